@@ -48,7 +48,7 @@
 #define configTICK_RATE_HZ			( ( TickType_t ) 1000 )
 #define configMAX_PRIORITIES		( 5 )
 #define configMINIMAL_STACK_SIZE	( ( unsigned short ) 120 )
-#define configTOTAL_HEAP_SIZE		( ( size_t ) ( 18 * 1024 ) )
+#define configTOTAL_HEAP_SIZE		( ( size_t ) ( 14 * 1024 ) )
 #define configMAX_TASK_NAME_LEN		( 16 )
 #define configUSE_TRACE_FACILITY	1
 #define configUSE_16_BIT_TICKS		0
@@ -61,7 +61,7 @@
 #define configUSE_MUTEXES				1
 #define configUSE_COUNTING_SEMAPHORES 	1
 #define configUSE_ALTERNATIVE_API 		0
-#define configCHECK_FOR_STACK_OVERFLOW	0
+#define configCHECK_FOR_STACK_OVERFLOW	0	/* Переопределяется ниже при CONFIG_STACKPROF_ENABLE */
 #define configUSE_RECURSIVE_MUTEXES		1
 #define configQUEUE_REGISTRY_SIZE		0
 #define configGENERATE_RUN_TIME_STATS	0
@@ -82,6 +82,7 @@ to exclude the API function. */
 #define INCLUDE_vTaskSuspend			1
 #define INCLUDE_vTaskDelayUntil			1
 #define INCLUDE_vTaskDelay				1
+#define INCLUDE_xTaskGetCurrentTaskHandle	1	/* events.h: задача-получатель канала */
 
 #define configASSERT( x ) if( ( x ) == 0 ) { taskDISABLE_INTERRUPTS(); for( ;; ); }
 
@@ -136,6 +137,32 @@ NVIC value of 255. */
 #define configCOM1_TX_BUFFER_LENGTH		128
 
 
+/*-----------------------------------------------------------
+ * Трасса выделений heap_4 для mempool_benchmark, app_config.h CONFIG_MEMPOOL_TRACE
+ *-----------------------------------------------------------*/
+#include "app_config.h"
+#if (CONFIG_MEMPOOL_TRACE == 1)
+void vMemTraceMalloc( void *pvAddress, size_t uiSize );
+void vMemTraceFree( void *pvAddress, size_t uiSize );
+#define traceMALLOC( pvAddress, uiSize )    vMemTraceMalloc( pvAddress, uiSize )
+#define traceFREE( pvAddress, uiSize )      vMemTraceFree( pvAddress, uiSize )
+#endif
+
+
+/*-----------------------------------------------------------
+ * Профилировщик стеков, app_config.h CONFIG_STACKPROF_ENABLE
+ *-----------------------------------------------------------*/
+#if (CONFIG_STACKPROF_ENABLE == 1)
+#undef configCHECK_FOR_STACK_OVERFLOW
+#define configCHECK_FOR_STACK_OVERFLOW      2
+#define configRECORD_STACK_HIGH_ADDRESS     1
+void vStackProfTaskCreated( void *xTask, void *pxStack, void *pxEndOfStack );
+void vStackProfTaskDeleted( void *xTask );
+#define traceTASK_CREATE( pxNewTCB )        vStackProfTaskCreated( pxNewTCB, pxNewTCB->pxStack, pxNewTCB->pxEndOfStack )
+#define traceTASK_DELETE( pxTCB )           vStackProfTaskDeleted( pxTCB )
+#endif
+
+
 #define vPortSVCHandler SVC_Handler
 #define xPortPendSVHandler PendSV_Handler
 #define xPortSysTickHandler SysTick_Handler
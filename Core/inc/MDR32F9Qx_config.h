@@ -174,13 +174,13 @@ extern "C" {
 // <o.0..5> Number of DMA channels to use
 // <i> This parameter is in range 1..32
 // <i> Default: 32
-#define DMA_Channels_Number   16
+#define DMA_Channels_Number   32
 
 // <o> Alternate Control Data Structure Usage
 //   <0=> 0: DMA_ALternateDataDisabled
 //   <1=> 1: DMA_ALternateDataEnabled
 // <i> Default: 1 (DMA_ALternateDataEnabled)
-#define DMA_AlternateData     0
+#define DMA_AlternateData     1
 // </h>
 
 // </h>
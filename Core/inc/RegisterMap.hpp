@@ -0,0 +1,113 @@
+/**
+ * @file RegisterMap.hpp
+ * @brief Карта регистров RegisterProtocol: номера, размеры, доступ и обработчики прошивки
+ *
+ * Сгенерировано lfregmap из registers.json, не редактировать.
+ * Перегенерировать: cmake --build <сборка Host> --target regmap
+ */
+
+#ifndef MILANDRBASE_REGISTERMAP_HPP
+#define MILANDRBASE_REGISTERMAP_HPP
+
+#include <stdint.h>
+#include <stddef.h>
+
+#define REG_WHOIAM              (0x00)
+#define REG_STATUS              (0x01)
+#define REG_LAST_ERROR          (0x02)
+#define REG_DAC_CH1             (0x03)
+#define REG_DAC_CH2             (0x04)
+#define REG_DAC_CH3             (0x05)
+#define REG_DAC_CH4             (0x06)
+#define REG_DAC_ALL             (0x07)
+#define REG_ADC_CH1             (0x08)
+#define REG_ADC_CH2             (0x09)
+#define REG_ADC_CH3             (0x0A)
+#define REG_ADC_CH4             (0x0B)
+#define REG_ADC_ALL             (0x0C)
+#define REG_DAC_DEFAULT_CH1     (0x0D)
+#define REG_DAC_DEFAULT_CH2     (0x0E)
+#define REG_DAC_DEFAULT_CH3     (0x0F)
+#define REG_DAC_DEFAULT_CH4     (0x10)
+#define REG_DAC_MAX_CH1         (0x11)
+#define REG_DAC_MAX_CH2         (0x12)
+#define REG_DAC_MAX_CH3         (0x13)
+#define REG_DAC_MAX_CH4         (0x14)
+#define REG_SAVE_EEP            (0x15)
+#define REG_THRM_PCB            (0x16)
+#define REG_THRM_MCU            (0x17)
+#define REG_SVC                 (0x18)
+#define REG_VERSION             (0x19)
+#define REG_CRC_HW              (0x1A)
+#define REG_CRC_SW              (0x1B)
+#define REG_CERT                (0x1C)
+#define REG_COUNT               (0x1D)      ///< Номеров в RegisterMap
+#define REG_DATA_MAX            (8)         ///< Наибольший регистр, байт
+
+#define REG_SIZE_WHOIAM         (2)
+#define REG_SIZE_STATUS         (2)
+#define REG_SIZE_LAST_ERROR     (2)
+#define REG_SIZE_DAC_CH1        (2)
+#define REG_SIZE_DAC_CH2        (2)
+#define REG_SIZE_DAC_CH3        (2)
+#define REG_SIZE_DAC_CH4        (2)
+#define REG_SIZE_DAC_ALL        (2)
+#define REG_SIZE_ADC_CH1        (2)
+#define REG_SIZE_ADC_CH2        (2)
+#define REG_SIZE_ADC_CH3        (2)
+#define REG_SIZE_ADC_CH4        (2)
+#define REG_SIZE_ADC_ALL        (8)
+#define REG_SIZE_DAC_DEFAULT_CH1 (2)
+#define REG_SIZE_DAC_DEFAULT_CH2 (2)
+#define REG_SIZE_DAC_DEFAULT_CH3 (2)
+#define REG_SIZE_DAC_DEFAULT_CH4 (2)
+#define REG_SIZE_DAC_MAX_CH1    (2)
+#define REG_SIZE_DAC_MAX_CH2    (2)
+#define REG_SIZE_DAC_MAX_CH3    (2)
+#define REG_SIZE_DAC_MAX_CH4    (2)
+#define REG_SIZE_SAVE_EEP       (2)
+#define REG_SIZE_THRM_PCB       (2)
+#define REG_SIZE_THRM_MCU       (2)
+#define REG_SIZE_SVC            (2)
+#define REG_SIZE_VERSION        (2)
+#define REG_SIZE_CRC_HW         (4)
+#define REG_SIZE_CRC_SW         (4)
+#define REG_SIZE_CERT           (2)
+
+#define REG_ACCESS_READ         (1U << 0)
+#define REG_ACCESS_WRITE        (1U << 1)
+
+
+/**
+ * @brief Данные регистра для ответа на чтение, RegisterEntry::Size байт little-endian без CRC
+ */
+typedef void (*RegisterReadHandler)(uint8_t reg, uint8_t *data);
+
+/**
+ * @brief Запись регистра, CRC уже проверена
+ * @return false - запись не выполнена
+ */
+typedef bool (*RegisterWriteHandler)(uint8_t reg, uint16_t value);
+
+/**
+ * @brief Регистр в RegisterMap
+ */
+struct RegisterEntry {
+    uint8_t              Size;          ///< Байт данных при чтении
+    uint8_t              Access;        ///< REG_ACCESS_READ | REG_ACCESS_WRITE по спецификации
+    RegisterReadHandler  Read;          ///< nullptr - прошивка не отвечает на чтение
+    RegisterWriteHandler Write;         ///< nullptr - прошивка не принимает запись
+};
+
+void RegisterReadWhoiam(uint8_t reg, uint8_t *data);
+void RegisterReadAdc(uint8_t reg, uint8_t *data);
+void RegisterReadAdcAll(uint8_t reg, uint8_t *data);
+bool RegisterWriteSvc(uint8_t reg, uint16_t value);
+
+
+/**
+ * @brief Регистры по номеру: разбор команды - одно обращение к таблице. Определена в RegisterMap.cpp
+ */
+extern const RegisterEntry RegisterMap[REG_COUNT];
+
+#endif //MILANDRBASE_REGISTERMAP_HPP
@@ -0,0 +1,34 @@
+/**
+ * @file RegisterProtocol.hpp
+ * @brief Протокол регистров SSPSlaveTask и UARTCommand, номера регистров как в lfc::Registers
+ *
+ * Чтение: байт REG_READ(reg), ответ - данные регистра и CRC. Запись: байт REG_WRITE(reg), 2 байта данных
+ * little-endian и CRC трёх байт. CRC-8, полином 0x07, начальное значение 0, результат XOR 0x55.
+ *
+ * Номера, размеры и обработчики регистров - RegisterMap.hpp, сгенерированный из registers.json.
+ */
+
+#ifndef MILANDRBASE_REGISTERPROTOCOL_HPP
+#define MILANDRBASE_REGISTERPROTOCOL_HPP
+
+#include <stdint.h>
+#include <stddef.h>
+#include "RegisterMap.hpp"
+
+#define REG_READ(reg)       static_cast<uint8_t>(((reg) << 1) | 0x01)
+#define REG_WRITE(reg)      static_cast<uint8_t>((reg) << 1)
+#define REG_SVC_UPDATE      (1U << 7)       // LF_SVC_UPDATE
+#define REG_WRITE_SIZE      (4)             ///< Команда, 2 байта данных, CRC
+
+uint8_t RegisterCrc(const uint8_t *data, size_t len);
+size_t RegisterRead(uint8_t reg, uint8_t *data);
+bool RegisterWrite(uint8_t reg, uint16_t value);
+
+/**
+ * @brief Прошивка принимает запись регистра
+ */
+static inline bool RegisterWritable(uint8_t reg) {
+    return reg < REG_COUNT && RegisterMap[reg].Write != nullptr;
+}
+
+#endif //MILANDRBASE_REGISTERPROTOCOL_HPP
@@ -0,0 +1,6 @@
+#ifndef MILANDRBASE_UARTCOMMAND_HPP
+#define MILANDRBASE_UARTCOMMAND_HPP
+
+void UARTCommandStart();
+
+#endif //MILANDRBASE_UARTCOMMAND_HPP
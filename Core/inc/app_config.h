@@ -26,6 +26,222 @@
     #define CONFIG_LOG_TIMESTAMP_SOURCE_RTOS 1
 #endif
 
+/*
+ * Классы размеров пулов блоков PoolAlloc()/PoolFree(). Размер кратен 4, классы по возрастанию размера.
+ */
+#ifndef CONFIG_MEMPOOL_CLASS0_SIZE
+    #define CONFIG_MEMPOOL_CLASS0_SIZE      16      ///< Дескрипторы транзакций, записи тегов лога
+#endif
+#ifndef CONFIG_MEMPOOL_CLASS0_COUNT
+    #define CONFIG_MEMPOOL_CLASS0_COUNT     32
+#endif
+#ifndef CONFIG_MEMPOOL_CLASS1_SIZE
+    #define CONFIG_MEMPOOL_CLASS1_SIZE      64      ///< Отчёты USB HID
+#endif
+#ifndef CONFIG_MEMPOOL_CLASS1_COUNT
+    #define CONFIG_MEMPOOL_CLASS1_COUNT     8
+#endif
+#ifndef CONFIG_MEMPOOL_CLASS2_SIZE
+    #define CONFIG_MEMPOOL_CLASS2_SIZE      256     ///< Буферы ввода-вывода, записи лога
+#endif
+#ifndef CONFIG_MEMPOOL_CLASS2_COUNT
+    #define CONFIG_MEMPOOL_CLASS2_COUNT     4
+#endif
+
+#ifndef CONFIG_MEMPOOL_TRACE
+    #define CONFIG_MEMPOOL_TRACE 0                  ///< 1 - вывод трассы pvPortMalloc/vPortFree в RTT для mempool_benchmark
+#endif
+
+/*
+ * Профилировщик стеков stackprof
+ */
+#ifndef CONFIG_STACKPROF_ENABLE
+    #define CONFIG_STACKPROF_ENABLE 0               ///< 1 - учёт использования стеков задач и MSP, проверка переполнения стеков
+#endif
+#ifndef CONFIG_STACKPROF_MAX_TASKS
+    #define CONFIG_STACKPROF_MAX_TASKS      10      ///< Максимальное количество задач, включая IDLE и Tmr Svc
+#endif
+#ifndef CONFIG_STACKPROF_PERIOD_MS
+    #define CONFIG_STACKPROF_PERIOD_MS      5000    ///< Период пересчёта и вывода в лог
+#endif
+
+/*
+ * Профилировщик участков кода cycleprof
+ */
+#ifndef CONFIG_CYCLEPROF_ENABLE
+    #define CONFIG_CYCLEPROF_ENABLE 0               ///< 1 - замеры CYCLEPROF_*, 0 - макросы пустые
+#endif
+#ifndef CONFIG_CYCLEPROF_MAX_SITES
+    #define CONFIG_CYCLEPROF_MAX_SITES      8       ///< Максимальное количество участков
+#endif
+#ifndef CONFIG_CYCLEPROF_BUCKETS
+    #define CONFIG_CYCLEPROF_BUCKETS        16      ///< Корзин гистограммы, последняя - от 2^(N-2) тактов
+#endif
+#ifndef CONFIG_CYCLEPROF_PERIOD_MS
+    #define CONFIG_CYCLEPROF_PERIOD_MS      5000    ///< Период вывода статистики
+#endif
+#ifndef CONFIG_CYCLEPROF_RTT_CHANNEL
+    #define CONFIG_CYCLEPROF_RTT_CHANNEL    0       ///< 0 - вывод в лог, N - в канал RTT N (SEGGER_RTT_MAX_NUM_UP_BUFFERS > N)
+#endif
+#ifndef CONFIG_CYCLEPROF_RTT_BUFFER_SIZE
+    #define CONFIG_CYCLEPROF_RTT_BUFFER_SIZE 512    ///< Буфер канала RTT CONFIG_CYCLEPROF_RTT_CHANNEL
+#endif
+
+/*
+ * Измерение задержки входа в прерывания irqlat. Бюджеты в тактах ядра 80 МГц
+ */
+#ifndef CONFIG_IRQLAT_ENABLE
+    #define CONFIG_IRQLAT_ENABLE            0       ///< 1 - режим измерения: отметки времени в обработчиках прерываний
+#endif
+#ifndef CONFIG_IRQLAT_BUCKETS
+    #define CONFIG_IRQLAT_BUCKETS           14      ///< Корзин гистограмм задержки и джиттера
+#endif
+#ifndef CONFIG_IRQLAT_PERIOD_MS
+    #define CONFIG_IRQLAT_PERIOD_MS         5000    ///< Период вывода отчёта
+#endif
+#ifndef CONFIG_IRQLAT_BUDGET_IICS
+    #define CONFIG_IRQLAT_BUDGET_IICS       160     ///< TIMER1 iicslave: 2 мкс из полупериода SCL 4 мкс на 120 кГц
+#endif
+#ifndef CONFIG_IRQLAT_BUDGET_CAPTURE
+    #define CONFIG_IRQLAT_BUDGET_CAPTURE    800     ///< TIMER3 capture: 10 мкс, разрешение 1 мкс (PSG 79)
+#endif
+
+/*
+ * Копирование в RAM dmacopy на программном канале DMA
+ */
+#ifndef CONFIG_DMACOPY_THRESHOLD
+    #define CONFIG_DMACOPY_THRESHOLD        64      ///< Короче - memcpy процессором, байт. 0 - замер в DmaCopyStart()
+#endif
+#ifndef CONFIG_DMACOPY_R_POWER
+    #define CONFIG_DMACOPY_R_POWER          4       ///< Переарбитрация через 2^R элементов, каналы периферии ждут не дольше
+#endif
+#ifndef CONFIG_DMACOPY_BENCH_MAX
+    #define CONFIG_DMACOPY_BENCH_MAX        1024    ///< Наибольший размер замера, байт. Два буфера из кучи на время замера
+#endif
+#ifndef CONFIG_DMACOPY_BENCHMARK
+    #define CONFIG_DMACOPY_BENCHMARK        0       ///< 1 - вывод замеров memcpy и DMA строками @DMACPY
+#endif
+
+/*
+ * Захват фронтов capture
+ */
+#ifndef CONFIG_CAPTURE_RING_SIZE
+    #define CONFIG_CAPTURE_RING_SIZE        256     ///< Кольцевой буфер DMA, отсчётов. Половина вмещает фронты за период счёта
+#endif
+#ifndef CONFIG_CAPTURE_MARKERS
+    #define CONFIG_CAPTURE_MARKERS          16      ///< Очередь маркеров переполнения, степень 2
+#endif
+
+/*
+ * Измерительный АЦП adcacq. Входы ADC0..ADC7 - выводы PD0..PD7, PD2, PD3, PD5, PD6 заняты SSP2
+ */
+#ifndef CONFIG_ADC_CH1_INPUT
+    #define CONFIG_ADC_CH1_INPUT            0       ///< Вход ADC1 для ADC_CH1, PD0
+#endif
+#ifndef CONFIG_ADC_CH2_INPUT
+    #define CONFIG_ADC_CH2_INPUT            1       ///< Вход ADC1 для ADC_CH2, PD1
+#endif
+#ifndef CONFIG_ADC_CH3_INPUT
+    #define CONFIG_ADC_CH3_INPUT            4       ///< Вход ADC2 для ADC_CH3, PD4
+#endif
+#ifndef CONFIG_ADC_CH4_INPUT
+    #define CONFIG_ADC_CH4_INPUT            7       ///< Вход ADC2 для ADC_CH4, PD7
+#endif
+#ifndef CONFIG_ADC_PRESCALER
+    #define CONFIG_ADC_PRESCALER            ADC_CLK_div_512     ///< ~5.5 тыс. преобразований в секунду на каждом АЦП
+#endif
+#ifndef CONFIG_ADC_DMA_HALF
+    #define CONFIG_ADC_DMA_HALF             64      ///< Половина буфера DMA, слов. Заполняется за ~11 мс
+#endif
+#ifndef CONFIG_ADC_PERIOD_MS
+    #define CONFIG_ADC_PERIOD_MS            5       ///< Период обработки, меньше времени заполнения половины
+#endif
+
+
+/*
+ * Генератор синуса dds на DAC1 (PE1) и DAC2 (PE9), отсчёты по DMA от TIMER2
+ */
+#ifndef CONFIG_DDS_ENABLE
+    #define CONFIG_DDS_ENABLE               0       ///< 1 - TIMER2, DAC и канал DMA TIM2 заняты dds, буфер 2 КиБ
+#endif
+#ifndef CONFIG_DDS_SAMPLE_RATE
+    #define CONFIG_DDS_SAMPLE_RATE          50000   ///< Частота отсчётов, Гц
+#endif
+#ifndef CONFIG_DDS_DMA_HALF
+    #define CONFIG_DDS_DMA_HALF             256     ///< Половина буфера DMA, отсчётов. Отыгрывается за ~5 мс
+#endif
+#ifndef CONFIG_DDS_PERIOD_MS
+    #define CONFIG_DDS_PERIOD_MS            2       ///< Период пересчёта, меньше времени воспроизведения половины
+#endif
+
+/*
+ * Параметры во flash paramstore. Две последние страницы основной flash, исключены из FLASH в 1986ve92.ld
+ */
+#ifndef CONFIG_PARAMSTORE_ENABLE
+    #define CONFIG_PARAMSTORE_ENABLE        0       ///< 1 - задача Params, до подключения SAVE_EEP вызовов нет
+#endif
+#ifndef CONFIG_PARAMSTORE_PAGE0
+    #define CONFIG_PARAMSTORE_PAGE0         0x0801E000UL
+#endif
+#ifndef CONFIG_PARAMSTORE_PAGE1
+    #define CONFIG_PARAMSTORE_PAGE1         0x0801F000UL
+#endif
+#ifndef CONFIG_PARAMSTORE_PAGE_SIZE
+    #define CONFIG_PARAMSTORE_PAGE_SIZE     4096    ///< Страница основной flash 1986ВЕ92
+#endif
+#ifndef CONFIG_PARAMSTORE_KEYS
+    #define CONFIG_PARAMSTORE_KEYS          8       ///< DAC_DEFAULT_CH1..4, DAC_MAX_CH1..4
+#endif
+#ifndef CONFIG_PARAMSTORE_COLLECT_MS
+    #define CONFIG_PARAMSTORE_COLLECT_MS    1000    ///< Период проверки фоновой сборки
+#endif
+
+/*
+ * Обмен uartlink по UART2 (PF0 - RXD, PF1 - TXD) на DMA: протокол регистров UARTCommand и вывод лога
+ */
+#ifndef CONFIG_UARTLINK_ENABLE
+    #define CONFIG_UARTLINK_ENABLE          1       ///< 1 - UART2 и каналы DMA UART2_RX, UART2_TX заняты uartlink
+#endif
+#ifndef CONFIG_UARTLINK_BAUD
+    #define CONFIG_UARTLINK_BAUD            921600  ///< До 5000000 на 80 МГц, отклонение делителя не больше 1.5%
+#endif
+#ifndef CONFIG_UARTLINK_LOG
+    #define CONFIG_UARTLINK_LOG             0       ///< 1 - лог в UART вместо RTT, строки текста между ответами регистров
+#endif
+#ifndef CONFIG_UARTLINK_RX_SIZE
+    #define CONFIG_UARTLINK_RX_SIZE         512     ///< Кольцо приёма, степень 2. Половина - 2.8 мс на 921600, 0.5 мс на 5 Мбод
+#endif
+#ifndef CONFIG_UARTLINK_TX_SIZE
+    #define CONFIG_UARTLINK_TX_SIZE         1024    ///< Кольцо передачи, степень 2
+#endif
+#ifndef CONFIG_UARTLINK_FRAME_MAX
+    #define CONFIG_UARTLINK_FRAME_MAX       128     ///< Наибольший кадр, поток без пауз отдаётся частями такого размера
+#endif
+#ifndef CONFIG_UARTLINK_IDLE_TICKS
+    #define CONFIG_UARTLINK_IDLE_TICKS      2       ///< Пауза конца кадра, тиков без новых байт
+#endif
+#ifndef CONFIG_UARTLINK_LOG_LINE
+    #define CONFIG_UARTLINK_LOG_LINE        96      ///< Буфер строки лога на стеке вызывающей задачи
+#endif
+
+/*
+ * Обновление прошивки iap по SSP2. Область образа - FLASH в 1986ve92.ld, CRC append_crc в её последнем слове
+ */
+#ifndef CONFIG_IAP_BASE
+    #define CONFIG_IAP_BASE                 0x08000000UL
+#endif
+#ifndef CONFIG_IAP_SIZE
+    #define CONFIG_IAP_SIZE                 122880UL    ///< 120 КиБ, до страниц paramstore
+#endif
+#ifndef CONFIG_IAP_PAGE_SIZE
+    #define CONFIG_IAP_PAGE_SIZE            4096UL
+#endif
+#ifndef CONFIG_IAP_RING_SIZE
+    #define CONFIG_IAP_RING_SIZE            2048    ///< Кольцо принятых данных, байт. Запись одной страницы ждёт ~5 пачек
+#endif
+#ifndef CONFIG_IAP_DMA_HALF
+    #define CONFIG_IAP_DMA_HALF             128     ///< Половина буфера приёма DMA, байт. Принимается за ~340 мкс на 3 МГц
+#endif
 
 #ifndef VERSION_HW
 //#error "VERSION_HW must be defined"
@@ -42,5 +42,38 @@
 #ifndef LOG_TAG_IICSW_LOCAL_LEVEL
 #define LOG_TAG_IICSW_LOCAL_LEVEL   MDR_LOG_NONE
 #endif
+#ifndef LOG_TAG_STACKPROF_LOCAL_LEVEL
+#define LOG_TAG_STACKPROF_LOCAL_LEVEL   MDR_LOG_INFO    ///< Log level for TAG "STK" (stack profiler reports)
+#endif
+#ifndef LOG_TAG_CYCLEPROF_LOCAL_LEVEL
+#define LOG_TAG_CYCLEPROF_LOCAL_LEVEL   MDR_LOG_INFO    ///< Log level for TAG "CYC" (cycle profiler reports)
+#endif
+#ifndef LOG_TAG_IRQLAT_LOCAL_LEVEL
+#define LOG_TAG_IRQLAT_LOCAL_LEVEL      MDR_LOG_INFO    ///< Log level for TAG "IRQ" (interrupt latency reports)
+#endif
+#ifndef LOG_TAG_DMA_LOCAL_LEVEL
+#define LOG_TAG_DMA_LOCAL_LEVEL     MDR_LOG_INFO    ///< Log level for TAG "DMA" (DMA channel manager)
+#endif
+#ifndef LOG_TAG_DMACOPY_LOCAL_LEVEL
+#define LOG_TAG_DMACOPY_LOCAL_LEVEL MDR_LOG_INFO    ///< Log level for TAG "DMACPY" (DMA memcpy/memset service)
+#endif
+#ifndef LOG_TAG_UART_LOCAL_LEVEL
+#define LOG_TAG_UART_LOCAL_LEVEL    MDR_LOG_INFO    ///< Log level for TAG "UART" (UART DMA transport and commands)
+#endif
+#ifndef LOG_TAG_SSPBUS_LOCAL_LEVEL
+#define LOG_TAG_SSPBUS_LOCAL_LEVEL  MDR_LOG_INFO    ///< Log level for TAG "SSPBUS" (SSP2 master transaction queue)
+#endif
+#ifndef LOG_TAG_ADC_LOCAL_LEVEL
+#define LOG_TAG_ADC_LOCAL_LEVEL     MDR_LOG_INFO    ///< Log level for TAG "ADC" (measurement ADC acquisition)
+#endif
+#ifndef LOG_TAG_DDS_LOCAL_LEVEL
+#define LOG_TAG_DDS_LOCAL_LEVEL     MDR_LOG_INFO    ///< Log level for TAG "DDS" (sine generator on DAC)
+#endif
+#ifndef LOG_TAG_PARAMS_LOCAL_LEVEL
+#define LOG_TAG_PARAMS_LOCAL_LEVEL  MDR_LOG_INFO    ///< Log level for TAG "PARAMS" (flash parameter store)
+#endif
+#ifndef LOG_TAG_IAP_LOCAL_LEVEL
+#define LOG_TAG_IAP_LOCAL_LEVEL     MDR_LOG_INFO    ///< Log level for TAG "IAP" (firmware update)
+#endif
 
 #endif //MILANDRBASE_LOG_LEVELS_H
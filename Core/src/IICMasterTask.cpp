@@ -4,7 +4,8 @@
 #include <MDR32F9Qx_i2c.h>
 #include <FreeRTOS.h>
 #include <task.h>
-#include <semphr.h>
+#include <stackprof.h>
+#include <events.h>
 #include "IICMasterTask.hpp"
 #include "ring_buffer.h"
 
@@ -26,7 +27,9 @@ static void ReadTestInterrupt(uint32_t address, void *buffer, size_t buffer_len)
 __IO static uint32_t iReceiveLen = 0;
 RingBuffer<64, uint8_t> ringBuffer;
 
-SemaphoreHandle_t IrqSemaphore;
+#define IICM_EVENT_DONE     (1UL << 0)  ///< Приём или передача по прерываниям завершены
+
+static EventChannel xDoneEvent;
 
 static void InitHW();
 
@@ -34,6 +37,7 @@ static void Execute(void *pvParameters) {
 static uint8_t rx_buffer[32] {};
 
     MDR_LOGI(TAG, "Start!");
+    EventInit(xDoneEvent, xTaskGetCurrentTaskHandle(), IICM_EVENT_DONE, "iicm_done");
     InitHW();
     NVIC_SetPriority(I2C_IRQn, NVIC_EncodePriority(NVIC_GetPriorityGrouping(), 6, 0));
     I2C_Cmd(ENABLE);
@@ -85,7 +89,7 @@ void ReadTestInterrupt(uint32_t address, void *buffer, size_t buffer_len) {
             }
             I2C_ITConfig(ENABLE);
             NVIC_EnableIRQ(I2C_IRQn);
-            if (xSemaphoreTake(IrqSemaphore, 5000) != pdTRUE) {
+            if (!EventWait(xDoneEvent, 5000)) {
                 MDR_LOGE(TAG, "I2C Read Error!!");
             }
         }
@@ -161,7 +165,7 @@ void WriteTestInterrupt(uint32_t address, const void *buffer, size_t buffer_len)
         NVIC_EnableIRQ(I2C_IRQn);
         I2C_SendByte(const_buf[0]);
 
-        if (xSemaphoreTake(IrqSemaphore, 5000) != pdTRUE) {
+        if (!EventWait(xDoneEvent, 5000)) {
             MDR_LOGE(TAG, "I2C Transmit Error!");
         } else {
             MDR_LOGI(TAG, "I2C Write OK");
@@ -219,6 +223,7 @@ I2C_InitTypeDef I2C_InitStructure;
 }
 
 extern "C" void I2C_IRQHandler() {
+    STACKPROF_ISR_ENTER();
     BaseType_t xHigherPriorityTaskWoken = pdFALSE;
     if (I2C_GetITStatus() == SET) {
         I2C_ClearITPendingBit();
@@ -228,7 +233,7 @@ extern "C" void I2C_IRQHandler() {
                 ringBuffer.Write(I2C_GetReceivedData());
                 iReceiveLen--;
                 if (iReceiveLen == 0) {
-                    xSemaphoreGiveFromISR(IrqSemaphore, &xHigherPriorityTaskWoken);
+                    EventPostFromISR(xDoneEvent, &xHigherPriorityTaskWoken);
                 } else if (iReceiveLen == 1) {
                     I2C_StartReceiveData(I2C_Send_to_Slave_NACK);
                 } else {
@@ -242,7 +247,7 @@ extern "C" void I2C_IRQHandler() {
                 ringBuffer.Read(v);
                 I2C_SendByte(v);
             } else {
-                xSemaphoreGiveFromISR(IrqSemaphore, &xHigherPriorityTaskWoken);
+                EventPostFromISR(xDoneEvent, &xHigherPriorityTaskWoken);
             }
         }
     }
@@ -251,7 +256,5 @@ extern "C" void I2C_IRQHandler() {
 
 
 void IICMasterTaskStart() {
-    IrqSemaphore = xSemaphoreCreateBinary();
-    xSemaphoreTake(IrqSemaphore, 0);
     xTaskCreate(Execute, "IICMaster", configMINIMAL_STACK_SIZE * 2, nullptr, tskIDLE_PRIORITY, nullptr);
 }
@@ -1,9 +1,14 @@
+#include <cstring>
 #include <MDR32F9Qx_rst_clk.h>
 #include <MDR32F9Qx_port.h>
 #include <MDR32F9Qx_timer.h>
 #include <FreeRTOS.h>
 #include <task.h>
 #include <iicslave.h>
+#include <stackprof.h>
+#include <cycleprof.h>
+#include <irqlat.h>
+#include <events.h>
 #include "IICSlaveTask.hpp"
 
 #include "log_levels.h"
@@ -14,6 +19,13 @@ const static char *TAG = "IICS";
 // NOTE Программная реализация I2C https://startmilandr.ru/doku.php/prog:i2c:timersorfi2c
 static IICSlave xIICSlave;
 
+#define IICS_REG_STACKPROF      (0x80)      ///< Регистры 0x80..0x9F - записи профилировщика стеков по 8 байт
+#define IICS_REG_CYCLEPROF      (0xA0)      ///< Регистры 0xA0.. - записи профилировщика участков кода по 8 байт
+
+#define IICS_EVENT_STOP         (1UL << 0)  ///< STOP после обращения к ведомому, принятые байты в stop_buff
+
+static EventChannel xStopEvent;
+
 
 
 // Тестовые данные
@@ -24,9 +36,24 @@ uint8_t rx_buff[8];
 uint8_t tx_buffer_index;
 uint8_t tx_buffer[8] = {0xA0, 0xA1, 0xBC, 0xCC,
                         0xDE, 0x12, 0x68, 0x57};
+uint8_t prof_record[STACKPROF_RECORD_SIZE];
+static_assert(STACKPROF_RECORD_SIZE == CYCLEPROF_RECORD_SIZE, "prof_record size");
+const uint8_t *tx_data = tx_buffer;
+
+uint8_t stop_buff[8];
+uint8_t stop_len;
+
 bool AddressMatch(bool read_transition, bool restarted) {
     rx_buff_index = 0;
     tx_buffer_index = 0;
+    tx_data = tx_buffer;
+    if (read_transition && reg_address >= IICS_REG_CYCLEPROF) {
+        CycleProfReadRecord(reg_address - IICS_REG_CYCLEPROF, prof_record);
+        tx_data = prof_record;
+    } else if (read_transition && reg_address >= IICS_REG_STACKPROF) {
+        StackProfReadRecord(reg_address - IICS_REG_STACKPROF, prof_record);
+        tx_data = prof_record;
+    }
     return true;
 }
 
@@ -40,19 +67,24 @@ bool DataReceived(uint8_t data) {
 }
 
 bool GetTransmittedByte(uint8_t &data) {
-    data = tx_buffer[tx_buffer_index];
+    data = tx_data[tx_buffer_index % sizeof(tx_buffer)];
     tx_buffer_index++;
     return true;
 }
 
 bool StopCallback() {
-    MDR_LOGD(TAG, "STOP Register: %d", reg_address);
-    MDR_LOG_BUFFER_HEXDUMP(TAG, rx_buff, rx_buff_index, MDR_LOG_DEBUG);
+    // Вывод в лог из задачи: в прерывании ждать мьютекс лога нельзя
+    stop_len = rx_buff_index < sizeof(stop_buff) ? rx_buff_index : sizeof(stop_buff);
+    memcpy(stop_buff, rx_buff, stop_len);
+    BaseType_t xHigherPriorityTaskWoken = pdFALSE;
+    EventPostFromISR(xStopEvent, &xHigherPriorityTaskWoken);
+    portYIELD_FROM_ISR(xHigherPriorityTaskWoken);
     return true;
 }
 
 void Execute(void *pvParameters) {
     MDR_LOGI(TAG, "Start!");
+    EventInit(xStopEvent, xTaskGetCurrentTaskHandle(), IICS_EVENT_STOP, "iics_stop");
     IICSlaveInit(xIICSlave,
                  MDR_TIMER1,
                  MDR_PORTA, PORT_Pin_1, PORT_FUNC_ALTER, TIMER_CHANNEL1,  // SDA, PA1 ALTER
@@ -61,14 +93,23 @@ void Execute(void *pvParameters) {
 
     IICSlaveSetAddress(xIICSlave, 0x37);
     IICSlaveCallback(xIICSlave, AddressMatch, DataReceived, GetTransmittedByte, StopCallback);
+    IrqLatRegister(xIICSlave.TimerIrqNumber, "iics", CONFIG_IRQLAT_BUDGET_IICS);
     IICSlaveStart(xIICSlave);
+    // Задача просыпается только по STOP, приём и передача байтов целиком в прерывании
     for (;;) {
-        vTaskDelay(1);
+        if (EventWait(xStopEvent, portMAX_DELAY)) {
+            MDR_LOGD(TAG, "STOP Register: %d", stop_buff[0]);
+            MDR_LOG_BUFFER_HEXDUMP(TAG, stop_buff, stop_len, MDR_LOG_DEBUG);
+        }
     }
 }
 
 extern "C" __attribute__ ((section(".ramfunc"))) void Timer1_IRQHandler()  {
+    IRQLAT_TIMER_ENTRY(Timer1_IRQn, MDR_TIMER1, IICSlaveEventCount(xIICSlave));
+    STACKPROF_ISR_ENTER();
+    CYCLEPROF_BEGIN(iics);
     TimerIIC_IRQHandler(xIICSlave);
+    CYCLEPROF_END(iics);
 }
 
 
@@ -0,0 +1,42 @@
+/**
+ * @file RegisterMap.cpp
+ * @brief Таблица RegisterMap, единственное определение на прошивку
+ *
+ * Сгенерировано lfregmap из registers.json, не редактировать.
+ * Перегенерировать: cmake --build <сборка Host> --target regmap
+ */
+
+#include "RegisterMap.hpp"
+
+
+const RegisterEntry RegisterMap[REG_COUNT] = {
+        {REG_SIZE_WHOIAM, REG_ACCESS_READ, RegisterReadWhoiam, nullptr},                     // 0x00 WHOIAM
+        {REG_SIZE_STATUS, REG_ACCESS_READ, nullptr, nullptr},                                // 0x01 STATUS
+        {REG_SIZE_LAST_ERROR, REG_ACCESS_READ, nullptr, nullptr},                            // 0x02 LAST_ERROR
+        {REG_SIZE_DAC_CH1, REG_ACCESS_READ | REG_ACCESS_WRITE, nullptr, nullptr},            // 0x03 DAC_CH1
+        {REG_SIZE_DAC_CH2, REG_ACCESS_READ | REG_ACCESS_WRITE, nullptr, nullptr},            // 0x04 DAC_CH2
+        {REG_SIZE_DAC_CH3, REG_ACCESS_READ | REG_ACCESS_WRITE, nullptr, nullptr},            // 0x05 DAC_CH3
+        {REG_SIZE_DAC_CH4, REG_ACCESS_READ | REG_ACCESS_WRITE, nullptr, nullptr},            // 0x06 DAC_CH4
+        {REG_SIZE_DAC_ALL, REG_ACCESS_READ | REG_ACCESS_WRITE, nullptr, nullptr},            // 0x07 DAC_ALL
+        {REG_SIZE_ADC_CH1, REG_ACCESS_READ, RegisterReadAdc, nullptr},                       // 0x08 ADC_CH1
+        {REG_SIZE_ADC_CH2, REG_ACCESS_READ, RegisterReadAdc, nullptr},                       // 0x09 ADC_CH2
+        {REG_SIZE_ADC_CH3, REG_ACCESS_READ, RegisterReadAdc, nullptr},                       // 0x0A ADC_CH3
+        {REG_SIZE_ADC_CH4, REG_ACCESS_READ, RegisterReadAdc, nullptr},                       // 0x0B ADC_CH4
+        {REG_SIZE_ADC_ALL, REG_ACCESS_READ, RegisterReadAdcAll, nullptr},                    // 0x0C ADC_ALL
+        {REG_SIZE_DAC_DEFAULT_CH1, REG_ACCESS_READ | REG_ACCESS_WRITE, nullptr, nullptr},    // 0x0D DAC_DEFAULT_CH1
+        {REG_SIZE_DAC_DEFAULT_CH2, REG_ACCESS_READ | REG_ACCESS_WRITE, nullptr, nullptr},    // 0x0E DAC_DEFAULT_CH2
+        {REG_SIZE_DAC_DEFAULT_CH3, REG_ACCESS_READ | REG_ACCESS_WRITE, nullptr, nullptr},    // 0x0F DAC_DEFAULT_CH3
+        {REG_SIZE_DAC_DEFAULT_CH4, REG_ACCESS_READ | REG_ACCESS_WRITE, nullptr, nullptr},    // 0x10 DAC_DEFAULT_CH4
+        {REG_SIZE_DAC_MAX_CH1, REG_ACCESS_READ | REG_ACCESS_WRITE, nullptr, nullptr},        // 0x11 DAC_MAX_CH1
+        {REG_SIZE_DAC_MAX_CH2, REG_ACCESS_READ | REG_ACCESS_WRITE, nullptr, nullptr},        // 0x12 DAC_MAX_CH2
+        {REG_SIZE_DAC_MAX_CH3, REG_ACCESS_READ | REG_ACCESS_WRITE, nullptr, nullptr},        // 0x13 DAC_MAX_CH3
+        {REG_SIZE_DAC_MAX_CH4, REG_ACCESS_READ | REG_ACCESS_WRITE, nullptr, nullptr},        // 0x14 DAC_MAX_CH4
+        {REG_SIZE_SAVE_EEP, REG_ACCESS_WRITE, nullptr, nullptr},                             // 0x15 SAVE_EEP
+        {REG_SIZE_THRM_PCB, REG_ACCESS_READ, nullptr, nullptr},                              // 0x16 THRM_PCB
+        {REG_SIZE_THRM_MCU, REG_ACCESS_READ, nullptr, nullptr},                              // 0x17 THRM_MCU
+        {REG_SIZE_SVC, REG_ACCESS_WRITE, nullptr, RegisterWriteSvc},                         // 0x18 SVC
+        {REG_SIZE_VERSION, REG_ACCESS_READ, nullptr, nullptr},                               // 0x19 VERSION
+        {REG_SIZE_CRC_HW, REG_ACCESS_READ, nullptr, nullptr},                                // 0x1A CRC_HW
+        {REG_SIZE_CRC_SW, REG_ACCESS_READ, nullptr, nullptr},                                // 0x1B CRC_SW
+        {REG_SIZE_CERT, REG_ACCESS_READ | REG_ACCESS_WRITE, nullptr, nullptr},               // 0x1C CERT
+};
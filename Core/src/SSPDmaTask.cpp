@@ -4,7 +4,9 @@
 #include <MDR32F9Qx_dma.h>
 #include <FreeRTOS.h>
 #include <task.h>
-#include <semphr.h>
+#include <cycleprof.h>
+#include <events.h>
+#include <dmamgr.h>
 #include "SSPDmaTask.hpp"
 
 #include "log_levels.h"
@@ -14,7 +16,7 @@ const static char *TAG = " SSP";
 
 #define SSP_MASTER_HW      MDR_SSP2
 
-// INFO Время передачи DMA 20.95 мкс
+// INFO Время передачи DMA 20.95 мкс, с пробуждением задачи - участок ssp_dma профилировщика cycleprof
 static uint16_t TxData[] = {
         0x0000, 0x1234, 0x5974, 0xfA5B,
         0x24CD, 0x4444, 0xAA55, 0xAAAA,
@@ -25,30 +27,37 @@ static uint16_t TxData[] = {
 DMA_ChannelInitTypeDef DMA_ChannelInitStructure;
 DMA_CtrlDataInitTypeDef DMA_CtrlDataInitStructure;
 
-SemaphoreHandle_t DmaSemaphore;
+#define SSP_EVENT_DMA_DONE  (1UL << 0)  ///< Цикл DMA завершён
+
+static EventChannel xDmaDoneEvent;
 
 static void InitHW();
+static void DmaDone(uint8_t channel, void *context, BaseType_t *pxHigherPriorityTaskWoken);
 
 static void Execute(void *pvParameters) {
     MDR_LOGI(TAG, "Start!");
+    EventInit(xDmaDoneEvent, xTaskGetCurrentTaskHandle(), SSP_EVENT_DMA_DONE, "ssp_dma_done");
     vTaskDelay(100);
 
+    if (!DmaMgrClaim(DMA_Channel_SSP2_TX, "SSPDma"))
+        vTaskDelete(nullptr);
+    DmaMgrSetCallback(DMA_Channel_SSP2_TX, DmaDone, nullptr, false);
     InitHW();
-    NVIC_SetPriority(DMA_IRQn, NVIC_EncodePriority(NVIC_GetPriorityGrouping(), 7, 0));
-    NVIC_EnableIRQ(DMA_IRQn);
     SSP_Cmd(SSP_MASTER_HW, ENABLE);
 
     uint16_t index = 0;
     for (;;) {
         TxData[0] = index++;
-        DMA_Init(DMA_Channel_SSP2_TX, &DMA_ChannelInitStructure);
+        CYCLEPROF_BEGIN(ssp_dma);
+        DmaMgrStart(DMA_Channel_SSP2_TX, DMA_ChannelInitStructure);
         SSP_DMACmd(SSP_MASTER_HW, SSP_DMA_TXE, ENABLE);
 
         // Ожидаем окончания передачи
         // while (SSP_GetFlagStatus(SSP_MASTER_HW, SSP_FLAG_BSY) == SET){}
         // Или ждем прерывание
-        if (xSemaphoreTake(DmaSemaphore, portMAX_DELAY) == pdTRUE) {
+        if (EventWait(xDmaDoneEvent, portMAX_DELAY)) {
             SSP_DMACmd(SSP_MASTER_HW, SSP_DMA_TXE, DISABLE);
+            CYCLEPROF_END(ssp_dma);
             MDR_LOGD(TAG, "DMA Transfer complete: %d", index - 1);
         }
         vTaskDelay(100);
@@ -104,12 +113,11 @@ void InitHW() {
 
     // INFO Если DMA_Channels_Number < 9 и DMA_AlternateData == (0/1), то SSP2_TX, канал 6, не работает.
 
-    // Инициализация DMA
-    DMA_DeInit();
+    // Инициализация DMA. Контроллер общий, сбрасывается DmaMgrInit() при первом занятии канала
     DMA_StructInit(&DMA_ChannelInitStructure);
     // Primary Control
-    DMA_CtrlDataInitStructure.DMA_SourceBaseAddr = reinterpret_cast<uint32_t>(TxData);
-    DMA_CtrlDataInitStructure.DMA_DestBaseAddr = reinterpret_cast<uint32_t>(&SSP_MASTER_HW->DR);
+    DMA_CtrlDataInitStructure.DMA_SourceBaseAddr = DmaMgrBusAddress(TxData);
+    DMA_CtrlDataInitStructure.DMA_DestBaseAddr = DmaMgrBusAddress(&SSP_MASTER_HW->DR);
     DMA_CtrlDataInitStructure.DMA_SourceIncSize = DMA_SourceIncHalfword;
     DMA_CtrlDataInitStructure.DMA_DestIncSize = DMA_DestIncNo;
     DMA_CtrlDataInitStructure.DMA_MemoryDataSize = DMA_MemoryDataSize_HalfWord;
@@ -126,21 +134,18 @@ void InitHW() {
     DMA_ChannelInitStructure.DMA_SelectDataStructure = DMA_CTRL_DATA_PRIMARY;
 }
 
-extern "C" void DMA_IRQHandler() {
-    BaseType_t xHigherPriorityTaskWoken = pdFALSE;
-    if (DMA_GetCurrTransferCounter(DMA_Channel_SSP2_TX, DMA_CTRL_DATA_PRIMARY) == 1) {
-        // Если счетчик передач 0, то закончили цикл. Функция DMA_GetCurrTransferCounter +1 возвращает.
-        // Если не отключить источник прерывания, то SSP будет сыпать запросами и, соответственно, будут прерывания.
-        SSP_DMACmd(SSP_MASTER_HW, SSP_DMA_TXE, DISABLE);
-        xSemaphoreGiveFromISR(DmaSemaphore, &xHigherPriorityTaskWoken);
-    }
-    NVIC_ClearPendingIRQ(DMA_IRQn);
-    portYIELD_FROM_ISR(xHigherPriorityTaskWoken);
+/*
+ * Конец цикла канала SSP2_TX, из DMA_IRQHandler менеджера. Если не отключить запросы DMA, то SSP будет сыпать
+ * запросами в остановленный канал и, соответственно, будут прерывания.
+ */
+static void DmaDone(uint8_t channel, void *context, BaseType_t *pxHigherPriorityTaskWoken) {
+    (void)channel;
+    (void)context;
+    SSP_DMACmd(SSP_MASTER_HW, SSP_DMA_TXE, DISABLE);
+    EventPostFromISR(xDmaDoneEvent, pxHigherPriorityTaskWoken);
 }
 
 
 void SSPDmaTaskStart() {
-    DmaSemaphore = xSemaphoreCreateBinary();
-    xSemaphoreTake(DmaSemaphore, 0);
     xTaskCreate(Execute, "SSPDma", configMINIMAL_STACK_SIZE * 2, nullptr, configMAX_PRIORITIES - 1, nullptr);
 }
@@ -0,0 +1,58 @@
+/**
+ * @file UARTCommand.cpp
+ * @brief Протокол регистров по UART2: кадр uartlink - последовательность команд SSPSlaveTask
+ *
+ * Ответы на чтения уходят в порядке команд, каждый с CRC. Запись занимает REG_WRITE_SIZE байт и с неверной CRC
+ * пропускается, как в SSPSlaveTask. Неполная запись в конце кадра отбрасывается.
+ *
+ * Вход в обновление LF_SVC_UPDATE по UART отклоняется: IapEnter() принимает образ только по SSP2.
+ */
+
+#include <uartlink.h>
+#include "UARTCommand.hpp"
+#include "RegisterProtocol.hpp"
+
+#include "log_levels.h"
+#define LOG_LOCAL_LEVEL LOG_TAG_UART_LOCAL_LEVEL
+#include <mdr_log.h>
+const static char *TAG = "UART";
+
+
+static bool Write(uint8_t reg, uint16_t value) {
+    if (reg == REG_SVC && (value & REG_SVC_UPDATE)) {
+        MDR_LOGW(TAG, "Update mode over UART rejected, use SPI");
+        return false;
+    }
+    return RegisterWrite(reg, value);
+}
+
+
+static void Frame(const uint8_t *data, size_t size, void *context) {
+    (void)context;
+    for (size_t i = 0; i < size;) {
+        uint8_t command = data[i];
+        if (command & 0x01) {
+            uint8_t reply[REG_DATA_MAX + 1];
+            size_t len = RegisterRead(command >> 1, reply);
+            if (len != 0) {
+                reply[len] = RegisterCrc(reply, len);
+                UartLinkWrite(reply, len + 1);
+            }
+            i++;
+        } else if (size - i < REG_WRITE_SIZE) {
+            MDR_LOGW(TAG, "Write 0x%02X incomplete", command);
+            break;
+        } else {
+            if (data[i + 3] != RegisterCrc(&data[i], 3))
+                MDR_LOGW(TAG, "Write 0x%02X CRC error", command);
+            else if (!Write(command >> 1, data[i + 1] | (data[i + 2] << 8)))
+                MDR_LOGW(TAG, "Register 0x%02X not written", command >> 1);
+            i += REG_WRITE_SIZE;
+        }
+    }
+}
+
+
+void UARTCommandStart() {
+    UartLinkStart(Frame, nullptr);
+}
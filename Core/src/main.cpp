@@ -6,6 +6,8 @@
 #include "MDR32F9Qx_usb_default_handlers.h"
 #include <mdr_log.h>
 #include "main_app.hpp"
+#include <stackprof.h>
+#include <uartlink.h>
 #include <FreeRTOS.h>
 #include <task.h>
 
@@ -18,12 +20,19 @@ static uint8_t HidBuffer[64];
 int main(int argc, char* argv[]) {
 (void)argc;
 (void)argv;
+    StackProfPaintMsp();
     DWT->CYCCNT = 0;
     DWT->CTRL |= 1;
     CPU_Init();
+    // UART до лога: при CONFIG_UARTLINK_LOG лог выводится в UART без отладчика
+    bool uart = (CONFIG_UARTLINK_ENABLE == 1) && UartLinkInit(CONFIG_UARTLINK_BAUD);
     if (CONFIG_LOG_MAXIMUM_LEVEL > MDR_LOG_NONE) {
-        SEGGER_RTT_ConfigUpBuffer(0, nullptr, nullptr, 0, SEGGER_RTT_MODE_NO_BLOCK_SKIP);
-        mdr_log_set_vprintf([](const char *sFormat, va_list va) { return SEGGER_RTT_vprintf(0, sFormat, &va); });
+        if (uart && CONFIG_UARTLINK_LOG == 1) {
+            mdr_log_set_vprintf(UartLinkVprintf);
+        } else {
+            SEGGER_RTT_ConfigUpBuffer(0, nullptr, nullptr, 0, SEGGER_RTT_MODE_NO_BLOCK_SKIP);
+            mdr_log_set_vprintf([](const char *sFormat, va_list va) { return SEGGER_RTT_vprintf(0, sFormat, &va); });
+        }
     }
     MDR_LOGI("MAIN", "Init!!");
     USB_HID_Init(HidBuffer, sizeof(HidBuffer));
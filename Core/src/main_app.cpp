@@ -5,7 +5,6 @@
 #include <MDR32F9Qx_timer.h>
 #include <FreeRTOS.h>
 #include <task.h>
-#include <queue.h>
 #include "main_app.hpp"
 #include "main_app_extern.h"
 #include "SSPIrqTask.hpp"
@@ -14,7 +13,19 @@
 #include "SSPSlaveTask.hpp"
 #include "IICSlaveTask.hpp"
 #include "IICMasterTask.hpp"
+#include "UARTCommand.hpp"
 #include <bitbanding.h>
+#include <ring_buffer.h>
+#include <mempool.h>
+#include <stackprof.h>
+#include <cycleprof.h>
+#include <irqlat.h>
+#include <events.h>
+#include <dmacopy.h>
+#include <capture.h>
+#include <adcacq.h>
+#include <dds.h>
+#include <paramstore.h>
 
 
 #include "log_levels.h"
@@ -26,28 +37,38 @@ static const char *TAG_BLINK = "BLINK";
 static const char *TAG_PORT = "PORT";
 
 
-static void InitTimerAndPort();
+static bool InitTimerAndPort();
 
 
-static QueueHandle_t usbin;
+#define MAIN_EVENT_USB_RX       (1UL << 0)      ///< В usbin есть сообщения USB
+#define MAIN_REPORT_PERIOD_MS   (40)            ///< Период отчёта HID без входящих сообщений
+
+static RingBuffer<4, uint8_t *> usbin;          ///< Блоки пула с сообщениями, пишет только прерывание USB
+static EventChannel xUsbRxEvent;
 static uint8_t txBuffer[64];
 
 void vMainApp(void *pvParameters) {
     mdr_log_level_set(TAG_MAIN, LOG_TAG_MAIN_LEVEL);
     MDR_LOGI(TAG_MAIN, "Init!!");
+    EventInit(xUsbRxEvent, xTaskGetCurrentTaskHandle(), MAIN_EVENT_USB_RX, "usb_rx");
     MDR_LOGI(TAG_MAIN, "Delay 4 seconds while USB is enumerated");
     vTaskDelay(4000);
 
     float hs = -273;
-    USBMessage _m;
+    uint8_t *_m;
 
     for (;;) {
         memset(txBuffer, 0, sizeof(txBuffer));
-        if (xQueueReceive(usbin, &_m, 40) == pdTRUE) {
+        // Задача просыпается по сообщению USB или по сроку отчёта, событие без сообщения - уже прочитанное
+        bool received = usbin.Read(_m);
+        if (!received && EventWait(xUsbRxEvent, pdMS_TO_TICKS(MAIN_REPORT_PERIOD_MS)))
+            received = usbin.Read(_m);
+        if (received) {
             MDR_LOGI(TAG_MAIN, "USB data received");
-            MDR_LOG_BUFFER_HEXDUMP(TAG_MAIN, _m, sizeof(_m), MDR_LOG_VERBOSE);
+            MDR_LOG_BUFFER_HEXDUMP(TAG_MAIN, _m, sizeof(USBMessage), MDR_LOG_VERBOSE);
             txBuffer[0] = 1;
             txBuffer[1] = _m[1];
+            PoolFree(_m);
         } else {
             txBuffer[0] = 1;
             txBuffer[1] = 0;
@@ -61,7 +82,16 @@ void vMainApp(void *pvParameters) {
 void USBInProcess(uint8_t *data, uint16_t len) {
 BaseType_t xHigherPriorityTaskWoken = pdFALSE;
     assert_param(len == sizeof(USBMessage));
-    xQueueSendFromISR(usbin, data, &xHigherPriorityTaskWoken);
+    // В очередь кладётся только указатель на блок пула, 64 байта копируются один раз
+    auto message = static_cast<uint8_t *>(PoolAlloc(sizeof(USBMessage)));
+    if (message == nullptr)
+        return;
+    memcpy(message, data, sizeof(USBMessage));
+    if (!usbin.Write(message)) {
+        PoolFree(message);
+        return;
+    }
+    EventPostFromISR(xUsbRxEvent, &xHigherPriorityTaskWoken);
     portYIELD_FROM_ISR(xHigherPriorityTaskWoken);
 }
 
@@ -84,59 +114,81 @@ PORT_InitTypeDef PORT_InitStructure;
     }
 }
 
-QueueHandle_t irq_queue = nullptr;
+static CaptureEngine xCapture;
+
 void PortReceiver(void *pvParameters) {
-    irq_queue = xQueueCreate(1, sizeof(uint32_t));
-    InitTimerAndPort();
+    if (!InitTimerAndPort())
+        vTaskDelete(nullptr);
 
     for (;;) {
-        uint32_t irq_status;
+        // Фронты SELECT копятся в буфере DMA, задача просыпается только по таймауту
+        vTaskDelay(100);
+
+        CaptureMeasurement m;
+        CYCLEPROF_BEGIN(capture);
+        bool measured = CaptureMeasure(xCapture, m);
+        CYCLEPROF_END(capture);
+        if (measured) {
+            PORT_WriteBit(MDR_PORTE, PORT_Pin_2, SET);
+            PORT_WriteBit(MDR_PORTE, PORT_Pin_2, RESET);
+            MDR_LOGI(TAG_PORT, "SELECT: %lu edges, period %lu ticks, %lu Hz", m.Edges, m.LastPeriod,
+                     static_cast<uint32_t>(m.Frequency));
+        } else if (m.Edges != 0) {
+            MDR_LOGI(TAG_PORT, "BUTTON SELECT");
+        }
 
-        if (xQueueReceive(irq_queue, &irq_status, portMAX_DELAY) == pdTRUE) {
+        uint16_t ccr;
+        if (CaptureChannelPoll(xCapture, TIMER_CHANNEL3, ccr)) {
+            PORT_WriteBit(MDR_PORTE, PORT_Pin_2, SET);
+            PORT_WriteBit(MDR_PORTE, PORT_Pin_2, SET);
+            PORT_WriteBit(MDR_PORTE, PORT_Pin_2, SET);
             PORT_WriteBit(MDR_PORTE, PORT_Pin_2, RESET);
-            if (irq_status & TIMER_STATUS_CCR_CAP_CH1) {
-                PORT_WriteBit(MDR_PORTE, PORT_Pin_2, SET);
-                PORT_WriteBit(MDR_PORTE, PORT_Pin_2, RESET);
-                MDR_LOGI(TAG_PORT, "BUTTON SELECT");
-            } else if (irq_status & TIMER_STATUS_CCR_CAP_CH3) {
-                PORT_WriteBit(MDR_PORTE, PORT_Pin_2, SET);
-                PORT_WriteBit(MDR_PORTE, PORT_Pin_2, SET);
-                PORT_WriteBit(MDR_PORTE, PORT_Pin_2, SET);
-                PORT_WriteBit(MDR_PORTE, PORT_Pin_2, RESET);
-                MDR_LOGI(TAG_PORT, "BUTTON UP");
-            }
-
-            MDR_LOGI(TAG_PORT, "IRQ, Status: 0x%08lX", irq_status);
+            MDR_LOGI(TAG_PORT, "BUTTON UP");
+        }
+
+        if (xCapture.Lost || xCapture.DmaOverruns || xCapture.MarkerOverruns) {
+            MDR_LOGW(TAG_PORT, "Capture lost %lu, DMA overruns %lu, marker overruns %lu", xCapture.Lost,
+                     xCapture.DmaOverruns, xCapture.MarkerOverruns);
         }
     }
 }
 
 
 void InitApp() {
-    usbin = xQueueCreate(1, sizeof(USBMessage));
     xTaskCreate(vMainApp, "Main", configMINIMAL_STACK_SIZE * 2, nullptr, tskIDLE_PRIORITY, nullptr);
 //    xTaskCreate(vBlinker, "Blink", configMINIMAL_STACK_SIZE * 2, nullptr, tskIDLE_PRIORITY + 1, nullptr);
     xTaskCreate(PortReceiver, "IRQ", configMINIMAL_STACK_SIZE * 2, nullptr, configMAX_PRIORITIES - 1, nullptr);
 
+    // Примеры SSP2 взаимоисключающие, включается один. Регистры НЧ драйвера, в том числе ADC_CH1..ADC_ALL от adcacq,
+    // по умолчанию обслуживает UARTCommand. SSPSlaveTask обслуживает ту же таблицу по SPI и вход в обновление IAP
 //    SSPPoolTaskStart();
 //    SSPIrqTaskStart();
 //    SSPDmaTaskStart();
 //    SSPSlaveTaskStart();
     IICSlaveTaskStart();
     IICMasterTaskStart();
+    UARTCommandStart();
+    ParamStoreStart();
+    StackProfStart();
+    CycleProfStart();
+    IrqLatStart();
+    DmaCopyStart();
+    AdcAcqStart();
+    DdsStart();
 }
 
 
 /**
  * @brief Инициализация таймера 3 для захвата фронтов от кнопок
  *
- * PC2 - кнопка SELECT, TMR3_CH1, PullUp 10k.
+ * PC2 - кнопка SELECT, TMR3_CH1, PullUp 10k. Канал потока DMA, сюда же можно подать частотный сигнал.
+ *
+ * PB5 - кнопка UP, TMR3_CH3, PullUp 10k. Опрашивается по флагу захвата.
  *
- * PB5 - кнопка UP, TMR3_CH3, PullUp 10k.
+ * @return false, если канал DMA TIMER3 занят
  */
-void InitTimerAndPort() {
+bool InitTimerAndPort() {
     RST_CLK_PCLKcmd(RST_CLK_PCLK_PORTB | RST_CLK_PCLK_PORTC, ENABLE);
-    RST_CLK_PCLKcmd(RST_CLK_PCLK_TIMER3, ENABLE);
 
 PORT_InitTypeDef PORT_InitStructure;
     PORT_StructInit(&PORT_InitStructure);
@@ -154,31 +206,23 @@ PORT_InitTypeDef PORT_InitStructure;
     PORT_InitStructure.PORT_FUNC = PORT_FUNC_OVERRID; // MODE[1:0] = 11, переопределенная
     PORT_Init(MDR_PORTB, &PORT_InitStructure);
 
-    // TIMER3, CH1 и CH3
-    TIMER_DeInit(MDR_TIMER3);
-    TIMER_BRGInit(MDR_TIMER3, TIMER_HCLKdiv1); // Включаем тактовую на таймер
-
-    MDR_TIMER3->CNT = 0;
-    MDR_TIMER3->PSG = 0;
-    MDR_TIMER3->ARR = 0xFF;
-    MDR_TIMER3->IE = (0b0101 << TIMER_IE_CCR_CAP_EVENT_IE_Pos); // Прерывание CCR CAP EVENT для 1 и 3 канала
-
-    // 15b канал в режиме захват
+    // TIMER3, 1 МГц, период счёта 65.5 мс. Половина буфера DMA, 128 фронтов, должна успеть за период: до ~1.9 кГц
+    // непрерывно, при опросе раз в 100 мс без потерь до ~1.2 кГц. Для более быстрых сигналов уменьшить PSG и период
+    // опроса или увеличить CONFIG_CAPTURE_RING_SIZE
     // 0011 CHFLTR[3:0], Сигнал зафиксирован в 8 триггерах на частоте TIM_CLK
-    // 01 CHSEL[5:4] Отрицательный фронт на CH
-    MDR_TIMER3->CH1_CNTRL = (0b1 << TIMER_CH_CNTRL_CAP_NPWM_Pos) | (0b01 << TIMER_CH_CNTRL_CHSEL_Pos) | (0b0000 << TIMER_CH_CNTRL_CHFLTR_Pos);
-    MDR_TIMER3->CH3_CNTRL = (0b1 << TIMER_CH_CNTRL_CAP_NPWM_Pos) | (0b01 << TIMER_CH_CNTRL_CHSEL_Pos) | (0b0000 << TIMER_CH_CNTRL_CHFLTR_Pos);
-
-    MDR_TIMER3->CNTRL = 0x1;
-    NVIC_SetPriority(Timer3_IRQn, NVIC_EncodePriority(NVIC_GetPriorityGrouping(), 6, 0));
-    NVIC_EnableIRQ(Timer3_IRQn);
+    // Отрицательный фронт на CH1 в CCR, положительный в CCR1 - длительность нажатия
+    if (!CaptureInit(xCapture, MDR_TIMER3, 79, 0xFFFF))
+        return false;
+    CaptureChannelInit(xCapture, TIMER_CHANNEL1, CAPTURE_EDGE_FALLING, CAPTURE_EDGE_RISING, 0b0011);
+    CaptureChannelInit(xCapture, TIMER_CHANNEL3, CAPTURE_EDGE_FALLING, CAPTURE_EDGE_NONE, 0b0011);
+    CaptureStart(xCapture, TIMER_CHANNEL1);
+    IrqLatRegister(Timer3_IRQn, "capt", CONFIG_IRQLAT_BUDGET_CAPTURE);
+    return true;
 }
 
 
 extern "C" void Timer3_IRQHandler() {
-    BaseType_t xHigherPriorityTaskWoken = pdFALSE;
-    uint32_t ls = MDR_TIMER3->STATUS;
-    xQueueSendFromISR(irq_queue, &ls, &xHigherPriorityTaskWoken);
-    MDR_TIMER3->STATUS = 0;
-    portYIELD_FROM_ISR(xHigherPriorityTaskWoken);
+    IRQLAT_TIMER_ENTRY(Timer3_IRQn, MDR_TIMER3, MDR_TIMER3->ARR);     // Прерывание только по CNT == ARR
+    STACKPROF_ISR_ENTER();
+    CaptureTimerIRQHandler(xCapture);
 }
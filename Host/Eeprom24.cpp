@@ -0,0 +1,214 @@
+#include <algorithm>
+#include <stdexcept>
+#include "Eeprom24.h"
+#include "FtdiException.h"
+
+// Биты FT4222_I2CMaster_GetStatus
+#define I2C_STATUS_ERROR        (1U << 1)
+#define I2C_STATUS_ADDR_NACK    (1U << 2)
+#define I2C_STATUS_DATA_NACK    (1U << 3)
+
+const uint8_t Eeprom24::DefaultAddress;
+const uint16_t Eeprom24::MaxTransfer;
+
+static const I2CFlag FLAG_REPEATED_START_AND_STOP = static_cast<I2CFlag>(FLAG_REPEATED_START | FLAG_STOP);
+
+
+/**
+ * Микросхемы из Tools/lists.py
+ */
+const std::vector<EepromChip> &Eeprom24::Chips() {
+    static const std::vector<EepromChip> chips = {
+        {"generic", "", "Generic", 128, 8, true, 1, 3, 400},
+        {"microchip_24aa65", "Microchip", "24AA65", 8 * 1024, 64, true, 2, 3, 400},
+        {"microchip_24lc65", "Microchip", "24LC65", 8 * 1024, 64, true, 2, 3, 400},
+        {"microchip_24c65", "Microchip", "24C65", 8 * 1024, 64, true, 2, 3, 400},
+        {"microchip_24aa64", "Microchip", "24AA64", 8 * 1024, 32, true, 2, 3, 400},
+        {"microchip_24lc64", "Microchip", "24LC64", 8 * 1024, 32, true, 2, 3, 400},
+        {"microchip_24aa02uid", "Microchip", "24AA02UID", 256, 8, true, 1, 0, 400},
+        {"microchip_24aa025uid", "Microchip", "24AA025UID", 256, 16, true, 1, 3, 400},
+        {"microchip_24aa025uid_sot23", "Microchip", "24AA025UID (SOT-23)", 256, 16, true, 1, 2, 400},
+        {"onsemi_cat24c256", "ON Semiconductor", "CAT24C256", 32 * 1024, 64, true, 2, 3, 1000},
+        {"onsemi_cat24m01", "ON Semiconductor", "CAT24M01", 128 * 1024, 256, true, 2, 2, 1000},
+        {"siemens_slx_24c01", "Siemens", "SLx 24C01", 128, 8, true, 1, 0, 400},
+        {"siemens_slx_24c02", "Siemens", "SLx 24C02", 256, 8, true, 1, 0, 400},
+        {"st_m24c01", "ST", "M24C01", 128, 16, true, 1, 3, 400},
+        {"st_m24c02", "ST", "M24C02", 256, 16, true, 1, 3, 400},
+        {"st_m24m02", "ST", "M24M02", 256 * 1024, 256, true, 2, 2, 400},
+        {"cy_fm24cl64b", "Cypress", "FM24CL64B", 8 * 1024, 8 * 1024, true, 2, 3, 1000},
+        {"xicor_x24c02", "Xicor", "X24C02", 256, 4, true, 1, 3, 100},
+    };
+    return chips;
+}
+
+
+/**
+ * Микросхема по ключу Tools/lists.py
+ * @return nullptr, если микросхемы нет в таблице
+ */
+const EepromChip *Eeprom24::FindChip(const std::string &name) {
+    for (const auto &chip : Chips()) {
+        if (name == chip.Name)
+            return &chip;
+    }
+    return nullptr;
+}
+
+
+/**
+ * CRC-32 (IEEE 802.3, как у zlib), crc - значение предыдущей части данных
+ */
+uint32_t Eeprom24::Crc32(const uint8_t *data, size_t size, uint32_t crc) {
+    crc = ~crc;
+    for (size_t i = 0; i < size; i++) {
+        crc ^= data[i];
+        for (int bit = 0; bit < 8; bit++)
+            crc = (crc >> 1) ^ (0xEDB88320U & (0U - (crc & 1)));
+    }
+    return ~crc;
+}
+
+
+/**
+ * @param bus I2cBus& - ведущий I2C
+ * @param chip const EepromChip& - параметры микросхемы
+ * @param address uint8_t - адрес I2C микросхемы с учётом A0..A2, без битов старшего адреса ячейки
+ */
+Eeprom24::Eeprom24(I2cBus &bus, const EepromChip &chip, uint8_t address) :
+        m_xBus(bus), m_xChip(chip), m_uAddress(address), m_uSegment(1U << (8 * chip.AddrBytes)) {
+}
+
+
+uint16_t Eeprom24::SlaveAddress(uint32_t offset) const {
+    return m_uAddress | (offset / m_uSegment);
+}
+
+
+size_t Eeprom24::EncodeAddress(uint32_t offset, uint8_t *buffer) const {
+    for (size_t i = 0; i < m_xChip.AddrBytes; i++)
+        buffer[i] = offset >> (8 * (m_xChip.AddrBytes - 1 - i));
+    return m_xChip.AddrBytes;
+}
+
+
+void Eeprom24::CheckRange(uint32_t offset, uint32_t size) const {
+    if (offset > m_xChip.Size || size > m_xChip.Size - offset)
+        throw std::out_of_range("EEPROM range out of chip size");
+}
+
+
+void Eeprom24::CheckAck(int status, bool transferred) const {
+    if (status != 0)
+        throw FtdiException("I2C transfer failed");
+
+    uint8_t bits = 0;
+    if (m_xBus.GetStatus(bits) != 0)
+        throw FtdiException("I2C status failed");
+    if (bits & I2C_STATUS_ADDR_NACK)
+        throw FtdiException("EEPROM not responding");
+    if ((bits & (I2C_STATUS_ERROR | I2C_STATUS_DATA_NACK)) || !transferred)
+        throw FtdiException("EEPROM transfer not acknowledged");
+}
+
+
+/*
+ * Опрос ACK после записи страницы: пока идёт внутренний цикл записи, микросхема не подтверждает адрес.
+ * Опрос - запись только адреса ячейки, то есть установка указателя без данных
+ */
+void Eeprom24::WaitReady(uint32_t offset) {
+    uint8_t address[2];
+    size_t size = EncodeAddress(offset, address);
+    auto deadline = std::chrono::steady_clock::now() + m_xPollTimeout;
+
+    for (;;) {
+        uint16_t transferred = 0;
+        if (m_xBus.WriteEx(SlaveAddress(offset), FLAG_START_AND_STOP, address, size, transferred) != 0)
+            throw FtdiException("I2C transfer failed");
+        uint8_t bits = 0;
+        if (m_xBus.GetStatus(bits) != 0)
+            throw FtdiException("I2C status failed");
+        if ((bits & I2C_STATUS_ADDR_NACK) == 0)
+            return;
+
+        m_xStats.Polls++;
+        if (std::chrono::steady_clock::now() > deadline)
+            throw FtdiException("EEPROM write cycle timeout");
+    }
+}
+
+
+/**
+ * Чтение
+ * @param offset uint32_t - адрес первой ячейки
+ * @param buffer uint8_t* - приёмник
+ * @param size uint32_t - байт
+ */
+void Eeprom24::Read(uint32_t offset, uint8_t *buffer, uint32_t size) {
+    CheckRange(offset, size);
+    auto start = std::chrono::steady_clock::now();
+
+    while (size > 0) {
+        uint32_t chunk = std::min<uint32_t>({size, m_uSegment - offset % m_uSegment, MaxTransfer});
+        uint8_t address[2];
+        size_t addressSize = EncodeAddress(offset, address);
+
+        uint16_t transferred = 0;
+        int status = m_xBus.WriteEx(SlaveAddress(offset), FLAG_START, address, addressSize, transferred);
+        CheckAck(status, transferred == addressSize);
+        status = m_xBus.ReadEx(SlaveAddress(offset), FLAG_REPEATED_START_AND_STOP, buffer, chunk, transferred);
+        CheckAck(status, transferred == chunk);
+
+        m_xStats.Transactions++;
+        m_xStats.Bytes += chunk;
+        offset += chunk;
+        buffer += chunk;
+        size -= chunk;
+    }
+    m_xStats.Elapsed += std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - start);
+}
+
+
+/**
+ * Запись по страницам с ожиданием окончания записи каждой страницы
+ * @param offset uint32_t - адрес первой ячейки, может быть не кратен странице
+ * @param data const uint8_t* - данные
+ * @param size uint32_t - байт
+ */
+void Eeprom24::Write(uint32_t offset, const uint8_t *data, uint32_t size) {
+    CheckRange(offset, size);
+    auto start = std::chrono::steady_clock::now();
+
+    std::vector<uint8_t> packet(m_xChip.AddrBytes + m_xChip.PageSize);
+    while (size > 0) {
+        uint32_t chunk = std::min(size, m_xChip.PageSize - offset % m_xChip.PageSize);
+        size_t addressSize = EncodeAddress(offset, packet.data());
+        std::copy(data, data + chunk, packet.begin() + addressSize);
+
+        uint16_t length = addressSize + chunk;
+        uint16_t transferred = 0;
+        int status = m_xBus.WriteEx(SlaveAddress(offset), FLAG_START_AND_STOP, packet.data(), length, transferred);
+        CheckAck(status, transferred == length);
+        WaitReady(offset);
+
+        m_xStats.Transactions++;
+        m_xStats.Pages++;
+        m_xStats.Bytes += chunk;
+        offset += chunk;
+        data += chunk;
+        size -= chunk;
+    }
+    m_xStats.Elapsed += std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - start);
+}
+
+
+/**
+ * Сравнение CRC-32 содержимого микросхемы с данными
+ * @param crc uint32_t& - CRC-32 прочитанного из микросхемы
+ * @return true, если CRC совпадает с CRC data
+ */
+bool Eeprom24::Verify(uint32_t offset, const uint8_t *data, uint32_t size, uint32_t &crc) {
+    std::vector<uint8_t> image(size);
+    Read(offset, image.data(), size);
+    crc = Crc32(image.data(), image.size());
+    return crc == Crc32(data, size);
+}
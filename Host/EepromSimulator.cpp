@@ -0,0 +1,111 @@
+#include "EepromSimulator.h"
+
+
+// Биты FT4222_I2CMaster_GetStatus
+#define I2C_STATUS_ERROR        (1U << 1)
+#define I2C_STATUS_ADDR_NACK    (1U << 2)
+#define I2C_STATUS_IDLE         (1U << 5)
+
+
+EepromSimulator::EepromSimulator(const EepromChip &chip, uint8_t address, int busyPolls) :
+        m_xChip(chip), m_uAddress(address), m_iBusyPolls(busyPolls), m_uStatus(I2C_STATUS_IDLE),
+        m_vMemory(chip.Size, 0xFF) {
+}
+
+
+/*
+ * Фаза адреса I2C. Младшие биты адреса выбирают сегмент, если объём больше 2^(8 * AddrBytes).
+ * Во время цикла записи микросхема не отвечает
+ */
+bool EepromSimulator::Address(uint16_t slaveAddress, I2CFlag flag) {
+    uint32_t segmentBits = 8 * m_xChip.AddrBytes;
+    uint32_t segments = (m_xChip.Size + (1U << segmentBits) - 1) >> segmentBits;
+    uint16_t mask = segments > 1 ? segments - 1 : 0;
+
+    bool start = flag != FLAG_NONE && (flag & FLAG_START);
+    if ((slaveAddress & ~mask) != m_uAddress || (start && m_iBusy > 0)) {
+        if (start && m_iBusy > 0)
+            m_iBusy--;
+        m_uStatus = I2C_STATUS_IDLE | I2C_STATUS_ERROR | I2C_STATUS_ADDR_NACK;
+        return false;
+    }
+    m_uStatus = I2C_STATUS_IDLE;
+    if (start) {
+        m_uSegment = static_cast<uint32_t>(slaveAddress & mask) << segmentBits;
+        m_uAddressBytes = 0;
+        m_vPage.clear();
+    }
+    return true;
+}
+
+
+/*
+ * STOP после записи данных: данные ложатся в страницу указателя с переходом на её начало
+ */
+void EepromSimulator::Commit() {
+    if (m_vPage.empty())
+        return;
+
+    uint32_t base = m_uPointer - m_uPointer % m_xChip.PageSize;
+    uint32_t column = m_uPointer % m_xChip.PageSize;
+    for (auto byte : m_vPage) {
+        m_vMemory[(base + column) % m_xChip.Size] = byte;
+        column = (column + 1) % m_xChip.PageSize;
+    }
+    m_uPointer = (base + column) % m_xChip.Size;
+    m_vPage.clear();
+    m_iBusy = m_iBusyPolls;
+    m_iWriteCycles++;
+}
+
+
+int EepromSimulator::WriteEx(uint16_t slaveAddress, I2CFlag flag, uint8_t *buffer, uint16_t bufferSize, uint16_t &sizeTransferred) {
+    sizeTransferred = 0;
+    if (!Address(slaveAddress, flag))
+        return 0;
+
+    for (uint16_t i = 0; i < bufferSize; i++) {
+        if (m_uAddressBytes < m_xChip.AddrBytes) {
+            if (m_uAddressBytes == 0)
+                m_uPointer = m_uSegment;
+            m_uPointer |= static_cast<uint32_t>(buffer[i]) << (8 * (m_xChip.AddrBytes - 1 - m_uAddressBytes));
+            m_uPointer %= m_xChip.Size;
+            m_uAddressBytes++;
+        } else {
+            m_vPage.push_back(buffer[i]);
+        }
+    }
+    sizeTransferred = bufferSize;
+
+    if (flag != FLAG_NONE && (flag & FLAG_STOP))
+        Commit();
+    return 0;
+}
+
+
+int EepromSimulator::ReadEx(uint16_t slaveAddress, I2CFlag flag, uint8_t *buffer, uint16_t bufferSize, uint16_t &sizeTransferred) {
+    sizeTransferred = 0;
+    if (!Address(slaveAddress, flag))
+        return 0;
+
+    for (uint16_t i = 0; i < bufferSize; i++) {
+        buffer[i] = m_vMemory[m_uPointer];
+        m_uPointer = (m_uPointer + 1) % m_xChip.Size;
+    }
+    sizeTransferred = bufferSize;
+    return 0;
+}
+
+
+int EepromSimulator::GetStatus(uint8_t &status) {
+    status = m_uStatus;
+    return 0;
+}
+
+
+int EepromSimulator::ResetBus() {
+    m_uStatus = I2C_STATUS_IDLE;
+    m_uAddressBytes = 0;
+    m_vPage.clear();
+    return 0;
+}
@@ -0,0 +1,97 @@
+#include <mutex>
+#include <string>
+#include <fmt/core.h>
+#include "FtdiDeviceList.h"
+#include "FtdiException.h"
+
+
+static std::mutex g_xDevListMutex;
+static std::vector<FT_DEVICE_LIST_INFO_NODE> g_FT4222DevList;
+
+
+static std::string DeviceFlagToString(DWORD flags) {
+    std::string msg;
+    msg += (flags & 0x1)? "DEVICE_OPEN" : "DEVICE_CLOSED";
+    msg += ", ";
+    msg += (flags & 0x2)? "High-speed USB" : "Full-speed USB";
+    return msg;
+}
+
+
+static int FindLocked(bool show) {
+    FT_STATUS ftStatus = 0;
+    DWORD numOfDevices = 0;
+    FT_CreateDeviceInfoList(&numOfDevices);
+    g_FT4222DevList.clear();
+
+    for (DWORD iDev = 0; iDev < numOfDevices; ++iDev) {
+        FT_DEVICE_LIST_INFO_NODE devInfo{0};
+        ftStatus = FT_GetDeviceInfoDetail(iDev, &devInfo.Flags, &devInfo.Type, &devInfo.ID, &devInfo.LocId,
+                                          devInfo.SerialNumber, devInfo.Description, &devInfo.ftHandle);
+        if (FT_OK == ftStatus) {
+            const std::string desc = devInfo.Description;
+            if (desc == "FT4222" || desc == "FT4222 A") {
+                g_FT4222DevList.push_back(devInfo);
+                if (show) {
+                    fmt::print("Dev {:d}:\n", iDev);
+                    fmt::print("  Flags= 0x{:X}, ({})\n", devInfo.Flags, DeviceFlagToString(devInfo.Flags));
+                    fmt::print("  Type= 0x{:X}\n", devInfo.Type);
+                    fmt::print("  ID= 0x{:X}\n", devInfo.ID);
+                    fmt::print("  LocID= 0x{:X}\n", devInfo.LocId);
+                    fmt::print("  SerialNumber= {}\n", devInfo.SerialNumber);
+                    fmt::print("  Description= {}\n\n", devInfo.Description);
+                }
+            }
+        }
+    }
+    return g_FT4222DevList.size();
+}
+
+
+/**
+ * Перечисление подключенных FT4222 заново
+ * @param show bool - true вывести описание найденных устройств
+ * @return Количество найденных FT4222
+ */
+int FtdiDeviceList::Find(bool show) {
+    std::lock_guard<std::mutex> lock(g_xDevListMutex);
+    return FindLocked(show);
+}
+
+
+/**
+ * Количество FT4222, при пустом списке - после перечисления
+ */
+int FtdiDeviceList::Count() {
+    std::lock_guard<std::mutex> lock(g_xDevListMutex);
+    if (g_FT4222DevList.empty())
+        FindLocked(false);
+    return g_FT4222DevList.size();
+}
+
+
+/**
+ * Адрес USB устройства для FT_OpenEx(FT_OPEN_BY_LOCATION), при пустом списке - после перечисления
+ * @param device int - номер преобразователя
+ * @return LocId устройства
+ * @throw FtdiException, если FT4222 нет или номер больше количества
+ */
+DWORD FtdiDeviceList::Location(int device) {
+    std::lock_guard<std::mutex> lock(g_xDevListMutex);
+    if (g_FT4222DevList.empty()) {
+        if (0 == FindLocked(false))
+            throw FtdiException("No FTDI devices present");
+    }
+    if (device < 0 || (size_t)device >= g_FT4222DevList.size())
+        throw FtdiException("Device not found");
+    return g_FT4222DevList[device].LocId;
+}
+
+
+/**
+ * Копия списка, не меняется при следующих Find()
+ */
+std::vector<FT_DEVICE_LIST_INFO_NODE> FtdiDeviceList::Snapshot() {
+    std::lock_guard<std::mutex> lock(g_xDevListMutex);
+    return g_FT4222DevList;
+}
@@ -1,23 +1,15 @@
 #include <vector>
 #include <fmt/core.h>
 #include "common.h"
+#include "FtdiDeviceList.h"
 #include "FtdiSpi.h"
 
 
-static std::vector<FT_DEVICE_LIST_INFO_NODE> g_FT4222DevList;
-
-
 FtdiSpi::FtdiSpi(int device) : m_iDeviceNumber(device) {
-    if (g_FT4222DevList.empty()) {
-        if (0 == FindDevices(false))
-            throw FtdiException("No FTDI devices present");
-    }
-
     FT_STATUS ftStatus;
-    if (m_iDeviceNumber >= g_FT4222DevList.size())
-        throw FtdiException("Device not found");
+    DWORD location = FtdiDeviceList::Location(m_iDeviceNumber);
 
-    ftStatus = FT_OpenEx((PVOID)g_FT4222DevList[m_iDeviceNumber].LocId, FT_OPEN_BY_LOCATION, &m_xHandle);
+    ftStatus = FT_OpenEx((PVOID)(uintptr_t)location, FT_OPEN_BY_LOCATION, &m_xHandle);
     if (FT_OK != ftStatus) {
         throw FtdiException("Cannot open device");
     }
@@ -41,58 +33,61 @@ FtdiSpi::~FtdiSpi() {
     }
 }
 
-bool FtdiSpi::Read(uint8 *buffer, uint16 bufferSize, BOOL isEndTransaction) {
+bool FtdiSpi::Read(uint8_t *buffer, uint16_t bufferSize, bool isEndTransaction) {
     uint16 transferred = 0;
     FT_STATUS ftStatus;
-    ftStatus = FT4222_SPIMaster_SingleRead(m_xHandle, buffer, bufferSize, &transferred, isEndTransaction);
+    ftStatus = FT4222_SPIMaster_SingleRead(m_xHandle, buffer, bufferSize, &transferred, isEndTransaction ? TRUE : FALSE);
     if (FT_OK != ftStatus)
         throw FtdiException("FT4222_SPIMaster_SingleRead error in FtdiSpi::Read");
     return transferred == bufferSize;
 }
 
-bool FtdiSpi::Write(uint8 *buffer, uint16 bufferSize, BOOL isEndTransaction) {
+bool FtdiSpi::Write(uint8_t *buffer, uint16_t bufferSize, bool isEndTransaction) {
     uint16 transferred = 0;
     FT_STATUS ftStatus;
-    ftStatus = FT4222_SPIMaster_SingleWrite(m_xHandle, buffer, bufferSize, &transferred, isEndTransaction);
+    ftStatus = FT4222_SPIMaster_SingleWrite(m_xHandle, buffer, bufferSize, &transferred, isEndTransaction ? TRUE : FALSE);
     if (FT_OK != ftStatus)
         throw FtdiException("FT4222_SPIMaster_SingleWrite error in FtdiSpi::Write");
     return transferred == bufferSize;
 }
 
+/**
+ * Полнодуплексная передача: bufferSize байт записываются и одновременно читаются за один обмен по USB
+ * @param readBuffer uint8_t* - принятые байты
+ * @param writeBuffer uint8_t* - передаваемые байты
+ * @param bufferSize uint16_t - размер обоих буферов
+ * @param isEndTransaction bool - true снимает SS после передачи
+ * @return true, если передано bufferSize байт
+ */
+bool FtdiSpi::ReadWrite(uint8_t *readBuffer, uint8_t *writeBuffer, uint16_t bufferSize, bool isEndTransaction) {
+    uint16 transferred = 0;
+    FT_STATUS ftStatus;
+    ftStatus = FT4222_SPIMaster_SingleReadWrite(m_xHandle, readBuffer, writeBuffer, bufferSize, &transferred,
+                                                isEndTransaction ? TRUE : FALSE);
+    if (FT_OK != ftStatus)
+        throw FtdiException("FT4222_SPIMaster_SingleReadWrite error in FtdiSpi::ReadWrite");
+    return transferred == bufferSize;
+}
 
-static std::string DeviceFlagToString(DWORD flags) {
-    std::string msg;
-    msg += (flags & 0x1)? "DEVICE_OPEN" : "DEVICE_CLOSED";
-    msg += ", ";
-    msg += (flags & 0x2)? "High-speed USB" : "Full-speed USB";
-    return msg;
+/**
+ * Команда и ответ при одном выборе ведомого, но двумя обменами по USB: Write(command) без снятия SS,
+ * затем Read(response). Задержка чтения та же, что у отдельных Write и Read. Пауза между обменами - время ведомому
+ * разобрать команду и положить ответ в FIFO передатчика SSP. Полнодуплексный ReadWrite() тактирует ответ
+ * сразу за командой, ведомый не успевает и отвечает нулями
+ * @param command const uint8_t* - байты команды
+ * @param commandSize uint16_t - размер команды
+ * @param response uint8_t* - ответ, байты после команды
+ * @param responseSize uint16_t - размер ответа
+ * @return true, если передана вся транзакция
+ */
+bool FtdiSpi::WriteRead(const uint8_t *command, uint16_t commandSize, uint8_t *response, uint16_t responseSize) {
+    m_vTxBuffer.assign(command, command + commandSize);
+    bool complete = Write(m_vTxBuffer.data(), commandSize, false);
+    complete &= Read(response, responseSize, true);
+    return complete;
 }
 
-int FtdiSpi::FindDevices(bool show) {
-    FT_STATUS ftStatus = 0;
-    DWORD numOfDevices = 0;
-    FT_CreateDeviceInfoList(&numOfDevices);
-    g_FT4222DevList.clear();
 
-    for (DWORD iDev = 0; iDev < numOfDevices; ++iDev) {
-        FT_DEVICE_LIST_INFO_NODE devInfo{0};
-        ftStatus = FT_GetDeviceInfoDetail(iDev, &devInfo.Flags, &devInfo.Type, &devInfo.ID, &devInfo.LocId,
-                                          devInfo.SerialNumber, devInfo.Description, &devInfo.ftHandle);
-        if (FT_OK == ftStatus) {
-            const std::string desc = devInfo.Description;
-            if (desc == "FT4222" || desc == "FT4222 A") {
-                g_FT4222DevList.push_back(devInfo);
-                if (show) {
-                    fmt::print("Dev {:d}:\n", iDev);
-                    fmt::print("  Flags= 0x{:X}, ({})\n", devInfo.Flags, DeviceFlagToString(devInfo.Flags));
-                    fmt::print("  Type= 0x{:X}\n", devInfo.Type);
-                    fmt::print("  ID= 0x{:X}\n", devInfo.ID);
-                    fmt::print("  LocID= 0x{:X}\n", devInfo.LocId);
-                    fmt::print("  SerialNumber= {}\n", devInfo.SerialNumber);
-                    fmt::print("  Description= {}\n\n", devInfo.Description);
-                }
-            }
-        }
-    }
-    return g_FT4222DevList.size();
+int FtdiSpi::FindDevices(bool show) {
+    return FtdiDeviceList::Find(show);
 }
@@ -0,0 +1,73 @@
+#include "I2cSimulator.h"
+
+
+// Биты FT4222_I2CMaster_GetStatus
+#define I2C_STATUS_ERROR        (1U << 1)
+#define I2C_STATUS_ADDR_NACK    (1U << 2)
+#define I2C_STATUS_IDLE         (1U << 5)
+
+const uint16_t I2cSimulator::DefaultAddress;
+
+static const uint8_t TestData[8] = {0xA0, 0xA1, 0xBC, 0xCC, 0xDE, 0x12, 0x68, 0x57};
+
+
+I2cSimulator::I2cSimulator(uint16_t slaveAddress) : m_uAddress(slaveAddress), m_uStatus(I2C_STATUS_IDLE) {
+}
+
+
+/*
+ * Фаза адреса: START или повторный START начинает новую посылку, без START продолжается текущая
+ */
+bool I2cSimulator::Address(uint16_t slaveAddress, I2CFlag flag) {
+    if (slaveAddress != m_uAddress) {
+        m_uStatus = I2C_STATUS_IDLE | I2C_STATUS_ERROR | I2C_STATUS_ADDR_NACK;
+        return false;
+    }
+    m_uStatus = I2C_STATUS_IDLE;
+    if (flag != FLAG_NONE && (flag & FLAG_START)) {
+        m_uTxIndex = 0;
+        m_vReceived.clear();
+    }
+    return true;
+}
+
+
+int I2cSimulator::WriteEx(uint16_t slaveAddress, I2CFlag flag, uint8_t *buffer, uint16_t bufferSize, uint16_t &sizeTransferred) {
+    sizeTransferred = 0;
+    if (!Address(slaveAddress, flag))
+        return 0;
+
+    for (uint16_t i = 0; i < bufferSize; i++) {
+        if (m_vReceived.empty())
+            m_uRegister = buffer[i];
+        m_vReceived.push_back(buffer[i]);
+    }
+    sizeTransferred = bufferSize;
+    return 0;
+}
+
+
+int I2cSimulator::ReadEx(uint16_t slaveAddress, I2CFlag flag, uint8_t *buffer, uint16_t bufferSize, uint16_t &sizeTransferred) {
+    sizeTransferred = 0;
+    if (!Address(slaveAddress, flag))
+        return 0;
+
+    for (uint16_t i = 0; i < bufferSize; i++)
+        buffer[i] = TestData[m_uTxIndex++ % sizeof(TestData)];
+    sizeTransferred = bufferSize;
+    return 0;
+}
+
+
+int I2cSimulator::GetStatus(uint8_t &status) {
+    status = m_uStatus;
+    return 0;
+}
+
+
+int I2cSimulator::ResetBus() {
+    m_uStatus = I2C_STATUS_IDLE;
+    m_uTxIndex = 0;
+    m_vReceived.clear();
+    return 0;
+}
@@ -1,79 +1,25 @@
 #include <chrono>
+#include <cmath>
 #include <thread>
+#include <vector>
 #include <LFSmart.h>
-#include "common.h"
+#include "FtdiException.h"
+#include "crc8.h"
 
-static uint8_t crc8(uint8_t *pcBlock, size_t len);
 
-
-static lfc::Registers GetAdcCommand(lfc::Channel channel) {
-    switch (channel) {
-        case lfc::Channel::CHANNEL_1:
-            return lfc::Registers::ADC_CH1;
-        case lfc::Channel::CHANNEL_2:
-            return lfc::Registers::ADC_CH2;
-        case lfc::Channel::CHANNEL_3:
-            return lfc::Registers::ADC_CH3;
-        case lfc::Channel::CHANNEL_4:
-            return lfc::Registers::ADC_CH4;
-        case lfc::Channel::CHANNEL_ALL:
-            return lfc::Registers::ADC_ALL;
-        default:
-            return lfc::Registers::INVALID;
-    }
-}
-
-static lfc::Registers GetDacCommand(lfc::Channel channel) {
-    switch (channel) {
-        case lfc::Channel::CHANNEL_1:
-            return lfc::Registers::DAC_CH1;
-        case lfc::Channel::CHANNEL_2:
-            return lfc::Registers::DAC_CH2;
-        case lfc::Channel::CHANNEL_3:
-            return lfc::Registers::DAC_CH3;
-        case lfc::Channel::CHANNEL_4:
-            return lfc::Registers::DAC_CH4;
-        case lfc::Channel::CHANNEL_ALL:
-            return lfc::Registers::DAC_ALL;
-        default:
-            return lfc::Registers::INVALID;
-    }
-}
-
-
-static lfc::Registers GetDacMaximumCommand(lfc::Channel channel) {
-    switch (channel) {
-        case lfc::Channel::CHANNEL_1:
-            return lfc::Registers::DAC_MAX_CH1;
-        case lfc::Channel::CHANNEL_2:
-            return lfc::Registers::DAC_MAX_CH2;
-        case lfc::Channel::CHANNEL_3:
-            return lfc::Registers::DAC_MAX_CH3;
-        case lfc::Channel::CHANNEL_4:
-            return lfc::Registers::DAC_MAX_CH4;
-        default:
-            return lfc::Registers::INVALID;
-    }
-}
-
-
-static lfc::Registers GetDacDefaultCommand(lfc::Channel channel) {
-    switch (channel) {
-        case lfc::Channel::CHANNEL_1:
-            return lfc::Registers::DAC_DEFAULT_CH1;
-        case lfc::Channel::CHANNEL_2:
-            return lfc::Registers::DAC_DEFAULT_CH2;
-        case lfc::Channel::CHANNEL_3:
-            return lfc::Registers::DAC_DEFAULT_CH3;
-        case lfc::Channel::CHANNEL_4:
-            return lfc::Registers::DAC_DEFAULT_CH4;
-        default:
-            return lfc::Registers::INVALID;
-    }
+/*
+ * Регистр канала группы из register_map.h, CHANNEL_ALL - регистр всех каналов
+ */
+static lfc::Registers GetChannelCommand(const lfc::RegisterGroup &group, lfc::Channel channel) {
+    if (channel == lfc::Channel::CHANNEL_ALL)
+        return group.All;
+    if (channel < 0 || channel >= group.Count)
+        return lfc::Registers::INVALID;
+    return static_cast<lfc::Registers>(group.First + channel);
 }
 
 
-LFSmart::LFSmart(FtdiSpi &spi, bool crc, int tries) : m_xSpi(spi), m_bUseCRC(crc), m_iTries(tries) {
+LFSmart::LFSmart(SpiTransport &spi, bool crc, int tries) : m_xSpi(spi), m_bUseCRC(crc), m_iTries(tries) {
 }
 
 
@@ -118,6 +64,8 @@ lfc::LastError LFSmart::LastError() {
     } catch (const FtdiException &e) {
         throw;
     }
+    if (m_bCache && read_value != lfc::LastError::LE_NOERROR)
+        m_xCache.DeviceError();
     return (lfc::LastError)read_value;
 }
 
@@ -135,7 +83,7 @@ uint16_t LFSmart::WriteDacChannel(lfc::Channel channel, uint16_t value, bool rea
 
     uint16_t read_value = 0;
     try {
-        auto cmd = GetDacCommand(channel);
+        auto cmd = GetChannelCommand(lfc::GROUP_DAC, channel);
         WriteRegister16b(cmd, value, m_bUseCRC);
         if (readback)
             read_value = ReadRegister16b(cmd, m_bUseCRC);
@@ -162,7 +110,7 @@ uint16_t LFSmart::WriteDacChannel(lfc::Channel channel, double value, bool readb
     uint16_t raw = DacRealToRaw(value);
     uint16_t read_value = 0;
     try {
-        auto cmd = GetDacCommand(channel);
+        auto cmd = GetChannelCommand(lfc::GROUP_DAC, channel);
         WriteRegister16b(cmd, raw, m_bUseCRC);
         if (readback)
             read_value = ReadRegister16b(cmd, m_bUseCRC);
@@ -184,7 +132,7 @@ uint16_t LFSmart::ReadDacChannel(lfc::Channel channel) {
 
     uint16_t read_value;
     try {
-        read_value = ReadRegister16b(GetDacCommand(channel), m_bUseCRC);
+        read_value = ReadRegister16b(GetChannelCommand(lfc::GROUP_DAC, channel), m_bUseCRC);
     } catch (const FtdiException &e) {
         throw;
     }
@@ -203,17 +151,79 @@ uint16_t LFSmart::ReadAdcChannel(lfc::Channel channel) {
 
     uint16_t read_value;
     try {
-        read_value = ReadRegister16b(GetAdcCommand(channel), m_bUseCRC);
+        read_value = ReadRegister16b(GetChannelCommand(lfc::GROUP_ADC, channel), m_bUseCRC);
     } catch (const FtdiException &e) {
         throw;
     }
     return read_value;
 }
 
+/**
+ * Чтение всех каналов АЦП одной посылкой ADC_ALL. Значения из одного снимка
+ * @param channels uint16_t[4] - сырые данные каналов 1..4
+ */
 void LFSmart::ReadAdcAll(uint16_t *channels) {
-    throw LFSmartException("ReadAdcAll not implemented");
+    ReadGroup(lfc::GROUP_ADC, channels);
 }
 
+
+/**
+ * Чтение группы подряд идущих регистров из register_map.h, например lfc::GROUP_DAC_MAX.
+ * Группа с Block читается одной транзакцией регистра All, остальные - пакетом транзакций одним вызовом
+ * SpiTransport::Transfer. С теневыми копиями читаются только регистры без копии
+ * @param group const lfc::RegisterGroup& - группа
+ * @param values uint16_t* - значения group.Count регистров по порядку
+ */
+void LFSmart::ReadGroup(const lfc::RegisterGroup &group, uint16_t *values) {
+    if (group.Block) {
+        ReadBlock(group.All, values, group.Count);
+        return;
+    }
+
+    std::vector<size_t> missed;
+    for (size_t i = 0; i < group.Count; i++) {
+        uint32_t shadow;
+        if (m_bCache && m_xCache.Lookup(static_cast<lfc::Registers>(group.First + i), shadow))
+            values[i] = shadow;
+        else
+            missed.push_back(i);
+    }
+    if (missed.empty())
+        return;
+
+    const size_t size = m_bUseCRC ? 3 : 2;
+    std::vector<uint8_t> commands(missed.size());
+    std::vector<uint8_t> responses(missed.size() * size);
+    std::vector<SpiTransport::Transaction> transactions(missed.size());
+    for (size_t i = 0; i < missed.size(); i++) {
+        commands[i] = ((group.First + missed[i]) << 1) | lfc::Access::READ;
+        transactions[i] = {&commands[i], 1, &responses[i * size], static_cast<uint16_t>(size)};
+    }
+
+    int tries = m_iTries;
+    while (tries > 0) {
+        m_xSpi.Transfer(transactions.data(), transactions.size());
+        bool valid = true;
+        for (size_t i = 0; i < missed.size() && m_bUseCRC; i++)
+            valid &= crc8(&responses[i * size], 2) == responses[i * size + 2];
+        if (valid)
+            break;
+        tries--;
+        std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    }
+    if (tries == 0) {
+        // Кончились попытки чтения
+        throw LFSmartException("CRC error", true);
+    }
+
+    for (size_t i = 0; i < missed.size(); i++) {
+        values[missed[i]] = (responses[i * size + 1] << 8) | responses[i * size];
+        if (m_bCache)
+            m_xCache.Fill(static_cast<lfc::Registers>(group.First + missed[i]), values[missed[i]]);
+    }
+}
+
+
 /**
  * Перевод сырых данных АЦП в нормальные вольты
  * @param raw uint16_t - сырые данные АЦП
@@ -258,7 +268,7 @@ uint16_t LFSmart::WriteDacDefault(lfc::Channel channel, uint16_t value, bool rea
 
     uint16_t read_value = 0;
     try {
-        auto cmd = GetDacDefaultCommand(channel);
+        auto cmd = GetChannelCommand(lfc::GROUP_DAC_DEFAULT, channel);
         WriteRegister16b(cmd, value, m_bUseCRC);
         if (readback)
             read_value = ReadRegister16b(cmd, m_bUseCRC);
@@ -285,7 +295,7 @@ uint16_t LFSmart::WriteDacDefault(lfc::Channel channel, double value, bool readb
     uint16_t raw = DacRealToRaw(value);
     uint16_t read_value = 0;
     try {
-        auto cmd = GetDacDefaultCommand(channel);
+        auto cmd = GetChannelCommand(lfc::GROUP_DAC_DEFAULT, channel);
         WriteRegister16b(cmd, raw, m_bUseCRC);
         if (readback)
             read_value = ReadRegister16b(cmd, m_bUseCRC);
@@ -307,7 +317,7 @@ uint16_t LFSmart::ReadDacDefault(lfc::Channel channel) {
 
     uint16_t read_value = 0;
     try {
-        auto cmd = GetDacDefaultCommand(channel);
+        auto cmd = GetChannelCommand(lfc::GROUP_DAC_DEFAULT, channel);
         read_value = ReadRegister16b(cmd, m_bUseCRC);
     } catch (const FtdiException &e) {
         throw;
@@ -342,7 +352,7 @@ uint16_t LFSmart::WriteDacChannelMaximum(lfc::Channel channel, uint16_t value, b
 
     uint16_t read_value = 0;
     try {
-        auto cmd = GetDacMaximumCommand(channel);
+        auto cmd = GetChannelCommand(lfc::GROUP_DAC_MAX, channel);
         WriteRegister16b(cmd, value, m_bUseCRC);
         if (readback)
             read_value = ReadRegister16b(cmd, m_bUseCRC);
@@ -364,7 +374,7 @@ uint16_t LFSmart::ReadDacChannelMaximum(lfc::Channel channel) {
 
     uint16_t read_value;
     try {
-        auto cmd = GetDacMaximumCommand(channel);
+        auto cmd = GetChannelCommand(lfc::GROUP_DAC_MAX, channel);
         read_value = ReadRegister16b(cmd, m_bUseCRC);
     } catch (const FtdiException &e) {
         throw;
@@ -469,15 +479,18 @@ uint16_t LFSmart::ReadCert() {
  * @return Значение регистра или 0 при readback false
  */
 uint16_t LFSmart::WriteRaw(uint8_t command, uint16_t value, bool readback) {
-    uint8 tx_buffer[3];
+    uint8_t tx_buffer[3];
     tx_buffer[0] = (command << 1) | lfc::Access::WRITE;
     tx_buffer[1] = value & 0x00FF;
     tx_buffer[2] = (value & 0xFF00) >> 8;
 
+    // Регистр и его влияние на другие регистры неизвестны
+    if (m_bCache)
+        m_xCache.Invalidate();
+
     uint16_t read_value = 0;
     try {
-        m_xSpi.Write(&tx_buffer[0], 1, FALSE);
-        m_xSpi.Write(&tx_buffer[1], 2, TRUE);
+        m_xSpi.Write(tx_buffer, 3, true);
         if (readback) {
             read_value = ReadRaw(command);
         }
@@ -496,10 +509,9 @@ uint16_t LFSmart::WriteRaw(uint8_t command, uint16_t value, bool readback) {
 uint16_t LFSmart::ReadRaw(uint8_t command) {
     uint16_t read_value;
     try {
-        uint8 rx_buffer[2];
-        uint8 ucmd = (command << 1) | lfc::Access::READ;
-        m_xSpi.Write(&ucmd, 1, FALSE);
-        m_xSpi.Read(rx_buffer, 2, TRUE);
+        uint8_t rx_buffer[2];
+        uint8_t ucmd = (command << 1) | lfc::Access::READ;
+        m_xSpi.WriteRead(&ucmd, 1, rx_buffer, 2);
         read_value = (rx_buffer[1] << 8) | rx_buffer[0];
     } catch (const FtdiException &e) {
         throw;
@@ -508,23 +520,64 @@ uint16_t LFSmart::ReadRaw(uint8_t command) {
 }
 
 
-uint16_t LFSmart::ReadRegister16b(lfc::Registers cmd, bool crc) {
+/**
+ * Включение теневых копий регистров, см. LfShadowCache. По-умолчанию выключены.
+ *
+ * С копиями readback в Write* для регистров POLICY_WRITE_THROUGH возвращает копию и не подтверждает запись,
+ * ошибки записи видны только в LastError()
+ * @param enable bool - true включить, false выключить и очистить
+ */
+void LFSmart::EnableCache(bool enable) {
+    if (m_bCache && !enable)
+        m_xCache.Invalidate();
+    m_bCache = enable;
+}
+
+
+/**
+ * Проверка копий: повторное чтение WHOIAM и VERSION из устройства.
+ * При несовпадении (устройство сброшено или заменено) все копии очищаются
+ * @return true - копии соответствуют устройству
+ */
+bool LFSmart::ValidateCache() {
+    if (!m_bCache)
+        return true;
+
+    bool valid = true;
+    const lfc::Registers identity[] = {lfc::Registers::WHOIAM, lfc::Registers::VERSION};
+    uint16_t actual[2];
+    for (int i = 0; i < 2; i++) {
+        uint32_t shadow;
+        bool known = m_xCache.Peek(identity[i], shadow);
+        actual[i] = ReadRegister16b(identity[i], m_bUseCRC, false);
+        if (known && shadow != actual[i])
+            valid = false;
+    }
+
+    if (!valid)
+        m_xCache.Invalidate();
+    for (int i = 0; i < 2; i++)
+        m_xCache.Fill(identity[i], actual[i]);
+    return valid;
+}
+
+
+uint16_t LFSmart::ReadRegister16b(lfc::Registers cmd, bool crc, bool cached) {
     if ((cmd == lfc::Registers::DAC_ALL) || (cmd == lfc::Registers::ADC_ALL))
         throw LFSmartException("Register size not 16 bit");
 
+    uint32_t shadow;
+    if (m_bCache && cached && m_xCache.Lookup(cmd, shadow))
+        return shadow;
+
     int tries = m_iTries;
     uint16_t read_value;
     try {
-        uint8 rx_buffer[3] = {0};
-        uint8 ucmd = (cmd << 1) | lfc::Access::READ;
+        uint8_t rx_buffer[3] = {0};
+        uint8_t ucmd = (cmd << 1) | lfc::Access::READ;
 
         while (tries > 0) {
-            m_xSpi.Write(&ucmd, 1, FALSE);
-            if (!crc) {
-                m_xSpi.Read(rx_buffer, 2, TRUE);
-            } else {
-                m_xSpi.Read(rx_buffer, 3, TRUE);
-            }
+            m_xSpi.WriteRead(&ucmd, 1, rx_buffer, crc ? 3 : 2);
 
             read_value = (rx_buffer[1] << 8) | rx_buffer[0];
             if (crc) {
@@ -545,6 +598,8 @@ uint16_t LFSmart::ReadRegister16b(lfc::Registers cmd, bool crc) {
     } catch (const FtdiException &e) {
         throw;
     }
+    if (m_bCache)
+        m_xCache.Fill(cmd, read_value);
     return read_value;
 }
 
@@ -553,7 +608,7 @@ void LFSmart::WriteRegister16b(lfc::Registers cmd, uint16_t value, bool crc) {
     if ((cmd == lfc::Registers::DAC_ALL) || (cmd == lfc::Registers::ADC_ALL))
         throw LFSmartException("Register size not 16 bit");
 
-    uint8 tx_buffer[4];
+    uint8_t tx_buffer[4];
     tx_buffer[0] = (cmd << 1) | lfc::Access::WRITE;
     tx_buffer[1] = value & 0x00FF;
     tx_buffer[2] = (value & 0xFF00) >> 8;
@@ -562,15 +617,15 @@ void LFSmart::WriteRegister16b(lfc::Registers cmd, uint16_t value, bool crc) {
         tx_buffer[3] = crc8(tx_buffer, 3);
     }
     try {
-        m_xSpi.Write(&tx_buffer[0], 1, FALSE);
-        if (!crc) {
-            m_xSpi.Write(&tx_buffer[1], 2, TRUE);
-        } else {
-            m_xSpi.Write(&tx_buffer[1], 3, TRUE);
-        }
+        m_xSpi.Write(tx_buffer, crc ? 4 : 3, true);
     } catch (const FtdiException &e) {
+        // Неизвестно, дошла ли запись до устройства
+        if (m_bCache)
+            m_xCache.Invalidate();
         throw;
     }
+    if (m_bCache)
+        m_xCache.Written(cmd, value);
 }
 
 
@@ -578,19 +633,18 @@ uint32_t LFSmart::ReadRegister32b(lfc::Registers cmd, bool crc) {
     if (!((cmd == lfc::Registers::CRC_SW) || (cmd == lfc::Registers::CRC_HW)))
         throw LFSmartException("Register size not 16 bit");
 
+    uint32_t shadow;
+    if (m_bCache && m_xCache.Lookup(cmd, shadow))
+        return shadow;
+
     int tries = m_iTries;
     uint32_t read_value;
     try {
-        uint8 rx_buffer[5] = {0};
-        uint8 ucmd = (cmd << 1) | lfc::Access::READ;
+        uint8_t rx_buffer[5] = {0};
+        uint8_t ucmd = (cmd << 1) | lfc::Access::READ;
 
         while (tries > 0) {
-            m_xSpi.Write(&ucmd, 1, FALSE);
-            if (!crc) {
-                m_xSpi.Read(rx_buffer, 4, TRUE);
-            } else {
-                m_xSpi.Read(rx_buffer, 5, TRUE);
-            }
+            m_xSpi.WriteRead(&ucmd, 1, rx_buffer, crc ? 5 : 4);
 
             read_value = (rx_buffer[3] << 24) | (rx_buffer[2] << 16) | (rx_buffer[1] << 8) | rx_buffer[0];
             if (crc) {
@@ -611,62 +665,40 @@ uint32_t LFSmart::ReadRegister32b(lfc::Registers cmd, bool crc) {
     } catch (const FtdiException &e) {
         throw;
     }
+    if (m_bCache)
+        m_xCache.Fill(cmd, read_value);
     return read_value;
 }
 
 
-uint16_t LFSmart::MakeVersion(uint8_t major, uint8_t minor, uint8_t patch) {
-    return major*10000 + minor*100 + patch;
-}
-
 
 /*
-  Name  : CRC-8-ITU
-  Poly  : 0x07
-  Init  : 0x00
-  Revert: false
-  XorOut: 0x55
-  Check : 0xA1 ("123456789")
-*/
-const uint8_t Crc8Table[256] = {
-        0x00, 0x07, 0x0E, 0x09, 0x1C, 0x1B, 0x12, 0x15,
-        0x38, 0x3F, 0x36, 0x31, 0x24, 0x23, 0x2A, 0x2D,
-        0x70, 0x77, 0x7E, 0x79, 0x6C, 0x6B, 0x62, 0x65,
-        0x48, 0x4F, 0x46, 0x41, 0x54, 0x53, 0x5A, 0x5D,
-        0xE0, 0xE7, 0xEE, 0xE9, 0xFC, 0xFB, 0xF2, 0xF5,
-        0xD8, 0xDF, 0xD6, 0xD1, 0xC4, 0xC3, 0xCA, 0xCD,
-        0x90, 0x97, 0x9E, 0x99, 0x8C, 0x8B, 0x82, 0x85,
-        0xA8, 0xAF, 0xA6, 0xA1, 0xB4, 0xB3, 0xBA, 0xBD,
-        0xC7, 0xC0, 0xC9, 0xCE, 0xDB, 0xDC, 0xD5, 0xD2,
-        0xFF, 0xF8, 0xF1, 0xF6, 0xE3, 0xE4, 0xED, 0xEA,
-        0xB7, 0xB0, 0xB9, 0xBE, 0xAB, 0xAC, 0xA5, 0xA2,
-        0x8F, 0x88, 0x81, 0x86, 0x93, 0x94, 0x9D, 0x9A,
-        0x27, 0x20, 0x29, 0x2E, 0x3B, 0x3C, 0x35, 0x32,
-        0x1F, 0x18, 0x11, 0x16, 0x03, 0x04, 0x0D, 0x0A,
-        0x57, 0x50, 0x59, 0x5E, 0x4B, 0x4C, 0x45, 0x42,
-        0x6F, 0x68, 0x61, 0x66, 0x73, 0x74, 0x7D, 0x7A,
-        0x89, 0x8E, 0x87, 0x80, 0x95, 0x92, 0x9B, 0x9C,
-        0xB1, 0xB6, 0xBF, 0xB8, 0xAD, 0xAA, 0xA3, 0xA4,
-        0xF9, 0xFE, 0xF7, 0xF0, 0xE5, 0xE2, 0xEB, 0xEC,
-        0xC1, 0xC6, 0xCF, 0xC8, 0xDD, 0xDA, 0xD3, 0xD4,
-        0x69, 0x6E, 0x67, 0x60, 0x75, 0x72, 0x7B, 0x7C,
-        0x51, 0x56, 0x5F, 0x58, 0x4D, 0x4A, 0x43, 0x44,
-        0x19, 0x1E, 0x17, 0x10, 0x05, 0x02, 0x0B, 0x0C,
-        0x21, 0x26, 0x2F, 0x28, 0x3D, 0x3A, 0x33, 0x34,
-        0x4E, 0x49, 0x40, 0x47, 0x52, 0x55, 0x5C, 0x5B,
-        0x76, 0x71, 0x78, 0x7F, 0x6A, 0x6D, 0x64, 0x63,
-        0x3E, 0x39, 0x30, 0x37, 0x22, 0x25, 0x2C, 0x2B,
-        0x06, 0x01, 0x08, 0x0F, 0x1A, 0x1D, 0x14, 0x13,
-        0xAE, 0xA9, 0xA0, 0xA7, 0xB2, 0xB5, 0xBC, 0xBB,
-        0x96, 0x91, 0x98, 0x9F, 0x8A, 0x8D, 0x84, 0x83,
-        0xDE, 0xD9, 0xD0, 0xD7, 0xC2, 0xC5, 0xCC, 0xCB,
-        0xE6, 0xE1, 0xE8, 0xEF, 0xFA, 0xFD, 0xF4, 0xF3,
-};
-
-static uint8_t crc8(uint8_t *pcBlock, size_t len) {
-    uint8_t crc = 0x00;
-    while (len--) {
-        crc = Crc8Table[crc ^ *pcBlock++];
-    }
-    return crc ^ 0x55;
+ * Регистр из count 16-битных значений одной транзакцией, например ADC_ALL
+ */
+void LFSmart::ReadBlock(lfc::Registers cmd, uint16_t *values, size_t count) {
+    if (lfc::GetRegisterInfo(cmd).Size != 2 * count)
+        throw LFSmartException("Register size mismatch");
+
+    int tries = m_iTries;
+    uint8_t rx_buffer[lfc::REGISTER_SIZE_MAX + 1] = {0};
+    uint8_t ucmd = (cmd << 1) | lfc::Access::READ;
+    const size_t size = 2 * count;
+    while (tries > 0) {
+        m_xSpi.WriteRead(&ucmd, 1, rx_buffer, m_bUseCRC ? size + 1 : size);
+        if (!m_bUseCRC || crc8(rx_buffer, size) == rx_buffer[size])
+            break;
+        tries--;
+        std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    }
+    if (tries == 0) {
+        // Кончились попытки чтения
+        throw LFSmartException("CRC error", true);
+    }
+
+    for (size_t i = 0; i < count; i++)
+        values[i] = (rx_buffer[2 * i + 1] << 8) | rx_buffer[2 * i];
+}
+
+uint16_t LFSmart::MakeVersion(uint8_t major, uint8_t minor, uint8_t patch) {
+    return major*10000 + minor*100 + patch;
 }
@@ -0,0 +1,237 @@
+#include <memory>
+#include "LFSmart.h"
+#include "LFSmartAsync.h"
+#include "crc8.h"
+
+
+static bool Is16bit(lfc::Registers reg) {
+    return reg <= lfc::Registers::CERT && reg != lfc::Registers::DAC_ALL && reg != lfc::Registers::ADC_ALL &&
+           reg != lfc::Registers::CRC_HW && reg != lfc::Registers::CRC_SW;
+}
+
+
+/**
+ * @param spi SpiTransport& - транспорт до устройства, используется только потоком очереди
+ * @param crc bool - true для кадров с CRC8
+ * @param tries int - количество попыток чтения при ошибке CRC
+ * @param maxBatch size_t - максимальное количество операций в одном вызове SpiTransport::Transfer
+ */
+LFSmartAsync::LFSmartAsync(SpiTransport &spi, bool crc, int tries, size_t maxBatch) :
+        m_xSpi(spi), m_bUseCRC(crc), m_iTries(tries > 0 ? tries : 1), m_uMaxBatch(maxBatch > 0 ? maxBatch : 1) {
+    m_xThread = std::thread(&LFSmartAsync::Execute, this);
+}
+
+
+/**
+ * Выполняет все поставленные операции и останавливает поток очереди
+ */
+LFSmartAsync::~LFSmartAsync() {
+    {
+        std::lock_guard<std::mutex> lock(m_xMutex);
+        m_bStop = true;
+    }
+    m_xWork.notify_one();
+    m_xThread.join();
+}
+
+
+/**
+ * Чтение регистра
+ * @param reg lfc::Registers - 16-битный регистр
+ * @return Значение регистра или исключение LFSmartException, FtdiException
+ */
+std::future<uint16_t> LFSmartAsync::Read(lfc::Registers reg) {
+    auto promise = std::make_shared<std::promise<uint16_t>>();
+    auto future = promise->get_future();
+    Read(reg, [promise](uint16_t value, std::exception_ptr error) {
+        if (error)
+            promise->set_exception(error);
+        else
+            promise->set_value(value);
+    });
+    return future;
+}
+
+
+/**
+ * Запись регистра
+ * @param reg lfc::Registers - 16-битный регистр
+ * @param value uint16_t - записываемое значение
+ * @return Готовность после передачи кадра. Результат выполнения на устройстве - в регистре LAST_ERROR
+ */
+std::future<void> LFSmartAsync::Write(lfc::Registers reg, uint16_t value) {
+    auto promise = std::make_shared<std::promise<void>>();
+    auto future = promise->get_future();
+    Write(reg, value, [promise](std::exception_ptr error) {
+        if (error)
+            promise->set_exception(error);
+        else
+            promise->set_value();
+    });
+    return future;
+}
+
+
+void LFSmartAsync::Read(lfc::Registers reg, ReadCallback callback) {
+    if (!Is16bit(reg))
+        throw LFSmartException("Register size not 16 bit");
+
+    Operation operation {};
+    operation.Access = lfc::Access::READ;
+    operation.Register = reg;
+    operation.OnRead = std::move(callback);
+    operation.Frame[0] = (reg << 1) | lfc::Access::READ;
+    Enqueue(std::move(operation));
+}
+
+
+void LFSmartAsync::Write(lfc::Registers reg, uint16_t value, WriteCallback callback) {
+    if (!Is16bit(reg))
+        throw LFSmartException("Register size not 16 bit");
+
+    Operation operation {};
+    operation.Access = lfc::Access::WRITE;
+    operation.Register = reg;
+    operation.Value = value;
+    operation.OnWrite = std::move(callback);
+    operation.Frame[0] = (reg << 1) | lfc::Access::WRITE;
+    operation.Frame[1] = value & 0x00FF;
+    operation.Frame[2] = (value & 0xFF00) >> 8;
+    operation.Frame[3] = crc8(operation.Frame, 3);
+    Enqueue(std::move(operation));
+}
+
+
+/**
+ * Ожидание выполнения всех поставленных операций
+ * @throw Первое исключение обработчика с прошлого вызова Flush()
+ */
+void LFSmartAsync::Flush() {
+    std::unique_lock<std::mutex> lock(m_xMutex);
+    m_xIdle.wait(lock, [this] { return m_dQueue.empty() && m_uInFlight == 0; });
+    if (m_xCallbackError) {
+        std::exception_ptr error = m_xCallbackError;
+        m_xCallbackError = nullptr;
+        std::rethrow_exception(error);
+    }
+}
+
+
+LFSmartAsync::Stats LFSmartAsync::GetStats() const {
+    return {m_uOperations.load(), m_uBatches.load(), m_uRetries.load()};
+}
+
+
+void LFSmartAsync::Enqueue(Operation &&operation) {
+    operation.Tries = m_iTries;
+    {
+        std::lock_guard<std::mutex> lock(m_xMutex);
+        m_dQueue.push_back(std::move(operation));
+    }
+    m_xWork.notify_one();
+}
+
+
+void LFSmartAsync::Execute() {
+    std::unique_lock<std::mutex> lock(m_xMutex);
+    for (;;) {
+        m_xWork.wait(lock, [this] { return m_bStop || !m_dQueue.empty(); });
+        if (m_dQueue.empty())
+            break;
+
+        // Записи, затем чтения: запись после чтения начинает следующий пакет
+        std::vector<Operation> batch;
+        bool reading = false;
+        while (!m_dQueue.empty() && batch.size() < m_uMaxBatch) {
+            bool read = m_dQueue.front().Access == lfc::Access::READ;
+            if (reading && !read)
+                break;
+            reading |= read;
+            batch.push_back(std::move(m_dQueue.front()));
+            m_dQueue.pop_front();
+        }
+        m_uInFlight = batch.size();
+
+        lock.unlock();
+        Process(batch);
+        lock.lock();
+
+        m_uInFlight = 0;
+        if (m_dQueue.empty())
+            m_xIdle.notify_all();
+    }
+    m_xIdle.notify_all();
+}
+
+
+/*
+ * Передача пакета и повтор чтений с ошибкой CRC. Записи пакета уже выполнены до чтений,
+ * поэтому повтор передаёт только чтения.
+ */
+void LFSmartAsync::Process(std::vector<Operation> &batch) {
+    std::vector<Operation *> pending;
+    for (auto &operation : batch)
+        pending.push_back(&operation);
+
+    std::vector<SpiTransport::Transaction> transactions;
+    while (!pending.empty()) {
+        transactions.clear();
+        for (auto operation : pending) {
+            if (operation->Access == lfc::Access::READ)
+                transactions.push_back({operation->Frame, 1, operation->Response, (uint16_t)(m_bUseCRC ? 3 : 2)});
+            else
+                transactions.push_back({operation->Frame, (uint16_t)(m_bUseCRC ? 4 : 3), nullptr, 0});
+        }
+
+        try {
+            m_xSpi.Transfer(transactions.data(), transactions.size());
+            m_uBatches++;
+        } catch (...) {
+            auto error = std::current_exception();
+            for (auto operation : pending)
+                Complete(*operation, 0, error);
+            m_uOperations += pending.size();
+            return;
+        }
+
+        std::vector<Operation *> retry;
+        for (auto operation : pending) {
+            if (operation->Access == lfc::Access::WRITE) {
+                Complete(*operation, 0, nullptr);
+                m_uOperations++;
+                continue;
+            }
+
+            uint16_t value = (operation->Response[1] << 8) | operation->Response[0];
+            if (!m_bUseCRC || crc8(operation->Response, 2) == operation->Response[2]) {
+                Complete(*operation, value, nullptr);
+                m_uOperations++;
+            } else if (--operation->Tries > 0) {
+                retry.push_back(operation);
+                m_uRetries++;
+            } else {
+                // Кончились попытки чтения
+                Complete(*operation, 0, std::make_exception_ptr(LFSmartException("CRC error", true)));
+                m_uOperations++;
+            }
+        }
+        pending.swap(retry);
+    }
+}
+
+
+/*
+ * Вызов обработчика операции. Исключение обработчика сохраняется для Flush(), поток очереди продолжает работу
+ */
+void LFSmartAsync::Complete(Operation &operation, uint16_t value, std::exception_ptr error) {
+    try {
+        if (operation.Access == lfc::Access::READ)
+            operation.OnRead(value, error);
+        else
+            operation.OnWrite(error);
+    } catch (...) {
+        std::lock_guard<std::mutex> lock(m_xMutex);
+        if (!m_xCallbackError)
+            m_xCallbackError = std::current_exception();
+    }
+}
@@ -0,0 +1,196 @@
+#include <algorithm>
+#include <cerrno>
+#include <cstdlib>
+#include <cstring>
+#include <mutex>
+#include <set>
+#include <system_error>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+#include "FtdiException.h"
+#include "LFSmart.h"
+#include "LfClient.h"
+
+using nlohmann::json;
+
+
+/*
+ * Исключения хранят указатель на сообщение, сообщения сервера живут до конца программы
+ */
+static const char *Intern(const std::string &message) {
+    static std::mutex mutex;
+    static std::set<std::string> messages;
+    std::lock_guard<std::mutex> lock(mutex);
+    return messages.insert(message).first->c_str();
+}
+
+
+/**
+ * Подключение к lfsd
+ * @param socketPath const std::string& - путь сокета
+ * @throw std::system_error, если сервер не запущен
+ */
+LfClient::LfClient(const std::string &socketPath) {
+    sockaddr_un address {};
+    if (socketPath.size() >= sizeof(address.sun_path))
+        throw std::system_error(ENAMETOOLONG, std::generic_category(), "socket path");
+    address.sun_family = AF_UNIX;
+    strncpy(address.sun_path, socketPath.c_str(), sizeof(address.sun_path) - 1);
+
+    m_iSocket = socket(AF_UNIX, SOCK_STREAM, 0);
+    if (m_iSocket < 0)
+        throw std::system_error(errno, std::generic_category(), "socket");
+    if (connect(m_iSocket, reinterpret_cast<sockaddr *>(&address), sizeof(address)) != 0) {
+        int error = errno;
+        close(m_iSocket);
+        throw std::system_error(error, std::generic_category(), "connect " + socketPath);
+    }
+}
+
+
+LfClient::~LfClient() {
+    close(m_iSocket);
+}
+
+
+/**
+ * Запрос и ожидание ответа
+ * @param request const nlohmann::json& - запрос, см. LfServer
+ * @return Ответ с "ok": true
+ * @throw FtdiException при ошибке адаптера или связи с lfsd, LFSmartException при ошибке НЧ драйвера
+ */
+json LfClient::Call(const json &request) {
+    std::string out = request.dump() + "\n";
+    for (size_t sent = 0; sent < out.size();) {
+        ssize_t n = send(m_iSocket, out.data() + sent, out.size() - sent, MSG_NOSIGNAL);
+        if (n <= 0)
+            throw FtdiException("lfsd connection lost");
+        sent += n;
+    }
+
+    size_t end;
+    while ((end = m_sPending.find('\n')) == std::string::npos) {
+        char buffer[4096];
+        ssize_t n = read(m_iSocket, buffer, sizeof(buffer));
+        if (n <= 0)
+            throw FtdiException("lfsd connection lost");
+        m_sPending.append(buffer, n);
+    }
+    json reply = json::parse(m_sPending.begin(), m_sPending.begin() + end);
+    m_sPending.erase(0, end + 1);
+
+    if (reply.value("ok", false))
+        return reply;
+
+    const char *message = Intern(reply.value("error", std::string("lfsd error")));
+    if (reply.value("kind", std::string()) == "lfsmart")
+        throw LFSmartException(message, reply.value("crc", false));
+    throw FtdiException(message);
+}
+
+
+/**
+ * Сокет по-умолчанию: переменная окружения LFSD_SOCKET, иначе lfsd.sock в каталоге пользователя XDG_RUNTIME_DIR,
+ * иначе /tmp/lfsd.sock
+ */
+std::string LfClient::DefaultSocket() {
+    const char *path = getenv("LFSD_SOCKET");
+    if (path)
+        return path;
+    const char *runtime = getenv("XDG_RUNTIME_DIR");
+    if (runtime && runtime[0] != '\0')
+        return std::string(runtime) + "/lfsd.sock";
+    return "/tmp/lfsd.sock";
+}
+
+
+SocketSpi::SocketSpi(const std::string &socketPath, int device) : m_xClient(socketPath), m_iDevice(device) {
+}
+
+
+bool SocketSpi::Write(uint8_t *buffer, uint16_t bufferSize, bool isEndTransaction) {
+    m_vTx.insert(m_vTx.end(), buffer, buffer + bufferSize);
+    if (isEndTransaction) {
+        std::vector<uint8_t> tx;
+        tx.swap(m_vTx);
+        return WriteRead(tx.data(), tx.size(), nullptr, 0);
+    }
+    return true;
+}
+
+
+/*
+ * Приём возможен только в конце транзакции: сервер выполняет транзакцию целиком
+ */
+bool SocketSpi::Read(uint8_t *buffer, uint16_t bufferSize, bool isEndTransaction) {
+    if (!isEndTransaction)
+        throw FtdiException("lfsd: read inside transaction not supported");
+    std::vector<uint8_t> tx;
+    tx.swap(m_vTx);
+    return WriteRead(tx.data(), tx.size(), buffer, bufferSize);
+}
+
+
+bool SocketSpi::WriteRead(const uint8_t *command, uint16_t commandSize, uint8_t *response, uint16_t responseSize) {
+    json reply = m_xClient.Call({{"op", "spi"}, {"dev", m_iDevice},
+                                 {"tx", std::vector<uint8_t>(command, command + commandSize)}, {"rx", responseSize}});
+    auto rx = reply.at("rx").get<std::vector<uint8_t>>();
+    std::copy(rx.begin(), rx.begin() + std::min<size_t>(rx.size(), responseSize), response);
+    return rx.size() == responseSize;
+}
+
+
+bool SocketSpi::Transfer(const Transaction *transactions, size_t count) {
+    json list = json::array();
+    for (size_t i = 0; i < count; i++) {
+        list.push_back({{"tx", std::vector<uint8_t>(transactions[i].Tx, transactions[i].Tx + transactions[i].TxSize)},
+                        {"rx", transactions[i].RxSize}});
+    }
+    json reply = m_xClient.Call({{"op", "spi_batch"}, {"dev", m_iDevice}, {"transactions", list}});
+
+    const json &rx = reply.at("rx");
+    bool complete = rx.size() == count;
+    for (size_t i = 0; i < count && i < rx.size(); i++) {
+        auto bytes = rx[i].get<std::vector<uint8_t>>();
+        complete &= bytes.size() == transactions[i].RxSize;
+        std::copy(bytes.begin(), bytes.begin() + std::min<size_t>(bytes.size(), transactions[i].RxSize),
+                  transactions[i].Rx);
+    }
+    return complete;
+}
+
+
+SocketI2c::SocketI2c(const std::string &socketPath, int device) : m_xClient(socketPath), m_iDevice(device) {
+}
+
+
+int SocketI2c::WriteEx(uint16_t slaveAddress, I2CFlag flag, uint8_t *buffer, uint16_t bufferSize, uint16_t &sizeTransferred) {
+    json reply = m_xClient.Call({{"op", "i2c_write"}, {"dev", m_iDevice}, {"addr", slaveAddress}, {"flag", (int)flag},
+                                 {"data", std::vector<uint8_t>(buffer, buffer + bufferSize)}});
+    sizeTransferred = reply.at("transferred").get<uint16_t>();
+    return reply.at("status").get<int>();
+}
+
+
+int SocketI2c::ReadEx(uint16_t slaveAddress, I2CFlag flag, uint8_t *buffer, uint16_t bufferSize, uint16_t &sizeTransferred) {
+    json reply = m_xClient.Call({{"op", "i2c_read"}, {"dev", m_iDevice}, {"addr", slaveAddress}, {"flag", (int)flag},
+                                 {"size", bufferSize}});
+    auto data = reply.at("data").get<std::vector<uint8_t>>();
+    sizeTransferred = std::min<size_t>(data.size(), bufferSize);
+    std::copy(data.begin(), data.begin() + sizeTransferred, buffer);
+    return reply.at("status").get<int>();
+}
+
+
+int SocketI2c::GetStatus(uint8_t &status) {
+    json reply = m_xClient.Call({{"op", "i2c_status"}, {"dev", m_iDevice}});
+    status = reply.at("value").get<uint8_t>();
+    return reply.at("status").get<int>();
+}
+
+
+int SocketI2c::ResetBus() {
+    json reply = m_xClient.Call({{"op", "i2c_reset"}, {"dev", m_iDevice}});
+    return reply.at("status").get<int>();
+}
@@ -0,0 +1,156 @@
+#include <algorithm>
+#include <exception>
+#include "FtdiException.h"
+#include "LfFleet.h"
+
+
+/**
+ * @param opener Opener - открытие адаптера по номеру, вызывается одновременно из разных потоков
+ * @param crc bool - CRC в обмене с НЧ драйвером
+ * @param tries int - попытки чтения регистра при ошибке CRC
+ * @param threads size_t - потоков в пуле, 0 - по числу ядер. Обмен по USB в основном ожидание, поэтому
+ * для большой стойки выгодно число потоков, равное числу плат
+ */
+LfFleet::LfFleet(Opener opener, bool crc, int tries, size_t threads) :
+        m_xOpener(std::move(opener)), m_bUseCRC(crc), m_iTries(tries) {
+    if (threads == 0)
+        threads = std::max(1u, std::thread::hardware_concurrency());
+    for (size_t i = 0; i < threads; i++)
+        m_vWorkers.emplace_back(&LfFleet::Worker, this);
+}
+
+
+LfFleet::~LfFleet() {
+    {
+        std::lock_guard<std::mutex> lock(m_xMutex);
+        m_bStop = true;
+    }
+    m_xWork.notify_all();
+    for (auto &worker : m_vWorkers)
+        worker.join();
+}
+
+
+/**
+ * Открытие адаптеров. Ранее открытые закрываются
+ * @param devices const std::vector<int>& - номера адаптеров
+ * @return Результат открытия каждого адаптера
+ */
+LfFleet::Report LfFleet::Open(const std::vector<int> &devices) {
+    m_vBoards.clear();
+
+    std::vector<std::unique_ptr<Board>> opened(devices.size());
+    std::vector<Job> jobs;
+    for (size_t i = 0; i < devices.size(); i++) {
+        jobs.push_back([this, &opened, &devices, i](BoardResult &) {
+            std::unique_ptr<Board> board(new Board {devices[i], m_xOpener(devices[i]), nullptr});
+            board->Lf.reset(new LFSmart(*board->Spi, m_bUseCRC, m_iTries));
+            opened[i] = std::move(board);
+        });
+    }
+    Report report = Execute(devices, jobs);
+
+    for (auto &board : opened) {
+        if (board)
+            m_vBoards.push_back(std::move(board));
+    }
+    return report;
+}
+
+
+/**
+ * Открытие адаптеров 0..count-1
+ */
+LfFleet::Report LfFleet::Open(int count) {
+    std::vector<int> devices;
+    for (int device = 0; device < count; device++)
+        devices.push_back(device);
+    return Open(devices);
+}
+
+
+/**
+ * Выполнение сценария на всех открытых платах
+ * @param script const Script& - сценарий, получает номер адаптера и LFSmart платы
+ * @return Результат и время выполнения на каждой плате
+ */
+LfFleet::Report LfFleet::Run(const Script &script) {
+    std::vector<int> devices;
+    std::vector<Job> jobs;
+    for (auto &board : m_vBoards) {
+        Board *current = board.get();
+        devices.push_back(current->Device);
+        jobs.push_back([&script, current](BoardResult &) { script(current->Device, *current->Lf); });
+    }
+    return Execute(devices, jobs);
+}
+
+
+/*
+ * Ставит задачи в пул и ждёт завершения всех. Исключение задачи - ошибка только этой платы
+ */
+LfFleet::Report LfFleet::Execute(const std::vector<int> &devices, const std::vector<Job> &jobs) {
+    Report report {std::vector<BoardResult>(jobs.size()), 0, 0, std::chrono::microseconds(0)};
+    auto start = std::chrono::steady_clock::now();
+
+    {
+        std::lock_guard<std::mutex> lock(m_xMutex);
+        for (size_t i = 0; i < jobs.size(); i++) {
+            BoardResult &result = report.Boards[i];
+            result = {devices[i], true, false, std::string(), std::chrono::microseconds(0)};
+            const Job &job = jobs[i];
+
+            m_qJobs.emplace_back([&result, &job]() {
+                auto begin = std::chrono::steady_clock::now();
+                try {
+                    job(result);
+                } catch (const LFSmartException &e) {
+                    result.Ok = false;
+                    result.CrcError = e.CrcError();
+                    result.Error = e.what();
+                } catch (const FtdiException &e) {
+                    result.Ok = false;
+                    result.Error = e.what();
+                } catch (const std::exception &e) {
+                    result.Ok = false;
+                    result.Error = e.what();
+                }
+                result.Time = std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - begin);
+            });
+            m_uPending++;
+        }
+    }
+    m_xWork.notify_all();
+
+    std::unique_lock<std::mutex> lock(m_xMutex);
+    m_xDone.wait(lock, [this] { return m_uPending == 0; });
+    lock.unlock();
+
+    report.Elapsed = std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - start);
+    for (const auto &result : report.Boards) {
+        if (result.Ok)
+            report.Succeeded++;
+        else
+            report.Failed++;
+    }
+    return report;
+}
+
+
+void LfFleet::Worker() {
+    std::unique_lock<std::mutex> lock(m_xMutex);
+    for (;;) {
+        m_xWork.wait(lock, [this] { return m_bStop || !m_qJobs.empty(); });
+        if (m_bStop)
+            return;
+
+        auto job = std::move(m_qJobs.front());
+        m_qJobs.pop_front();
+        lock.unlock();
+        job();
+        lock.lock();
+
+        if (--m_uPending == 0)
+            m_xDone.notify_all();
+    }
+}
@@ -0,0 +1,271 @@
+#include <cerrno>
+#include <cstring>
+#include <system_error>
+#include <vector>
+#include <fcntl.h>
+#include <poll.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/un.h>
+#include <unistd.h>
+#include "FtdiException.h"
+#include "LFSmart.h"
+#include "LfServer.h"
+
+using nlohmann::json;
+
+static const size_t MaxRequestSize = 64 * 1024;
+
+const int LfServer::ProtocolVersion;
+
+
+static json Error(const char *kind, const char *message, bool crc = false) {
+    return {{"ok", false}, {"kind", kind}, {"error", message}, {"crc", crc}};
+}
+
+
+/*
+ * Удаляет сокет, оставшийся от прошлого запуска. Файл другого типа и сокет работающего сервера не трогает
+ */
+static void RemoveStaleSocket(const sockaddr_un &address) {
+    struct stat status {};
+    if (lstat(address.sun_path, &status) != 0) {
+        if (errno == ENOENT)
+            return;
+        throw std::system_error(errno, std::generic_category(), std::string("stat ") + address.sun_path);
+    }
+    if (!S_ISSOCK(status.st_mode))
+        throw std::system_error(EEXIST, std::generic_category(), std::string("not a socket ") + address.sun_path);
+
+    int probe = socket(AF_UNIX, SOCK_STREAM, 0);
+    if (probe < 0)
+        throw std::system_error(errno, std::generic_category(), "socket");
+    bool alive = connect(probe, reinterpret_cast<const sockaddr *>(&address), sizeof(address)) == 0;
+    close(probe);
+    if (alive)
+        throw std::system_error(EADDRINUSE, std::generic_category(), std::string("lfsd on ") + address.sun_path);
+    unlink(address.sun_path);
+}
+
+
+/**
+ * Создаёт сокет и начинает слушать. Оставшийся от прошлого запуска файл сокета удаляется, если сервер на нём не
+ * отвечает. Сокет доступен только владельцу, права 0600
+ * @param devices LfDeviceProvider& - адаптеры или модели
+ * @param socketPath const std::string& - путь сокета
+ */
+LfServer::LfServer(LfDeviceProvider &devices, const std::string &socketPath) :
+        m_xDevices(devices), m_sSocketPath(socketPath) {
+    sockaddr_un address {};
+    if (socketPath.size() >= sizeof(address.sun_path))
+        throw std::system_error(ENAMETOOLONG, std::generic_category(), "socket path");
+    address.sun_family = AF_UNIX;
+    strncpy(address.sun_path, socketPath.c_str(), sizeof(address.sun_path) - 1);
+
+    RemoveStaleSocket(address);
+    if (pipe(m_aWakeup) != 0)
+        throw std::system_error(errno, std::generic_category(), "pipe");
+
+    m_iListen = socket(AF_UNIX, SOCK_STREAM, 0);
+    if (m_iListen < 0) {
+        int error = errno;
+        close(m_aWakeup[0]);
+        close(m_aWakeup[1]);
+        throw std::system_error(error, std::generic_category(), "socket");
+    }
+
+    // До listen() подключиться нельзя, права выставляются раньше, чем сокет начинает принимать клиентов
+    if (bind(m_iListen, reinterpret_cast<sockaddr *>(&address), sizeof(address)) != 0 ||
+        chmod(socketPath.c_str(), S_IRUSR | S_IWUSR) != 0 || listen(m_iListen, 8) != 0) {
+        int error = errno;
+        close(m_iListen);
+        close(m_aWakeup[0]);
+        close(m_aWakeup[1]);
+        throw std::system_error(error, std::generic_category(), "bind " + socketPath);
+    }
+}
+
+
+LfServer::~LfServer() {
+    for (auto &client : m_mClients)
+        close(client.first);
+    close(m_iListen);
+    close(m_aWakeup[0]);
+    close(m_aWakeup[1]);
+    unlink(m_sSocketPath.c_str());
+}
+
+
+/**
+ * Цикл обслуживания клиентов до вызова Stop()
+ */
+void LfServer::Run() {
+    for (;;) {
+        std::vector<pollfd> fds;
+        fds.push_back({m_aWakeup[0], POLLIN, 0});
+        fds.push_back({m_iListen, POLLIN, 0});
+        for (auto &client : m_mClients)
+            fds.push_back({client.first, POLLIN, 0});
+
+        if (poll(fds.data(), fds.size(), -1) < 0) {
+            if (errno == EINTR)
+                continue;
+            throw std::system_error(errno, std::generic_category(), "poll");
+        }
+
+        if (fds[0].revents)
+            return;
+        if (fds[1].revents & POLLIN)
+            Accept();
+        for (size_t i = 2; i < fds.size(); i++) {
+            if (fds[i].revents && !Serve(fds[i].fd)) {
+                close(fds[i].fd);
+                m_mClients.erase(fds[i].fd);
+            }
+        }
+    }
+}
+
+
+/**
+ * Остановка Run(). Можно вызывать из другого потока и из обработчика сигнала
+ */
+void LfServer::Stop() {
+    char byte = 0;
+    (void)!write(m_aWakeup[1], &byte, 1);
+}
+
+
+void LfServer::Accept() {
+    int client = accept(m_iListen, nullptr, nullptr);
+    if (client >= 0)
+        m_mClients[client] = std::string();
+}
+
+
+/*
+ * Чтение из сокета клиента и выполнение всех полных строк. false - клиент отключился или нарушил протокол
+ */
+bool LfServer::Serve(int client) {
+    char buffer[4096];
+    ssize_t size = read(client, buffer, sizeof(buffer));
+    if (size <= 0)
+        return false;
+
+    std::string &pending = m_mClients[client];
+    pending.append(buffer, size);
+    if (pending.size() > MaxRequestSize)
+        return false;
+
+    size_t end;
+    while ((end = pending.find('\n')) != std::string::npos) {
+        json reply;
+        try {
+            reply = Handle(json::parse(pending.begin(), pending.begin() + end));
+        } catch (const json::exception &e) {
+            reply = Error("request", "Malformed request");
+        }
+        pending.erase(0, end + 1);
+
+        std::string out = reply.dump() + "\n";
+        for (size_t sent = 0; sent < out.size();) {
+            ssize_t n = send(client, out.data() + sent, out.size() - sent, MSG_NOSIGNAL);
+            if (n <= 0)
+                return false;
+            sent += n;
+        }
+    }
+    return true;
+}
+
+
+/*
+ * Массив JSON в байты. false, если значение вне 0..255: get<uint8_t>() молча обрезал бы его.
+ * Не число - json::type_error, ответ "Malformed request"
+ */
+static bool Bytes(const json &array, std::vector<uint8_t> &bytes) {
+    bytes.clear();
+    for (const auto &value : array) {
+        int64_t byte = value.get<int64_t>();
+        if (byte < 0 || byte > 0xFF)
+            return false;
+        bytes.push_back(static_cast<uint8_t>(byte));
+    }
+    return true;
+}
+
+
+/**
+ * Выполнение одного запроса
+ * @param request const nlohmann::json& - запрос
+ * @return Ответ, ошибки устройства и запроса передаются в ответе
+ */
+json LfServer::Handle(const json &request) {
+    try {
+        const std::string op = request.at("op").get<std::string>();
+        int device = request.value("dev", 0);
+
+        if (op == "ping")
+            return {{"ok", true}, {"version", ProtocolVersion}};
+
+        if (op == "spi" || op == "spi_batch") {
+            const json single = json::array({{{"tx", request.value("tx", json::array())}, {"rx", request.value("rx", 0)}}});
+            const json &list = (op == "spi") ? single : request.at("transactions");
+
+            std::vector<std::vector<uint8_t>> tx, rx;
+            std::vector<SpiTransport::Transaction> transactions;
+            for (const auto &item : list) {
+                tx.emplace_back();
+                if (!Bytes(item.at("tx"), tx.back()))
+                    return Error("request", "Byte out of range");
+                rx.emplace_back(item.at("rx").get<uint16_t>());
+            }
+            for (size_t i = 0; i < tx.size(); i++)
+                transactions.push_back({tx[i].data(), (uint16_t)tx[i].size(), rx[i].data(), (uint16_t)rx[i].size()});
+            m_xDevices.Spi(device).Transfer(transactions.data(), transactions.size());
+
+            if (op == "spi")
+                return {{"ok", true}, {"rx", rx[0]}};
+            return {{"ok", true}, {"rx", rx}};
+        }
+
+        if (op == "i2c_write") {
+            std::vector<uint8_t> data;
+            if (!Bytes(request.at("data"), data))
+                return Error("request", "Byte out of range");
+            uint16_t transferred = 0;
+            int status = m_xDevices.I2c(device).WriteEx(request.at("addr").get<uint16_t>(),
+                                                        static_cast<I2CFlag>(request.at("flag").get<int>()),
+                                                        data.data(), data.size(), transferred);
+            return {{"ok", true}, {"status", status}, {"transferred", transferred}};
+        }
+
+        if (op == "i2c_read") {
+            std::vector<uint8_t> data(request.at("size").get<uint16_t>());
+            uint16_t transferred = 0;
+            int status = m_xDevices.I2c(device).ReadEx(request.at("addr").get<uint16_t>(),
+                                                       static_cast<I2CFlag>(request.at("flag").get<int>()),
+                                                       data.data(), data.size(), transferred);
+            data.resize(transferred);
+            return {{"ok", true}, {"status", status}, {"data", data}};
+        }
+
+        if (op == "i2c_status") {
+            uint8_t value = 0;
+            int status = m_xDevices.I2c(device).GetStatus(value);
+            return {{"ok", true}, {"status", status}, {"value", value}};
+        }
+
+        if (op == "i2c_reset")
+            return {{"ok", true}, {"status", m_xDevices.I2c(device).ResetBus()}};
+
+        return Error("request", "Unknown operation");
+
+    } catch (const FtdiException &e) {
+        return Error("ftdi", e.what());
+    } catch (const LFSmartException &e) {
+        return Error("lfsmart", e.what(), e.CrcError());
+    } catch (const json::exception &e) {
+        return Error("request", "Malformed request");
+    }
+}
@@ -0,0 +1,206 @@
+#include "LfShadowCache.h"
+
+const size_t LfShadowCache::Size;
+
+
+LfShadowCache::LfShadowCache() {
+    for (size_t reg = 0; reg < Size; reg++)
+        m_aEntries[reg] = {DefaultPolicy(static_cast<lfc::Registers>(reg)), false, 0};
+}
+
+
+/**
+ * Политика регистра по-умолчанию, см. описание класса
+ * @param reg lfc::Registers - регистр
+ * @return Политика кэширования
+ */
+LfShadowCache::Policy LfShadowCache::DefaultPolicy(lfc::Registers reg) {
+    switch (reg) {
+        case lfc::Registers::WHOIAM:
+        case lfc::Registers::VERSION:
+        case lfc::Registers::CRC_HW:
+        case lfc::Registers::CRC_SW:
+            return POLICY_CONSTANT;
+
+        case lfc::Registers::DAC_CH1:
+        case lfc::Registers::DAC_CH2:
+        case lfc::Registers::DAC_CH3:
+        case lfc::Registers::DAC_CH4:
+        case lfc::Registers::DAC_DEFAULT_CH1:
+        case lfc::Registers::DAC_DEFAULT_CH2:
+        case lfc::Registers::DAC_DEFAULT_CH3:
+        case lfc::Registers::DAC_DEFAULT_CH4:
+        case lfc::Registers::DAC_MAX_CH1:
+        case lfc::Registers::DAC_MAX_CH2:
+        case lfc::Registers::DAC_MAX_CH3:
+        case lfc::Registers::DAC_MAX_CH4:
+            return POLICY_WRITE_THROUGH;
+
+        default:
+            return POLICY_VOLATILE;
+    }
+}
+
+
+/**
+ * Изменение политики регистра. Например, POLICY_VOLATILE для DAC_CH*, если ЦАП меняет DDS
+ * @param reg lfc::Registers - регистр
+ * @param policy Policy - новая политика
+ */
+void LfShadowCache::SetPolicy(lfc::Registers reg, Policy policy) {
+    if (reg >= Size)
+        return;
+    m_aEntries[reg].Mode = policy;
+    m_aEntries[reg].Valid = false;
+}
+
+
+LfShadowCache::Policy LfShadowCache::GetPolicy(lfc::Registers reg) const {
+    return reg < Size ? m_aEntries[reg].Mode : POLICY_VOLATILE;
+}
+
+
+/**
+ * Поиск копии регистра
+ * @param reg lfc::Registers - регистр
+ * @param value uint32_t& - значение копии
+ * @return true - копия есть, обмен с устройством не нужен
+ */
+bool LfShadowCache::Lookup(lfc::Registers reg, uint32_t &value) {
+    if (reg >= Size || m_aEntries[reg].Mode == POLICY_VOLATILE)
+        return false;
+
+    if (!m_aEntries[reg].Valid) {
+        m_xStats.Misses++;
+        return false;
+    }
+    m_xStats.Hits++;
+    value = m_aEntries[reg].Value;
+    return true;
+}
+
+
+/**
+ * Копия регистра без учёта в статистике
+ * @param reg lfc::Registers - регистр
+ * @param value uint32_t& - значение копии
+ * @return true - копия есть
+ */
+bool LfShadowCache::Peek(lfc::Registers reg, uint32_t &value) const {
+    if (reg >= Size || !m_aEntries[reg].Valid)
+        return false;
+    value = m_aEntries[reg].Value;
+    return true;
+}
+
+
+/**
+ * Значение, прочитанное из устройства
+ * @param reg lfc::Registers - регистр
+ * @param value uint32_t - прочитанное значение
+ */
+void LfShadowCache::Fill(lfc::Registers reg, uint32_t value) {
+    if (reg == lfc::Registers::STATUS) {
+        m_bActiveKnown = true;
+        m_bActive = (value & LF_STATUS_ENABLED) != 0;
+    }
+    if (reg < Size && m_aEntries[reg].Mode != POLICY_VOLATILE)
+        Store(reg, value);
+}
+
+
+/**
+ * Значение, записанное в устройство. Повторяет действия устройства над зависимыми регистрами
+ * @param reg lfc::Registers - регистр
+ * @param value uint16_t - записанное значение
+ */
+void LfShadowCache::Written(lfc::Registers reg, uint16_t value) {
+    switch (reg) {
+        case lfc::Registers::SVC:
+            if (value & LF_SVC_RESET) {
+                Invalidate();
+                return;
+            }
+            if (value & LF_SVC_STOP) {
+                m_bActiveKnown = true;
+                m_bActive = false;
+            }
+            if (value & LS_SVC_START) {
+                m_bActiveKnown = true;
+                m_bActive = true;
+            }
+            return;
+
+        case lfc::Registers::DAC_CH1:
+        case lfc::Registers::DAC_CH2:
+        case lfc::Registers::DAC_CH3:
+        case lfc::Registers::DAC_CH4: {
+            // Устройство ограничивает значение максимумом и не пишет ЦАП в остановленном состоянии
+            const Entry &maximum = m_aEntries[lfc::Registers::DAC_MAX_CH1 + (reg - lfc::Registers::DAC_CH1)];
+            if (m_aEntries[reg].Mode != POLICY_WRITE_THROUGH || !maximum.Valid || !m_bActiveKnown) {
+                Drop(reg);
+                return;
+            }
+            if (m_bActive)
+                Store(reg, value < maximum.Value ? value : maximum.Value);
+            return;
+        }
+
+        case lfc::Registers::DAC_MAX_CH1:
+        case lfc::Registers::DAC_MAX_CH2:
+        case lfc::Registers::DAC_MAX_CH3:
+        case lfc::Registers::DAC_MAX_CH4: {
+            // Текущее значение ЦАП больше нового максимума уменьшается устройством
+            Entry &dac = m_aEntries[lfc::Registers::DAC_CH1 + (reg - lfc::Registers::DAC_MAX_CH1)];
+            if (dac.Valid && dac.Value > value)
+                dac.Value = value;
+            break;
+        }
+
+        default:
+            break;
+    }
+
+    if (reg >= Size)
+        return;
+    if (m_aEntries[reg].Mode == POLICY_WRITE_THROUGH)
+        Store(reg, value);
+    else
+        Drop(reg);
+}
+
+
+/**
+ * Устройство сообщило об ошибке (LAST_ERROR не LE_NOERROR): записанные копии могут не совпадать
+ */
+void LfShadowCache::DeviceError() {
+    for (auto &entry : m_aEntries) {
+        if (entry.Mode == POLICY_WRITE_THROUGH)
+            entry.Valid = false;
+    }
+    m_bActiveKnown = false;
+    m_xStats.Invalidations++;
+}
+
+
+/**
+ * Очистка всех копий, например после сброса устройства
+ */
+void LfShadowCache::Invalidate() {
+    for (auto &entry : m_aEntries)
+        entry.Valid = false;
+    m_bActiveKnown = false;
+    m_xStats.Invalidations++;
+}
+
+
+void LfShadowCache::Store(int reg, uint32_t value) {
+    m_aEntries[reg].Valid = true;
+    m_aEntries[reg].Value = value;
+}
+
+
+void LfShadowCache::Drop(int reg) {
+    if (reg >= 0 && (size_t)reg < Size)
+        m_aEntries[reg].Valid = false;
+}
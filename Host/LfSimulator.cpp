@@ -0,0 +1,357 @@
+#include <algorithm>
+#include <thread>
+#include "LfSimulator.h"
+#include "crc8.h"
+
+
+static const uint16_t WhoiamValue = 0x1234;
+static const uint32_t CrcValue = 0x5A3C96E1;        ///< CRC_HW и CRC_SW, прошивка не повреждена
+
+
+LfSimulator::LfSimulator() : LfSimulator(Options()) {
+}
+
+
+LfSimulator::LfSimulator(const Options &options) : m_xOptions(options), m_xRandom(options.Seed) {
+    m_aNvDefault.fill(0);
+    m_aNvMax.fill(UINT16_MAX);
+    Reset();
+}
+
+
+bool LfSimulator::Write(uint8_t *buffer, uint16_t bufferSize, bool isEndTransaction) {
+    RoundTrip();
+    for (uint16_t i = 0; i < bufferSize; i++)
+        Exchange(buffer[i]);
+    if (isEndTransaction)
+        EndTransaction();
+    return true;
+}
+
+
+bool LfSimulator::Read(uint8_t *buffer, uint16_t bufferSize, bool isEndTransaction) {
+    RoundTrip();
+    for (uint16_t i = 0; i < bufferSize; i++)
+        buffer[i] = Exchange(0x00);
+    if (isEndTransaction)
+        EndTransaction();
+    return true;
+}
+
+
+bool LfSimulator::WriteRead(const uint8_t *command, uint16_t commandSize, uint8_t *response, uint16_t responseSize) {
+    RoundTrip();
+    if (m_xOptions.FtdiExchanges && responseSize != 0)
+        RoundTrip();
+    for (uint16_t i = 0; i < commandSize; i++)
+        Exchange(command[i]);
+    for (uint16_t i = 0; i < responseSize; i++)
+        response[i] = Exchange(0x00);
+    EndTransaction();
+    return true;
+}
+
+
+bool LfSimulator::Transfer(const Transaction *transactions, size_t count) {
+    if (m_xOptions.FtdiExchanges)
+        return SpiTransport::Transfer(transactions, count);
+
+    RoundTrip();
+    for (size_t i = 0; i < count; i++) {
+        for (uint16_t k = 0; k < transactions[i].TxSize; k++)
+            Exchange(transactions[i].Tx[k]);
+        for (uint16_t k = 0; k < transactions[i].RxSize; k++)
+            transactions[i].Rx[k] = Exchange(0x00);
+        EndTransaction();
+    }
+    return true;
+}
+
+
+/**
+ * Задать значение канала АЦП
+ * @param channel lfc::Channel - номер канала: CHANNEL_1..CHANNEL_4 или CHANNEL_ALL
+ * @param value uint16_t - сырое значение
+ */
+void LfSimulator::SetAdc(lfc::Channel channel, uint16_t value) {
+    if (channel == lfc::Channel::CHANNEL_ALL)
+        m_aAdc.fill(value);
+    else if (channel < lfc::Channel::CHANNEL_ALL)
+        m_aAdc[channel] = value;
+}
+
+
+/**
+ * Задать температуры THRM_PCB и THRM_MCU
+ * @param pcb uint16_t - температура платы, К
+ * @param mcu uint16_t - температура микроконтроллера, К
+ */
+void LfSimulator::SetTemperature(uint16_t pcb, uint16_t mcu) {
+    m_uThermPcb = pcb;
+    m_uThermMcu = mcu;
+}
+
+
+void LfSimulator::RoundTrip() {
+    m_uTransfers++;
+    m_xSimulatedTime += m_xOptions.Latency;
+    if (m_xOptions.RealTime && m_xOptions.Latency.count() > 0)
+        std::this_thread::sleep_for(m_xOptions.Latency);
+}
+
+
+/*
+ * Один байт полнодуплексного обмена. Первый байт транзакции - команда, на чтение ответ (данные и CRC8)
+ * готовится сразу и выдаётся со следующего байта. После ответа устройство выдаёт нули.
+ */
+uint8_t LfSimulator::Exchange(uint8_t mosi) {
+    size_t index = m_vMosi.size();
+    m_vMosi.push_back(Corrupt(mosi, m_xOptions.MosiBitErrorRate));
+
+    if (index == 0) {
+        uint8_t command = m_vMosi[0];
+        if ((command & 0x01) == lfc::Access::READ)
+            m_vResponse = ReadRegister(command >> 1);
+        return 0x00;
+    }
+
+    if (index - 1 < m_vResponse.size())
+        return Corrupt(m_vResponse[index - 1], m_xOptions.MisoBitErrorRate);
+    return 0x00;
+}
+
+
+uint8_t LfSimulator::Corrupt(uint8_t byte, double rate) {
+    if (rate <= 0.0)
+        return byte;
+
+    for (int bit = 0; bit < 8; bit++) {
+        if (m_xUniform(m_xRandom) < rate) {
+            byte ^= (1U << bit);
+            m_uBitErrors++;
+        }
+    }
+    return byte;
+}
+
+
+/*
+ * Запись выполняется по снятию SS: 3 байта - без CRC, 4 байта - с CRC8 по команде и данным.
+ * Короткие кадры отбрасываются, как и на устройстве.
+ */
+void LfSimulator::EndTransaction() {
+    m_uTransactions++;
+    if (m_vMosi.size() >= 3 && (m_vMosi[0] & 0x01) == lfc::Access::WRITE) {
+        if (m_vMosi.size() >= 4 && crc8(m_vMosi.data(), 3) != m_vMosi[3]) {
+            m_uLastError = lfc::LastError::LE_CRC_ERROR;
+        } else {
+            WriteRegister(m_vMosi[0] >> 1, static_cast<uint16_t>((m_vMosi[2] << 8) | m_vMosi[1]));
+        }
+    }
+    m_vMosi.clear();
+    m_vResponse.clear();
+}
+
+
+std::vector<uint8_t> LfSimulator::ReadRegister(uint8_t reg) {
+    std::vector<uint8_t> data;
+    auto put16 = [&data](uint16_t value) {
+        data.push_back(value & 0x00FF);
+        data.push_back((value & 0xFF00) >> 8);
+    };
+
+    switch (reg) {
+        case lfc::Registers::WHOIAM:
+            put16(WhoiamValue);
+            break;
+        case lfc::Registers::STATUS:
+            put16(m_uStatus);
+            break;
+        case lfc::Registers::LAST_ERROR:
+            put16(m_uLastError);
+            m_uLastError = lfc::LastError::LE_NOERROR;
+            break;
+
+        case lfc::Registers::DAC_CH1:
+        case lfc::Registers::DAC_CH2:
+        case lfc::Registers::DAC_CH3:
+        case lfc::Registers::DAC_CH4:
+            put16(m_aDac[reg - lfc::Registers::DAC_CH1]);
+            break;
+        case lfc::Registers::DAC_ALL:
+            put16(m_aDac[0]);
+            break;
+
+        case lfc::Registers::ADC_CH1:
+        case lfc::Registers::ADC_CH2:
+        case lfc::Registers::ADC_CH3:
+        case lfc::Registers::ADC_CH4:
+            put16((m_uStatus & LF_STATUS_ADC_ENABLED) ? m_aAdc[reg - lfc::Registers::ADC_CH1] : 0);
+            break;
+        case lfc::Registers::ADC_ALL:
+            for (auto value : m_aAdc)
+                put16((m_uStatus & LF_STATUS_ADC_ENABLED) ? value : 0);
+            break;
+
+        case lfc::Registers::DAC_DEFAULT_CH1:
+        case lfc::Registers::DAC_DEFAULT_CH2:
+        case lfc::Registers::DAC_DEFAULT_CH3:
+        case lfc::Registers::DAC_DEFAULT_CH4:
+            put16(m_aDacDefault[reg - lfc::Registers::DAC_DEFAULT_CH1]);
+            break;
+
+        case lfc::Registers::DAC_MAX_CH1:
+        case lfc::Registers::DAC_MAX_CH2:
+        case lfc::Registers::DAC_MAX_CH3:
+        case lfc::Registers::DAC_MAX_CH4:
+            put16(m_aDacMax[reg - lfc::Registers::DAC_MAX_CH1]);
+            break;
+
+        case lfc::Registers::THRM_PCB:
+            put16(m_uThermPcb);
+            break;
+        case lfc::Registers::THRM_MCU:
+            put16(m_uThermMcu);
+            break;
+        case lfc::Registers::VERSION:
+            put16(m_xOptions.Version);
+            break;
+        case lfc::Registers::CRC_HW:
+        case lfc::Registers::CRC_SW:
+            put16(CrcValue & 0xFFFF);
+            put16(CrcValue >> 16);
+            break;
+        case lfc::Registers::CERT:
+            put16(m_uCert);
+            break;
+
+        case lfc::Registers::SAVE_EEP:
+        case lfc::Registers::SVC:
+            m_uLastError = lfc::LastError::LE_ACCESS_ERROR;
+            put16(0);
+            break;
+        default:
+            m_uLastError = lfc::LastError::LE_UNKNOWN_COMMAND;
+            put16(0);
+            break;
+    }
+
+    data.push_back(crc8(data.data(), data.size()));
+    return data;
+}
+
+
+/*
+ * Каждая запись обновляет LAST_ERROR результатом выполнения
+ */
+void LfSimulator::WriteRegister(uint8_t reg, uint16_t value) {
+    m_uLastError = lfc::LastError::LE_NOERROR;
+
+    switch (reg) {
+        case lfc::Registers::DAC_CH1:
+        case lfc::Registers::DAC_CH2:
+        case lfc::Registers::DAC_CH3:
+        case lfc::Registers::DAC_CH4:
+            WriteDac(reg - lfc::Registers::DAC_CH1, value);
+            break;
+        case lfc::Registers::DAC_ALL:
+            for (int channel = 0; channel < 4; channel++)
+                WriteDac(channel, value);
+            break;
+
+        case lfc::Registers::DAC_DEFAULT_CH1:
+        case lfc::Registers::DAC_DEFAULT_CH2:
+        case lfc::Registers::DAC_DEFAULT_CH3:
+        case lfc::Registers::DAC_DEFAULT_CH4:
+            m_aDacDefault[reg - lfc::Registers::DAC_DEFAULT_CH1] = value;
+            break;
+
+        case lfc::Registers::DAC_MAX_CH1:
+        case lfc::Registers::DAC_MAX_CH2:
+        case lfc::Registers::DAC_MAX_CH3:
+        case lfc::Registers::DAC_MAX_CH4: {
+            int channel = reg - lfc::Registers::DAC_MAX_CH1;
+            m_aDacMax[channel] = value;
+            if (m_aDac[channel] > value) {
+                m_aDac[channel] = value;
+                m_uLastError = lfc::LastError::LE_DAC_OVERFLOW;
+            }
+            break;
+        }
+
+        case lfc::Registers::SAVE_EEP:
+            for (int channel = 0; channel < 4; channel++) {
+                if (value & (NV_DAC_DEFAULT_CH1 << channel))
+                    m_aNvDefault[channel] = m_aDacDefault[channel];
+                if (value & (NV_DAC_MAX_CH1 << channel))
+                    m_aNvMax[channel] = m_aDacMax[channel];
+            }
+            break;
+
+        case lfc::Registers::SVC:
+            if (value & LF_SVC_RESET) {
+                Reset();
+                break;
+            }
+            if (value & LF_SVC_ADC_EN)
+                m_uStatus |= LF_STATUS_ADC_ENABLED;
+            if (value & LF_SVC_ADC_DIS)
+                m_uStatus &= ~LF_STATUS_ADC_ENABLED;
+            if (value & LS_SVC_START)
+                m_uStatus |= LF_STATUS_ENABLED;
+            if (value & LF_SVC_STOP)
+                m_uStatus &= ~LF_STATUS_ENABLED;
+            break;
+
+        case lfc::Registers::CERT:
+            m_uCert = value;
+            break;
+
+        case lfc::Registers::WHOIAM:
+        case lfc::Registers::STATUS:
+        case lfc::Registers::LAST_ERROR:
+        case lfc::Registers::ADC_CH1:
+        case lfc::Registers::ADC_CH2:
+        case lfc::Registers::ADC_CH3:
+        case lfc::Registers::ADC_CH4:
+        case lfc::Registers::ADC_ALL:
+        case lfc::Registers::THRM_PCB:
+        case lfc::Registers::THRM_MCU:
+        case lfc::Registers::VERSION:
+        case lfc::Registers::CRC_HW:
+        case lfc::Registers::CRC_SW:
+            m_uLastError = lfc::LastError::LE_ACCESS_ERROR;
+            break;
+
+        default:
+            m_uLastError = lfc::LastError::LE_UNKNOWN_COMMAND;
+            break;
+    }
+}
+
+
+void LfSimulator::WriteDac(int channel, uint16_t value) {
+    if ((m_uStatus & LF_STATUS_ENABLED) == 0) {
+        m_uLastError = lfc::LastError::LE_INACTIVE;
+        return;
+    }
+    if (value > m_aDacMax[channel]) {
+        value = m_aDacMax[channel];
+        m_uLastError = lfc::LastError::LE_DAC_TRUNCATE;
+    }
+    m_aDac[channel] = value;
+}
+
+
+/*
+ * Программный сброс: регистры из энергонезависимой памяти, ЦАП - значения по-умолчанию
+ */
+void LfSimulator::Reset() {
+    m_aDacDefault = m_aNvDefault;
+    m_aDacMax = m_aNvMax;
+    for (size_t channel = 0; channel < m_aDac.size(); channel++)
+        m_aDac[channel] = std::min(m_aDacDefault[channel], m_aDacMax[channel]);
+    m_uStatus = LF_STATUS_PG | LF_STATUS_ADC_ENABLED | LF_STATUS_ENABLED;
+    m_uLastError = lfc::LastError::LE_NOERROR;
+    m_uCert = 0;
+}
@@ -0,0 +1,219 @@
+#include <algorithm>
+#include <stdexcept>
+#include "LfUpdater.h"
+
+
+static const uint8_t FrameSync = 0x5A;
+static const uint8_t ReplySync = 0xA5;
+static const uint32_t StalePolls = 4;       ///< Опросов с номером старого кадра, после которых кадр считается потерянным
+
+
+static uint32_t LoadWord(const uint8_t *data) {
+    return data[0] | (uint32_t)data[1] << 8 | (uint32_t)data[2] << 16 | (uint32_t)data[3] << 24;
+}
+
+
+static void StoreWord(uint8_t *data, uint32_t value) {
+    for (int i = 0; i < 4; i++)
+        data[i] = value >> (8 * i);
+}
+
+
+/**
+ * CRC-32/MPEG-2 (crc-32-mpeg в Tools/append_crc.py): полином 0x04C11DB7, без отражения и финального XOR
+ * @param crc uint32_t - начальное значение или результат предыдущего вызова
+ */
+uint32_t LfUpdater::Crc32(const uint8_t *data, size_t size, uint32_t crc) {
+    for (size_t i = 0; i < size; i++) {
+        crc ^= (uint32_t)data[i] << 24;
+        for (int bit = 0; bit < 8; bit++)
+            crc = (crc & 0x80000000) ? (crc << 1) ^ 0x04C11DB7 : crc << 1;
+    }
+    return crc;
+}
+
+
+/**
+ * Проверка образа после Tools/append_crc.py
+ * @param image const std::vector<uint8_t>& - образ
+ * @param crc uint32_t& - CRC из последнего слова образа
+ * @return true, если размер кратен слову и CRC совпадает
+ */
+bool LfUpdater::CheckImage(const std::vector<uint8_t> &image, uint32_t &crc) {
+    if (image.size() < 8 || image.size() % 4)
+        return false;
+    crc = LoadWord(&image[image.size() - 4]);
+    return Crc32(image.data(), image.size() - 4) == crc;
+}
+
+
+/**
+ * Кадр протокола
+ * @param frame uint8_t* - FrameSize байт
+ * @param argument uint32_t - размер образа для CMD_BEGIN, смещение для CMD_DATA
+ * @param data const uint8_t* - данные CMD_DATA, length не больше FrameData
+ */
+void LfUpdater::MakeFrame(uint8_t *frame, Command command, uint8_t sequence, uint32_t argument,
+                          const uint8_t *data, uint8_t length) {
+    if (length > FrameData)
+        throw std::invalid_argument("Frame data too long");
+
+    std::fill(frame, frame + FrameSize, 0);
+    frame[0] = FrameSync;
+    frame[1] = command;
+    frame[2] = sequence;
+    frame[3] = length;
+    StoreWord(frame + 4, argument);
+    if (length)
+        std::copy(data, data + length, frame + 8);
+    StoreWord(frame + FrameSize - 4, Crc32(frame, FrameSize - 4));
+}
+
+
+/**
+ * Разбор ответа
+ * @return false, если ответ повреждён: FIFO устройства не успело заполниться или байты сдвинуты
+ */
+bool LfUpdater::ParseReply(const uint8_t *reply, Reply &parsed) {
+    if (reply[0] != ReplySync || reply[7] != (uint8_t)Crc32(reply, ReplySize - 1))
+        return false;
+    uint8_t status = reply[2] & 0x0F, state = reply[2] >> 4;
+    if (status > VERIFY_ERROR || state > FAILED)
+        return false;
+
+    parsed.Sequence = reply[1];
+    parsed.Result = static_cast<Status>(status);
+    parsed.Progress = static_cast<State>(state);
+    parsed.Received = (reply[3] | reply[4] << 8) * 4u;
+    parsed.Free = (reply[5] | reply[6] << 8) * 4u;
+    return true;
+}
+
+
+std::string LfUpdater::StatusName(Status status) {
+    switch (status) {
+        case OK: return "ok";
+        case BUSY: return "busy";
+        case BAD_FRAME: return "bad frame";
+        case BAD_OFFSET: return "bad offset";
+        case BAD_SIZE: return "bad image size";
+        case BAD_STATE: return "bad state";
+        case PROGRAM_ERROR: return "program error";
+        case VERIFY_ERROR: return "CRC verify error";
+    }
+    return "unknown";
+}
+
+
+/*
+ * Неполная передача не проверяется: устройство отбросит оборванный кадр, хост повторит его по ответу
+ */
+void LfUpdater::Send(std::vector<uint8_t> &frames) {
+    m_xSpi.Write(frames.data(), frames.size(), true);
+}
+
+
+/*
+ * Ответ на последний кадр. FIFO устройства заполняется заново, только когда опустело, поэтому первое чтение
+ * после пачки кадров может вернуть обрывок или ответ на более ранний кадр
+ */
+LfUpdater::Reply LfUpdater::Wait() {
+    Reply latest {};
+    uint32_t stale = 0;
+    for (uint32_t poll = 0; poll < m_uPollLimit; poll++) {
+        uint8_t raw[ReplySize];
+        m_xSpi.Read(raw, ReplySize, true);
+        m_xStats.Polls++;
+
+        Reply reply {};
+        if (!ParseReply(raw, reply)) {
+            m_xStats.BadReplies++;
+            continue;
+        }
+        if (reply.Sequence == m_uSequence)
+            return reply;
+
+        m_xStats.BadReplies++;
+        latest = reply;
+        if (++stale >= StalePolls)
+            return latest;
+    }
+    throw std::runtime_error("No reply from device in update mode");
+}
+
+
+/**
+ * Передача, запись и проверка образа. После успешного обновления устройство ждёт Reset()
+ * @param image const std::vector<uint8_t>& - образ после Tools/append_crc.py, размер - область образа во flash
+ * @return Статистика передачи
+ * @throw std::invalid_argument без верной CRC образа, std::runtime_error при отказе устройства
+ */
+LfUpdater::Stats LfUpdater::Update(const std::vector<uint8_t> &image) {
+    auto start = std::chrono::steady_clock::now();
+    m_xStats = {image.size(), 0, 0, 0, 0, std::chrono::microseconds(0)};
+
+    uint32_t crc;
+    if (!CheckImage(image, crc))
+        throw std::invalid_argument("Image has no valid trailing CRC, see Tools/append_crc.py");
+    const uint32_t size = image.size();
+
+    // Стирание от прошлой попытки надо дождаться: BEGIN отвечает BUSY
+    std::vector<uint8_t> frames(FrameSize);
+    Reply reply {};
+    for (uint32_t attempt = 0;; attempt++) {
+        if (attempt >= m_uPollLimit)
+            throw std::runtime_error("Device does not start update");
+        MakeFrame(frames.data(), CMD_BEGIN, ++m_uSequence, size);
+        Send(frames);
+        reply = Wait();
+        if (reply.Sequence == m_uSequence && reply.Result != BUSY)
+            break;
+    }
+    if (reply.Result != OK)
+        throw std::runtime_error("Update rejected: " + StatusName(reply.Result));
+
+    uint32_t sent = 0;
+    uint32_t idle = 0;
+    while (reply.Progress != DONE) {
+        if (reply.Progress == FAILED)
+            throw std::runtime_error("Update failed: " + StatusName(reply.Result));
+
+        if (reply.Progress == RECEIVING && reply.Received < size && reply.Free >= 4) {
+            frames.clear();
+            uint32_t offset = reply.Received;
+            uint32_t budget = std::min<uint32_t>(reply.Free, MaxBurstFrames * FrameData);
+            while (budget >= 4 && offset < size) {
+                uint32_t length = std::min<uint32_t>({FrameData, budget, size - offset});
+                frames.resize(frames.size() + FrameSize);
+                MakeFrame(&frames[frames.size() - FrameSize], CMD_DATA, ++m_uSequence, offset, &image[offset], length);
+                m_xStats.Frames++;
+                if (offset < sent)
+                    m_xStats.Retransmits++;
+                offset += length;
+                budget -= length;
+            }
+            sent = std::max(sent, offset);
+            Send(frames);
+        }
+
+        Reply next = Wait();
+        if (next.Received != reply.Received || next.Progress != reply.Progress)
+            idle = 0;
+        else if (++idle > m_uPollLimit)
+            throw std::runtime_error("Update stalled at " + std::to_string(next.Received) + " bytes");
+        reply = next;
+    }
+
+    m_xStats.Elapsed = std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - start);
+    return m_xStats;
+}
+
+
+/**
+ * Сброс устройства: после обновления запускается новая прошивка
+ */
+void LfUpdater::Reset() {
+    std::vector<uint8_t> frame(FrameSize);
+    MakeFrame(frame.data(), CMD_RESET, ++m_uSequence, 0);
+    Send(frame);
+}
@@ -0,0 +1,292 @@
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <stdexcept>
+#include <system_error>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include "TelemetryFile.h"
+
+using nlohmann::json;
+
+static const uint64_t PageSize = 4096;
+static const char Magic[4] = {'L', 'F', 'T', 'M'};
+
+
+static uint64_t AlignPage(uint64_t size) {
+    return (size + PageSize - 1) / PageSize * PageSize;
+}
+
+
+static uint64_t Load(const uint8_t *cell, uint32_t width) {
+    uint64_t value = 0;
+    memcpy(&value, cell, width);
+    return value;
+}
+
+
+/**
+ * Создаёт файл, существующий перезаписывается
+ * @param path const std::string& - путь файла
+ * @param columns const std::vector<TelemetryFile::Column>& - столбцы
+ * @param meta const nlohmann::json& - метаданные, поле "columns" заполняется из columns
+ * @param blockSamples uint32_t - записей в блоке
+ * @throw std::system_error при ошибке файла, std::invalid_argument при неверной ширине столбца
+ */
+TelemetryWriter::TelemetryWriter(const std::string &path, const std::vector<TelemetryFile::Column> &columns,
+                                 const json &meta, uint32_t blockSamples) : m_uBlockSamples(blockSamples) {
+    if (columns.empty() || blockSamples == 0)
+        throw std::invalid_argument("Telemetry file without columns");
+
+    json header = meta;
+    header["columns"] = json::array();
+    for (const auto &column : columns) {
+        if (column.Width != 1 && column.Width != 2 && column.Width != 4 && column.Width != 8)
+            throw std::invalid_argument("Column width must be 1, 2, 4 or 8");
+        header["columns"].push_back({{"name", column.Name}, {"width", column.Width}});
+        m_vColumnOffsets.push_back(m_uBlockSize);
+        m_vWidths.push_back(column.Width);
+        m_uBlockSize += (uint64_t)column.Width * blockSamples;
+    }
+    const std::string text = header.dump();
+    m_uDataOffset = AlignPage(sizeof(TelemetryFile::Header) + text.size());
+
+    m_iFile = open(path.c_str(), O_RDWR | O_CREAT | O_TRUNC, 0644);
+    if (m_iFile < 0)
+        throw std::system_error(errno, std::generic_category(), "open " + path);
+
+    Map(1);
+    auto *fileHeader = reinterpret_cast<TelemetryFile::Header *>(m_pMap);
+    memcpy(fileHeader->Magic, Magic, sizeof(Magic));
+    fileHeader->FormatVersion = TelemetryFile::FormatVersion;
+    fileHeader->MetaSize = text.size();
+    fileHeader->BlockSamples = blockSamples;
+    fileHeader->Samples = 0;
+    fileHeader->DataOffset = m_uDataOffset;
+    fileHeader->BlockSize = m_uBlockSize;
+    fileHeader->Columns = columns.size();
+    memcpy(m_pMap + sizeof(TelemetryFile::Header), text.data(), text.size());
+}
+
+
+TelemetryWriter::~TelemetryWriter() {
+    try {
+        Close();
+    } catch (const std::system_error &) {
+        // Деструктор не бросает, данные до последней записи уже в файле
+    }
+}
+
+
+/*
+ * Отображение файла размером на blocks блоков
+ */
+void TelemetryWriter::Map(uint64_t blocks) {
+    size_t size = m_uDataOffset + blocks * m_uBlockSize;
+    if (m_pMap)
+        munmap(m_pMap, m_uMapSize);
+    m_pMap = nullptr;
+
+    if (ftruncate(m_iFile, size) != 0)
+        throw std::system_error(errno, std::generic_category(), "ftruncate");
+    void *map = mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED, m_iFile, 0);
+    if (map == MAP_FAILED)
+        throw std::system_error(errno, std::generic_category(), "mmap");
+
+    m_pMap = static_cast<uint8_t *>(map);
+    m_uMapSize = size;
+    m_uBlocks = blocks;
+}
+
+
+/**
+ * Добавление записи
+ * @param values const uint64_t* - значения всех столбцов, в столбец записываются младшие Width байт
+ */
+void TelemetryWriter::Append(const uint64_t *values) {
+    uint64_t block = m_uSamples / m_uBlockSamples;
+    uint64_t index = m_uSamples % m_uBlockSamples;
+    if (block >= m_uBlocks)
+        Map(m_uBlocks * 2);
+
+    uint8_t *base = m_pMap + m_uDataOffset + block * m_uBlockSize;
+    for (size_t column = 0; column < m_vWidths.size(); column++)
+        memcpy(base + m_vColumnOffsets[column] + index * m_vWidths[column], &values[column], m_vWidths[column]);
+
+    m_uSamples++;
+    reinterpret_cast<TelemetryFile::Header *>(m_pMap)->Samples = m_uSamples;
+}
+
+
+/**
+ * Завершение записи: файл обрезается до последнего занятого блока
+ */
+void TelemetryWriter::Close() {
+    if (m_iFile < 0)
+        return;
+
+    uint64_t blocks = (m_uSamples + m_uBlockSamples - 1) / m_uBlockSamples;
+    munmap(m_pMap, m_uMapSize);
+    m_pMap = nullptr;
+    int result = ftruncate(m_iFile, m_uDataOffset + blocks * m_uBlockSize);
+    int error = errno;
+    close(m_iFile);
+    m_iFile = -1;
+    if (result != 0)
+        throw std::system_error(error, std::generic_category(), "ftruncate");
+}
+
+
+/**
+ * Открытие файла телеметрии
+ * @param path const std::string& - путь файла
+ * @throw std::system_error при ошибке файла, std::runtime_error при неверном формате
+ */
+TelemetryReader::TelemetryReader(const std::string &path) {
+    m_iFile = open(path.c_str(), O_RDONLY);
+    if (m_iFile < 0)
+        throw std::system_error(errno, std::generic_category(), "open " + path);
+
+    struct stat info {};
+    if (fstat(m_iFile, &info) != 0 || (size_t)info.st_size < sizeof(TelemetryFile::Header)) {
+        close(m_iFile);
+        throw std::runtime_error("Not a telemetry file");
+    }
+    void *map = mmap(nullptr, info.st_size, PROT_READ, MAP_SHARED, m_iFile, 0);
+    if (map == MAP_FAILED) {
+        int error = errno;
+        close(m_iFile);
+        throw std::system_error(error, std::generic_category(), "mmap");
+    }
+    m_pMap = static_cast<const uint8_t *>(map);
+    m_uMapSize = info.st_size;
+
+    TelemetryFile::Header header {};
+    memcpy(&header, m_pMap, sizeof(header));
+    try {
+        if (memcmp(header.Magic, Magic, sizeof(Magic)) != 0 || header.FormatVersion != TelemetryFile::FormatVersion ||
+                sizeof(header) + header.MetaSize > m_uMapSize || header.BlockSamples == 0 || header.BlockSize == 0)
+            throw std::runtime_error("Not a telemetry file");
+
+        const char *text = reinterpret_cast<const char *>(m_pMap + sizeof(header));
+        m_xMeta = json::parse(text, text + header.MetaSize);
+        uint64_t offset = 0;
+        for (const auto &column : m_xMeta.at("columns")) {
+            m_vColumns.push_back({column.at("name").get<std::string>(), column.at("width").get<uint32_t>()});
+            m_vColumnOffsets.push_back(offset);
+            offset += (uint64_t)m_vColumns.back().Width * header.BlockSamples;
+        }
+        if (offset != header.BlockSize || m_vColumns.size() != header.Columns)
+            throw std::runtime_error("Telemetry file columns mismatch");
+    } catch (const json::exception &) {
+        munmap(const_cast<uint8_t *>(m_pMap), m_uMapSize);
+        close(m_iFile);
+        throw std::runtime_error("Telemetry file metadata corrupted");
+    } catch (...) {
+        munmap(const_cast<uint8_t *>(m_pMap), m_uMapSize);
+        close(m_iFile);
+        throw;
+    }
+
+    m_uBlockSamples = header.BlockSamples;
+    m_uDataOffset = header.DataOffset;
+    m_uBlockSize = header.BlockSize;
+
+    // Запись могла не дойти до конца блока, читаются только записи внутри файла
+    uint64_t blocks = m_uMapSize > m_uDataOffset ? (m_uMapSize - m_uDataOffset) / m_uBlockSize : 0;
+    m_uSamples = std::min<uint64_t>(header.Samples, blocks * m_uBlockSamples);
+}
+
+
+TelemetryReader::~TelemetryReader() {
+    munmap(const_cast<uint8_t *>(m_pMap), m_uMapSize);
+    close(m_iFile);
+}
+
+
+/**
+ * Номер столбца по имени, -1 если нет
+ */
+int TelemetryReader::FindColumn(const std::string &name) const {
+    for (size_t column = 0; column < m_vColumns.size(); column++) {
+        if (m_vColumns[column].Name == name)
+            return column;
+    }
+    return -1;
+}
+
+
+const uint8_t *TelemetryReader::Cell(size_t column, uint64_t sample) const {
+    uint64_t block = sample / m_uBlockSamples;
+    uint64_t index = sample % m_uBlockSamples;
+    return m_pMap + m_uDataOffset + block * m_uBlockSize + m_vColumnOffsets[column] + index * m_vColumns[column].Width;
+}
+
+
+/**
+ * Значение одной ячейки
+ * @param column size_t - номер столбца
+ * @param sample uint64_t - номер записи
+ * @throw std::out_of_range при выходе за границы
+ */
+uint64_t TelemetryReader::Value(size_t column, uint64_t sample) const {
+    if (column >= m_vColumns.size() || sample >= m_uSamples)
+        throw std::out_of_range("Telemetry cell out of range");
+    return Load(Cell(column, sample), m_vColumns[column].Width);
+}
+
+
+/**
+ * Весь столбец. Значения в блоке лежат подряд, чтение идёт последовательно по памяти
+ * @param column size_t - номер столбца
+ */
+std::vector<uint64_t> TelemetryReader::Column(size_t column) const {
+    if (column >= m_vColumns.size())
+        throw std::out_of_range("Telemetry column out of range");
+
+    std::vector<uint64_t> values(m_uSamples);
+    const uint32_t width = m_vColumns[column].Width;
+    for (uint64_t first = 0; first < m_uSamples; first += m_uBlockSamples) {
+        const uint8_t *cell = Cell(column, first);
+        uint64_t count = std::min<uint64_t>(m_uBlockSamples, m_uSamples - first);
+        switch (width) {
+            case 1:
+                for (uint64_t i = 0; i < count; i++)
+                    values[first + i] = cell[i];
+                break;
+            case 2:
+                for (uint64_t i = 0; i < count; i++)
+                    values[first + i] = Load(cell + 2 * i, 2);
+                break;
+            case 4:
+                for (uint64_t i = 0; i < count; i++)
+                    values[first + i] = Load(cell + 4 * i, 4);
+                break;
+            default:
+                memcpy(&values[first], cell, count * 8);
+                break;
+        }
+    }
+    return values;
+}
+
+
+/**
+ * Экспорт в CSV: строка заголовка с именами столбцов, затем по строке на запись
+ */
+void TelemetryReader::ExportCsv(std::ostream &out) const {
+    std::vector<std::vector<uint64_t>> columns;
+    for (size_t column = 0; column < m_vColumns.size(); column++) {
+        out << (column ? "," : "") << m_vColumns[column].Name;
+        columns.push_back(Column(column));
+    }
+    out << '\n';
+
+    for (uint64_t sample = 0; sample < m_uSamples; sample++) {
+        for (size_t column = 0; column < columns.size(); column++)
+            out << (column ? "," : "") << columns[column][sample];
+        out << '\n';
+    }
+}
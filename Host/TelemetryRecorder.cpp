@@ -0,0 +1,187 @@
+#include <cmath>
+#include <cstring>
+#include <stdexcept>
+#include <thread>
+#include "TelemetryRecorder.h"
+#include "crc8.h"
+
+using nlohmann::json;
+
+const size_t TelemetryRecorder::MaxRegisters;
+
+/**
+ * Регистр по имени из register_map.h, например "THRM_PCB"
+ * @return lfc::Registers::INVALID, если регистра нет или он только для записи
+ */
+lfc::Registers TelemetryRecorder::RegisterFromName(const std::string &name) {
+    for (size_t reg = 0; reg < lfc::REGISTER_COUNT; reg++) {
+        if (RegisterName(static_cast<lfc::Registers>(reg)) && name == lfc::RegisterTable[reg].Name)
+            return static_cast<lfc::Registers>(reg);
+    }
+    return lfc::Registers::INVALID;
+}
+
+
+const char *TelemetryRecorder::RegisterName(lfc::Registers reg) {
+    lfc::RegisterInfo info = lfc::GetRegisterInfo(reg);
+    return (info.Access & lfc::ACCESS_READ) ? info.Name : nullptr;
+}
+
+
+/**
+ * Размер данных регистра при чтении, без CRC
+ */
+uint16_t TelemetryRecorder::RegisterSize(lfc::Registers reg) {
+    return lfc::GetRegisterInfo(reg).Size;
+}
+
+
+/**
+ * @param spi SpiTransport& - транспорт
+ * @param registers const std::vector<lfc::Registers>& - регистры записи, не больше MaxRegisters
+ * @param options const Options& - параметры записи
+ * @throw std::invalid_argument при пустом списке, слишком длинном списке или регистре только для записи
+ */
+TelemetryRecorder::TelemetryRecorder(SpiTransport &spi, const std::vector<lfc::Registers> &registers,
+                                     const Options &options) :
+        m_xSpi(spi), m_vRegisters(registers), m_xOptions(options) {
+    if (registers.empty() || registers.size() > MaxRegisters)
+        throw std::invalid_argument("Telemetry register count must be 1..16");
+
+    m_vColumns.push_back({"time_ns", 8});
+    m_vColumns.push_back({"flags", 2});
+    for (auto reg : registers) {
+        const char *name = RegisterName(reg);
+        if (!name)
+            throw std::invalid_argument("Register not readable");
+
+        uint16_t size = RegisterSize(reg);
+        if (size == 8) {
+            for (int channel = 1; channel <= 4; channel++)
+                m_vColumns.push_back({std::string(name) + "_" + std::to_string(channel), 2});
+        } else {
+            m_vColumns.push_back({name, size});
+        }
+        m_vCommands.push_back((reg << 1) | lfc::Access::READ);
+        m_vResponses.emplace_back(size + (options.UseCRC ? 1 : 0));
+    }
+}
+
+
+bool TelemetryRecorder::Check(size_t index) const {
+    if (!m_xOptions.UseCRC)
+        return true;
+    const auto &response = m_vResponses[index];
+    return crc8(response.data(), response.size() - 1) == response.back();
+}
+
+
+/*
+ * Значение part-го столбца index-го регистра из ответа
+ */
+uint64_t TelemetryRecorder::Decode(size_t index, size_t part) const {
+    const auto &response = m_vResponses[index];
+    if (RegisterSize(m_vRegisters[index]) == 4)
+        return (uint32_t)response[0] | (uint32_t)response[1] << 8 | (uint32_t)response[2] << 16 | (uint32_t)response[3] << 24;
+    return response[2 * part] | response[2 * part + 1] << 8;
+}
+
+
+/**
+ * Запись до Options::Samples записей или до Stop()
+ * @param path const std::string& - файл телеметрии
+ * @param meta const nlohmann::json& - дополнительные метаданные файла
+ * @return Статистика записи
+ * @throw std::system_error при ошибке файла, FtdiException при ошибке адаптера
+ */
+TelemetryRecorder::Stats TelemetryRecorder::Record(const std::string &path, const json &meta) {
+    using Clock = std::chrono::steady_clock;
+
+    json header = meta;
+    header["registers"] = json::array();
+    for (auto reg : m_vRegisters)
+        header["registers"].push_back(RegisterName(reg));
+    header["period_us"] = m_xOptions.Period.count();
+    header["crc"] = m_xOptions.UseCRC;
+    TelemetryWriter writer(path, m_vColumns, header, m_xOptions.BlockSamples);
+
+    std::vector<SpiTransport::Transaction> all, retry;
+    for (size_t i = 0; i < m_vRegisters.size(); i++)
+        all.push_back({&m_vCommands[i], 1, m_vResponses[i].data(), (uint16_t)m_vResponses[i].size()});
+    std::vector<uint64_t> values(m_vColumns.size());
+
+    Stats stats {0, 0, 0, 0, 0.0, std::chrono::nanoseconds(0), std::chrono::nanoseconds(0), std::chrono::nanoseconds(0)};
+    double sum = 0, sumSquares = 0;
+    int64_t maxInterval = 0;
+    int64_t previous = 0;
+
+    m_bStop = false;
+    const auto start = Clock::now();
+    auto deadline = start;
+    while (!m_bStop && (m_xOptions.Samples == 0 || stats.Samples < m_xOptions.Samples)) {
+        if (m_xOptions.Period.count() > 0) {
+            auto now = Clock::now();
+            if (now < deadline)
+                std::this_thread::sleep_until(deadline);
+            else if (now - deadline > m_xOptions.Period)
+                stats.Late++;
+            deadline += m_xOptions.Period;
+        }
+
+        int64_t time = std::chrono::duration_cast<std::chrono::nanoseconds>(Clock::now() - start).count();
+        m_xSpi.Transfer(all.data(), all.size());
+
+        uint16_t flags = 0;
+        for (size_t i = 0; i < m_vRegisters.size(); i++) {
+            if (!Check(i))
+                flags |= 1 << i;
+        }
+        for (int attempt = 1; flags && attempt < m_xOptions.Tries; attempt++) {
+            retry.clear();
+            for (size_t i = 0; i < m_vRegisters.size(); i++) {
+                if (flags & (1 << i))
+                    retry.push_back(all[i]);
+            }
+            stats.Retries += retry.size();
+            m_xSpi.Transfer(retry.data(), retry.size());
+            for (size_t i = 0; i < m_vRegisters.size(); i++) {
+                if ((flags & (1 << i)) && Check(i))
+                    flags &= ~(1 << i);
+            }
+        }
+
+        size_t column = 0;
+        values[column++] = time;
+        values[column++] = flags;
+        for (size_t i = 0; i < m_vRegisters.size(); i++) {
+            size_t parts = RegisterSize(m_vRegisters[i]) == 8 ? 4 : 1;
+            for (size_t part = 0; part < parts; part++)
+                values[column++] = Decode(i, part);
+            if (flags & (1 << i))
+                stats.CrcErrors++;
+        }
+        writer.Append(values.data());
+
+        if (stats.Samples > 0) {
+            int64_t interval = time - previous;
+            sum += interval;
+            sumSquares += (double)interval * interval;
+            maxInterval = std::max(maxInterval, interval);
+        }
+        previous = time;
+        stats.Samples++;
+    }
+    auto elapsed = std::chrono::duration<double>(Clock::now() - start).count();
+    writer.Close();
+
+    if (stats.Samples > 1) {
+        double count = stats.Samples - 1;
+        double mean = sum / count;
+        stats.MeanInterval = std::chrono::nanoseconds((int64_t)mean);
+        stats.Jitter = std::chrono::nanoseconds((int64_t)std::sqrt(std::max(0.0, sumSquares / count - mean * mean)));
+        stats.MaxInterval = std::chrono::nanoseconds(maxInterval);
+    }
+    if (elapsed > 0)
+        stats.Rate = stats.Samples / elapsed;
+    return stats;
+}
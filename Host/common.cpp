@@ -1,4 +1,10 @@
 #include "common.h"
+#include "FtdiI2C.h"
+#include "FtdiSpi.h"
+#ifdef LFS_DAEMON
+#include <system_error>
+#include "LfClient.h"
+#endif
 
 
 bool no_channel_selected(const cxxopts::ParseResult &opts) {
@@ -54,3 +60,53 @@ uint16_t GetEepromMaximumMask(lfc::Channel channel) {
             return 0;
     }
 }
+
+
+/**
+ * Сокет lfsd для утилит, пустая строка - lfsd не поддерживается
+ */
+std::string DaemonSocket() {
+#ifdef LFS_DAEMON
+    return LfClient::DefaultSocket();
+#else
+    return std::string();
+#endif
+}
+
+
+/**
+ * Транспорт SPI: через lfsd, если он слушает socket, иначе напрямую через FT4222
+ * @param device int - номер преобразователя USB-SPI
+ * @param socket const std::string& - сокет lfsd, пустая строка - только напрямую
+ */
+std::unique_ptr<SpiTransport> OpenSpi(int device, const std::string &socket) {
+#ifdef LFS_DAEMON
+    if (!socket.empty()) {
+        try {
+            return std::unique_ptr<SpiTransport>(new SocketSpi(socket, device));
+        } catch (const std::system_error &) {
+            // lfsd не запущен
+        }
+    }
+#endif
+    return std::unique_ptr<SpiTransport>(new FtdiSpi(device));
+}
+
+
+/**
+ * Ведущий I2C: через lfsd, если он слушает socket, иначе напрямую через FT4222
+ * @param device int - номер преобразователя USB-I2C
+ * @param socket const std::string& - сокет lfsd, пустая строка - только напрямую
+ */
+std::unique_ptr<I2cBus> OpenI2c(int device, const std::string &socket) {
+#ifdef LFS_DAEMON
+    if (!socket.empty()) {
+        try {
+            return std::unique_ptr<I2cBus>(new SocketI2c(socket, device));
+        } catch (const std::system_error &) {
+            // lfsd не запущен
+        }
+    }
+#endif
+    return std::unique_ptr<I2cBus>(new FtdiI2C(device));
+}
@@ -14,15 +14,26 @@
   * Аргументы командной строки:
   *  - -l --list: вывести список подключенных преобразователей USB-SPI/I2C FT4222
   *  - -d --device: номер преобразователя USB-SPI/I2C, по-умолчанию 0
+  *  - -s --socket: сокет lfsd, по-умолчанию $LFSD_SOCKET, $XDG_RUNTIME_DIR/lfsd.sock или /tmp/lfsd.sock.
+  *    Без lfsd - напрямую через FT4222
   *  - -a --addr: адрес I2C ведомого устройства
   *  - -r --reg: адрес регистра ведомого устройства
+  *
+  * Чтение образа внешней EEPROM 24Cxx в файл:
+  *  - -c --chip: микросхема из Tools/lists.py, --chips - список
+  *  - -f --file: файл образа
+  *  - -o --offset: адрес первой ячейки, по-умолчанию 0
+  *  - -n --size: байт, по-умолчанию до конца микросхемы
+  *  Без -a адрес I2C микросхемы 0x50
   */
 
 /** @} */
 
+#include <fstream>
 #include <iostream>
 #include <fmt/core.h>
 #include <cxxopts.hpp>
+#include <Eeprom24.h>
 #include <FtdiI2C.h>
 #include <common.h>
 
@@ -35,8 +46,14 @@ static cxxopts::ParseResult parse(int argc, char *argv[]) {
                 ("h,help", "Print help")
                 ("l,list", "List FTDI devices", cxxopts::value<bool>()->default_value("false"))
                 ("d,device", "FTDI device number, default 0", cxxopts::value<int>()->default_value("0"))
+                ("s,socket", "lfsd socket, empty - direct FTDI access", cxxopts::value<std::string>()->default_value(DaemonSocket()))
                 ("a,addr", "I2C slave device address", cxxopts::value<uint8_t>()->default_value("12"))
-                ("r,reg", "Slave Register address", cxxopts::value<uint8_t>()->default_value("0"));
+                ("r,reg", "Slave Register address", cxxopts::value<uint8_t>()->default_value("0"))
+                ("c,chip", "EEPROM chip from Tools/lists.py", cxxopts::value<std::string>())
+                ("chips", "List EEPROM chips", cxxopts::value<bool>()->default_value("false"))
+                ("f,file", "File to dump EEPROM to", cxxopts::value<std::string>())
+                ("o,offset", "EEPROM start address", cxxopts::value<uint32_t>()->default_value("0"))
+                ("n,size", "Bytes to dump, default up to the chip end", cxxopts::value<uint32_t>());
 
         auto result = options.parse(argc, argv);
         if (result.count("help")) {
@@ -84,33 +101,79 @@ void PrintStatus(uint8 status) {
     }
 }
 
+/*
+ * Чтение образа EEPROM в файл
+ */
+static int DumpEeprom(I2cBus &iic, const EepromChip &chip, uint8_t address, const std::string &path,
+                      uint32_t offset, uint32_t size) {
+    std::ofstream file(path, std::ios::binary);
+    if (!file) {
+        fmt::print(stderr, "Cannot create {}\n", path);
+        return RETURN_STATUS::COMMANDLINE_ERROR;
+    }
+
+    Eeprom24 eeprom(iic, chip, address);
+    std::vector<uint8_t> image(size);
+    eeprom.Read(offset, image.data(), image.size());
+    file.write(reinterpret_cast<const char *>(image.data()), image.size());
+
+    auto stats = eeprom.GetStats();
+    fmt::print("Read {} bytes from {} at 0x{:X} in {:.1f} ms, {:.0f} B/s, {} transactions\n", size, chip.Model,
+               offset, stats.Elapsed.count() / 1000.0, stats.Rate(), stats.Transactions);
+    fmt::print("CRC32 {:08X}\n", Eeprom24::Crc32(image.data(), image.size()));
+    return RETURN_STATUS::OK;
+}
+
 int main(int argc, char *argv[]) {
     auto opts = parse(argc, argv);
     if (opts.count("list")) {
         FtdiI2C::FindDevices(true);
         ::exit(RETURN_STATUS::OK);
     }
+    if (opts.count("chips")) {
+        for (const auto &chip : Eeprom24::Chips())
+            fmt::print("{:28} {:18} {:7} B, page {}\n", chip.Name, chip.Model, chip.Size, chip.PageSize);
+        ::exit(RETURN_STATUS::OK);
+    }
+
+    const EepromChip *chip = nullptr;
+    if (opts.count("file")) {
+        chip = opts.count("chip") ? Eeprom24::FindChip(opts["chip"].as<std::string>()) : nullptr;
+        if (!chip) {
+            fmt::print(stderr, "EEPROM chip required, see --chips\n");
+            return RETURN_STATUS::COMMANDLINE_ERROR;
+        }
+    }
 
     int devnum = opts["device"].as<int>();
     uint8_t slaveAddress = opts["addr"].as<uint8_t>();
     uint8_t regAddress = opts["reg"].as<uint8_t>();
     try {
         fmt::print("Using FTDI device number {}\n", devnum);
-        FtdiI2C iic(devnum);
+        auto iic = OpenI2c(devnum, opts["socket"].as<std::string>());
+        if (chip) {
+            uint8_t address = opts.count("addr") ? slaveAddress : Eeprom24::DefaultAddress;
+            uint32_t offset = opts["offset"].as<uint32_t>();
+            uint32_t size = opts.count("size") ? opts["size"].as<uint32_t>() : (offset < chip->Size ? chip->Size - offset : 0);
+            return DumpEeprom(*iic, *chip, address, opts["file"].as<std::string>(), offset, size);
+        }
         uint16 transferred;
-        auto ret = iic.WriteEx(slaveAddress, FLAG_START, &regAddress, sizeof(regAddress), transferred);
+        auto ret = iic->WriteEx(slaveAddress, FLAG_START, &regAddress, sizeof(regAddress), transferred);
         fmt::print("Write START {}\n", ret == FT4222_OK ? "Success" : "Not Success");
         uint8_t readed[4];
-        ret = iic.ReadEx(slaveAddress, FLAG_START_AND_STOP, readed, sizeof(readed), transferred);
+        ret = iic->ReadEx(slaveAddress, FLAG_START_AND_STOP, readed, sizeof(readed), transferred);
         fmt::print("Read {}\n", ret == FT4222_OK ? "Success" : "Not Success");
         auto outstr = BufferToHex(readed, sizeof(readed));
         fmt::print("Register[{:02X}h] {}\n", regAddress, outstr);
         uint8 status = 0;
-        iic.GetStatus(status);
+        iic->GetStatus(status);
         PrintStatus(status);
     } catch (const FtdiException &e) {
         fmt::print(stderr, "FTDI error: {}\n", e.what());
         return RETURN_STATUS::FTDI_ERROR;
+    } catch (const std::out_of_range &e) {
+        fmt::print(stderr, "Error: {}\n", e.what());
+        return RETURN_STATUS::COMMANDLINE_ERROR;
     }
     return 0;
 }
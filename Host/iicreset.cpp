@@ -14,6 +14,8 @@
   * Аргументы командной строки:
   *  - -l --list: вывести список подключенных преобразователей USB-SPI/I2C FT4222
   *  - -d --device: номер преобразователя USB-SPI/I2C, по-умолчанию 0
+  *  - -s --socket: сокет lfsd, по-умолчанию $LFSD_SOCKET, $XDG_RUNTIME_DIR/lfsd.sock или /tmp/lfsd.sock.
+  *    Без lfsd - напрямую через FT4222
   */
 
 /** @} */
@@ -32,7 +34,8 @@ static cxxopts::ParseResult parse(int argc, char *argv[]) {
         options.add_options()
                 ("h,help", "Print help")
                 ("l,list", "List FTDI devices", cxxopts::value<bool>()->default_value("false"))
-                ("d,device", "FTDI device number, default 0", cxxopts::value<int>()->default_value("0"));
+                ("d,device", "FTDI device number, default 0", cxxopts::value<int>()->default_value("0"))
+                ("s,socket", "lfsd socket, empty - direct FTDI access", cxxopts::value<std::string>()->default_value(DaemonSocket()));
 
         auto result = options.parse(argc, argv);
         if (result.count("help")) {
@@ -57,8 +60,8 @@ int main(int argc, char *argv[]) {
     int devnum = opts["device"].as<int>();
     try {
         fmt::print("Using FTDI device number {}\n", devnum);
-        FtdiI2C iic(devnum);
-        iic.ResetBus();
+        auto iic = OpenI2c(devnum, opts["socket"].as<std::string>());
+        iic->ResetBus();
     } catch (const FtdiException &e) {
         fmt::print(stderr, "FTDI error: {}\n", e.what());
         return RETURN_STATUS::FTDI_ERROR;
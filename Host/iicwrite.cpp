@@ -14,15 +14,27 @@
   * Аргументы командной строки:
   *  - -l --list: вывести список подключенных преобразователей USB-SPI/I2C FT4222
   *  - -d --device: номер преобразователя USB-SPI/I2C, по-умолчанию 0
+  *  - -s --socket: сокет lfsd, по-умолчанию $LFSD_SOCKET, $XDG_RUNTIME_DIR/lfsd.sock или /tmp/lfsd.sock.
+  *    Без lfsd - напрямую через FT4222
   *  - -a --addr: адрес I2C ведомого устройства
   *  - -r --reg: адрес регистра ведомого устройства
+  *
+  * Запись образа во внешнюю EEPROM 24Cxx:
+  *  - -c --chip: микросхема из Tools/lists.py, --chips - список
+  *  - -f --file: файл образа
+  *  - -o --offset: адрес первой ячейки, по-умолчанию 0
+  *  - --no-verify: не проверять CRC-32 записанного
+  *  Без -a адрес I2C микросхемы 0x50
   */
 
 /** @} */
 
+#include <fstream>
 #include <iostream>
+#include <iterator>
 #include <fmt/core.h>
 #include <cxxopts.hpp>
+#include <Eeprom24.h>
 #include <FtdiI2C.h>
 #include <common.h>
 
@@ -35,8 +47,14 @@ static cxxopts::ParseResult parse(int argc, char *argv[]) {
                 ("h,help", "Print help")
                 ("l,list", "List FTDI devices", cxxopts::value<bool>()->default_value("false"))
                 ("d,device", "FTDI device number, default 0", cxxopts::value<int>()->default_value("0"))
+                ("s,socket", "lfsd socket, empty - direct FTDI access", cxxopts::value<std::string>()->default_value(DaemonSocket()))
                 ("a,addr", "I2C slave device address", cxxopts::value<uint8_t>()->default_value("12"))
-                ("r,reg", "Slave Register address", cxxopts::value<uint8_t>()->default_value("0"));
+                ("r,reg", "Slave Register address", cxxopts::value<uint8_t>()->default_value("0"))
+                ("c,chip", "EEPROM chip from Tools/lists.py", cxxopts::value<std::string>())
+                ("chips", "List EEPROM chips", cxxopts::value<bool>()->default_value("false"))
+                ("f,file", "EEPROM image file to program", cxxopts::value<std::string>())
+                ("o,offset", "EEPROM start address", cxxopts::value<uint32_t>()->default_value("0"))
+                ("no-verify", "Skip CRC verification", cxxopts::value<bool>()->default_value("false"));
 
         auto result = options.parse(argc, argv);
         if (result.count("help")) {
@@ -76,29 +94,82 @@ void PrintStatus(uint8 status) {
     }
 }
 
+/*
+ * Запись образа EEPROM по страницам и проверка CRC-32
+ */
+static int ProgramEeprom(I2cBus &iic, const EepromChip &chip, uint8_t address, const std::string &path,
+                         uint32_t offset, bool verify) {
+    std::ifstream file(path, std::ios::binary);
+    if (!file) {
+        fmt::print(stderr, "Cannot open {}\n", path);
+        return RETURN_STATUS::COMMANDLINE_ERROR;
+    }
+    std::vector<uint8_t> image((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
+
+    Eeprom24 eeprom(iic, chip, address);
+    fmt::print("Programming {} bytes to {} at 0x{:X}, page {} bytes\n", image.size(), chip.Model, offset, chip.PageSize);
+    eeprom.Write(offset, image.data(), image.size());
+    auto stats = eeprom.GetStats();
+    fmt::print("Written {} pages in {:.1f} ms, {:.0f} B/s, ACK polls {}\n", stats.Pages, stats.Elapsed.count() / 1000.0,
+               stats.Rate(), stats.Polls);
+    if (!verify)
+        return RETURN_STATUS::OK;
+
+    eeprom.ResetStats();
+    uint32_t crc = 0;
+    bool ok = eeprom.Verify(offset, image.data(), image.size(), crc);
+    stats = eeprom.GetStats();
+    fmt::print("Read back in {:.1f} ms, {:.0f} B/s\n", stats.Elapsed.count() / 1000.0, stats.Rate());
+    fmt::print("CRC32 file {:08X}, EEPROM {:08X}: {}\n", Eeprom24::Crc32(image.data(), image.size()), crc,
+               ok ? "OK" : "MISMATCH");
+    return ok ? RETURN_STATUS::OK : RETURN_STATUS::CRC_ERROR;
+}
+
 int main(int argc, char *argv[]) {
     auto opts = parse(argc, argv);
     if (opts.count("list")) {
         FtdiI2C::FindDevices(true);
         ::exit(RETURN_STATUS::OK);
     }
+    if (opts.count("chips")) {
+        for (const auto &chip : Eeprom24::Chips())
+            fmt::print("{:28} {:18} {:7} B, page {}\n", chip.Name, chip.Model, chip.Size, chip.PageSize);
+        ::exit(RETURN_STATUS::OK);
+    }
+
+    const EepromChip *chip = nullptr;
+    if (opts.count("file")) {
+        chip = opts.count("chip") ? Eeprom24::FindChip(opts["chip"].as<std::string>()) : nullptr;
+        if (!chip) {
+            fmt::print(stderr, "EEPROM chip required, see --chips\n");
+            return RETURN_STATUS::COMMANDLINE_ERROR;
+        }
+    }
 
     int devnum = opts["device"].as<int>();
     uint8_t slaveAddress = opts["addr"].as<uint8_t>();
     uint8_t regAddress = opts["reg"].as<uint8_t>();
     try {
         fmt::print("Using FTDI device number {}\n", devnum);
-        FtdiI2C iic(devnum);
+        auto iic = OpenI2c(devnum, opts["socket"].as<std::string>());
+        if (chip) {
+            uint8_t address = opts.count("addr") ? slaveAddress : Eeprom24::DefaultAddress;
+            return ProgramEeprom(*iic, *chip, address, opts["file"].as<std::string>(), opts["offset"].as<uint32_t>(),
+                                 !opts["no-verify"].as<bool>());
+        }
         uint8_t tx_buffer[] = {regAddress, 0xDE, 0xAD, 0xBE, 0xEF};
         uint16 written;
-        auto ret = iic.WriteEx(slaveAddress, FLAG_START_AND_STOP, tx_buffer, sizeof(tx_buffer), written);
+        auto ret = iic->WriteEx(slaveAddress, FLAG_START_AND_STOP, tx_buffer, sizeof(tx_buffer), written);
         fmt::print("Write START_AND_STOP {}\n", ret == FT4222_OK ? "Success" : "Not Success");
         uint8 status = 0;
-        iic.GetStatus(status);
+        iic->GetStatus(status);
         PrintStatus(status);
     } catch (const FtdiException &e) {
         fmt::print(stderr, "FTDI error: {}\n", e.what());
         return RETURN_STATUS::FTDI_ERROR;
+    } catch (const std::out_of_range &e) {
+        fmt::print(stderr, "Error: {}\n", e.what());
+        return RETURN_STATUS::COMMANDLINE_ERROR;
     }
     return 0;
 }
@@ -0,0 +1,81 @@
+#pragma once
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+#include "I2cBus.h"
+
+
+/**
+ * Параметры микросхемы 24Cxx, таблица повторяет chips из Tools/lists.py
+ */
+struct EepromChip {
+    const char *Name;           ///< Ключ в Tools/lists.py, например "microchip_24lc64"
+    const char *Vendor;
+    const char *Model;
+    uint32_t Size;              ///< Объём, байт
+    uint32_t PageSize;          ///< Страница записи, байт
+    bool PageWraparound;        ///< Запись за границу страницы переходит на её начало
+    uint8_t AddrBytes;          ///< Байт адреса ячейки. Старшие биты адреса сверх них - в младших битах адреса I2C
+    uint8_t AddrPins;           ///< Выводы A0..A2
+    uint16_t MaxSpeed;          ///< Наибольшая частота I2C, кГц
+};
+
+
+/**
+ * Чтение и запись внешней EEPROM 24Cxx блоками.
+ *
+ * Запись разбивается по границам страниц, адрес ячейки и данные страницы уходят одной посылкой START..STOP.
+ * Окончание внутреннего цикла записи определяется опросом ACK: микросхема не подтверждает свой адрес, пока
+ * пишет страницу. Чтение - адрес ячейки с START, данные с повторным START и STOP, последовательно до конца
+ * сегмента адресов (2^(8 * AddrBytes) байт), следующий сегмент - другим адресом I2C.
+ *
+ * Ошибки шины и отсутствие ответа микросхемы - FtdiException, выход за объём - std::out_of_range.
+ */
+class Eeprom24 {
+public:
+    static const uint8_t DefaultAddress = 0x50;
+    static const uint16_t MaxTransfer = 0x8000;     ///< Наибольшее чтение одной посылкой
+
+    struct Stats {
+        uint64_t Bytes;                             ///< Передано данных
+        uint32_t Transactions;                      ///< Посылок данных, без опроса ACK
+        uint32_t Pages;                             ///< Записано страниц
+        uint32_t Polls;                             ///< Опросов ACK, на которые микросхема не ответила
+        std::chrono::microseconds Elapsed;          ///< Время передачи, включая ожидание записи
+
+        double Rate() const {
+            return Elapsed.count() > 0 ? Bytes * 1e6 / Elapsed.count() : 0.0;
+        }
+    };
+
+    Eeprom24(I2cBus &bus, const EepromChip &chip, uint8_t address = DefaultAddress);
+
+    void Read(uint32_t offset, uint8_t *buffer, uint32_t size);
+    void Write(uint32_t offset, const uint8_t *data, uint32_t size);
+    bool Verify(uint32_t offset, const uint8_t *data, uint32_t size, uint32_t &crc);
+
+    void SetPollTimeout(std::chrono::milliseconds timeout) { m_xPollTimeout = timeout; }
+    const EepromChip &Chip() const { return m_xChip; }
+    Stats GetStats() const { return m_xStats; }
+    void ResetStats() { m_xStats = {0, 0, 0, 0, std::chrono::microseconds(0)}; }
+
+    static const std::vector<EepromChip> &Chips();
+    static const EepromChip *FindChip(const std::string &name);
+    static uint32_t Crc32(const uint8_t *data, size_t size, uint32_t crc = 0);
+
+private:
+    uint16_t SlaveAddress(uint32_t offset) const;
+    size_t EncodeAddress(uint32_t offset, uint8_t *buffer) const;
+    void CheckRange(uint32_t offset, uint32_t size) const;
+    void CheckAck(int status, bool transferred) const;
+    void WaitReady(uint32_t offset);
+
+    I2cBus &m_xBus;
+    const EepromChip m_xChip;
+    uint8_t m_uAddress;
+    uint32_t m_uSegment;                            ///< Байт на один адрес I2C
+    std::chrono::milliseconds m_xPollTimeout {50};
+    Stats m_xStats {0, 0, 0, 0, std::chrono::microseconds(0)};
+};
@@ -0,0 +1,42 @@
+#pragma once
+#include <cstddef>
+#include <vector>
+#include "Eeprom24.h"
+#include "I2cBus.h"
+
+
+/**
+ * Модель EEPROM 24Cxx на шине I2C: указатель ячейки из первых AddrBytes байт записи, старшие биты адреса -
+ * в младших битах адреса I2C, запись страницы с переходом на начало страницы, применяется по STOP. После записи
+ * микросхема не подтверждает адрес BusyPolls обращений - модель внутреннего цикла записи.
+ */
+class EepromSimulator : public I2cBus {
+public:
+    EepromSimulator(const EepromChip &chip, uint8_t address = Eeprom24::DefaultAddress, int busyPolls = 0);
+
+    int WriteEx(uint16_t slaveAddress, I2CFlag flag, uint8_t *buffer, uint16_t bufferSize, uint16_t &sizeTransferred) override;
+    int ReadEx(uint16_t slaveAddress, I2CFlag flag, uint8_t *buffer, uint16_t bufferSize, uint16_t &sizeTransferred) override;
+    int GetStatus(uint8_t &status) override;
+    int ResetBus() override;
+
+    std::vector<uint8_t> &Memory() { return m_vMemory; }
+    int WriteCycles() const { return m_iWriteCycles; }
+    void SetBusyPolls(int polls) { m_iBusyPolls = polls; }
+
+private:
+    bool Address(uint16_t slaveAddress, I2CFlag flag);
+    void Commit();
+
+    EepromChip m_xChip;
+    uint8_t m_uAddress;
+    int m_iBusyPolls;
+    int m_iBusy = 0;                        ///< Оставшиеся обращения без ACK
+    int m_iWriteCycles = 0;
+    uint8_t m_uStatus;
+    std::vector<uint8_t> m_vMemory;
+
+    uint32_t m_uSegment = 0;                ///< Старшие биты адреса из адреса I2C текущей посылки
+    uint32_t m_uPointer = 0;                ///< Указатель ячейки
+    size_t m_uAddressBytes = 0;             ///< Принято байт адреса ячейки в текущей посылке
+    std::vector<uint8_t> m_vPage;           ///< Данные записи до STOP
+};
@@ -0,0 +1,18 @@
+#pragma once
+#include <vector>
+#include <ftd2xx.h>
+
+
+/**
+ * Список преобразователей FT4222, общий для FtdiSpi и FtdiI2C.
+ *
+ * Перечисление и обращения к списку защищены мьютексом, поэтому адаптеры можно открывать из разных потоков.
+ * Номер устройства - индекс в списке после последнего Find()
+ */
+class FtdiDeviceList {
+public:
+    static int Find(bool show = false);
+    static int Count();
+    static DWORD Location(int device);
+    static std::vector<FT_DEVICE_LIST_INFO_NODE> Snapshot();
+};
@@ -0,0 +1,14 @@
+#pragma once
+#include <exception>
+
+
+class FtdiException : public std::exception {
+public:
+    explicit FtdiException(const char *message) : msg(message) {}
+    const char *what() const noexcept override {
+        return msg;
+    }
+
+private:
+    const char *msg;
+};
@@ -1,27 +1,20 @@
 #pragma once
 #include <ftd2xx.h>
 #include <LibFT4222.h>
+#include "I2cBus.h"
 
-enum I2CFlag {
-    FLAG_NONE = 0x80,
-    FLAG_START = 0x02,
-    FLAG_REPEATED_START = 0x03,
-    FLAG_STOP = 0x04,
-    FLAG_START_AND_STOP = 0x06
-};
-
-class FtdiI2C {
+class FtdiI2C : public I2cBus {
 public:
     explicit FtdiI2C(int device = 0);
-    ~FtdiI2C();
+    ~FtdiI2C() override;
 
     static int FindDevices(bool show = false);
     FT4222_STATUS Write(uint16_t slaveAddress, uint8 *buffer, uint16 bufferSize, uint16_t &sizeTransferred);
-    FT4222_STATUS WriteEx(uint16_t slaveAddress, I2CFlag flag, uint8 *buffer, uint16 bufferSize, uint16_t &sizeTransferred);
+    int WriteEx(uint16_t slaveAddress, I2CFlag flag, uint8_t *buffer, uint16_t bufferSize, uint16_t &sizeTransferred) override;
     FT4222_STATUS Read(uint16 slaveAddress, uint8 *buffer, uint16 bufferSize, uint16 &sizeTransferred);
-    FT4222_STATUS ReadEx(uint16 slaveAddress, I2CFlag flag, uint8 *buffer, uint16 bufferSize, uint16 &sizeTransferred);
-    FT4222_STATUS GetStatus(uint8 &status);
-    FT4222_STATUS ResetBus();
+    int ReadEx(uint16_t slaveAddress, I2CFlag flag, uint8_t *buffer, uint16_t bufferSize, uint16_t &sizeTransferred) override;
+    int GetStatus(uint8_t &status) override;
+    int ResetBus() override;
 
 
 private:
@@ -1,18 +1,23 @@
 #pragma once
+#include <vector>
 #include <ftd2xx.h>
 #include <LibFT4222.h>
+#include "SpiTransport.h"
 
 
-class FtdiSpi {
+class FtdiSpi : public SpiTransport {
 public:
     explicit FtdiSpi(int device = 0);
-    ~FtdiSpi();
+    ~FtdiSpi() override;
 
     static int FindDevices(bool show = false);
-    bool Write(uint8 *buffer, uint16 bufferSize, BOOL isEndTransaction);
-    bool Read(uint8 *buffer, uint16 bufferSize, BOOL isEndTransaction);
+    bool Write(uint8_t *buffer, uint16_t bufferSize, bool isEndTransaction) override;
+    bool Read(uint8_t *buffer, uint16_t bufferSize, bool isEndTransaction) override;
+    bool ReadWrite(uint8_t *readBuffer, uint8_t *writeBuffer, uint16_t bufferSize, bool isEndTransaction);
+    bool WriteRead(const uint8_t *command, uint16_t commandSize, uint8_t *response, uint16_t responseSize) override;
 
 private:
     int m_iDeviceNumber = 0;
     FT_HANDLE m_xHandle {};
+    std::vector<uint8> m_vTxBuffer;
 };
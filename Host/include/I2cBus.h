@@ -0,0 +1,27 @@
+#pragma once
+#include <cstdint>
+
+
+enum I2CFlag {
+    FLAG_NONE = 0x80,
+    FLAG_START = 0x02,
+    FLAG_REPEATED_START = 0x03,
+    FLAG_STOP = 0x04,
+    FLAG_START_AND_STOP = 0x06
+};
+
+
+/**
+ * Ведущий I2C. Реализации: FtdiI2C - адаптер FT4222, I2cSimulator - модель ведомого, SocketI2c - через lfsd.
+ *
+ * Методы возвращают код FT4222_STATUS, 0 - FT4222_OK. Биты status - как у FT4222_I2CMaster_GetStatus.
+ */
+class I2cBus {
+public:
+    virtual ~I2cBus() = default;
+
+    virtual int WriteEx(uint16_t slaveAddress, I2CFlag flag, uint8_t *buffer, uint16_t bufferSize, uint16_t &sizeTransferred) = 0;
+    virtual int ReadEx(uint16_t slaveAddress, I2CFlag flag, uint8_t *buffer, uint16_t bufferSize, uint16_t &sizeTransferred) = 0;
+    virtual int GetStatus(uint8_t &status) = 0;
+    virtual int ResetBus() = 0;
+};
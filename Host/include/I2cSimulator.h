@@ -0,0 +1,33 @@
+#pragma once
+#include <cstddef>
+#include <vector>
+#include "I2cBus.h"
+
+
+/**
+ * Модель ведомого I2C из IICSlaveTask: первый принятый после START байт - адрес регистра, чтение отдаёт
+ * тестовые данные по кругу с начала после каждого START. Чужой адрес не подтверждается.
+ */
+class I2cSimulator : public I2cBus {
+public:
+    static const uint16_t DefaultAddress = 0x37;
+
+    explicit I2cSimulator(uint16_t slaveAddress = DefaultAddress);
+
+    int WriteEx(uint16_t slaveAddress, I2CFlag flag, uint8_t *buffer, uint16_t bufferSize, uint16_t &sizeTransferred) override;
+    int ReadEx(uint16_t slaveAddress, I2CFlag flag, uint8_t *buffer, uint16_t bufferSize, uint16_t &sizeTransferred) override;
+    int GetStatus(uint8_t &status) override;
+    int ResetBus() override;
+
+    uint8_t RegisterAddress() const { return m_uRegister; }
+    const std::vector<uint8_t> &Received() const { return m_vReceived; }
+
+private:
+    bool Address(uint16_t slaveAddress, I2CFlag flag);
+
+    uint16_t m_uAddress;
+    uint8_t m_uStatus;
+    uint8_t m_uRegister = 0;
+    size_t m_uTxIndex = 0;
+    std::vector<uint8_t> m_vReceived;
+};
@@ -1,12 +1,15 @@
 #pragma once
+#include <array>
 #include <exception>
-#include "FtdiSpi.h"
+#include <utility>
+#include "LfShadowCache.h"
+#include "SpiTransport.h"
 #include "commands.h"
 
 
 class LFSmart {
 public:
-    explicit LFSmart(FtdiSpi &spi, bool crc, int tries = 1);
+    explicit LFSmart(SpiTransport &spi, bool crc, int tries = 1);
     uint16_t Whoiam();
     uint16_t Status();
     lfc::LastError LastError();
@@ -16,6 +19,7 @@ public:
     uint16_t ReadDacChannel(lfc::Channel channel);
     uint16_t ReadAdcChannel(lfc::Channel channel);
     void ReadAdcAll(uint16_t *channels);
+    void ReadGroup(const lfc::RegisterGroup &group, uint16_t *values);
 
     uint16_t WriteDacDefault(lfc::Channel channel, uint16_t value, bool readback);
     uint16_t WriteDacDefault(lfc::Channel channel, double value, bool readback);
@@ -35,9 +39,36 @@ public:
     uint16_t Version();
     std::pair<uint32_t, uint32_t> ReadCRC();
 
+    /**
+     * Чтение регистра по типу из register_map.h, например Read<lfc::reg::CRC_HW>() - uint32_t
+     * @return Значение типа регистра
+     */
+    template <typename R>
+    typename R::Type Read() {
+        static_assert(R::Access & lfc::ACCESS_READ, "Register is write-only");
+        typename R::Type value;
+        ReadTyped(R::Address, value);
+        return value;
+    }
+
+    /**
+     * Запись регистра по типу из register_map.h, например Write<lfc::reg::SVC>(LF_SVC_RESET)
+     * @param value typename R::Type - значение, записываемые регистры 16-битные
+     */
+    template <typename R>
+    void Write(typename R::Type value) {
+        static_assert(R::Access & lfc::ACCESS_WRITE, "Register is read-only");
+        WriteRegister16b(R::Address, value, m_bUseCRC);
+    }
+
     uint16_t WriteRaw(uint8_t command, uint16_t value, bool readback);
     uint16_t ReadRaw(uint8_t command);
 
+    void EnableCache(bool enable);
+    bool CacheEnabled() const { return m_bCache; }
+    bool ValidateCache();
+    LfShadowCache &Cache() { return m_xCache; }
+
     static double AdcRawToReal(uint16_t raw);
     static double DacRawToReal(uint16_t raw);
     static uint16_t DacRealToRaw(double real_value);
@@ -47,13 +78,21 @@ public:
     static uint16_t WhoiamExpected() { return 0x1234; }
 
 private:
-    uint16_t ReadRegister16b(lfc::Registers cmd, bool crc);
+    uint16_t ReadRegister16b(lfc::Registers cmd, bool crc, bool cached = true);
     void WriteRegister16b(lfc::Registers cmd, uint16_t value, bool crc);
-    uint32_t LFSmart::ReadRegister32b(lfc::Registers cmd, bool crc);
+    uint32_t ReadRegister32b(lfc::Registers cmd, bool crc);
+    void ReadBlock(lfc::Registers cmd, uint16_t *values, size_t count);
+
+    void ReadTyped(lfc::Registers cmd, uint16_t &value) { value = ReadRegister16b(cmd, m_bUseCRC); }
+    void ReadTyped(lfc::Registers cmd, uint32_t &value) { value = ReadRegister32b(cmd, m_bUseCRC); }
+    template <size_t N>
+    void ReadTyped(lfc::Registers cmd, std::array<uint16_t, N> &value) { ReadBlock(cmd, value.data(), N); }
 
-    FtdiSpi &m_xSpi;
+    SpiTransport &m_xSpi;
     bool m_bUseCRC;
     int m_iTries;
+    bool m_bCache = false;
+    LfShadowCache m_xCache;
 };
 
 
@@ -0,0 +1,86 @@
+#pragma once
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <exception>
+#include <functional>
+#include <future>
+#include <mutex>
+#include <thread>
+#include <vector>
+#include "SpiTransport.h"
+#include "commands.h"
+
+
+/**
+ * Асинхронный доступ к 16-битным регистрам НЧ драйвера.
+ *
+ * Операции ставятся в очередь и выполняются отдельным потоком в порядке постановки. Поток забирает из очереди
+ * пакет: сначала записи, затем чтения, до первой записи после чтения или до maxBatch операций, и передаёт его
+ * одним вызовом SpiTransport::Transfer. Поэтому повтор чтения с ошибкой CRC в следующем пакете видит то же
+ * состояние устройства, что и первая попытка, и порядок записей относительно чтений сохраняется.
+ *
+ * Обработчики вызываются из потока очереди, исключения транспорта передаются в future или обработчик. Исключение
+ * самого обработчика не выходит из потока очереди: первое сохраняется и выбрасывается из Flush().
+ */
+class LFSmartAsync {
+public:
+    using ReadCallback = std::function<void(uint16_t value, std::exception_ptr error)>;
+    using WriteCallback = std::function<void(std::exception_ptr error)>;
+
+    struct Stats {
+        uint64_t Operations;        ///< Выполнено операций
+        uint64_t Batches;           ///< Вызовов SpiTransport::Transfer
+        uint64_t Retries;           ///< Повторов чтения после ошибки CRC
+    };
+
+    explicit LFSmartAsync(SpiTransport &spi, bool crc, int tries = 1, size_t maxBatch = 32);
+    ~LFSmartAsync();
+
+    LFSmartAsync(const LFSmartAsync &) = delete;
+    LFSmartAsync &operator=(const LFSmartAsync &) = delete;
+
+    std::future<uint16_t> Read(lfc::Registers reg);
+    std::future<void> Write(lfc::Registers reg, uint16_t value);
+    void Read(lfc::Registers reg, ReadCallback callback);
+    void Write(lfc::Registers reg, uint16_t value, WriteCallback callback);
+
+    void Flush();
+    Stats GetStats() const;
+
+private:
+    struct Operation {
+        lfc::Access Access;
+        lfc::Registers Register;
+        uint16_t Value;
+        int Tries;
+        ReadCallback OnRead;
+        WriteCallback OnWrite;
+        uint8_t Frame[4];
+        uint8_t Response[3];
+    };
+
+    void Enqueue(Operation &&operation);
+    void Execute();
+    void Process(std::vector<Operation> &batch);
+    void Complete(Operation &operation, uint16_t value, std::exception_ptr error);
+
+    SpiTransport &m_xSpi;
+    bool m_bUseCRC;
+    int m_iTries;
+    size_t m_uMaxBatch;
+
+    std::mutex m_xMutex;
+    std::condition_variable m_xWork;
+    std::condition_variable m_xIdle;
+    std::deque<Operation> m_dQueue;
+    size_t m_uInFlight = 0;
+    bool m_bStop = false;
+    std::exception_ptr m_xCallbackError;
+
+    std::atomic<uint64_t> m_uOperations {0};
+    std::atomic<uint64_t> m_uBatches {0};
+    std::atomic<uint64_t> m_uRetries {0};
+
+    std::thread m_xThread;
+};
@@ -0,0 +1,66 @@
+#pragma once
+#include <string>
+#include <vector>
+#include "I2cBus.h"
+#include "SpiTransport.h"
+#include "json.hpp"
+
+
+/**
+ * Соединение с lfsd. Ошибки из ответа сервера превращаются в FtdiException и LFSmartException,
+ * поэтому утилиты обрабатывают их так же, как при прямой работе с адаптером.
+ */
+class LfClient {
+public:
+    explicit LfClient(const std::string &socketPath);
+    ~LfClient();
+
+    LfClient(const LfClient &) = delete;
+    LfClient &operator=(const LfClient &) = delete;
+
+    nlohmann::json Call(const nlohmann::json &request);
+
+    static std::string DefaultSocket();
+
+private:
+    int m_iSocket = -1;
+    std::string m_sPending;
+};
+
+
+/**
+ * SPI адаптера через lfsd. Транзакция копится до isEndTransaction и передаётся одним запросом,
+ * Transfer передаёт весь пакет одним запросом spi_batch
+ */
+class SocketSpi : public SpiTransport {
+public:
+    SocketSpi(const std::string &socketPath, int device);
+
+    bool Write(uint8_t *buffer, uint16_t bufferSize, bool isEndTransaction) override;
+    bool Read(uint8_t *buffer, uint16_t bufferSize, bool isEndTransaction) override;
+    bool WriteRead(const uint8_t *command, uint16_t commandSize, uint8_t *response, uint16_t responseSize) override;
+    bool Transfer(const Transaction *transactions, size_t count) override;
+
+private:
+    LfClient m_xClient;
+    int m_iDevice;
+    std::vector<uint8_t> m_vTx;
+};
+
+
+/**
+ * I2C адаптера через lfsd
+ */
+class SocketI2c : public I2cBus {
+public:
+    SocketI2c(const std::string &socketPath, int device);
+
+    int WriteEx(uint16_t slaveAddress, I2CFlag flag, uint8_t *buffer, uint16_t bufferSize, uint16_t &sizeTransferred) override;
+    int ReadEx(uint16_t slaveAddress, I2CFlag flag, uint8_t *buffer, uint16_t bufferSize, uint16_t &sizeTransferred) override;
+    int GetStatus(uint8_t &status) override;
+    int ResetBus() override;
+
+private:
+    LfClient m_xClient;
+    int m_iDevice;
+};
@@ -0,0 +1,78 @@
+#pragma once
+#include <chrono>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+#include "LFSmart.h"
+#include "SpiTransport.h"
+
+
+/**
+ * Параллельная работа с несколькими НЧ драйверами, каждый на своём адаптере.
+ *
+ * Open() открывает адаптеры одновременно, Run() выполняет сценарий для каждой платы. Задачи выполняет пул
+ * потоков, одна плата в каждый момент обслуживается одним потоком, поэтому сценарию не нужна синхронизация
+ * для своей платы. Результаты и время собираются по каждой плате. Плата, которая не открылась, в Run() не участвует.
+ */
+class LfFleet {
+public:
+    using Opener = std::function<std::unique_ptr<SpiTransport>(int device)>;
+    using Script = std::function<void(int device, LFSmart &lf)>;
+
+    struct BoardResult {
+        int Device;                             ///< Номер адаптера
+        bool Ok;                                ///< false - исключение, текст в Error
+        bool CrcError;                          ///< Исключение LFSmartException с ошибкой CRC
+        std::string Error;                      ///< Текст исключения
+        std::chrono::microseconds Time;         ///< Время открытия или выполнения сценария
+    };
+
+    struct Report {
+        std::vector<BoardResult> Boards;        ///< В порядке номеров адаптеров
+        size_t Succeeded;
+        size_t Failed;
+        std::chrono::microseconds Elapsed;      ///< Время от постановки первой задачи до завершения последней
+    };
+
+    explicit LfFleet(Opener opener, bool crc = true, int tries = 3, size_t threads = 0);
+    ~LfFleet();
+    LfFleet(const LfFleet &) = delete;
+    LfFleet &operator=(const LfFleet &) = delete;
+
+    Report Open(const std::vector<int> &devices);
+    Report Open(int count);
+    Report Run(const Script &script);
+
+    size_t Size() const { return m_vBoards.size(); }
+    size_t Threads() const { return m_vWorkers.size(); }
+
+private:
+    struct Board {
+        int Device;
+        std::unique_ptr<SpiTransport> Spi;
+        std::unique_ptr<LFSmart> Lf;
+    };
+
+    using Job = std::function<void(BoardResult &)>;
+
+    Report Execute(const std::vector<int> &devices, const std::vector<Job> &jobs);
+    void Worker();
+
+    Opener m_xOpener;
+    bool m_bUseCRC;
+    int m_iTries;
+    std::vector<std::unique_ptr<Board>> m_vBoards;
+
+    std::vector<std::thread> m_vWorkers;
+    std::mutex m_xMutex;
+    std::condition_variable m_xWork;
+    std::condition_variable m_xDone;
+    std::deque<std::function<void()>> m_qJobs;
+    size_t m_uPending = 0;
+    bool m_bStop = false;
+};
@@ -0,0 +1,57 @@
+#pragma once
+#include <map>
+#include <string>
+#include "I2cBus.h"
+#include "SpiTransport.h"
+#include "json.hpp"
+
+
+/**
+ * Источник устройств для LfServer. Устройства открываются при первом запросе и остаются открытыми.
+ */
+class LfDeviceProvider {
+public:
+    virtual ~LfDeviceProvider() = default;
+
+    virtual SpiTransport &Spi(int device) = 0;
+    virtual I2cBus &I2c(int device) = 0;
+};
+
+
+/**
+ * Сервер lfsd: владеет адаптерами FT4222 и выполняет запросы клиентов через Unix domain socket.
+ *
+ * Протокол - JSON по строке на запрос и ответ. Запросы:
+ *  - {"op":"ping"} -> {"ok":true,"version":1}
+ *  - {"op":"spi","dev":0,"tx":[..],"rx":N} -> {"ok":true,"rx":[..]} - одна транзакция SPI
+ *  - {"op":"spi_batch","dev":0,"transactions":[{"tx":[..],"rx":N},..]} -> {"ok":true,"rx":[[..],..]}
+ *  - {"op":"i2c_write","dev":0,"addr":A,"flag":F,"data":[..]} -> {"ok":true,"status":S,"transferred":N}
+ *  - {"op":"i2c_read","dev":0,"addr":A,"flag":F,"size":N} -> {"ok":true,"status":S,"data":[..]}
+ *  - {"op":"i2c_status","dev":0} -> {"ok":true,"status":S,"value":V}
+ *  - {"op":"i2c_reset","dev":0} -> {"ok":true,"status":S}
+ *
+ * Ошибка: {"ok":false,"kind":"ftdi"|"lfsmart"|"request","error":"...","crc":false}. Запросы клиентов
+ * выполняются по очереди, устройство одно на всех.
+ */
+class LfServer {
+public:
+    static const int ProtocolVersion = 1;
+
+    LfServer(LfDeviceProvider &devices, const std::string &socketPath);
+    ~LfServer();
+
+    void Run();
+    void Stop();
+
+    nlohmann::json Handle(const nlohmann::json &request);
+
+private:
+    void Accept();
+    bool Serve(int client);
+
+    LfDeviceProvider &m_xDevices;
+    std::string m_sSocketPath;
+    int m_iListen = -1;
+    int m_aWakeup[2] = {-1, -1};
+    std::map<int, std::string> m_mClients;          ///< Сокет клиента -> принятые байты без конца строки
+};
@@ -0,0 +1,67 @@
+#pragma once
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include "commands.h"
+
+
+/**
+ * Теневые копии регистров НЧ драйвера для LFSmart.
+ *
+ * Политики регистров по-умолчанию:
+ *  - POLICY_CONSTANT - не меняется до сброса: WHOIAM, VERSION, CRC_HW, CRC_SW. Читается один раз
+ *  - POLICY_WRITE_THROUGH - меняется только записью хоста: DAC_CH*, DAC_DEFAULT_CH*, DAC_MAX_CH*.
+ *    Записанное значение DAC_CH* запоминается с учётом ограничения DAC_MAX_CH*, только если известен
+ *    максимум канала и устройство заведомо включено (STATUS прочитан или была команда SVC START)
+ *  - POLICY_VOLATILE - меняется устройством: STATUS, LAST_ERROR, ADC_*, THRM_*, CERT. Всегда читается
+ *
+ * Копии верны, пока LFSmart - единственный, кто пишет в устройство. SVC RESET очищает все копии,
+ * ненулевой LAST_ERROR - копии POLICY_WRITE_THROUGH: устройство выполнило запись не так, как ожидалось.
+ */
+class LfShadowCache {
+public:
+    enum Policy {
+        POLICY_VOLATILE,
+        POLICY_CONSTANT,
+        POLICY_WRITE_THROUGH
+    };
+
+    struct Stats {
+        uint64_t Hits;              ///< Чтения без обмена с устройством
+        uint64_t Misses;            ///< Чтения кэшируемых регистров с обменом
+        uint64_t Invalidations;     ///< Очистки после сброса, ошибки устройства или несовпадения WHOIAM/VERSION
+    };
+
+    LfShadowCache();
+
+    static Policy DefaultPolicy(lfc::Registers reg);
+    void SetPolicy(lfc::Registers reg, Policy policy);
+    Policy GetPolicy(lfc::Registers reg) const;
+
+    bool Lookup(lfc::Registers reg, uint32_t &value);
+    bool Peek(lfc::Registers reg, uint32_t &value) const;
+    void Fill(lfc::Registers reg, uint32_t value);
+    void Written(lfc::Registers reg, uint16_t value);
+    void DeviceError();
+    void Invalidate();
+
+    Stats GetStats() const { return m_xStats; }
+    void ResetStats() { m_xStats = {0, 0, 0}; }
+
+private:
+    static const size_t Size = lfc::REGISTER_COUNT;
+
+    struct Entry {
+        Policy Mode;
+        bool Valid;
+        uint32_t Value;
+    };
+
+    void Store(int reg, uint32_t value);
+    void Drop(int reg);
+
+    std::array<Entry, Size> m_aEntries;
+    bool m_bActiveKnown = false;
+    bool m_bActive = false;
+    Stats m_xStats {0, 0, 0};
+};
@@ -0,0 +1,93 @@
+#pragma once
+#include <array>
+#include <chrono>
+#include <random>
+#include <vector>
+#include "SpiTransport.h"
+#include "commands.h"
+
+
+/**
+ * Модель НЧ драйвера на SPI в процессе, без адаптера и платы.
+ *
+ * Реализует регистры lfc::Registers: ограничение DAC_CH* значением DAC_MAX_CH* с LE_DAC_TRUNCATE, LE_DAC_OVERFLOW,
+ * очистку LAST_ERROR чтением, маски SAVE_EEP, сброс и START/STOP через SVC, кадры с CRC8. Сброс выполняется мгновенно,
+ * энергонезависимые значения сохраняются.
+ *
+ * Каждый вызов Write/Read/WriteRead/Transfer считается одним обменом по USB с задержкой Options::Latency, пакет
+ * Transfer моделирует адаптер, который передаёт несколько транзакций одной посылкой. Options::FtdiExchanges
+ * моделирует FtdiSpi: WriteRead - запись команды и чтение ответа отдельными обменами, Transfer - по одной транзакции
+ * реализацией SpiTransport по умолчанию. Задержка
+ * накапливается в SimulatedTime(), спать по-настоящему только при Options::RealTime. Ошибки линии - инверсия
+ * каждого бита MOSI или MISO с вероятностью Options::MosiBitErrorRate и Options::MisoBitErrorRate, генератор с
+ * зерном Options::Seed, поэтому прогоны с одинаковыми параметрами повторяются.
+ */
+class LfSimulator : public SpiTransport {
+public:
+    struct Options {
+        std::chrono::microseconds Latency {0};  ///< Время одного обмена по USB
+        bool RealTime = false;                  ///< true - выдерживать Latency, false - только учитывать
+        bool FtdiExchanges = false;             ///< true - обмены по USB как у FtdiSpi, без пакетов Transfer
+        double MosiBitErrorRate = 0.0;          ///< Вероятность инверсии бита от адаптера к устройству
+        double MisoBitErrorRate = 0.0;          ///< Вероятность инверсии бита от устройства к адаптеру
+        uint32_t Seed = 1;                      ///< Зерно генератора ошибок
+        uint16_t Version = 200;                 ///< Регистр VERSION, LFSmart::MakeVersion(0, 2, 0)
+    };
+
+    LfSimulator();
+    explicit LfSimulator(const Options &options);
+
+    bool Write(uint8_t *buffer, uint16_t bufferSize, bool isEndTransaction) override;
+    bool Read(uint8_t *buffer, uint16_t bufferSize, bool isEndTransaction) override;
+    bool WriteRead(const uint8_t *command, uint16_t commandSize, uint8_t *response, uint16_t responseSize) override;
+    bool Transfer(const Transaction *transactions, size_t count) override;
+
+    void SetAdc(lfc::Channel channel, uint16_t value);
+    void SetTemperature(uint16_t pcb, uint16_t mcu);
+    void SetBitErrorRate(double mosi, double miso) { m_xOptions.MosiBitErrorRate = mosi; m_xOptions.MisoBitErrorRate = miso; }
+    uint16_t Dac(lfc::Channel channel) const { return m_aDac[channel]; }
+
+    uint64_t Transfers() const { return m_uTransfers; }
+    uint64_t Transactions() const { return m_uTransactions; }
+    uint64_t BitErrors() const { return m_uBitErrors; }
+    std::chrono::microseconds SimulatedTime() const { return m_xSimulatedTime; }
+
+private:
+    void RoundTrip();
+    uint8_t Exchange(uint8_t mosi);
+    uint8_t Corrupt(uint8_t byte, double rate);
+    void EndTransaction();
+
+    std::vector<uint8_t> ReadRegister(uint8_t reg);
+    void WriteRegister(uint8_t reg, uint16_t value);
+    void WriteDac(int channel, uint16_t value);
+    void Reset();
+
+    Options m_xOptions;
+    std::mt19937 m_xRandom;
+    std::uniform_real_distribution<double> m_xUniform {0.0, 1.0};
+
+    // Текущая транзакция
+    std::vector<uint8_t> m_vMosi;
+    std::vector<uint8_t> m_vResponse;
+
+    // Регистры
+    std::array<uint16_t, 4> m_aDac {};
+    std::array<uint16_t, 4> m_aDacDefault {};
+    std::array<uint16_t, 4> m_aDacMax {};
+    std::array<uint16_t, 4> m_aAdc {};
+    uint16_t m_uStatus = 0;
+    uint16_t m_uLastError = lfc::LastError::LE_NOERROR;
+    uint16_t m_uThermPcb = 300;
+    uint16_t m_uThermMcu = 310;
+    uint16_t m_uCert = 0;
+
+    // Энергонезависимая память
+    std::array<uint16_t, 4> m_aNvDefault {};
+    std::array<uint16_t, 4> m_aNvMax {};
+
+    uint64_t m_uTransfers = 0;
+    uint64_t m_uTransactions = 0;
+    uint64_t m_uBitErrors = 0;
+    std::chrono::microseconds m_xSimulatedTime {0};
+};
@@ -0,0 +1,100 @@
+#pragma once
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+#include "SpiTransport.h"
+
+
+/**
+ * Обновление прошивки НЧ драйвера по SPI, протокол Middlewares/iap/iap_engine.h.
+ *
+ * Устройство переводится в режим обновления битом LF_SVC_UPDATE регистра SVC, после этого оно не отвечает на
+ * регистры до сброса. Образ - .bin после Tools/append_crc.py, последнее слово - CRC-32/MPEG-2 остальных байт.
+ *
+ * Данные уходят пачками кадров одной транзакцией, ответ читается отдельной транзакцией из FIFO передатчика
+ * устройства. В ответе - сколько принято подряд и сколько свободно в кольце устройства, следующая пачка
+ * начинается с принятого: потерянный кадр передаётся заново вместе со всеми после него. Пока кольцо занято,
+ * хост только опрашивает ответ, скорость задаёт flash устройства.
+ *
+ * Неверный образ - std::invalid_argument, отказ устройства или отсутствие ответа - std::runtime_error.
+ */
+class LfUpdater {
+public:
+    static const uint16_t FrameSize = 64;
+    static const uint16_t FrameData = 52;               ///< Байт данных в кадре
+    static const uint16_t ReplySize = 8;
+    static const size_t MaxBurstFrames = 16;            ///< Кадров в одной транзакции, 1 КиБ
+
+    enum Command : uint8_t {
+        CMD_BEGIN = 0x01,
+        CMD_DATA = 0x02,
+        CMD_STATUS = 0x03,
+        CMD_RESET = 0x04,
+    };
+
+    /// Результат последнего кадра, как IapStatus прошивки
+    enum Status : uint8_t {
+        OK = 0,
+        BUSY,
+        BAD_FRAME,
+        BAD_OFFSET,
+        BAD_SIZE,
+        BAD_STATE,
+        PROGRAM_ERROR,
+        VERIFY_ERROR,
+    };
+
+    /// Состояние устройства, как IapState прошивки
+    enum State : uint8_t {
+        IDLE = 0,
+        RECEIVING,
+        VERIFYING,
+        DONE,
+        FAILED,
+    };
+
+    struct Reply {
+        uint8_t Sequence;                               ///< Последний принятый кадр
+        Status Result;
+        State Progress;
+        uint32_t Received;                              ///< Принято байт подряд с начала образа
+        uint32_t Free;                                  ///< Свободно байт в кольце
+    };
+
+    struct Stats {
+        uint64_t Bytes;                                 ///< Размер образа
+        uint64_t Frames;                                ///< Передано кадров данных
+        uint64_t Retransmits;                           ///< Из них повторно
+        uint64_t Polls;                                 ///< Чтений ответа
+        uint64_t BadReplies;                            ///< Ответов с неверной CRC или устаревших
+        std::chrono::microseconds Elapsed;
+
+        double Rate() const {
+            return Elapsed.count() > 0 ? Bytes * 1e6 / Elapsed.count() : 0.0;
+        }
+    };
+
+    explicit LfUpdater(SpiTransport &spi) : m_xSpi(spi) {}
+
+    Stats Update(const std::vector<uint8_t> &image);
+    void Reset();
+    void SetPollLimit(uint32_t polls) { m_uPollLimit = polls; }
+
+    static uint32_t Crc32(const uint8_t *data, size_t size, uint32_t crc = 0xFFFFFFFF);
+    static bool CheckImage(const std::vector<uint8_t> &image, uint32_t &crc);
+    static void MakeFrame(uint8_t *frame, Command command, uint8_t sequence, uint32_t argument,
+                          const uint8_t *data = nullptr, uint8_t length = 0);
+    static bool ParseReply(const uint8_t *reply, Reply &parsed);
+    static std::string StatusName(Status status);
+
+private:
+    void Send(std::vector<uint8_t> &frames);
+    Reply Wait();
+
+    SpiTransport &m_xSpi;
+    uint8_t m_uSequence = 0;
+    uint32_t m_uPollLimit = 50000;                      ///< Опросов подряд без продвижения до ошибки
+    Stats m_xStats {0, 0, 0, 0, 0, std::chrono::microseconds(0)};
+};
@@ -0,0 +1,50 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+
+
+/**
+ * Транспорт SPI до НЧ драйвера. Реализации: FtdiSpi - адаптер FT4222, LfSimulator - модель устройства в процессе.
+ *
+ * Транзакция - байты от установки SS до его снятия: isEndTransaction = true снимает SS после передачи.
+ */
+class SpiTransport {
+public:
+    virtual ~SpiTransport() = default;
+
+    virtual bool Write(uint8_t *buffer, uint16_t bufferSize, bool isEndTransaction) = 0;
+    virtual bool Read(uint8_t *buffer, uint16_t bufferSize, bool isEndTransaction) = 0;
+
+    /**
+     * Команда и ответ при одном выборе ведомого, во время ответа передаются нули. Число обменов с адаптером
+     * зависит от реализации: FtdiSpi передаёт команду и читает ответ двумя обменами по USB
+     * @param command const uint8_t* - байты команды
+     * @param commandSize uint16_t - размер команды
+     * @param response uint8_t* - ответ, байты после команды
+     * @param responseSize uint16_t - размер ответа
+     * @return true, если передана вся транзакция
+     */
+    virtual bool WriteRead(const uint8_t *command, uint16_t commandSize, uint8_t *response, uint16_t responseSize) = 0;
+
+    /// Транзакция пакета: Tx передаётся, затем принимается RxSize байт
+    struct Transaction {
+        const uint8_t *Tx;
+        uint16_t TxSize;
+        uint8_t *Rx;
+        uint16_t RxSize;
+    };
+
+    /**
+     * Пакет транзакций в заданном порядке. Реализация по умолчанию выполняет их по одной через WriteRead:
+     * FT4222 в режиме single SPI не умеет ставить в одну посылку USB несколько транзакций с переключением SS.
+     * @param transactions const Transaction* - транзакции
+     * @param count size_t - количество транзакций
+     * @return true, если переданы все транзакции
+     */
+    virtual bool Transfer(const Transaction *transactions, size_t count) {
+        bool complete = true;
+        for (size_t i = 0; i < count; i++)
+            complete &= WriteRead(transactions[i].Tx, transactions[i].TxSize, transactions[i].Rx, transactions[i].RxSize);
+        return complete;
+    }
+};
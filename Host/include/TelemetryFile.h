@@ -0,0 +1,109 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <ostream>
+#include <string>
+#include <vector>
+#include "json.hpp"
+
+
+/**
+ * Файл телеметрии: записи фиксированной ширины, хранение по столбцам.
+ *
+ * Формат (little-endian):
+ *  - TelemetryFile::Header, 64 байта: сигнатура "LFTM", версия формата, размер метаданных, количество записей
+ *  - метаданные JSON: {"columns":[{"name":..,"width":..},..],...} и произвольные поля записывающего
+ *  - блоки с DataOffset (кратно 4096): в блоке BlockSamples записей, внутри блока столбцы подряд,
+ *    столбец - BlockSamples значений шириной 1, 2, 4 или 8 байт
+ *
+ * Количество записей в заголовке обновляется после каждой записи, поэтому файл читается и во время записи,
+ * и после аварийного завершения.
+ */
+namespace TelemetryFile {
+
+    struct Header {
+        char Magic[4];              ///< "LFTM"
+        uint32_t FormatVersion;     ///< TelemetryFile::FormatVersion
+        uint32_t MetaSize;          ///< Размер метаданных JSON после заголовка
+        uint32_t BlockSamples;      ///< Записей в блоке
+        uint64_t Samples;           ///< Записано записей
+        uint64_t DataOffset;        ///< Смещение первого блока
+        uint64_t BlockSize;         ///< Размер блока в байтах
+        uint32_t Columns;           ///< Количество столбцов
+        uint8_t Reserved[20];
+    };
+    static_assert(sizeof(Header) == 64, "Header size");
+
+    static const uint32_t FormatVersion = 1;
+
+    struct Column {
+        std::string Name;
+        uint32_t Width;             ///< 1, 2, 4 или 8 байт
+    };
+}
+
+
+/**
+ * Запись файла телеметрии через отображение в память. Файл растёт блоками, удвоением отображённой области
+ */
+class TelemetryWriter {
+public:
+    TelemetryWriter(const std::string &path, const std::vector<TelemetryFile::Column> &columns,
+                    const nlohmann::json &meta, uint32_t blockSamples = 4096);
+    ~TelemetryWriter();
+    TelemetryWriter(const TelemetryWriter &) = delete;
+    TelemetryWriter &operator=(const TelemetryWriter &) = delete;
+
+    void Append(const uint64_t *values);
+    void Close();
+    uint64_t Samples() const { return m_uSamples; }
+
+private:
+    void Map(uint64_t blocks);
+
+    int m_iFile = -1;
+    uint8_t *m_pMap = nullptr;
+    size_t m_uMapSize = 0;
+    uint64_t m_uBlocks = 0;
+    uint64_t m_uSamples = 0;
+    uint32_t m_uBlockSamples;
+    uint64_t m_uDataOffset = 0;
+    uint64_t m_uBlockSize = 0;
+    std::vector<uint32_t> m_vWidths;
+    std::vector<uint64_t> m_vColumnOffsets;    ///< Смещение столбца внутри блока
+};
+
+
+/**
+ * Чтение файла телеметрии, файл отображается в память только для чтения
+ */
+class TelemetryReader {
+public:
+    explicit TelemetryReader(const std::string &path);
+    ~TelemetryReader();
+    TelemetryReader(const TelemetryReader &) = delete;
+    TelemetryReader &operator=(const TelemetryReader &) = delete;
+
+    const nlohmann::json &Meta() const { return m_xMeta; }
+    const std::vector<TelemetryFile::Column> &Columns() const { return m_vColumns; }
+    int FindColumn(const std::string &name) const;
+    uint64_t Samples() const { return m_uSamples; }
+
+    uint64_t Value(size_t column, uint64_t sample) const;
+    std::vector<uint64_t> Column(size_t column) const;
+    void ExportCsv(std::ostream &out) const;
+
+private:
+    const uint8_t *Cell(size_t column, uint64_t sample) const;
+
+    int m_iFile = -1;
+    const uint8_t *m_pMap = nullptr;
+    size_t m_uMapSize = 0;
+    uint64_t m_uSamples = 0;
+    uint32_t m_uBlockSamples = 0;
+    uint64_t m_uDataOffset = 0;
+    uint64_t m_uBlockSize = 0;
+    nlohmann::json m_xMeta;
+    std::vector<TelemetryFile::Column> m_vColumns;
+    std::vector<uint64_t> m_vColumnOffsets;
+};
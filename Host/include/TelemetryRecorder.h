@@ -0,0 +1,68 @@
+#pragma once
+#include <atomic>
+#include <chrono>
+#include <string>
+#include <vector>
+#include "SpiTransport.h"
+#include "TelemetryFile.h"
+#include "commands.h"
+
+
+/**
+ * Запись телеметрии НЧ драйвера в TelemetryFile.
+ *
+ * Все регистры одной записи читаются одним вызовом SpiTransport::Transfer, поэтому скорость ограничена одним
+ * обменом по USB на запись. Столбцы файла: time_ns - время начала чтения от старта записи, flags - биты регистров,
+ * не прошедших проверку CRC за все попытки (бит i - i-й регистр списка), затем значения регистров: 2-байтные
+ * регистры - столбец uint16, CRC_HW/CRC_SW - uint32, ADC_ALL - четыре столбца ADC_ALL_1..ADC_ALL_4.
+ *
+ * При Options::Period запись идёт по расписанию от момента старта. Опоздавшая запись не пропускается,
+ * следующие делаются подряд до возврата в расписание, опоздания считаются в Stats::Late.
+ */
+class TelemetryRecorder {
+public:
+    static const size_t MaxRegisters = 16;
+
+    struct Options {
+        std::chrono::microseconds Period {0};   ///< Период записей, 0 - с максимальной скоростью
+        uint64_t Samples = 0;                   ///< Количество записей, 0 - до Stop()
+        bool UseCRC = true;                     ///< Проверка CRC чтения
+        int Tries = 3;                          ///< Попытки чтения регистра при ошибке CRC
+        uint32_t BlockSamples = 4096;           ///< Записей в блоке файла
+    };
+
+    struct Stats {
+        uint64_t Samples;                       ///< Записано
+        uint64_t CrcErrors;                     ///< Значений с флагом ошибки CRC
+        uint64_t Retries;                       ///< Повторных чтений
+        uint64_t Late;                          ///< Записей позже расписания больше чем на период
+        double Rate;                            ///< Записей в секунду
+        std::chrono::nanoseconds MeanInterval;  ///< Средний интервал между записями
+        std::chrono::nanoseconds Jitter;        ///< СКО интервала
+        std::chrono::nanoseconds MaxInterval;   ///< Наибольший интервал
+    };
+
+    TelemetryRecorder(SpiTransport &spi, const std::vector<lfc::Registers> &registers, const Options &options);
+
+    Stats Record(const std::string &path, const nlohmann::json &meta = nlohmann::json::object());
+    void Stop() { m_bStop = true; }
+
+    const std::vector<TelemetryFile::Column> &Columns() const { return m_vColumns; }
+
+    static lfc::Registers RegisterFromName(const std::string &name);
+    static const char *RegisterName(lfc::Registers reg);
+    static uint16_t RegisterSize(lfc::Registers reg);
+
+private:
+    bool Check(size_t index) const;
+    uint64_t Decode(size_t index, size_t part) const;
+
+    SpiTransport &m_xSpi;
+    std::vector<lfc::Registers> m_vRegisters;
+    Options m_xOptions;
+    std::vector<TelemetryFile::Column> m_vColumns;
+
+    std::vector<uint8_t> m_vCommands;
+    std::vector<std::vector<uint8_t>> m_vResponses;
+    std::atomic<bool> m_bStop {false};
+};
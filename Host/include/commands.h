@@ -1,5 +1,6 @@
 #pragma once
 #include <cstdint>
+#include "register_map.h"
 
 
 /// Объявления НЧ драйвера
@@ -16,49 +17,6 @@ namespace lfc {
         CHANNEL_INVALID             ///< Заглушка для неправильного канала
     };
 
-    /**
-     * Регистры НЧ драйвера
-     */
-    enum Registers {
-        WHOIAM          = 0x00,     ///< RO 2 байта. Кто я такой, код устройства
-        STATUS          = 0x01,     ///< RO 2 байта. Статус устройства. @ref status_flags "Описание полей"
-        LAST_ERROR      = 0x02,     ///< RO 2 байта. Ошибка выполнения последней команды
-
-        DAC_CH1         = 0x03,     ///< RW 2 байта. Канал 1 ЦАП, текущее значение
-        DAC_CH2         = 0x04,     ///< RW 2 байта. Канал 2 ЦАП, текущее значение
-        DAC_CH3         = 0x05,     ///< RW 2 байта. Канал 3 ЦАП, текущее значение
-        DAC_CH4         = 0x06,     ///< RW 2 байта. Канал 4 ЦАП, текущее значение
-        DAC_ALL         = 0x07,     ///< RW 2 байта. Все каналы ЦАП, текущее значение
-
-        ADC_CH1         = 0x08,     ///< RO 2 байта. Канал 1 АЦП
-        ADC_CH2         = 0x09,     ///< RO 2 байта. Канал 2 АЦП
-        ADC_CH3         = 0x0A,     ///< RO 2 байта. Канал 3 АЦП
-        ADC_CH4         = 0x0B,     ///< RO 2 байта. Канал 4 АЦП
-        ADC_ALL         = 0x0C,     ///< RO 8 байта. Все каналы АЦП
-
-        DAC_DEFAULT_CH1 = 0x0D,     ///< RW 2 байта. Канал 1 ЦАП, значение после включения, сброса
-        DAC_DEFAULT_CH2 = 0x0E,     ///< RW 2 байта. Канал 2 ЦАП, значение после включения, сброса
-        DAC_DEFAULT_CH3 = 0x0F,     ///< RW 2 байта. Канал 3 ЦАП, значение после включения, сброса
-        DAC_DEFAULT_CH4 = 0x10,     ///< RW 2 байта. Канал 4 ЦАП, значение после включения, сброса
-
-        DAC_MAX_CH1     = 0x11,     ///< RW 2 байта. Канал 1 ЦАП, максимальное значение
-        DAC_MAX_CH2     = 0x12,     ///< RW 2 байта. Канал 2 ЦАП, максимальное значение
-        DAC_MAX_CH3     = 0x13,     ///< RW 2 байта. Канал 3 ЦАП, максимальное значение
-        DAC_MAX_CH4     = 0x14,     ///< RW 2 байта. Канал 4 ЦАП, максимальное значение
-        SAVE_EEP        = 0x15,     ///< WO 2 байта. Битовая карта сохранения настроек. @ref nv_flags "Описание полей"
-
-        THRM_PCB        = 0x16,     ///< RO 2 байта. Температура термодатчика на печатной плате, К
-        THRM_MCU        = 0x17,     ///< RO 2 байта. Температура микропроцессора, К
-        SVC             = 0x18,     ///< WO 2 байта. Сервисная команда. @ref svc_flags "Описание полей"
-        VERSION         = 0x19,     ///< RO 2 байта. Версия программного обеспечения
-        CRC_HW          = 0x1A,     ///< RO 4 байта. Контрольная сумма, посчитанная аппаратно
-        CRC_SW          = 0x1B,     ///< RO 4 байта. Контрольная сумма, посчитанная программно
-        CERT            = 0x1C,
-
-        RESTRICTED      = UINT8_MAX - 1,
-        INVALID         = UINT8_MAX ///< Не верный регистр
-    };
-
     /**
      * Доступ к регистру
      */
@@ -149,6 +107,10 @@ namespace lfc {
 #define LF_SVC_STOP_Pos             (6U)
 #define LF_SVC_STOP_Msk             (0x01UL << LF_SVC_STOP_Pos)
 #define LF_SVC_STOP                 LF_SVC_STOP_Msk           ///< 1 Выключает НЧ драйвер
+
+#define LF_SVC_UPDATE_Pos           (7U)
+#define LF_SVC_UPDATE_Msk           (0x01UL << LF_SVC_UPDATE_Pos)
+#define LF_SVC_UPDATE               LF_SVC_UPDATE_Msk         ///< 1 Переводит НЧ драйвер в режим обновления прошивки до сброса, см. LfUpdater
 /** @} */
 
 
@@ -1,10 +1,13 @@
 #ifndef LFDRIVER_COMMON_H
 #define LFDRIVER_COMMON_H
 
+#include <memory>
 #include <string>
-#include <exception>
 #include "cxxopts.hpp"
 #include "commands.h"
+#include "FtdiException.h"
+#include "I2cBus.h"
+#include "SpiTransport.h"
 
 
 bool no_channel_selected(const cxxopts::ParseResult &opts);
@@ -12,6 +15,10 @@ lfc::Channel GetChannelFromString(const std::string &ch);
 uint16_t GetEepromDefaultMask(lfc::Channel channel);
 uint16_t GetEepromMaximumMask(lfc::Channel channel);
 
+std::string DaemonSocket();
+std::unique_ptr<SpiTransport> OpenSpi(int device, const std::string &socket);
+std::unique_ptr<I2cBus> OpenI2c(int device, const std::string &socket);
+
 
 enum RETURN_STATUS {
     OK = 0,
@@ -22,16 +29,4 @@ enum RETURN_STATUS {
 };
 
 
-class FtdiException : public std::exception {
-public:
-    explicit FtdiException(const char *message) : msg(message) {}
-    const char *what() const noexcept override {
-        return msg;
-    }
-
-private:
-    const char *msg;
-};
-
-
 #endif //LFDRIVER_COMMON_H
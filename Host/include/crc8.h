@@ -0,0 +1,12 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+
+
+/**
+ * CRC-8-ITU посылок НЧ драйвера, такая же считается в прошивке
+ * @param pcBlock const uint8_t* - данные
+ * @param len size_t - размер данных
+ * @return Контрольная сумма
+ */
+uint8_t crc8(const uint8_t *pcBlock, size_t len);
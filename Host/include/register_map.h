@@ -0,0 +1,172 @@
+// Сгенерировано lfregmap из registers.json, не редактировать.
+// Перегенерировать: cmake --build <сборка Host> --target regmap
+#pragma once
+#include <array>
+#include <cstddef>
+#include <cstdint>
+
+
+namespace lfc {
+    /**
+     * Регистры НЧ драйвера, спецификация - registers.json
+     */
+    enum Registers {
+        WHOIAM          = 0x00,     ///< RO 2 байта. Кто я такой, код устройства
+        STATUS          = 0x01,     ///< RO 2 байта. Статус устройства. @ref status_flags "Описание полей"
+        LAST_ERROR      = 0x02,     ///< RO 2 байта. Ошибка выполнения последней команды
+        DAC_CH1         = 0x03,     ///< RW 2 байта. Канал 1 ЦАП, текущее значение
+        DAC_CH2         = 0x04,     ///< RW 2 байта. Канал 2 ЦАП, текущее значение
+        DAC_CH3         = 0x05,     ///< RW 2 байта. Канал 3 ЦАП, текущее значение
+        DAC_CH4         = 0x06,     ///< RW 2 байта. Канал 4 ЦАП, текущее значение
+        DAC_ALL         = 0x07,     ///< RW 2 байта. Все каналы ЦАП, текущее значение
+        ADC_CH1         = 0x08,     ///< RO 2 байта. Канал 1 АЦП
+        ADC_CH2         = 0x09,     ///< RO 2 байта. Канал 2 АЦП
+        ADC_CH3         = 0x0A,     ///< RO 2 байта. Канал 3 АЦП
+        ADC_CH4         = 0x0B,     ///< RO 2 байта. Канал 4 АЦП
+        ADC_ALL         = 0x0C,     ///< RO 8 байт. Все каналы АЦП из одного снимка
+        DAC_DEFAULT_CH1 = 0x0D,     ///< RW 2 байта. Канал 1 ЦАП, значение после включения, сброса
+        DAC_DEFAULT_CH2 = 0x0E,     ///< RW 2 байта. Канал 2 ЦАП, значение после включения, сброса
+        DAC_DEFAULT_CH3 = 0x0F,     ///< RW 2 байта. Канал 3 ЦАП, значение после включения, сброса
+        DAC_DEFAULT_CH4 = 0x10,     ///< RW 2 байта. Канал 4 ЦАП, значение после включения, сброса
+        DAC_MAX_CH1     = 0x11,     ///< RW 2 байта. Канал 1 ЦАП, максимальное значение
+        DAC_MAX_CH2     = 0x12,     ///< RW 2 байта. Канал 2 ЦАП, максимальное значение
+        DAC_MAX_CH3     = 0x13,     ///< RW 2 байта. Канал 3 ЦАП, максимальное значение
+        DAC_MAX_CH4     = 0x14,     ///< RW 2 байта. Канал 4 ЦАП, максимальное значение
+        SAVE_EEP        = 0x15,     ///< WO 2 байта. Битовая карта сохранения настроек. @ref nv_flags "Описание полей"
+        THRM_PCB        = 0x16,     ///< RO 2 байта. Температура термодатчика на печатной плате, К
+        THRM_MCU        = 0x17,     ///< RO 2 байта. Температура микропроцессора, К
+        SVC             = 0x18,     ///< WO 2 байта. Сервисная команда. @ref svc_flags "Описание полей"
+        VERSION         = 0x19,     ///< RO 2 байта. Версия программного обеспечения
+        CRC_HW          = 0x1A,     ///< RO 4 байта. Контрольная сумма, посчитанная аппаратно
+        CRC_SW          = 0x1B,     ///< RO 4 байта. Контрольная сумма, посчитанная программно
+        CERT            = 0x1C,     ///< RW 2 байта. Самоконтроль. @ref cert_flags "Описание полей"
+
+        RESTRICTED      = UINT8_MAX - 1,
+        INVALID         = UINT8_MAX ///< Не верный регистр
+    };
+
+    /**
+     * Доступ к регистру по спецификации, битовая карта
+     */
+    enum RegisterAccess {
+        ACCESS_NONE         = 0,    ///< Номер не занят
+        ACCESS_READ         = 1,    ///< Чтение
+        ACCESS_WRITE        = 2,    ///< Запись, всегда 2 байта
+        ACCESS_READ_WRITE   = 3
+    };
+
+    /**
+     * Описание регистра в RegisterTable
+     */
+    struct RegisterInfo {
+        const char *Name;           ///< nullptr - номер не занят
+        uint8_t Size;               ///< Байт данных при чтении, без CRC
+        uint8_t Access;             ///< RegisterAccess
+    };
+
+    constexpr size_t REGISTER_COUNT = 0x1D;   ///< Номеров в RegisterTable
+    constexpr size_t REGISTER_SIZE_MAX = 8;   ///< Наибольший регистр, байт
+
+    /**
+     * Регистры по номеру
+     */
+    constexpr RegisterInfo RegisterTable[REGISTER_COUNT] = {
+            {"WHOIAM", 2, ACCESS_READ},
+            {"STATUS", 2, ACCESS_READ},
+            {"LAST_ERROR", 2, ACCESS_READ},
+            {"DAC_CH1", 2, ACCESS_READ_WRITE},
+            {"DAC_CH2", 2, ACCESS_READ_WRITE},
+            {"DAC_CH3", 2, ACCESS_READ_WRITE},
+            {"DAC_CH4", 2, ACCESS_READ_WRITE},
+            {"DAC_ALL", 2, ACCESS_READ_WRITE},
+            {"ADC_CH1", 2, ACCESS_READ},
+            {"ADC_CH2", 2, ACCESS_READ},
+            {"ADC_CH3", 2, ACCESS_READ},
+            {"ADC_CH4", 2, ACCESS_READ},
+            {"ADC_ALL", 8, ACCESS_READ},
+            {"DAC_DEFAULT_CH1", 2, ACCESS_READ_WRITE},
+            {"DAC_DEFAULT_CH2", 2, ACCESS_READ_WRITE},
+            {"DAC_DEFAULT_CH3", 2, ACCESS_READ_WRITE},
+            {"DAC_DEFAULT_CH4", 2, ACCESS_READ_WRITE},
+            {"DAC_MAX_CH1", 2, ACCESS_READ_WRITE},
+            {"DAC_MAX_CH2", 2, ACCESS_READ_WRITE},
+            {"DAC_MAX_CH3", 2, ACCESS_READ_WRITE},
+            {"DAC_MAX_CH4", 2, ACCESS_READ_WRITE},
+            {"SAVE_EEP", 2, ACCESS_WRITE},
+            {"THRM_PCB", 2, ACCESS_READ},
+            {"THRM_MCU", 2, ACCESS_READ},
+            {"SVC", 2, ACCESS_WRITE},
+            {"VERSION", 2, ACCESS_READ},
+            {"CRC_HW", 4, ACCESS_READ},
+            {"CRC_SW", 4, ACCESS_READ},
+            {"CERT", 2, ACCESS_READ_WRITE},
+    };
+
+    /**
+     * Описание регистра по номеру, вне таблицы - {nullptr, 0, ACCESS_NONE}
+     */
+    constexpr RegisterInfo GetRegisterInfo(unsigned reg) {
+        return reg < REGISTER_COUNT ? RegisterTable[reg] : RegisterInfo {nullptr, 0, ACCESS_NONE};
+    }
+
+    /**
+     * Типизированные регистры для LFSmart::Read<>() и LFSmart::Write<>(): номер, тип значения и доступ
+     */
+    namespace reg {
+        template <Registers R, typename T, unsigned A>
+        struct Register {
+            using Type = T;
+            static constexpr Registers Address = R;
+            static constexpr unsigned Access = A;
+        };
+
+        template <Registers R, typename T, unsigned A> constexpr Registers Register<R, T, A>::Address;
+        template <Registers R, typename T, unsigned A> constexpr unsigned Register<R, T, A>::Access;
+
+        using WHOIAM = Register<lfc::WHOIAM, uint16_t, ACCESS_READ>;
+        using STATUS = Register<lfc::STATUS, uint16_t, ACCESS_READ>;
+        using LAST_ERROR = Register<lfc::LAST_ERROR, uint16_t, ACCESS_READ>;
+        using DAC_CH1 = Register<lfc::DAC_CH1, uint16_t, ACCESS_READ_WRITE>;
+        using DAC_CH2 = Register<lfc::DAC_CH2, uint16_t, ACCESS_READ_WRITE>;
+        using DAC_CH3 = Register<lfc::DAC_CH3, uint16_t, ACCESS_READ_WRITE>;
+        using DAC_CH4 = Register<lfc::DAC_CH4, uint16_t, ACCESS_READ_WRITE>;
+        using DAC_ALL = Register<lfc::DAC_ALL, uint16_t, ACCESS_READ_WRITE>;
+        using ADC_CH1 = Register<lfc::ADC_CH1, uint16_t, ACCESS_READ>;
+        using ADC_CH2 = Register<lfc::ADC_CH2, uint16_t, ACCESS_READ>;
+        using ADC_CH3 = Register<lfc::ADC_CH3, uint16_t, ACCESS_READ>;
+        using ADC_CH4 = Register<lfc::ADC_CH4, uint16_t, ACCESS_READ>;
+        using ADC_ALL = Register<lfc::ADC_ALL, std::array<uint16_t, 4>, ACCESS_READ>;
+        using DAC_DEFAULT_CH1 = Register<lfc::DAC_DEFAULT_CH1, uint16_t, ACCESS_READ_WRITE>;
+        using DAC_DEFAULT_CH2 = Register<lfc::DAC_DEFAULT_CH2, uint16_t, ACCESS_READ_WRITE>;
+        using DAC_DEFAULT_CH3 = Register<lfc::DAC_DEFAULT_CH3, uint16_t, ACCESS_READ_WRITE>;
+        using DAC_DEFAULT_CH4 = Register<lfc::DAC_DEFAULT_CH4, uint16_t, ACCESS_READ_WRITE>;
+        using DAC_MAX_CH1 = Register<lfc::DAC_MAX_CH1, uint16_t, ACCESS_READ_WRITE>;
+        using DAC_MAX_CH2 = Register<lfc::DAC_MAX_CH2, uint16_t, ACCESS_READ_WRITE>;
+        using DAC_MAX_CH3 = Register<lfc::DAC_MAX_CH3, uint16_t, ACCESS_READ_WRITE>;
+        using DAC_MAX_CH4 = Register<lfc::DAC_MAX_CH4, uint16_t, ACCESS_READ_WRITE>;
+        using SAVE_EEP = Register<lfc::SAVE_EEP, uint16_t, ACCESS_WRITE>;
+        using THRM_PCB = Register<lfc::THRM_PCB, uint16_t, ACCESS_READ>;
+        using THRM_MCU = Register<lfc::THRM_MCU, uint16_t, ACCESS_READ>;
+        using SVC = Register<lfc::SVC, uint16_t, ACCESS_WRITE>;
+        using VERSION = Register<lfc::VERSION, uint16_t, ACCESS_READ>;
+        using CRC_HW = Register<lfc::CRC_HW, uint32_t, ACCESS_READ>;
+        using CRC_SW = Register<lfc::CRC_SW, uint32_t, ACCESS_READ>;
+        using CERT = Register<lfc::CERT, uint16_t, ACCESS_READ_WRITE>;
+    }
+
+    /**
+     * Группа подряд идущих 16-битных регистров, например каналы. Читается LFSmart::ReadGroup():
+     * при Block - одной транзакцией регистра All, иначе - пакетом транзакций SpiTransport::Transfer
+     */
+    struct RegisterGroup {
+        Registers First;            ///< Регистр канала 1
+        uint8_t Count;              ///< Регистров подряд
+        Registers All;              ///< Регистр всех каналов, INVALID - нет
+        bool Block;                 ///< All читает значения всех Count регистров
+    };
+
+    constexpr RegisterGroup GROUP_DAC           = {DAC_CH1, 4, DAC_ALL, false};
+    constexpr RegisterGroup GROUP_ADC           = {ADC_CH1, 4, ADC_ALL, true};
+    constexpr RegisterGroup GROUP_DAC_DEFAULT   = {DAC_DEFAULT_CH1, 4, INVALID, false};
+    constexpr RegisterGroup GROUP_DAC_MAX       = {DAC_MAX_CH1, 4, INVALID, false};
+}
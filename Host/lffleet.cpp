@@ -0,0 +1,112 @@
+/**
+ * @addtogroup applications
+ * Утилиты для управления умным НЧ драйвером
+ * @{
+ */
+
+/**
+  ******************************************************************************
+  * @file   lffleet.cpp
+  * @brief  Опрос всех подключенных НЧ драйверов
+  *
+  * Открывает все найденные преобразователи USB-SPI FT4222 одновременно и читает с каждой платы WHOIAM, VERSION
+  * и контрольные суммы CRC_HW/CRC_SW. Платы опрашиваются параллельно пулом потоков LfFleet.
+  *
+  * Аргументы командной строки:
+  *  - -n --count: количество преобразователей, по-умолчанию все найденные
+  *  - -j --threads: потоков, по-умолчанию по одному на плату
+  *  - -s --socket: сокет lfsd, по-умолчанию $LFSD_SOCKET, $XDG_RUNTIME_DIR/lfsd.sock или /tmp/lfsd.sock.
+  *    Без lfsd - напрямую через FT4222
+  *  - -t --tries: Количество попыток чтения, по-умолчанию 3
+  */
+
+/** @} */
+
+#include <iostream>
+#include <vector>
+#include <fmt/core.h>
+#include <cxxopts.hpp>
+#include <FtdiDeviceList.h>
+#include <LfFleet.h>
+#include <common.h>
+
+
+static cxxopts::ParseResult parse(int argc, char *argv[]) {
+    try {
+        cxxopts::Options options(argv[0], " - DAC LF controller, fleet status");
+        options.positional_help("[optional args]").show_positional_help();
+        options.add_options()
+        ("h,help", "Print help")
+        ("n,count", "FTDI devices, default all", cxxopts::value<int>()->default_value("0"))
+        ("j,threads", "Worker threads, default one per device", cxxopts::value<int>()->default_value("0"))
+        ("t,tries", "Read tries, default 3", cxxopts::value<int>()->default_value("3"))
+        ("s,socket", "lfsd socket, empty - direct FTDI access", cxxopts::value<std::string>()->default_value(DaemonSocket()));
+
+        auto result = options.parse(argc, argv);
+        if (result.count("help")) {
+            std::cout << options.help({}) << std::endl;
+            ::exit(RETURN_STATUS::OK);
+        }
+        return result;
+
+    } catch (const cxxopts::OptionException &e) {
+        fmt::print(stderr, "error parsing options: {}\n", e.what());
+        ::exit(RETURN_STATUS::COMMANDLINE_ERROR);
+    }
+}
+
+
+struct BoardInfo {
+    uint16_t Whoiam;
+    uint16_t Version;
+    std::pair<uint32_t, uint32_t> Crc;
+};
+
+
+int main(int argc, char *argv[]) {
+    auto opts = parse(argc, argv);
+    std::string socket = opts["socket"].as<std::string>();
+
+    int count = opts["count"].as<int>();
+    if (count <= 0)
+        count = FtdiDeviceList::Find(false);
+    if (count == 0) {
+        fmt::print(stderr, "FTDI error: No FTDI devices present\n");
+        return RETURN_STATUS::FTDI_ERROR;
+    }
+    int threads = opts["threads"].as<int>();
+
+    LfFleet fleet([&socket](int device) { return OpenSpi(device, socket); }, true, opts["tries"].as<int>(),
+                  threads > 0 ? threads : count);
+    auto open = fleet.Open(count);
+
+    std::vector<BoardInfo> info(count);
+    auto run = fleet.Run([&info](int device, LFSmart &lf) {
+        info[device] = {lf.Whoiam(), lf.Version(), lf.ReadCRC()};
+    });
+
+    int status = RETURN_STATUS::OK;
+    auto print = [&](const LfFleet::BoardResult &board) {
+        if (!board.Ok) {
+            fmt::print("Dev {:2d}: error: {}\n", board.Device, board.Error);
+            status = board.CrcError ? RETURN_STATUS::CRC_ERROR : RETURN_STATUS::LFDRV_ERROR;
+            return;
+        }
+        const BoardInfo &board_info = info[board.Device];
+        fmt::print("Dev {:2d}: WHOIAM 0x{:04X}, VERSION {}, CRC_HW 0x{:08X}, CRC_SW 0x{:08X}{}, {:.1f} ms\n",
+                   board.Device, board_info.Whoiam, board_info.Version, board_info.Crc.first, board_info.Crc.second,
+                   board_info.Crc.first == board_info.Crc.second ? "" : " MISMATCH", board.Time.count() / 1000.0);
+    };
+    for (const auto &board : open.Boards) {
+        if (!board.Ok) {
+            print(board);
+            status = RETURN_STATUS::FTDI_ERROR;
+        }
+    }
+    for (const auto &board : run.Boards)
+        print(board);
+
+    fmt::print("{} of {} boards ok, open {:.1f} ms, run {:.1f} ms, {} threads\n", run.Succeeded, count,
+               open.Elapsed.count() / 1000.0, run.Elapsed.count() / 1000.0, fleet.Threads());
+    return status;
+}
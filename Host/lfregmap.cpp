@@ -0,0 +1,470 @@
+/**
+ * @addtogroup applications
+ * Утилиты для управления умным НЧ драйвером
+ * @{
+ */
+
+/**
+  ******************************************************************************
+  * @file   lfregmap.cpp
+  * @brief  Генератор карты регистров НЧ драйвера из registers.json
+  *
+  * Спецификация регистров одна на прошивку и хост. Из неё генерируются:
+  *  - Core/inc/RegisterMap.hpp: номера REG_*, размеры REG_SIZE_*, объявление таблицы RegisterMap;
+  *  - Core/src/RegisterMap.cpp: единственное определение RegisterMap по номеру регистра с размером, доступом и
+  *    обработчиками прошивки для разбора команды за одно обращение;
+  *  - Host/include/register_map.h: lfc::Registers, таблица lfc::RegisterTable, типизированные регистры lfc::reg::*
+  *    для LFSmart::Read<>() и LFSmart::Write<>(), группы подряд идущих регистров lfc::GROUP_* для LFSmart::ReadGroup().
+  *
+  * Сгенерированные файлы хранятся в репозитории: прошивка собирается без хостовых утилит.
+  *
+  * Аргументы командной строки: lfregmap registers.json RegisterMap.hpp RegisterMap.cpp register_map.h [--check]
+  *  - --check: не записывать, а сравнить с существующими файлами. Код возврата 1 - файлы устарели
+  */
+
+/** @} */
+
+#include <algorithm>
+#include <cctype>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <map>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+#include <json.hpp>
+
+using nlohmann::json;
+
+
+namespace {
+
+const unsigned AddressMax = 127;                // Номер регистра - старшие 7 бит байта команды
+const char *Generated = "Сгенерировано lfregmap из registers.json, не редактировать";
+const char *Regenerate = "Перегенерировать: cmake --build <сборка Host> --target regmap";
+
+struct Register {
+    std::string Name;
+    unsigned Address;
+    bool Readable;
+    bool Writable;
+    std::string Type;                           // Тип хоста
+    unsigned Size;                              // Байт данных при чтении
+    std::string Description;
+    std::string Read;                           // Обработчик прошивки, пусто - нет
+    std::string Write;
+};
+
+struct Group {
+    std::string Name;
+    size_t First;                               // Индекс в Spec::Registers
+    unsigned Count;
+    const Register *All;                        // nullptr - нет
+    bool Block;                                 // All читает всю группу одной транзакцией
+};
+
+struct Spec {
+    std::vector<Register> Registers;            // По возрастанию номера
+    std::vector<Group> Groups;
+    unsigned Count;                             // Наибольший номер + 1
+    unsigned SizeMax;
+};
+
+
+std::string Hex(unsigned value) {
+    std::ostringstream out;
+    out << "0x" << std::uppercase << std::hex << std::setw(2) << std::setfill('0') << value;
+    return out.str();
+}
+
+
+std::string Pad(const std::string &text, size_t width) {
+    return text.size() < width ? text + std::string(width - text.size(), ' ') : text + " ";
+}
+
+
+std::string Bytes(unsigned size) {
+    unsigned last = size % 10;
+    bool few = last >= 2 && last <= 4 && (size % 100 < 12 || size % 100 > 14);
+    return std::to_string(size) + (few ? " байта" : " байт");
+}
+
+
+void Require(bool condition, const std::string &message) {
+    if (!condition)
+        throw std::runtime_error(message);
+}
+
+
+bool Identifier(const std::string &name) {
+    if (name.empty() || !(isupper(name[0]) || name[0] == '_'))
+        return false;
+    for (char c : name) {
+        if (!(isupper(c) || isdigit(c) || c == '_'))
+            return false;
+    }
+    return true;
+}
+
+
+/*
+ * uint16, uint32 или массив uint16[N]. Запись всегда 2 байта, поэтому записываемые регистры - только uint16
+ */
+void ParseType(Register &reg, const std::string &type) {
+    if (type == "uint16") {
+        reg.Type = "uint16_t";
+        reg.Size = 2;
+        return;
+    }
+    if (type == "uint32") {
+        reg.Type = "uint32_t";
+        reg.Size = 4;
+        return;
+    }
+    unsigned count = 0;
+    char tail = 0;
+    Require(sscanf(type.c_str(), "uint16[%u%c", &count, &tail) == 2 && tail == ']' &&
+            type == "uint16[" + std::to_string(count) + "]" && count > 0,
+            reg.Name + ": unknown type " + type);
+    reg.Type = "std::array<uint16_t, " + std::to_string(count) + ">";
+    reg.Size = 2 * count;
+}
+
+
+Spec Parse(const json &document) {
+    Spec spec {};
+    std::map<std::string, size_t> names;
+    std::map<unsigned, std::string> addresses;
+
+    for (const auto &item : document.at("registers")) {
+        Register reg {};
+        reg.Name = item.at("name").get<std::string>();
+        Require(Identifier(reg.Name), "Bad register name '" + reg.Name + "'");
+        Require(names.count(reg.Name) == 0, reg.Name + ": duplicate name");
+        reg.Address = item.at("address").get<unsigned>();
+        Require(reg.Address <= AddressMax, reg.Name + ": address above 127");
+        auto taken = addresses.find(reg.Address);
+        Require(taken == addresses.end(), reg.Name + ": address taken by " +
+                                          (taken != addresses.end() ? taken->second : ""));
+
+        std::string access = item.at("access").get<std::string>();
+        Require(access == "RO" || access == "WO" || access == "RW", reg.Name + ": access must be RO, WO or RW");
+        reg.Readable = access != "WO";
+        reg.Writable = access != "RO";
+        ParseType(reg, item.at("type").get<std::string>());
+        Require(!reg.Writable || reg.Size == 2, reg.Name + ": writable register must be uint16");
+        reg.Description = item.value("description", "");
+        reg.Read = item.value("read", "");
+        reg.Write = item.value("write", "");
+        Require(reg.Read.empty() || reg.Readable, reg.Name + ": read handler for write-only register");
+        Require(reg.Write.empty() || reg.Writable, reg.Name + ": write handler for read-only register");
+
+        names[reg.Name] = spec.Registers.size();
+        addresses[reg.Address] = reg.Name;
+        spec.Registers.push_back(reg);
+    }
+    Require(!spec.Registers.empty(), "No registers");
+
+    std::sort(spec.Registers.begin(), spec.Registers.end(),
+              [](const Register &a, const Register &b) { return a.Address < b.Address; });
+    for (size_t i = 0; i < spec.Registers.size(); i++) {
+        names[spec.Registers[i].Name] = i;
+        if (spec.Registers[i].Size > spec.SizeMax)
+            spec.SizeMax = spec.Registers[i].Size;
+    }
+    spec.Count = spec.Registers.back().Address + 1;
+
+    auto find = [&](const std::string &name) -> size_t {
+        auto it = names.find(name);
+        Require(it != names.end(), "Unknown register " + name);
+        return it->second;
+    };
+
+    for (const auto &item : document.value("groups", json::array())) {
+        Group group {};
+        group.Name = item.at("name").get<std::string>();
+        Require(Identifier(group.Name), "Bad group name '" + group.Name + "'");
+        group.First = find(item.at("first").get<std::string>());
+        group.Count = item.at("count").get<unsigned>();
+        Require(group.Count > 0, group.Name + ": empty group");
+        for (size_t i = group.First; i < group.First + group.Count; i++) {
+            Require(i < spec.Registers.size() &&
+                    spec.Registers[i].Address == spec.Registers[group.First].Address + (i - group.First),
+                    group.Name + ": registers are not contiguous");
+            Require(spec.Registers[i].Type == "uint16_t" && spec.Registers[i].Readable,
+                    group.Name + ": " + spec.Registers[i].Name + " is not readable uint16");
+        }
+        if (item.count("all")) {
+            group.All = &spec.Registers[find(item.at("all").get<std::string>())];
+            group.Block = group.All->Readable && group.All->Size == 2 * group.Count;
+        }
+        spec.Groups.push_back(group);
+    }
+    return spec;
+}
+
+
+std::string Firmware(const Spec &spec) {
+    std::ostringstream out;
+    out << "/**\n"
+           " * @file RegisterMap.hpp\n"
+           " * @brief Карта регистров RegisterProtocol: номера, размеры, доступ и обработчики прошивки\n"
+           " *\n"
+           " * " << Generated << ".\n"
+           " * " << Regenerate << "\n"
+           " */\n\n"
+           "#ifndef MILANDRBASE_REGISTERMAP_HPP\n"
+           "#define MILANDRBASE_REGISTERMAP_HPP\n\n"
+           "#include <stdint.h>\n"
+           "#include <stddef.h>\n\n";
+
+    for (const auto &reg : spec.Registers)
+        out << "#define " << Pad("REG_" + reg.Name, 24) << "(" << Hex(reg.Address) << ")\n";
+    out << "#define " << Pad("REG_COUNT", 24) << Pad("(" + Hex(spec.Count) + ")", 12) << "///< Номеров в RegisterMap\n";
+    out << "#define " << Pad("REG_DATA_MAX", 24) << Pad("(" + std::to_string(spec.SizeMax) + ")", 12)
+        << "///< Наибольший регистр, байт\n\n";
+    for (const auto &reg : spec.Registers)
+        out << "#define " << Pad("REG_SIZE_" + reg.Name, 24) << "(" << reg.Size << ")\n";
+    out << "\n";
+
+    out << "#define " << Pad("REG_ACCESS_READ", 24) << "(1U << 0)\n"
+        << "#define " << Pad("REG_ACCESS_WRITE", 24) << "(1U << 1)\n\n\n"
+           "/**\n"
+           " * @brief Данные регистра для ответа на чтение, RegisterEntry::Size байт little-endian без CRC\n"
+           " */\n"
+           "typedef void (*RegisterReadHandler)(uint8_t reg, uint8_t *data);\n\n"
+           "/**\n"
+           " * @brief Запись регистра, CRC уже проверена\n"
+           " * @return false - запись не выполнена\n"
+           " */\n"
+           "typedef bool (*RegisterWriteHandler)(uint8_t reg, uint16_t value);\n\n"
+           "/**\n"
+           " * @brief Регистр в RegisterMap\n"
+           " */\n"
+           "struct RegisterEntry {\n"
+           "    uint8_t              Size;          ///< Байт данных при чтении\n"
+           "    uint8_t              Access;        ///< REG_ACCESS_READ | REG_ACCESS_WRITE по спецификации\n"
+           "    RegisterReadHandler  Read;          ///< nullptr - прошивка не отвечает на чтение\n"
+           "    RegisterWriteHandler Write;         ///< nullptr - прошивка не принимает запись\n"
+           "};\n\n";
+
+    std::vector<std::string> declared;
+    auto declare = [&](const std::string &handler, const char *signature) {
+        if (handler.empty() || std::find(declared.begin(), declared.end(), handler) != declared.end())
+            return;
+        declared.push_back(handler);
+        out << signature << handler << (signature[0] == 'v' ? "(uint8_t reg, uint8_t *data);\n"
+                                                              : "(uint8_t reg, uint16_t value);\n");
+    };
+    for (const auto &reg : spec.Registers) {
+        declare(reg.Read, "void ");
+        declare(reg.Write, "bool ");
+    }
+
+    out << "\n\n"
+           "/**\n"
+           " * @brief Регистры по номеру: разбор команды - одно обращение к таблице. Определена в RegisterMap.cpp\n"
+           " */\n"
+           "extern const RegisterEntry RegisterMap[REG_COUNT];\n\n"
+           "#endif //MILANDRBASE_REGISTERMAP_HPP\n";
+    return out.str();
+}
+
+
+std::string Source(const Spec &spec) {
+    std::ostringstream out;
+    out << "/**\n"
+           " * @file RegisterMap.cpp\n"
+           " * @brief Таблица RegisterMap, единственное определение на прошивку\n"
+           " *\n"
+           " * " << Generated << ".\n"
+           " * " << Regenerate << "\n"
+           " */\n\n"
+           "#include \"RegisterMap.hpp\"\n\n\n"
+           "const RegisterEntry RegisterMap[REG_COUNT] = {\n";
+    std::vector<std::pair<std::string, std::string>> entries;
+    size_t next = 0, width = 0;
+    for (unsigned address = 0; address < spec.Count; address++) {
+        std::string entry = "{0, 0, nullptr, nullptr},";
+        std::string name = "-";
+        if (spec.Registers[next].Address == address) {
+            const Register &reg = spec.Registers[next++];
+            std::string access = reg.Readable && reg.Writable ? "REG_ACCESS_READ | REG_ACCESS_WRITE"
+                                 : reg.Readable ? "REG_ACCESS_READ" : "REG_ACCESS_WRITE";
+            entry = "{REG_SIZE_" + reg.Name + ", " + access + ", " +
+                    (reg.Read.empty() ? "nullptr" : reg.Read) + ", " +
+                    (reg.Write.empty() ? "nullptr" : reg.Write) + "},";
+            name = reg.Name;
+        }
+        entries.emplace_back(entry, "// " + Hex(address) + " " + name);
+        width = std::max(width, entry.size());
+    }
+    for (const auto &entry : entries)
+        out << "        " << Pad(entry.first, width + 4) << entry.second << "\n";
+    out << "};\n";
+    return out.str();
+}
+
+
+std::string Host(const Spec &spec) {
+    size_t width = 0;
+    for (const auto &reg : spec.Registers)
+        width = std::max(width, reg.Name.size());
+    width = std::max<size_t>(width + 1, 16);
+
+    std::ostringstream out;
+    out << "// " << Generated << ".\n"
+           "// " << Regenerate << "\n"
+           "#pragma once\n"
+           "#include <array>\n"
+           "#include <cstddef>\n"
+           "#include <cstdint>\n\n\n"
+           "namespace lfc {\n"
+           "    /**\n"
+           "     * Регистры НЧ драйвера, спецификация - registers.json\n"
+           "     */\n"
+           "    enum Registers {\n";
+    for (const auto &reg : spec.Registers) {
+        std::string access = reg.Readable && reg.Writable ? "RW" : reg.Readable ? "RO" : "WO";
+        std::string comment = access + " " + Bytes(reg.Size) + "." +
+                              (reg.Description.empty() ? "" : " " + reg.Description);
+        out << "        " << Pad(reg.Name, width) << "= " << Pad(Hex(reg.Address) + ",", 10) << "///< " << comment << "\n";
+    }
+    out << "\n"
+           "        " << Pad("RESTRICTED", width) << "= UINT8_MAX - 1,\n"
+           "        " << Pad("INVALID", width) << "= UINT8_MAX ///< Не верный регистр\n"
+           "    };\n\n"
+           "    /**\n"
+           "     * Доступ к регистру по спецификации, битовая карта\n"
+           "     */\n"
+           "    enum RegisterAccess {\n"
+           "        ACCESS_NONE         = 0,    ///< Номер не занят\n"
+           "        ACCESS_READ         = 1,    ///< Чтение\n"
+           "        ACCESS_WRITE        = 2,    ///< Запись, всегда 2 байта\n"
+           "        ACCESS_READ_WRITE   = 3\n"
+           "    };\n\n"
+           "    /**\n"
+           "     * Описание регистра в RegisterTable\n"
+           "     */\n"
+           "    struct RegisterInfo {\n"
+           "        const char *Name;           ///< nullptr - номер не занят\n"
+           "        uint8_t Size;               ///< Байт данных при чтении, без CRC\n"
+           "        uint8_t Access;             ///< RegisterAccess\n"
+           "    };\n\n"
+           "    constexpr size_t REGISTER_COUNT = " << Pad(Hex(spec.Count) + ";", 8) << "///< Номеров в RegisterTable\n"
+           "    constexpr size_t REGISTER_SIZE_MAX = " << Pad(std::to_string(spec.SizeMax) + ";", 5)
+        << "///< Наибольший регистр, байт\n\n"
+           "    /**\n"
+           "     * Регистры по номеру\n"
+           "     */\n"
+           "    constexpr RegisterInfo RegisterTable[REGISTER_COUNT] = {\n";
+    size_t next = 0;
+    for (unsigned address = 0; address < spec.Count; address++) {
+        if (spec.Registers[next].Address != address) {
+            out << "            {nullptr, 0, ACCESS_NONE},\n";
+            continue;
+        }
+        const Register &reg = spec.Registers[next++];
+        std::string access = reg.Readable && reg.Writable ? "ACCESS_READ_WRITE"
+                             : reg.Readable ? "ACCESS_READ" : "ACCESS_WRITE";
+        out << "            {\"" << reg.Name << "\", " << reg.Size << ", " << access << "},\n";
+    }
+    out << "    };\n\n"
+           "    /**\n"
+           "     * Описание регистра по номеру, вне таблицы - {nullptr, 0, ACCESS_NONE}\n"
+           "     */\n"
+           "    constexpr RegisterInfo GetRegisterInfo(unsigned reg) {\n"
+           "        return reg < REGISTER_COUNT ? RegisterTable[reg] : RegisterInfo {nullptr, 0, ACCESS_NONE};\n"
+           "    }\n\n"
+           "    /**\n"
+           "     * Типизированные регистры для LFSmart::Read<>() и LFSmart::Write<>(): номер, тип значения и доступ\n"
+           "     */\n"
+           "    namespace reg {\n"
+           "        template <Registers R, typename T, unsigned A>\n"
+           "        struct Register {\n"
+           "            using Type = T;\n"
+           "            static constexpr Registers Address = R;\n"
+           "            static constexpr unsigned Access = A;\n"
+           "        };\n\n"
+           "        template <Registers R, typename T, unsigned A> constexpr Registers Register<R, T, A>::Address;\n"
+           "        template <Registers R, typename T, unsigned A> constexpr unsigned Register<R, T, A>::Access;\n\n";
+    for (const auto &reg : spec.Registers) {
+        std::string access = reg.Readable && reg.Writable ? "ACCESS_READ_WRITE"
+                             : reg.Readable ? "ACCESS_READ" : "ACCESS_WRITE";
+        out << "        using " << reg.Name << " = Register<lfc::" << reg.Name << ", " << reg.Type << ", "
+            << access << ">;\n";
+    }
+    out << "    }\n\n"
+           "    /**\n"
+           "     * Группа подряд идущих 16-битных регистров, например каналы. Читается LFSmart::ReadGroup():\n"
+           "     * при Block - одной транзакцией регистра All, иначе - пакетом транзакций SpiTransport::Transfer\n"
+           "     */\n"
+           "    struct RegisterGroup {\n"
+           "        Registers First;            ///< Регистр канала 1\n"
+           "        uint8_t Count;              ///< Регистров подряд\n"
+           "        Registers All;              ///< Регистр всех каналов, INVALID - нет\n"
+           "        bool Block;                 ///< All читает значения всех Count регистров\n"
+           "    };\n\n";
+    for (const auto &group : spec.Groups) {
+        out << "    constexpr RegisterGroup " << Pad("GROUP_" + group.Name, 20) << "= {" << spec.Registers[group.First].Name << ", "
+            << group.Count << ", " << (group.All ? group.All->Name : "INVALID") << ", "
+            << (group.Block ? "true" : "false") << "};\n";
+    }
+    out << "}\n";
+    return out.str();
+}
+
+
+std::string Load(const std::string &path) {
+    std::ifstream file(path, std::ios::binary);
+    std::ostringstream content;
+    content << file.rdbuf();
+    return content.str();
+}
+
+}
+
+
+int main(int argc, char *argv[]) {
+    bool check = argc == 6 && strcmp(argv[5], "--check") == 0;
+    if (argc != 5 && !check) {
+        std::cerr << "Usage: " << argv[0] << " registers.json RegisterMap.hpp RegisterMap.cpp register_map.h [--check]"
+                  << std::endl;
+        return 2;
+    }
+
+    Spec spec;
+    try {
+        std::ifstream input(argv[1]);
+        Require(input.good(), std::string("Cannot open ") + argv[1]);
+        spec = Parse(json::parse(input));
+    } catch (const std::exception &e) {
+        std::cerr << argv[1] << ": " << e.what() << std::endl;
+        return 1;
+    }
+
+    const std::pair<const char *, std::string> outputs[] = {{argv[2], Firmware(spec)},
+                                                             {argv[3], Source(spec)},
+                                                             {argv[4], Host(spec)}};
+    int result = 0;
+    for (const auto &output : outputs) {
+        if (check) {
+            if (Load(output.first) != output.second) {
+                std::cerr << output.first << " is out of date with " << argv[1] << ", build target regmap" << std::endl;
+                result = 1;
+            }
+            continue;
+        }
+        std::ofstream file(output.first, std::ios::binary);
+        file << output.second;
+        if (!file.good()) {
+            std::cerr << "Cannot write " << output.first << std::endl;
+            result = 1;
+        }
+    }
+    return result;
+}
@@ -0,0 +1,150 @@
+/**
+ * @addtogroup applications
+ * Утилиты для управления умным НЧ драйвером
+ * @{
+ */
+
+/**
+  ******************************************************************************
+  * @file   lfsd.cpp
+  * @brief  Сервер адаптеров FT4222 для утилит
+  *
+  * Держит открытыми адаптеры FT4222 и выполняет запросы SPI и I2C утилит через Unix domain socket, поэтому
+  * утилиты не перечисляют устройства и не настраивают адаптер при каждом запуске. Протокол описан в LfServer.
+  * Адаптер работает в одном режиме: запрос I2C к устройству, открытому как SPI, переоткрывает его как I2C.
+  *
+  * Аргументы командной строки:
+  *  - -s --socket: путь сокета, по-умолчанию $LFSD_SOCKET, $XDG_RUNTIME_DIR/lfsd.sock или /tmp/lfsd.sock
+  *  - --loopback: модели LfSimulator и I2cSimulator вместо адаптеров
+  */
+
+/** @} */
+
+#include <csignal>
+#include <iostream>
+#include <map>
+#include <memory>
+#include <system_error>
+#include <fmt/core.h>
+#include <cxxopts.hpp>
+#include <FtdiI2C.h>
+#include <FtdiSpi.h>
+#include <I2cSimulator.h>
+#include <LfClient.h>
+#include <LfServer.h>
+#include <LfSimulator.h>
+#include <common.h>
+
+
+static LfServer *g_pServer = nullptr;
+
+
+static cxxopts::ParseResult parse(int argc, char *argv[]) {
+    try {
+        cxxopts::Options options(argv[0], " - FT4222 device daemon");
+        options.positional_help("[optional args]").show_positional_help();
+        options.add_options()
+        ("h,help", "Print help")
+        ("s,socket", "Unix socket path", cxxopts::value<std::string>()->default_value(LfClient::DefaultSocket()))
+        ("loopback", "Serve simulated devices", cxxopts::value<bool>()->default_value("false"));
+
+        auto result = options.parse(argc, argv);
+        if (result.count("help")) {
+            std::cout << options.help({}) << std::endl;
+            ::exit(RETURN_STATUS::OK);
+        }
+        return result;
+
+    } catch (const cxxopts::OptionException &e) {
+        fmt::print(stderr, "error parsing options: {}\n", e.what());
+        ::exit(RETURN_STATUS::COMMANDLINE_ERROR);
+    }
+}
+
+
+/*
+ * Адаптеры FT4222, открываются при первом запросе
+ */
+class FtdiProvider : public LfDeviceProvider {
+public:
+    SpiTransport &Spi(int device) override {
+        auto &spi = m_mSpi[device];
+        if (!spi) {
+            m_mI2c.erase(device);
+            spi.reset(new FtdiSpi(device));
+            fmt::print("Device {} opened as SPI\n", device);
+        }
+        return *spi;
+    }
+
+    I2cBus &I2c(int device) override {
+        auto &iic = m_mI2c[device];
+        if (!iic) {
+            m_mSpi.erase(device);
+            iic.reset(new FtdiI2C(device));
+            fmt::print("Device {} opened as I2C\n", device);
+        }
+        return *iic;
+    }
+
+private:
+    std::map<int, std::unique_ptr<FtdiSpi>> m_mSpi;
+    std::map<int, std::unique_ptr<FtdiI2C>> m_mI2c;
+};
+
+
+/*
+ * Модели устройств для проверки утилит и скриптов без адаптера
+ */
+class LoopbackProvider : public LfDeviceProvider {
+public:
+    SpiTransport &Spi(int device) override {
+        auto &spi = m_mSpi[device];
+        if (!spi)
+            spi.reset(new LfSimulator());
+        return *spi;
+    }
+
+    I2cBus &I2c(int device) override {
+        auto &iic = m_mI2c[device];
+        if (!iic)
+            iic.reset(new I2cSimulator());
+        return *iic;
+    }
+
+private:
+    std::map<int, std::unique_ptr<LfSimulator>> m_mSpi;
+    std::map<int, std::unique_ptr<I2cSimulator>> m_mI2c;
+};
+
+
+static void OnSignal(int) {
+    if (g_pServer)
+        g_pServer->Stop();
+}
+
+
+int main(int argc, char *argv[]) {
+    auto opts = parse(argc, argv);
+    std::string socketPath = opts["socket"].as<std::string>();
+
+    FtdiProvider ftdi;
+    LoopbackProvider loopback;
+    LfDeviceProvider &devices = opts["loopback"].as<bool>() ? static_cast<LfDeviceProvider &>(loopback)
+                                                            : static_cast<LfDeviceProvider &>(ftdi);
+    try {
+        LfServer server(devices, socketPath);
+        g_pServer = &server;
+        signal(SIGINT, OnSignal);
+        signal(SIGTERM, OnSignal);
+
+        fmt::print("Listening on {}{}\n", socketPath, opts["loopback"].as<bool>() ? " (loopback)" : "");
+        server.Run();
+        g_pServer = nullptr;
+
+    } catch (const std::system_error &e) {
+        fmt::print(stderr, "Socket error: {}\n", e.what());
+        return RETURN_STATUS::FTDI_ERROR;
+    }
+    return RETURN_STATUS::OK;
+}
@@ -0,0 +1,152 @@
+/**
+ * @addtogroup applications
+ * Утилиты для управления умным НЧ драйвером
+ * @{
+ */
+
+/**
+  ******************************************************************************
+  * @file   lftelemetry.cpp
+  * @brief  Запись телеметрии НЧ драйвера в файл
+  *
+  * Читает набор регистров с максимальной скоростью или с заданным периодом и пишет записи в файл телеметрии
+  * (TelemetryFile: столбцы, заголовок JSON). По окончании выводит достигнутую скорость и разброс интервалов.
+  * Запись прерывается Ctrl+C, записанное остаётся в файле.
+  *
+  * Аргументы командной строки:
+  *  - -r --registers: регистры через запятую, по-умолчанию STATUS,ADC_ALL,THRM_PCB,THRM_MCU
+  *  - -p --period: период записей в мкс, по-умолчанию 0 - максимальная скорость
+  *  - -n --samples: количество записей, по-умолчанию 1000, 0 - до Ctrl+C
+  *  - -o --output: файл телеметрии, по-умолчанию telemetry.lft
+  *  - -x --export: вывести файл телеметрии в CSV и выйти
+  *  - -d --device: номер преобразователя USB-SPI, по-умолчанию 0
+  *  - -s --socket: сокет lfsd, по-умолчанию $LFSD_SOCKET, $XDG_RUNTIME_DIR/lfsd.sock или /tmp/lfsd.sock.
+  *    Без lfsd - напрямую через FT4222
+  *  - -t --tries: Количество попыток чтения, по-умолчанию 3
+  *  - --loopback: модель LfSimulator вместо устройства
+  */
+
+/** @} */
+
+#include <csignal>
+#include <iostream>
+#include <sstream>
+#include <stdexcept>
+#include <system_error>
+#include <fmt/core.h>
+#include <cxxopts.hpp>
+#include <LFSmart.h>
+#include <LfSimulator.h>
+#include <TelemetryRecorder.h>
+#include <common.h>
+
+
+static TelemetryRecorder *g_pRecorder = nullptr;
+
+
+static cxxopts::ParseResult parse(int argc, char *argv[]) {
+    try {
+        cxxopts::Options options(argv[0], " - DAC LF controller, telemetry recorder");
+        options.positional_help("[optional args]").show_positional_help();
+        options.add_options()
+        ("h,help", "Print help")
+        ("r,registers", "Registers, comma separated", cxxopts::value<std::string>()->default_value("STATUS,ADC_ALL,THRM_PCB,THRM_MCU"))
+        ("p,period", "Sample period, us, 0 - maximum rate", cxxopts::value<long>()->default_value("0"))
+        ("n,samples", "Samples, 0 - until Ctrl+C", cxxopts::value<uint64_t>()->default_value("1000"))
+        ("o,output", "Telemetry file", cxxopts::value<std::string>()->default_value("telemetry.lft"))
+        ("x,export", "Print telemetry file as CSV", cxxopts::value<std::string>())
+        ("t,tries", "Read tries, default 3", cxxopts::value<int>()->default_value("3"))
+        ("d,device", "FTDI device number, default 0", cxxopts::value<int>()->default_value("0"))
+        ("s,socket", "lfsd socket, empty - direct FTDI access", cxxopts::value<std::string>()->default_value(DaemonSocket()))
+        ("loopback", "Record simulated device", cxxopts::value<bool>()->default_value("false"));
+
+        auto result = options.parse(argc, argv);
+        if (result.count("help")) {
+            std::cout << options.help({}) << std::endl;
+            ::exit(RETURN_STATUS::OK);
+        }
+        return result;
+
+    } catch (const cxxopts::OptionException &e) {
+        fmt::print(stderr, "error parsing options: {}\n", e.what());
+        ::exit(RETURN_STATUS::COMMANDLINE_ERROR);
+    }
+}
+
+
+static void OnSignal(int) {
+    if (g_pRecorder)
+        g_pRecorder->Stop();
+}
+
+
+int main(int argc, char *argv[]) {
+    auto opts = parse(argc, argv);
+
+    if (opts.count("export")) {
+        try {
+            TelemetryReader reader(opts["export"].as<std::string>());
+            reader.ExportCsv(std::cout);
+        } catch (const std::exception &e) {
+            fmt::print(stderr, "Telemetry file error: {}\n", e.what());
+            return RETURN_STATUS::COMMANDLINE_ERROR;
+        }
+        return RETURN_STATUS::OK;
+    }
+
+    std::vector<lfc::Registers> registers;
+    std::stringstream list(opts["registers"].as<std::string>());
+    std::string name;
+    while (std::getline(list, name, ',')) {
+        lfc::Registers reg = TelemetryRecorder::RegisterFromName(name);
+        if (reg == lfc::Registers::INVALID) {
+            fmt::print(stderr, "Unknown register {}\n", name);
+            return RETURN_STATUS::COMMANDLINE_ERROR;
+        }
+        registers.push_back(reg);
+    }
+
+    TelemetryRecorder::Options options;
+    options.Period = std::chrono::microseconds(opts["period"].as<long>());
+    options.Samples = opts["samples"].as<uint64_t>();
+    options.Tries = opts["tries"].as<int>();
+
+    int devnum = opts["device"].as<int>();
+    try {
+        std::unique_ptr<SpiTransport> spi;
+        if (opts["loopback"].as<bool>())
+            spi.reset(new LfSimulator());
+        else
+            spi = OpenSpi(devnum, opts["socket"].as<std::string>());
+
+        TelemetryRecorder recorder(*spi, registers, options);
+        g_pRecorder = &recorder;
+        signal(SIGINT, OnSignal);
+
+        const std::string output = opts["output"].as<std::string>();
+        auto stats = recorder.Record(output, {{"device", devnum}});
+        g_pRecorder = nullptr;
+
+        fmt::print("{} samples to {}, {:.1f} samples/s\n", stats.Samples, output, stats.Rate);
+        fmt::print("Interval mean {:.1f} us, jitter {:.1f} us, max {:.1f} us, late {}\n",
+                   stats.MeanInterval.count() / 1000.0, stats.Jitter.count() / 1000.0,
+                   stats.MaxInterval.count() / 1000.0, stats.Late);
+        if (stats.CrcErrors) {
+            fmt::print(stderr, "{} values with CRC error after {} retries\n", stats.CrcErrors, stats.Retries);
+            return RETURN_STATUS::CRC_ERROR;
+        }
+
+    } catch (const FtdiException &e) {
+        fmt::print(stderr, "FTDI error: {}\n", e.what());
+        return RETURN_STATUS::FTDI_ERROR;
+
+    } catch (const LFSmartException &e) {
+        fmt::print(stderr, "LFDriver error: {}\n", e.what());
+        return e.CrcError() ? RETURN_STATUS::CRC_ERROR : RETURN_STATUS::LFDRV_ERROR;
+
+    } catch (const std::system_error &e) {
+        fmt::print(stderr, "Telemetry file error: {}\n", e.what());
+        return RETURN_STATUS::COMMANDLINE_ERROR;
+    }
+    return RETURN_STATUS::OK;
+}
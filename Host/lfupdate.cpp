@@ -0,0 +1,115 @@
+/**
+ * @addtogroup applications
+ * Утилиты для управления умным НЧ драйвером
+ * @{
+ */
+
+/**
+  ******************************************************************************
+  * @file   lfupdate.cpp
+  * @brief  Обновление прошивки НЧ драйвера по SPI
+  *
+  * Переводит НЧ драйвер в режим обновления битом LF_SVC_UPDATE регистра SVC, передаёт образ через LfUpdater
+  * и после проверки CRC образа во flash сбрасывает плату. Образ - .bin после Tools/append_crc.py с размером
+  * области FLASH_SIZE.
+  *
+  * Аргументы командной строки:
+  *  - -f --file: образ прошивки .bin
+  *  - -d --device: номер преобразователя USB-SPI, по-умолчанию 0
+  *  - -s --socket: сокет lfsd, по-умолчанию $LFSD_SOCKET, $XDG_RUNTIME_DIR/lfsd.sock или /tmp/lfsd.sock.
+  *    Без lfsd - напрямую через FT4222
+  *  - -n --no-reset: не сбрасывать плату после записи
+  */
+
+/** @} */
+
+#include <fstream>
+#include <iostream>
+#include <iterator>
+#include <stdexcept>
+#include <thread>
+#include <vector>
+#include <fmt/core.h>
+#include <cxxopts.hpp>
+#include <FtdiSpi.h>
+#include <LFSmart.h>
+#include <LfUpdater.h>
+#include <commands.h>
+#include <common.h>
+
+
+static cxxopts::ParseResult parse(int argc, char *argv[]) {
+    try {
+        cxxopts::Options options(argv[0], " - DAC LF controller, firmware update");
+        options.positional_help("[optional args]").show_positional_help();
+        options.add_options()
+        ("h,help", "Print help")
+        ("f,file", "Firmware image after append_crc.py", cxxopts::value<std::string>())
+        ("d,device", "FTDI device number, default 0", cxxopts::value<int>()->default_value("0"))
+        ("s,socket", "lfsd socket, empty - direct FTDI access", cxxopts::value<std::string>()->default_value(DaemonSocket()))
+        ("n,no-reset", "Do not reset the board after update", cxxopts::value<bool>()->default_value("false"));
+
+        auto result = options.parse(argc, argv);
+        if (result.count("help")) {
+            std::cout << options.help({}) << std::endl;
+            ::exit(RETURN_STATUS::OK);
+        }
+        if (!result.count("file")) {
+            fmt::print(stderr, "error parsing options: firmware file required\n");
+            ::exit(RETURN_STATUS::COMMANDLINE_ERROR);
+        }
+        return result;
+
+    } catch (const cxxopts::OptionException &e) {
+        fmt::print(stderr, "error parsing options: {}\n", e.what());
+        ::exit(RETURN_STATUS::COMMANDLINE_ERROR);
+    }
+}
+
+
+int main(int argc, char *argv[]) {
+    auto opts = parse(argc, argv);
+
+    std::string file = opts["file"].as<std::string>();
+    std::ifstream input(file, std::ios::binary);
+    if (!input) {
+        fmt::print(stderr, "Can not open {}\n", file);
+        return RETURN_STATUS::COMMANDLINE_ERROR;
+    }
+    std::vector<uint8_t> image((std::istreambuf_iterator<char>(input)), std::istreambuf_iterator<char>());
+    uint32_t crc;
+    if (!LfUpdater::CheckImage(image, crc)) {
+        fmt::print(stderr, "{}: no valid trailing CRC, see Tools/append_crc.py\n", file);
+        return RETURN_STATUS::COMMANDLINE_ERROR;
+    }
+
+    int devnum = opts["device"].as<int>();
+    try {
+        fmt::print("Using FTDI device number {}\n", devnum);
+        auto spi = OpenSpi(devnum, opts["socket"].as<std::string>());
+        LFSmart lfSmart(*spi, true);
+        fmt::print("Running firmware version {}, image {} bytes, CRC 0x{:08X}\n", lfSmart.Version(), image.size(), crc);
+        lfSmart.SVC(LF_SVC_UPDATE);
+        std::this_thread::sleep_for(std::chrono::milliseconds(10));
+
+        LfUpdater updater(*spi);
+        auto stats = updater.Update(image);
+        fmt::print("Written and verified in {:.2f} s, {:.1f} KiB/s, {} frames, {} retransmitted, {} polls\n",
+                   stats.Elapsed.count() / 1e6, stats.Rate() / 1024, stats.Frames, stats.Retransmits, stats.Polls);
+        if (!opts["no-reset"].as<bool>())
+            updater.Reset();
+
+    } catch (const FtdiException &e) {
+        fmt::print(stderr, "FTDI error: {}\n", e.what());
+        return RETURN_STATUS::FTDI_ERROR;
+
+    } catch (const LFSmartException &e) {
+        fmt::print(stderr, "LFDriver error: {}\n", e.what());
+        return e.CrcError() ? RETURN_STATUS::CRC_ERROR : RETURN_STATUS::LFDRV_ERROR;
+
+    } catch (const std::exception &e) {
+        fmt::print(stderr, "Update error: {}\n", e.what());
+        return RETURN_STATUS::LFDRV_ERROR;
+    }
+    return RETURN_STATUS::OK;
+}
@@ -0,0 +1,169 @@
+#include <atomic>
+#include <thread>
+#include <vector>
+#include "adc_pipeline.h"
+#include "gtest/gtest.h"
+
+namespace {
+
+    /*
+     * Модель регистра ADCx_RESULT в режиме переключения каналов: входы CHSEL перебираются по возрастанию,
+     * каждое слово несёт значение и номер входа. Значение входа задаёт функция Signal.
+     */
+    class AdcResultMock {
+    public:
+        AdcResultMock(uint32_t chsel, uint8_t start, uint16_t (*signal)(uint8_t input, uint32_t n))
+            : m_uChsel(chsel), m_uInput(start), m_pSignal(signal) {}
+
+        uint32_t Read() {
+            uint32_t word = (static_cast<uint32_t>(m_uInput) << ADC_PIPELINE_INPUT_Pos) |
+                            (m_pSignal(m_uInput, m_uCount++) & ADC_PIPELINE_VALUE_Msk);
+            do {
+                m_uInput = (m_uInput + 1) % ADC_PIPELINE_INPUTS;
+            } while ((m_uChsel & (1UL << m_uInput)) == 0);
+            return word;
+        }
+
+        // Половина буфера DMA
+        std::vector<uint32_t> Block(size_t size) {
+            std::vector<uint32_t> block(size);
+            for (auto &word : block)
+                word = Read();
+            return block;
+        }
+
+    private:
+        uint32_t m_uChsel;
+        uint8_t m_uInput;
+        uint16_t (*m_pSignal)(uint8_t, uint32_t);
+        uint32_t m_uCount = 0;
+    };
+
+    uint16_t Constant(uint8_t input, uint32_t) {
+        return 100 * (input + 1);
+    }
+
+    // Шум +-2 вокруг 1000 + input
+    uint16_t Noisy(uint8_t input, uint32_t n) {
+        static const int noise[] = {-2, 1, 0, 2, -1};
+        return 1000 + input + noise[n % 5];
+    }
+
+    void MapDefault(AdcPipeline &p) {
+        AdcPipelineInit(p);
+        AdcPipelineMap(p, 0, 0);
+        AdcPipelineMap(p, 1, 1);
+        AdcPipelineMap(p, 4, 2);
+        AdcPipelineMap(p, 7, 3);
+    }
+
+    TEST(AdcPipeline, NoDataBeforePublish) {
+        AdcPipeline p;
+        MapDefault(p);
+        AdcSnapshot s;
+        EXPECT_EQ(AdcPipelineRead(p, s), 0u);
+        EXPECT_EQ(s.Value[0], 0);
+    }
+
+    TEST(AdcPipeline, DemultiplexesByInputTag) {
+        AdcPipeline p;
+        MapDefault(p);
+        AdcResultMock adc1(0x03, 0, Constant);
+        AdcResultMock adc2(0x90, 7, Constant);     // фаза после запуска произвольная
+        auto b1 = adc1.Block(64);
+        auto b2 = adc2.Block(63);
+        AdcPipelineFeed(p, b1.data(), b1.size());
+        AdcPipelineFeed(p, b2.data(), b2.size());
+        AdcPipelinePublish(p);
+
+        AdcSnapshot s;
+        EXPECT_EQ(AdcPipelineRead(p, s), 1u);
+        EXPECT_EQ(s.Value[0], 100);
+        EXPECT_EQ(s.Value[1], 200);
+        EXPECT_EQ(s.Value[2], 500);
+        EXPECT_EQ(s.Value[3], 800);
+        EXPECT_EQ(p.Unmapped, 0u);
+    }
+
+    TEST(AdcPipeline, AveragesOverPeriod) {
+        AdcPipeline p;
+        MapDefault(p);
+        AdcResultMock adc1(0x03, 1, Noisy);
+        auto block = adc1.Block(100);
+        AdcPipelineFeed(p, block.data(), block.size());
+        AdcPipelinePublish(p);
+
+        AdcSnapshot s;
+        AdcPipelineRead(p, s);
+        EXPECT_NEAR(s.Value[0], 1000, 1);
+        EXPECT_NEAR(s.Value[1], 1001, 1);
+    }
+
+    TEST(AdcPipeline, ChannelWithoutSamplesKeepsValue) {
+        AdcPipeline p;
+        MapDefault(p);
+        AdcResultMock adc1(0x03, 0, Constant);
+        AdcResultMock adc2(0x90, 4, Constant);
+        auto b1 = adc1.Block(8);
+        auto b2 = adc2.Block(8);
+        AdcPipelineFeed(p, b1.data(), b1.size());
+        AdcPipelineFeed(p, b2.data(), b2.size());
+        AdcPipelinePublish(p);
+
+        // Следующий период только ADC1
+        b1 = adc1.Block(8);
+        AdcPipelineFeed(p, b1.data(), b1.size());
+        AdcPipelinePublish(p);
+
+        AdcSnapshot s;
+        EXPECT_EQ(AdcPipelineRead(p, s), 2u);
+        EXPECT_EQ(s.Value[2], 500);
+        EXPECT_EQ(s.Value[3], 800);
+    }
+
+    TEST(AdcPipeline, UnmappedInputsCounted) {
+        AdcPipeline p;
+        MapDefault(p);
+        AdcResultMock adc1((1UL << 0) | (1UL << 1) | (1UL << 31), 0, Constant);   // + датчик температуры
+        auto block = adc1.Block(30);
+        AdcPipelineFeed(p, block.data(), block.size());
+        AdcPipelinePublish(p);
+
+        AdcSnapshot s;
+        AdcPipelineRead(p, s);
+        EXPECT_EQ(p.Unmapped, 10u);
+        EXPECT_EQ(s.Value[0], 100);
+        EXPECT_EQ(s.Value[1], 200);
+    }
+
+    // Снимок не разрывается при публикации из другого потока: все каналы из одной публикации
+    TEST(AdcPipeline, SnapshotIsCoherent) {
+        AdcPipeline p;
+        MapDefault(p);
+        std::atomic<bool> done {false};
+
+        std::thread writer([&] {
+            for (uint32_t k = 1; k < 200000; k++) {
+                uint16_t value = k & ADC_PIPELINE_VALUE_Msk;
+                uint32_t block[4] = {value, (1U << 16) | value, (4U << 16) | value, (7U << 16) | value};
+                AdcPipelineFeed(p, block, 4);
+                AdcPipelinePublish(p);
+            }
+            done = true;
+        });
+
+        uint32_t torn = 0, reads = 0, last = 0;
+        while (!done) {
+            AdcSnapshot s;
+            uint32_t sequence = AdcPipelineRead(p, s);
+            EXPECT_GE(sequence, last);
+            last = sequence;
+            if (s.Value[0] != s.Value[1] || s.Value[0] != s.Value[2] || s.Value[0] != s.Value[3])
+                torn++;
+            reads++;
+        }
+        writer.join();
+        EXPECT_EQ(torn, 0u);
+        EXPECT_GT(reads, 0u);
+    }
+}
@@ -0,0 +1,117 @@
+#include <random>
+#include <vector>
+#include "capture_timeline.h"
+#include "gtest/gtest.h"
+
+namespace {
+
+    /*
+     * Модель захвата: CNT(t) = t mod M, событие CNT == ARR в момент j*M - 1, прерывание переполнения в j*M + L_j.
+     * Прерывание читает CNT в момент t_isr, позицию DMA в t_isr + 1. DMA записывает отсчёт через 1 тик после захвата.
+     */
+    struct CaptureModel {
+        uint32_t Modulus;
+        std::vector<uint64_t> Edges;            // истинные моменты захвата
+        std::vector<uint16_t> Samples;          // значения CCR в порядке записи DMA
+        std::vector<CaptureMarker> Markers;
+
+        void Run(std::mt19937 &rnd, uint32_t min_latency, uint32_t max_latency) {
+            uint64_t end = Edges.back() + 2 * Modulus;
+            uint32_t last_index = 0;
+            uint16_t last_cnt = 0;
+            size_t written = 0;
+            for (auto e : Edges)
+                Samples.push_back(e % Modulus);
+
+            for (uint32_t j = 1; (uint64_t)j * Modulus < end; j++) {
+                uint64_t t_isr = (uint64_t)j * Modulus + min_latency + rnd() % (max_latency - min_latency + 1);
+                uint16_t cnt = t_isr % Modulus;
+                while (written < Edges.size() && Edges[written] + 1 <= t_isr + 1)
+                    written++;
+                if (written != last_index) {
+                    Markers.push_back({(uint32_t)written, j, cnt, last_cnt});
+                    last_index = written;
+                }
+                last_cnt = cnt;
+            }
+        }
+
+        std::vector<uint64_t> Extend() const {
+            CaptureTimeline tl;
+            CaptureTimelineInit(tl, Modulus);
+            std::vector<uint64_t> result;
+            size_t m = 0;
+            for (uint32_t k = 0; k < Samples.size(); k++) {
+                while (Markers[m].Index <= k)
+                    m++;
+                result.push_back(CaptureTimelineExtend(tl, Samples[k], Markers[m]));
+            }
+            return result;
+        }
+    };
+
+    TEST(CaptureTimeline, FastPeriodicSignal) {
+        std::mt19937 rnd(1);
+        CaptureModel model {65536, {}, {}, {}};
+        for (uint64_t t = 100; t < 20 * 65536; t += 37)
+            model.Edges.push_back(t);
+        model.Run(rnd, 10, 40);
+        EXPECT_EQ(model.Extend(), model.Edges);
+    }
+
+    TEST(CaptureTimeline, SlowSignalSpansOverflows) {
+        std::mt19937 rnd(2);
+        CaptureModel model {1000, {}, {}, {}};
+        for (uint64_t t = 500; t < 200000; t += 2345)
+            model.Edges.push_back(t);
+        model.Run(rnd, 5, 20);
+        EXPECT_EQ(model.Extend(), model.Edges);
+    }
+
+    // Фронты сразу после переполнения, до прерывания: отсчёт попадает в сегмент предыдущего периода
+    TEST(CaptureTimeline, EdgeBetweenOverflowAndInterrupt) {
+        std::mt19937 rnd(3);
+        CaptureModel model {1000, {}, {}, {}};
+        for (uint64_t j = 1; j < 100; j++) {
+            model.Edges.push_back(j * 1000 - 300);
+            model.Edges.push_back(j * 1000 + 2);
+        }
+        model.Run(rnd, 10, 10);
+        EXPECT_EQ(model.Extend(), model.Edges);
+    }
+
+    TEST(CaptureTimeline, RandomBursts) {
+        std::mt19937 rnd(4);
+        CaptureModel model {4096, {}, {}, {}};
+        uint64_t t = 10;
+        for (int i = 0; i < 50000; i++) {
+            t += (rnd() % 10 == 0) ? 1 + rnd() % 20000 : 1 + rnd() % 50;
+            model.Edges.push_back(t);
+        }
+        // Постоянная задержка прерывания: окна неоднозначности нет
+        model.Run(rnd, 25, 25);
+        EXPECT_EQ(model.Extend(), model.Edges);
+    }
+
+    // С джиттером задержки ошибки возможны только для первого отсчёта сегмента в окне (PrevCnt, Cnt]
+    TEST(CaptureTimeline, LatencyJitterWindow) {
+        std::mt19937 rnd(5);
+        CaptureModel model {4096, {}, {}, {}};
+        uint64_t t = 10;
+        for (int i = 0; i < 50000; i++) {
+            t += (rnd() % 10 == 0) ? 1 + rnd() % 20000 : 1 + rnd() % 50;
+            model.Edges.push_back(t);
+        }
+        model.Run(rnd, 10, 40);
+        auto extended = model.Extend();
+        size_t errors = 0;
+        for (size_t i = 0; i < extended.size(); i++) {
+            if (extended[i] != model.Edges[i]) {
+                errors++;
+                EXPECT_EQ(extended[i] + model.Modulus, model.Edges[i]);
+                EXPECT_LE(model.Edges[i] % model.Modulus, 40u);
+            }
+        }
+        EXPECT_LT(errors, extended.size() / 1000);
+    }
+}
@@ -0,0 +1,167 @@
+#include <cmath>
+#include <vector>
+#include "dds_engine.h"
+#include "gtest/gtest.h"
+
+namespace {
+
+    const uint32_t SampleRate = 50000;
+    const uint32_t Points = 4096;
+
+    // Коды канала из слов DAC1_DATA
+    std::vector<double> Channel(const std::vector<uint32_t> &words, uint32_t channel) {
+        std::vector<double> codes;
+        for (auto word : words)
+            codes.push_back((word >> (channel * DDS_DAC_HI_Pos)) & DDS_DAC_MAX);
+        return codes;
+    }
+
+    // Мощность бинов ДПФ без постоянной составляющей, 1..N/2 - 1
+    std::vector<double> Spectrum(const std::vector<double> &signal) {
+        const size_t n = signal.size();
+        std::vector<double> power(n / 2, 0.0);
+        for (size_t bin = 1; bin < n / 2; bin++) {
+            double re = 0, im = 0;
+            for (size_t i = 0; i < n; i++) {
+                double angle = 2 * M_PI * bin * i / n;
+                re += signal[i] * std::cos(angle);
+                im -= signal[i] * std::sin(angle);
+            }
+            power[bin] = re * re + im * im;
+        }
+        return power;
+    }
+
+    // Когерентный тон: ровно cycles периодов на Points отсчётов
+    void SetCoherent(DdsEngine &dds, uint32_t channel, uint32_t cycles, uint16_t amplitude) {
+        dds.Channel[channel].Step = static_cast<uint32_t>((static_cast<uint64_t>(cycles) << 32) / Points);
+        dds.Channel[channel].Amplitude = amplitude;
+    }
+
+    TEST(DdsEngine, TuningWordRoundTrip) {
+        uint32_t step = DdsTuningWord(1000000, SampleRate);         // 1 кГц
+        EXPECT_EQ(step, 85899346u);
+        EXPECT_NEAR(DdsFrequency(step, SampleRate), 1000000u, 1u);
+
+        // Разрешение Fs / 2^32 ~ 12 мкГц, ошибка округления не больше половины шага
+        for (uint32_t mhz : {1u, 12345u, 999999u, 24999999u}) {
+            EXPECT_NEAR(DdsFrequency(DdsTuningWord(mhz, SampleRate), SampleRate), mhz, 1u);
+        }
+    }
+
+    TEST(DdsEngine, SineMatchesReference) {
+        int32_t maxError = 0;
+        for (uint32_t i = 0; i < 65536; i++) {
+            uint32_t phase = i * 65536u + 12345u;
+            int32_t expected = static_cast<int32_t>(std::lround(32767 * std::sin(2 * M_PI * phase / 4294967296.0)));
+            maxError = std::max(maxError, std::abs(DdsSine(phase) - expected));
+        }
+        EXPECT_LE(maxError, 3);
+
+        EXPECT_EQ(DdsSine(0), 0);
+        EXPECT_EQ(DdsSine(0x40000000u), 32767);
+        EXPECT_EQ(DdsSine(0x80000000u), 0);
+        EXPECT_EQ(DdsSine(0xC0000000u), -32767);
+    }
+
+    TEST(DdsEngine, ScaleClampsToDacRange) {
+        EXPECT_EQ(DdsScale(0, 2000, 2048), 2048u);
+        EXPECT_EQ(DdsScale(32767, 2047, 2048), 4095u);
+        EXPECT_EQ(DdsScale(-32767, 2047, 2048), 1u);
+        EXPECT_EQ(DdsScale(32767, 4000, 2048), DDS_DAC_MAX);
+        EXPECT_EQ(DdsScale(-32767, 4000, 2048), 0u);
+    }
+
+    TEST(DdsEngine, SynchronousWordLayout) {
+        DdsEngine dds;
+        DdsInit(dds, SampleRate);
+        dds.Channel[0].Offset = 0x123;
+        dds.Channel[1].Offset = 0xABC;
+        uint32_t word;
+        DdsFill(dds, &word, 1);
+        EXPECT_EQ(word, 0x0ABC0123u);
+    }
+
+    // Спектральная чистота: выше всех гармоник и шума только основной тон, ограничение - квантование 12 бит
+    TEST(DdsEngine, SpuriousFreeDynamicRange) {
+        DdsEngine dds;
+        DdsInit(dds, SampleRate);
+        SetCoherent(dds, 0, 37, 2000);
+        SetCoherent(dds, 1, 411, 1500);
+
+        std::vector<uint32_t> words(Points);
+        DdsFill(dds, words.data(), Points);
+
+        const uint32_t tones[] = {37, 411};
+        for (uint32_t ch = 0; ch < DDS_CHANNELS; ch++) {
+            auto power = Spectrum(Channel(words, ch));
+            double spur = 0;
+            for (size_t bin = 1; bin < power.size(); bin++) {
+                if (bin != tones[ch])
+                    spur = std::max(spur, power[bin]);
+            }
+            double sfdr = 10 * std::log10(power[tones[ch]] / spur);
+            EXPECT_GT(sfdr, 75.0) << "channel " << ch;
+        }
+    }
+
+    TEST(DdsEngine, BlocksAreContinuous) {
+        DdsEngine whole, split;
+        DdsInit(whole, SampleRate);
+        DdsInit(split, SampleRate);
+        for (auto *dds : {&whole, &split}) {
+            dds->Channel[0].Step = DdsTuningWord(1234567, SampleRate);
+            dds->Channel[0].Amplitude = 2047;
+            dds->Channel[1].Step = DdsTuningWord(7654321, SampleRate);
+            dds->Channel[1].Amplitude = 1000;
+        }
+
+        std::vector<uint32_t> expected(1000), actual(1000);
+        DdsFill(whole, expected.data(), expected.size());
+        for (size_t offset = 0; offset < actual.size(); offset += 100)
+            DdsFill(split, actual.data() + offset, 100);
+
+        EXPECT_EQ(actual, expected);
+        EXPECT_EQ(split.Channel[0].Phase, whole.Channel[0].Phase);
+    }
+
+    TEST(DdsEngine, FrequencyChangeKeepsPhase) {
+        DdsEngine dds;
+        DdsInit(dds, SampleRate);
+        dds.Channel[0].Step = DdsTuningWord(1000000, SampleRate);
+        dds.Channel[0].Amplitude = 2047;
+
+        std::vector<uint32_t> block(100);
+        DdsFill(dds, block.data(), block.size());
+        uint32_t phase = dds.Channel[0].Phase;
+        EXPECT_EQ(phase, 100 * dds.Channel[0].Step);
+
+        dds.Channel[0].Step = DdsTuningWord(3000000, SampleRate);
+        DdsFill(dds, block.data(), block.size());
+        EXPECT_EQ(block[0] & DDS_DAC_MAX, DdsScale(DdsSine(phase), 2047, 2048));
+        EXPECT_EQ(dds.Channel[0].Phase, phase + 100 * dds.Channel[0].Step);
+    }
+
+    TEST(DdsEngine, FrequencyAccuracyFromZeroCrossings) {
+        DdsEngine dds;
+        DdsInit(dds, SampleRate);
+        dds.Channel[0].Step = DdsTuningWord(1234567, SampleRate);   // 1234.567 Гц
+        dds.Channel[0].Amplitude = 2047;
+
+        std::vector<uint32_t> words(SampleRate);                    // 1 с
+        DdsFill(dds, words.data(), words.size());
+        auto codes = Channel(words, 0);
+
+        int first = -1, last = -1, crossings = 0;
+        for (size_t i = 1; i < codes.size(); i++) {
+            if (codes[i - 1] < 2048 && codes[i] >= 2048) {
+                if (first < 0)
+                    first = i;
+                last = i;
+                crossings++;
+            }
+        }
+        double frequency = (crossings - 1) * static_cast<double>(SampleRate) / (last - first);
+        EXPECT_NEAR(frequency, 1234.567, 0.05);
+    }
+}
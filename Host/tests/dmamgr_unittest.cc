@@ -0,0 +1,290 @@
+#include <cstring>
+#include <vector>
+#include "dma_table.h"
+#include "gtest/gtest.h"
+
+namespace {
+
+    const uint32_t Base = 0x20000000;
+    const uint32_t TableAddress = Base;                 // Таблица выровнена на 1 КБ, как DMA_ControlTable
+    const uint32_t TasksAddress = Base + 0x400;
+    const uint32_t DataAddress = Base + 0x800;
+    const uint32_t RegisterAddress = 0x40000000;        // Регистр данных периферии, например SSP2->DR
+
+    /*
+     * Модель PL230: управляющие структуры читаются из памяти модели, как это делает контроллер.
+     * Цепочка памяти выполняется целиком по программному запросу, в цепочке периферии копирование задачи
+     * основной структурой не ждёт запроса, каждая пересылка задачи - один запрос.
+     */
+    struct DmaModel {
+        std::vector<uint8_t> Memory = std::vector<uint8_t>(0x2000, 0);
+        std::vector<uint32_t> RegisterWrites;
+        uint32_t Enabled = 0;
+        uint32_t PriAlt = 0;
+        uint32_t Done = 0;                              // Сигналов dma_done
+
+        uint32_t Read(uint32_t address, uint32_t size) {
+            uint32_t value = 0;
+            memcpy(&value, &Memory.at(address - Base), size);
+            return value;
+        }
+
+        void Write(uint32_t address, uint32_t value, uint32_t size) {
+            if (address == RegisterAddress) {
+                RegisterWrites.push_back(value);
+                return;
+            }
+            memcpy(&Memory.at(address - Base), &value, size);
+        }
+
+        DmaDescriptor *Structure(uint32_t address) {
+            return reinterpret_cast<DmaDescriptor *>(&Memory.at(address - Base));
+        }
+
+        DmaDescriptor *Primary() { return Structure(TableAddress); }
+        DmaDescriptor *Alternate() { return Structure(TableAddress + DMA_TABLE_ALT_OFFSET); }
+
+        void Put(uint32_t address, const void *data, size_t size) {
+            memcpy(&Memory.at(address - Base), data, size);
+        }
+
+        void Start(uint8_t channel, bool alternate) {
+            Enabled |= 1UL << channel;
+            if (alternate)
+                PriAlt |= 1UL << channel;
+            else
+                PriAlt &= ~(1UL << channel);
+        }
+
+        // Пересылка 2^R элементов текущей структуры. false - структура отработала или канал выключен
+        bool Arbitrate(uint8_t channel) {
+            uint32_t bit = 1UL << channel;
+            if ((Enabled & bit) == 0)
+                return false;
+            bool alternate = (PriAlt & bit) != 0;
+            DmaDescriptor &d = alternate ? Alternate()[channel] : Primary()[channel];
+            uint32_t cycle = d.Control & DMA_CYCLE_Msk;
+            if (cycle == DMA_CYCLE_STOP) {
+                Enabled &= ~bit;
+                return false;
+            }
+
+            uint32_t items = 1UL << ((d.Control >> DMA_R_POWER_Pos) & 0xF);
+            for (uint32_t i = 0; i < items; i++) {
+                uint32_t control = d.Control;
+                uint32_t remaining = (control & DMA_N_MINUS_1_Msk) >> DMA_N_MINUS_1_Pos;
+                uint32_t srcSize = (control >> DMA_SRC_SIZE_Pos) & 3;
+                uint32_t srcInc = (control >> DMA_SRC_INC_Pos) & 3;
+                uint32_t dstInc = (control >> DMA_DST_INC_Pos) & 3;
+                uint32_t src = d.SourceEnd - (srcInc == DMA_INC_NONE ? 0 : remaining << srcInc);
+                uint32_t dst = d.DestEnd - (dstInc == DMA_INC_NONE ? 0 : remaining << dstInc);
+                if (cycle == DMA_CYCLE_MEM_SG_PRI || cycle == DMA_CYCLE_PER_SG_PRI)
+                    dst = d.DestEnd - ((remaining & 3) << 2);  // Каждые 4 слова - в ту же альтернативную структуру
+                Write(dst, Read(src, 1UL << srcSize), 1UL << srcSize);
+                if (remaining > 0) {
+                    d.Control = (control & ~DMA_N_MINUS_1_Msk) | ((remaining - 1) << DMA_N_MINUS_1_Pos);
+                    continue;
+                }
+                // Конец цикла структуры
+                d.Control = control & ~DMA_CYCLE_Msk;
+                EndOfCycle(channel, cycle, alternate);
+                return false;
+            }
+            // Основная структура scatter-gather после 4 слов передаёт управление задаче
+            if (cycle == DMA_CYCLE_MEM_SG_PRI || cycle == DMA_CYCLE_PER_SG_PRI)
+                PriAlt |= bit;
+            return true;
+        }
+
+        void EndOfCycle(uint8_t channel, uint32_t cycle, bool alternate) {
+            uint32_t bit = 1UL << channel;
+            switch (cycle) {
+                case DMA_CYCLE_PINGPONG:
+                    Done++;
+                    PriAlt ^= bit;
+                    if (((alternate ? Primary() : Alternate())[channel].Control & DMA_CYCLE_Msk) == DMA_CYCLE_STOP)
+                        Enabled &= ~bit;
+                    break;
+                case DMA_CYCLE_MEM_SG_PRI:
+                case DMA_CYCLE_PER_SG_PRI:
+                    PriAlt |= bit;          // Последняя задача скопирована
+                    break;
+                case DMA_CYCLE_MEM_SG_ALT:
+                case DMA_CYCLE_PER_SG_ALT:
+                    PriAlt &= ~bit;         // Задача выполнена, следующую копирует основная структура
+                    break;
+                default:
+                    Done++;
+                    Enabled &= ~bit;
+                    break;
+            }
+        }
+
+        void SoftwareRequest(uint8_t channel) {
+            while (Enabled & (1UL << channel))
+                Arbitrate(channel);
+        }
+
+        void PeripheralRequest(uint8_t channel) {
+            uint32_t bit = 1UL << channel;
+            while ((Enabled & bit) && (PriAlt & bit) == 0 &&
+                   (Primary()[channel].Control & DMA_CYCLE_Msk) == DMA_CYCLE_PER_SG_PRI)
+                Arbitrate(channel);         // Копирование задачи без запроса
+            Arbitrate(channel);
+        }
+
+        uint32_t Scan(DmaCompletion &state) {
+            return DmaCompletionScan(state, Enabled, Primary(), Alternate());
+        }
+    };
+
+
+    TEST(DmaTable, ChainPrimaryMatchesSplScatterGather) {
+        DmaDescriptor primary;
+        uint32_t alternate = TableAddress + DMA_TABLE_ALT_OFFSET + 6 * sizeof(DmaDescriptor);
+        DmaChainPrimary(primary, TasksAddress, 3, alternate, false);
+        // DMA_SG_Init(): word, шаг word, R = 2 (DMA_Transfers_4), n = 4 * 3, DMA_Mode_MemScatterPri, privileged
+        EXPECT_EQ(primary.Control, 0xAA2480B4u);
+        EXPECT_EQ(primary.SourceEnd, TasksAddress + 3 * 16 - 4);
+        EXPECT_EQ(primary.DestEnd, alternate + 12);
+
+        DmaChainPrimary(primary, TasksAddress, 3, alternate, true);
+        EXPECT_EQ(primary.Control & DMA_CYCLE_Msk, static_cast<uint32_t>(DMA_CYCLE_PER_SG_PRI));
+    }
+
+    TEST(DmaTable, SegmentDescriptorEndAddresses) {
+        DmaDescriptor d;
+        DmaSegmentDescriptor(d, {0x1000, 0x2000, 10, 1, 0}, DMA_CYCLE_BASIC, 0);
+        EXPECT_EQ(d.SourceEnd, 0x1000u + 9 * 2);
+        EXPECT_EQ(d.DestEnd, 0x2000u + 9 * 2);
+        EXPECT_EQ((d.Control & DMA_N_MINUS_1_Msk) >> DMA_N_MINUS_1_Pos, 9u);
+
+        DmaSegmentDescriptor(d, {0x1000, 0x2000, 10, 2, DMA_SEGMENT_DEST_FIXED}, DMA_CYCLE_BASIC, 0);
+        EXPECT_EQ(d.SourceEnd, 0x1000u + 9 * 4);
+        EXPECT_EQ(d.DestEnd, 0x2000u);
+        EXPECT_EQ(d.Control >> DMA_DST_INC_Pos, static_cast<uint32_t>(DMA_INC_NONE));
+    }
+
+    TEST(DmaTable, MemoryChainGathersSegments) {
+        DmaModel dma;
+        const uint8_t channel = 13;
+        const uint8_t bytes[5] = {1, 2, 3, 4, 5};
+        const uint16_t halves[3] = {0x1111, 0x2222, 0x3333};
+        const uint32_t words[2] = {0xDEADBEEF, 0x01234567};
+        dma.Put(DataAddress, bytes, sizeof(bytes));
+        dma.Put(DataAddress + 0x10, halves, sizeof(halves));
+        dma.Put(DataAddress + 0x20, words, sizeof(words));
+
+        const uint32_t out = DataAddress + 0x100;
+        DmaSegment segments[] = {
+                {DataAddress, out, 5, 0, 0},
+                {DataAddress + 0x10, out + 6, 3, 1, 0},
+                {DataAddress + 0x20, out + 12, 2, 2, 0},
+                {DataAddress, out + 20, 4, 0, DMA_SEGMENT_SOURCE_FIXED},    // Заполнение первым байтом
+        };
+        const uint32_t count = sizeof(segments) / sizeof(segments[0]);
+        DmaChainBuild(dma.Structure(TasksAddress), segments, count, false);
+        DmaChainPrimary(dma.Primary()[channel], TasksAddress, count,
+                        TableAddress + DMA_TABLE_ALT_OFFSET + channel * sizeof(DmaDescriptor), false);
+
+        DmaCompletion state = {};
+        state.Armed = 1UL << channel;
+        dma.Start(channel, false);
+        EXPECT_EQ(dma.Scan(state), 0u);
+
+        dma.SoftwareRequest(channel);
+        EXPECT_EQ(dma.Done, 1u);
+        EXPECT_EQ(dma.Enabled, 0u);
+
+        const uint8_t expected[24] = {1, 2, 3, 4, 5, 0,
+                                      0x11, 0x11, 0x22, 0x22, 0x33, 0x33,
+                                      0xEF, 0xBE, 0xAD, 0xDE, 0x67, 0x45, 0x23, 0x01,
+                                      1, 1, 1, 1};
+        EXPECT_EQ(0, memcmp(&dma.Memory[out - Base], expected, sizeof(expected)));
+
+        EXPECT_EQ(dma.Scan(state), 1UL << channel);
+        EXPECT_EQ(dma.Scan(state), 0u);
+    }
+
+    TEST(DmaTable, PeripheralChainFeedsDataRegister) {
+        DmaModel dma;
+        const uint8_t channel = 6;                      // DMA_Channel_SSP2_TX
+        const uint16_t header[2] = {0xA5A5, 0x0007};
+        const uint16_t payload[5] = {10, 20, 30, 40, 50};
+        dma.Put(DataAddress, header, sizeof(header));
+        dma.Put(DataAddress + 0x10, payload, sizeof(payload));
+
+        DmaSegment segments[] = {
+                {DataAddress, RegisterAddress, 2, 1, DMA_SEGMENT_DEST_FIXED},
+                {DataAddress + 0x10, RegisterAddress, 5, 1, DMA_SEGMENT_DEST_FIXED},
+        };
+        DmaChainBuild(dma.Structure(TasksAddress), segments, 2, true);
+        DmaChainPrimary(dma.Primary()[channel], TasksAddress, 2,
+                        TableAddress + DMA_TABLE_ALT_OFFSET + channel * sizeof(DmaDescriptor), true);
+
+        DmaCompletion state = {};
+        state.Armed = 1UL << channel;
+        dma.Start(channel, false);
+        for (uint32_t i = 0; i < 7; i++) {
+            EXPECT_EQ(dma.Scan(state), 0u) << i;
+            dma.PeripheralRequest(channel);
+        }
+        EXPECT_EQ(dma.RegisterWrites, std::vector<uint32_t>({0xA5A5, 0x0007, 10, 20, 30, 40, 50}));
+        EXPECT_EQ(dma.Done, 1u);
+        EXPECT_EQ(dma.Scan(state), 1UL << channel);
+
+        // Лишний запрос в выключенный канал ничего не пересылает
+        dma.PeripheralRequest(channel);
+        EXPECT_EQ(dma.RegisterWrites.size(), 7u);
+        EXPECT_EQ(dma.Scan(state), 0u);
+    }
+
+    TEST(DmaTable, PingPongReportsEachHalfOnce) {
+        DmaModel dma;
+        const uint8_t channel = 8;                      // DMA_Channel_ADC1
+        const uint32_t half = 4;
+        const uint32_t result = DataAddress + 0x40;    // Слово результата АЦП
+        DmaSegmentDescriptor(dma.Primary()[channel], {result, DataAddress, half, 2, DMA_SEGMENT_SOURCE_FIXED},
+                             DMA_CYCLE_PINGPONG, 0);
+        DmaSegmentDescriptor(dma.Alternate()[channel], {result, DataAddress + 0x10, half, 2, DMA_SEGMENT_SOURCE_FIXED},
+                             DMA_CYCLE_PINGPONG, 0);
+        uint32_t control = dma.Primary()[channel].Control;
+
+        DmaCompletion state = {};
+        state.Continuous = 1UL << channel;
+        dma.Start(channel, false);
+        for (uint32_t i = 0; i < half; i++)
+            dma.PeripheralRequest(channel);
+        EXPECT_EQ(dma.Scan(state), 1UL << channel);     // primary
+        EXPECT_EQ(dma.Scan(state), 0u);                 // та же половина повторно не сообщается
+
+        dma.Primary()[channel].Control = control;       // Перезапуск primary
+        for (uint32_t i = 0; i < half; i++)
+            dma.PeripheralRequest(channel);
+        EXPECT_EQ(dma.Scan(state), 1UL << channel);     // alternate
+        EXPECT_TRUE(dma.Enabled & (1UL << channel));
+
+        dma.Alternate()[channel].Control = control;
+        for (uint32_t i = 0; i < half; i++)
+            dma.PeripheralRequest(channel);
+        EXPECT_EQ(dma.Scan(state), 1UL << channel);     // primary после перезапуска
+        EXPECT_EQ(dma.Done, 3u);
+    }
+
+    TEST(DmaTable, ChannelAllocation) {
+        uint32_t claimed = 0;
+        EXPECT_TRUE(DmaChannelClaim(claimed, 6));
+        EXPECT_FALSE(DmaChannelClaim(claimed, 6));
+        EXPECT_TRUE(DmaChannelClaim(claimed, 8));
+
+        EXPECT_EQ(DmaChannelClaimFree(claimed, 13, 31), 13);
+        EXPECT_EQ(DmaChannelClaimFree(claimed, 13, 31), 14);
+        EXPECT_TRUE(DmaChannelClaim(claimed, 16));
+        EXPECT_EQ(DmaChannelClaimFree(claimed, 13, 31), 15);
+        EXPECT_EQ(DmaChannelClaimFree(claimed, 13, 31), 17);
+
+        EXPECT_EQ(DmaChannelClaimFree(claimed, 30, 31), 30);
+        EXPECT_EQ(DmaChannelClaimFree(claimed, 30, 31), 31);
+        EXPECT_EQ(DmaChannelClaimFree(claimed, 30, 31), DMA_TABLE_CHANNEL_NONE);
+    }
+}
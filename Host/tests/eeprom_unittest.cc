@@ -0,0 +1,117 @@
+#include <numeric>
+#include <stdexcept>
+#include <vector>
+#include "Eeprom24.h"
+#include "EepromSimulator.h"
+#include "FtdiException.h"
+#include "gtest/gtest.h"
+
+namespace {
+
+    std::vector<uint8_t> Pattern(size_t size, uint8_t seed = 0) {
+        std::vector<uint8_t> data(size);
+        for (size_t i = 0; i < size; i++)
+            data[i] = static_cast<uint8_t>(i * 7 + seed);
+        return data;
+    }
+
+    const EepromChip &Chip(const char *name) {
+        const EepromChip *chip = Eeprom24::FindChip(name);
+        EXPECT_NE(chip, nullptr) << name;
+        return *chip;
+    }
+
+    TEST(Eeprom24, ChipTable) {
+        const EepromChip &chip = Chip("microchip_24lc64");
+        EXPECT_EQ(chip.Size, 8192u);
+        EXPECT_EQ(chip.PageSize, 32u);
+        EXPECT_EQ(chip.AddrBytes, 2);
+        EXPECT_EQ(Eeprom24::FindChip("24lc64"), nullptr);
+        EXPECT_EQ(Eeprom24::Chips().size(), 18u);
+    }
+
+    TEST(Eeprom24, Crc32) {
+        const uint8_t text[] = {'1', '2', '3', '4', '5', '6', '7', '8', '9'};
+        EXPECT_EQ(Eeprom24::Crc32(text, sizeof(text)), 0xCBF43926u);
+        EXPECT_EQ(Eeprom24::Crc32(text + 4, 5, Eeprom24::Crc32(text, 4)), 0xCBF43926u);
+    }
+
+    // Запись с середины страницы: без разбиения по страницам модель завернула бы данные на начало страницы
+    TEST(Eeprom24, WriteSplitsOnPageBoundaries) {
+        EepromSimulator sim(Chip("microchip_24lc64"));
+        Eeprom24 eeprom(sim, Chip("microchip_24lc64"));
+
+        auto data = Pattern(100);
+        eeprom.Write(5, data.data(), data.size());
+
+        EXPECT_EQ(sim.WriteCycles(), 4);                // 5..31, 32..63, 64..95, 96..104
+        EXPECT_EQ(eeprom.GetStats().Pages, 4u);
+        EXPECT_EQ(eeprom.GetStats().Bytes, 100u);
+        EXPECT_TRUE(std::equal(data.begin(), data.end(), sim.Memory().begin() + 5));
+        EXPECT_EQ(sim.Memory()[4], 0xFF);
+        EXPECT_EQ(sim.Memory()[105], 0xFF);
+    }
+
+    TEST(Eeprom24, AckPollingWaitsForWriteCycle) {
+        EepromSimulator sim(Chip("st_m24c02"), Eeprom24::DefaultAddress, 3);
+        Eeprom24 eeprom(sim, Chip("st_m24c02"));
+
+        auto data = Pattern(256);
+        eeprom.Write(0, data.data(), data.size());
+        EXPECT_EQ(eeprom.GetStats().Pages, 16u);
+        EXPECT_EQ(eeprom.GetStats().Polls, 48u);
+        EXPECT_EQ(sim.Memory(), data);
+    }
+
+    TEST(Eeprom24, PollTimeout) {
+        EepromSimulator sim(Chip("st_m24c02"), Eeprom24::DefaultAddress, 1000000000);
+        Eeprom24 eeprom(sim, Chip("st_m24c02"));
+        eeprom.SetPollTimeout(std::chrono::milliseconds(5));
+
+        uint8_t byte = 0x55;
+        EXPECT_THROW(eeprom.Write(0, &byte, 1), FtdiException);
+    }
+
+    // Чтение через границу 64 КБ идёт двумя посылками с разными адресами I2C
+    TEST(Eeprom24, ReadAcrossAddressSegment) {
+        const EepromChip &chip = Chip("onsemi_cat24m01");
+        EepromSimulator sim(chip, 0x54);
+        sim.Memory() = Pattern(chip.Size, 3);
+        Eeprom24 eeprom(sim, chip, 0x54);
+
+        std::vector<uint8_t> buffer(64);
+        eeprom.Read(0xFFE0, buffer.data(), buffer.size());
+        EXPECT_TRUE(std::equal(buffer.begin(), buffer.end(), sim.Memory().begin() + 0xFFE0));
+        EXPECT_EQ(eeprom.GetStats().Transactions, 2u);
+    }
+
+    TEST(Eeprom24, WholeImageRoundTrip) {
+        const EepromChip &chip = Chip("onsemi_cat24c256");
+        EepromSimulator sim(chip, Eeprom24::DefaultAddress, 2);
+        Eeprom24 eeprom(sim, chip);
+
+        auto image = Pattern(chip.Size, 11);
+        eeprom.Write(0, image.data(), image.size());
+        EXPECT_EQ(eeprom.GetStats().Pages, chip.Size / chip.PageSize);
+
+        uint32_t crc = 0;
+        EXPECT_TRUE(eeprom.Verify(0, image.data(), image.size(), crc));
+        EXPECT_EQ(crc, Eeprom24::Crc32(image.data(), image.size()));
+
+        sim.Memory()[12345] ^= 0x01;
+        EXPECT_FALSE(eeprom.Verify(0, image.data(), image.size(), crc));
+    }
+
+    TEST(Eeprom24, Errors) {
+        const EepromChip &chip = Chip("st_m24c02");
+        EepromSimulator sim(chip, 0x51);
+        Eeprom24 absent(sim, chip);
+        Eeprom24 eeprom(sim, chip, 0x51);
+
+        uint8_t buffer[16] = {};
+        EXPECT_THROW(absent.Read(0, buffer, sizeof(buffer)), FtdiException);
+        EXPECT_THROW(eeprom.Read(250, buffer, sizeof(buffer)), std::out_of_range);
+        EXPECT_THROW(eeprom.Write(257, buffer, 0), std::out_of_range);
+        EXPECT_NO_THROW(eeprom.Write(240, buffer, sizeof(buffer)));
+    }
+}
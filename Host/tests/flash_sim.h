@@ -0,0 +1,83 @@
+#pragma once
+#include <cstdint>
+#include <stdexcept>
+#include <vector>
+#include "param_log.h"
+
+
+/**
+ * Модель двух страниц основной flash 1986ВЕ92 для param_log: запись только сбрасывает биты, стирание - страница
+ * целиком. Время операций - по задержкам EEPROM_ProgramWord и EEPROM_ErasePage из SPL. FailAfter() моделирует
+ * сброс питания: запись с заданным номером оставляет слово записанным наполовину и бросает PowerLoss.
+ */
+class FlashSim {
+public:
+    struct PowerLoss : std::runtime_error {
+        PowerLoss() : std::runtime_error("power loss") {}
+    };
+
+    static const uint32_t Base = 0x0801E000;
+    static constexpr double ProgramUs = 61;             ///< 5 + 10 + 40 + 5 + 1 мкс
+    static constexpr double EraseUs = 4 * 40010 + 4000; ///< 4 сектора по 40 мс и 4 мс после
+
+    explicit FlashSim(uint32_t pageSize = 4096) : m_uPageSize(pageSize), m_vMemory(2 * pageSize / 4, 0xFFFFFFFF),
+                                                  m_vErases(2, 0) {
+        s_pCurrent = this;
+    }
+    ~FlashSim() { s_pCurrent = nullptr; }
+
+    ParamFlash Flash() const {
+        return {{Base, Base + m_uPageSize}, m_uPageSize, Read, Program, Erase};
+    }
+
+    void FailAfter(int64_t programs) { m_iFailAfter = programs; }
+    void WriteProtect(bool protect) { m_bProtect = protect; }
+
+    const std::vector<uint32_t> &Erases() const { return m_vErases; }
+    uint64_t Programs() const { return m_uPrograms; }
+    double BusyUs() const { return m_uPrograms * ProgramUs + (m_vErases[0] + m_vErases[1]) * EraseUs; }
+
+private:
+    uint32_t &Word(uint32_t address) {
+        if (address < Base || address >= Base + 2 * m_uPageSize || address % 4)
+            throw std::out_of_range("flash address");
+        return m_vMemory[(address - Base) / 4];
+    }
+
+    static uint32_t Read(uint32_t address) {
+        return s_pCurrent->Word(address);
+    }
+
+    static void Program(uint32_t address, uint32_t data) {
+        FlashSim &flash = *s_pCurrent;
+        if (flash.m_iFailAfter == 0) {
+            flash.m_iFailAfter = -1;
+            flash.Word(address) &= data | 0xFFFF0000;       // Записана только младшая половина
+            throw PowerLoss();
+        }
+        if (flash.m_iFailAfter > 0)
+            flash.m_iFailAfter--;
+        flash.m_uPrograms++;
+        if (!flash.m_bProtect)
+            flash.Word(address) &= data;
+    }
+
+    static void Erase(uint32_t address) {
+        FlashSim &flash = *s_pCurrent;
+        uint32_t page = (address - Base) / flash.m_uPageSize;
+        flash.m_vErases.at(page)++;
+        for (uint32_t offset = 0; offset < flash.m_uPageSize; offset += 4)
+            flash.Word(Base + page * flash.m_uPageSize + offset) = 0xFFFFFFFF;
+    }
+
+    static FlashSim *s_pCurrent;
+
+    uint32_t m_uPageSize;
+    std::vector<uint32_t> m_vMemory;
+    std::vector<uint32_t> m_vErases;
+    uint64_t m_uPrograms = 0;
+    int64_t m_iFailAfter = -1;
+    bool m_bProtect = false;
+};
+
+FlashSim *FlashSim::s_pCurrent = nullptr;
@@ -0,0 +1,157 @@
+#pragma once
+#include <algorithm>
+#include <cstdint>
+#include <set>
+#include <stdexcept>
+#include <vector>
+#include "SpiTransport.h"
+#include "iap_engine.h"
+
+
+/**
+ * НЧ драйвер в режиме обновления: iap_engine на модели основной flash 1986ВЕ92 и SPI-ведомый с ответом в FIFO.
+ *
+ * Время модельное, мкс. Транзакция занимает UsbUs на обмен по USB и 8 / SpiMHz на байт, устройство в это время
+ * крутит IapPoll(), данные приходят кадрами по ходу транзакции. Запись слова - 61 мкс, стирание страницы -
+ * 164 мс, оба через один контроллер: запись, чтение или второе стирание во время стирания - ошибка модели.
+ */
+class IapDeviceSim : public SpiTransport {
+public:
+    static const uint32_t Base = 0x08000000;
+    static constexpr double ProgramUs = 61;             ///< 5 + 10 + 40 + 5 + 1 мкс, EEPROM_ProgramWord
+    static constexpr double EraseUs = 4 * 40010 + 4000; ///< 4 сектора по 40 мс и 4 мс после
+    static constexpr double ReadUs = 0.2;
+    static constexpr double StepUs = 1;                 ///< Проход цикла обработчика
+    static constexpr double UsbUs = 150;                ///< Обмен по USB одной транзакции FT4222
+    static constexpr double SpiMHz = 3;                 ///< SYS_CLK_24 / CLK_DIV_8 в FtdiSpi
+
+    explicit IapDeviceSim(uint32_t size = 120 * 1024, uint32_t pageSize = 4096, uint32_t ringSize = 2048) :
+            m_vMemory(size / 4), m_vRing(ringSize) {
+        // Старая прошивка: без стирания новый образ не запишется
+        for (uint32_t i = 0; i < m_vMemory.size(); i++)
+            m_vMemory[i] = 0x12345678 ^ (i * 2654435761u);
+        m_xFlash = {Base, size, pageSize, Read, Program, EraseStart, EraseBusy};
+        s_pCurrent = this;
+        IapInit(m_xEngine, m_xFlash, m_vRing.data(), ringSize);
+    }
+    ~IapDeviceSim() override { s_pCurrent = nullptr; }
+
+    bool Write(uint8_t *buffer, uint16_t bufferSize, bool) override {
+        Run(UsbUs);
+        for (uint16_t offset = 0; offset < bufferSize; offset += IAP_FRAME_SIZE) {
+            uint16_t chunk = std::min<uint16_t>(IAP_FRAME_SIZE, bufferSize - offset);
+            Run(chunk * 8 / SpiMHz);
+            std::vector<uint8_t> line(buffer + offset, buffer + offset + chunk);
+            for (auto &byte : line) {
+                if (m_xCorrupt.count(m_uLineBytes++))
+                    byte ^= 0xFF;
+            }
+            IapFeed(m_xEngine, line.data(), line.size());
+        }
+        return true;
+    }
+
+    bool Read(uint8_t *buffer, uint16_t bufferSize, bool) override {
+        Run(UsbUs + bufferSize * 8 / SpiMHz);
+        uint8_t reply[IAP_REPLY_SIZE];
+        IapReply(m_xEngine, reply);
+        if (m_uGarbledReplies > 0) {
+            m_uGarbledReplies--;
+            reply[3] ^= 0x01;
+        }
+        std::fill(buffer, buffer + bufferSize, 0);
+        std::copy(reply, reply + std::min<uint16_t>(bufferSize, IAP_REPLY_SIZE), buffer);
+        return true;
+    }
+
+    bool WriteRead(const uint8_t *command, uint16_t commandSize, uint8_t *response, uint16_t responseSize) override {
+        std::vector<uint8_t> tx(command, command + commandSize);
+        Write(tx.data(), tx.size(), false);
+        return Read(response, responseSize, true);
+    }
+
+    /// Байт линии с номером index от создания модели передаётся инвертированным
+    void CorruptByte(uint64_t index) { m_xCorrupt.insert(index); }
+    /// Следующие count ответов с неверной CRC
+    void GarbleReplies(uint32_t count) { m_uGarbledReplies = count; }
+    /// Запись не меняет flash, проверка чтением не проходит
+    void WriteProtect(bool protect) { m_bProtect = protect; }
+
+    /// Устройство без обмена: например, ждёт конца стирания
+    void Run(double us) {
+        double end = m_dNow + us;
+        while (m_dNow < end) {
+            if (m_xEngine.Erasing && m_dNow < m_dEraseEnd) {
+                m_dNow = std::min(end, m_dEraseEnd);
+                continue;
+            }
+            if (!IapPoll(m_xEngine)) {
+                m_dNow = end;
+                break;
+            }
+            m_dNow += StepUs;
+        }
+    }
+
+    IapEngine &Engine() { return m_xEngine; }
+    const std::vector<uint32_t> &Memory() const { return m_vMemory; }
+    double Now() const { return m_dNow; }
+    uint32_t Erases() const { return m_uErases; }
+    uint64_t Programs() const { return m_uPrograms; }
+    double BusyUs() const { return m_uPrograms * ProgramUs + m_uErases * EraseUs; }
+
+private:
+    uint32_t &Word(uint32_t address) {
+        if (address < Base || address >= Base + m_vMemory.size() * 4 || address % 4)
+            throw std::out_of_range("flash address");
+        if (m_dNow < m_dEraseEnd)
+            throw std::logic_error("flash access during erase");
+        return m_vMemory[(address - Base) / 4];
+    }
+
+    static uint32_t Read(uint32_t address) {
+        s_pCurrent->m_dNow += ReadUs;
+        return s_pCurrent->Word(address);
+    }
+
+    static void Program(uint32_t address, uint32_t data) {
+        IapDeviceSim &sim = *s_pCurrent;
+        uint32_t &word = sim.Word(address);
+        sim.m_dNow += ProgramUs;
+        sim.m_uPrograms++;
+        if (!sim.m_bProtect)
+            word &= data;
+    }
+
+    static void EraseStart(uint32_t address) {
+        IapDeviceSim &sim = *s_pCurrent;
+        uint32_t page = sim.m_xFlash.PageSize;
+        if ((address - Base) % page)
+            throw std::logic_error("erase address not page aligned");
+        sim.Word(address);
+        std::fill_n(sim.m_vMemory.begin() + (address - Base) / 4, page / 4, 0xFFFFFFFF);
+        sim.m_dEraseEnd = sim.m_dNow + EraseUs;
+        sim.m_uErases++;
+    }
+
+    static bool EraseBusy() {
+        return s_pCurrent->m_dNow < s_pCurrent->m_dEraseEnd;
+    }
+
+    static IapDeviceSim *s_pCurrent;
+
+    IapFlash m_xFlash {};
+    IapEngine m_xEngine {};
+    std::vector<uint32_t> m_vMemory;
+    std::vector<uint8_t> m_vRing;
+    double m_dNow = 0;
+    double m_dEraseEnd = 0;
+    uint32_t m_uErases = 0;
+    uint64_t m_uPrograms = 0;
+    uint64_t m_uLineBytes = 0;
+    std::set<uint64_t> m_xCorrupt;
+    uint32_t m_uGarbledReplies = 0;
+    bool m_bProtect = false;
+};
+
+IapDeviceSim *IapDeviceSim::s_pCurrent = nullptr;
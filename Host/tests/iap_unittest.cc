@@ -0,0 +1,230 @@
+#include <cstring>
+#include <iostream>
+#include <random>
+#include "LfUpdater.h"
+#include "iap_device_sim.h"
+#include "iap_engine.h"
+#include "gtest/gtest.h"
+
+namespace {
+
+    // Образ как после Tools/append_crc.py: code байт кода, 0xFF до size, CRC-32/MPEG-2 в последнем слове
+    std::vector<uint8_t> MakeImage(uint32_t code, uint32_t size, uint32_t seed = 1) {
+        std::vector<uint8_t> image(size, 0xFF);
+        std::mt19937 random(seed);
+        for (uint32_t i = 0; i < code; i++)
+            image[i] = random();
+        uint32_t crc = LfUpdater::Crc32(image.data(), size - 4);
+        for (int i = 0; i < 4; i++)
+            image[size - 4 + i] = crc >> (8 * i);
+        return image;
+    }
+
+    std::vector<uint8_t> Flash(const IapDeviceSim &sim, uint32_t size) {
+        std::vector<uint8_t> bytes(size);
+        std::memcpy(bytes.data(), sim.Memory().data(), size);
+        return bytes;
+    }
+
+    std::vector<uint8_t> Frame(LfUpdater::Command command, uint8_t sequence, uint32_t argument,
+                               const uint8_t *data = nullptr, uint8_t length = 0) {
+        std::vector<uint8_t> frame(IAP_FRAME_SIZE);
+        LfUpdater::MakeFrame(frame.data(), command, sequence, argument, data, length);
+        return frame;
+    }
+
+    IapStatus Send(IapDeviceSim &sim, const std::vector<uint8_t> &frame) {
+        return IapHandleFrame(sim.Engine(), frame.data());
+    }
+
+    TEST(Iap, Crc32MatchesAppendCrc) {
+        const char *check = "123456789";
+        auto data = reinterpret_cast<const uint8_t *>(check);
+        EXPECT_EQ(IapCrc32(0xFFFFFFFF, data, 9), 0x0376E6E7u);     // crc-32-mpeg, check из crcmod
+        EXPECT_EQ(LfUpdater::Crc32(data, 9), 0x0376E6E7u);
+        EXPECT_EQ(IapCrc32(IapCrc32(0xFFFFFFFF, data, 4), data + 4, 5), 0x0376E6E7u);
+
+        auto image = MakeImage(1000, 4096);
+        uint32_t crc = 0;
+        EXPECT_TRUE(LfUpdater::CheckImage(image, crc));
+        image[10] ^= 1;
+        EXPECT_FALSE(LfUpdater::CheckImage(image, crc));
+    }
+
+    TEST(Iap, RejectsBadCommands) {
+        IapDeviceSim sim(4096, 1024, 256);
+        uint8_t data[8] = {};
+        EXPECT_EQ(Send(sim, Frame(LfUpdater::CMD_DATA, 1, 0, data, 8)), IAP_BAD_STATE);
+        EXPECT_EQ(Send(sim, Frame(LfUpdater::CMD_BEGIN, 2, 4097)), IAP_BAD_SIZE);
+        EXPECT_EQ(Send(sim, Frame(LfUpdater::CMD_BEGIN, 3, 8192)), IAP_BAD_SIZE);
+        EXPECT_EQ(sim.Engine().State, IAP_IDLE);
+
+        auto frame = Frame(LfUpdater::CMD_BEGIN, 4, 4096);
+        frame[5] ^= 1;
+        EXPECT_EQ(Send(sim, frame), IAP_BAD_FRAME);
+        EXPECT_EQ(sim.Engine().Sequence, 3);                        // номер только у кадров с верной CRC
+        EXPECT_EQ(sim.Engine().Stats.BadFrames, 1u);
+        EXPECT_EQ(sim.Erases(), 0u);
+    }
+
+    TEST(Iap, DataInOrderWithRepeats) {
+        IapDeviceSim sim(4096, 1024, 256);
+        ASSERT_EQ(Send(sim, Frame(LfUpdater::CMD_BEGIN, 1, 4096)), IAP_OK);
+        uint8_t data[IAP_FRAME_DATA];
+        for (uint32_t i = 0; i < sizeof(data); i++)
+            data[i] = i;
+
+        EXPECT_EQ(Send(sim, Frame(LfUpdater::CMD_DATA, 2, 52, data, 52)), IAP_BAD_OFFSET);
+        EXPECT_EQ(Send(sim, Frame(LfUpdater::CMD_DATA, 3, 0, data, 52)), IAP_OK);
+        EXPECT_EQ(Send(sim, Frame(LfUpdater::CMD_DATA, 4, 0, data, 52)), IAP_OK);   // повтор после потерянного ответа
+        EXPECT_EQ(sim.Engine().Received, 52u);
+        EXPECT_EQ(Send(sim, Frame(LfUpdater::CMD_DATA, 5, 48, data, 8)), IAP_OK);   // перекрытие дописывает хвост
+        EXPECT_EQ(sim.Engine().Received, 56u);
+        EXPECT_EQ(Send(sim, Frame(LfUpdater::CMD_DATA, 6, 56, data, 6)), IAP_BAD_FRAME);
+        EXPECT_EQ(Send(sim, Frame(LfUpdater::CMD_DATA, 7, 4092, data, 8)), IAP_BAD_FRAME);
+
+        // Кольцо 256 байт: пока flash не стёрта, принимается только то, что в него помещается
+        uint32_t offset = 56;
+        IapStatus status = IAP_OK;
+        for (uint8_t sequence = 8; status == IAP_OK; sequence++) {
+            status = Send(sim, Frame(LfUpdater::CMD_DATA, sequence, offset, data, 52));
+            if (status == IAP_OK)
+                offset += 52;
+        }
+        EXPECT_EQ(status, IAP_BUSY);
+        EXPECT_EQ(sim.Engine().Received, offset);
+        EXPECT_LT(IapFree(sim.Engine()), 52u);
+        EXPECT_EQ(sim.Engine().Stats.Busy, 1u);
+    }
+
+    TEST(Iap, StreamResynchronizes) {
+        IapDeviceSim sim(4096, 1024, 256);
+        std::vector<uint8_t> line = {0x00, 0x5A, 0x13, 0x00};                 // нули опроса и ложный синхробайт
+        auto begin = Frame(LfUpdater::CMD_BEGIN, 1, 4096);
+        line.insert(line.end(), begin.begin(), begin.end());
+        uint8_t data[8] = {1, 2, 3, 4, 5, 6, 7, 8};
+        auto broken = Frame(LfUpdater::CMD_DATA, 2, 0, data, 8);
+        broken[20] ^= 0x40;
+        line.insert(line.end(), broken.begin(), broken.begin() + 40);          // оборванный кадр
+        auto good = Frame(LfUpdater::CMD_DATA, 3, 0, data, 8);
+        line.insert(line.end(), good.begin(), good.end());
+
+        // По байту: граница транзакций не важна
+        for (uint8_t byte : line)
+            IapFeed(sim.Engine(), &byte, 1);
+        EXPECT_EQ(sim.Engine().State, IAP_RECEIVING);
+        EXPECT_EQ(sim.Engine().Received, 8u);
+        EXPECT_EQ(sim.Engine().Sequence, 3);
+        EXPECT_EQ(sim.Engine().Stats.Frames, 2u);
+        EXPECT_GE(sim.Engine().Stats.BadFrames, 1u);
+    }
+
+    TEST(Iap, ReplyRoundTrip) {
+        IapDeviceSim sim(4096, 1024, 256);
+        Send(sim, Frame(LfUpdater::CMD_BEGIN, 7, 4096));
+        uint8_t raw[IAP_REPLY_SIZE];
+        IapReply(sim.Engine(), raw);
+
+        LfUpdater::Reply reply {};
+        ASSERT_TRUE(LfUpdater::ParseReply(raw, reply));
+        EXPECT_EQ(reply.Sequence, 7);
+        EXPECT_EQ(reply.Result, LfUpdater::OK);
+        EXPECT_EQ(reply.Progress, LfUpdater::RECEIVING);
+        EXPECT_EQ(reply.Received, 0u);
+        EXPECT_EQ(reply.Free, 256u);
+        raw[4] ^= 1;
+        EXPECT_FALSE(LfUpdater::ParseReply(raw, reply));
+    }
+
+    TEST(Iap, UpdateWritesAndVerifiesImage) {
+        IapDeviceSim sim;
+        auto image = MakeImage(70 * 1024, 120 * 1024);
+        LfUpdater updater(sim);
+        auto stats = updater.Update(image);
+
+        EXPECT_EQ(sim.Engine().State, IAP_DONE);
+        EXPECT_EQ(Flash(sim, image.size()), image);
+        EXPECT_EQ(sim.Erases(), 30u);
+        EXPECT_EQ(stats.Retransmits, 0u);
+        // Заполнение 0xFF не пишется
+        EXPECT_EQ(sim.Engine().Stats.Skipped + sim.Programs(), image.size() / 4);
+        EXPECT_LT(sim.Programs(), 70 * 1024 / 4 + 2);
+
+        EXPECT_FALSE(sim.Engine().ResetRequested);
+        updater.Reset();
+        EXPECT_TRUE(sim.Engine().ResetRequested);
+    }
+
+    TEST(Iap, UpdateTimeApproachesFlashLimit) {
+        IapDeviceSim sim;
+        auto image = MakeImage(100 * 1024, 120 * 1024);
+        LfUpdater updater(sim);
+        auto stats = updater.Update(image);
+
+        // Нижняя граница - контроллер flash без простоя: стирание всех страниц и запись всех слов кода
+        double limit = sim.BusyUs();
+        double serial = limit + (double)image.size() / LfUpdater::FrameData *
+                                (IapDeviceSim::UsbUs * 2 + (LfUpdater::FrameSize + LfUpdater::ReplySize) * 8 / IapDeviceSim::SpiMHz);
+        std::cout << "Update " << image.size() << " bytes: " << sim.Now() / 1000 << " ms, flash limit "
+                  << limit / 1000 << " ms, frame-by-frame without overlap " << serial / 1000 << " ms, polls "
+                  << stats.Polls << std::endl;
+        EXPECT_EQ(Flash(sim, image.size()), image);
+        EXPECT_LT(sim.Now(), limit * 1.03 + 20000);
+    }
+
+    TEST(Iap, LostBytesAreRetransmitted) {
+        IapDeviceSim sim;
+        auto image = MakeImage(20 * 1024, 120 * 1024, 2);
+        for (uint64_t index : {100u, 5000u, 5001u, 40001u, 90000u})
+            sim.CorruptByte(index);
+        sim.GarbleReplies(3);
+
+        LfUpdater updater(sim);
+        auto stats = updater.Update(image);
+        EXPECT_EQ(sim.Engine().State, IAP_DONE);
+        EXPECT_EQ(Flash(sim, image.size()), image);
+        EXPECT_GT(stats.Retransmits, 0u);
+        EXPECT_GE(stats.BadReplies, 3u);
+        EXPECT_GE(sim.Engine().Stats.BadFrames, 4u);
+    }
+
+    TEST(Iap, VerifyFailsOnWrongCrc) {
+        IapDeviceSim sim(4096, 1024, 256);
+        auto image = MakeImage(2000, 4096);
+        image[100] ^= 0x10;                                          // образ испорчен после append_crc
+
+        uint8_t sequence = 0;
+        ASSERT_EQ(Send(sim, Frame(LfUpdater::CMD_BEGIN, ++sequence, image.size())), IAP_OK);
+        for (uint32_t offset = 0; offset < image.size();) {
+            uint32_t length = std::min<uint32_t>(IAP_FRAME_DATA, image.size() - offset);
+            if (Send(sim, Frame(LfUpdater::CMD_DATA, ++sequence, offset, &image[offset], length)) == IAP_OK)
+                offset += length;
+            sim.Run(100000);
+        }
+        sim.Run(1000000);
+        EXPECT_EQ(sim.Engine().State, IAP_FAILED);
+        EXPECT_EQ(sim.Engine().Status, IAP_VERIFY_ERROR);
+
+        // Новая попытка с верным образом
+        LfUpdater updater(sim);
+        EXPECT_THROW(updater.Update(image), std::invalid_argument);
+        image[100] ^= 0x10;
+        updater.Update(image);
+        EXPECT_EQ(sim.Engine().State, IAP_DONE);
+        EXPECT_EQ(Flash(sim, image.size()), image);
+    }
+
+    TEST(Iap, ProgramErrorStopsUpdate) {
+        IapDeviceSim sim(4096, 1024, 256);
+        sim.WriteProtect(true);
+        LfUpdater updater(sim);
+        try {
+            updater.Update(MakeImage(2000, 4096));
+            FAIL() << "Update must fail";
+        } catch (const std::runtime_error &e) {
+            EXPECT_NE(std::string(e.what()).find("program error"), std::string::npos);
+        }
+        EXPECT_EQ(sim.Engine().State, IAP_FAILED);
+        EXPECT_EQ(sim.Programs(), 1u);
+    }
+}
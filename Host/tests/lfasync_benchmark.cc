@@ -0,0 +1,86 @@
+/**
+ * Скорость доступа к регистрам НЧ драйвера: LFSmart и LFSmartAsync без пакетов и с пакетами.
+ *
+ * Транспорт - LfSimulator с реальной задержкой обмена по USB: адаптер с пакетами Transfer и FtdiSpi, где пакет
+ * передаётся по одной транзакции, а чтение занимает два обмена. Нагрузка - цикл управления: запись четырёх
+ * каналов ЦАП, чтение четырёх каналов АЦП и регистра STATUS.
+ *
+ * Использование: lfasync_benchmark [задержка, мкс] [циклов]
+ */
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <vector>
+#include "LFSmart.h"
+#include "LFSmartAsync.h"
+#include "LfSimulator.h"
+
+
+static const int OpsPerCycle = 9;
+
+static LfSimulator::Options MakeOptions(long latency, bool ftdi) {
+    LfSimulator::Options options;
+    options.Latency = std::chrono::microseconds(latency);
+    options.RealTime = true;
+    options.FtdiExchanges = ftdi;
+    return options;
+}
+
+static void Print(const char *name, int ops, double seconds, uint64_t transfers) {
+    printf("%-16s %10.0f ops/s  %8.1f us/op  USB transfers %6llu\n", name, ops / seconds, 1e6 * seconds / ops,
+           (unsigned long long)transfers);
+}
+
+static void RunSync(long latency, bool ftdi, int cycles) {
+    LfSimulator sim(MakeOptions(latency, ftdi));
+    LFSmart lf(sim, true, 3);
+
+    auto start = std::chrono::steady_clock::now();
+    for (int n = 0; n < cycles; n++) {
+        for (int ch = lfc::Channel::CHANNEL_1; ch <= lfc::Channel::CHANNEL_4; ch++)
+            lf.WriteDacChannel(static_cast<lfc::Channel>(ch), static_cast<uint16_t>(n), false);
+        for (int ch = lfc::Channel::CHANNEL_1; ch <= lfc::Channel::CHANNEL_4; ch++)
+            lf.ReadAdcChannel(static_cast<lfc::Channel>(ch));
+        lf.Status();
+    }
+    std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+    Print("LFSmart", cycles * OpsPerCycle, elapsed.count(), sim.Transfers());
+}
+
+static void RunAsync(const char *name, long latency, bool ftdi, int cycles, size_t batch) {
+    LfSimulator sim(MakeOptions(latency, ftdi));
+    std::vector<std::future<uint16_t>> reads;
+    reads.reserve(cycles * 5);
+
+    auto start = std::chrono::steady_clock::now();
+    {
+        LFSmartAsync lf(sim, true, 3, batch);
+        for (int n = 0; n < cycles; n++) {
+            for (int ch = 0; ch < 4; ch++)
+                lf.Write(static_cast<lfc::Registers>(lfc::Registers::DAC_CH1 + ch), static_cast<uint16_t>(n));
+            for (int ch = 0; ch < 4; ch++)
+                reads.push_back(lf.Read(static_cast<lfc::Registers>(lfc::Registers::ADC_CH1 + ch)));
+            reads.push_back(lf.Read(lfc::Registers::STATUS));
+        }
+        for (auto &read : reads)
+            read.get();
+    }
+    std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+    Print(name, cycles * OpsPerCycle, elapsed.count(), sim.Transfers());
+}
+
+
+int main(int argc, char *argv[]) {
+    long latency = (argc > 1) ? strtol(argv[1], nullptr, 10) : 200;
+    int cycles = (argc > 2) ? atoi(argv[2]) : 200;
+    printf("USB latency %ld us, %d cycles x %d operations\n", latency, cycles, OpsPerCycle);
+
+    for (bool ftdi : {false, true}) {
+        printf("%s\n", ftdi ? "FtdiSpi, transaction per transfer" : "Batching adapter");
+        RunSync(latency, ftdi, cycles);
+        RunAsync("async batch 1", latency, ftdi, cycles, 1);
+        RunAsync("async batch 32", latency, ftdi, cycles, 32);
+    }
+    return 0;
+}
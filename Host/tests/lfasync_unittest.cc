@@ -0,0 +1,98 @@
+#include <stdexcept>
+#include <vector>
+#include "LFSmart.h"
+#include "LFSmartAsync.h"
+#include "LfSimulator.h"
+#include "gtest/gtest.h"
+
+namespace {
+
+    TEST(LFSmartAsync, ReadAfterWriteKeepsOrder) {
+        LfSimulator sim;
+        LFSmartAsync lf(sim, true);
+
+        std::vector<std::future<uint16_t>> reads;
+        for (uint16_t value = 1; value <= 50; value++) {
+            lf.Write(lfc::Registers::DAC_CH1, value);
+            reads.push_back(lf.Read(lfc::Registers::DAC_CH1));
+        }
+        for (uint16_t value = 1; value <= 50; value++)
+            EXPECT_EQ(reads[value - 1].get(), value);
+    }
+
+    TEST(LFSmartAsync, BatchesCoalesceTransfers) {
+        LfSimulator sim;
+        LFSmartAsync lf(sim, true, 1, 16);
+
+        for (int i = 0; i < 4; i++)
+            lf.Write(static_cast<lfc::Registers>(lfc::Registers::DAC_CH1 + i), 100 * (i + 1));
+        std::vector<std::future<uint16_t>> reads;
+        for (int i = 0; i < 4; i++)
+            reads.push_back(lf.Read(static_cast<lfc::Registers>(lfc::Registers::DAC_CH1 + i)));
+        for (int i = 0; i < 4; i++)
+            EXPECT_EQ(reads[i].get(), 100 * (i + 1));
+
+        lf.Flush();
+        auto stats = lf.GetStats();
+        EXPECT_EQ(stats.Operations, 8u);
+        EXPECT_LT(stats.Batches, 8u);
+        EXPECT_EQ(sim.Transactions(), 8u);
+    }
+
+    TEST(LFSmartAsync, CallbacksAndErrors) {
+        LfSimulator sim;
+        LFSmartAsync lf(sim, true);
+
+        uint16_t whoiam = 0;
+        lf.Read(lfc::Registers::WHOIAM, [&whoiam](uint16_t value, std::exception_ptr error) {
+            if (!error)
+                whoiam = value;
+        });
+        lf.Flush();
+        EXPECT_EQ(whoiam, LFSmart::WhoiamExpected());
+
+        EXPECT_THROW(lf.Read(lfc::Registers::ADC_ALL), LFSmartException);
+        EXPECT_THROW(lf.Write(lfc::Registers::DAC_ALL, 0), LFSmartException);
+    }
+
+    TEST(LFSmartAsync, CallbackExceptionReachesFlush) {
+        LfSimulator sim;
+        LFSmartAsync lf(sim, true);
+
+        lf.Write(lfc::Registers::DAC_CH1, 10, [](std::exception_ptr) { throw std::runtime_error("callback"); });
+        auto read = lf.Read(lfc::Registers::DAC_CH1);
+        EXPECT_EQ(read.get(), 10);
+        EXPECT_THROW(lf.Flush(), std::runtime_error);
+        EXPECT_NO_THROW(lf.Flush());
+    }
+
+    TEST(LFSmartAsync, CrcRetry) {
+        LfSimulator::Options options;
+        options.MisoBitErrorRate = 0.01;
+        options.Seed = 7;
+        LfSimulator sim(options);
+        LFSmartAsync lf(sim, true, 20);
+
+        std::vector<std::future<uint16_t>> reads;
+        for (int i = 0; i < 100; i++)
+            reads.push_back(lf.Read(lfc::Registers::WHOIAM));
+        for (auto &read : reads)
+            EXPECT_EQ(read.get(), LFSmart::WhoiamExpected());
+        EXPECT_GT(lf.GetStats().Retries, 0u);
+    }
+
+    TEST(LFSmartAsync, CrcRetriesExhausted) {
+        LfSimulator::Options options;
+        options.MisoBitErrorRate = 0.5;
+        LfSimulator sim(options);
+        LFSmartAsync lf(sim, true, 2);
+
+        auto read = lf.Read(lfc::Registers::WHOIAM);
+        try {
+            read.get();
+            FAIL();
+        } catch (const LFSmartException &e) {
+            EXPECT_TRUE(e.CrcError());
+        }
+    }
+}
@@ -0,0 +1,152 @@
+#include "LFSmart.h"
+#include "LfSimulator.h"
+#include "gtest/gtest.h"
+
+namespace {
+
+    // Подмена устройства на шине без ведома LFSmart
+    class SwitchTransport : public SpiTransport {
+    public:
+        explicit SwitchTransport(SpiTransport *spi) : device(spi) {}
+        bool Write(uint8_t *buffer, uint16_t size, bool end) override { return device->Write(buffer, size, end); }
+        bool Read(uint8_t *buffer, uint16_t size, bool end) override { return device->Read(buffer, size, end); }
+        bool WriteRead(const uint8_t *tx, uint16_t txSize, uint8_t *rx, uint16_t rxSize) override {
+            return device->WriteRead(tx, txSize, rx, rxSize);
+        }
+
+        SpiTransport *device;
+    };
+
+    TEST(LfShadowCache, ConstantsReadOnce) {
+        LfSimulator sim;
+        LFSmart lfSmart(sim, true);
+        lfSmart.EnableCache(true);
+
+        for (int i = 0; i < 10; i++) {
+            EXPECT_EQ(lfSmart.Whoiam(), LFSmart::WhoiamExpected());
+            EXPECT_EQ(lfSmart.Version(), 200);
+            EXPECT_EQ(lfSmart.ReadCRC().first, 0x5A3C96E1u);
+        }
+        EXPECT_EQ(sim.Transfers(), 4u);
+        EXPECT_EQ(lfSmart.Cache().GetStats().Hits, 36u);
+        EXPECT_EQ(lfSmart.Cache().GetStats().Misses, 4u);
+    }
+
+    TEST(LfShadowCache, VolatileAlwaysRead) {
+        LfSimulator sim;
+        LFSmart lfSmart(sim, true);
+        lfSmart.EnableCache(true);
+
+        sim.SetAdc(lfc::Channel::CHANNEL_2, 100);
+        EXPECT_EQ(lfSmart.ReadAdcChannel(lfc::Channel::CHANNEL_2), 100);
+        sim.SetAdc(lfc::Channel::CHANNEL_2, 200);
+        EXPECT_EQ(lfSmart.ReadAdcChannel(lfc::Channel::CHANNEL_2), 200);
+        lfSmart.Status();
+        lfSmart.TemperatureMcu();
+        EXPECT_EQ(sim.Transfers(), 4u);
+        EXPECT_EQ(lfSmart.Cache().GetStats().Hits, 0u);
+    }
+
+    TEST(LfShadowCache, ReadbackFromShadow) {
+        LfSimulator sim;
+        LFSmart lfSmart(sim, true);
+        lfSmart.EnableCache(true);
+
+        lfSmart.Status();
+        lfSmart.ReadDacChannelMaximum(lfc::Channel::CHANNEL_1);
+        size_t transfers = sim.Transfers();
+        for (uint16_t value = 0; value < 100; value++)
+            EXPECT_EQ(lfSmart.WriteDacChannel(lfc::Channel::CHANNEL_1, value, true), value);
+        EXPECT_EQ(sim.Transfers() - transfers, 100u);
+        EXPECT_EQ(sim.Dac(lfc::Channel::CHANNEL_1), 99);
+
+        EXPECT_EQ(lfSmart.WriteDacDefault(lfc::Channel::CHANNEL_4, (uint16_t)777, true), 777);
+        EXPECT_EQ(lfSmart.ReadDacDefault(lfc::Channel::CHANNEL_4), 777);
+        EXPECT_EQ(sim.Transfers() - transfers, 101u);
+    }
+
+    TEST(LfShadowCache, DacFollowsMaximum) {
+        LfSimulator sim;
+        LFSmart lfSmart(sim, true);
+        lfSmart.EnableCache(true);
+
+        // Максимум и состояние неизвестны - значение ЦАП читается из устройства
+        lfSmart.WriteDacChannel(lfc::Channel::CHANNEL_3, (uint16_t)5000, false);
+        size_t transfers = sim.Transfers();
+        EXPECT_EQ(lfSmart.ReadDacChannel(lfc::Channel::CHANNEL_3), 5000);
+        EXPECT_EQ(sim.Transfers() - transfers, 1u);
+
+        lfSmart.Status();
+        lfSmart.WriteDacChannelMaximum(lfc::Channel::CHANNEL_3, 3000, false);
+        EXPECT_EQ(lfSmart.ReadDacChannel(lfc::Channel::CHANNEL_3), sim.Dac(lfc::Channel::CHANNEL_3));
+        EXPECT_EQ(lfSmart.WriteDacChannel(lfc::Channel::CHANNEL_3, (uint16_t)4000, true), 3000);
+        EXPECT_EQ(sim.Dac(lfc::Channel::CHANNEL_3), 3000);
+
+        // Остановленное устройство не меняет ЦАП
+        lfSmart.SVC(LF_SVC_STOP);
+        EXPECT_EQ(lfSmart.WriteDacChannel(lfc::Channel::CHANNEL_3, (uint16_t)1000, true), 3000);
+        EXPECT_EQ(sim.Dac(lfc::Channel::CHANNEL_3), 3000);
+    }
+
+    TEST(LfShadowCache, ResetInvalidates) {
+        LfSimulator sim;
+        LFSmart lfSmart(sim, true);
+        lfSmart.EnableCache(true);
+
+        lfSmart.Whoiam();
+        lfSmart.WriteDacDefault(lfc::Channel::CHANNEL_1, (uint16_t)10, false);
+        lfSmart.WriteDacChannelMaximum(lfc::Channel::CHANNEL_1, 50, false);
+        lfSmart.SVC(LF_SVC_RESET);
+        EXPECT_EQ(lfSmart.Cache().GetStats().Invalidations, 1u);
+
+        // Сброс загрузил значения из энергонезависимой памяти
+        EXPECT_EQ(lfSmart.ReadDacDefault(lfc::Channel::CHANNEL_1), 0);
+        EXPECT_EQ(lfSmart.ReadDacChannelMaximum(lfc::Channel::CHANNEL_1), 0xFFFF);
+    }
+
+    TEST(LfShadowCache, DeviceErrorInvalidates) {
+        LfSimulator sim;
+        LFSmart lfSmart(sim, true);
+        LFSmart other(sim, true);
+        lfSmart.EnableCache(true);
+
+        lfSmart.Status();
+        lfSmart.ReadDacChannelMaximum(lfc::Channel::CHANNEL_2);
+        lfSmart.WriteDacChannel(lfc::Channel::CHANNEL_2, (uint16_t)100, false);
+
+        // Второй хост остановил устройство, запись отвергнута, копия неверна до чтения LAST_ERROR
+        other.SVC(LF_SVC_STOP);
+        EXPECT_EQ(lfSmart.WriteDacChannel(lfc::Channel::CHANNEL_2, (uint16_t)500, true), 500);
+        EXPECT_EQ(lfSmart.LastError(), lfc::LastError::LE_INACTIVE);
+        EXPECT_EQ(lfSmart.ReadDacChannel(lfc::Channel::CHANNEL_2), 100);
+        EXPECT_EQ(lfSmart.Cache().GetStats().Invalidations, 1u);
+    }
+
+    TEST(LfShadowCache, ValidateDetectsNewDevice) {
+        LfSimulator first;
+        LfSimulator::Options options;
+        options.Version = 201;
+        LfSimulator second(options);
+        SwitchTransport spi(&first);
+        LFSmart lfSmart(spi, true);
+        lfSmart.EnableCache(true);
+
+        EXPECT_EQ(lfSmart.Version(), 200);
+        EXPECT_TRUE(lfSmart.ValidateCache());
+
+        spi.device = &second;
+        EXPECT_EQ(lfSmart.Version(), 200);
+        EXPECT_FALSE(lfSmart.ValidateCache());
+        EXPECT_EQ(lfSmart.Version(), 201);
+    }
+
+    TEST(LfShadowCache, DisabledByDefault) {
+        LfSimulator sim;
+        LFSmart lfSmart(sim, true);
+        lfSmart.Whoiam();
+        lfSmart.Whoiam();
+        EXPECT_EQ(sim.Transfers(), 2u);
+        EXPECT_EQ(lfSmart.Cache().GetStats().Hits, 0u);
+        EXPECT_EQ(lfSmart.Cache().GetStats().Misses, 0u);
+    }
+}
@@ -0,0 +1,54 @@
+/**
+ * Время прогона сценария на стойке плат: LfFleet с одним потоком и с потоком на плату.
+ *
+ * Платы - LfSimulator с реальной задержкой обмена по USB. Сценарий - чтение WHOIAM, VERSION и CRC, запись
+ * и чтение четырёх каналов ЦАП, чтение четырёх каналов АЦП.
+ *
+ * Использование: lffleet_benchmark [плат] [задержка, мкс]
+ */
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <memory>
+#include "LfFleet.h"
+#include "LfSimulator.h"
+
+
+static void Script(int device, LFSmart &lf) {
+    lf.Whoiam();
+    lf.Version();
+    lf.ReadCRC();
+    for (int ch = lfc::Channel::CHANNEL_1; ch <= lfc::Channel::CHANNEL_4; ch++) {
+        lf.WriteDacChannel(static_cast<lfc::Channel>(ch), static_cast<uint16_t>(device), true);
+        lf.ReadAdcChannel(static_cast<lfc::Channel>(ch));
+    }
+}
+
+static void RunFleet(int boards, long latency, size_t threads) {
+    LfSimulator::Options options;
+    options.Latency = std::chrono::microseconds(latency);
+    options.RealTime = true;
+
+    LfFleet fleet([&options](int) { return std::unique_ptr<SpiTransport>(new LfSimulator(options)); }, true, 3, threads);
+    auto open = fleet.Open(boards);
+    auto run = fleet.Run(Script);
+
+    long long slowest = 0;
+    for (const auto &board : run.Boards)
+        slowest = std::max<long long>(slowest, board.Time.count());
+    printf("%3zu threads  open %8.1f ms  run %8.1f ms  slowest board %7.1f ms  failed %zu\n", threads,
+           open.Elapsed.count() / 1000.0, run.Elapsed.count() / 1000.0, slowest / 1000.0, open.Failed + run.Failed);
+}
+
+
+int main(int argc, char *argv[]) {
+    int boards = (argc > 1) ? atoi(argv[1]) : 32;
+    long latency = (argc > 2) ? strtol(argv[2], nullptr, 10) : 200;
+    printf("%d boards, USB latency %ld us\n", boards, latency);
+
+    RunFleet(boards, latency, 1);
+    RunFleet(boards, latency, 4);
+    RunFleet(boards, latency, boards);
+    return 0;
+}
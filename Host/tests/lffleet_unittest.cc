@@ -0,0 +1,115 @@
+#include <atomic>
+#include <memory>
+#include <set>
+#include <thread>
+#include "FtdiException.h"
+#include "LfFleet.h"
+#include "LfSimulator.h"
+#include "gtest/gtest.h"
+
+namespace {
+
+    // Стойка моделей: у платы N регистр VERSION = 200 + N, адаптер 3 не отвечает
+    class SimulatedRack {
+    public:
+        explicit SimulatedRack(int count) : boards(count) {
+            for (int device = 0; device < count; device++) {
+                LfSimulator::Options options;
+                options.Version = 200 + device;
+                boards[device].reset(new LfSimulator(options));
+            }
+        }
+
+        LfFleet::Opener Opener() {
+            return [this](int device) -> std::unique_ptr<SpiTransport> {
+                if (device == 3)
+                    throw FtdiException("Cannot open device");
+                return std::unique_ptr<SpiTransport>(new Proxy(*boards.at(device)));
+            };
+        }
+
+        // Плата принадлежит стойке, fleet владеет только транспортом
+        class Proxy : public SpiTransport {
+        public:
+            explicit Proxy(SpiTransport &spi) : spi(spi) {}
+            bool Write(uint8_t *buffer, uint16_t size, bool end) override { return spi.Write(buffer, size, end); }
+            bool Read(uint8_t *buffer, uint16_t size, bool end) override { return spi.Read(buffer, size, end); }
+            bool WriteRead(const uint8_t *tx, uint16_t txSize, uint8_t *rx, uint16_t rxSize) override {
+                return spi.WriteRead(tx, txSize, rx, rxSize);
+            }
+            SpiTransport &spi;
+        };
+
+        std::vector<std::unique_ptr<LfSimulator>> boards;
+    };
+
+    TEST(LfFleet, OpenReportsFailedBoards) {
+        SimulatedRack rack(6);
+        LfFleet fleet(rack.Opener(), true, 3, 4);
+        auto report = fleet.Open(6);
+        EXPECT_EQ(report.Succeeded, 5u);
+        EXPECT_EQ(report.Failed, 1u);
+        ASSERT_EQ(report.Boards.size(), 6u);
+        EXPECT_FALSE(report.Boards[3].Ok);
+        EXPECT_EQ(report.Boards[3].Error, "Cannot open device");
+        EXPECT_EQ(fleet.Size(), 5u);
+    }
+
+    TEST(LfFleet, ScriptPerBoard) {
+        SimulatedRack rack(8);
+        LfFleet fleet(rack.Opener(), true, 3, 3);
+        fleet.Open(8);
+
+        std::vector<uint16_t> versions(8, 0);
+        auto report = fleet.Run([&versions](int device, LFSmart &lf) {
+            versions[device] = lf.Version();
+            lf.WriteDacChannel(lfc::Channel::CHANNEL_1, (uint16_t)(100 * device), false);
+        });
+        EXPECT_EQ(report.Succeeded, 7u);
+        for (int device = 0; device < 8; device++) {
+            if (device == 3)
+                continue;
+            EXPECT_EQ(versions[device], 200 + device);
+            EXPECT_EQ(rack.boards[device]->Dac(lfc::Channel::CHANNEL_1), 100 * device);
+        }
+        EXPECT_EQ(rack.boards[3]->Transfers(), 0u);
+    }
+
+    TEST(LfFleet, ScriptErrorsStayOnBoard) {
+        SimulatedRack rack(4);
+        LfFleet fleet(rack.Opener(), true, 2, 2);
+        fleet.Open(std::vector<int> {0, 1, 2});
+        rack.boards[1]->SetBitErrorRate(0.0, 0.5);
+
+        auto report = fleet.Run([](int, LFSmart &lf) { lf.Whoiam(); });
+        EXPECT_EQ(report.Succeeded, 2u);
+        EXPECT_FALSE(report.Boards[1].Ok);
+        EXPECT_TRUE(report.Boards[1].CrcError);
+        EXPECT_EQ(report.Boards[1].Device, 1);
+    }
+
+    TEST(LfFleet, BoardsRunInParallel) {
+        SimulatedRack rack(4);
+        LfFleet fleet(rack.Opener(), true, 1, 4);
+        fleet.Open(std::vector<int> {0, 1, 2});
+
+        std::atomic<int> running {0};
+        std::atomic<int> peak {0};
+        std::mutex mutex;
+        std::set<std::thread::id> threads;
+        fleet.Run([&](int, LFSmart &) {
+            int now = ++running;
+            int expected = peak.load();
+            while (now > expected && !peak.compare_exchange_weak(expected, now)) {
+            }
+            {
+                std::lock_guard<std::mutex> lock(mutex);
+                threads.insert(std::this_thread::get_id());
+            }
+            std::this_thread::sleep_for(std::chrono::milliseconds(50));
+            running--;
+        });
+        EXPECT_EQ(peak.load(), 3);
+        EXPECT_EQ(threads.size(), 3u);
+    }
+}
@@ -0,0 +1,176 @@
+#include <cstdio>
+#include <cstring>
+#include <memory>
+#include <string>
+#include <system_error>
+#include <thread>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/un.h>
+#include <unistd.h>
+#include "FtdiException.h"
+#include "I2cSimulator.h"
+#include "LFSmart.h"
+#include "LFSmartAsync.h"
+#include "LfClient.h"
+#include "LfServer.h"
+#include "LfSimulator.h"
+#include "gtest/gtest.h"
+
+namespace {
+
+    // Устройство 0 - модели, остальных нет
+    class TestProvider : public LfDeviceProvider {
+    public:
+        SpiTransport &Spi(int device) override {
+            if (device != 0)
+                throw FtdiException("Device not found");
+            return spi;
+        }
+        I2cBus &I2c(int device) override {
+            if (device != 0)
+                throw FtdiException("Device not found");
+            return iic;
+        }
+
+        LfSimulator spi;
+        I2cSimulator iic;
+    };
+
+    class LfsdTest : public ::testing::Test {
+    protected:
+        void SetUp() override {
+            path = "/tmp/lfsd_unittest_" + std::to_string(getpid()) + ".sock";
+            server.reset(new LfServer(devices, path));
+            thread = std::thread([this] { server->Run(); });
+        }
+        void TearDown() override {
+            server->Stop();
+            thread.join();
+            server.reset();
+        }
+
+        TestProvider devices;
+        std::string path;
+        std::unique_ptr<LfServer> server;
+        std::thread thread;
+    };
+
+    TEST_F(LfsdTest, RegistersOverSocket) {
+        SocketSpi spi(path, 0);
+        LFSmart lfSmart(spi, true);
+        EXPECT_EQ(lfSmart.Whoiam(), LFSmart::WhoiamExpected());
+        EXPECT_EQ(lfSmart.WriteDacChannel(lfc::Channel::CHANNEL_2, (uint16_t)1234, true), 1234);
+        EXPECT_EQ(devices.spi.Dac(lfc::Channel::CHANNEL_2), 1234);
+    }
+
+    TEST_F(LfsdTest, BatchIsOneRequest) {
+        SocketSpi spi(path, 0);
+        LFSmartAsync lf(spi, true);
+        lf.Write(lfc::Registers::DAC_CH1, 10);
+        lf.Write(lfc::Registers::DAC_CH3, 30);
+        auto ch1 = lf.Read(lfc::Registers::DAC_CH1);
+        auto ch3 = lf.Read(lfc::Registers::DAC_CH3);
+        EXPECT_EQ(ch1.get(), 10);
+        EXPECT_EQ(ch3.get(), 30);
+        EXPECT_EQ(devices.spi.Transfers(), lf.GetStats().Batches);
+    }
+
+    TEST_F(LfsdTest, I2cOverSocket) {
+        SocketI2c iic(path, 0);
+        uint8_t reg = 0x05;
+        uint16_t transferred = 0;
+        EXPECT_EQ(iic.WriteEx(I2cSimulator::DefaultAddress, FLAG_START, &reg, 1, transferred), 0);
+        EXPECT_EQ(transferred, 1);
+
+        uint8_t data[4] = {0};
+        iic.ReadEx(I2cSimulator::DefaultAddress, FLAG_START_AND_STOP, data, sizeof(data), transferred);
+        EXPECT_EQ(transferred, 4);
+        EXPECT_EQ(data[0], 0xA0);
+        EXPECT_EQ(data[3], 0xCC);
+        EXPECT_EQ(devices.iic.RegisterAddress(), 0x05);
+
+        uint8_t status = 0;
+        iic.WriteEx(0x12, FLAG_START_AND_STOP, &reg, 1, transferred);
+        iic.GetStatus(status);
+        EXPECT_EQ(transferred, 0);
+        EXPECT_NE(status & (1 << 2), 0);
+    }
+
+    TEST_F(LfsdTest, ErrorsBecomeExceptions) {
+        SocketSpi spi(path, 3);
+        LFSmart lfSmart(spi, true);
+        try {
+            lfSmart.Whoiam();
+            FAIL();
+        } catch (const FtdiException &e) {
+            EXPECT_STREQ(e.what(), "Device not found");
+        }
+
+        LfClient client(path);
+        EXPECT_THROW(client.Call({{"op", "flash"}}), FtdiException);
+        EXPECT_EQ(client.Call({{"op", "ping"}})["version"], LfServer::ProtocolVersion);
+    }
+
+    TEST_F(LfsdTest, MalformedRequest) {
+        auto reply = server->Handle({{"op", "spi"}, {"tx", "abc"}});
+        EXPECT_FALSE(reply["ok"].get<bool>());
+        EXPECT_EQ(reply["kind"], "request");
+    }
+
+    TEST_F(LfsdTest, ByteOutOfRange) {
+        for (int value : {256, -1}) {
+            auto reply = server->Handle({{"op", "spi"}, {"tx", {0x01, value}}, {"rx", 2}});
+            EXPECT_FALSE(reply["ok"].get<bool>());
+            EXPECT_EQ(reply["error"], "Byte out of range");
+            reply = server->Handle({{"op", "i2c_write"}, {"addr", 0x50}, {"flag", 0}, {"data", {value}}});
+            EXPECT_EQ(reply["error"], "Byte out of range");
+        }
+        EXPECT_EQ(devices.spi.Transactions(), 0u);
+    }
+
+    TEST(Lfsd, NoServer) {
+        EXPECT_THROW(LfClient("/tmp/lfsd_unittest_absent.sock"), std::system_error);
+    }
+
+    TEST_F(LfsdTest, SocketOwnerOnly) {
+        struct stat status {};
+        ASSERT_EQ(lstat(path.c_str(), &status), 0);
+        EXPECT_TRUE(S_ISSOCK(status.st_mode));
+        EXPECT_EQ(status.st_mode & 0777, 0600u);
+    }
+
+    TEST_F(LfsdTest, SecondServerRefused) {
+        TestProvider other;
+        EXPECT_THROW(LfServer(other, path), std::system_error);
+        LfClient client(path);
+        EXPECT_EQ(client.Call({{"op", "ping"}})["version"], LfServer::ProtocolVersion);
+    }
+
+    TEST(Lfsd, StaleSocketReplaced) {
+        std::string path = "/tmp/lfsd_unittest_stale_" + std::to_string(getpid()) + ".sock";
+        TestProvider devices;
+        {
+            // Сокет без сервера, как после аварийного завершения
+            int stale = socket(AF_UNIX, SOCK_STREAM, 0);
+            sockaddr_un address {};
+            address.sun_family = AF_UNIX;
+            strncpy(address.sun_path, path.c_str(), sizeof(address.sun_path) - 1);
+            ASSERT_EQ(bind(stale, reinterpret_cast<sockaddr *>(&address), sizeof(address)), 0);
+            close(stale);
+        }
+        EXPECT_NO_THROW(LfServer(devices, path));
+    }
+
+    TEST(Lfsd, RegularFileKept) {
+        std::string path = "/tmp/lfsd_unittest_file_" + std::to_string(getpid());
+        FILE *file = fopen(path.c_str(), "w");
+        ASSERT_NE(file, nullptr);
+        fclose(file);
+
+        TestProvider devices;
+        EXPECT_THROW(LfServer(devices, path), std::system_error);
+        EXPECT_EQ(access(path.c_str(), F_OK), 0);
+        unlink(path.c_str());
+    }
+}
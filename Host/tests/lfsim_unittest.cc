@@ -0,0 +1,159 @@
+#include "LFSmart.h"
+#include "LfSimulator.h"
+#include "gtest/gtest.h"
+
+namespace {
+
+    TEST(LfSimulator, LastErrorClearedByRead) {
+        LfSimulator sim;
+        LFSmart lfSmart(sim, true);
+        lfSmart.WriteDacChannelMaximum(lfc::Channel::CHANNEL_1, 100, false);
+        lfSmart.WriteDacChannel(lfc::Channel::CHANNEL_1, (uint16_t)101, false);
+        EXPECT_EQ(lfSmart.LastError(), lfc::LastError::LE_DAC_TRUNCATE);
+        EXPECT_EQ(lfSmart.LastError(), lfc::LastError::LE_NOERROR);
+        EXPECT_EQ(lfSmart.ReadDacChannel(lfc::Channel::CHANNEL_1), 100);
+    }
+
+    TEST(LfSimulator, AccessErrors) {
+        LfSimulator sim;
+        LFSmart lfSmart(sim, false);
+        lfSmart.WriteRaw(lfc::Registers::WHOIAM, 0x5555, false);
+        EXPECT_EQ(lfSmart.LastError(), lfc::LastError::LE_ACCESS_ERROR);
+        EXPECT_EQ(lfSmart.Whoiam(), LFSmart::WhoiamExpected());
+
+        lfSmart.ReadRaw(lfc::Registers::SVC);
+        EXPECT_EQ(lfSmart.LastError(), lfc::LastError::LE_ACCESS_ERROR);
+
+        lfSmart.ReadRaw(0x40);
+        EXPECT_EQ(lfSmart.LastError(), lfc::LastError::LE_UNKNOWN_COMMAND);
+    }
+
+    TEST(LfSimulator, DacAllAndInactive) {
+        LfSimulator sim;
+        LFSmart lfSmart(sim, true);
+        lfSmart.WriteDacChannelMaximum(lfc::Channel::CHANNEL_3, 500, false);
+        lfSmart.WriteRaw(lfc::Registers::DAC_ALL, 1000, false);
+        EXPECT_EQ(lfSmart.LastError(), lfc::LastError::LE_DAC_TRUNCATE);
+        EXPECT_EQ(sim.Dac(lfc::Channel::CHANNEL_1), 1000);
+        EXPECT_EQ(sim.Dac(lfc::Channel::CHANNEL_3), 500);
+
+        lfSmart.SVC(LF_SVC_STOP);
+        EXPECT_EQ(lfSmart.Status() & LF_STATUS_ENABLED, 0u);
+        lfSmart.WriteDacChannel(lfc::Channel::CHANNEL_1, (uint16_t)7, false);
+        EXPECT_EQ(lfSmart.LastError(), lfc::LastError::LE_INACTIVE);
+        EXPECT_EQ(lfSmart.ReadDacChannel(lfc::Channel::CHANNEL_1), 1000);
+
+        lfSmart.SVC(LS_SVC_START);
+        lfSmart.WriteDacChannel(lfc::Channel::CHANNEL_1, (uint16_t)7, false);
+        EXPECT_EQ(lfSmart.LastError(), lfc::LastError::LE_NOERROR);
+    }
+
+    TEST(LfSimulator, AdcAll) {
+        LfSimulator sim;
+        LFSmart lfSmart(sim, true);
+        for (int ch = lfc::Channel::CHANNEL_1; ch <= lfc::Channel::CHANNEL_4; ch++)
+            sim.SetAdc(static_cast<lfc::Channel>(ch), static_cast<uint16_t>(0x0100 * (ch + 1) + ch));
+
+        uint16_t channels[4];
+        lfSmart.ReadAdcAll(channels);
+        for (int ch = 0; ch < 4; ch++)
+            EXPECT_EQ(channels[ch], 0x0100 * (ch + 1) + ch);
+        EXPECT_EQ(lfSmart.ReadAdcChannel(lfc::Channel::CHANNEL_3), 0x0302);
+
+        lfSmart.SVC(LF_SVC_ADC_DIS);
+        EXPECT_EQ(lfSmart.Status() & LF_STATUS_ADC_ENABLED, 0u);
+        lfSmart.ReadAdcAll(channels);
+        EXPECT_EQ(channels[0], 0);
+    }
+
+    // Сброс загружает только сохранённые маской SAVE_EEP значения
+    TEST(LfSimulator, ResetRestoresSavedRegisters) {
+        LfSimulator sim;
+        LFSmart lfSmart(sim, true);
+        lfSmart.WriteDacDefault(lfc::Channel::CHANNEL_1, (uint16_t)10, false);
+        lfSmart.WriteDacDefault(lfc::Channel::CHANNEL_2, (uint16_t)20, false);
+        lfSmart.WriteDacChannelMaximum(lfc::Channel::CHANNEL_2, 15, false);
+        lfSmart.SaveDacToEeprom(NV_DAC_DEFAULT_CH1 | NV_DAC_MAX_CH2);
+        EXPECT_EQ(lfSmart.LastError(), lfc::LastError::LE_NOERROR);
+        lfSmart.WriteCert(LF_CERT_START);
+
+        lfSmart.SVC(LF_SVC_RESET);
+        EXPECT_EQ(lfSmart.ReadDacChannel(lfc::Channel::CHANNEL_1), 10);
+        EXPECT_EQ(lfSmart.ReadDacDefault(lfc::Channel::CHANNEL_2), 0);
+        EXPECT_EQ(lfSmart.ReadDacChannelMaximum(lfc::Channel::CHANNEL_2), 15);
+        EXPECT_EQ(lfSmart.ReadDacChannelMaximum(lfc::Channel::CHANNEL_1), UINT16_MAX);
+        EXPECT_EQ(lfSmart.ReadCert(), 0);
+        EXPECT_EQ(lfSmart.Status(), LF_STATUS_PG | LF_STATUS_ADC_ENABLED | LF_STATUS_ENABLED);
+    }
+
+    TEST(LfSimulator, ReadCrc) {
+        LfSimulator sim;
+        LFSmart lfSmart(sim, true);
+        auto crc = lfSmart.ReadCRC();
+        EXPECT_EQ(crc.first, crc.second);
+        EXPECT_EQ(lfSmart.Version(), LFSmart::MakeVersion(0, 2, 0));
+    }
+
+    // Ошибки на MISO: с CRC чтение повторяется до верного ответа, без CRC возвращаются искажённые данные
+    TEST(LfSimulator, CrcRetryOnMisoErrors) {
+        LfSimulator::Options options;
+        options.MisoBitErrorRate = 0.005;
+        options.Seed = 42;
+        LfSimulator sim(options);
+
+        LFSmart withCrc(sim, true, 20);
+        for (int i = 0; i < 40; i++)
+            ASSERT_EQ(withCrc.Whoiam(), LFSmart::WhoiamExpected());
+        EXPECT_GT(sim.BitErrors(), 0u);
+        EXPECT_GT(sim.Transfers(), 40u);
+
+        LFSmart withoutCrc(sim, false);
+        int wrong = 0;
+        for (int i = 0; i < 200; i++)
+            wrong += withoutCrc.Whoiam() != LFSmart::WhoiamExpected();
+        EXPECT_GT(wrong, 0);
+    }
+
+    /*
+     * Ошибки на MOSI: запись с неверной CRC не выполняется и отмечается LE_CRC_ERROR. Инверсия бита доступа
+     * превращает запись в чтение, такая запись теряется без ошибки, но искажённое значение не применяется никогда.
+     */
+    TEST(LfSimulator, CorruptedWriteRejected) {
+        LfSimulator sim;
+        LFSmart lfSmart(sim, true);
+
+        uint16_t applied = 0;
+        int rejected = 0;
+        for (uint16_t value = 1; value <= 100; value++) {
+            sim.SetBitErrorRate(0.01, 0.0);
+            lfSmart.WriteDacChannel(lfc::Channel::CHANNEL_2, value, false);
+            sim.SetBitErrorRate(0.0, 0.0);
+
+            auto error = lfSmart.LastError();
+            uint16_t dac = sim.Dac(lfc::Channel::CHANNEL_2);
+            if (error == lfc::LastError::LE_CRC_ERROR) {
+                EXPECT_EQ(dac, applied);
+                rejected++;
+            } else {
+                EXPECT_EQ(error, lfc::LastError::LE_NOERROR);
+                EXPECT_TRUE(dac == value || dac == applied);
+                applied = dac;
+            }
+        }
+        EXPECT_GT(rejected, 0);
+        EXPECT_LT(rejected, 100);
+    }
+
+    TEST(LfSimulator, LatencyAccounting) {
+        LfSimulator::Options options;
+        options.Latency = std::chrono::microseconds(250);
+        LfSimulator sim(options);
+        LFSmart lfSmart(sim, true);
+
+        lfSmart.Whoiam();
+        lfSmart.WriteDacChannel(lfc::Channel::CHANNEL_4, (uint16_t)123, true);
+        EXPECT_EQ(sim.Transfers(), 3u);
+        EXPECT_EQ(sim.Transactions(), 3u);
+        EXPECT_EQ(sim.SimulatedTime(), std::chrono::microseconds(750));
+    }
+}
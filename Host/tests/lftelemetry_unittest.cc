@@ -0,0 +1,175 @@
+#include <cstdio>
+#include <fstream>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <unistd.h>
+#include "LfSimulator.h"
+#include "TelemetryFile.h"
+#include "TelemetryRecorder.h"
+#include "gtest/gtest.h"
+
+namespace {
+
+    class TelemetryTest : public ::testing::Test {
+    protected:
+        void SetUp() override {
+            path = "/tmp/lftelemetry_unittest_" + std::to_string(getpid()) + ".lft";
+        }
+        void TearDown() override {
+            remove(path.c_str());
+        }
+
+        std::string path;
+    };
+
+    TEST_F(TelemetryTest, WriterReaderRoundTrip) {
+        {
+            TelemetryWriter writer(path, {{"a", 1}, {"b", 2}, {"c", 4}, {"d", 8}}, {{"source", "test"}}, 16);
+            for (uint64_t i = 0; i < 100; i++) {
+                uint64_t values[4] = {i, 1000 + i, 100000 + i, 0x123456789ULL * i};
+                writer.Append(values);
+            }
+        }
+
+        TelemetryReader reader(path);
+        EXPECT_EQ(reader.Samples(), 100u);
+        EXPECT_EQ(reader.Meta()["source"], "test");
+        ASSERT_EQ(reader.Columns().size(), 4u);
+        EXPECT_EQ(reader.FindColumn("c"), 2);
+        EXPECT_EQ(reader.FindColumn("x"), -1);
+        EXPECT_EQ(reader.Value(0, 99), 99u);
+        EXPECT_EQ(reader.Value(3, 17), 0x123456789ULL * 17);
+
+        auto b = reader.Column(1);
+        auto d = reader.Column(3);
+        for (uint64_t i = 0; i < 100; i++) {
+            EXPECT_EQ(b[i], 1000 + i);
+            EXPECT_EQ(d[i], 0x123456789ULL * i);
+        }
+        EXPECT_THROW(reader.Value(0, 100), std::out_of_range);
+    }
+
+    TEST_F(TelemetryTest, ReadableWhileWriting) {
+        TelemetryWriter writer(path, {{"v", 2}}, nlohmann::json::object(), 8);
+        for (uint64_t i = 0; i < 20; i++)
+            writer.Append(&i);
+
+        TelemetryReader reader(path);
+        EXPECT_EQ(reader.Samples(), 20u);
+        EXPECT_EQ(reader.Value(0, 19), 19u);
+    }
+
+    TEST_F(TelemetryTest, NotTelemetryFile) {
+        std::ofstream(path) << "definitely not telemetry, but long enough to hold a header ..........................";
+        EXPECT_THROW(TelemetryReader reader(path), std::runtime_error);
+    }
+
+    TEST_F(TelemetryTest, RecordSimulatedDevice) {
+        LfSimulator sim;
+        sim.SetAdc(lfc::Channel::CHANNEL_1, 111);
+        sim.SetAdc(lfc::Channel::CHANNEL_4, 444);
+        sim.SetTemperature(300, 310);
+
+        TelemetryRecorder::Options options;
+        options.Samples = 5000;
+        options.BlockSamples = 1024;
+        TelemetryRecorder recorder(sim, {lfc::Registers::STATUS, lfc::Registers::ADC_ALL, lfc::Registers::THRM_PCB,
+                                         lfc::Registers::THRM_MCU, lfc::Registers::CRC_HW}, options);
+        auto stats = recorder.Record(path);
+        EXPECT_EQ(stats.Samples, 5000u);
+        EXPECT_EQ(stats.CrcErrors, 0u);
+        EXPECT_GT(stats.Rate, 0.0);
+
+        // Одна транзакция USB на запись
+        EXPECT_EQ(sim.Transfers(), 5000u);
+
+        TelemetryReader reader(path);
+        EXPECT_EQ(reader.Samples(), 5000u);
+        EXPECT_EQ(reader.Meta()["registers"].size(), 5u);
+        auto adc1 = reader.Column(reader.FindColumn("ADC_ALL_1"));
+        auto adc4 = reader.Column(reader.FindColumn("ADC_ALL_4"));
+        auto pcb = reader.Column(reader.FindColumn("THRM_PCB"));
+        auto time = reader.Column(reader.FindColumn("time_ns"));
+        for (uint64_t i = 0; i < reader.Samples(); i++) {
+            EXPECT_EQ(adc1[i], 111u);
+            EXPECT_EQ(adc4[i], 444u);
+            EXPECT_EQ(pcb[i], 300u);
+            if (i > 0) {
+                EXPECT_GE(time[i], time[i - 1]);
+            }
+        }
+        EXPECT_EQ(reader.Value(reader.FindColumn("CRC_HW"), 0), 0x5A3C96E1u);
+    }
+
+    TEST_F(TelemetryTest, CrcErrorsAreFlagged) {
+        LfSimulator sim;
+        sim.SetBitErrorRate(0.0, 0.02);
+
+        TelemetryRecorder::Options options;
+        options.Samples = 2000;
+        options.Tries = 1;
+        TelemetryRecorder recorder(sim, {lfc::Registers::WHOIAM, lfc::Registers::VERSION}, options);
+        auto stats = recorder.Record(path);
+        EXPECT_GT(stats.CrcErrors, 0u);
+
+        TelemetryReader reader(path);
+        auto flags = reader.Column(reader.FindColumn("flags"));
+        auto whoiam = reader.Column(reader.FindColumn("WHOIAM"));
+        uint64_t flagged = 0;
+        for (uint64_t i = 0; i < reader.Samples(); i++) {
+            flagged += ((flags[i] & 1) != 0) + ((flags[i] & 2) != 0);
+            if ((flags[i] & 1) == 0) {
+                EXPECT_EQ(whoiam[i], 0x1234u);
+            }
+        }
+        EXPECT_EQ(flagged, stats.CrcErrors);
+    }
+
+    TEST_F(TelemetryTest, PeriodAndStop) {
+        LfSimulator sim;
+        TelemetryRecorder::Options options;
+        options.Period = std::chrono::microseconds(1000);
+        TelemetryRecorder recorder(sim, {lfc::Registers::STATUS}, options);
+
+        std::thread stopper([&recorder] {
+            std::this_thread::sleep_for(std::chrono::milliseconds(100));
+            recorder.Stop();
+        });
+        auto stats = recorder.Record(path);
+        stopper.join();
+
+        EXPECT_GT(stats.Samples, 50u);
+        EXPECT_LT(stats.Samples, 150u);
+        EXPECT_NEAR(stats.MeanInterval.count(), 1000000, 200000);
+    }
+
+    TEST_F(TelemetryTest, CsvExport) {
+        LfSimulator sim;
+        TelemetryRecorder::Options options;
+        options.Samples = 3;
+        TelemetryRecorder recorder(sim, {lfc::Registers::WHOIAM}, options);
+        recorder.Record(path);
+
+        std::ostringstream csv;
+        TelemetryReader(path).ExportCsv(csv);
+        std::istringstream lines(csv.str());
+        std::string line;
+        std::getline(lines, line);
+        EXPECT_EQ(line, "time_ns,flags,WHOIAM");
+        int rows = 0;
+        while (std::getline(lines, line)) {
+            EXPECT_NE(line.find(",0,4660"), std::string::npos);
+            rows++;
+        }
+        EXPECT_EQ(rows, 3);
+    }
+
+    TEST(TelemetryRecorder, RejectsWriteOnlyRegister) {
+        LfSimulator sim;
+        EXPECT_THROW(TelemetryRecorder(sim, {lfc::Registers::SVC}, {}), std::invalid_argument);
+        EXPECT_EQ(TelemetryRecorder::RegisterFromName("THRM_MCU"), lfc::Registers::THRM_MCU);
+        EXPECT_EQ(TelemetryRecorder::RegisterFromName("SAVE_EEP"), lfc::Registers::INVALID);
+    }
+}
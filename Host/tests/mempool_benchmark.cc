@@ -0,0 +1,169 @@
+/**
+ * Сравнение heap_4 и пулов блоков на трассе выделений прошивки.
+ *
+ * Трасса снимается с устройства при CONFIG_MEMPOOL_TRACE = 1 (вывод RTT канала 0 в файл), строки вида
+ *   @M <адрес hex> <размер>
+ *   @F <адрес hex> <размер>
+ * остальные строки пропускаются. Без аргумента используется синтетическая нагрузка, похожая на прошивку:
+ * отчёты USB по 64 байта, записи лога, редкие большие буферы.
+ *
+ * Использование: mempool_benchmark [trace.txt]
+ */
+
+#include <chrono>
+#include <cstdio>
+#include <fstream>
+#include <map>
+#include <random>
+#include <sstream>
+#include <string>
+#include <vector>
+#include "mempool.h"
+#include "FreeRTOS.h"
+
+
+struct TraceOp {
+    bool Alloc;
+    uint32_t Id;
+    uint32_t Size;
+};
+
+static std::vector<TraceOp> LoadTrace(const char *filename) {
+    std::vector<TraceOp> ops;
+    std::ifstream in(filename);
+    std::map<uint32_t, uint32_t> live;      // адрес на устройстве -> идентификатор
+    uint32_t next_id = 0;
+    std::string line;
+    while (std::getline(in, line)) {
+        auto pos = line.find('@');
+        if (pos == std::string::npos || pos + 1 >= line.size())
+            continue;
+        char kind = line[pos + 1];
+        if (kind != 'M' && kind != 'F')
+            continue;
+        std::istringstream ss(line.substr(pos + 2));
+        uint32_t address, size;
+        if (!(ss >> std::hex >> address >> std::dec >> size))
+            continue;
+        if (kind == 'M') {
+            live[address] = next_id;
+            ops.push_back({true, next_id++, size});
+        } else {
+            auto it = live.find(address);
+            if (it == live.end())
+                continue;
+            ops.push_back({false, it->second, size});
+            live.erase(it);
+        }
+    }
+    return ops;
+}
+
+static std::vector<TraceOp> SyntheticTrace(size_t count) {
+    std::vector<TraceOp> ops;
+    std::vector<uint32_t> live;
+    std::mt19937 rnd(2021);
+    uint32_t next_id = 0;
+    while (ops.size() < count) {
+        if (live.size() < 10 && (rnd() % 8) < 5) {
+            uint32_t r = rnd() % 100, size;
+            if (r < 50)
+                size = 64;                              // отчёт USB
+            else if (r < 85)
+                size = 4 + rnd() % 12;                  // запись тега лога
+            else
+                size = 128 + rnd() % 128;               // буфер ввода-вывода
+            live.push_back(next_id);
+            ops.push_back({true, next_id++, size});
+        } else if (!live.empty()) {
+            size_t i = rnd() % live.size();
+            ops.push_back({false, live[i], 0});
+            live.erase(live.begin() + i);
+        }
+    }
+    return ops;
+}
+
+
+struct Result {
+    double NsPerOp;
+    uint32_t Failures;
+    uint64_t Requested;
+    uint64_t Granted;
+};
+
+template <typename Alloc, typename Free, typename Granted>
+static Result Run(const std::vector<TraceOp> &ops, uint32_t max_id, Alloc alloc, Free release, Granted granted) {
+    std::vector<void *> slots(max_id, nullptr);
+    Result r {0, 0, 0, 0};
+    auto start = std::chrono::steady_clock::now();
+    for (const auto &op : ops) {
+        if (op.Alloc) {
+            void *p = alloc(op.Size);
+            if (p == nullptr) {
+                r.Failures++;
+            } else {
+                r.Requested += op.Size;
+                r.Granted += granted(p, op.Size);
+            }
+            slots[op.Id] = p;
+        } else {
+            release(slots[op.Id]);
+            slots[op.Id] = nullptr;
+        }
+    }
+    for (auto p : slots)
+        release(p);
+    auto stop = std::chrono::steady_clock::now();
+    r.NsPerOp = std::chrono::duration<double, std::nano>(stop - start).count() / ops.size();
+    return r;
+}
+
+static void Print(const char *name, const Result &r) {
+    double waste = r.Granted ? 100.0 * (r.Granted - r.Requested) / r.Granted : 0.0;
+    printf("%-8s %8.1f ns/op  failures %6u  internal waste %5.1f %%\n", name, r.NsPerOp, r.Failures, waste);
+}
+
+
+int main(int argc, char *argv[]) {
+    std::vector<TraceOp> ops = (argc > 1) ? LoadTrace(argv[1]) : SyntheticTrace(200000);
+    if (ops.empty()) {
+        fprintf(stderr, "Empty trace\n");
+        return 1;
+    }
+
+    uint32_t max_id = 0;
+    for (const auto &op : ops)
+        if (op.Id + 1 > max_id)
+            max_id = op.Id + 1;
+    printf("Trace: %zu operations, %u allocations\n", ops.size(), max_id);
+
+    // Размер блока heap_4 на хосте: заголовок 16 байт, выравнивание 8. На Cortex-M3 заголовок 8 байт.
+    const size_t header = 2 * sizeof(void *);
+    auto heap = Run(ops, max_id,
+                    [](size_t size) { return pvPortMalloc(size); },
+                    [](void *p) { vPortFree(p); },
+                    [header](void *, size_t size) {
+                        return ((size + header + portBYTE_ALIGNMENT - 1) & ~(size_t)(portBYTE_ALIGNMENT - 1));
+                    });
+
+    auto pool = Run(ops, max_id,
+                    [](size_t size) { return PoolAlloc(size); },
+                    [](void *p) { PoolFree(p); },
+                    [](void *p, size_t) {
+                        for (unsigned i = 0; i < MEMPOOL_CLASS_COUNT; i++)
+                            if (MemPoolOwns(*PoolGetClass(i), p))
+                                return (size_t)PoolGetClass(i)->BlockSize;
+                        return (size_t)0;
+                    });
+
+    Print("heap_4", heap);
+    Print("mempool", pool);
+    for (unsigned i = 0; i < MEMPOOL_CLASS_COUNT; i++) {
+        MemPoolStats stats {};
+        MemPoolGetStats(*PoolGetClass(i), stats);
+        printf("  class %u: %3u x %-3u high water %3u, allocs %u, fails %u\n", i, stats.BlockCount, stats.BlockSize,
+               stats.HighWater, stats.AllocCount, stats.FailCount);
+    }
+    return 0;
+}
@@ -0,0 +1,183 @@
+#include <algorithm>
+#include <atomic>
+#include <cstring>
+#include <random>
+#include <thread>
+#include <vector>
+#include "mempool.h"
+#include "FreeRTOS.h"
+#include "gtest/gtest.h"
+
+namespace {
+
+    struct TestPool {
+        explicit TestPool(uint16_t size, uint16_t count) : storage(size * count / sizeof(uint32_t)) {
+            pool = MEMPOOL_INITIALIZER(storage.data(), size, count);
+        }
+        std::vector<uint32_t> storage;
+        MemPool pool;
+    };
+
+    TEST(MemPool, ExhaustAndReuse) {
+        TestPool tp(16, 8);
+        std::vector<void *> blocks;
+        for (int i = 0; i < 8; i++) {
+            void *p = MemPoolAlloc(tp.pool);
+            ASSERT_NE(p, nullptr);
+            EXPECT_TRUE(MemPoolOwns(tp.pool, p));
+            blocks.push_back(p);
+        }
+        EXPECT_EQ(MemPoolAlloc(tp.pool), nullptr);
+
+        std::sort(blocks.begin(), blocks.end());
+        EXPECT_EQ(std::unique(blocks.begin(), blocks.end()), blocks.end());
+
+        MemPoolStats stats {};
+        MemPoolGetStats(tp.pool, stats);
+        EXPECT_EQ(stats.Used, 8u);
+        EXPECT_EQ(stats.HighWater, 8u);
+        EXPECT_EQ(stats.FailCount, 1u);
+
+        MemPoolFree(tp.pool, blocks[3]);
+        EXPECT_EQ(MemPoolAlloc(tp.pool), blocks[3]);
+
+        for (auto p : blocks)
+            MemPoolFree(tp.pool, p);
+        MemPoolGetStats(tp.pool, stats);
+        EXPECT_EQ(stats.Used, 0u);
+        EXPECT_EQ(stats.HighWater, 8u);
+        MemPoolResetHighWater(tp.pool);
+        MemPoolGetStats(tp.pool, stats);
+        EXPECT_EQ(stats.HighWater, 0u);
+    }
+
+    TEST(MemPool, OwnsRejectsForeignPointers) {
+        TestPool tp(16, 4);
+        uint32_t foreign[4];
+        EXPECT_FALSE(MemPoolOwns(tp.pool, foreign));
+        void *p = MemPoolAlloc(tp.pool);
+        EXPECT_FALSE(MemPoolOwns(tp.pool, static_cast<uint8_t *>(p) + 4));
+    }
+
+    TEST(PoolAlloc, SizeClasses) {
+        void *small = PoolAlloc(CONFIG_MEMPOOL_CLASS0_SIZE);
+        void *usb = PoolAlloc(64);
+        void *big = PoolAlloc(CONFIG_MEMPOOL_CLASS1_SIZE + 1);
+        EXPECT_TRUE(MemPoolOwns(*PoolGetClass(0), small));
+        EXPECT_TRUE(MemPoolOwns(*PoolGetClass(1), usb));
+        EXPECT_TRUE(MemPoolOwns(*PoolGetClass(2), big));
+        EXPECT_EQ(PoolAlloc(CONFIG_MEMPOOL_CLASS2_SIZE + 1), nullptr);
+        PoolFree(small);
+        PoolFree(usb);
+        PoolFree(big);
+        for (unsigned i = 0; i < MEMPOOL_CLASS_COUNT; i++)
+            EXPECT_EQ(PoolGetClass(i)->Used, 0u);
+    }
+
+    TEST(PoolAlloc, FallsBackToLargerClass) {
+        std::vector<void *> blocks;
+        for (int i = 0; i < CONFIG_MEMPOOL_CLASS0_COUNT; i++)
+            blocks.push_back(PoolAlloc(1));
+        void *p = PoolAlloc(1);
+        EXPECT_TRUE(MemPoolOwns(*PoolGetClass(1), p));
+        PoolFree(p);
+        for (auto b : blocks)
+            PoolFree(b);
+    }
+
+    // Вытеснение обработчиком прерывания моделируется потоками: каждый поток метит свои блоки и проверяет, что
+    // никто не получил тот же блок одновременно.
+    TEST(MemPool, ConcurrentAllocFree) {
+        TestPool tp(16, 64);
+        constexpr int Threads = 4;
+        constexpr int Iterations = 200000;
+        std::atomic<int> errors {0};
+
+        auto worker = [&](uint32_t id) {
+            std::mt19937 rnd(id);
+            std::vector<uint32_t *> own;
+            for (int i = 0; i < Iterations; i++) {
+                if (own.size() < 8 && (rnd() & 1)) {
+                    auto p = static_cast<uint32_t *>(MemPoolAlloc(tp.pool));
+                    if (p) {
+                        p[1] = id;
+                        own.push_back(p);
+                    }
+                } else if (!own.empty()) {
+                    uint32_t *p = own.back();
+                    own.pop_back();
+                    if (p[1] != id)
+                        errors++;
+                    MemPoolFree(tp.pool, p);
+                }
+            }
+            for (auto p : own)
+                MemPoolFree(tp.pool, p);
+        };
+
+        std::vector<std::thread> threads;
+        for (int i = 0; i < Threads; i++)
+            threads.emplace_back(worker, i + 1);
+        for (auto &t : threads)
+            t.join();
+
+        EXPECT_EQ(errors.load(), 0);
+        EXPECT_EQ(tp.pool.Used, 0u);
+        EXPECT_LE(tp.pool.HighWater, 64u);
+        std::vector<void *> all;
+        while (void *p = MemPoolAlloc(tp.pool))
+            all.push_back(p);
+        EXPECT_EQ(all.size(), 64u);
+    }
+
+    // Фрагментация: одинаковая нагрузка на heap_4 и на пулы. Пул отказывает только при исчерпании класса,
+    // heap_4 может отказать при достаточном суммарном свободном объёме из-за фрагментации.
+    TEST(Fragmentation, Heap4VersusPools) {
+        std::mt19937 rnd(12345);
+        const size_t sizes[] = {12, 16, 40, 64, 64, 100, 200, 256};
+        struct Live { void *heap; void *pool; size_t size; };
+        std::vector<Live> live;
+
+        int heap_frag_failures = 0;
+        int pool_failures_with_room = 0;
+        for (int step = 0; step < 50000; step++) {
+            if (live.size() < 24 && (rnd() % 3)) {
+                size_t size = sizes[rnd() % (sizeof(sizes) / sizeof(sizes[0]))];
+                size_t free_before = xPortGetFreeHeapSize();
+                void *h = pvPortMalloc(size);
+                if (h == nullptr && free_before >= size + 2 * sizeof(void *) * 2)
+                    heap_frag_failures++;
+
+                bool room = false;
+                for (unsigned c = 0; c < MEMPOOL_CLASS_COUNT; c++) {
+                    MemPool *pool = PoolGetClass(c);
+                    if (size <= pool->BlockSize && pool->Used < pool->BlockCount)
+                        room = true;
+                }
+                void *p = PoolAlloc(size);
+                if (p == nullptr && room)
+                    pool_failures_with_room++;
+                if (p)
+                    memset(p, 0xA5, size);
+                live.push_back({h, p, size});
+            } else if (!live.empty()) {
+                size_t i = rnd() % live.size();
+                vPortFree(live[i].heap);
+                PoolFree(live[i].pool);
+                live.erase(live.begin() + i);
+            }
+        }
+        for (auto &l : live) {
+            vPortFree(l.heap);
+            PoolFree(l.pool);
+        }
+
+        HeapStats_t stats {};
+        vPortGetHeapStats(&stats);
+        RecordProperty("heap4_fragmentation_failures", heap_frag_failures);
+        RecordProperty("heap4_min_ever_free", static_cast<int>(stats.xMinimumEverFreeBytesRemaining));
+        EXPECT_EQ(pool_failures_with_room, 0);
+        for (unsigned c = 0; c < MEMPOOL_CLASS_COUNT; c++)
+            EXPECT_EQ(PoolGetClass(c)->Used, 0u);
+    }
+}
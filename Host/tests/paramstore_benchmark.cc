@@ -0,0 +1,56 @@
+/**
+ * Журнал параметров param_log на модели flash: скорость записи и износ страниц.
+ *
+ * Время flash считается по задержкам SPL: запись слова 61 мкс, стирание страницы ~164 мс. Для сравнения -
+ * хранение с перезаписью страницы на каждое сохранение (стирание и запись всех параметров).
+ *
+ * Использование: paramstore_benchmark [сохранений] [размер страницы]
+ */
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <random>
+#include "flash_sim.h"
+#include "param_log.h"
+
+
+int main(int argc, char *argv[]) {
+    uint32_t commits = argc > 1 ? strtoul(argv[1], nullptr, 0) : 100000;
+    uint32_t pageSize = argc > 2 ? strtoul(argv[2], nullptr, 0) : 4096;
+
+    FlashSim sim(pageSize);
+    ParamFlash flash = sim.Flash();
+    ParamLog log;
+    ParamLogMount(log, flash);
+    uint64_t programs = sim.Programs();
+    std::vector<uint32_t> erases = sim.Erases();
+
+    std::mt19937 random(1);
+    double foregroundUs = 0;
+    auto start = std::chrono::steady_clock::now();
+    for (uint32_t i = 0; i < commits; i++) {
+        uint64_t before = sim.Programs();
+        ParamLogSet(log, random() % PARAM_LOG_KEYS, random());
+        foregroundUs += (sim.Programs() - before) * FlashSim::ProgramUs;
+        while (ParamLogNeedsCollect(log))
+            ParamLogCollect(log);
+    }
+    double hostS = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+    uint32_t erase0 = sim.Erases()[0] - erases[0], erase1 = sim.Erases()[1] - erases[1];
+    double flashS = (sim.BusyUs() - programs * FlashSim::ProgramUs) / 1e6;
+    printf("Commits %u, page %u bytes, %u keys\n", commits, pageSize, PARAM_LOG_KEYS);
+    printf("  Word programs %llu, %.2f per commit\n", (unsigned long long)(sim.Programs() - programs),
+           (double)(sim.Programs() - programs) / commits);
+    printf("  Page erases %u / %u, one per %.0f commits\n", erase0, erase1, (double)commits / (erase0 + erase1));
+    printf("  Commit latency %.0f us, %.0f commits/s\n", foregroundUs / commits, commits * 1e6 / foregroundUs);
+    printf("  Flash busy incl. background %.1f s, %.0f commits/s sustained\n", flashS, commits / flashS);
+    printf("  Host %.0f commits/s\n", commits / hostS);
+
+    double rewriteUs = FlashSim::EraseUs + PARAM_LOG_KEYS * FlashSim::ProgramUs;
+    printf("Page rewrite per commit: %.0f us, %.1f commits/s, %u erases\n", rewriteUs, 1e6 / rewriteUs, commits);
+    printf("Endurance at 10000 erases per page: %.0f commits\n",
+           10000.0 * 2 * commits / std::max(1u, erase0 + erase1));
+    return 0;
+}
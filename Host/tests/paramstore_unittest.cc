@@ -0,0 +1,187 @@
+#include <map>
+#include <random>
+#include "flash_sim.h"
+#include "param_log.h"
+#include "gtest/gtest.h"
+
+namespace {
+
+    // Фоновая сборка, как в задаче Params
+    void Collect(ParamLog &log) {
+        while (ParamLogNeedsCollect(log))
+            ASSERT_TRUE(ParamLogCollect(log));
+    }
+
+    TEST(ParamLog, FormatsBlankFlash) {
+        FlashSim sim;
+        ParamFlash flash = sim.Flash();
+        ParamLog log;
+        ASSERT_TRUE(ParamLogMount(log, flash));
+
+        uint16_t value;
+        EXPECT_FALSE(ParamLogGet(log, 0, value));
+        EXPECT_EQ(log.Active, 0);
+        EXPECT_EQ(log.Generation, 1u);
+        EXPECT_TRUE(log.SpareErased);
+        EXPECT_EQ(sim.Erases()[0], 1u);
+        EXPECT_EQ(ParamLogFreeSlots(log), (4096u - PARAM_LOG_HEADER_SIZE) / PARAM_LOG_RECORD_SIZE);
+    }
+
+    TEST(ParamLog, CommitIsTwoWordsWithoutErase) {
+        FlashSim sim;
+        ParamFlash flash = sim.Flash();
+        ParamLog log;
+        ParamLogMount(log, flash);
+        uint64_t programs = sim.Programs();
+
+        EXPECT_EQ(ParamLogSet(log, 3, 1234), PARAM_LOG_OK);
+        EXPECT_EQ(sim.Programs() - programs, 2u);
+        EXPECT_EQ(ParamLogSet(log, 3, 1234), PARAM_LOG_OK);     // то же значение - flash не трогается
+        EXPECT_EQ(sim.Programs() - programs, 2u);
+        EXPECT_EQ(log.Stats.Unchanged, 1u);
+        EXPECT_EQ(sim.Erases()[0] + sim.Erases()[1], 1u);
+
+        uint16_t value = 0;
+        EXPECT_TRUE(ParamLogGet(log, 3, value));
+        EXPECT_EQ(value, 1234);
+        EXPECT_EQ(ParamLogSet(log, PARAM_LOG_KEYS, 1), PARAM_LOG_ERROR);
+    }
+
+    TEST(ParamLog, RemountRebuildsIndex) {
+        FlashSim sim;
+        ParamFlash flash = sim.Flash();
+        ParamLog log;
+        ParamLogMount(log, flash);
+        for (uint16_t i = 0; i < 100; i++)
+            ParamLogSet(log, i % 5, 1000 + i);
+
+        ParamLog mounted;
+        ASSERT_TRUE(ParamLogMount(mounted, flash));
+        EXPECT_EQ(mounted.Tail, log.Tail);
+        EXPECT_EQ(mounted.Present, 0x1Fu);
+        for (uint8_t key = 0; key < 5; key++) {
+            uint16_t value = 0;
+            EXPECT_TRUE(ParamLogGet(mounted, key, value));
+            EXPECT_EQ(value, 1095 + key);
+        }
+    }
+
+    TEST(ParamLog, FullWithoutCollect) {
+        FlashSim sim(256);
+        ParamFlash flash = sim.Flash();
+        ParamLog log;
+        ParamLogMount(log, flash);
+
+        uint32_t slots = ParamLogFreeSlots(log);
+        for (uint32_t i = 0; i < slots; i++)
+            ASSERT_EQ(ParamLogSet(log, 0, i), PARAM_LOG_OK);
+        EXPECT_EQ(ParamLogSet(log, 0, 0xFFFF), PARAM_LOG_FULL);
+        EXPECT_TRUE(ParamLogNeedsCollect(log));
+
+        Collect(log);
+        EXPECT_EQ(ParamLogSet(log, 0, 0xFFFF), PARAM_LOG_OK);
+        EXPECT_EQ(log.Active, 1);
+        EXPECT_EQ(log.Generation, 2u);
+    }
+
+    // Длительная работа со сборкой в фоне: значения не теряются, страницы стираются поровну
+    TEST(ParamLog, WearIsBalanced) {
+        FlashSim sim(512);
+        ParamFlash flash = sim.Flash();
+        ParamLog log;
+        ParamLogMount(log, flash);
+
+        std::mt19937 random(1);
+        std::map<uint8_t, uint16_t> expected;
+        for (int i = 0; i < 20000; i++) {
+            uint8_t key = random() % PARAM_LOG_KEYS;
+            uint16_t value = random();
+            ASSERT_EQ(ParamLogSet(log, key, value), PARAM_LOG_OK);
+            expected[key] = value;
+            Collect(log);
+        }
+
+        ParamLog mounted;
+        ASSERT_TRUE(ParamLogMount(mounted, flash));
+        for (const auto &entry : expected) {
+            uint16_t value = 0;
+            EXPECT_TRUE(ParamLogGet(mounted, entry.first, value));
+            EXPECT_EQ(value, entry.second);
+        }
+        // Страница 0 стирается ещё раз при разметке
+        EXPECT_GT(sim.Erases()[1], 100u);
+        EXPECT_LE(std::max(sim.Erases()[0], sim.Erases()[1]) - std::min(sim.Erases()[0], sim.Erases()[1]), 2u);
+    }
+
+    TEST(ParamLog, TornCommitKeepsPreviousValue) {
+        FlashSim sim;
+        ParamFlash flash = sim.Flash();
+        ParamLog log;
+        ParamLogMount(log, flash);
+        ParamLogSet(log, 2, 100);
+
+        for (int64_t fail = 0; fail < 2; fail++) {
+            sim.FailAfter(fail);
+            EXPECT_THROW(ParamLogSet(log, 2, 200 + fail), FlashSim::PowerLoss);
+
+            ParamLog mounted;
+            ASSERT_TRUE(ParamLogMount(mounted, flash));
+            uint16_t value = 0;
+            EXPECT_TRUE(ParamLogGet(mounted, 2, value));
+            EXPECT_EQ(value, 100);
+            EXPECT_EQ(mounted.Stats.Torn, static_cast<uint32_t>(fail + 1));
+
+            // После сброса журнал продолжается за испорченной записью
+            EXPECT_EQ(ParamLogSet(mounted, 2, 100 + fail), PARAM_LOG_OK);
+            ParamLog again;
+            ParamLogMount(again, flash);
+            EXPECT_TRUE(ParamLogGet(again, 2, value));
+            EXPECT_EQ(value, 100 + fail);
+            log = again;
+            ParamLogSet(log, 2, 100);
+        }
+    }
+
+    // Сброс на каждой записи переноса: после монтирования значения те же, следующий перенос проходит
+    TEST(ParamLog, PowerLossDuringCollect) {
+        for (int64_t fail = 0; ; fail++) {
+            FlashSim sim(256);
+            ParamFlash flash = sim.Flash();
+            ParamLog log;
+            ParamLogMount(log, flash);
+            for (uint16_t i = 0; ParamLogFreeSlots(log) >= PARAM_LOG_COLLECT_SLOTS; i++)
+                ParamLogSet(log, i % PARAM_LOG_KEYS, i);
+            std::vector<uint16_t> expected(log.Value, log.Value + PARAM_LOG_KEYS);
+
+            sim.FailAfter(fail);
+            bool lost = false;
+            try {
+                Collect(log);
+            } catch (const FlashSim::PowerLoss &) {
+                lost = true;
+            }
+
+            ParamLog mounted;
+            ASSERT_TRUE(ParamLogMount(mounted, flash));
+            EXPECT_EQ(std::vector<uint16_t>(mounted.Value, mounted.Value + PARAM_LOG_KEYS), expected) << fail;
+            Collect(mounted);
+            EXPECT_EQ(std::vector<uint16_t>(mounted.Value, mounted.Value + PARAM_LOG_KEYS), expected) << fail;
+            EXPECT_GE(ParamLogFreeSlots(mounted), PARAM_LOG_COLLECT_SLOTS);
+            if (!lost)
+                break;
+        }
+    }
+
+    TEST(ParamLog, ProgramErrorReported) {
+        FlashSim sim;
+        ParamFlash flash = sim.Flash();
+        ParamLog log;
+        ParamLogMount(log, flash);
+
+        sim.WriteProtect(true);
+        EXPECT_EQ(ParamLogSet(log, 1, 5), PARAM_LOG_ERROR);
+        EXPECT_EQ(log.Stats.Errors, 1u);
+        uint16_t value;
+        EXPECT_FALSE(ParamLogGet(log, 1, value));
+    }
+}
@@ -0,0 +1,124 @@
+#include <cstring>
+#include "LFSmart.h"
+#include "LfSimulator.h"
+#include "RegisterMap.hpp"
+#include "gtest/gtest.h"
+
+// Обработчики прошивки из RegisterProtocol.cpp: таблица RegisterMap ссылается на них
+void RegisterReadWhoiam(uint8_t reg, uint8_t *data) { data[0] = reg; data[1] = 0xDA; }
+void RegisterReadAdc(uint8_t reg, uint8_t *data) { data[0] = reg; data[1] = 0xAD; }
+void RegisterReadAdcAll(uint8_t reg, uint8_t *data) { memset(data, reg, 8); }
+bool RegisterWriteSvc(uint8_t reg, uint16_t value) { return reg == REG_SVC && value != 0; }
+
+namespace {
+
+    TEST(RegisterMap, FirmwareMatchesHost) {
+        static_assert(REG_COUNT == lfc::REGISTER_COUNT, "Register count");
+        static_assert(REG_DATA_MAX == lfc::REGISTER_SIZE_MAX, "Largest register");
+        static_assert(REG_ACCESS_READ == lfc::ACCESS_READ && REG_ACCESS_WRITE == lfc::ACCESS_WRITE, "Access bits");
+
+        for (unsigned reg = 0; reg < REG_COUNT; reg++) {
+            const RegisterEntry &entry = RegisterMap[reg];
+            const lfc::RegisterInfo info = lfc::GetRegisterInfo(reg);
+            EXPECT_EQ(entry.Size, info.Size) << info.Name;
+            EXPECT_EQ(entry.Access, info.Access) << info.Name;
+            EXPECT_LE(entry.Size, REG_DATA_MAX) << info.Name;
+            if (entry.Read != nullptr) {
+                EXPECT_TRUE(entry.Access & REG_ACCESS_READ) << info.Name;
+            }
+            if (entry.Write != nullptr) {
+                EXPECT_TRUE(entry.Access & REG_ACCESS_WRITE) << info.Name;
+            }
+        }
+    }
+
+    TEST(RegisterMap, FirmwareDispatch) {
+        uint8_t data[REG_DATA_MAX] = {0};
+        RegisterMap[REG_ADC_CH3].Read(REG_ADC_CH3, data);
+        EXPECT_EQ(data[0], REG_ADC_CH3);
+        EXPECT_EQ(data[1], 0xAD);
+        EXPECT_EQ(RegisterMap[REG_ADC_ALL].Size, 8);
+        EXPECT_EQ(RegisterMap[REG_WHOIAM].Read, &RegisterReadWhoiam);
+        EXPECT_EQ(RegisterMap[REG_SVC].Write, &RegisterWriteSvc);
+        EXPECT_EQ(RegisterMap[REG_SVC].Read, nullptr);
+        EXPECT_EQ(RegisterMap[REG_STATUS].Read, nullptr);
+    }
+
+    TEST(RegisterMap, HostTable) {
+        EXPECT_STREQ(lfc::GetRegisterInfo(lfc::Registers::THRM_PCB).Name, "THRM_PCB");
+        EXPECT_EQ(lfc::GetRegisterInfo(lfc::Registers::CRC_HW).Size, 4);
+        EXPECT_EQ(lfc::GetRegisterInfo(lfc::Registers::ADC_ALL).Size, 8);
+        EXPECT_EQ(lfc::GetRegisterInfo(lfc::Registers::SVC).Access, lfc::ACCESS_WRITE);
+        EXPECT_EQ(lfc::GetRegisterInfo(lfc::Registers::INVALID).Name, nullptr);
+        EXPECT_EQ(lfc::GetRegisterInfo(lfc::Registers::INVALID).Access, lfc::ACCESS_NONE);
+
+        static_assert(std::is_same<lfc::reg::CRC_SW::Type, uint32_t>::value, "CRC_SW is 32 bit");
+        static_assert(std::is_same<lfc::reg::ADC_ALL::Type, std::array<uint16_t, 4>>::value, "ADC_ALL is 4 channels");
+        static_assert(lfc::reg::DAC_MAX_CH2::Address == lfc::Registers::DAC_MAX_CH2, "Typed register address");
+    }
+
+    TEST(RegisterMap, Groups) {
+        const lfc::RegisterGroup groups[] = {lfc::GROUP_DAC, lfc::GROUP_ADC, lfc::GROUP_DAC_DEFAULT, lfc::GROUP_DAC_MAX};
+        for (const auto &group : groups) {
+            for (unsigned i = 0; i < group.Count; i++) {
+                lfc::RegisterInfo info = lfc::GetRegisterInfo(group.First + i);
+                EXPECT_EQ(info.Size, 2);
+                EXPECT_TRUE(info.Access & lfc::ACCESS_READ);
+            }
+            if (group.Block) {
+                EXPECT_EQ(lfc::GetRegisterInfo(group.All).Size, 2 * group.Count);
+            }
+        }
+        EXPECT_TRUE(lfc::GROUP_ADC.Block);
+        EXPECT_FALSE(lfc::GROUP_DAC.Block);
+        EXPECT_EQ(lfc::GROUP_DAC.All, lfc::Registers::DAC_ALL);
+        EXPECT_EQ(lfc::GROUP_DAC_MAX.All, lfc::Registers::INVALID);
+    }
+
+    TEST(RegisterMap, TypedAccessors) {
+        LfSimulator sim;
+        LFSmart lfSmart(sim, true);
+
+        EXPECT_EQ(lfSmart.Read<lfc::reg::WHOIAM>(), LFSmart::WhoiamExpected());
+        EXPECT_EQ(lfSmart.Read<lfc::reg::CRC_HW>(), 0x5A3C96E1u);
+
+        lfSmart.Write<lfc::reg::SVC>(LS_SVC_START);
+        EXPECT_TRUE(lfSmart.Read<lfc::reg::STATUS>() & LF_STATUS_ENABLED);
+        lfSmart.Write<lfc::reg::DAC_MAX_CH3>(5000);
+        EXPECT_EQ(lfSmart.Read<lfc::reg::DAC_MAX_CH3>(), 5000);
+
+        for (int channel = 0; channel < 4; channel++)
+            sim.SetAdc(static_cast<lfc::Channel>(channel), 100 * (channel + 1));
+        std::array<uint16_t, 4> adc = lfSmart.Read<lfc::reg::ADC_ALL>();
+        EXPECT_EQ(adc[0], 100);
+        EXPECT_EQ(adc[3], 400);
+    }
+
+    TEST(RegisterMap, GroupReadIsOneTransfer) {
+        LfSimulator sim;
+        LFSmart lfSmart(sim, true);
+        for (int channel = 0; channel < 4; channel++)
+            lfSmart.WriteDacChannelMaximum(static_cast<lfc::Channel>(channel), 1000 + channel, false);
+
+        uint64_t transfers = sim.Transfers();
+        uint16_t values[4];
+        lfSmart.ReadGroup(lfc::GROUP_DAC_MAX, values);
+        EXPECT_EQ(sim.Transfers() - transfers, 1u);
+        for (int channel = 0; channel < 4; channel++)
+            EXPECT_EQ(values[channel], 1000 + channel);
+    }
+
+    TEST(RegisterMap, GroupReadSkipsShadowed) {
+        LfSimulator sim;
+        LFSmart lfSmart(sim, true);
+        lfSmart.EnableCache(true);
+        lfSmart.ReadDacDefault(lfc::Channel::CHANNEL_2);
+
+        uint64_t transactions = sim.Transactions();
+        uint16_t values[4];
+        lfSmart.ReadGroup(lfc::GROUP_DAC_DEFAULT, values);
+        EXPECT_EQ(sim.Transactions() - transactions, 3u);
+        lfSmart.ReadGroup(lfc::GROUP_DAC_DEFAULT, values);
+        EXPECT_EQ(sim.Transactions() - transactions, 3u);
+    }
+}
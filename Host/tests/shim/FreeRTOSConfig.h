@@ -0,0 +1,27 @@
+/**
+ * @file FreeRTOSConfig.h
+ * @brief Конфигурация FreeRTOS для сборки модулей прошивки в хостовых тестах
+ *
+ * Планировщик не используется, собираются только heap_4 и модули без зависимостей от ядра.
+ */
+
+#ifndef FREERTOS_CONFIG_H
+#define FREERTOS_CONFIG_H
+
+#include <assert.h>
+
+#define configUSE_PREEMPTION            1
+#define configUSE_IDLE_HOOK             0
+#define configUSE_TICK_HOOK             0
+#define configTICK_RATE_HZ              ( ( TickType_t ) 1000 )
+#define configMAX_PRIORITIES            ( 5 )
+#define configMINIMAL_STACK_SIZE        ( ( unsigned short ) 120 )
+#define configTOTAL_HEAP_SIZE           ( ( size_t ) ( 4 * 1024 ) )
+#define configMAX_TASK_NAME_LEN         ( 16 )
+#define configUSE_16_BIT_TICKS          0
+#define configUSE_MUTEXES               1
+#define configUSE_TIMERS                0
+
+#define configASSERT( x )               assert( x )
+
+#endif /* FREERTOS_CONFIG_H */
@@ -0,0 +1,14 @@
+/**
+ * @file MDR32F9Qx_config.h
+ * @brief Замена конфигурации SPL для хостовых тестов: assert_param через assert()
+ */
+
+#ifndef MDR32F9QX_CONFIG_H
+#define MDR32F9QX_CONFIG_H
+
+#include <assert.h>
+#include <stdint.h>
+
+#define assert_param(expr) assert(expr)
+
+#endif // MDR32F9QX_CONFIG_H
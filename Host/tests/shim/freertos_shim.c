@@ -0,0 +1,16 @@
+/**
+ * @file freertos_shim.c
+ * @brief Заглушки ядра FreeRTOS, которые вызывает heap_4 в хостовых тестах
+ */
+
+#include "FreeRTOS.h"
+#include "task.h"
+
+void vTaskSuspendAll( void )
+{
+}
+
+BaseType_t xTaskResumeAll( void )
+{
+    return pdFALSE;
+}
@@ -0,0 +1,84 @@
+#include "ssp_setup.h"
+#include "gtest/gtest.h"
+
+namespace {
+
+    const uint32_t Clock = 80000000;
+
+    TEST(SspSetup, DividerNotAboveMaxHz) {
+        SspSetup setup = {};
+        // SSPIrqTask: SCR = 3, CPSDVSR = 2
+        ASSERT_TRUE(SspSetupEncode(Clock, 10000000, 16, 0, setup));
+        EXPECT_EQ(setup.Cpsr, 2);
+        EXPECT_EQ(setup.Cr0, (3 << SSP_SETUP_CR0_SCR_Pos) | 15);
+        EXPECT_EQ(setup.Hz, 10000000u);
+
+        // Выше SSP_CLK / 2 - наибольшая частота
+        ASSERT_TRUE(SspSetupEncode(Clock, 50000000, 8, 0, setup));
+        EXPECT_EQ(setup.Cpsr, 2);
+        EXPECT_EQ(setup.Cr0 >> SSP_SETUP_CR0_SCR_Pos, 0);
+        EXPECT_EQ(setup.Hz, 40000000u);
+
+        // 80 / 3 не делится: ближайший меньший 80 / 4
+        ASSERT_TRUE(SspSetupEncode(Clock, 26000000, 8, 0, setup));
+        EXPECT_EQ(setup.Hz, 20000000u);
+
+        // Делитель 1000 = 8 * 125: CPSDVSR чётный, SCR до 255
+        ASSERT_TRUE(SspSetupEncode(Clock, 80000, 8, 0, setup));
+        EXPECT_EQ(setup.Hz, 80000u);
+        EXPECT_EQ(setup.Cpsr * ((setup.Cr0 >> SSP_SETUP_CR0_SCR_Pos) + 1), 1000);
+
+        // Делитель 1001 точно не раскладывается: частота ниже заданной
+        for (uint32_t hz : {79921u, 12345u, 1234u}) {
+            ASSERT_TRUE(SspSetupEncode(Clock, hz, 8, 0, setup));
+            EXPECT_LE(setup.Hz, hz);
+            EXPECT_GT(setup.Hz, hz - hz / 100);
+            EXPECT_EQ(setup.Cpsr % 2, 0);
+        }
+    }
+
+    TEST(SspSetup, RejectsOutOfRange) {
+        SspSetup setup = {};
+        EXPECT_FALSE(SspSetupEncode(Clock, 0, 8, 0, setup));
+        EXPECT_FALSE(SspSetupEncode(Clock, Clock / (254 * 256) - 1, 8, 0, setup));
+        EXPECT_TRUE(SspSetupEncode(Clock, Clock / (254 * 256) + 1, 8, 0, setup));
+        EXPECT_FALSE(SspSetupEncode(Clock, 1000000, 3, 0, setup));
+        EXPECT_FALSE(SspSetupEncode(Clock, 1000000, 17, 0, setup));
+        EXPECT_FALSE(SspSetupEncode(Clock, 1000000, 8, 4, setup));
+    }
+
+    TEST(SspSetup, ModeAndWordBits) {
+        SspSetup mode0 = {}, mode3 = {}, wide = {};
+        ASSERT_TRUE(SspSetupEncode(Clock, 1000000, 8, 0, mode0));
+        ASSERT_TRUE(SspSetupEncode(Clock, 1000000, 8, SSP_SETUP_MODE_SPO | SSP_SETUP_MODE_SPH, mode3));
+        ASSERT_TRUE(SspSetupEncode(Clock, 1000000, 16, 0, wide));
+        EXPECT_EQ(mode0.Cr0 & 0xF, 7);
+        EXPECT_EQ(wide.Cr0 & 0xF, 15);
+        EXPECT_EQ(mode3.Cr0 ^ mode0.Cr0, SSP_SETUP_CR0_SPO | SSP_SETUP_CR0_SPH);
+
+        EXPECT_FALSE(SspSetupEqual(mode0, mode3));
+        EXPECT_FALSE(SspSetupEqual(mode0, wide));
+        SspSetup same = {};
+        ASSERT_TRUE(SspSetupEncode(Clock, 1000001, 8, 0, same));     // Другая частота, тот же делитель
+        EXPECT_TRUE(SspSetupEqual(mode0, same));
+    }
+
+    TEST(SspSetup, PumpKeepsReceiveFifoFromOverflow) {
+        EXPECT_EQ(SspSetupPump(0, 0, 3), 3u);
+        EXPECT_EQ(SspSetupPump(0, 0, 20), 8u);
+        EXPECT_EQ(SspSetupPump(8, 0, 20), 0u);          // FIFO приёма может быть заполнен
+        EXPECT_EQ(SspSetupPump(8, 5, 20), 5u);
+        EXPECT_EQ(SspSetupPump(18, 12, 20), 2u);
+        EXPECT_EQ(SspSetupPump(20, 20, 20), 0u);
+
+        // Передано никогда не больше принятого + FIFO
+        uint32_t sent = 0, received = 0;
+        const uint32_t words = 1000;
+        while (received < words) {
+            sent += SspSetupPump(sent, received, words);
+            ASSERT_LE(sent - received, static_cast<uint32_t>(SSP_SETUP_FIFO_DEPTH));
+            received += (sent - received + 1) / 2;      // Прерывание дочитывает часть
+        }
+        EXPECT_EQ(sent, words);
+    }
+}
@@ -0,0 +1,125 @@
+#include "uart_ring.h"
+#include "gtest/gtest.h"
+
+namespace {
+
+    const uint32_t Half = 8;
+    const uint32_t Ring = 2 * Half;
+
+    /*
+     * Половина кольца пинг-понг после count пересылок: контроллер уменьшает n_minus_1,
+     * после последней пересылки пишет STOP
+     */
+    DmaDescriptor Progress(uint32_t count) {
+        DmaDescriptor descriptor;
+        DmaSegmentDescriptor(descriptor, {0x40000000, 0x20000000, Half, 0, DMA_SEGMENT_SOURCE_FIXED},
+                             DMA_CYCLE_PINGPONG, 0);
+        if (count == Half) {
+            descriptor.Control &= ~(DMA_CYCLE_Msk | DMA_N_MINUS_1_Msk);
+            return descriptor;
+        }
+        descriptor.Control = (descriptor.Control & ~DMA_N_MINUS_1_Msk) | ((Half - 1 - count) << DMA_N_MINUS_1_Pos);
+        return descriptor;
+    }
+
+    TEST(UartRing, BaudDivider) {
+        UartDivider divider = {};
+        ASSERT_TRUE(UartBaudDivider(80000000, 921600, divider));
+        EXPECT_EQ(divider.Integer, 5);                  // 80 МГц / (16 * 921600) = 5.425
+        EXPECT_EQ(divider.Fraction, 27);                // 0.425 * 64 = 27.2
+        EXPECT_LT(divider.ErrorPpm, 1000);
+
+        ASSERT_TRUE(UartBaudDivider(80000000, 115200, divider));
+        EXPECT_EQ(divider.Integer, 43);
+        EXPECT_EQ(divider.Fraction, 26);
+
+        ASSERT_TRUE(UartBaudDivider(80000000, 5000000, divider));
+        EXPECT_EQ(divider.Integer, 1);
+        EXPECT_EQ(divider.Fraction, 0);
+        EXPECT_EQ(divider.ErrorPpm, 0);
+
+        EXPECT_FALSE(UartBaudDivider(80000000, 5000001, divider));
+        EXPECT_FALSE(UartBaudDivider(80000000, 0, divider));
+        EXPECT_FALSE(UartBaudDivider(80000000, 50, divider));      // IBRD больше 0xFFFF
+
+        ASSERT_TRUE(UartBaudDivider(80000000, 3500000, divider));   // 1.43: 1 + 27/64, шаг 1/64 у края диапазона
+        EXPECT_EQ(divider.Integer, 1);
+        EXPECT_EQ(divider.Fraction, 27);
+        EXPECT_LT(divider.ErrorPpm, UART_BAUD_ERROR_MAX_PPM);
+    }
+
+    TEST(UartRing, WrittenFollowsPingPong) {
+        // Приём в primary
+        EXPECT_EQ(UartRxWritten(0, Progress(0), Progress(0), Half), 0u);
+        EXPECT_EQ(UartRxWritten(0, Progress(3), Progress(0), Half), 3u);
+        // primary закончена, обратный вызов ещё не перезапустил её, запись идёт в alternate
+        EXPECT_EQ(UartRxWritten(0, Progress(Half), Progress(0), Half), Half);
+        EXPECT_EQ(UartRxWritten(0, Progress(Half), Progress(5), Half), Half + 5);
+        // Перезапуск primary: halves = 1, текущая alternate
+        EXPECT_EQ(UartRxWritten(1, Progress(0), Progress(5), Half), Half + 5);
+        // Обе половины закончены до обратного вызова: канал остановлен, кольцо заполнено
+        EXPECT_EQ(UartRxWritten(1, Progress(Half), Progress(Half), Half), 3 * Half);
+        // Счётчик половин не сворачивается по размеру кольца
+        EXPECT_EQ(UartRxWritten(6, Progress(2), Progress(0), Half), 6 * Half + 2);
+    }
+
+    TEST(UartRing, FrameEndsOnIdle) {
+        UartRxFramer framer = {};
+        const uint32_t idle = 2;
+
+        EXPECT_TRUE(UartRxPoll(framer, 5, Ring));
+        EXPECT_EQ(UartRxFrame(framer, idle, Ring), 0u);             // Байты ещё идут
+        EXPECT_TRUE(UartRxPoll(framer, 5, Ring));
+        EXPECT_EQ(UartRxFrame(framer, idle, Ring), 0u);
+        EXPECT_TRUE(UartRxPoll(framer, 5, Ring));
+        EXPECT_EQ(UartRxFrame(framer, idle, Ring), 5u);             // Пауза в два опроса
+        framer.Read += 5;
+        EXPECT_EQ(UartRxFrame(framer, idle, Ring), 0u);
+
+        // Пауза без новых байт кадров не даёт
+        for (uint32_t i = 0; i < 10; i++)
+            EXPECT_TRUE(UartRxPoll(framer, 5, Ring));
+        EXPECT_EQ(UartRxFrame(framer, idle, Ring), 0u);
+
+        // Новый байт сбрасывает паузу
+        EXPECT_TRUE(UartRxPoll(framer, 6, Ring));
+        EXPECT_EQ(UartRxFrame(framer, idle, Ring), 0u);
+    }
+
+    TEST(UartRing, StreamSplitsIntoMaxFrames) {
+        UartRxFramer framer = {};
+        const uint32_t maxFrame = 4;
+        EXPECT_TRUE(UartRxPoll(framer, 10, Ring));
+        EXPECT_EQ(UartRxFrame(framer, 2, maxFrame), maxFrame);
+        framer.Read += maxFrame;
+        EXPECT_EQ(UartRxFrame(framer, 2, maxFrame), maxFrame);
+        framer.Read += maxFrame;
+        EXPECT_EQ(UartRxFrame(framer, 2, maxFrame), 0u);            // Остаток ждёт паузы
+        EXPECT_TRUE(UartRxPoll(framer, 10, Ring));
+        EXPECT_TRUE(UartRxPoll(framer, 10, Ring));
+        EXPECT_EQ(UartRxFrame(framer, 2, maxFrame), 2u);
+    }
+
+    TEST(UartRing, OverrunDropsUnread) {
+        UartRxFramer framer = {};
+        EXPECT_TRUE(UartRxPoll(framer, Ring, Ring));                // Ровно кольцо - ещё не переполнение
+        EXPECT_FALSE(UartRxPoll(framer, Ring + 3, Ring));
+        EXPECT_EQ(framer.Overruns, 1u);
+        EXPECT_EQ(framer.Read, Ring + 3);
+        EXPECT_EQ(UartRxFrame(framer, 0, Ring), 0u);
+
+        // Переход счётчиков через 2^32
+        framer = {0xFFFFFFF8u, 0xFFFFFFF8u, 0, 0};
+        EXPECT_TRUE(UartRxPoll(framer, 0x00000004u, Ring));
+        EXPECT_EQ(UartRxFrame(framer, 0, Ring), 12u);
+    }
+
+    TEST(UartRing, TxSpanStopsAtWrap) {
+        EXPECT_EQ(UartTxSpan(0, 0, 16, 64), 0u);
+        EXPECT_EQ(UartTxSpan(10, 2, 16, 64), 8u);
+        EXPECT_EQ(UartTxSpan(20, 12, 16, 64), 4u);                  // 12..15, затем 0..3
+        EXPECT_EQ(UartTxSpan(20, 16, 16, 64), 4u);
+        EXPECT_EQ(UartTxSpan(40, 32, 16, 3), 3u);
+        EXPECT_EQ(UartTxSpan(0x00000004u, 0xFFFFFFFCu, 16, 64), 4u);
+    }
+}
@@ -15,6 +15,8 @@
   * Аргументы командной строки:
   *  - -l --list: вывести список подключенных преобразователей USB-SPI FT4222
   *  - -d --device: номер преобразователя USB-SPI, по-умолчанию 0
+  *  - -s --socket: сокет lfsd, по-умолчанию $LFSD_SOCKET, $XDG_RUNTIME_DIR/lfsd.sock или /tmp/lfsd.sock.
+  *    Без lfsd - напрямую через FT4222
   *  - -t --tries: Количество попыток чтения, по-умолчанию 1
   */
 
@@ -36,7 +38,8 @@ static cxxopts::ParseResult parse(int argc, char *argv[]) {
         ("h,help", "Print help")
         ("l,list", "List FTDI devices", cxxopts::value<bool>()->default_value("false"))
         ("t,tries", "Read tries, default 1", cxxopts::value<int>()->default_value("1"))
-        ("d,device", "FTDI device number, default 0", cxxopts::value<int>()->default_value("0"));
+        ("d,device", "FTDI device number, default 0", cxxopts::value<int>()->default_value("0"))
+        ("s,socket", "lfsd socket, empty - direct FTDI access", cxxopts::value<std::string>()->default_value(DaemonSocket()));
 
         auto result = options.parse(argc, argv);
         if (result.count("help")) {
@@ -63,8 +66,8 @@ int main(int argc, char* argv[]) {
     int devnum = opts["device"].as<int>();
     try {
         fmt::print("Using FTDI device number {}\n", devnum);
-        FtdiSpi spi(devnum);
-        LFSmart lfSmart(spi, true, tries);
+        auto spi = OpenSpi(devnum, opts["socket"].as<std::string>());
+        LFSmart lfSmart(*spi, true, tries);
         uint16_t who_i_am = lfSmart.Whoiam();
         fmt::print("Who I am register: 0x{:04X}\n", who_i_am);
 
@@ -0,0 +1,122 @@
+/**
+ * @file adc_pipeline.h
+ * @brief Разбор результатов АЦП по каналам и согласованный снимок всех каналов
+ *
+ * DMA складывает слова ADCx_RESULT целиком: значение в битах 0..11, номер входа АЦП в битах 16..20. В режиме
+ * переключения каналов порядок входов известен, но фаза после запуска - нет, поэтому отсчёты раскладываются
+ * по номеру входа из самого слова. За период обработки отсчёты каждого канала усредняются, результат публикуется
+ * снимком всех каналов сразу.
+ *
+ * Снимков два: писатель заполняет неактивный и увеличивает Sequence, номер актуального снимка - Sequence & 1.
+ * Читатель копирует актуальный снимок и повторяет чтение, если за время копирования Sequence изменился. Читать
+ * можно и из прерывания, если оно не вытесняется писателем, иначе возможны повторы, но не разорванный снимок.
+ *
+ * Модуль не зависит от периферии и собирается в хостовых тестах.
+ */
+
+#ifndef MILANDRBASE_ADC_PIPELINE_H
+#define MILANDRBASE_ADC_PIPELINE_H
+
+#include <stdint.h>
+#include <string.h>
+
+
+#define ADC_PIPELINE_CHANNELS           (4)             ///< Каналы ADC_CH1..ADC_CH4
+#define ADC_PIPELINE_INPUTS             (32)            ///< Номера входов АЦП 0..31, включая VREF и датчик температуры
+#define ADC_PIPELINE_UNMAPPED           (0xFF)          ///< Вход не относится ни к одному каналу
+
+#define ADC_PIPELINE_VALUE_Msk          (0x0FFFUL)      ///< ADC_RESULT_Msk
+#define ADC_PIPELINE_INPUT_Pos          (16)            ///< ADC_RESULT_CHANNEL_Pos
+#define ADC_PIPELINE_INPUT_Msk          (0x1FUL << ADC_PIPELINE_INPUT_Pos)
+
+#define ADC_PIPELINE_BARRIER()          __asm volatile ("" ::: "memory")
+
+
+/**
+ * @brief Снимок всех каналов
+ */
+struct AdcSnapshot {
+    uint16_t Value[ADC_PIPELINE_CHANNELS];  ///< Среднее за период, 12 бит. Порядок как в регистре ADC_ALL
+};
+
+/**
+ * @brief Состояние разбора
+ */
+struct AdcPipeline {
+    uint8_t             InputMap[ADC_PIPELINE_INPUTS];  ///< Номер канала для входа АЦП или ADC_PIPELINE_UNMAPPED
+    uint32_t            Sum[ADC_PIPELINE_CHANNELS];     ///< Сумма отсчётов за текущий период
+    uint16_t            Count[ADC_PIPELINE_CHANNELS];   ///< Количество отсчётов за текущий период
+    uint16_t            Last[ADC_PIPELINE_CHANNELS];    ///< Последнее опубликованное значение
+    AdcSnapshot         Snapshot[2];                    ///< Снимки, актуальный Snapshot[Sequence & 1]
+    volatile uint32_t   Sequence;                       ///< Количество публикаций
+    uint32_t            Unmapped;                       ///< Отсчёты с входов без канала
+};
+
+
+static inline void AdcPipelineInit(AdcPipeline &p) {
+    memset(&p, 0, sizeof(p));
+    memset(p.InputMap, ADC_PIPELINE_UNMAPPED, sizeof(p.InputMap));
+}
+
+/**
+ * @brief Привязка входа АЦП к каналу
+ * @param p Состояние
+ * @param input Номер входа АЦП, ADC_CH_ADC0..ADC_CH_TEMP_SENSOR
+ * @param channel Канал 0..ADC_PIPELINE_CHANNELS - 1
+ */
+static inline void AdcPipelineMap(AdcPipeline &p, uint8_t input, uint8_t channel) {
+    p.InputMap[input % ADC_PIPELINE_INPUTS] = channel;
+}
+
+/**
+ * @brief Накопление блока слов ADCx_RESULT
+ */
+static inline void AdcPipelineFeed(AdcPipeline &p, const uint32_t *results, uint32_t count) {
+    for (uint32_t i = 0; i < count; i++) {
+        uint32_t word = results[i];
+        uint8_t channel = p.InputMap[(word & ADC_PIPELINE_INPUT_Msk) >> ADC_PIPELINE_INPUT_Pos];
+        if (channel >= ADC_PIPELINE_CHANNELS) {
+            p.Unmapped++;
+            continue;
+        }
+        p.Sum[channel] += word & ADC_PIPELINE_VALUE_Msk;
+        p.Count[channel]++;
+    }
+}
+
+/**
+ * @brief Публикация средних за период и начало нового периода
+ *
+ * Канал без отсчётов за период сохраняет прошлое значение. Вызывается одним писателем.
+ */
+static inline void AdcPipelinePublish(AdcPipeline &p) {
+    AdcSnapshot &next = p.Snapshot[(p.Sequence + 1) & 1];
+    for (uint32_t ch = 0; ch < ADC_PIPELINE_CHANNELS; ch++) {
+        if (p.Count[ch] != 0)
+            p.Last[ch] = (p.Sum[ch] + p.Count[ch] / 2) / p.Count[ch];
+        next.Value[ch] = p.Last[ch];
+        p.Sum[ch] = 0;
+        p.Count[ch] = 0;
+    }
+    ADC_PIPELINE_BARRIER();
+    p.Sequence = p.Sequence + 1;
+}
+
+/**
+ * @brief Копия актуального снимка
+ * @param p Состояние
+ * @param snapshot Снимок всех каналов
+ * @return Номер публикации снимка, 0 - данных ещё нет
+ */
+static inline uint32_t AdcPipelineRead(const AdcPipeline &p, AdcSnapshot &snapshot) {
+    for (;;) {
+        uint32_t sequence = p.Sequence;
+        ADC_PIPELINE_BARRIER();
+        snapshot = p.Snapshot[sequence & 1];
+        ADC_PIPELINE_BARRIER();
+        if (p.Sequence == sequence)
+            return sequence;
+    }
+}
+
+#endif //MILANDRBASE_ADC_PIPELINE_H
@@ -0,0 +1,226 @@
+/**
+ * @file adcacq.cpp
+ * @brief Непрерывное измерение каналов ADC_CH1..ADC_CH4 на ADC1 и ADC2 с передачей по DMA
+ */
+
+#include <MDR32F9Qx_config.h>
+#include <MDR32F9Qx_rst_clk.h>
+#include <MDR32F9Qx_port.h>
+#include <MDR32F9Qx_adc.h>
+#include <MDR32F9Qx_dma.h>
+#include <dmamgr.h>
+#include <FreeRTOS.h>
+#include <task.h>
+#include "adcacq.h"
+
+#include "log_levels.h"
+#define LOG_LOCAL_LEVEL LOG_TAG_ADC_LOCAL_LEVEL
+#include <mdr_log.h>
+static const char *TAG = "ADC";
+
+static_assert(DMA_AlternateData == 1, "ADC DMA ping-pong requires alternate control data");
+static_assert(CONFIG_ADC_DMA_HALF <= 1024, "ADC DMA half must fit one DMA cycle");
+static_assert(CONFIG_ADC_CH1_INPUT < 8 && CONFIG_ADC_CH2_INPUT < 8 && CONFIG_ADC_CH3_INPUT < 8 &&
+              CONFIG_ADC_CH4_INPUT < 8, "ADC inputs must be PD0..PD7");
+
+#define DMA_CYCLE_CTRL_Msk  (0x07UL)
+
+
+/**
+ * @brief Поток одного АЦП
+ */
+struct AdcStream {
+    uint8_t     DmaChannel;                             ///< DMA_Channel_ADC1 или DMA_Channel_ADC2
+    uint8_t     NextHalf;                               ///< Половина, которая заполнится следующей: 0 - primary
+    uint32_t    DmaControl;                             ///< Управляющее слово DMA для перезапуска половины
+    uint32_t    Block[2][CONFIG_ADC_DMA_HALF];          ///< Слова ADCx_RESULT, две половины ping-pong
+};
+
+static AdcStream s_xStreams[2];
+static AdcPipeline s_xPipeline;
+static AdcAcqStats s_xStats;
+
+
+static void InitStream(AdcStream &stream, uint8_t dmaChannel, volatile uint32_t *result) {
+    stream.DmaChannel = dmaChannel;
+    stream.NextHalf = 0;
+
+    DMA_CtrlDataInitTypeDef primary;
+    primary.DMA_SourceBaseAddr = DmaMgrBusAddress(result);
+    primary.DMA_DestBaseAddr = DmaMgrBusAddress(stream.Block[0]);
+    primary.DMA_SourceIncSize = DMA_SourceIncNo;
+    primary.DMA_DestIncSize = DMA_DestIncWord;
+    primary.DMA_MemoryDataSize = DMA_MemoryDataSize_Word;
+    primary.DMA_Mode = DMA_Mode_PingPong;
+    primary.DMA_CycleSize = CONFIG_ADC_DMA_HALF;
+    primary.DMA_NumContinuous = DMA_Transfers_1;
+    primary.DMA_SourceProtCtrl = DMA_SourcePrivileged;
+    primary.DMA_DestProtCtrl = DMA_DestPrivileged;
+
+    DMA_CtrlDataInitTypeDef alternate = primary;
+    alternate.DMA_DestBaseAddr = DmaMgrBusAddress(stream.Block[1]);
+
+    DMA_ChannelInitTypeDef channel;
+    DMA_StructInit(&channel);
+    channel.DMA_PriCtrlData = &primary;
+    channel.DMA_AltCtrlData = &alternate;
+    channel.DMA_Priority = DMA_Priority_Default;
+    channel.DMA_UseBurst = DMA_BurstClear;
+    channel.DMA_SelectDataStructure = DMA_CTRL_DATA_PRIMARY;
+    DMA_Init(dmaChannel, &channel);
+    stream.DmaControl = DmaMgrPrimary(dmaChannel)->DMA_Control;
+}
+
+
+/*
+ * Разбор заполненных половин в порядке заполнения и их перезапуск. Если DMA успел заполнить обе половины,
+ * канал остановлен: после перезапуска обеих он включается заново с половины NextHalf.
+ */
+static void ProcessStream(AdcStream &stream) {
+    uint32_t mask = 1UL << stream.DmaChannel;
+    bool stopped = (MDR_DMA->CHNL_ENABLE_SET & mask) == 0;
+
+    for (uint32_t i = 0; i < 2; i++) {
+        DMA_CtrlDataTypeDef *half = stream.NextHalf ? DmaMgrAlternate(stream.DmaChannel)
+                                                    : DmaMgrPrimary(stream.DmaChannel);
+        if ((half->DMA_Control & DMA_CYCLE_CTRL_Msk) != DMA_Mode_Stop)
+            break;
+        AdcPipelineFeed(s_xPipeline, stream.Block[stream.NextHalf], CONFIG_ADC_DMA_HALF);
+        half->DMA_Control = stream.DmaControl;
+        stream.NextHalf ^= 1;
+        s_xStats.Blocks++;
+    }
+
+    if (stopped) {
+        s_xStats.Overruns++;
+        if (stream.NextHalf)
+            MDR_DMA->CHNL_PRI_ALT_SET = mask;
+        else
+            MDR_DMA->CHNL_PRI_ALT_CLR = mask;
+        MDR_DMA->CHNL_ENABLE_SET = mask;
+    }
+}
+
+
+static bool InitHW() {
+    if (!DmaMgrClaim(DMA_Channel_ADC1, "AdcAcq"))
+        return false;
+    if (!DmaMgrClaim(DMA_Channel_ADC2, "AdcAcq")) {
+        DmaMgrRelease(DMA_Channel_ADC1);
+        return false;
+    }
+    RST_CLK_PCLKcmd(RST_CLK_PCLK_RST_CLK | RST_CLK_PCLK_PORTD | RST_CLK_PCLK_ADC, ENABLE);
+
+PORT_InitTypeDef PORT_InitStructure;
+    PORT_StructInit(&PORT_InitStructure);
+    // Входы ADC0..ADC7 - PD0..PD7, аналоговый режим
+    PORT_InitStructure.PORT_Pin = (1UL << CONFIG_ADC_CH1_INPUT) | (1UL << CONFIG_ADC_CH2_INPUT) |
+                                  (1UL << CONFIG_ADC_CH3_INPUT) | (1UL << CONFIG_ADC_CH4_INPUT);
+    PORT_InitStructure.PORT_OE = PORT_OE_IN;
+    PORT_InitStructure.PORT_MODE = PORT_MODE_ANALOG;
+    PORT_Init(MDR_PORTD, &PORT_InitStructure);
+
+ADC_InitTypeDef ADC_InitStructure;
+    ADC_DeInit();
+    ADC_StructInit(&ADC_InitStructure);
+    ADC_Init(&ADC_InitStructure);
+
+    // Непрерывное преобразование с перебором входов CHSEL, каждое слово RESULT несёт номер входа
+ADCx_InitTypeDef ADCx_InitStructure;
+    ADCx_StructInit(&ADCx_InitStructure);
+    ADCx_InitStructure.ADC_ClockSource = ADC_CLOCK_SOURCE_CPU;
+    ADCx_InitStructure.ADC_SamplingMode = ADC_SAMPLING_MODE_CYCLIC_CONV;
+    ADCx_InitStructure.ADC_ChannelSwitching = ADC_CH_SWITCHING_Enable;
+    ADCx_InitStructure.ADC_VRefSource = ADC_VREF_SOURCE_INTERNAL;
+    ADCx_InitStructure.ADC_IntVRefSource = ADC_INT_VREF_SOURCE_INEXACT;
+    ADCx_InitStructure.ADC_Prescaler = CONFIG_ADC_PRESCALER;
+    ADCx_InitStructure.ADC_DelayGo = 7;
+
+    ADCx_InitStructure.ADC_ChannelNumber = static_cast<ADCx_Channel_Number>(CONFIG_ADC_CH1_INPUT);
+    ADCx_InitStructure.ADC_Channels = (1UL << CONFIG_ADC_CH1_INPUT) | (1UL << CONFIG_ADC_CH2_INPUT);
+    ADC1_Init(&ADCx_InitStructure);
+
+    ADCx_InitStructure.ADC_ChannelNumber = static_cast<ADCx_Channel_Number>(CONFIG_ADC_CH3_INPUT);
+    ADCx_InitStructure.ADC_Channels = (1UL << CONFIG_ADC_CH3_INPUT) | (1UL << CONFIG_ADC_CH4_INPUT);
+    ADC2_Init(&ADCx_InitStructure);
+
+    InitStream(s_xStreams[0], DMA_Channel_ADC1, &MDR_ADC->ADC1_RESULT);
+    InitStream(s_xStreams[1], DMA_Channel_ADC2, &MDR_ADC->ADC2_RESULT);
+
+    ADC1_Cmd(ENABLE);
+    ADC2_Cmd(ENABLE);
+    return true;
+}
+
+
+static void Execute(void *pvParameters) {
+    (void)pvParameters;
+    MDR_LOGI(TAG, "Start!");
+    if (!InitHW())
+        vTaskDelete(nullptr);
+
+    uint32_t overruns = 0;
+    TickType_t wake = xTaskGetTickCount();
+    for (;;) {
+        vTaskDelayUntil(&wake, pdMS_TO_TICKS(CONFIG_ADC_PERIOD_MS));
+
+        uint32_t blocks = s_xStats.Blocks;
+        ProcessStream(s_xStreams[0]);
+        ProcessStream(s_xStreams[1]);
+        if (s_xStats.Blocks != blocks)
+            AdcPipelinePublish(s_xPipeline);
+
+        if (s_xStats.Overruns != overruns) {
+            overruns = s_xStats.Overruns;
+            MDR_LOGW(TAG, "DMA overrun %lu, increase CONFIG_ADC_DMA_HALF or CONFIG_ADC_PRESCALER", overruns);
+        }
+    }
+}
+
+
+/**
+ * @brief Настройка ADC1, ADC2, DMA и запуск задачи обработки
+ *
+ * ADC1 преобразует входы CONFIG_ADC_CH1_INPUT и CONFIG_ADC_CH2_INPUT, ADC2 - CONFIG_ADC_CH3_INPUT
+ * и CONFIG_ADC_CH4_INPUT. Каналы DMA_Channel_ADC1 и DMA_Channel_ADC2 занимаются у DmaMgrClaim(), остальные каналы
+ * DMA не затрагиваются.
+ */
+void AdcAcqStart() {
+    AdcPipelineInit(s_xPipeline);
+    AdcPipelineMap(s_xPipeline, CONFIG_ADC_CH1_INPUT, 0);
+    AdcPipelineMap(s_xPipeline, CONFIG_ADC_CH2_INPUT, 1);
+    AdcPipelineMap(s_xPipeline, CONFIG_ADC_CH3_INPUT, 2);
+    AdcPipelineMap(s_xPipeline, CONFIG_ADC_CH4_INPUT, 3);
+
+    xTaskCreate(Execute, "AdcAcq", configMINIMAL_STACK_SIZE * 2, nullptr, tskIDLE_PRIORITY + 1, nullptr);
+}
+
+
+/**
+ * @brief Последний снимок всех каналов. Можно вызывать из прерываний
+ * @param snapshot Значения ADC_CH1..ADC_CH4
+ * @return Номер публикации, 0 - измерений ещё нет
+ */
+uint32_t AdcAcqRead(AdcSnapshot &snapshot) {
+    return AdcPipelineRead(s_xPipeline, snapshot);
+}
+
+
+/**
+ * @brief Значение одного канала из последнего снимка
+ * @param channel Канал 0..3
+ */
+uint16_t AdcAcqReadChannel(uint8_t channel) {
+    assert_param(channel < ADC_PIPELINE_CHANNELS);
+    AdcSnapshot snapshot;
+    AdcPipelineRead(s_xPipeline, snapshot);
+    return snapshot.Value[channel];
+}
+
+
+void AdcAcqGetStats(AdcAcqStats &stats) {
+    stats.Blocks = s_xStats.Blocks;
+    stats.Overruns = s_xStats.Overruns;
+    stats.Unmapped = s_xPipeline.Unmapped;
+    stats.Sequence = s_xPipeline.Sequence;
+}
@@ -0,0 +1,37 @@
+/**
+ * @file adcacq.h
+ * @brief Непрерывное измерение каналов ADC_CH1..ADC_CH4 на ADC1 и ADC2 с передачей по DMA
+ *
+ * ADC1 и ADC2 циклически преобразуют по два входа в режиме переключения каналов. Слова ADCx_RESULT складываются
+ * DMA в буфер ping-pong, на каждый отсчёт прерывания нет. Задача AdcAcq раз в CONFIG_ADC_PERIOD_MS забирает
+ * заполненные половины, перезапускает их и публикует согласованный снимок всех каналов, см. adc_pipeline.h.
+ *
+ * Половина буфера должна заполняться дольше периода задачи, иначе DMA останавливается и отсчёты теряются
+ * (счётчик Overruns в AdcAcqGetStats()).
+ */
+
+#ifndef MILANDRBASE_ADCACQ_H
+#define MILANDRBASE_ADCACQ_H
+
+#include <stdint.h>
+#include "adc_pipeline.h"
+#include "app_config.h"
+
+
+/**
+ * @brief Счётчики работы
+ */
+struct AdcAcqStats {
+    uint32_t Blocks;                ///< Обработано половин буфера
+    uint32_t Overruns;              ///< DMA останавливался: обе половины заполнены до обработки
+    uint32_t Unmapped;              ///< Отсчёты с входов, не привязанных к каналам
+    uint32_t Sequence;              ///< Количество публикаций снимка
+};
+
+
+void AdcAcqStart();
+uint32_t AdcAcqRead(AdcSnapshot &snapshot);
+uint16_t AdcAcqReadChannel(uint8_t channel);
+void AdcAcqGetStats(AdcAcqStats &stats);
+
+#endif //MILANDRBASE_ADCACQ_H
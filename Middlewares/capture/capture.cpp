@@ -0,0 +1,384 @@
+/**
+ * @file capture.cpp
+ * @brief Захват фронтов таймером с передачей значений по DMA
+ */
+
+#include <MDR32F9Qx_config.h>
+#include <MDR32F9Qx_rst_clk.h>
+#include <MDR32F9Qx_dma.h>
+#include <dmamgr.h>
+#include "capture.h"
+
+static_assert(DMA_AlternateData == 1, "Capture DMA ping-pong requires alternate control data");
+static_assert(CONFIG_CAPTURE_RING_SIZE % 2 == 0 && CONFIG_CAPTURE_RING_SIZE / 2 <= 1024,
+              "Capture ring half must fit one DMA cycle");
+static_assert((CONFIG_CAPTURE_MARKERS & (CONFIG_CAPTURE_MARKERS - 1)) == 0, "Marker queue size must be power of 2");
+
+#define RING_HALF           (CONFIG_CAPTURE_RING_SIZE / 2)
+#define DMA_CYCLE_CTRL_Msk  (0x07UL)
+#define DMA_N_MINUS_1_Pos   (4)
+#define DMA_N_MINUS_1_Msk   (0x3FFUL << DMA_N_MINUS_1_Pos)
+
+
+static inline volatile uint32_t &ChannelControl(MDR_TIMER_TypeDef *timer, uint32_t channel) {
+    return (&timer->CH1_CNTRL)[channel];
+}
+
+static inline volatile uint32_t &ChannelControl2(MDR_TIMER_TypeDef *timer, uint32_t channel) {
+    return (&timer->CH1_CNTRL2)[channel];
+}
+
+static inline uint16_t ChannelCCR(MDR_TIMER_TypeDef *timer, uint32_t channel) {
+    return (&timer->CCR1)[channel];
+}
+
+static inline uint16_t ChannelCCR1(MDR_TIMER_TypeDef *timer, uint32_t channel) {
+    return (&timer->CCR11)[channel];
+}
+
+/**
+ * @brief Инициализация таймера для захвата
+ *
+ * Таймер тактируется от HCLK, частота счёта HCLK / (prescaler + 1), период счёта arr + 1 тиков.
+ *
+ * @param cap Движок захвата
+ * @param timer MDR_TIMER1..MDR_TIMER3
+ * @param prescaler Значение PSG
+ * @param arr Значение ARR. Чем меньше, тем чаще прерывание и тем меньше допустимая задержка чтения CaptureRead()
+ * @return false, если канал DMA таймера занят другим модулем. Таймер не настраивается
+ */
+bool CaptureInit(CaptureEngine &cap, MDR_TIMER_TypeDef *timer, uint16_t prescaler, uint16_t arr) {
+    assert_param(timer == MDR_TIMER1 || timer == MDR_TIMER2 || timer == MDR_TIMER3);
+
+    cap.Timer = timer;
+    if (timer == MDR_TIMER1) {
+        RST_CLK_PCLKcmd(RST_CLK_PCLK_TIMER1, ENABLE);
+        cap.TimerIrqNumber = Timer1_IRQn;
+        cap.DmaChannel = DMA_Channel_TIM1;
+    } else if (timer == MDR_TIMER2) {
+        RST_CLK_PCLKcmd(RST_CLK_PCLK_TIMER2, ENABLE);
+        cap.TimerIrqNumber = Timer2_IRQn;
+        cap.DmaChannel = DMA_Channel_TIM2;
+    } else {
+        RST_CLK_PCLKcmd(RST_CLK_PCLK_TIMER3, ENABLE);
+        cap.TimerIrqNumber = Timer3_IRQn;
+        cap.DmaChannel = DMA_Channel_TIM3;
+    }
+    if (!DmaMgrClaim(cap.DmaChannel, "Capture"))
+        return false;
+
+    TIMER_DeInit(timer);
+    TIMER_BRGInit(timer, TIMER_HCLKdiv1);
+    timer->CNT = 0;
+    timer->PSG = prescaler;
+    timer->ARR = arr;
+    cap.Modulus = static_cast<uint32_t>(arr) + 1;
+    cap.TickHz = SystemCoreClock / (static_cast<uint32_t>(prescaler) + 1);
+    return true;
+}
+
+
+/**
+ * @brief Настройка канала таймера на захват
+ * @param cap Движок захвата
+ * @param channel Канал таймера
+ * @param edge Фронт захвата в CCR
+ * @param edge1 Фронт захвата в CCR1 или CAPTURE_EDGE_NONE
+ * @param filter CHFLTR[3:0]: 0 - без фильтра, 1..15 - сигнал должен быть стабилен N тактов, см. описание TIMER
+ */
+void CaptureChannelInit(CaptureEngine &cap, TIMER_Channel_Number_TypeDef channel, CaptureEdge edge,
+                        CaptureEdge edge1, uint8_t filter) {
+    assert_param(edge != CAPTURE_EDGE_NONE);
+    assert_param(filter <= 0x0F);
+
+    uint32_t chsel = (edge == CAPTURE_EDGE_RISING) ? TIMER_CH_EvSrc_PE : TIMER_CH_EvSrc_NE;
+    ChannelControl(cap.Timer, channel) = TIMER_CH_CNTRL_CAP_NPWM | chsel | (filter << TIMER_CH_CNTRL_CHFLTR_Pos);
+
+    if (edge1 == CAPTURE_EDGE_NONE) {
+        ChannelControl2(cap.Timer, channel) = 0;
+    } else {
+        uint32_t chsel1 = (edge1 == CAPTURE_EDGE_RISING) ? TIMER_CH_CCR1EvSrc_PE : TIMER_CH_CCR1EvSrc_NE;
+        ChannelControl2(cap.Timer, channel) = TIMER_CH_CNTRL2_CCR1_EN | chsel1;
+    }
+}
+
+
+/**
+ * @brief Запуск счёта и передачи значений канала потока по DMA
+ *
+ * Перед вызовом каналы должны быть настроены CaptureChannelInit(). Канал DMA таймера занимается в CaptureInit(),
+ * остальные каналы DMA не затрагиваются.
+ *
+ * @param cap Движок захвата
+ * @param streamChannel Канал, значения CCR которого передаются в кольцевой буфер
+ */
+void CaptureStart(CaptureEngine &cap, TIMER_Channel_Number_TypeDef streamChannel) {
+    cap.StreamChannel = streamChannel;
+    cap.HalvesDone = 0;
+    cap.Overflows = 0;
+    cap.LastIndex = 0;
+    cap.LastCnt = 0;
+    cap.MarkerHead = 0;
+    cap.MarkerTail = 0;
+    cap.ReadIndex = 0;
+    cap.DmaOverruns = 0;
+    cap.MarkerOverruns = 0;
+    cap.Lost = 0;
+    CaptureTimelineInit(cap.Timeline, cap.Modulus);
+
+    DMA_CtrlDataInitTypeDef primary;
+    primary.DMA_SourceBaseAddr = DmaMgrBusAddress(&(&cap.Timer->CCR1)[streamChannel]);
+    primary.DMA_DestBaseAddr = DmaMgrBusAddress(&cap.Ring[0]);
+    primary.DMA_SourceIncSize = DMA_SourceIncNo;
+    primary.DMA_DestIncSize = DMA_DestIncHalfword;
+    primary.DMA_MemoryDataSize = DMA_MemoryDataSize_HalfWord;
+    primary.DMA_Mode = DMA_Mode_PingPong;
+    primary.DMA_CycleSize = RING_HALF;
+    primary.DMA_NumContinuous = DMA_Transfers_1;
+    primary.DMA_SourceProtCtrl = DMA_SourcePrivileged;
+    primary.DMA_DestProtCtrl = DMA_DestPrivileged;
+
+    DMA_CtrlDataInitTypeDef alternate = primary;
+    alternate.DMA_DestBaseAddr = DmaMgrBusAddress(&cap.Ring[RING_HALF]);
+
+    DMA_ChannelInitTypeDef channel;
+    DMA_StructInit(&channel);
+    channel.DMA_PriCtrlData = &primary;
+    channel.DMA_AltCtrlData = &alternate;
+    channel.DMA_Priority = DMA_Priority_High;
+    channel.DMA_UseBurst = DMA_BurstClear;
+    channel.DMA_SelectDataStructure = DMA_CTRL_DATA_PRIMARY;
+    DMA_Init(cap.DmaChannel, &channel);
+    cap.DmaControl = DmaMgrPrimary(cap.DmaChannel)->DMA_Control;
+
+    cap.Timer->CNT = 0;
+    cap.Timer->STATUS = 0;
+    cap.Timer->DMA_RE = 1UL << (TIMER_DMA_RE_CCR_CAP_EVENT_RE_Pos + streamChannel);
+    cap.Timer->IE = TIMER_IE_CNT_ARR_EVENT_IE;
+
+    NVIC_SetPriority(cap.TimerIrqNumber, NVIC_EncodePriority(NVIC_GetPriorityGrouping(),
+                                                             CAPTURE_TIMER_IRQ_PREEMPTIVE_PRIORITY,
+                                                             CAPTURE_TIMER_IRQ_SUBPRIORITY));
+    NVIC_EnableIRQ(cap.TimerIrqNumber);
+    cap.Timer->CNTRL = TIMER_CNTRL_CNT_EN;
+}
+
+
+void CaptureStop(CaptureEngine &cap) {
+    cap.Timer->CNTRL = 0;
+    cap.Timer->IE = 0;
+    cap.Timer->DMA_RE = 0;
+    NVIC_DisableIRQ(cap.TimerIrqNumber);
+    DMA_Cmd(cap.DmaChannel, DISABLE);
+}
+
+
+/*
+ * Перезапуск отработавшей половины и количество отсчётов, записанных DMA. Вызывается из прерывания таймера.
+ */
+static uint32_t DmaWriteIndex(CaptureEngine &cap) {
+    uint32_t mask = 1UL << cap.DmaChannel;
+    DMA_CtrlDataTypeDef *primary = DmaMgrPrimary(cap.DmaChannel);
+    DMA_CtrlDataTypeDef *alternate = DmaMgrAlternate(cap.DmaChannel);
+
+    if ((MDR_DMA->CHNL_ENABLE_SET & mask) == 0) {
+        // Обе половины заполнены раньше, чем пришло прерывание. Отсчёты между остановкой и перезапуском потеряны
+        cap.DmaOverruns++;
+        cap.HalvesDone = (cap.HalvesDone + 3) & ~1UL;      // Следующая чётная половина - primary
+        primary->DMA_Control = cap.DmaControl;
+        alternate->DMA_Control = cap.DmaControl;
+        MDR_DMA->CHNL_PRI_ALT_CLR = mask;
+        MDR_DMA->CHNL_ENABLE_SET = mask;
+        return cap.HalvesDone * RING_HALF;
+    }
+
+    bool alt;
+    uint32_t control;
+    do {
+        alt = (MDR_DMA->CHNL_PRI_ALT_SET & mask) != 0;
+        control = alt ? alternate->DMA_Control : primary->DMA_Control;
+    } while (alt != ((MDR_DMA->CHNL_PRI_ALT_SET & mask) != 0));
+
+    DMA_CtrlDataTypeDef *idle = alt ? primary : alternate;
+    if ((idle->DMA_Control & DMA_CYCLE_CTRL_Msk) == DMA_Mode_Stop) {
+        idle->DMA_Control = cap.DmaControl;
+        cap.HalvesDone++;
+    }
+
+    uint32_t remaining = 0;
+    if ((control & DMA_CYCLE_CTRL_Msk) != DMA_Mode_Stop)
+        remaining = ((control & DMA_N_MINUS_1_Msk) >> DMA_N_MINUS_1_Pos) + 1;
+    return cap.HalvesDone * RING_HALF + (RING_HALF - remaining);
+}
+
+
+/**
+ * @brief Обработчик прерывания переполнения, вызывается из TimerX_IRQHandler
+ *
+ * CNT читается раньше позиции DMA, см. capture_timeline.h.
+ */
+void CaptureTimerIRQHandler(CaptureEngine &cap) {
+    if ((cap.Timer->STATUS & TIMER_STATUS_CNT_ARR_EVENT) == 0)
+        return;
+    cap.Timer->STATUS = ~TIMER_STATUS_CNT_ARR_EVENT;
+
+    uint16_t cnt = cap.Timer->CNT;
+    uint32_t index = DmaWriteIndex(cap);
+    cap.Overflows++;
+
+    if (index != cap.LastIndex) {
+        if (cap.MarkerHead - cap.MarkerTail < CONFIG_CAPTURE_MARKERS) {
+            CaptureMarker &m = cap.Markers[cap.MarkerHead & (CONFIG_CAPTURE_MARKERS - 1)];
+            m.Index = index;
+            m.Overflows = cap.Overflows;
+            m.Cnt = cnt;
+            m.PrevCnt = cap.LastCnt;
+            cap.MarkerHead++;
+        } else {
+            cap.MarkerOverruns++;
+        }
+        cap.LastIndex = index;
+    }
+    cap.LastCnt = cnt;
+}
+
+
+/**
+ * @brief Чтение меток времени фронтов канала потока
+ *
+ * Возвращаются только отсчёты, за которыми уже записан маркер переполнения, то есть с задержкой до одного периода
+ * счёта. Вызывать чаще, чем заполняется половина кольцевого буфера и очередь маркеров.
+ *
+ * @param cap Движок захвата
+ * @param timestamps Буфер меток времени в тиках таймера, может быть nullptr
+ * @param max Размер буфера
+ * @return Количество прочитанных меток
+ */
+uint32_t CaptureRead(CaptureEngine &cap, uint64_t *timestamps, uint32_t max) {
+    uint32_t count = 0;
+    while (count < max && cap.MarkerTail != cap.MarkerHead) {
+        const CaptureMarker &next = cap.Markers[cap.MarkerTail & (CONFIG_CAPTURE_MARKERS - 1)];
+        if (cap.ReadIndex >= next.Index) {
+            cap.MarkerTail++;
+            continue;
+        }
+
+        // Новейший маркер - нижняя граница позиции DMA. Отсчёты старше кольцевого буфера уже перезаписаны
+        const CaptureMarker &newest = cap.Markers[(cap.MarkerHead - 1) & (CONFIG_CAPTURE_MARKERS - 1)];
+        if (newest.Index - cap.ReadIndex > CONFIG_CAPTURE_RING_SIZE) {
+            // Пропуск всегда в начале вызова, чтобы метки одного вызова шли без разрыва
+            if (count != 0)
+                break;
+            uint32_t skip = newest.Index - CONFIG_CAPTURE_RING_SIZE;
+            cap.Lost += skip - cap.ReadIndex;
+            cap.ReadIndex = skip;
+            cap.Timeline.HasLast = false;
+            cap.Timeline.SegmentEnd = 0;
+            continue;
+        }
+
+        uint16_t value = cap.Ring[cap.ReadIndex % CONFIG_CAPTURE_RING_SIZE];
+        uint64_t ts = CaptureTimelineExtend(cap.Timeline, value, next);
+        if (timestamps)
+            timestamps[count] = ts;
+        count++;
+        cap.ReadIndex++;
+    }
+    return count;
+}
+
+
+/**
+ * @brief Период и частота по накопленным фронтам канала потока
+ *
+ * Читает все доступные фронты. Средний период считается от последнего фронта прошлого измерения, поэтому
+ * разрешение растёт с частотой сигнала. После потери отсчётов измерение начинается с первого фронта после пропуска.
+ *
+ * @param cap Движок захвата
+ * @param m Результат
+ * @return false, если новых фронтов нет или период посчитать не из чего
+ */
+bool CaptureMeasure(CaptureEngine &cap, CaptureMeasurement &m) {
+    bool had_last = cap.Timeline.HasLast;
+    uint64_t first = cap.Timeline.Last;
+    uint64_t prev = first;
+    uint64_t ts[16];
+    uint32_t edges = 0;
+
+    m.LastPeriod = 0;
+    for (;;) {
+        uint32_t lost = cap.Lost;
+        uint32_t n = CaptureRead(cap, ts, sizeof(ts) / sizeof(ts[0]));
+        if (cap.Lost != lost) {
+            had_last = false;
+            edges = 0;
+            m.LastPeriod = 0;
+        }
+        for (uint32_t i = 0; i < n; i++) {
+            if (edges > 0 || had_last)
+                m.LastPeriod = ts[i] - prev;
+            if (edges == 0 && !had_last)
+                first = ts[i];
+            prev = ts[i];
+            edges++;
+        }
+        if (n < sizeof(ts) / sizeof(ts[0]))
+            break;
+    }
+
+    m.Edges = edges;
+    m.LastTimestamp = prev;
+    uint32_t periods = had_last ? edges : (edges ? edges - 1 : 0);
+    if (periods == 0) {
+        m.AveragePeriod = 0;
+        m.Frequency = 0;
+        return false;
+    }
+    m.AveragePeriod = static_cast<float>(prev - first) / periods;
+    m.Frequency = cap.TickHz / m.AveragePeriod;
+    return true;
+}
+
+
+/**
+ * @brief Длительность импульса между фронтами CCR и CCR1 канала
+ *
+ * Канал должен быть настроен с edge1 != CAPTURE_EDGE_NONE. Длительность импульса и время с последнего фронта
+ * должны быть меньше периода счёта.
+ *
+ * @param cap Движок захвата
+ * @param channel Канал таймера
+ * @param ticks Длительность, тики
+ * @return false, если импульс ещё не закончился: последний захват CCR позже CCR1
+ */
+bool CaptureGetPulseWidth(CaptureEngine &cap, TIMER_Channel_Number_TypeDef channel, uint32_t &ticks) {
+    __disable_irq();
+    uint32_t cnt = cap.Timer->CNT;
+    uint32_t start = ChannelCCR(cap.Timer, channel);
+    uint32_t stop = ChannelCCR1(cap.Timer, channel);
+    __enable_irq();
+
+    uint32_t start_age = (cnt + cap.Modulus - start) % cap.Modulus;
+    uint32_t stop_age = (cnt + cap.Modulus - stop) % cap.Modulus;
+    if (stop_age >= start_age)
+        return false;
+    ticks = start_age - stop_age;
+    return true;
+}
+
+
+/**
+ * @brief Опрос захвата на канале без прерываний
+ * @param cap Движок захвата
+ * @param channel Канал таймера
+ * @param ccr Значение CCR последнего захвата
+ * @return true, если с прошлого опроса был захват. Флаг события сбрасывается
+ */
+bool CaptureChannelPoll(CaptureEngine &cap, TIMER_Channel_Number_TypeDef channel, uint16_t &ccr) {
+    uint32_t flag = 1UL << (TIMER_STATUS_CCR_CAP_EVENT_Pos + channel);
+    if ((cap.Timer->STATUS & flag) == 0)
+        return false;
+    cap.Timer->STATUS = ~flag;
+    ccr = ChannelCCR(cap.Timer, channel);
+    return true;
+}
@@ -0,0 +1,91 @@
+/**
+ * @file capture.h
+ * @brief Захват фронтов таймером с передачей значений по DMA
+ *
+ * Значения CCR одного канала таймера (канал потока) складываются DMA в кольцевой буфер в режиме ping-pong,
+ * прерывания на каждый фронт нет. Прерывание таймера возникает только при переполнении CNT: перезапускает
+ * отработавшую половину буфера DMA и пишет маркер для расширения меток времени до 64 бит, см. capture_timeline.h.
+ *
+ * Остальные каналы таймера можно настроить на захват с фильтром и опрашивать CaptureChannelPoll() без прерываний.
+ * Канал потока CaptureChannelPoll() не опрашивается. Для любого канала CCR1 может захватывать противоположный фронт,
+ * тогда доступна длительность импульса CaptureGetPulseWidth().
+ */
+
+#ifndef MILANDRBASE_CAPTURE_H
+#define MILANDRBASE_CAPTURE_H
+
+#include <MDR32F9Qx_timer.h>
+#include "capture_timeline.h"
+#include "app_config.h"
+
+
+/**
+ * @brief Фронт захвата
+ */
+enum CaptureEdge {
+    CAPTURE_EDGE_RISING,                ///< Положительный фронт
+    CAPTURE_EDGE_FALLING,               ///< Отрицательный фронт
+    CAPTURE_EDGE_NONE                   ///< Захват CCR1 выключен
+};
+
+
+/**
+ * @brief Движок захвата на одном таймере
+ */
+struct CaptureEngine {
+    MDR_TIMER_TypeDef  *Timer;                                  ///< Таймер MDR_TIMER1..MDR_TIMER3
+    IRQn_Type           TimerIrqNumber;                         ///< Номер прерывания таймера
+    uint8_t             DmaChannel;                             ///< Канал DMA таймера, DMA_Channel_TIM1..3
+    uint8_t             StreamChannel;                          ///< Канал таймера, значения CCR которого идут в DMA
+    uint32_t            Modulus;                                ///< Период счёта, ARR + 1
+    uint32_t            TickHz;                                 ///< Частота счёта таймера, Гц
+    uint32_t            DmaControl;                             ///< Управляющее слово DMA для перезапуска половины
+
+    uint16_t            Ring[CONFIG_CAPTURE_RING_SIZE];         ///< Кольцевой буфер DMA, две половины ping-pong
+    volatile uint32_t   HalvesDone;                             ///< Количество заполненных половин буфера
+    volatile uint32_t   Overflows;                              ///< Количество переполнений таймера
+    uint32_t            LastIndex;                              ///< Index последнего записанного маркера
+    uint16_t            LastCnt;                                ///< CNT в прошлом прерывании переполнения
+
+    CaptureMarker       Markers[CONFIG_CAPTURE_MARKERS];        ///< Очередь маркеров, пишет прерывание
+    volatile uint32_t   MarkerHead;                             ///< Запись маркеров, прерывание
+    volatile uint32_t   MarkerTail;                             ///< Чтение маркеров, задача
+
+    uint32_t            ReadIndex;                              ///< Номер следующего читаемого отсчёта
+    CaptureTimeline     Timeline;                               ///< Состояние расширения меток времени
+
+    volatile uint32_t   DmaOverruns;                            ///< DMA остановился: обе половины заполнены
+    volatile uint32_t   MarkerOverruns;                         ///< Очередь маркеров переполнена
+    uint32_t            Lost;                                   ///< Отсчётов перезаписано до чтения
+};
+
+
+/**
+ * @brief Результат измерения по потоку фронтов
+ */
+struct CaptureMeasurement {
+    uint32_t Edges;                     ///< Количество фронтов, обработанных за это измерение
+    uint64_t LastTimestamp;             ///< Метка времени последнего фронта, тики
+    uint32_t LastPeriod;                ///< Последний период, тики
+    float    AveragePeriod;             ///< Средний период по фронтам измерения, тики
+    float    Frequency;                 ///< Частота по среднему периоду, Гц
+};
+
+
+#define CAPTURE_TIMER_IRQ_PREEMPTIVE_PRIORITY   (5)     ///< Ниже Timer1 ведомого I2C (4): его вход в прерывание критичен
+#define CAPTURE_TIMER_IRQ_SUBPRIORITY           (0)
+
+bool CaptureInit(CaptureEngine &cap, MDR_TIMER_TypeDef *timer, uint16_t prescaler, uint16_t arr);
+void CaptureChannelInit(CaptureEngine &cap, TIMER_Channel_Number_TypeDef channel, CaptureEdge edge,
+                        CaptureEdge edge1, uint8_t filter);
+void CaptureStart(CaptureEngine &cap, TIMER_Channel_Number_TypeDef streamChannel);
+void CaptureStop(CaptureEngine &cap);
+
+uint32_t CaptureRead(CaptureEngine &cap, uint64_t *timestamps, uint32_t max);
+bool CaptureMeasure(CaptureEngine &cap, CaptureMeasurement &m);
+bool CaptureGetPulseWidth(CaptureEngine &cap, TIMER_Channel_Number_TypeDef channel, uint32_t &ticks);
+bool CaptureChannelPoll(CaptureEngine &cap, TIMER_Channel_Number_TypeDef channel, uint16_t &ccr);
+
+void CaptureTimerIRQHandler(CaptureEngine &cap);
+
+#endif //MILANDRBASE_CAPTURE_H
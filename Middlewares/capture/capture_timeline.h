@@ -0,0 +1,88 @@
+/**
+ * @file capture_timeline.h
+ * @brief Расширение 16-битных значений захвата таймера до 64-битных меток времени
+ *
+ * DMA складывает значения CCR в кольцевой буфер, а прерывание переполнения таймера (CNT == ARR) записывает маркер:
+ * значение CNT в прерывании, затем сколько отсчётов DMA успел записать к этому моменту. Именно в таком порядке:
+ * отсчёт, записанный после чтения позиции DMA, захвачен позже чтения CNT. Отсчёты между двумя маркерами образуют
+ * сегмент, все они записаны после предыдущего переполнения. Отсчёт, захваченный уже после следующего переполнения,
+ * но до его прерывания, распознаётся по уменьшению значения внутри сегмента или, если он первый в сегменте,
+ * по значению не больше CNT предыдущего прерывания.
+ *
+ * Ограничения: прерывание переполнения не должно задерживаться больше чем на период таймера. Первый в сегменте
+ * отсчёт со значением в (PrevCnt, Cnt] относится к предыдущему периоду - это окно джиттера задержки прерывания.
+ *
+ * Модуль не зависит от периферии и собирается в хостовых тестах.
+ */
+
+#ifndef MILANDRBASE_CAPTURE_TIMELINE_H
+#define MILANDRBASE_CAPTURE_TIMELINE_H
+
+#include <stdint.h>
+
+
+/**
+ * @brief Маркер переполнения таймера
+ *
+ * Пишется в прерывании, только если с прошлого маркера DMA записал новые отсчёты.
+ */
+struct CaptureMarker {
+    uint32_t Index;             ///< Количество отсчётов, записанных DMA к моменту прерывания
+    uint32_t Overflows;         ///< Номер переполнения, начиная с 1
+    uint16_t Cnt;               ///< CNT в прерывании этого переполнения
+    uint16_t PrevCnt;           ///< CNT в прерывании предыдущего переполнения
+};
+
+/**
+ * @brief Состояние расширения меток времени
+ */
+struct CaptureTimeline {
+    uint32_t Modulus;           ///< Период счёта таймера, ARR + 1
+    uint32_t SegmentEnd;        ///< Index маркера, завершающего текущий сегмент
+    bool     SegmentEmpty;      ///< В текущем сегменте ещё не было отсчётов
+    bool     Wrapped;           ///< В текущем сегменте уже встретился отсчёт после переполнения
+    bool     HasLast;           ///< Last содержит метку
+    uint64_t Last;              ///< Метка времени предыдущего отсчёта, тики таймера
+};
+
+
+static inline void CaptureTimelineInit(CaptureTimeline &tl, uint32_t modulus) {
+    tl.Modulus = modulus;
+    tl.SegmentEnd = 0;
+    tl.SegmentEmpty = true;
+    tl.Wrapped = false;
+    tl.HasLast = false;
+    tl.Last = 0;
+}
+
+/**
+ * @brief Метка времени отсчёта
+ * @param tl Состояние
+ * @param value Значение CCR
+ * @param next Первый маркер, у которого Index больше номера отсчёта
+ * @return Время захвата в тиках таймера от его запуска
+ */
+static inline uint64_t CaptureTimelineExtend(CaptureTimeline &tl, uint16_t value, const CaptureMarker &next) {
+    if (next.Index != tl.SegmentEnd) {
+        tl.SegmentEnd = next.Index;
+        tl.SegmentEmpty = true;
+        tl.Wrapped = false;
+    }
+
+    uint64_t base = next.Overflows - 1;
+    if (!tl.Wrapped) {
+        uint64_t t = base * tl.Modulus + value;
+        if (tl.HasLast && t <= tl.Last)
+            tl.Wrapped = true;
+        else if (tl.SegmentEmpty && value <= next.PrevCnt)
+            tl.Wrapped = true;
+    }
+
+    uint64_t timestamp = (base + (tl.Wrapped ? 1 : 0)) * tl.Modulus + value;
+    tl.SegmentEmpty = false;
+    tl.HasLast = true;
+    tl.Last = timestamp;
+    return timestamp;
+}
+
+#endif //MILANDRBASE_CAPTURE_TIMELINE_H
@@ -0,0 +1,225 @@
+/**
+ * @file cycleprof.cpp
+ * @brief Профилировщик участков кода по счётчику тактов DWT->CYCCNT
+ */
+
+#include <cstdio>
+#include <cstring>
+#include <MDR32F9Qx_config.h>
+#include <FreeRTOS.h>
+#include <timers.h>
+#include <SEGGER_RTT.h>
+#include "cycleprof.h"
+
+#if (CONFIG_CYCLEPROF_ENABLE == 1)
+
+#include "log_levels.h"
+#define LOG_LOCAL_LEVEL LOG_TAG_CYCLEPROF_LOCAL_LEVEL
+#include <mdr_log.h>
+static const char *TAG = "CYC";
+
+#if (CONFIG_CYCLEPROF_RTT_CHANNEL > 0) && (CONFIG_CYCLEPROF_RTT_CHANNEL >= SEGGER_RTT_MAX_NUM_UP_BUFFERS)
+#error "CONFIG_CYCLEPROF_RTT_CHANNEL requires SEGGER_RTT_MAX_NUM_UP_BUFFERS > CONFIG_CYCLEPROF_RTT_CHANNEL"
+#endif
+
+
+#define CYCLEPROF_LINE_SIZE     (48 + CONFIG_CYCLEPROF_BUCKETS * 6)
+
+
+struct CycleProfSite {
+    const char *Name;               ///< Имя из макроса, строка во flash
+    uint32_t    Count;
+    uint32_t    Min;
+    uint32_t    Max;
+    uint64_t    Sum;
+    uint16_t    Histogram[CONFIG_CYCLEPROF_BUCKETS];
+};
+
+static CycleProfSite s_xSites[CONFIG_CYCLEPROF_MAX_SITES];
+static uint8_t s_uSiteCount = 0;
+static uint16_t s_uDropped = 0;
+static uint32_t s_uOverhead = 0;
+
+#if (CONFIG_CYCLEPROF_RTT_CHANNEL > 0)
+static char s_cRttBuffer[CONFIG_CYCLEPROF_RTT_BUFFER_SIZE];
+#endif
+
+
+static void ClearSite(CycleProfSite &site) {
+    site.Count = 0;
+    site.Min = UINT32_MAX;
+    site.Max = 0;
+    site.Sum = 0;
+    memset(site.Histogram, 0, sizeof(site.Histogram));
+}
+
+
+/**
+ * @brief Учёт замера участка. Можно вызывать из прерываний, вызывается макросами CYCLEPROF_*
+ * @param site Номер участка в таблице, CYCLEPROF_SITE_NONE до первого замера
+ * @param name Имя участка, запоминается указатель
+ * @param cycles Разность CYCCNT, из неё вычитаются такты пары чтений
+ */
+void CycleProfRecord(uint8_t &site, const char *name, uint32_t cycles) {
+    cycles = cycles > s_uOverhead ? cycles - s_uOverhead : 0;
+    uint32_t bucket = cycles == 0 ? 0 : 32 - __builtin_clz(cycles);
+    if (bucket >= CONFIG_CYCLEPROF_BUCKETS)
+        bucket = CONFIG_CYCLEPROF_BUCKETS - 1;
+
+    uint32_t primask = __get_PRIMASK();
+    __disable_irq();
+    if (site == CYCLEPROF_SITE_NONE) {
+        if (s_uSiteCount >= CONFIG_CYCLEPROF_MAX_SITES) {
+            if (s_uDropped != UINT16_MAX)
+                s_uDropped++;
+            __set_PRIMASK(primask);
+            return;
+        }
+        site = s_uSiteCount++;
+        s_xSites[site].Name = name;
+        ClearSite(s_xSites[site]);
+    }
+
+    CycleProfSite &entry = s_xSites[site];
+    entry.Count++;
+    entry.Sum += cycles;
+    if (cycles < entry.Min)
+        entry.Min = cycles;
+    if (cycles > entry.Max)
+        entry.Max = cycles;
+    if (entry.Histogram[bucket] != UINT16_MAX)
+        entry.Histogram[bucket]++;
+    __set_PRIMASK(primask);
+}
+
+
+/**
+ * @brief Обнуление статистики всех участков. Участки остаются зарегистрированными
+ */
+void CycleProfReset() {
+    uint32_t primask = __get_PRIMASK();
+    __disable_irq();
+    for (uint8_t i = 0; i < s_uSiteCount; i++)
+        ClearSite(s_xSites[i]);
+    s_uDropped = 0;
+    __set_PRIMASK(primask);
+}
+
+
+static bool CopySite(uint8_t index, CycleProfSite &copy) {
+    uint32_t primask = __get_PRIMASK();
+    __disable_irq();
+    bool valid = index < s_uSiteCount;
+    if (valid)
+        copy = s_xSites[index];
+    __set_PRIMASK(primask);
+    return valid;
+}
+
+
+/**
+ * @brief Вывод статистики участков строками @CYC в лог или в канал RTT CONFIG_CYCLEPROF_RTT_CHANNEL
+ */
+void CycleProfDump() {
+    static char line[CYCLEPROF_LINE_SIZE];
+    CycleProfSite site;
+    for (uint8_t i = 0; CopySite(i, site); i++) {
+        if (site.Count == 0)
+            continue;
+        int length = snprintf(line, sizeof(line), "@CYC,%s,%lu,%lu,%lu,%lu,", site.Name, site.Count, site.Min,
+                              static_cast<uint32_t>(site.Sum / site.Count), site.Max);
+        for (uint32_t b = 0; b < CONFIG_CYCLEPROF_BUCKETS && length < static_cast<int>(sizeof(line)); b++)
+            length += snprintf(line + length, sizeof(line) - length, b == 0 ? "%u" : ";%u", site.Histogram[b]);
+#if (CONFIG_CYCLEPROF_RTT_CHANNEL > 0)
+        SEGGER_RTT_WriteString(CONFIG_CYCLEPROF_RTT_CHANNEL, line);
+        SEGGER_RTT_WriteString(CONFIG_CYCLEPROF_RTT_CHANNEL, "\n");
+#else
+        MDR_LOGI(TAG, "%s", line);
+#endif
+    }
+    if (s_uDropped != 0)
+        MDR_LOGW(TAG, "%u samples dropped, increase CONFIG_CYCLEPROF_MAX_SITES", s_uDropped);
+}
+
+
+/**
+ * @brief Чтение записи профилировщика. Можно вызывать из прерываний
+ * @param index 0 - заголовок CycleProfHeader, далее по CYCLEPROF_SITE_RECORDS записей на участок:
+ *              CycleProfName, CycleProfRange, CycleProfMean, CycleProfBuckets
+ * @param record Буфер на CYCLEPROF_RECORD_SIZE байт
+ * @return false, если записи с таким номером нет. Буфер заполняется нулями
+ */
+bool CycleProfReadRecord(uint8_t index, uint8_t *record) {
+    memset(record, 0, CYCLEPROF_RECORD_SIZE);
+    if (index == 0) {
+        CycleProfHeader header;
+        header.Magic = CYCLEPROF_RECORD_MAGIC;
+        header.SiteCount = s_uSiteCount;
+        header.SiteRecords = CYCLEPROF_SITE_RECORDS;
+        header.Buckets = CONFIG_CYCLEPROF_BUCKETS;
+        header.Overhead = s_uOverhead > UINT8_MAX ? UINT8_MAX : s_uOverhead;
+        header.Dropped = s_uDropped;
+        memcpy(record, &header, sizeof(header));
+        return true;
+    }
+
+    CycleProfSite site;
+    if (!CopySite((index - 1) / CYCLEPROF_SITE_RECORDS, site))
+        return false;
+
+    uint32_t part = (index - 1) % CYCLEPROF_SITE_RECORDS;
+    if (part == 0) {
+        CycleProfName name;
+        strncpy(name.Name, site.Name, sizeof(name.Name));
+        name.Count = site.Count;
+        memcpy(record, &name, sizeof(name));
+    } else if (part == 1) {
+        CycleProfRange range = {site.Count != 0 ? site.Min : 0, site.Max};
+        memcpy(record, &range, sizeof(range));
+    } else if (part == 2) {
+        CycleProfMean mean = {site.Count != 0 ? static_cast<uint32_t>(site.Sum / site.Count) : 0,
+                              static_cast<uint32_t>(site.Sum >> 32)};
+        memcpy(record, &mean, sizeof(mean));
+    } else {
+        CycleProfBuckets buckets = {};
+        for (uint32_t i = 0, b = (part - 3) * 4; i < 4 && b < CONFIG_CYCLEPROF_BUCKETS; i++, b++)
+            buckets.Count[i] = site.Histogram[b];
+        memcpy(record, &buckets, sizeof(buckets));
+    }
+    return true;
+}
+
+
+static void TimerCallback(TimerHandle_t xTimer) {
+    (void)xTimer;
+    CycleProfDump();
+}
+
+/**
+ * @brief Включение CYCCNT, измерение тактов пары чтений и запуск периодического вывода, период CONFIG_CYCLEPROF_PERIOD_MS
+ *
+ * Замеры до вызова учитываются без вычета тактов чтения.
+ */
+void CycleProfStart() {
+    CoreDebug->DEMCR |= CoreDebug_DEMCR_TRCENA_Msk;
+    DWT->CTRL |= DWT_CTRL_CYCCNTENA_Msk;
+
+    uint32_t primask = __get_PRIMASK();
+    __disable_irq();
+    uint32_t start = DWT->CYCCNT;
+    uint32_t end = DWT->CYCCNT;
+    s_uOverhead = end - start;
+    __set_PRIMASK(primask);
+
+#if (CONFIG_CYCLEPROF_RTT_CHANNEL > 0)
+    SEGGER_RTT_ConfigUpBuffer(CONFIG_CYCLEPROF_RTT_CHANNEL, "CycleProf", s_cRttBuffer, sizeof(s_cRttBuffer),
+                              SEGGER_RTT_MODE_NO_BLOCK_SKIP);
+#endif
+
+    TimerHandle_t timer = xTimerCreate("CycleProf", pdMS_TO_TICKS(CONFIG_CYCLEPROF_PERIOD_MS), pdTRUE, nullptr,
+                                       TimerCallback);
+    assert_param(timer != nullptr);
+    xTimerStart(timer, 0);
+}
+
+#endif
@@ -0,0 +1,134 @@
+/**
+ * @file cycleprof.h
+ * @brief Профилировщик участков кода по счётчику тактов DWT->CYCCNT
+ *
+ * Участок (место замера) отмечается в коде макросами:
+ *   CYCLEPROF_SCOPE(name);                        - от объявления до конца блока
+ *   CYCLEPROF_BEGIN(name); ... CYCLEPROF_END(name); - между макросами в одном блоке, в том числе в прерываниях
+ * Имя участка - идентификатор C, одинаковые имена в разных функциях - разные участки. Участок регистрируется в
+ * статической таблице при первом замере, на участок считаются количество, минимум, максимум, среднее и гистограмма
+ * по степеням 2: корзина b - длительность [2^(b-1), 2^b) тактов, последняя корзина - всё, что длиннее.
+ * Из замера вычитаются такты пары чтений CYCCNT.
+ *
+ * Программный таймер периодически выводит таблицу в лог (или в канал RTT CONFIG_CYCLEPROF_RTT_CHANNEL) строками:
+ *   @CYC,<участок>,<количество>,<минимум>,<среднее>,<максимум>,<корзина 0>;<корзина 1>;...
+ * Те же данные доступны записями по 8 байт через CycleProfReadRecord(), см. IICSlaveTask.
+ *
+ * При CONFIG_CYCLEPROF_ENABLE == 0 макросы пустые, замеры не компилируются.
+ */
+
+#ifndef MILANDRBASE_CYCLEPROF_H
+#define MILANDRBASE_CYCLEPROF_H
+
+#include <stdint.h>
+#include <MDR32Fx.h>
+#include "app_config.h"
+
+
+#define CYCLEPROF_RECORD_SIZE       (8)             ///< Размер записи CycleProfReadRecord()
+#define CYCLEPROF_RECORD_MAGIC      (0x5043)        ///< "CP" в заголовке, запись 0
+#define CYCLEPROF_SITE_NONE         (0xFF)          ///< Участок ещё не зарегистрирован
+#define CYCLEPROF_SITE_RECORDS      (3 + (CONFIG_CYCLEPROF_BUCKETS + 3) / 4)    ///< Записей на участок
+
+/**
+ * @brief Запись 0 - заголовок
+ */
+struct CycleProfHeader {
+    uint16_t Magic;                 ///< CYCLEPROF_RECORD_MAGIC
+    uint8_t  SiteCount;             ///< Количество участков
+    uint8_t  SiteRecords;           ///< Записей на участок, CYCLEPROF_SITE_RECORDS
+    uint8_t  Buckets;               ///< Корзин гистограммы, CONFIG_CYCLEPROF_BUCKETS
+    uint8_t  Overhead;              ///< Вычитаемые такты пары чтений CYCCNT
+    uint16_t Dropped;               ///< Замеров участков, не поместившихся в таблицу, с насыщением
+} __attribute__((packed));
+
+/**
+ * @brief Запись 1 + участок * SiteRecords - имя и количество замеров
+ */
+struct CycleProfName {
+    char     Name[4];               ///< Первые 4 символа имени участка, без завершающего нуля
+    uint32_t Count;                 ///< Количество замеров
+} __attribute__((packed));
+
+/**
+ * @brief Запись 2 + участок * SiteRecords - минимум и максимум, тактов
+ */
+struct CycleProfRange {
+    uint32_t Min;
+    uint32_t Max;
+} __attribute__((packed));
+
+/**
+ * @brief Запись 3 + участок * SiteRecords - среднее, тактов, и сумма старших разрядов
+ */
+struct CycleProfMean {
+    uint32_t Mean;
+    uint32_t SumHigh;               ///< Старшие 32 разряда суммы тактов, переполнение суммы видно по изменению
+} __attribute__((packed));
+
+/**
+ * @brief Записи 4.. + участок * SiteRecords - гистограмма, по 4 корзины в записи
+ */
+struct CycleProfBuckets {
+    uint16_t Count[4];              ///< Количество замеров в корзине, с насыщением
+} __attribute__((packed));
+
+static_assert(sizeof(CycleProfHeader) == CYCLEPROF_RECORD_SIZE, "CycleProfHeader size");
+static_assert(sizeof(CycleProfName) == CYCLEPROF_RECORD_SIZE, "CycleProfName size");
+static_assert(sizeof(CycleProfRange) == CYCLEPROF_RECORD_SIZE, "CycleProfRange size");
+static_assert(sizeof(CycleProfMean) == CYCLEPROF_RECORD_SIZE, "CycleProfMean size");
+static_assert(sizeof(CycleProfBuckets) == CYCLEPROF_RECORD_SIZE, "CycleProfBuckets size");
+
+
+#if (CONFIG_CYCLEPROF_ENABLE == 1)
+
+static_assert(CONFIG_CYCLEPROF_MAX_SITES < CYCLEPROF_SITE_NONE, "CONFIG_CYCLEPROF_MAX_SITES too large");
+static_assert(CONFIG_CYCLEPROF_BUCKETS >= 2 && CONFIG_CYCLEPROF_BUCKETS <= 33, "CONFIG_CYCLEPROF_BUCKETS out of range");
+
+void CycleProfRecord(uint8_t &site, const char *name, uint32_t cycles);
+void CycleProfStart();
+void CycleProfDump();
+void CycleProfReset();
+bool CycleProfReadRecord(uint8_t index, uint8_t *record);
+
+/**
+ * @brief Замер от конструктора до деструктора, см. CYCLEPROF_SCOPE
+ */
+class CycleProfScope {
+public:
+    CycleProfScope(uint8_t &site, const char *name) : m_site(site), m_name(name), m_start(DWT->CYCCNT) {}
+    ~CycleProfScope() { CycleProfRecord(m_site, m_name, DWT->CYCCNT - m_start); }
+
+    CycleProfScope(const CycleProfScope &) = delete;
+    CycleProfScope &operator=(const CycleProfScope &) = delete;
+
+private:
+    uint8_t &m_site;
+    const char *m_name;
+    uint32_t m_start;
+};
+
+#define CYCLEPROF_SCOPE(name)                                                       \
+    static uint8_t cycleprof_site_##name = CYCLEPROF_SITE_NONE;                     \
+    CycleProfScope cycleprof_scope_##name(cycleprof_site_##name, #name)
+
+#define CYCLEPROF_BEGIN(name)                                                       \
+    static uint8_t cycleprof_site_##name = CYCLEPROF_SITE_NONE;                     \
+    uint32_t cycleprof_start_##name = DWT->CYCCNT
+
+#define CYCLEPROF_END(name)                                                         \
+    CycleProfRecord(cycleprof_site_##name, #name, DWT->CYCCNT - cycleprof_start_##name)
+
+#else
+
+#define CYCLEPROF_SCOPE(name)
+#define CYCLEPROF_BEGIN(name)
+#define CYCLEPROF_END(name)
+static inline void CycleProfStart() {}
+static inline void CycleProfDump() {}
+static inline void CycleProfReset() {}
+static inline bool CycleProfReadRecord(uint8_t, uint8_t *) { return false; }
+
+#endif
+
+#endif //MILANDRBASE_CYCLEPROF_H
@@ -0,0 +1,244 @@
+/**
+ * @file dds.cpp
+ * @brief Генератор синуса на DAC1 и DAC2 с передачей отсчётов по DMA от таймера
+ */
+
+#include <MDR32F9Qx_config.h>
+#include <MDR32F9Qx_rst_clk.h>
+#include <MDR32F9Qx_port.h>
+#include <MDR32F9Qx_dac.h>
+#include <MDR32F9Qx_timer.h>
+#include <MDR32F9Qx_dma.h>
+#include <dmamgr.h>
+#include <events.h>
+#include <FreeRTOS.h>
+#include <task.h>
+#include "dds.h"
+
+#if (CONFIG_DDS_ENABLE == 1)
+
+#include "log_levels.h"
+#define LOG_LOCAL_LEVEL LOG_TAG_DDS_LOCAL_LEVEL
+#include <mdr_log.h>
+static const char *TAG = "DDS";
+
+static_assert(DMA_AlternateData == 1, "DDS DMA ping-pong requires alternate control data");
+static_assert(CONFIG_DDS_DMA_HALF <= 1024, "DDS DMA half must fit one DMA cycle");
+
+#define DMA_CYCLE_CTRL_Msk  (0x07UL)
+#define DDS_EVENT_ENABLE    (1UL << 0)      ///< DdsEnable(true)
+
+
+/**
+ * @brief Поток отсчётов в DAC1_DATA
+ */
+struct DdsStream {
+    uint8_t     NextHalf;                               ///< Половина, которая отыграет следующей: 0 - primary
+    uint32_t    DmaControl;                             ///< Управляющее слово DMA для перезапуска половины
+    uint32_t    Block[2][CONFIG_DDS_DMA_HALF];          ///< Слова DAC1_DATA, две половины ping-pong
+};
+
+static DdsStream s_xStream;
+static DdsEngine s_xEngine;
+static DdsStats s_xStats;
+static volatile bool s_bEnabled = false;
+static EventChannel s_xEnableEvent;
+
+
+static void InitStream(DdsStream &stream) {
+    stream.NextHalf = 0;
+    DdsFill(s_xEngine, stream.Block[0], CONFIG_DDS_DMA_HALF);
+    DdsFill(s_xEngine, stream.Block[1], CONFIG_DDS_DMA_HALF);
+
+    // Источник - буфер, приёмник - DAC1_DATA, одно слово на запрос таймера
+    DMA_CtrlDataInitTypeDef primary;
+    primary.DMA_SourceBaseAddr = DmaMgrBusAddress(stream.Block[0]);
+    primary.DMA_DestBaseAddr = DmaMgrBusAddress(&MDR_DAC->DAC1_DATA);
+    primary.DMA_SourceIncSize = DMA_SourceIncWord;
+    primary.DMA_DestIncSize = DMA_DestIncNo;
+    primary.DMA_MemoryDataSize = DMA_MemoryDataSize_Word;
+    primary.DMA_Mode = DMA_Mode_PingPong;
+    primary.DMA_CycleSize = CONFIG_DDS_DMA_HALF;
+    primary.DMA_NumContinuous = DMA_Transfers_1;
+    primary.DMA_SourceProtCtrl = DMA_SourcePrivileged;
+    primary.DMA_DestProtCtrl = DMA_DestPrivileged;
+
+    DMA_CtrlDataInitTypeDef alternate = primary;
+    alternate.DMA_SourceBaseAddr = DmaMgrBusAddress(stream.Block[1]);
+
+    DMA_ChannelInitTypeDef channel;
+    DMA_StructInit(&channel);
+    channel.DMA_PriCtrlData = &primary;
+    channel.DMA_AltCtrlData = &alternate;
+    channel.DMA_Priority = DMA_Priority_High;
+    channel.DMA_UseBurst = DMA_BurstClear;
+    channel.DMA_SelectDataStructure = DMA_CTRL_DATA_PRIMARY;
+    DMA_Init(DMA_Channel_TIM2, &channel);
+    stream.DmaControl = DmaMgrPrimary(DMA_Channel_TIM2)->DMA_Control;
+}
+
+
+/*
+ * Пересчёт отыгранных половин в порядке воспроизведения. Если DMA успел отыграть обе половины, канал
+ * остановлен: после пересчёта обеих он включается заново с половины NextHalf.
+ */
+static void ProcessStream(DdsStream &stream) {
+    uint32_t mask = 1UL << DMA_Channel_TIM2;
+    bool stopped = (MDR_DMA->CHNL_ENABLE_SET & mask) == 0;
+
+    for (uint32_t i = 0; i < 2; i++) {
+        DMA_CtrlDataTypeDef *half = stream.NextHalf ? DmaMgrAlternate(DMA_Channel_TIM2)
+                                                    : DmaMgrPrimary(DMA_Channel_TIM2);
+        if ((half->DMA_Control & DMA_CYCLE_CTRL_Msk) != DMA_Mode_Stop)
+            break;
+        DdsFill(s_xEngine, stream.Block[stream.NextHalf], CONFIG_DDS_DMA_HALF);
+        half->DMA_Control = stream.DmaControl;
+        stream.NextHalf ^= 1;
+        s_xStats.Blocks++;
+    }
+
+    if (stopped) {
+        s_xStats.Overruns++;
+        if (stream.NextHalf)
+            MDR_DMA->CHNL_PRI_ALT_SET = mask;
+        else
+            MDR_DMA->CHNL_PRI_ALT_CLR = mask;
+        MDR_DMA->CHNL_ENABLE_SET = mask;
+    }
+}
+
+
+static void InitHW() {
+    RST_CLK_PCLKcmd(RST_CLK_PCLK_RST_CLK | RST_CLK_PCLK_PORTE | RST_CLK_PCLK_DAC | RST_CLK_PCLK_TIMER2, ENABLE);
+
+PORT_InitTypeDef PORT_InitStructure;
+    PORT_StructInit(&PORT_InitStructure);
+    // Выходы DAC1 - PE1, DAC2 - PE9, аналоговый режим
+    PORT_InitStructure.PORT_Pin = PORT_Pin_1 | PORT_Pin_9;
+    PORT_InitStructure.PORT_OE = PORT_OE_IN;
+    PORT_InitStructure.PORT_MODE = PORT_MODE_ANALOG;
+    PORT_Init(MDR_PORTE, &PORT_InitStructure);
+
+    // Синхронный режим: слово DAC1_DATA несёт оба канала и обновляет их одновременно
+    DAC_DeInit();
+    DAC_Init(DAC_SYNC_MODE_Synchronous, DAC1_AVCC, DAC2_AVCC);
+    DAC1_Cmd(ENABLE);
+    DAC2_Cmd(ENABLE);
+
+    uint32_t arr = SystemCoreClock / CONFIG_DDS_SAMPLE_RATE - 1;
+    TIMER_DeInit(MDR_TIMER2);
+    TIMER_BRGInit(MDR_TIMER2, TIMER_HCLKdiv1);
+    MDR_TIMER2->CNT = 0;
+    MDR_TIMER2->PSG = 0;
+    MDR_TIMER2->ARR = arr;
+    s_xStats.SampleRate = SystemCoreClock / (arr + 1);
+    s_xEngine.SampleRate = s_xStats.SampleRate;
+
+    InitStream(s_xStream);
+    MDR_DAC->DAC1_DATA = s_xStream.Block[1][CONFIG_DDS_DMA_HALF - 1];
+    MDR_TIMER2->STATUS = 0;
+    MDR_TIMER2->DMA_RE = TIMER_DMA_RE_CNT_ARR_EVENT_RE;
+}
+
+
+static void Execute(void *pvParameters) {
+    (void)pvParameters;
+    MDR_LOGI(TAG, "Start! %lu Hz", s_xStats.SampleRate);
+    EventInit(s_xEnableEvent, xTaskGetCurrentTaskHandle(), DDS_EVENT_ENABLE, "dds_en");
+
+    uint32_t overruns = 0;
+    TickType_t wake = xTaskGetTickCount();
+    for (;;) {
+        // Выключенный генератор не пересчитывается, задача спит до DdsEnable(true)
+        if (!s_bEnabled) {
+            EventWait(s_xEnableEvent, portMAX_DELAY);
+            wake = xTaskGetTickCount();
+            continue;
+        }
+        vTaskDelayUntil(&wake, pdMS_TO_TICKS(CONFIG_DDS_PERIOD_MS));
+        if (!s_bEnabled)
+            continue;
+
+        ProcessStream(s_xStream);
+        if (s_xStats.Overruns != overruns) {
+            overruns = s_xStats.Overruns;
+            MDR_LOGW(TAG, "DMA underrun %lu, increase CONFIG_DDS_DMA_HALF or decrease CONFIG_DDS_SAMPLE_RATE", overruns);
+        }
+    }
+}
+
+
+/**
+ * @brief Настройка DAC1, DAC2, TIMER2, DMA и запуск задачи пересчёта
+ *
+ * Генерация выключена, выходы в середине шкалы. Включается DdsEnable(). Канал DMA_Channel_TIM2 занимается
+ * у DmaMgrClaim(), остальные каналы DMA не затрагиваются.
+ */
+void DdsStart() {
+    if (!DmaMgrClaim(DMA_Channel_TIM2, "Dds"))
+        return;
+    DdsInit(s_xEngine, CONFIG_DDS_SAMPLE_RATE);
+    InitHW();
+
+    xTaskCreate(Execute, "Dds", configMINIMAL_STACK_SIZE * 2, nullptr, tskIDLE_PRIORITY + 2, nullptr);
+}
+
+
+/**
+ * @brief Включение и выключение генерации
+ *
+ * При выключении таймер останавливается, выходы переводятся в Offset каналов. Фаза сохраняется, генерация
+ * продолжается с отсчётов, уже лежащих в буфере.
+ */
+void DdsEnable(bool enable) {
+    if (enable) {
+        s_bEnabled = true;
+        MDR_TIMER2->CNTRL = TIMER_CNTRL_CNT_EN;
+        EventPost(s_xEnableEvent);
+    } else {
+        MDR_TIMER2->CNTRL = 0;
+        s_bEnabled = false;
+        MDR_DAC->DAC1_DATA = s_xEngine.Channel[0].Offset | (s_xEngine.Channel[1].Offset << DDS_DAC_HI_Pos);
+    }
+}
+
+
+bool DdsIsEnabled() {
+    return s_bEnabled;
+}
+
+
+/**
+ * @brief Частота канала
+ * @param channel Канал 0 - DAC1, 1 - DAC2
+ * @param millihertz Частота, мГц, до половины частоты отсчётов
+ * @return Установленная частота с учётом разрешения Fs / 2^32, мГц
+ */
+uint32_t DdsSetFrequency(uint8_t channel, uint32_t millihertz) {
+    assert_param(channel < DDS_CHANNELS);
+    uint32_t step = DdsTuningWord(millihertz, s_xEngine.SampleRate);
+    s_xEngine.Channel[channel].Step = step;
+    return DdsFrequency(step, s_xEngine.SampleRate);
+}
+
+
+/**
+ * @brief Амплитуда и смещение канала, коды ЦАП. Выход ограничивается 0..4095
+ * @param channel Канал 0 - DAC1, 1 - DAC2
+ * @param amplitude От середины до пика
+ * @param offset Середина синуса
+ */
+void DdsSetAmplitude(uint8_t channel, uint16_t amplitude, uint16_t offset) {
+    assert_param(channel < DDS_CHANNELS);
+    s_xEngine.Channel[channel].Amplitude = amplitude;
+    s_xEngine.Channel[channel].Offset = offset;
+}
+
+
+void DdsGetStats(DdsStats &stats) {
+    stats.SampleRate = s_xStats.SampleRate;
+    stats.Blocks = s_xStats.Blocks;
+    stats.Overruns = s_xStats.Overruns;
+}
+
+#endif
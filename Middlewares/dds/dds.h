@@ -0,0 +1,49 @@
+/**
+ * @file dds.h
+ * @brief Генератор синуса на DAC1 и DAC2 с передачей отсчётов по DMA от таймера
+ *
+ * TIMER2 отсчитывает период CONFIG_DDS_SAMPLE_RATE и на каждом CNT == ARR запрашивает DMA, который переносит
+ * слово из буфера ping-pong в DAC1_DATA. ЦАП работают в синхронном режиме, одно слово обновляет оба выхода.
+ * Частота отсчётов задаётся таймером и не зависит от планировщика: задача Dds раз в CONFIG_DDS_PERIOD_MS только
+ * досчитывает отыгранные половины буфера, см. dds_engine.h.
+ *
+ * Новые частота и амплитуда попадают в выход через одну-две половины буфера. Если задача не успела досчитать
+ * половину, DMA останавливается, выход держит последний отсчёт (счётчик Overruns в DdsGetStats()).
+ *
+ * Генератор собирается при CONFIG_DDS_ENABLE, иначе DdsStart() пустая и TIMER2, DAC, канал DMA свободны.
+ */
+
+#ifndef MILANDRBASE_DDS_H
+#define MILANDRBASE_DDS_H
+
+#include <stdint.h>
+#include "dds_engine.h"
+#include "app_config.h"
+
+
+/**
+ * @brief Счётчики работы
+ */
+struct DdsStats {
+    uint32_t SampleRate;            ///< Фактическая частота отсчётов, Гц
+    uint32_t Blocks;                ///< Досчитано половин буфера
+    uint32_t Overruns;              ///< DMA останавливался: обе половины отыграны до пересчёта
+};
+
+
+#if (CONFIG_DDS_ENABLE == 1)
+
+void DdsStart();
+void DdsEnable(bool enable);
+bool DdsIsEnabled();
+uint32_t DdsSetFrequency(uint8_t channel, uint32_t millihertz);
+void DdsSetAmplitude(uint8_t channel, uint16_t amplitude, uint16_t offset);
+void DdsGetStats(DdsStats &stats);
+
+#else
+
+static inline void DdsStart() {}
+
+#endif
+
+#endif //MILANDRBASE_DDS_H
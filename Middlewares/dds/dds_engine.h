@@ -0,0 +1,164 @@
+/**
+ * @file dds_engine.h
+ * @brief Прямой цифровой синтез синуса для двух каналов ЦАП
+ *
+ * Фаза канала - 32-битный аккумулятор, за отсчёт к нему прибавляется шаг Step = f * 2^32 / Fs. Старшие 2 бита
+ * фазы - квадрант, следующие 8 - номер точки в таблице четверти периода, ещё 8 - доля для линейной интерполяции
+ * между соседними точками. Таблица из 257 значений Q15 лежит во flash, полный период восстанавливается
+ * симметрией. Ошибка интерполяции меньше 1 LSB Q15, шум выхода определяется 12-битным ЦАП.
+ *
+ * Блок отсчётов заполняется словами для регистра DAC1_DATA в синхронном режиме: канал 0 в битах 0..11,
+ * канал 1 в битах 16..27. Параметры каналов читаются один раз в начале блока, изменение частоты не сбрасывает
+ * фазу, поэтому переход между блоками непрерывен.
+ *
+ * Модуль не зависит от периферии и собирается в хостовых тестах.
+ */
+
+#ifndef MILANDRBASE_DDS_ENGINE_H
+#define MILANDRBASE_DDS_ENGINE_H
+
+#include <stdint.h>
+#include <string.h>
+
+
+#define DDS_CHANNELS                    (2)             ///< DAC1, DAC2
+#define DDS_TABLE_BITS                  (8)             ///< Точек в четверти периода: 1 << DDS_TABLE_BITS
+#define DDS_FRACTION_BITS               (8)             ///< Разрядность доли для интерполяции
+#define DDS_DAC_MAX                     (0x0FFFUL)      ///< DAC_LO_DATA_MSK
+#define DDS_DAC_HI_Pos                  (16)            ///< Данные второго канала в синхронном режиме
+
+
+/**
+ * @brief Четверть периода синуса, Q15, точки 0..256 включительно
+ */
+static const int16_t DdsQuarterSine[(1 << DDS_TABLE_BITS) + 1] = {
+            0,   201,   402,   603,   804,  1005,  1206,  1407,  1608,  1809,  2009,  2210,
+         2410,  2611,  2811,  3012,  3212,  3412,  3612,  3811,  4011,  4210,  4410,  4609,
+         4808,  5007,  5205,  5404,  5602,  5800,  5998,  6195,  6393,  6590,  6786,  6983,
+         7179,  7375,  7571,  7767,  7962,  8157,  8351,  8545,  8739,  8933,  9126,  9319,
+         9512,  9704,  9896, 10087, 10278, 10469, 10659, 10849, 11039, 11228, 11417, 11605,
+        11793, 11980, 12167, 12353, 12539, 12725, 12910, 13094, 13279, 13462, 13645, 13828,
+        14010, 14191, 14372, 14553, 14732, 14912, 15090, 15269, 15446, 15623, 15800, 15976,
+        16151, 16325, 16499, 16673, 16846, 17018, 17189, 17360, 17530, 17700, 17869, 18037,
+        18204, 18371, 18537, 18703, 18868, 19032, 19195, 19357, 19519, 19680, 19841, 20000,
+        20159, 20317, 20475, 20631, 20787, 20942, 21096, 21250, 21403, 21554, 21705, 21856,
+        22005, 22154, 22301, 22448, 22594, 22739, 22884, 23027, 23170, 23311, 23452, 23592,
+        23731, 23870, 24007, 24143, 24279, 24413, 24547, 24680, 24811, 24942, 25072, 25201,
+        25329, 25456, 25582, 25708, 25832, 25955, 26077, 26198, 26319, 26438, 26556, 26674,
+        26790, 26905, 27019, 27133, 27245, 27356, 27466, 27575, 27683, 27790, 27896, 28001,
+        28105, 28208, 28310, 28411, 28510, 28609, 28706, 28803, 28898, 28992, 29085, 29177,
+        29268, 29358, 29447, 29534, 29621, 29706, 29791, 29874, 29956, 30037, 30117, 30195,
+        30273, 30349, 30424, 30498, 30571, 30643, 30714, 30783, 30852, 30919, 30985, 31050,
+        31113, 31176, 31237, 31297, 31356, 31414, 31470, 31526, 31580, 31633, 31685, 31736,
+        31785, 31833, 31880, 31926, 31971, 32014, 32057, 32098, 32137, 32176, 32213, 32250,
+        32285, 32318, 32351, 32382, 32412, 32441, 32469, 32495, 32521, 32545, 32567, 32589,
+        32609, 32628, 32646, 32663, 32678, 32692, 32705, 32717, 32728, 32737, 32745, 32752,
+        32757, 32761, 32765, 32766, 32767,
+};
+
+/**
+ * @brief Канал синтеза
+ */
+struct DdsChannel {
+    uint32_t            Phase;                          ///< Аккумулятор фазы, полный период 2^32
+    volatile uint32_t   Step;                           ///< Приращение фазы за отсчёт
+    volatile uint16_t   Amplitude;                      ///< Амплитуда, коды ЦАП от среднего до пика
+    volatile uint16_t   Offset;                         ///< Середина синуса, коды ЦАП
+};
+
+/**
+ * @brief Состояние синтезатора
+ */
+struct DdsEngine {
+    DdsChannel          Channel[DDS_CHANNELS];
+    uint32_t            SampleRate;                     ///< Частота отсчётов, Гц
+};
+
+
+static inline void DdsInit(DdsEngine &dds, uint32_t sampleRate) {
+    memset(&dds, 0, sizeof(dds));
+    dds.SampleRate = sampleRate;
+    for (uint32_t ch = 0; ch < DDS_CHANNELS; ch++)
+        dds.Channel[ch].Offset = (DDS_DAC_MAX + 1) / 2;
+}
+
+/**
+ * @brief Шаг фазы для частоты
+ * @param millihertz Частота, мГц. Выше Fs / 2 выход - зеркальная частота
+ * @param sampleRate Частота отсчётов, Гц
+ * @return Step с округлением, разрешение по частоте Fs / 2^32
+ */
+static inline uint32_t DdsTuningWord(uint32_t millihertz, uint32_t sampleRate) {
+    uint64_t divider = static_cast<uint64_t>(sampleRate) * 1000;
+    return static_cast<uint32_t>(((static_cast<uint64_t>(millihertz) << 32) + divider / 2) / divider);
+}
+
+/**
+ * @brief Частота, которую даёт шаг фазы, мГц
+ */
+static inline uint32_t DdsFrequency(uint32_t step, uint32_t sampleRate) {
+    return static_cast<uint32_t>((static_cast<uint64_t>(step) * sampleRate * 1000 + (1ULL << 31)) >> 32);
+}
+
+/**
+ * @brief Синус фазы
+ * @param phase Фаза, полный период 2^32
+ * @return Значение Q15, -32767..32767
+ */
+static inline int32_t DdsSine(uint32_t phase) {
+    const uint32_t shift = 32 - 2 - DDS_TABLE_BITS - DDS_FRACTION_BITS;
+    const uint32_t span = 1UL << (DDS_TABLE_BITS + DDS_FRACTION_BITS);
+
+    uint32_t quadrant = phase >> 30;
+    uint32_t position = (phase >> shift) & (span - 1);
+    if (quadrant & 1)
+        position = span - position;                     // Спад: 1..span, точка 256 есть в таблице
+
+    uint32_t index = position >> DDS_FRACTION_BITS;
+    uint32_t fraction = position & ((1UL << DDS_FRACTION_BITS) - 1);
+    int32_t value = DdsQuarterSine[index];
+    if (fraction != 0)
+        value += ((DdsQuarterSine[index + 1] - value) * static_cast<int32_t>(fraction)) >> DDS_FRACTION_BITS;
+    return (quadrant & 2) ? -value : value;
+}
+
+/**
+ * @brief Код ЦАП для синуса Q15 с амплитудой и смещением, с ограничением 0..DDS_DAC_MAX
+ */
+static inline uint32_t DdsScale(int32_t sine, uint16_t amplitude, uint16_t offset) {
+    int32_t value = offset + ((static_cast<int32_t>(amplitude) * sine + (1L << 14)) >> 15);
+    if (value < 0)
+        return 0;
+    if (value > static_cast<int32_t>(DDS_DAC_MAX))
+        return DDS_DAC_MAX;
+    return static_cast<uint32_t>(value);
+}
+
+/**
+ * @brief Заполнение блока словами DAC1_DATA синхронного режима
+ * @param dds Состояние
+ * @param block Блок, половина буфера DMA
+ * @param count Количество отсчётов
+ */
+static inline void DdsFill(DdsEngine &dds, uint32_t *block, uint32_t count) {
+    uint32_t phase[DDS_CHANNELS], step[DDS_CHANNELS];
+    uint16_t amplitude[DDS_CHANNELS], offset[DDS_CHANNELS];
+    for (uint32_t ch = 0; ch < DDS_CHANNELS; ch++) {
+        phase[ch] = dds.Channel[ch].Phase;
+        step[ch] = dds.Channel[ch].Step;
+        amplitude[ch] = dds.Channel[ch].Amplitude;
+        offset[ch] = dds.Channel[ch].Offset;
+    }
+
+    for (uint32_t i = 0; i < count; i++) {
+        block[i] = DdsScale(DdsSine(phase[0]), amplitude[0], offset[0]) |
+                   (DdsScale(DdsSine(phase[1]), amplitude[1], offset[1]) << DDS_DAC_HI_Pos);
+        phase[0] += step[0];
+        phase[1] += step[1];
+    }
+
+    for (uint32_t ch = 0; ch < DDS_CHANNELS; ch++)
+        dds.Channel[ch].Phase = phase[ch];
+}
+
+#endif //MILANDRBASE_DDS_ENGINE_H
@@ -0,0 +1,277 @@
+/**
+ * @file dmacopy.cpp
+ * @brief Асинхронные memcpy и memset в RAM на программном канале DMA
+ */
+
+#include <cstring>
+#include <MDR32F9Qx_config.h>
+#include <FreeRTOS.h>
+#include <dmamgr.h>
+#include "dmacopy.h"
+
+#include "log_levels.h"
+#define LOG_LOCAL_LEVEL LOG_TAG_DMACOPY_LOCAL_LEVEL
+#include <mdr_log.h>
+static const char *TAG = "DMACPY";
+
+static_assert(CONFIG_DMACOPY_R_POWER <= 10, "CONFIG_DMACOPY_R_POWER out of range");
+
+#define DMACOPY_CYCLE_MAX       (1024)          ///< Элементов в цикле авто
+#define DMACOPY_BENCH_MIN       (16)            ///< Наименьший размер замера, байт
+
+
+static uint8_t s_uChannel = DMA_TABLE_CHANNEL_NONE;
+static DmaCopyJob *s_pHead;                     ///< Выполняется
+static DmaCopyJob *s_pTail;
+static DmaCopyStats s_xStats = {0, 0, CONFIG_DMACOPY_THRESHOLD};
+
+
+static uint8_t ElementShift(uint32_t bits) {
+    if ((bits & 3) == 0)
+        return 2;
+    return (bits & 1) == 0 ? 1 : 0;
+}
+
+
+/*
+ * Цикл авто очередной части задания. Вызывается с запрещёнными прерываниями или из обратного вызова канала
+ */
+static void StartChunk(DmaCopyJob &job) {
+    uint32_t count = job.Size >> job.Shift;
+    if (count > DMACOPY_CYCLE_MAX)
+        count = DMACOPY_CYCLE_MAX;
+    job.Chunk = count << job.Shift;
+
+    DmaDescriptor primary;
+    DmaSegmentDescriptor(primary, {job.Source, job.Dest, static_cast<uint16_t>(count), job.Shift,
+                                   static_cast<uint8_t>(job.Fixed ? DMA_SEGMENT_SOURCE_FIXED : 0)},
+                         DMA_CYCLE_AUTO, CONFIG_DMACOPY_R_POWER);
+    DmaMgrStartDescriptor(s_uChannel, primary);
+    DmaMgrRequest(s_uChannel);
+}
+
+
+static void ChunkDone(uint8_t channel, void *context, BaseType_t *pxHigherPriorityTaskWoken) {
+    (void)channel;
+    (void)context;
+    DmaCopyJob *job = s_pHead;
+    if (job == nullptr)
+        return;
+
+    job->Dest += job->Chunk;
+    if (!job->Fixed)
+        job->Source += job->Chunk;
+    job->Size -= job->Chunk;
+    if (job->Size != 0) {
+        StartChunk(*job);
+        return;
+    }
+
+    // После Pending = false задание принадлежит вызывающему
+    EventChannel *done = job->Done;
+    s_pHead = job->Next;
+    if (s_pHead == nullptr)
+        s_pTail = nullptr;
+    s_xStats.DmaJobs++;
+    job->Pending = false;
+    if (done != nullptr)
+        EventPostFromISR(*done, pxHigherPriorityTaskWoken);
+    if (s_pHead != nullptr)
+        StartChunk(*s_pHead);
+}
+
+
+static void Enqueue(DmaCopyJob &job) {
+    job.Next = nullptr;
+    job.Pending = true;
+
+    uint32_t primask = __get_PRIMASK();
+    __disable_irq();
+    if (s_pTail != nullptr) {
+        s_pTail->Next = &job;
+        s_pTail = &job;
+    } else {
+        s_pHead = s_pTail = &job;
+        StartChunk(job);
+    }
+    __set_PRIMASK(primask);
+}
+
+
+/*
+ * Задание процессором: короткое или без канала DMA
+ */
+static void Complete(DmaCopyJob &job) {
+    uint32_t primask = __get_PRIMASK();
+    __disable_irq();
+    s_xStats.CpuJobs++;
+    __set_PRIMASK(primask);
+    job.Pending = false;
+    if (job.Done != nullptr)
+        EventPost(*job.Done);
+}
+
+
+/**
+ * @brief Копирование
+ * @param job Задание, не должно быть в очереди
+ * @param dest Приёмник в RAM
+ * @param source Источник
+ * @param size Байт
+ * @param done Событие завершения или nullptr
+ * @return true - копирование поставлено в очередь DMA, false - уже выполнено процессором
+ */
+bool DmaMemcpyAsync(DmaCopyJob &job, void *dest, const void *source, size_t size, EventChannel *done) {
+    assert_param(!job.Pending);
+    job.Done = done;
+    if (size < s_xStats.Threshold || size == 0 || s_uChannel == DMA_TABLE_CHANNEL_NONE) {
+        memcpy(dest, source, size);
+        Complete(job);
+        return false;
+    }
+
+    job.Dest = DmaMgrBusAddress(dest);
+    job.Source = DmaMgrBusAddress(source);
+    job.Size = size;
+    job.Shift = ElementShift(job.Dest | job.Source | job.Size);
+    job.Fixed = false;
+    Enqueue(job);
+    return true;
+}
+
+
+/**
+ * @brief Заполнение
+ * @param job Задание, не должно быть в очереди
+ * @param dest Приёмник в RAM
+ * @param value Байт заполнения
+ * @param size Байт
+ * @param done Событие завершения или nullptr
+ * @return true - заполнение поставлено в очередь DMA, false - уже выполнено процессором
+ */
+bool DmaMemsetAsync(DmaCopyJob &job, void *dest, uint8_t value, size_t size, EventChannel *done) {
+    assert_param(!job.Pending);
+    job.Done = done;
+    if (size < s_xStats.Threshold || size == 0 || s_uChannel == DMA_TABLE_CHANNEL_NONE) {
+        memset(dest, value, size);
+        Complete(job);
+        return false;
+    }
+
+    job.Dest = DmaMgrBusAddress(dest);
+    job.Fill = value * 0x01010101UL;
+    job.Source = DmaMgrBusAddress(&job.Fill);
+    job.Size = size;
+    job.Shift = ElementShift(job.Dest | job.Size);
+    job.Fixed = true;
+    Enqueue(job);
+    return true;
+}
+
+
+/**
+ * @brief Порог выполнения процессором, байт. 0 - все задания на DMA
+ */
+void DmaCopySetThreshold(uint32_t threshold) {
+    s_xStats.Threshold = threshold;
+}
+
+
+void DmaCopyGetStats(DmaCopyStats &stats) {
+    uint32_t primask = __get_PRIMASK();
+    __disable_irq();
+    stats = s_xStats;
+    __set_PRIMASK(primask);
+}
+
+
+/*
+ * Копирование DMA с ожиданием конца по CHNL_ENABLE_SET, до установки обратного вызова канала
+ */
+static uint32_t MeasureDma(void *dest, const void *source, uint32_t size) {
+    DmaCopyJob job = {};
+    uint32_t start = DWT->CYCCNT;
+    job.Dest = DmaMgrBusAddress(dest);
+    job.Source = DmaMgrBusAddress(source);
+    job.Size = size;
+    job.Shift = ElementShift(job.Dest | job.Source | job.Size);
+    while (job.Size != 0) {
+        StartChunk(job);
+        while (MDR_DMA->CHNL_ENABLE_SET & (1UL << s_uChannel)) {}
+        job.Dest += job.Chunk;
+        job.Source += job.Chunk;
+        job.Size -= job.Chunk;
+    }
+    return DWT->CYCCNT - start;
+}
+
+static uint32_t MeasureCpu(void *dest, const void *source, uint32_t size) {
+    uint32_t start = DWT->CYCCNT;
+    memcpy(dest, source, size);
+    return DWT->CYCCNT - start;
+}
+
+static uint32_t KiloBytesPerSecond(uint32_t size, uint32_t cycles) {
+    return cycles == 0 ? 0 : static_cast<uint32_t>(static_cast<uint64_t>(size) * SystemCoreClock / 1024 / cycles);
+}
+
+
+/*
+ * Замер memcpy и DMA на размерах DMACOPY_BENCH_MIN..CONFIG_DMACOPY_BENCH_MAX, выровненные буферы из кучи
+ * @return Наименьший размер, на котором DMA не медленнее, или CONFIG_DMACOPY_BENCH_MAX + 1
+ */
+static uint32_t Benchmark() {
+    auto source = static_cast<uint8_t *>(pvPortMalloc(CONFIG_DMACOPY_BENCH_MAX));
+    auto dest = static_cast<uint8_t *>(pvPortMalloc(CONFIG_DMACOPY_BENCH_MAX));
+    uint32_t threshold = CONFIG_DMACOPY_BENCH_MAX + 1;
+    if (source == nullptr || dest == nullptr) {
+        MDR_LOGW(TAG, "No memory for benchmark, threshold %lu", threshold);
+        vPortFree(source);
+        vPortFree(dest);
+        return threshold;
+    }
+    for (uint32_t i = 0; i < CONFIG_DMACOPY_BENCH_MAX; i++)
+        source[i] = static_cast<uint8_t>(i);
+
+    for (uint32_t size = DMACOPY_BENCH_MIN; size <= CONFIG_DMACOPY_BENCH_MAX; size *= 2) {
+        // Первый проход прогревает буфер предвыборки flash, учитывается второй
+        uint32_t cpu = 0, dma = 0;
+        for (uint32_t pass = 0; pass < 2; pass++) {
+            cpu = MeasureCpu(dest, source, size);
+            dma = MeasureDma(dest, source, size);
+        }
+        if (dma <= cpu && threshold > size)
+            threshold = size;
+#if (CONFIG_DMACOPY_BENCHMARK == 1)
+        MDR_LOGI(TAG, "@DMACPY,%lu,%lu,%lu,%lu,%lu", size, cpu, dma, KiloBytesPerSecond(size, cpu),
+                 KiloBytesPerSecond(size, dma));
+#else
+        (void)KiloBytesPerSecond;
+#endif
+    }
+    vPortFree(source);
+    vPortFree(dest);
+    return threshold;
+}
+
+
+/**
+ * @brief Занятие программного канала и, при CONFIG_DMACOPY_THRESHOLD == 0, замер порога
+ *
+ * Вызывается до заданий, замер ждёт DMA опросом и может выполняться до запуска планировщика.
+ */
+void DmaCopyStart() {
+    s_uChannel = DmaMgrClaimSoftware("DmaCopy");
+    if (s_uChannel == DMA_TABLE_CHANNEL_NONE)
+        return;
+
+    CoreDebug->DEMCR |= CoreDebug_DEMCR_TRCENA_Msk;
+    DWT->CTRL |= DWT_CTRL_CYCCNTENA_Msk;
+    if (CONFIG_DMACOPY_THRESHOLD == 0 || CONFIG_DMACOPY_BENCHMARK == 1) {
+        uint32_t measured = Benchmark();
+        if (CONFIG_DMACOPY_THRESHOLD == 0)
+            s_xStats.Threshold = measured;
+    }
+    DmaMgrSetCallback(s_uChannel, ChunkDone, nullptr, false);
+    MDR_LOGI(TAG, "Channel %u, CPU below %lu bytes", s_uChannel, s_xStats.Threshold);
+}
@@ -0,0 +1,65 @@
+/**
+ * @file dmacopy.h
+ * @brief Асинхронные memcpy и memset в RAM на программном канале DMA
+ *
+ * Задание копирования или заполнения ставится в очередь программного канала, задания выполняются по порядку
+ * циклами авто по 1024 элемента. Размер элемента - наибольший из слова, полуслова и байта, на который выровнены
+ * адреса и длина. Контроллер переарбитрирует каналы через 2^CONFIG_DMACOPY_R_POWER элементов, поэтому каналы
+ * периферии не ждут конца длинного копирования. О завершении задания сообщает событие канала events.
+ *
+ * Задание короче порога выполняется процессором сразу в вызове, событие публикуется так же. Порог
+ * CONFIG_DMACOPY_THRESHOLD, по умолчанию 64 байта: на 80 МГц memcpy newlib-nano из flash тратит ~7 тактов на байт,
+ * запуск задания DMA с завершением по прерыванию ~350 тактов. При 0 порог измеряется в DmaCopyStart(): наименьший
+ * размер, на котором DMA с запуском и ожиданием конца цикла не медленнее memcpy, буферы замера 2 x
+ * CONFIG_DMACOPY_BENCH_MAX берутся из кучи. При CONFIG_DMACOPY_BENCHMARK замеры выводятся в лог строками:
+ *   @DMACPY,<байт>,<тактов memcpy>,<тактов DMA>,<КБ/с memcpy>,<КБ/с DMA>
+ *
+ * Задание и буферы должны жить до завершения: DmaCopyBusy() или событие.
+ */
+
+#ifndef MILANDRBASE_DMACOPY_H
+#define MILANDRBASE_DMACOPY_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include <events.h>
+#include "app_config.h"
+
+
+/**
+ * @brief Задание копирования или заполнения
+ */
+struct DmaCopyJob {
+    uint32_t       Dest;            ///< Адрес следующего элемента приёмника
+    uint32_t       Source;          ///< Адрес следующего элемента источника или &Fill
+    uint32_t       Size;            ///< Осталось байт
+    uint32_t       Fill;            ///< Байт заполнения во всех байтах слова
+    uint32_t       Chunk;           ///< Байт в текущем цикле DMA
+    uint8_t        Shift;           ///< log2 размера элемента
+    bool           Fixed;           ///< Источник не сдвигается: заполнение
+    volatile bool  Pending;         ///< В очереди или выполняется
+    EventChannel  *Done;            ///< Событие завершения, nullptr - без события
+    DmaCopyJob    *Next;
+};
+
+/**
+ * @brief Счётчики заданий
+ */
+struct DmaCopyStats {
+    uint32_t DmaJobs;               ///< Заданий, выполненных DMA
+    uint32_t CpuJobs;               ///< Заданий короче порога, выполненных процессором
+    uint32_t Threshold;             ///< Текущий порог, байт
+};
+
+
+void DmaCopyStart();
+bool DmaMemcpyAsync(DmaCopyJob &job, void *dest, const void *source, size_t size, EventChannel *done);
+bool DmaMemsetAsync(DmaCopyJob &job, void *dest, uint8_t value, size_t size, EventChannel *done);
+void DmaCopySetThreshold(uint32_t threshold);
+void DmaCopyGetStats(DmaCopyStats &stats);
+
+static inline bool DmaCopyBusy(const DmaCopyJob &job) {
+    return job.Pending;
+}
+
+#endif //MILANDRBASE_DMACOPY_H
@@ -0,0 +1,203 @@
+/**
+ * @file dma_table.h
+ * @brief Управляющие структуры каналов DMA PL230: цепочки scatter-gather, занятость каналов, разбор завершений
+ *
+ * Управляющая структура канала - 4 слова: конец источника, конец приёмника, управляющее слово и резерв, как
+ * DMA_CtrlDataTypeDef. Управляющее слово:
+ *   [2:0] режим цикла, [13:4] элементов - 1, [17:14] R - арбитраж через 2^R элементов, [20:18] и [23:21] защита
+ *   источника и приёмника, [25:24] и [29:28] размер элемента, [27:26] и [31:30] шаг адреса, 3 - без шага.
+ *
+ * Цепочка scatter-gather: массив задач - копий альтернативной структуры канала. Основная структура в режиме
+ * scatter-gather пересылает очередную задачу (4 слова, R = 2) в альтернативную, контроллер выполняет её и
+ * возвращается к основной. Промежуточные задачи в режиме альтернативного scatter-gather, последняя - в режиме авто
+ * (память) или основном (периферия), после неё канал выключается и контроллер сообщает dma_done.
+ *
+ * Адреса - 32-битные адреса шины, поэтому модуль не зависит от периферии и собирается в хостовых тестах
+ * с моделью памяти и контроллера.
+ */
+
+#ifndef MILANDRBASE_DMA_TABLE_H
+#define MILANDRBASE_DMA_TABLE_H
+
+#include <stdint.h>
+
+
+#define DMA_TABLE_CHANNELS          (32)
+#define DMA_TABLE_CHANNEL_NONE      (0xFF)          ///< Нет свободного канала
+#define DMA_TABLE_ALT_OFFSET        (DMA_TABLE_CHANNELS * 16)   ///< Альтернативные структуры после основных
+#define DMA_TABLE_CHAIN_MAX         (256)           ///< Задач в цепочке: 4 слова на задачу, не больше 1024 пересылок
+
+#define DMA_CYCLE_Msk               (0x07UL)
+#define DMA_CYCLE_STOP              (0)
+#define DMA_CYCLE_BASIC             (1)
+#define DMA_CYCLE_AUTO              (2)
+#define DMA_CYCLE_PINGPONG          (3)
+#define DMA_CYCLE_MEM_SG_PRI        (4)
+#define DMA_CYCLE_MEM_SG_ALT        (5)
+#define DMA_CYCLE_PER_SG_PRI        (6)
+#define DMA_CYCLE_PER_SG_ALT        (7)
+
+#define DMA_N_MINUS_1_Pos           (4)
+#define DMA_N_MINUS_1_Msk           (0x3FFUL << DMA_N_MINUS_1_Pos)
+#define DMA_R_POWER_Pos             (14)
+#define DMA_PROT_PRIVILEGED         ((1UL << 18) | (1UL << 21))     ///< Как DMA_SourcePrivileged | DMA_DestPrivileged
+#define DMA_SRC_SIZE_Pos            (24)
+#define DMA_SRC_INC_Pos             (26)
+#define DMA_DST_SIZE_Pos            (28)
+#define DMA_DST_INC_Pos             (30)
+#define DMA_INC_NONE                (3)
+
+#define DMA_SEGMENT_SOURCE_FIXED    (0x01)          ///< Адрес источника не меняется, например регистр данных
+#define DMA_SEGMENT_DEST_FIXED      (0x02)          ///< Адрес приёмника не меняется
+
+
+/**
+ * @brief Управляющая структура канала в памяти, как DMA_CtrlDataTypeDef
+ */
+struct DmaDescriptor {
+    uint32_t SourceEnd;             ///< Адрес последнего элемента источника
+    uint32_t DestEnd;               ///< Адрес последнего элемента приёмника
+    uint32_t Control;               ///< Управляющее слово
+    uint32_t Spare;
+};
+
+/**
+ * @brief Участок пересылки в цепочке
+ */
+struct DmaSegment {
+    uint32_t Source;                ///< Адрес первого элемента источника
+    uint32_t Dest;                  ///< Адрес первого элемента приёмника
+    uint16_t Count;                 ///< Элементов, 1..1024
+    uint8_t  Size;                  ///< log2 размера элемента: 0 - байт, 1 - полуслово, 2 - слово
+    uint8_t  Flags;                 ///< DMA_SEGMENT_SOURCE_FIXED, DMA_SEGMENT_DEST_FIXED
+};
+
+/**
+ * @brief Состояние разбора завершений
+ */
+struct DmaCompletion {
+    uint32_t Armed;                 ///< Однократные циклы: канал запущен и ещё не выключился
+    uint32_t Continuous;            ///< Пинг-понг: завершение каждой половины
+    uint32_t Reported[2];           ///< Остановленные половины (primary, alternate), о которых уже сообщено
+};
+
+
+static inline uint32_t DmaControlWord(uint32_t cycle, uint32_t size, uint32_t count, uint32_t rpower,
+                                      bool sourceFixed, bool destFixed) {
+    uint32_t srcInc = sourceFixed ? DMA_INC_NONE : size;
+    uint32_t dstInc = destFixed ? DMA_INC_NONE : size;
+    return cycle | ((count - 1) << DMA_N_MINUS_1_Pos) | (rpower << DMA_R_POWER_Pos) | DMA_PROT_PRIVILEGED |
+           (size << DMA_SRC_SIZE_Pos) | (srcInc << DMA_SRC_INC_Pos) |
+           (size << DMA_DST_SIZE_Pos) | (dstInc << DMA_DST_INC_Pos);
+}
+
+/**
+ * @brief Структура участка с адресами концов, как DMA_CtrlDataInit()
+ */
+static inline void DmaSegmentDescriptor(DmaDescriptor &descriptor, const DmaSegment &segment, uint32_t cycle,
+                                        uint32_t rpower) {
+    uint32_t last = static_cast<uint32_t>(segment.Count - 1) << segment.Size;
+    descriptor.SourceEnd = segment.Source + ((segment.Flags & DMA_SEGMENT_SOURCE_FIXED) ? 0 : last);
+    descriptor.DestEnd = segment.Dest + ((segment.Flags & DMA_SEGMENT_DEST_FIXED) ? 0 : last);
+    descriptor.Control = DmaControlWord(cycle, segment.Size, segment.Count, rpower,
+                                        segment.Flags & DMA_SEGMENT_SOURCE_FIXED, segment.Flags & DMA_SEGMENT_DEST_FIXED);
+    descriptor.Spare = 0;
+}
+
+/**
+ * @brief Заполнение задач цепочки
+ *
+ * Задачи памяти выполняются целиком по одному программному запросу, задачи периферии - по элементу на запрос.
+ * @param tasks Массив задач, count элементов, выравнивание 4
+ * @param segments Участки
+ * @param count Участков, 1..DMA_TABLE_CHAIN_MAX
+ * @param peripheral true - пересылки по запросам периферии
+ */
+static inline void DmaChainBuild(DmaDescriptor *tasks, const DmaSegment *segments, uint32_t count, bool peripheral) {
+    uint32_t rpower = peripheral ? 0 : 10;
+    for (uint32_t i = 0; i < count; i++) {
+        uint32_t cycle;
+        if (i + 1 < count)
+            cycle = peripheral ? DMA_CYCLE_PER_SG_ALT : DMA_CYCLE_MEM_SG_ALT;
+        else
+            cycle = peripheral ? DMA_CYCLE_BASIC : DMA_CYCLE_AUTO;
+        DmaSegmentDescriptor(tasks[i], segments[i], cycle, rpower);
+    }
+}
+
+/**
+ * @brief Основная структура канала, копирующая задачи цепочки в альтернативную. Для памяти совпадает с DMA_SG_Init()
+ * @param primary Основная структура
+ * @param tasksAddress Адрес массива задач
+ * @param count Задач
+ * @param alternateAddress Адрес альтернативной структуры канала
+ * @param peripheral true - пересылки по запросам периферии
+ */
+static inline void DmaChainPrimary(DmaDescriptor &primary, uint32_t tasksAddress, uint32_t count,
+                                   uint32_t alternateAddress, bool peripheral) {
+    primary.SourceEnd = tasksAddress + count * sizeof(DmaDescriptor) - sizeof(uint32_t);
+    primary.DestEnd = alternateAddress + sizeof(DmaDescriptor) - sizeof(uint32_t);
+    primary.Control = DmaControlWord(peripheral ? DMA_CYCLE_PER_SG_PRI : DMA_CYCLE_MEM_SG_PRI, 2, count * 4, 2,
+                                     false, false);
+    primary.Spare = 0;
+}
+
+
+/**
+ * @brief Занятие канала
+ * @return false - канал уже занят
+ */
+static inline bool DmaChannelClaim(uint32_t &claimed, uint8_t channel) {
+    uint32_t mask = 1UL << channel;
+    if (claimed & mask)
+        return false;
+    claimed |= mask;
+    return true;
+}
+
+/**
+ * @brief Занятие первого свободного канала из диапазона
+ * @return Канал или DMA_TABLE_CHANNEL_NONE
+ */
+static inline uint8_t DmaChannelClaimFree(uint32_t &claimed, uint8_t first, uint8_t last) {
+    for (uint32_t channel = first; channel <= last; channel++) {
+        if (DmaChannelClaim(claimed, channel))
+            return channel;
+    }
+    return DMA_TABLE_CHANNEL_NONE;
+}
+
+
+/**
+ * @brief Каналы, завершившие работу с прошлого разбора
+ *
+ * Однократный цикл завершён, когда контроллер выключил запущенный канал. Канал пинг-понг сообщает о каждой
+ * остановленной половине один раз; половина снова участвует в разборе после перезапуска.
+ * @param state Состояние
+ * @param enabled CHNL_ENABLE_SET
+ * @param primary Основные структуры каналов
+ * @param alternate Альтернативные структуры каналов
+ * @return Маска каналов для обратных вызовов
+ */
+static inline uint32_t DmaCompletionScan(DmaCompletion &state, uint32_t enabled, const DmaDescriptor *primary,
+                                         const DmaDescriptor *alternate) {
+    uint32_t done = state.Armed & ~enabled;
+    state.Armed &= ~done;
+
+    for (uint32_t pending = state.Continuous; pending != 0; pending &= pending - 1) {
+        uint32_t channel = __builtin_ctz(pending);
+        uint32_t mask = 1UL << channel;
+        const DmaDescriptor *halves[2] = {&primary[channel], &alternate[channel]};
+        for (uint32_t h = 0; h < 2; h++) {
+            if ((halves[h]->Control & DMA_CYCLE_Msk) != DMA_CYCLE_STOP) {
+                state.Reported[h] &= ~mask;
+            } else if ((state.Reported[h] & mask) == 0) {
+                state.Reported[h] |= mask;
+                done |= mask;
+            }
+        }
+    }
+    return done;
+}
+
+#endif //MILANDRBASE_DMA_TABLE_H
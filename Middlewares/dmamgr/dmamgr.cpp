@@ -0,0 +1,274 @@
+/**
+ * @file dmamgr.cpp
+ * @brief Общий контроллер DMA: таблица управляющих структур, распределение каналов, обратные вызовы завершения
+ */
+
+#include <MDR32F9Qx_config.h>
+#include <MDR32F9Qx_rst_clk.h>
+#include <MDR32F9Qx_dma.h>
+#include <FreeRTOS.h>
+#include <stackprof.h>
+#include "dmamgr.h"
+
+#include "log_levels.h"
+#define LOG_LOCAL_LEVEL LOG_TAG_DMA_LOCAL_LEVEL
+#include <mdr_log.h>
+static const char *TAG = "DMA";
+
+static_assert(DMA_AlternateData == 1, "DMA manager requires alternate control data");
+static_assert(DMA_Channels_Number == DMA_TABLE_CHANNELS, "DMA manager handles all 32 channels");
+static_assert(sizeof(DmaDescriptor) == sizeof(DMA_CtrlDataTypeDef), "DmaDescriptor must match DMA_CtrlDataTypeDef");
+
+extern "C" DMA_CtrlDataTypeDef DMA_ControlTable[];      // MDR32F9Qx_dma.c, выровнена по размеру таблицы
+
+
+/**
+ * @brief Обработчик завершения канала
+ */
+struct DmaMgrHandler {
+    DmaMgrCallback  Callback;
+    void           *Context;
+};
+
+static bool s_bInit = false;
+static uint32_t s_uClaimed;
+static const char *s_pOwners[DMA_TABLE_CHANNELS];
+static DmaMgrHandler s_xHandlers[DMA_TABLE_CHANNELS];
+static DmaCompletion s_xCompletion;
+
+
+static inline const DmaDescriptor *Descriptors(uint32_t base) {
+    return reinterpret_cast<const DmaDescriptor *>(base);
+}
+
+
+/**
+ * @brief Сброс контроллера и разрешение DMA_IRQn. Повторные вызовы ничего не делают
+ *
+ * Вызывается при первом занятии канала, до настройки каналов модулями. Все каналы выключены, запросы замаскированы.
+ */
+void DmaMgrInit() {
+    uint32_t primask = __get_PRIMASK();
+    __disable_irq();
+    if (s_bInit) {
+        __set_PRIMASK(primask);
+        return;
+    }
+    s_bInit = true;
+    RST_CLK_PCLKcmd(RST_CLK_PCLK_DMA, ENABLE);
+    DMA_DeInit();
+    MDR_DMA->CHNL_ENABLE_CLR = 0xFFFFFFFF;      // DMA_DeInit() включает все каналы
+    MDR_DMA->CTRL_BASE_PTR = DmaMgrBusAddress(DMA_ControlTable);
+    __set_PRIMASK(primask);
+
+    NVIC_SetPriority(DMA_IRQn, NVIC_EncodePriority(NVIC_GetPriorityGrouping(), DMAMGR_IRQ_PREEMPTIVE_PRIORITY,
+                                                   DMAMGR_IRQ_SUBPRIORITY));
+    NVIC_EnableIRQ(DMA_IRQn);
+}
+
+
+/**
+ * @brief Занятие канала периферии
+ * @param channel DMA_Channel_SSP1_TX, DMA_Channel_ADC1 и т.д.
+ * @param owner Имя владельца для сообщений, запоминается указатель
+ * @return false - канал занят другим модулем
+ */
+bool DmaMgrClaim(uint8_t channel, const char *owner) {
+    assert_param(channel < DMA_TABLE_CHANNELS);
+    DmaMgrInit();
+
+    uint32_t primask = __get_PRIMASK();
+    __disable_irq();
+    bool claimed = DmaChannelClaim(s_uClaimed, channel);
+    const char *current = s_pOwners[channel];
+    if (claimed)
+        s_pOwners[channel] = owner;
+    __set_PRIMASK(primask);
+
+    if (!claimed)
+        MDR_LOGE(TAG, "Channel %u for %s is used by %s", channel, owner, current);
+    return claimed;
+}
+
+
+/**
+ * @brief Занятие свободного программного канала DMA_Channel_SW1..SW19 для пересылок память-память
+ * @param owner Имя владельца для сообщений, запоминается указатель
+ * @return Канал или DMA_TABLE_CHANNEL_NONE
+ */
+uint8_t DmaMgrClaimSoftware(const char *owner) {
+    DmaMgrInit();
+
+    uint32_t primask = __get_PRIMASK();
+    __disable_irq();
+    uint8_t channel = DmaChannelClaimFree(s_uClaimed, DMA_Channel_SW1, DMA_TABLE_CHANNELS - 1);
+    if (channel != DMA_TABLE_CHANNEL_NONE)
+        s_pOwners[channel] = owner;
+    __set_PRIMASK(primask);
+
+    if (channel == DMA_TABLE_CHANNEL_NONE)
+        MDR_LOGE(TAG, "No free software channel for %s", owner);
+    return channel;
+}
+
+
+/**
+ * @brief Выключение и освобождение канала
+ */
+void DmaMgrRelease(uint8_t channel) {
+    assert_param(channel < DMA_TABLE_CHANNELS);
+    uint32_t mask = 1UL << channel;
+    uint32_t primask = __get_PRIMASK();
+    __disable_irq();
+    MDR_DMA->CHNL_ENABLE_CLR = mask;
+    MDR_DMA->CHNL_REQ_MASK_SET = mask;
+    s_xCompletion.Armed &= ~mask;
+    s_xCompletion.Continuous &= ~mask;
+    s_xHandlers[channel] = {nullptr, nullptr};
+    s_pOwners[channel] = nullptr;
+    s_uClaimed &= ~mask;
+    __set_PRIMASK(primask);
+}
+
+
+/**
+ * @brief Обратный вызов завершения канала
+ * @param channel Занятый канал
+ * @param callback Обратный вызов, nullptr - завершения не передаются
+ * @param context Параметр обратного вызова
+ * @param continuous true - канал пинг-понг, вызов на каждую остановленную половину
+ */
+void DmaMgrSetCallback(uint8_t channel, DmaMgrCallback callback, void *context, bool continuous) {
+    assert_param((s_uClaimed & (1UL << channel)) != 0);
+    uint32_t mask = 1UL << channel;
+    uint32_t primask = __get_PRIMASK();
+    __disable_irq();
+    s_xHandlers[channel] = {callback, context};
+    if (callback != nullptr && continuous)
+        s_xCompletion.Continuous |= mask;
+    else
+        s_xCompletion.Continuous &= ~mask;
+    __set_PRIMASK(primask);
+}
+
+
+/**
+ * @brief Настройка и запуск канала, как DMA_Init()
+ *
+ * Обратный вызов однократного канала придёт, когда контроллер выключит канал в конце цикла.
+ */
+void DmaMgrStart(uint8_t channel, DMA_ChannelInitTypeDef &init) {
+    assert_param((s_uClaimed & (1UL << channel)) != 0);
+    uint32_t mask = 1UL << channel;
+    uint32_t primask = __get_PRIMASK();
+    __disable_irq();
+    if (s_xCompletion.Continuous & mask) {
+        s_xCompletion.Reported[0] &= ~mask;
+        s_xCompletion.Reported[1] &= ~mask;
+    } else if (s_xHandlers[channel].Callback != nullptr) {
+        s_xCompletion.Armed |= mask;
+    }
+    DMA_Init(channel, &init);
+    __set_PRIMASK(primask);
+}
+
+
+/**
+ * @brief Запуск канала с готовыми управляющими структурами, без SPL. Можно вызывать из обратного вызова канала
+ *
+ * Программный канал стартует по DmaMgrRequest(), канал периферии - по одиночным запросам и запросам burst.
+ * @param channel Занятый канал
+ * @param primary Основная структура
+ * @param alternate Альтернативная структура для режима пинг-понг, nullptr - не меняется
+ */
+void DmaMgrStartDescriptor(uint8_t channel, const DmaDescriptor &primary, const DmaDescriptor *alternate) {
+    assert_param((s_uClaimed & (1UL << channel)) != 0);
+    uint32_t mask = 1UL << channel;
+    uint32_t primask = __get_PRIMASK();
+    __disable_irq();
+    if (s_xCompletion.Continuous & mask) {
+        s_xCompletion.Reported[0] &= ~mask;
+        s_xCompletion.Reported[1] &= ~mask;
+    } else if (s_xHandlers[channel].Callback != nullptr) {
+        s_xCompletion.Armed |= mask;
+    }
+    *reinterpret_cast<DmaDescriptor *>(DmaMgrPrimary(channel)) = primary;
+    if (alternate != nullptr)
+        *reinterpret_cast<DmaDescriptor *>(DmaMgrAlternate(channel)) = *alternate;
+    MDR_DMA->CHNL_USEBURST_CLR = mask;
+    MDR_DMA->CHNL_PRI_ALT_CLR = mask;
+    MDR_DMA->CHNL_REQ_MASK_CLR = mask;
+    MDR_DMA->CHNL_ENABLE_SET = mask;
+    __set_PRIMASK(primask);
+}
+
+
+/**
+ * @brief Запуск цепочки scatter-gather
+ *
+ * Канал настраивается DMA_SG_Init(), основная структура переписывается на режим периферии для peripheral.
+ * Цепочка памяти стартует по DmaMgrRequest(), цепочка периферии - по запросам периферии.
+ * @param channel Занятый канал
+ * @param tasks Массив задач count элементов, не на стеке: контроллер читает его до конца цепочки
+ * @param segments Участки
+ * @param count Участков, 1..DMA_TABLE_CHAIN_MAX
+ * @param peripheral true - пересылки по запросам периферии
+ */
+void DmaMgrStartChain(uint8_t channel, DmaDescriptor *tasks, const DmaSegment *segments, uint32_t count,
+                      bool peripheral) {
+    assert_param((s_uClaimed & (1UL << channel)) != 0);
+    assert_param(count != 0 && count <= DMA_TABLE_CHAIN_MAX);
+    DmaChainBuild(tasks, segments, count, peripheral);
+
+    DmaDescriptor primary;
+    DmaChainPrimary(primary, DmaMgrBusAddress(tasks), count,
+                    DmaMgrBusAddress(DmaMgrAlternate(channel)), peripheral);
+
+    DMA_Channel_SG_InitTypeDef init;
+    DMA_SG_StructInit(&init);
+    init.DMA_SG_TaskArray = reinterpret_cast<DMA_CtrlDataTypeDef *>(tasks);
+    init.DMA_SG_TaskNumber = count;
+    init.DMA_SourceProtCtrl = DMA_SourcePrivileged;
+    init.DMA_DestProtCtrl = DMA_DestPrivileged;
+    init.DMA_Priority = DMA_Priority_Default;
+    init.DMA_UseBurst = DMA_BurstClear;
+
+    uint32_t mask = 1UL << channel;
+    uint32_t primask = __get_PRIMASK();
+    __disable_irq();
+    if (s_xHandlers[channel].Callback != nullptr)
+        s_xCompletion.Armed |= mask;
+    DMA_SG_Init(channel, &init);
+    assert_param(peripheral || DmaMgrPrimary(channel)->DMA_Control == primary.Control);
+    DmaMgrPrimary(channel)->DMA_Control = primary.Control;
+    __set_PRIMASK(primask);
+}
+
+
+/**
+ * @brief Программный запрос канала: цикл авто или цепочка памяти выполняются целиком
+ */
+void DmaMgrRequest(uint8_t channel) {
+    MDR_DMA->CHNL_SW_REQUEST = 1UL << channel;
+}
+
+
+/*
+ * Общее прерывание dma_done всех каналов. Контроллер не сообщает номер канала, завершения находятся
+ * по выключенным каналам и остановленным половинам, см. DmaCompletionScan()
+ */
+extern "C" void DMA_IRQHandler() {
+    STACKPROF_ISR_ENTER();
+    BaseType_t xHigherPriorityTaskWoken = pdFALSE;
+    // До поиска: завершение цикла, запущенного обратным вызовом, снова вызовет обработчик
+    NVIC_ClearPendingIRQ(DMA_IRQn);
+    uint32_t done = DmaCompletionScan(s_xCompletion, MDR_DMA->CHNL_ENABLE_SET, Descriptors(MDR_DMA->CTRL_BASE_PTR),
+                                      Descriptors(MDR_DMA->ALT_CTRL_BASE_PTR));
+    for (; done != 0; done &= done - 1) {
+        uint8_t channel = __builtin_ctz(done);
+        const DmaMgrHandler &handler = s_xHandlers[channel];
+        if (handler.Callback != nullptr)
+            handler.Callback(channel, handler.Context, &xHigherPriorityTaskWoken);
+    }
+    portYIELD_FROM_ISR(xHigherPriorityTaskWoken);
+}
@@ -0,0 +1,71 @@
+/**
+ * @file dmamgr.h
+ * @brief Общий контроллер DMA: таблица управляющих структур, распределение каналов, обратные вызовы завершения
+ *
+ * Контроллер сбрасывается один раз при первом занятии канала, дальше каждый модуль настраивает только свои каналы.
+ * Канал периферии (SSP1/2, UART1/2, ADC, таймеры) занимается DmaMgrClaim(), программный канал без периферии -
+ * DmaMgrClaimSoftware(). Занятый канал сообщает владельца при повторном занятии.
+ *
+ * Обработчик DMA_IRQHandler принадлежит модулю. Завершение цикла, запущенного DmaMgrStart() или DmaMgrStartChain(),
+ * передаётся обратному вызову канала из прерывания, см. DmaCompletionScan(). Каналы пинг-понг, которые
+ * перезапускают половины сами по опросу, обратный вызов не задают.
+ *
+ * Управляющие структуры - SPL DMA_ControlTable, DmaMgrPrimary() и DmaMgrAlternate() дают структуры канала.
+ */
+
+#ifndef MILANDRBASE_DMAMGR_H
+#define MILANDRBASE_DMAMGR_H
+
+#include <stdint.h>
+#include <MDR32F9Qx_dma.h>
+#include <FreeRTOS.h>
+#include "dma_table.h"
+
+
+#define DMAMGR_IRQ_PREEMPTIVE_PRIORITY      (7)     ///< Вытесняющий приоритет DMA_IRQn, обратные вызовы могут вызывать API FreeRTOS
+#define DMAMGR_IRQ_SUBPRIORITY              (0)
+
+/**
+ * @brief Обратный вызов завершения, вызывается из DMA_IRQHandler
+ * @param channel Канал
+ * @param context Параметр DmaMgrSetCallback()
+ * @param pxHigherPriorityTaskWoken Для вызовов ...FromISR, обработчик завершается portYIELD_FROM_ISR
+ */
+typedef void (*DmaMgrCallback)(uint8_t channel, void *context, BaseType_t *pxHigherPriorityTaskWoken);
+
+
+void DmaMgrInit();
+bool DmaMgrClaim(uint8_t channel, const char *owner);
+uint8_t DmaMgrClaimSoftware(const char *owner);
+void DmaMgrRelease(uint8_t channel);
+void DmaMgrSetCallback(uint8_t channel, DmaMgrCallback callback, void *context, bool continuous);
+void DmaMgrStart(uint8_t channel, DMA_ChannelInitTypeDef &init);
+void DmaMgrStartDescriptor(uint8_t channel, const DmaDescriptor &primary, const DmaDescriptor *alternate = nullptr);
+void DmaMgrStartChain(uint8_t channel, DmaDescriptor *tasks, const DmaSegment *segments, uint32_t count,
+                      bool peripheral);
+void DmaMgrRequest(uint8_t channel);
+
+
+/**
+ * @brief Адрес шины DMA указателя: адреса источника и приёмника, CTRL_BASE_PTR
+ *
+ * На 1986ВЕ92 совпадает с указателем. Симулятор Sim собран без PIE, образ с буферами DMA и окна периферии лежат
+ * в младших 4 ГБ, указатель выше - ошибка, а не усечение.
+ */
+static inline uint32_t DmaMgrBusAddress(const volatile void *address) {
+    uintptr_t value = reinterpret_cast<uintptr_t>(address);
+#if (UINTPTR_MAX > UINT32_MAX)
+    assert_param(value <= UINT32_MAX);
+#endif
+    return static_cast<uint32_t>(value);
+}
+
+static inline DMA_CtrlDataTypeDef *DmaMgrPrimary(uint8_t channel) {
+    return reinterpret_cast<DMA_CtrlDataTypeDef *>(MDR_DMA->CTRL_BASE_PTR) + channel;
+}
+
+static inline DMA_CtrlDataTypeDef *DmaMgrAlternate(uint8_t channel) {
+    return reinterpret_cast<DMA_CtrlDataTypeDef *>(MDR_DMA->ALT_CTRL_BASE_PTR) + channel;
+}
+
+#endif //MILANDRBASE_DMAMGR_H
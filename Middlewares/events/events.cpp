@@ -0,0 +1,98 @@
+/**
+ * @file events.cpp
+ * @brief События драйверов на уведомлениях задач FreeRTOS
+ */
+
+#include <MDR32F9Qx_config.h>
+#include <cycleprof.h>
+#include "events.h"
+
+
+/**
+ * @brief Инициализация канала. Вызывается до разрешения прерываний драйвера
+ * @param channel Канал
+ * @param task Задача-получатель
+ * @param bits Биты события, не пересекаются с другими каналами задачи
+ * @param name Имя участка cycleprof задержки пробуждения, запоминается указатель
+ */
+void EventInit(EventChannel &channel, TaskHandle_t task, EventBits bits, const char *name) {
+    assert_param(bits != 0);
+    channel.Task = task;
+    channel.Bits = bits;
+    channel.Name = name;
+    channel.PostedAt = 0;
+    channel.ProfSite = CYCLEPROF_SITE_NONE;
+}
+
+
+/**
+ * @brief Публикация события из задачи
+ */
+void EventPost(EventChannel &channel) {
+    if (channel.Task == nullptr)
+        return;
+    channel.PostedAt = DWT->CYCCNT;
+    xTaskNotify(channel.Task, channel.Bits, eSetBits);
+}
+
+
+/**
+ * @brief Публикация события из прерывания
+ * @param channel Канал
+ * @param pxHigherPriorityTaskWoken Как у xSemaphoreGiveFromISR, обработчик завершается portYIELD_FROM_ISR
+ */
+void EventPostFromISR(EventChannel &channel, BaseType_t *pxHigherPriorityTaskWoken) {
+    if (channel.Task == nullptr)
+        return;
+    channel.PostedAt = DWT->CYCCNT;
+    xTaskNotifyFromISR(channel.Task, channel.Bits, eSetBits, pxHigherPriorityTaskWoken);
+}
+
+
+/**
+ * @brief Ожидание любого из событий текущей задачи
+ *
+ * Пришедшие биты из bits сбрасываются, остальные остаются для следующего ожидания.
+ * @param bits Ожидаемые биты
+ * @param timeout Таймаут, тиков
+ * @return Пришедшие биты из bits, 0 по таймауту
+ */
+EventBits EventWaitAny(EventBits bits, TickType_t timeout) {
+    TimeOut_t start;
+    vTaskSetTimeOutState(&start);
+    for (;;) {
+        // Значение до сброса. Уведомление между сбросом и ожиданием оставляет признак, ожидание не блокируется
+        EventBits pending = ulTaskNotifyValueClear(nullptr, bits) & bits;
+        if (pending != 0)
+            return pending;
+        if (xTaskCheckForTimeOut(&start, &timeout) != pdFALSE)
+            return 0;
+        xTaskNotifyWait(0, 0, nullptr, timeout);
+    }
+}
+
+
+/**
+ * @brief Ожидание события канала текущей задачей
+ * @param channel Канал, Task - текущая задача
+ * @param timeout Таймаут, тиков
+ * @return false по таймауту
+ */
+bool EventWait(EventChannel &channel, TickType_t timeout) {
+    if (ulTaskNotifyValueClear(nullptr, channel.Bits) & channel.Bits)
+        return true;        // Событие пришло до ожидания, задержки пробуждения нет
+    if (EventWaitAny(channel.Bits, timeout) == 0)
+        return false;
+#if (CONFIG_CYCLEPROF_ENABLE == 1)
+    CycleProfRecord(channel.ProfSite, channel.Name, DWT->CYCCNT - channel.PostedAt);
+#endif
+    return true;
+}
+
+
+/**
+ * @brief Сброс неполученного события канала, например опоздавшего после таймаута
+ */
+void EventClear(EventChannel &channel) {
+    ulTaskNotifyValueClear(channel.Task, channel.Bits);
+}
@@ -0,0 +1,44 @@
+/**
+ * @file events.h
+ * @brief События драйверов на уведомлениях задач FreeRTOS
+ *
+ * Событие - бит значения уведомления задачи-получателя (индекс 0). Драйвер публикует завершение из прерывания
+ * EventPostFromISR(), задача блокируется в EventWait() или EventWaitAny() до прихода работы. В отличие от двоичного
+ * семафора не нужен объект очереди, публикация - одна операция xTaskNotifyFromISR, а одна задача ждёт несколько
+ * источников сразу. Биты событий задачи назначает её модуль, не пришедшие в EventWaitAny() биты остаются.
+ *
+ * При CONFIG_CYCLEPROF_ENABLE задержка от публикации до пробуждения ждавшей задачи попадает в участок cycleprof
+ * с именем канала.
+ */
+
+#ifndef MILANDRBASE_EVENTS_H
+#define MILANDRBASE_EVENTS_H
+
+#include <stdint.h>
+#include <FreeRTOS.h>
+#include <task.h>
+#include "app_config.h"
+
+
+typedef uint32_t EventBits;
+
+/**
+ * @brief Канал событий: задача-получатель и её биты
+ */
+struct EventChannel {
+    TaskHandle_t Task;              ///< Задача-получатель, nullptr - публикации отбрасываются
+    EventBits    Bits;              ///< Биты события в значении уведомления задачи
+    const char  *Name;              ///< Имя участка cycleprof
+    uint32_t     PostedAt;          ///< DWT->CYCCNT последней публикации
+    uint8_t      ProfSite;          ///< Участок cycleprof, CYCLEPROF_SITE_NONE до первого замера
+};
+
+
+void EventInit(EventChannel &channel, TaskHandle_t task, EventBits bits, const char *name);
+void EventPost(EventChannel &channel);
+void EventPostFromISR(EventChannel &channel, BaseType_t *pxHigherPriorityTaskWoken);
+bool EventWait(EventChannel &channel, TickType_t timeout);
+EventBits EventWaitAny(EventBits bits, TickType_t timeout);
+void EventClear(EventChannel &channel);
+
+#endif //MILANDRBASE_EVENTS_H
@@ -0,0 +1,312 @@
+/**
+ * @file iap.cpp
+ * @brief Обработчик обновления прошивки: приём по SSP2 через DMA, стирание и запись основной flash
+ *
+ * Код выполняется из RAM (1986ve92.ld) с запрещёнными прерываниями. После IapEnter() обработчик вызывает только
+ * функции этого файла, iap_engine.cpp и MDR32F9Qx_eeprom.c и обращается к периферии через регистры:
+ * SPL SSP и DMA, как и весь остальной код, лежат во flash.
+ */
+
+#include <MDR32F9Qx_config.h>
+#include <MDR32F9Qx_rst_clk.h>
+#include <MDR32F9Qx_ssp.h>
+#include <MDR32F9Qx_dma.h>
+#include <MDR32F9Qx_eeprom.h>
+#include <FreeRTOS.h>
+#include "iap.h"
+
+#include "log_levels.h"
+#define LOG_LOCAL_LEVEL LOG_TAG_IAP_LOCAL_LEVEL
+#include <mdr_log.h>
+static const char *TAG = "IAP";
+
+static_assert(DMA_AlternateData == 1, "IAP DMA ping-pong requires alternate control data");
+static_assert(CONFIG_IAP_DMA_HALF <= 1024, "IAP DMA half must fit one DMA cycle");
+static_assert(CONFIG_IAP_RING_SIZE % 4 == 0 && CONFIG_IAP_RING_SIZE >= IAP_FRAME_DATA, "IAP ring size");
+static_assert(CONFIG_IAP_SIZE % CONFIG_IAP_PAGE_SIZE == 0, "IAP area must be whole pages");
+
+#define IAP_SSP                 MDR_SSP2
+#define IAP_DMA_CHANNEL         DMA_Channel_SSP2_RX
+#define DMA_CYCLE_CTRL_Msk      (0x07UL)
+#define DMA_N_MINUS_1_Pos       (4U)
+#define DMA_N_MINUS_1_Msk       (0x3FFUL << DMA_N_MINUS_1_Pos)
+
+// Ключ доступа к регистрам EEPROM, в SPL объявлен только в MDR32F9Qx_eeprom.c
+#define IAP_EEPROM_KEY          (0x8AAA5551UL)
+#define IAP_ERASE_SECTORS       (4)                         ///< Страница стирается по 4 секторам, как EEPROM_ErasePage()
+
+
+/**
+ * @brief Приём кадров и кольцо данных, выделяются из кучи FreeRTOS при входе
+ */
+struct IapLink {
+    IapEngine   Engine;
+    uint8_t     Half;                                       ///< Половина, в которую сейчас пишет DMA: 0 - primary
+    uint32_t    Consumed;                                   ///< Байт этой половины уже переданы в IapFeed()
+    uint32_t    DmaControl;                                 ///< Управляющее слово DMA для перезапуска половины
+    uint32_t    Overruns;                                   ///< DMA заполнил обе половины, байты SSP потеряны
+    uint8_t     Rx[2][CONFIG_IAP_DMA_HALF];
+    uint8_t     Ring[CONFIG_IAP_RING_SIZE];
+};
+
+/**
+ * @brief Стирание страницы по шагам EEPROM_ErasePage() без ожидания в цикле
+ */
+struct IapErase {
+    bool        Busy;
+    uint32_t    Address;
+    uint32_t    Command;                                    ///< Текущее значение MDR_EEPROM->CMD
+    uint8_t     Sector;
+    uint8_t     Step;
+    uint32_t    Deadline;                                   ///< Время следующего шага, такты SysTick
+};
+
+static IapErase s_xErase;
+static uint32_t s_uNow;                                     ///< Такты от входа, SysTick считает вниз 24 бита
+static uint32_t s_uSysTick;
+static uint32_t s_uTicksPerUs;
+
+
+/*
+ * Вызывается чаще, чем SysTick обходит 2^24 тактов: ~200 мс на 80 МГц, самый долгий шаг цикла - запись слова
+ */
+static uint32_t Now() {
+    uint32_t value = SysTick->VAL;
+    s_uNow += (s_uSysTick - value) & SysTick_LOAD_RELOAD_Msk;
+    s_uSysTick = value;
+    return s_uNow;
+}
+
+static inline bool Elapsed(uint32_t deadline) {
+    return static_cast<int32_t>(Now() - deadline) >= 0;
+}
+
+
+static uint32_t FlashRead(uint32_t address) {
+    return EEPROM_ReadWord(address, EEPROM_Main_Bank_Select);
+}
+
+static void FlashProgram(uint32_t address, uint32_t data) {
+    EEPROM_ProgramWord(address, EEPROM_Main_Bank_Select, data);
+}
+
+
+/*
+ * Шаги сектора как в EEPROM_ErasePage(): XE|ERASE 5 мкс, NVSTR 40 мс, снять ERASE 5 мкс, снять XE|NVSTR 1 мкс.
+ * После четырёх секторов - выход из режима программирования и 4 мс до чтения flash
+ */
+static void EraseStep(IapErase &erase) {
+    uint32_t wait;
+    switch (erase.Step) {
+        case 0:
+            MDR_EEPROM->ADR = erase.Address + erase.Sector * 4;
+            MDR_EEPROM->DI = 0;
+            erase.Command |= EEPROM_CMD_XE | EEPROM_CMD_ERASE;
+            wait = 5;
+            break;
+        case 1:
+            erase.Command |= EEPROM_CMD_NVSTR;
+            wait = 40000;
+            break;
+        case 2:
+            erase.Command &= ~EEPROM_CMD_ERASE;
+            wait = 5;
+            break;
+        case 3:
+            erase.Command &= ~(EEPROM_CMD_XE | EEPROM_CMD_NVSTR);
+            wait = 1;
+            if (++erase.Sector < IAP_ERASE_SECTORS)
+                erase.Step = 0xFF;
+            break;
+        case 4:
+            erase.Command &= EEPROM_CMD_DELAY_Msk;
+            MDR_EEPROM->CMD = erase.Command;
+            MDR_EEPROM->KEY = 0;
+            erase.Step++;
+            erase.Deadline = Now() + 4000 * s_uTicksPerUs;
+            return;
+        default:
+            erase.Busy = false;
+            return;
+    }
+    MDR_EEPROM->CMD = erase.Command;
+    erase.Step++;
+    erase.Deadline = Now() + wait * s_uTicksPerUs;
+}
+
+static void FlashEraseStart(uint32_t address) {
+    IapErase &erase = s_xErase;
+    MDR_EEPROM->KEY = IAP_EEPROM_KEY;
+    erase.Command = (MDR_EEPROM->CMD & EEPROM_CMD_DELAY_Msk) | EEPROM_CMD_CON;
+    MDR_EEPROM->CMD = erase.Command;
+    erase.Busy = true;
+    erase.Address = address;
+    erase.Sector = 0;
+    erase.Step = 0;
+    EraseStep(erase);
+}
+
+static bool FlashEraseBusy() {
+    IapErase &erase = s_xErase;
+    while (erase.Busy && Elapsed(erase.Deadline))
+        EraseStep(erase);
+    return erase.Busy;
+}
+
+static const IapFlash s_xFlash = {CONFIG_IAP_BASE, CONFIG_IAP_SIZE, CONFIG_IAP_PAGE_SIZE,
+                                  FlashRead, FlashProgram, FlashEraseStart, FlashEraseBusy};
+
+
+static inline DMA_CtrlDataTypeDef *PrimaryData(uint8_t channel) {
+    return reinterpret_cast<DMA_CtrlDataTypeDef *>(MDR_DMA->CTRL_BASE_PTR) + channel;
+}
+
+static inline DMA_CtrlDataTypeDef *AlternateData(uint8_t channel) {
+    return reinterpret_cast<DMA_CtrlDataTypeDef *>(MDR_DMA->ALT_CTRL_BASE_PTR) + channel;
+}
+
+// Как DmaMgrBusAddress(): в симуляторе указатель выше 4 ГБ - ошибка, а не усечение
+static inline uint32_t BusAddress(const volatile void *address) {
+    uintptr_t value = reinterpret_cast<uintptr_t>(address);
+#if (UINTPTR_MAX > UINT32_MAX)
+    assert_param(value <= UINT32_MAX);
+#endif
+    return static_cast<uint32_t>(value);
+}
+
+
+/*
+ * Вызывается до запрета доступа к flash: SPL DMA во flash
+ */
+static void InitLink(IapLink &link) {
+    link.Half = 0;
+    link.Consumed = 0;
+    link.Overruns = 0;
+
+    DMA_CtrlDataInitTypeDef primary;
+    primary.DMA_SourceBaseAddr = BusAddress(&IAP_SSP->DR);
+    primary.DMA_DestBaseAddr = BusAddress(link.Rx[0]);
+    primary.DMA_SourceIncSize = DMA_SourceIncNo;
+    primary.DMA_DestIncSize = DMA_DestIncByte;
+    primary.DMA_MemoryDataSize = DMA_MemoryDataSize_Byte;
+    primary.DMA_Mode = DMA_Mode_PingPong;
+    primary.DMA_CycleSize = CONFIG_IAP_DMA_HALF;
+    primary.DMA_NumContinuous = DMA_Transfers_1;
+    primary.DMA_SourceProtCtrl = DMA_SourcePrivileged;
+    primary.DMA_DestProtCtrl = DMA_DestPrivileged;
+
+    DMA_CtrlDataInitTypeDef alternate = primary;
+    alternate.DMA_DestBaseAddr = BusAddress(link.Rx[1]);
+
+    DMA_ChannelInitTypeDef channel;
+    DMA_StructInit(&channel);
+    channel.DMA_PriCtrlData = &primary;
+    channel.DMA_AltCtrlData = &alternate;
+    channel.DMA_Priority = DMA_Priority_High;
+    channel.DMA_UseBurst = DMA_BurstClear;
+    channel.DMA_SelectDataStructure = DMA_CTRL_DATA_PRIMARY;
+    DMA_Init(IAP_DMA_CHANNEL, &channel);
+    link.DmaControl = PrimaryData(IAP_DMA_CHANNEL)->DMA_Control;
+
+    // Остаток команды SVC в FIFO приёмника не относится к потоку кадров
+    while (IAP_SSP->SR & SSP_SR_RNE)
+        (void)IAP_SSP->DR;
+    IAP_SSP->DMACR = SSP_DMACR_RXDMAE;
+}
+
+
+/*
+ * Принятые DMA байты в порядке приёма. Заполненная половина перезапускается, пока DMA пишет в другую; текущая
+ * половина читается по n_minus_1 управляющего слова, иначе хвост пачки кадров ждал бы следующей передачи
+ */
+static void Receive(IapLink &link) {
+    uint32_t mask = 1UL << IAP_DMA_CHANNEL;
+    bool stopped = (MDR_DMA->CHNL_ENABLE_SET & mask) == 0;
+
+    for (uint32_t i = 0; i < 2; i++) {
+        DMA_CtrlDataTypeDef *half = link.Half ? AlternateData(IAP_DMA_CHANNEL) : PrimaryData(IAP_DMA_CHANNEL);
+        uint32_t control = half->DMA_Control;
+        uint32_t done = CONFIG_IAP_DMA_HALF;
+        if ((control & DMA_CYCLE_CTRL_Msk) != DMA_Mode_Stop)
+            done = CONFIG_IAP_DMA_HALF - 1 - ((control & DMA_N_MINUS_1_Msk) >> DMA_N_MINUS_1_Pos);
+
+        if (done > link.Consumed) {
+            IapFeed(link.Engine, link.Rx[link.Half] + link.Consumed, done - link.Consumed);
+            link.Consumed = done;
+        }
+        if (done < CONFIG_IAP_DMA_HALF)
+            break;
+        half->DMA_Control = link.DmaControl;
+        link.Half ^= 1;
+        link.Consumed = 0;
+    }
+
+    if (stopped) {
+        link.Overruns++;
+        if (link.Half)
+            MDR_DMA->CHNL_PRI_ALT_SET = mask;
+        else
+            MDR_DMA->CHNL_PRI_ALT_CLR = mask;
+        MDR_DMA->CHNL_ENABLE_SET = mask;
+    }
+}
+
+
+/*
+ * Ответ кладётся целиком в пустой FIFO передатчика: хост вычитывает его следующей транзакцией. Пока хост передаёт
+ * кадры, FIFO уходит вместе с ними и заполняется снова
+ */
+static void Answer(IapLink &link) {
+    if ((IAP_SSP->SR & SSP_SR_TFE) == 0)
+        return;
+    uint8_t reply[IAP_REPLY_SIZE];
+    IapReply(link.Engine, reply);
+    for (uint32_t i = 0; i < IAP_REPLY_SIZE; i++)
+        IAP_SSP->DR = reply[i];
+}
+
+
+static void __attribute__((noreturn)) Run(IapLink &link) {
+    for (;;) {
+        Receive(link);
+        IapPoll(link.Engine);
+        Answer(link);
+        if (link.Engine.ResetRequested && !link.Engine.Erasing && (IAP_SSP->SR & SSP_SR_BSY) == 0)
+            NVIC_SystemReset();
+    }
+}
+
+
+/**
+ * @brief Переход в режим обновления
+ *
+ * Вызывается из задачи SSPSlave после записи LF_SVC_UPDATE, SSP2 уже настроен ведомым. Каналы DMA других
+ * модулей останавливаются, SysTick перезапускается без прерывания как счётчик тактов.
+ *
+ * @return false, если не хватило памяти; при успехе не возвращается
+ */
+bool IapEnter() {
+    auto link = static_cast<IapLink *>(pvPortMalloc(sizeof(IapLink)));
+    if (link == nullptr) {
+        MDR_LOGW(TAG, "No memory for update buffers, %u bytes", static_cast<unsigned>(sizeof(IapLink)));
+        return false;
+    }
+    MDR_LOGI(TAG, "Update mode: flash 0x%08lX..0x%08lX", CONFIG_IAP_BASE, CONFIG_IAP_BASE + CONFIG_IAP_SIZE);
+
+    RST_CLK_PCLKcmd(RST_CLK_PCLK_EEPROM | RST_CLK_PCLK_DMA | RST_CLK_PCLK_SSP2, ENABLE);
+    __disable_irq();
+    MDR_DMA->CHNL_ENABLE_CLR = 0xFFFFFFFF;
+
+    SysTick->CTRL = 0;
+    SysTick->LOAD = SysTick_LOAD_RELOAD_Msk;
+    SysTick->VAL = 0;
+    SysTick->CTRL = SysTick_CTRL_CLKSOURCE_Msk | SysTick_CTRL_ENABLE_Msk;
+    s_uNow = 0;
+    s_uSysTick = SysTick->VAL;
+    s_uTicksPerUs = SystemCoreClock / 1000000;
+    s_xErase.Busy = false;
+
+    IapInit(link->Engine, s_xFlash, link->Ring, CONFIG_IAP_RING_SIZE);
+    InitLink(*link);
+    Run(*link);
+}
@@ -0,0 +1,22 @@
+/**
+ * @file iap.h
+ * @brief Обновление прошивки по SPI из приложения
+ *
+ * Вход - запись бита LF_SVC_UPDATE в регистр SVC. Дальше НЧ драйвер работает только на обновление: прерывания
+ * запрещены, FreeRTOS и USB остановлены, цикл обработчика и всё, что он вызывает, выполняется из RAM
+ * (iap.cpp, iap_engine.cpp и MDR32F9Qx_eeprom.c размещены в .data в 1986ve92.ld). Кадры от хоста принимает DMA
+ * из SSP2 в две половины буфера, ответ кладётся в FIFO передатчика SSP2. Протокол - iap_engine.h.
+ *
+ * Выход только сбросом: IAP_CMD_RESET от хоста после записи образа или внешний сброс. При неудаче старая
+ * прошивка частично стёрта, повторить обновление можно сразу, не выходя из режима.
+ */
+
+#ifndef MILANDRBASE_IAP_H
+#define MILANDRBASE_IAP_H
+
+#include "iap_engine.h"
+
+
+bool IapEnter();
+
+#endif //MILANDRBASE_IAP_H
@@ -0,0 +1,323 @@
+/**
+ * @file iap_engine.cpp
+ * @brief Протокол и планировщик страниц обновления прошивки из приложения
+ *
+ * Код выполняется из RAM, пока flash стирается и пишется (1986ve92.ld), поэтому вызывает только IapFlash
+ * и не использует библиотечные функции: копирование и заполнение - циклами по байтам.
+ */
+
+#include <MDR32F9Qx_config.h>
+#include "iap_engine.h"
+
+
+/*
+ * CRC-32/MPEG-2 по полубайтам, полином 0x04C11DB7: таблица 64 байта, а не 1 КиБ, она тоже лежит в RAM
+ */
+static const uint32_t Crc32Nibble[16] = {
+        0x00000000, 0x04C11DB7, 0x09823B6E, 0x0D4326D9, 0x130476DC, 0x17C56B6B, 0x1A864DB2, 0x1E475005,
+        0x2608EDB8, 0x22C9F00F, 0x2F8AD6D6, 0x2B4BCB61, 0x350C9B64, 0x31CD86D3, 0x3C8EA00A, 0x384FBDBD,
+};
+
+
+static inline uint32_t LoadWord(const uint8_t *data) {
+    return data[0] | (static_cast<uint32_t>(data[1]) << 8) | (static_cast<uint32_t>(data[2]) << 16) |
+           (static_cast<uint32_t>(data[3]) << 24);
+}
+
+static inline uint32_t PageEnd(const IapFlash &flash, uint32_t size) {
+    return (size + flash.PageSize - 1) / flash.PageSize * flash.PageSize;
+}
+
+
+/**
+ * @brief CRC-32/MPEG-2, как crc-32-mpeg в Tools/append_crc.py
+ * @param crc Начальное значение 0xFFFFFFFF или результат предыдущего вызова
+ * @return CRC без финального XOR
+ */
+uint32_t IapCrc32(uint32_t crc, const uint8_t *data, uint32_t size) {
+    for (uint32_t i = 0; i < size; i++) {
+        crc = (crc << 4) ^ Crc32Nibble[(crc >> 28) ^ (data[i] >> 4)];
+        crc = (crc << 4) ^ Crc32Nibble[(crc >> 28) ^ (data[i] & 0x0F)];
+    }
+    return crc;
+}
+
+
+/**
+ * @brief Начальное состояние, flash не трогается до IAP_CMD_BEGIN
+ * @param ring Кольцо принятых данных, ringSize кратен 4
+ */
+void IapInit(IapEngine &iap, const IapFlash &flash, uint8_t *ring, uint32_t ringSize) {
+    assert_param(ringSize >= IAP_FRAME_DATA && ringSize % 4 == 0);
+    assert_param(flash.Size % flash.PageSize == 0);
+
+    iap.Flash = &flash;
+    iap.Ring = ring;
+    iap.RingSize = ringSize;
+    iap.State = IAP_IDLE;
+    iap.Status = IAP_OK;
+    iap.Sequence = 0;
+    iap.Erasing = false;
+    iap.ResetRequested = false;
+    iap.ImageSize = 0;
+    iap.Received = 0;
+    iap.Programmed = 0;
+    iap.Erased = 0;
+    iap.EraseEnd = 0;
+    iap.Verified = 0;
+    iap.Crc = 0;
+    iap.FrameFill = 0;
+    iap.Stats.Frames = 0;
+    iap.Stats.BadFrames = 0;
+    iap.Stats.Busy = 0;
+    iap.Stats.Erases = 0;
+    iap.Stats.Programs = 0;
+    iap.Stats.Skipped = 0;
+}
+
+
+/**
+ * @brief Свободно байт в кольце
+ */
+uint32_t IapFree(const IapEngine &iap) {
+    return iap.RingSize - (iap.Received - iap.Programmed);
+}
+
+
+static IapStatus Begin(IapEngine &iap, uint32_t size) {
+    const IapFlash &flash = *iap.Flash;
+    if (iap.Erasing)
+        return IAP_BUSY;
+    if (size < 8 || size % 4 || size > flash.Size)
+        return IAP_BAD_SIZE;
+
+    iap.State = IAP_RECEIVING;
+    iap.ImageSize = size;
+    iap.Received = 0;
+    iap.Programmed = 0;
+    iap.Erased = 0;
+    iap.EraseEnd = PageEnd(flash, size);
+    iap.Verified = 0;
+    return IAP_OK;
+}
+
+
+/*
+ * Повтор уже принятых данных подтверждается: хост после потерянного ответа передаёт их снова
+ */
+static IapStatus Data(IapEngine &iap, uint32_t offset, const uint8_t *data, uint32_t length) {
+    if (iap.State != IAP_RECEIVING)
+        return IAP_BAD_STATE;
+    if (length == 0 || length > IAP_FRAME_DATA || length % 4 || offset % 4 || offset + length > iap.ImageSize)
+        return IAP_BAD_FRAME;
+    if (offset + length <= iap.Received)
+        return IAP_OK;
+    if (offset > iap.Received)
+        return IAP_BAD_OFFSET;
+
+    uint32_t skip = iap.Received - offset;
+    if (length - skip > IapFree(iap)) {
+        iap.Stats.Busy++;
+        return IAP_BUSY;
+    }
+    for (uint32_t i = skip; i < length; i++) {
+        iap.Ring[iap.Received % iap.RingSize] = data[i];
+        iap.Received++;
+    }
+    return IAP_OK;
+}
+
+
+static bool FrameValid(const uint8_t *frame) {
+    return frame[0] == IAP_FRAME_SYNC &&
+           IapCrc32(0xFFFFFFFFUL, frame, IAP_FRAME_SIZE - 4) == LoadWord(frame + IAP_FRAME_SIZE - 4);
+}
+
+
+static IapStatus Handle(IapEngine &iap, const uint8_t *frame) {
+    iap.Stats.Frames++;
+    iap.Sequence = frame[2];
+    uint32_t argument = LoadWord(frame + 4);
+    switch (frame[1]) {
+        case IAP_CMD_BEGIN:
+            iap.Status = Begin(iap, argument);
+            break;
+        case IAP_CMD_DATA:
+            iap.Status = Data(iap, argument, frame + IAP_FRAME_HEADER, frame[3]);
+            break;
+        case IAP_CMD_STATUS:
+            iap.Status = IAP_OK;
+            break;
+        case IAP_CMD_RESET:
+            iap.ResetRequested = true;
+            iap.Status = IAP_OK;
+            break;
+        default:
+            iap.Status = IAP_BAD_FRAME;
+            break;
+    }
+    return iap.Status;
+}
+
+
+/**
+ * @brief Обработка кадра
+ * @param frame IAP_FRAME_SIZE байт
+ * @return Результат, он же попадает в ответ
+ */
+IapStatus IapHandleFrame(IapEngine &iap, const uint8_t *frame) {
+    if (!FrameValid(frame)) {
+        iap.Stats.BadFrames++;
+        iap.Status = IAP_BAD_FRAME;
+        return iap.Status;
+    }
+    return Handle(iap, frame);
+}
+
+
+/**
+ * @brief Байты потока от хоста, границы транзакций не важны
+ */
+void IapFeed(IapEngine &iap, const uint8_t *data, uint32_t size) {
+    for (uint32_t i = 0; i < size; i++) {
+        if (iap.FrameFill == 0 && data[i] != IAP_FRAME_SYNC)
+            continue;
+        iap.Frame[iap.FrameFill++] = data[i];
+        if (iap.FrameFill < IAP_FRAME_SIZE)
+            continue;
+
+        if (FrameValid(iap.Frame)) {
+            Handle(iap, iap.Frame);
+            iap.FrameFill = 0;
+            continue;
+        }
+        iap.Stats.BadFrames++;
+        iap.Status = IAP_BAD_FRAME;
+
+        // Синхробайт оказался в данных или кадр потерял байты: поиск со следующего синхробайта среди принятых
+        uint32_t next = 1;
+        while (next < IAP_FRAME_SIZE && iap.Frame[next] != IAP_FRAME_SYNC)
+            next++;
+        iap.FrameFill = IAP_FRAME_SIZE - next;
+        for (uint32_t j = 0; j < iap.FrameFill; j++)
+            iap.Frame[j] = iap.Frame[next + j];
+    }
+}
+
+
+static bool Fail(IapEngine &iap, IapStatus status) {
+    iap.State = IAP_FAILED;
+    iap.Status = status;
+    return false;
+}
+
+
+/*
+ * Следующее слово из кольца, если оно принято и его страница стёрта. Стёртые слова пропускаются пачкой
+ */
+static bool ProgramNext(IapEngine &iap) {
+    const IapFlash &flash = *iap.Flash;
+    for (uint32_t skipped = 0; skipped < IAP_SKIP_WORDS; skipped++) {
+        if (iap.Programmed >= iap.Received || iap.Programmed >= iap.Erased)
+            return skipped != 0;
+
+        uint32_t word = LoadWord(iap.Ring + iap.Programmed % iap.RingSize);
+        uint32_t address = flash.Base + iap.Programmed;
+        iap.Programmed += 4;
+        if (word == IAP_ERASED_WORD) {
+            iap.Stats.Skipped++;
+            continue;
+        }
+
+        flash.Program(address, word);
+        iap.Stats.Programs++;
+        if (flash.Read(address) != word)
+            return Fail(iap, IAP_PROGRAM_ERROR);
+        return true;
+    }
+    return true;
+}
+
+
+static bool Verify(IapEngine &iap) {
+    const IapFlash &flash = *iap.Flash;
+    uint32_t end = iap.ImageSize - 4;
+    for (uint32_t i = 0; i < IAP_VERIFY_WORDS && iap.Verified < end; i++) {
+        uint32_t word = flash.Read(flash.Base + iap.Verified);
+        uint8_t bytes[4] = {static_cast<uint8_t>(word), static_cast<uint8_t>(word >> 8),
+                            static_cast<uint8_t>(word >> 16), static_cast<uint8_t>(word >> 24)};
+        iap.Crc = IapCrc32(iap.Crc, bytes, 4);
+        iap.Verified += 4;
+    }
+    if (iap.Verified < end)
+        return true;
+
+    if (flash.Read(flash.Base + end) != iap.Crc)
+        return Fail(iap, IAP_VERIFY_ERROR);
+    iap.State = IAP_DONE;
+    return false;
+}
+
+
+/**
+ * @brief Один шаг работы с flash: запись слова, шаг стирания или часть проверки CRC
+ *
+ * Вызывается в цикле обработчика вперемешку с приёмом кадров. Запись слова блокирует на время
+ * EEPROM_ProgramWord, стирание - нет.
+ *
+ * @return true, если работа есть сейчас; false - ждёт данных или обновление закончено
+ */
+bool IapPoll(IapEngine &iap) {
+    const IapFlash &flash = *iap.Flash;
+    if (iap.Erasing) {
+        if (flash.EraseBusy())
+            return true;
+        iap.Erasing = false;
+        iap.Erased += flash.PageSize;
+        iap.Stats.Erases++;
+    }
+
+    if (iap.State == IAP_VERIFYING)
+        return Verify(iap);
+    if (iap.State != IAP_RECEIVING)
+        return false;
+
+    if (ProgramNext(iap))
+        return iap.State == IAP_RECEIVING;
+    if (iap.State != IAP_RECEIVING)
+        return false;
+
+    // Данных для стёртых страниц нет: стирание следующей страницы, пока хост передаёт
+    if (iap.Erased < iap.EraseEnd) {
+        flash.EraseStart(flash.Base + iap.Erased);
+        iap.Erasing = true;
+        return true;
+    }
+    if (iap.Programmed < iap.ImageSize)
+        return false;
+
+    iap.State = IAP_VERIFYING;
+    iap.Verified = 0;
+    iap.Crc = 0xFFFFFFFFUL;
+    return true;
+}
+
+
+/**
+ * @brief Ответ хосту, IAP_REPLY_SIZE байт
+ */
+void IapReply(const IapEngine &iap, uint8_t *reply) {
+    uint32_t received = iap.Received / 4;
+    uint32_t free = IapFree(iap) / 4;
+    if (free > 0xFFFF)
+        free = 0xFFFF;
+
+    reply[0] = IAP_REPLY_SYNC;
+    reply[1] = iap.Sequence;
+    reply[2] = static_cast<uint8_t>(iap.Status | (iap.State << 4));
+    reply[3] = static_cast<uint8_t>(received);
+    reply[4] = static_cast<uint8_t>(received >> 8);
+    reply[5] = static_cast<uint8_t>(free);
+    reply[6] = static_cast<uint8_t>(free >> 8);
+    reply[7] = static_cast<uint8_t>(IapCrc32(0xFFFFFFFFUL, reply, IAP_REPLY_SIZE - 1));
+}
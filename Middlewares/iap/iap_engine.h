@@ -0,0 +1,142 @@
+/**
+ * @file iap_engine.h
+ * @brief Протокол и планировщик страниц обновления прошивки из приложения
+ *
+ * Образ - файл .bin после Tools/append_crc.py: дополнен 0xFF до размера области, в последнем слове CRC-32/MPEG-2
+ * (полином 0x04C11DB7, начальное 0xFFFFFFFF, без отражения и финального XOR) всех предыдущих байт, little-endian.
+ *
+ * Хост передаёт образ кадрами по IAP_FRAME_SIZE байт, поток кадров не привязан к транзакциям: ищется IAP_FRAME_SYNC,
+ * кадр с неверной CRC отбрасывается и поиск продолжается со следующего байта. Кадр:
+ *  - [0] IAP_FRAME_SYNC, [1] команда IapCommand, [2] номер кадра, [3] байт данных в [8..59]
+ *  - [4..7] аргумент: IAP_CMD_BEGIN - размер образа, IAP_CMD_DATA - смещение данных в образе
+ *  - [60..63] CRC-32/MPEG-2 байт [0..59]
+ *
+ * Ответ - IAP_REPLY_SIZE байт, ровно FIFO передатчика SSP: [0] IAP_REPLY_SYNC, [1] номер последнего принятого кадра,
+ * [2] IapStatus | IapState << 4, [3..4] принято слов подряд с начала образа, [5..6] свободно слов в кольце,
+ * [7] младший байт CRC-32/MPEG-2 байт [0..6].
+ *
+ * Принятые данные копируются в кольцо, flash пишется из кольца по слову за вызов IapPoll(). Контроллер flash один:
+ * стирание и запись не идут одновременно, поэтому время обновления снизу ограничено суммой стираний страниц
+ * образа и записей его слов. Планировщик держит контроллер занятым: если следующее слово уже принято и его
+ * страница стёрта - пишет слово, иначе заранее стирает следующую страницу, пока хост передаёт данные.
+ * Слова 0xFFFFFFFF после стирания не пишутся, хвост образа из заполнения стоит только стирания. После записи
+ * последнего слова CRC образа считается по flash и сравнивается с последним словом.
+ *
+ * Стирание разбито на EraseStart() и опрос EraseBusy(): ~160 мс стирания страницы обработчик принимает кадры.
+ * Модуль обращается к flash только через IapFlash, не использует memcpy и собирается в хостовых тестах.
+ */
+
+#ifndef MILANDRBASE_IAP_ENGINE_H
+#define MILANDRBASE_IAP_ENGINE_H
+
+#include <stdint.h>
+
+
+#define IAP_FRAME_SIZE          (64)
+#define IAP_FRAME_SYNC          (0x5AU)
+#define IAP_FRAME_HEADER        (8)                         ///< Байт до данных кадра
+#define IAP_FRAME_DATA          (52)                        ///< Наибольшее число байт данных в кадре
+#define IAP_REPLY_SIZE          (8)
+#define IAP_REPLY_SYNC          (0xA5U)
+#define IAP_ERASED_WORD         (0xFFFFFFFFUL)
+#define IAP_SKIP_WORDS          (64)                        ///< Слов 0xFFFFFFFF, пропускаемых за один IapPoll()
+#define IAP_VERIFY_WORDS        (64)                        ///< Слов CRC образа за один IapPoll()
+
+static_assert(IAP_FRAME_HEADER + IAP_FRAME_DATA + 4 == IAP_FRAME_SIZE, "IAP frame layout");
+static_assert(IAP_FRAME_DATA % 4 == 0, "IAP frame data must be whole words");
+
+
+/**
+ * @brief Команды кадра
+ */
+enum IapCommand {
+    IAP_CMD_BEGIN   = 0x01,         ///< Начало обновления, аргумент - размер образа
+    IAP_CMD_DATA    = 0x02,         ///< Данные образа со смещения аргумента
+    IAP_CMD_STATUS  = 0x03,         ///< Только обновить ответ
+    IAP_CMD_RESET   = 0x04,         ///< Сброс контроллера, выполняет обработчик
+};
+
+/**
+ * @brief Результат последнего кадра
+ */
+enum IapStatus {
+    IAP_OK = 0,
+    IAP_BUSY,                       ///< В кольце нет места, кадр не принят
+    IAP_BAD_FRAME,                  ///< Неверная CRC, длина или команда
+    IAP_BAD_OFFSET,                 ///< Смещение дальше принятого, повторить с принятого
+    IAP_BAD_SIZE,                   ///< Размер образа не кратен слову или больше области
+    IAP_BAD_STATE,                  ///< Данные без IAP_CMD_BEGIN
+    IAP_PROGRAM_ERROR,              ///< Слово не совпало после записи
+    IAP_VERIFY_ERROR,               ///< CRC образа во flash не совпала с последним словом
+};
+
+/**
+ * @brief Состояние обновления
+ */
+enum IapState {
+    IAP_IDLE = 0,                   ///< Ждёт IAP_CMD_BEGIN, flash не тронута
+    IAP_RECEIVING,                  ///< Приём, стирание и запись
+    IAP_VERIFYING,                  ///< Всё записано, считается CRC
+    IAP_DONE,                       ///< Образ записан и проверен
+    IAP_FAILED,                     ///< Ошибка записи или проверки, можно начать заново
+};
+
+/**
+ * @brief Доступ к области образа во flash
+ */
+struct IapFlash {
+    uint32_t    Base;                                       ///< Начало области образа
+    uint32_t    Size;                                       ///< Размер области, байт
+    uint32_t    PageSize;                                   ///< Размер страницы, байт
+    uint32_t    (*Read)(uint32_t address);                  ///< Чтение слова
+    void        (*Program)(uint32_t address, uint32_t data);    ///< Запись стёртого слова
+    void        (*EraseStart)(uint32_t address);            ///< Начало стирания страницы
+    bool        (*EraseBusy)();                             ///< Стирание не закончено, продвигает его шаги
+};
+
+/**
+ * @brief Счётчики работы
+ */
+struct IapStats {
+    uint32_t Frames;                ///< Принято кадров
+    uint32_t BadFrames;             ///< Кадров с неверной CRC или форматом
+    uint32_t Busy;                  ///< Кадров, отклонённых из-за заполненного кольца
+    uint32_t Erases;                ///< Стёрто страниц
+    uint32_t Programs;              ///< Записано слов
+    uint32_t Skipped;               ///< Слов 0xFFFFFFFF, не требующих записи
+};
+
+/**
+ * @brief Состояние обновления
+ */
+struct IapEngine {
+    const IapFlash *Flash;
+    uint8_t        *Ring;                                   ///< Кольцо принятых данных
+    uint32_t        RingSize;                               ///< Размер кольца, кратен 4
+    IapState        State;
+    IapStatus       Status;                                 ///< Результат последнего кадра
+    uint8_t         Sequence;                               ///< Номер последнего кадра с верной CRC
+    bool            Erasing;                                ///< Идёт стирание страницы по смещению Erased
+    bool            ResetRequested;                         ///< Принят IAP_CMD_RESET
+    uint32_t        ImageSize;
+    uint32_t        Received;                               ///< Принято байт подряд с начала образа
+    uint32_t        Programmed;                             ///< Записано байт, из кольца ушли
+    uint32_t        Erased;                                 ///< Стёрто байт с начала области
+    uint32_t        EraseEnd;                               ///< Конец стирания, образ до границы страницы
+    uint32_t        Verified;                               ///< Байт образа, вошедших в Crc
+    uint32_t        Crc;                                    ///< CRC образа во flash
+    uint8_t         Frame[IAP_FRAME_SIZE];                  ///< Собираемый кадр
+    uint32_t        FrameFill;
+    IapStats        Stats;
+};
+
+
+uint32_t IapCrc32(uint32_t crc, const uint8_t *data, uint32_t size);
+void IapInit(IapEngine &iap, const IapFlash &flash, uint8_t *ring, uint32_t ringSize);
+void IapFeed(IapEngine &iap, const uint8_t *data, uint32_t size);
+IapStatus IapHandleFrame(IapEngine &iap, const uint8_t *frame);
+bool IapPoll(IapEngine &iap);
+void IapReply(const IapEngine &iap, uint8_t *reply);
+uint32_t IapFree(const IapEngine &iap);
+
+#endif //MILANDRBASE_IAP_ENGINE_H
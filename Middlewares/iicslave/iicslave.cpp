@@ -5,6 +5,7 @@
 
 #include <bitbanding.h>
 #include <MDR32F9Qx_rst_clk.h>
+#include "app_config.h"
 #include "iicslave.h"
 
 
@@ -79,6 +80,10 @@ void IICSlaveInit(IICSlave &slave, MDR_TIMER_TypeDef *timer, MDR_PORT_TypeDef *p
     slave.hw.SDAFallFlag = (TimerIEMask(timerSDAChannel) << TIMER_IE_CCR1_CAP_EVENT_IE_Pos);
     slave.hw.SCLRiseFlag = (TimerIEMask(timerSCLChannel) << TIMER_IE_CCR_CAP_EVENT_IE_Pos);
     slave.hw.SCLFallFlag = (TimerIEMask(timerSCLChannel) << TIMER_IE_CCR1_CAP_EVENT_IE_Pos);
+    slave.hw.SDARiseCCR = &timer->CCR1 + timerSDAChannel;
+    slave.hw.SDAFallCCR = &timer->CCR11 + timerSDAChannel;
+    slave.hw.SCLRiseCCR = &timer->CCR1 + timerSCLChannel;
+    slave.hw.SCLFallCCR = &timer->CCR11 + timerSCLChannel;
 
     InitTimer(timer, timerSDAChannel, timerSCLChannel,
               slave.hw.SDARiseFlag | slave.hw.SDAFallFlag | slave.hw.SCLRiseFlag | slave.hw.SCLFallFlag);
@@ -214,7 +219,11 @@ static void InitTimer(MDR_TIMER_TypeDef *timer,
 
     timer->CNT = 0;
     timer->PSG = 0;
+#if (CONFIG_IRQLAT_ENABLE == 1)
+    timer->ARR = 0xFFFF;    // Полный период: задержка входа в прерывание считается по CNT - CCR, см. irqlat
+#else
     timer->ARR = 0xFF;
+#endif
     timer->IE = IrqFlags;
 
     // SDA Rise, CCR
@@ -436,3 +445,24 @@ ramfunc_ void TimerIIC_IRQHandler(IICSlave &slave) {
         }
     }
 }
+
+
+/**
+ * @brief Значение счётчика таймера в момент фронта, который обработает TimerIIC_IRQHandler()
+ *
+ * Вызывается в обработчике прерывания до TimerIIC_IRQHandler(), флаги STATUS не сбрасываются.
+ * @param slave
+ * @return Регистр захвата фронта в порядке проверки флагов обработчиком, 0 без флагов
+ */
+ramfunc_ uint32_t IICSlaveEventCount(const IICSlave &slave) {
+    uint32_t status = slave.hw.timer->STATUS;
+    if (status & slave.hw.SCLFallFlag)
+        return *slave.hw.SCLFallCCR;
+    if (status & slave.hw.SCLRiseFlag)
+        return *slave.hw.SCLRiseCCR;
+    if (status & slave.hw.SDAFallFlag)
+        return *slave.hw.SDAFallCCR;
+    if (status & slave.hw.SDARiseFlag)
+        return *slave.hw.SDARiseCCR;
+    return 0;
+}
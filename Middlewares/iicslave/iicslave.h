@@ -34,6 +34,10 @@ typedef struct {
     uint32_t            SDAFallFlag;    ///< Маска для среза SDA
     uint32_t            SCLRiseFlag;    ///< Маска для фронта SCL
     uint32_t            SCLFallFlag;    ///< Маска для среза SCL
+    __IO uint32_t      *SDARiseCCR;     ///< Регистр захвата фронта SDA, момент события для irqlat
+    __IO uint32_t      *SDAFallCCR;     ///< Регистр захвата среза SDA
+    __IO uint32_t      *SCLRiseCCR;     ///< Регистр захвата фронта SCL
+    __IO uint32_t      *SCLFallCCR;     ///< Регистр захвата среза SCL
 } Hardware;
 
 
@@ -87,5 +91,6 @@ void IICSlaveStart(IICSlave &slave);
 void IICSlaveStop(IICSlave &slave);
 
 void TimerIIC_IRQHandler(IICSlave &slave);
+uint32_t IICSlaveEventCount(const IICSlave &slave);
 
 #endif //MILANDRBASE_IICSLAVE_H
@@ -0,0 +1,206 @@
+/**
+ * @file irqlat.cpp
+ * @brief Измерение задержки входа в прерывания под нагрузкой
+ */
+
+#include <cstdio>
+#include <cstring>
+#include <MDR32F9Qx_config.h>
+#include <FreeRTOS.h>
+#include <timers.h>
+#include "irqlat.h"
+
+#if (CONFIG_IRQLAT_ENABLE == 1)
+
+#include "log_levels.h"
+#define LOG_LOCAL_LEVEL LOG_TAG_IRQLAT_LOCAL_LEVEL
+#include <mdr_log.h>
+static const char *TAG = "IRQ";
+
+
+#define IRQLAT_IRQ_COUNT        (32)
+#define IRQLAT_LINE_SIZE        (72 + CONFIG_IRQLAT_BUCKETS * 12)
+
+
+struct IrqLatSource {
+    const char *Name;               ///< nullptr - источник не зарегистрирован
+    uint32_t    Budget;             ///< Допустимая задержка, тактов
+    uint32_t    Count;
+    uint32_t    Min;
+    uint32_t    Max;
+    uint64_t    Sum;
+    uint32_t    OverBudget;         ///< Входов с задержкой больше Budget
+    uint32_t    Last;               ///< Задержка предыдущего входа, для джиттера
+    uint16_t    Latency[CONFIG_IRQLAT_BUCKETS];
+    uint16_t    Jitter[CONFIG_IRQLAT_BUCKETS];
+};
+
+volatile uint32_t g_uIrqLatStamp[IRQLAT_IRQ_COUNT];
+static IrqLatSource s_xSources[IRQLAT_IRQ_COUNT];
+
+
+static uint32_t Bucket(uint32_t cycles) {
+    uint32_t bucket = cycles == 0 ? 0 : 32 - __builtin_clz(cycles);
+    return bucket < CONFIG_IRQLAT_BUCKETS ? bucket : CONFIG_IRQLAT_BUCKETS - 1;
+}
+
+static void Increment(uint16_t &counter) {
+    if (counter != UINT16_MAX)
+        counter++;
+}
+
+/*
+ * Учёт задержки. Вызывается в обработчике прерывания источника, вложенный вход того же IRQ невозможен
+ */
+static void Record(IrqLatSource &source, uint32_t cycles) {
+    if (source.Count != 0)
+        Increment(source.Jitter[Bucket(cycles > source.Last ? cycles - source.Last : source.Last - cycles)]);
+    source.Last = cycles;
+    source.Count++;
+    source.Sum += cycles;
+    if (cycles < source.Min)
+        source.Min = cycles;
+    if (cycles > source.Max)
+        source.Max = cycles;
+    if (cycles > source.Budget)
+        source.OverBudget++;
+    Increment(source.Latency[Bucket(cycles)]);
+}
+
+
+/**
+ * @brief Тактов ядра на отсчёт таймера: (PSG + 1) * 2^TIMx_BRG
+ */
+static uint32_t TimerCyclesPerTick(MDR_TIMER_TypeDef *timer) {
+    uint32_t brg;
+    if (timer == MDR_TIMER1) {
+        brg = MDR_RST_CLK->TIM_CLOCK >> RST_CLK_TIM_CLOCK_TIM1_BRG_Pos;
+    } else if (timer == MDR_TIMER2) {
+        brg = MDR_RST_CLK->TIM_CLOCK >> RST_CLK_TIM_CLOCK_TIM2_BRG_Pos;
+    } else {
+        brg = MDR_RST_CLK->TIM_CLOCK >> RST_CLK_TIM_CLOCK_TIM3_BRG_Pos;
+    }
+    return (timer->PSG + 1) << (brg & 0b111);
+}
+
+
+/**
+ * @brief Регистрация источника и сброс его статистики
+ * @param irq Номер прерывания 0..31
+ * @param name Имя в отчёте, запоминается указатель
+ * @param budget Допустимая задержка входа, тактов ядра
+ */
+void IrqLatRegister(IRQn_Type irq, const char *name, uint32_t budget) {
+    assert_param(irq >= 0 && irq < IRQLAT_IRQ_COUNT);
+    IrqLatSource source = {};
+    source.Name = name;
+    source.Budget = budget;
+    source.Min = UINT32_MAX;
+
+    uint32_t primask = __get_PRIMASK();
+    __disable_irq();
+    s_xSources[irq] = source;
+    g_uIrqLatStamp[irq] = 0;
+    __set_PRIMASK(primask);
+}
+
+
+/**
+ * @brief Вход в прерывание с моментом события из регистра захвата, вызывается макросом IRQLAT_TIMER_ENTRY
+ * @param irq Номер прерывания таймера
+ * @param timer Таймер
+ * @param cnt CNT при входе в обработчик
+ * @param event CNT в момент события
+ */
+void IrqLatTimerEntry(IRQn_Type irq, MDR_TIMER_TypeDef *timer, uint32_t cnt, uint32_t event) {
+    IrqLatSource &source = s_xSources[irq];
+    if (source.Name == nullptr)
+        return;
+    uint32_t ticks = cnt >= event ? cnt - event : cnt + timer->ARR + 1 - event;
+    Record(source, ticks * TimerCyclesPerTick(timer));
+}
+
+
+/**
+ * @brief Вход в прерывание с моментом события из IRQLAT_STAMP, вызывается макросом IRQLAT_ENTRY
+ * @param irq Номер прерывания
+ */
+void IrqLatEntry(IRQn_Type irq) {
+    uint32_t now = DWT->CYCCNT;
+    uint32_t stamp = g_uIrqLatStamp[irq];
+    IrqLatSource &source = s_xSources[irq];
+    if (stamp == 0 || source.Name == nullptr)
+        return;
+    g_uIrqLatStamp[irq] = 0;
+    Record(source, now - stamp);
+}
+
+
+static int FormatHistogram(char *line, int size, const uint16_t *histogram) {
+    int length = 0;
+    for (uint32_t b = 0; b < CONFIG_IRQLAT_BUCKETS && length < size; b++)
+        length += snprintf(line + length, size - length, b == 0 ? "%u" : ";%u", histogram[b]);
+    return length;
+}
+
+
+/**
+ * @brief Вывод статистики источников и приоритетов разрешённых прерываний в лог
+ */
+void IrqLatReport() {
+    static char line[IRQLAT_LINE_SIZE];
+    int length = snprintf(line, sizeof(line), "@IRQP");
+    for (uint32_t irq = 0; irq < IRQLAT_IRQ_COUNT && length < static_cast<int>(sizeof(line)); irq++) {
+        if (NVIC->ISER[0] & (1UL << irq))
+            length += snprintf(line + length, sizeof(line) - length, ",%lu:%lu", irq,
+                               NVIC_GetPriority(static_cast<IRQn_Type>(irq)));
+    }
+    MDR_LOGI(TAG, "%s", line);
+
+    for (uint32_t irq = 0; irq < IRQLAT_IRQ_COUNT; irq++) {
+        IrqLatSource source;
+        uint32_t primask = __get_PRIMASK();
+        __disable_irq();
+        source = s_xSources[irq];
+        __set_PRIMASK(primask);
+        if (source.Name == nullptr || source.Count == 0)
+            continue;
+
+        length = snprintf(line, sizeof(line), "@IRQ,%s,%lu,%lu,%lu,%lu,%lu,%lu,%lu,%lu,", source.Name, irq,
+                          NVIC_GetPriority(static_cast<IRQn_Type>(irq)), source.Count, source.Min,
+                          static_cast<uint32_t>(source.Sum / source.Count), source.Max, source.Budget,
+                          source.OverBudget);
+        if (length < static_cast<int>(sizeof(line)))
+            length += FormatHistogram(line + length, sizeof(line) - length, source.Latency);
+        if (length < static_cast<int>(sizeof(line)) - 1) {
+            line[length++] = ',';
+            FormatHistogram(line + length, sizeof(line) - length, source.Jitter);
+        }
+        MDR_LOGI(TAG, "%s", line);
+
+        if (source.Max > source.Budget)
+            MDR_LOGW(TAG, "%s: worst latency %lu cycles exceeds budget %lu, %lu times", source.Name, source.Max,
+                     source.Budget, source.OverBudget);
+    }
+}
+
+
+static void TimerCallback(TimerHandle_t xTimer) {
+    (void)xTimer;
+    IrqLatReport();
+}
+
+/**
+ * @brief Включение CYCCNT и запуск периодического отчёта, период CONFIG_IRQLAT_PERIOD_MS
+ */
+void IrqLatStart() {
+    CoreDebug->DEMCR |= CoreDebug_DEMCR_TRCENA_Msk;
+    DWT->CTRL |= DWT_CTRL_CYCCNTENA_Msk;
+
+    TimerHandle_t timer = xTimerCreate("IrqLat", pdMS_TO_TICKS(CONFIG_IRQLAT_PERIOD_MS), pdTRUE, nullptr,
+                                       TimerCallback);
+    assert_param(timer != nullptr);
+    xTimerStart(timer, 0);
+}
+
+#endif
@@ -0,0 +1,71 @@
+/**
+ * @file irqlat.h
+ * @brief Измерение задержки входа в прерывания под нагрузкой
+ *
+ * Задержка - такты от аппаратного события до первой инструкции обработчика. Момент события берётся:
+ *   - из регистров захвата таймера: IRQLAT_TIMER_ENTRY(irq, timer, event) первым в обработчике читает CNT,
+ *     event - счётчик в момент события (CCRx, CCR1x, ARR для переполнения). Разность по модулю ARR + 1 переводится
+ *     в такты ядра по PSG и TIMx_BRG, поэтому задержка должна быть меньше периода таймера;
+ *   - из DWT->CYCCNT: IRQLAT_STAMP(irq) в коде, который вызывает событие (например, разрешает прерывание по пустому
+ *     FIFO), IRQLAT_ENTRY(irq) первым в обработчике. Учитывается первый вход после отметки.
+ * У DMA, I2C и USB момент события программе неизвестен, их прерывания попадают только в список приоритетов.
+ *
+ * Источник регистрируется IrqLatRegister() с бюджетом задержки. На источник считаются количество, минимум, среднее,
+ * максимум, число превышений бюджета и гистограммы по степеням 2 задержки и джиттера - разности задержек соседних
+ * входов. Программный таймер периодически выводит в лог строки:
+ *   @IRQ,<имя>,<IRQn>,<приоритет>,<количество>,<минимум>,<среднее>,<максимум>,<бюджет>,<превышений>,<задержка 0>;...,<джиттер 0>;...
+ *   @IRQP,<IRQn>:<приоритет>,...  - все разрешённые в NVIC прерывания
+ * Источник, у которого максимум превысил бюджет, дополнительно выводится предупреждением.
+ *
+ * Режим измерения включается CONFIG_IRQLAT_ENABLE, при 0 макросы пустые.
+ */
+
+#ifndef MILANDRBASE_IRQLAT_H
+#define MILANDRBASE_IRQLAT_H
+
+#include <stdint.h>
+#include <MDR32Fx.h>
+#include "app_config.h"
+
+
+#if (CONFIG_IRQLAT_ENABLE == 1)
+
+static_assert(CONFIG_IRQLAT_BUCKETS >= 2 && CONFIG_IRQLAT_BUCKETS <= 33, "CONFIG_IRQLAT_BUCKETS out of range");
+
+extern volatile uint32_t g_uIrqLatStamp[32];
+
+void IrqLatRegister(IRQn_Type irq, const char *name, uint32_t budget);
+void IrqLatTimerEntry(IRQn_Type irq, MDR_TIMER_TypeDef *timer, uint32_t cnt, uint32_t event);
+void IrqLatEntry(IRQn_Type irq);
+void IrqLatStart();
+void IrqLatReport();
+
+/**
+ * @brief Отметка момента события для IRQLAT_ENTRY. 0 - нет отметки, поэтому CYCCNT == 0 сдвигается на 1
+ */
+static inline void IrqLatStamp(IRQn_Type irq) {
+    uint32_t stamp = DWT->CYCCNT;
+    g_uIrqLatStamp[irq] = stamp != 0 ? stamp : 1;
+}
+
+#define IRQLAT_TIMER_ENTRY(irq, timer, event)                                       \
+    do {                                                                            \
+        uint32_t irqlat_cnt = (timer)->CNT;                                         \
+        IrqLatTimerEntry(irq, timer, irqlat_cnt, event);                            \
+    } while (0)
+
+#define IRQLAT_STAMP(irq)           IrqLatStamp(irq)
+#define IRQLAT_ENTRY(irq)           IrqLatEntry(irq)
+
+#else
+
+#define IRQLAT_TIMER_ENTRY(irq, timer, event)
+#define IRQLAT_STAMP(irq)
+#define IRQLAT_ENTRY(irq)
+static inline void IrqLatRegister(IRQn_Type, const char *, uint32_t) {}
+static inline void IrqLatStart() {}
+static inline void IrqLatReport() {}
+
+#endif
+
+#endif //MILANDRBASE_IRQLAT_H
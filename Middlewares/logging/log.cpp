@@ -31,6 +31,7 @@
 #include <assert.h>
 #include "mdr_log.h"
 #include "mdr_log_private.h"
+#include "mempool.h"
 
 #ifndef NDEBUG
 // Enable built-in checks in queue.h in debug builds
@@ -112,7 +113,7 @@ void mdr_log_level_set(const char *tag, mdr_log_level_t level)
         // allocate new linked list entry and append it to the head of the list
         size_t tag_len = strlen(tag) + 1;
         size_t entry_size = offsetof(uncached_tag_entry_t, tag) + tag_len;
-        uncached_tag_entry_t *new_entry = (uncached_tag_entry_t *) (new uint8_t[entry_size]);
+        uncached_tag_entry_t *new_entry = (uncached_tag_entry_t *) PoolAlloc(entry_size);
         if (!new_entry) {
             mdr_log_impl_unlock();
             return;
@@ -169,7 +170,7 @@ void clear_log_level_list(void)
     uncached_tag_entry_t *it;
     while ((it = SLIST_FIRST(&s_log_tags)) != NULL) {
         SLIST_REMOVE_HEAD(&s_log_tags, entries);
-        delete it;
+        PoolFree(it);
     }
     s_log_cache_entry_count = 0;
     s_log_cache_max_generation = 0;
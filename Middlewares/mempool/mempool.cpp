@@ -0,0 +1,213 @@
+/**
+ * @file mempool.cpp
+ * @brief Пулы блоков фиксированного размера
+ */
+
+#include <MDR32F9Qx_config.h>
+#include "mempool.h"
+
+
+#define HEAD_INDEX_Msk      (0x0000FFFFUL)
+#define HEAD_TAG_Inc        (0x00010000UL)
+
+static inline uint8_t *BlockAddress(const MemPool &pool, uint32_t index) {
+    return pool.Storage + index * pool.BlockSize;
+}
+
+static inline uint16_t &BlockNext(const MemPool &pool, uint32_t index) {
+    return *reinterpret_cast<uint16_t *>(BlockAddress(pool, index));
+}
+
+static inline bool CompareExchange(volatile uint32_t *ptr, uint32_t &expected, uint32_t desired) {
+    return __atomic_compare_exchange_n(ptr, &expected, desired, true, __ATOMIC_ACQ_REL, __ATOMIC_ACQUIRE);
+}
+
+static inline void UpdateHighWater(MemPool &pool, uint32_t used) {
+    uint32_t hw = __atomic_load_n(&pool.HighWater, __ATOMIC_RELAXED);
+    while (used > hw) {
+        if (CompareExchange(&pool.HighWater, hw, used))
+            break;
+    }
+}
+
+
+/**
+ * @brief Выделение блока из пула
+ *
+ * Сначала снимается блок со стека свободных. Если стек пуст, выдаётся ещё не использованный блок по FreshCount.
+ * Можно вызывать из прерываний.
+ *
+ * @param pool Пул
+ * @return Указатель на блок или nullptr, если свободных блоков нет
+ */
+void *MemPoolAlloc(MemPool &pool) {
+    uint32_t index;
+    uint32_t head = __atomic_load_n(&pool.Head, __ATOMIC_ACQUIRE);
+    for (;;) {
+        if ((head & HEAD_INDEX_Msk) == 0) {
+            // Стек пуст, пробуем свежий блок
+            uint32_t fresh = __atomic_load_n(&pool.FreshCount, __ATOMIC_RELAXED);
+            do {
+                if (fresh >= pool.BlockCount) {
+                    __atomic_fetch_add(&pool.FailCount, 1, __ATOMIC_RELAXED);
+                    return nullptr;
+                }
+            } while (!CompareExchange(&pool.FreshCount, fresh, fresh + 1));
+            index = fresh;
+            break;
+        }
+        // Следующий индекс читается из блока, который мог уже забрать вытесняющий обработчик. Тогда значение
+        // мусорное, но и тег в голове сменился, CAS не пройдёт.
+        index = (head & HEAD_INDEX_Msk) - 1;
+        uint32_t next = BlockNext(pool, index);
+        uint32_t desired = ((head + HEAD_TAG_Inc) & ~HEAD_INDEX_Msk) | next;
+        if (CompareExchange(&pool.Head, head, desired))
+            break;
+    }
+
+    uint32_t used = __atomic_add_fetch(&pool.Used, 1, __ATOMIC_RELAXED);
+    UpdateHighWater(pool, used);
+    __atomic_fetch_add(&pool.AllocCount, 1, __ATOMIC_RELAXED);
+    return BlockAddress(pool, index);
+}
+
+
+/**
+ * @brief Возврат блока в пул
+ *
+ * Можно вызывать из прерываний.
+ *
+ * @param pool Пул, из которого был выделен блок
+ * @param block Указатель, полученный от MemPoolAlloc(). nullptr игнорируется
+ */
+void MemPoolFree(MemPool &pool, void *block) {
+    if (block == nullptr)
+        return;
+
+    assert_param(MemPoolOwns(pool, block));
+    uint32_t index = (static_cast<uint8_t *>(block) - pool.Storage) / pool.BlockSize;
+
+    __atomic_fetch_sub(&pool.Used, 1, __ATOMIC_RELAXED);
+    uint32_t head = __atomic_load_n(&pool.Head, __ATOMIC_RELAXED);
+    do {
+        BlockNext(pool, index) = head & HEAD_INDEX_Msk;
+    } while (!CompareExchange(&pool.Head, head, ((head + HEAD_TAG_Inc) & ~HEAD_INDEX_Msk) | (index + 1)));
+}
+
+
+/**
+ * @brief Проверка принадлежности блока пулу
+ * @param pool Пул
+ * @param block Указатель на блок
+ * @return true, если указатель - начало одного из блоков пула
+ */
+bool MemPoolOwns(const MemPool &pool, const void *block) {
+    auto p = static_cast<const uint8_t *>(block);
+    if (p < pool.Storage || p >= pool.Storage + pool.BlockCount * pool.BlockSize)
+        return false;
+    return ((p - pool.Storage) % pool.BlockSize) == 0;
+}
+
+
+void MemPoolGetStats(const MemPool &pool, MemPoolStats &stats) {
+    stats.BlockSize = pool.BlockSize;
+    stats.BlockCount = pool.BlockCount;
+    stats.Used = pool.Used;
+    stats.HighWater = pool.HighWater;
+    stats.AllocCount = pool.AllocCount;
+    stats.FailCount = pool.FailCount;
+}
+
+
+void MemPoolResetHighWater(MemPool &pool) {
+    __atomic_store_n(&pool.HighWater, __atomic_load_n(&pool.Used, __ATOMIC_RELAXED), __ATOMIC_RELAXED);
+}
+
+
+// Общий распределитель по классам размеров
+static uint32_t s_xClass0Storage[CONFIG_MEMPOOL_CLASS0_SIZE * CONFIG_MEMPOOL_CLASS0_COUNT / sizeof(uint32_t)];
+static uint32_t s_xClass1Storage[CONFIG_MEMPOOL_CLASS1_SIZE * CONFIG_MEMPOOL_CLASS1_COUNT / sizeof(uint32_t)];
+static uint32_t s_xClass2Storage[CONFIG_MEMPOOL_CLASS2_SIZE * CONFIG_MEMPOOL_CLASS2_COUNT / sizeof(uint32_t)];
+
+static_assert(CONFIG_MEMPOOL_CLASS0_SIZE % 4 == 0 && CONFIG_MEMPOOL_CLASS1_SIZE % 4 == 0 &&
+              CONFIG_MEMPOOL_CLASS2_SIZE % 4 == 0, "Block size must be multiple of 4");
+static_assert(CONFIG_MEMPOOL_CLASS0_SIZE < CONFIG_MEMPOOL_CLASS1_SIZE &&
+              CONFIG_MEMPOOL_CLASS1_SIZE < CONFIG_MEMPOOL_CLASS2_SIZE, "Classes must be sorted by size");
+
+static MemPool s_xPools[MEMPOOL_CLASS_COUNT] = {
+        MEMPOOL_INITIALIZER(s_xClass0Storage, CONFIG_MEMPOOL_CLASS0_SIZE, CONFIG_MEMPOOL_CLASS0_COUNT),
+        MEMPOOL_INITIALIZER(s_xClass1Storage, CONFIG_MEMPOOL_CLASS1_SIZE, CONFIG_MEMPOOL_CLASS1_COUNT),
+        MEMPOOL_INITIALIZER(s_xClass2Storage, CONFIG_MEMPOOL_CLASS2_SIZE, CONFIG_MEMPOOL_CLASS2_COUNT),
+};
+
+
+/**
+ * @brief Выделение блока подходящего размера
+ *
+ * Берётся наименьший класс, в который помещается size. Если класс исчерпан, пробуется следующий по размеру.
+ * Можно вызывать из прерываний.
+ *
+ * @param size Требуемый размер в байтах
+ * @return Указатель на блок или nullptr
+ */
+void *PoolAlloc(size_t size) {
+    for (auto &pool : s_xPools) {
+        if (size <= pool.BlockSize) {
+            void *block = MemPoolAlloc(pool);
+            if (block)
+                return block;
+        }
+    }
+    return nullptr;
+}
+
+
+/**
+ * @brief Освобождение блока, выделенного PoolAlloc()
+ *
+ * Класс определяется по адресу блока. Можно вызывать из прерываний.
+ * @param block Указатель на блок или nullptr
+ */
+void PoolFree(void *block) {
+    if (block == nullptr)
+        return;
+
+    for (auto &pool : s_xPools) {
+        if (MemPoolOwns(pool, block)) {
+            MemPoolFree(pool, block);
+            return;
+        }
+    }
+    assert_param(0);
+}
+
+
+/**
+ * @brief Доступ к пулу класса для статистики
+ * @param index 0..MEMPOOL_CLASS_COUNT-1
+ * @return Пул или nullptr
+ */
+MemPool *PoolGetClass(unsigned index) {
+    if (index >= MEMPOOL_CLASS_COUNT)
+        return nullptr;
+    return &s_xPools[index];
+}
+
+
+#if (CONFIG_MEMPOOL_TRACE == 1)
+#include <SEGGER_RTT.h>
+
+/*
+ * Трасса pvPortMalloc/vPortFree в RTT канал 0. Формат строк, читаемый mempool_benchmark:
+ *   @M <адрес hex> <размер>
+ *   @F <адрес hex> <размер>
+ * Вызывается из heap_4 при остановленном планировщике, поэтому без mdr_log и мьютексов.
+ */
+extern "C" void vMemTraceMalloc(void *pvAddress, size_t uiSize) {
+    SEGGER_RTT_printf(0, "@M %08X %u\n", reinterpret_cast<uint32_t>(pvAddress), uiSize);
+}
+
+extern "C" void vMemTraceFree(void *pvAddress, size_t uiSize) {
+    SEGGER_RTT_printf(0, "@F %08X %u\n", reinterpret_cast<uint32_t>(pvAddress), uiSize);
+}
+#endif
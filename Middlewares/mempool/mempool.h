@@ -0,0 +1,72 @@
+/**
+ * @file mempool.h
+ * @brief Пулы блоков фиксированного размера
+ *
+ * Выделение и освобождение блока за O(1) без запрета прерываний. Список свободных блоков - стек Трайбера на
+ * LDREX/STREX (__atomic builtins), голова списка хранится вместе с тегом для защиты от ABA. Функции можно вызывать
+ * одновременно из задач и из прерываний любого приоритета.
+ *
+ * Пул не требует инициализации во время выполнения: блоки, которые ни разу не выдавались, берутся по счётчику
+ * FreshCount, поэтому пул можно объявить статически и пользоваться им до запуска планировщика.
+ */
+
+#ifndef MILANDRBASE_MEMPOOL_H
+#define MILANDRBASE_MEMPOOL_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include "app_config.h"
+
+
+/**
+ * @brief Пул блоков одного размера
+ *
+ * Заполняется макросом MEMPOOL_INITIALIZER, остальные поля обнуляются.
+ */
+struct MemPool {
+    uint8_t            *Storage;        ///< Память под блоки, BlockSize * BlockCount байт, выравнивание 4
+    uint16_t            BlockSize;      ///< Размер блока в байтах, кратен 4
+    uint16_t            BlockCount;     ///< Количество блоков в пуле, не более 0xFFFE
+    volatile uint32_t   Head;           ///< [31:16] тег ABA, [15:0] индекс первого свободного блока + 1, 0 - пусто
+    volatile uint32_t   FreshCount;     ///< Количество блоков, выданных хотя бы один раз
+    volatile uint32_t   Used;           ///< Занято блоков в данный момент
+    volatile uint32_t   HighWater;      ///< Максимальное количество одновременно занятых блоков
+    volatile uint32_t   AllocCount;     ///< Всего успешных выделений
+    volatile uint32_t   FailCount;      ///< Отказов в выделении из-за исчерпания пула
+};
+
+#define MEMPOOL_INITIALIZER(storage, block_size, block_count) \
+    { (uint8_t *)(storage), (uint16_t)(block_size), (uint16_t)(block_count), 0, 0, 0, 0, 0, 0 }
+
+/**
+ * @brief Снимок статистики пула
+ */
+struct MemPoolStats {
+    uint16_t BlockSize;                 ///< Размер блока
+    uint16_t BlockCount;                ///< Количество блоков
+    uint32_t Used;                      ///< Занято сейчас
+    uint32_t HighWater;                 ///< Максимум занятых блоков
+    uint32_t AllocCount;                ///< Всего выделений
+    uint32_t FailCount;                 ///< Отказов
+};
+
+void *MemPoolAlloc(MemPool &pool);
+void MemPoolFree(MemPool &pool, void *block);
+bool MemPoolOwns(const MemPool &pool, const void *block);
+void MemPoolGetStats(const MemPool &pool, MemPoolStats &stats);
+void MemPoolResetHighWater(MemPool &pool);
+
+
+/**
+ * Классы размеров общего распределителя PoolAlloc()/PoolFree(). Количество классов MEMPOOL_CLASS_COUNT.
+ *
+ * Класс 0 - дескрипторы транзакций I2C, записи тегов лога. Класс 1 - отчёты USB HID (64 байта).
+ * Класс 2 - буферы ввода-вывода и записи лога.
+ */
+#define MEMPOOL_CLASS_COUNT         (3)
+
+void *PoolAlloc(size_t size);
+void PoolFree(void *block);
+MemPool *PoolGetClass(unsigned index);
+
+#endif //MILANDRBASE_MEMPOOL_H
@@ -0,0 +1,232 @@
+/**
+ * @file param_log.cpp
+ * @brief Журнал параметров во flash с выравниванием износа на двух страницах
+ */
+
+#include <MDR32F9Qx_config.h>
+#include "param_log.h"
+
+
+#define ALL_KEYS_Msk        ((PARAM_LOG_KEYS == 32) ? 0xFFFFFFFFUL : ((1UL << PARAM_LOG_KEYS) - 1))
+
+
+static inline uint32_t RecordWord(uint8_t key, uint16_t value) {
+    return (PARAM_LOG_RECORD_TAG << 24) | (static_cast<uint32_t>(key) << 16) | value;
+}
+
+static inline uint32_t PageAddress(const ParamLog &log, uint8_t page) {
+    return log.Flash->Page[page];
+}
+
+static inline uint32_t Slots(const ParamFlash &flash) {
+    return (flash.PageSize - PARAM_LOG_HEADER_SIZE) / PARAM_LOG_RECORD_SIZE;
+}
+
+static inline uint32_t SlotOffset(uint32_t slot) {
+    return PARAM_LOG_HEADER_SIZE + slot * PARAM_LOG_RECORD_SIZE;
+}
+
+
+/*
+ * Запись слова с проверкой чтением
+ */
+static bool Program(ParamLog &log, uint32_t address, uint32_t data) {
+    log.Flash->Program(address, data);
+    if (log.Flash->Read(address) == data)
+        return true;
+    log.Stats.Errors++;
+    return false;
+}
+
+
+static bool Header(const ParamFlash &flash, uint8_t page, uint32_t &generation) {
+    if (flash.Read(flash.Page[page]) != PARAM_LOG_MAGIC)
+        return false;
+    generation = flash.Read(flash.Page[page] + 4);
+    return generation != PARAM_LOG_ERASED;
+}
+
+
+static bool Erased(const ParamFlash &flash, uint8_t page) {
+    for (uint32_t offset = 0; offset < flash.PageSize; offset += 4) {
+        if (flash.Read(flash.Page[page] + offset) != PARAM_LOG_ERASED)
+            return false;
+    }
+    return true;
+}
+
+
+/*
+ * Слоты журнала заполняются подряд, поэтому первый стёртый слот ищется двоичным поиском
+ */
+static uint32_t FindTail(const ParamLog &log) {
+    uint32_t base = PageAddress(log, log.Active);
+    uint32_t low = 0, high = Slots(*log.Flash);
+    while (low < high) {
+        uint32_t middle = (low + high) / 2;
+        uint32_t address = base + SlotOffset(middle);
+        if (log.Flash->Read(address) == PARAM_LOG_ERASED && log.Flash->Read(address + 4) == PARAM_LOG_ERASED)
+            high = middle;
+        else
+            low = middle + 1;
+    }
+    return SlotOffset(low);
+}
+
+
+/*
+ * Индекс по записям от конца журнала: первое найденное значение ключа - последнее записанное
+ */
+static void BuildIndex(ParamLog &log) {
+    uint32_t base = PageAddress(log, log.Active);
+    for (uint32_t offset = log.Tail; offset > PARAM_LOG_HEADER_SIZE && log.Present != ALL_KEYS_Msk; ) {
+        offset -= PARAM_LOG_RECORD_SIZE;
+        uint32_t word = log.Flash->Read(base + offset);
+        uint32_t check = log.Flash->Read(base + offset + 4);
+        uint8_t key = (word >> 16) & 0xFF;
+        if (check != ~word || (word >> 24) != PARAM_LOG_RECORD_TAG || key >= PARAM_LOG_KEYS) {
+            log.Stats.Torn++;
+            continue;
+        }
+        if ((log.Present & (1UL << key)) == 0) {
+            log.Present |= 1UL << key;
+            log.Value[key] = word & 0xFFFF;
+        }
+    }
+}
+
+
+/**
+ * @brief Монтирование: выбор активной страницы и построение индекса
+ *
+ * Если ни одна страница не содержит журнала, страница 0 стирается и размечается.
+ *
+ * @param log Журнал
+ * @param flash Страницы flash, должны жить дольше журнала
+ * @return false, если разметить страницу не удалось
+ */
+bool ParamLogMount(ParamLog &log, const ParamFlash &flash) {
+    assert_param(Slots(flash) > PARAM_LOG_COLLECT_SLOTS + PARAM_LOG_KEYS);
+
+    log = ParamLog();
+    log.Flash = &flash;
+
+    uint32_t generation[2];
+    bool valid[2] = {Header(flash, 0, generation[0]), Header(flash, 1, generation[1])};
+    if (!valid[0] && !valid[1]) {
+        flash.Erase(flash.Page[0]);
+        log.Stats.Erases++;
+        log.Active = 0;
+        log.Generation = 1;
+        if (!Program(log, flash.Page[0] + 4, log.Generation) || !Program(log, flash.Page[0], PARAM_LOG_MAGIC))
+            return false;
+        log.Tail = PARAM_LOG_HEADER_SIZE;
+        log.SpareErased = Erased(flash, 1);
+        return true;
+    }
+
+    log.Active = (valid[1] && (!valid[0] || generation[1] > generation[0])) ? 1 : 0;
+    log.Generation = generation[log.Active];
+    // Вторая страница - старая после переноса или недописанная при сбросе во время переноса
+    log.SpareErased = !valid[log.Active ^ 1] && Erased(flash, log.Active ^ 1);
+    log.Tail = FindTail(log);
+    BuildIndex(log);
+    return true;
+}
+
+
+/**
+ * @brief Последнее значение параметра
+ * @return false, если параметр не записывался
+ */
+bool ParamLogGet(const ParamLog &log, uint8_t key, uint16_t &value) {
+    if (key >= PARAM_LOG_KEYS || (log.Present & (1UL << key)) == 0)
+        return false;
+    value = log.Value[key];
+    return true;
+}
+
+
+/**
+ * @brief Запись параметра: две записи слова в конец журнала, страница не стирается
+ *
+ * Значение, совпадающее с записанным, не пишется.
+ */
+ParamLogResult ParamLogSet(ParamLog &log, uint8_t key, uint16_t value) {
+    if (key >= PARAM_LOG_KEYS)
+        return PARAM_LOG_ERROR;
+    if ((log.Present & (1UL << key)) && log.Value[key] == value) {
+        log.Stats.Unchanged++;
+        return PARAM_LOG_OK;
+    }
+    if (log.Tail + PARAM_LOG_RECORD_SIZE > log.Flash->PageSize)
+        return PARAM_LOG_FULL;
+
+    uint32_t address = PageAddress(log, log.Active) + log.Tail;
+    uint32_t word = RecordWord(key, value);
+    log.Tail += PARAM_LOG_RECORD_SIZE;
+    if (!Program(log, address, word) || !Program(log, address + 4, ~word))
+        return PARAM_LOG_ERROR;
+
+    log.Present |= 1UL << key;
+    log.Value[key] = value;
+    log.Stats.Commits++;
+    return PARAM_LOG_OK;
+}
+
+
+uint32_t ParamLogFreeSlots(const ParamLog &log) {
+    return (log.Flash->PageSize - log.Tail) / PARAM_LOG_RECORD_SIZE;
+}
+
+
+/**
+ * @brief Есть фоновая работа: стереть вторую страницу или перенести журнал
+ */
+bool ParamLogNeedsCollect(const ParamLog &log) {
+    return !log.SpareErased || ParamLogFreeSlots(log) < PARAM_LOG_COLLECT_SLOTS;
+}
+
+
+/**
+ * @brief Один шаг фоновой сборки
+ *
+ * Стирает вторую страницу, если она не стёрта, иначе при нехватке места переносит в неё последние значения
+ * и делает её активной. Стирание и перенос выполняются разными вызовами.
+ *
+ * @return true, если шаг выполнен без ошибок
+ */
+bool ParamLogCollect(ParamLog &log) {
+    uint8_t spare = log.Active ^ 1;
+    if (!log.SpareErased) {
+        log.Flash->Erase(PageAddress(log, spare));
+        log.Stats.Erases++;
+        log.SpareErased = Erased(*log.Flash, spare);
+        return log.SpareErased;
+    }
+    if (ParamLogFreeSlots(log) >= PARAM_LOG_COLLECT_SLOTS)
+        return true;
+
+    // После первой записи в страницу она не стёрта, даже если перенос не удался
+    log.SpareErased = false;
+    uint32_t base = PageAddress(log, spare);
+    uint32_t tail = PARAM_LOG_HEADER_SIZE;
+    for (uint8_t key = 0; key < PARAM_LOG_KEYS; key++) {
+        if ((log.Present & (1UL << key)) == 0)
+            continue;
+        uint32_t word = RecordWord(key, log.Value[key]);
+        if (!Program(log, base + tail, word) || !Program(log, base + tail + 4, ~word))
+            return false;
+        tail += PARAM_LOG_RECORD_SIZE;
+    }
+
+    // Заголовок последним: до записи MAGIC страница не считается журналом
+    if (!Program(log, base + 4, log.Generation + 1) || !Program(log, base, PARAM_LOG_MAGIC))
+        return false;
+
+    log.Active = spare;
+    log.Generation++;
+    log.Tail = tail;
+    log.Stats.Collections++;
+    return true;
+}
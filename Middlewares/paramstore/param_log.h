@@ -0,0 +1,95 @@
+/**
+ * @file param_log.h
+ * @brief Журнал параметров во flash с выравниванием износа на двух страницах
+ *
+ * Параметр - 16-битное значение с ключом 0..PARAM_LOG_KEYS - 1. Запись параметра - две записи слова в конец
+ * журнала активной страницы, без стирания:
+ *  - слово 0: [31:24] 0xA5, [23:16] ключ, [15:0] значение
+ *  - слово 1: ~слово 0 - признак завершённой записи. Запись, прерванная сбросом, не проходит проверку и пропускается
+ *
+ * Заголовок страницы - два слова: PARAM_LOG_MAGIC и поколение. Активна страница с правильным заголовком и
+ * большим поколением. Когда в активной странице остаётся меньше PARAM_LOG_COLLECT_SLOTS свободных записей,
+ * ParamLogCollect() переносит последние значения всех ключей во вторую, заранее стёртую страницу и только потом
+ * пишет её заголовок с поколением + 1: сброс во время переноса оставляет активной старую страницу. Старая страница
+ * стирается следующим вызовом ParamLogCollect(), то есть в фоне, а не во время записи параметра. Страницы
+ * чередуются, поэтому износ делится поровну.
+ *
+ * Индекс последних значений хранится в RAM. При монтировании конец журнала ищется двоичным поиском по стёртым
+ * слотам, записи читаются от конца к началу до нахождения всех ключей.
+ *
+ * Модуль обращается к flash только через ParamFlash и собирается в хостовых тестах.
+ */
+
+#ifndef MILANDRBASE_PARAM_LOG_H
+#define MILANDRBASE_PARAM_LOG_H
+
+#include <stdint.h>
+#include "app_config.h"
+
+
+#define PARAM_LOG_KEYS                  (CONFIG_PARAMSTORE_KEYS)    ///< Ключей, не больше 32
+#define PARAM_LOG_MAGIC                 (0x5041524DUL)              ///< "PARM"
+#define PARAM_LOG_ERASED                (0xFFFFFFFFUL)
+#define PARAM_LOG_RECORD_TAG            (0xA5UL)
+#define PARAM_LOG_RECORD_SIZE           (8)                         ///< Байт на запись
+#define PARAM_LOG_HEADER_SIZE           (8)                         ///< Байт заголовка страницы
+#define PARAM_LOG_COLLECT_SLOTS         (2 * PARAM_LOG_KEYS)        ///< Запас записей, при котором начинается перенос
+
+static_assert(PARAM_LOG_KEYS > 0 && PARAM_LOG_KEYS <= 32, "Parameter keys must fit the present mask");
+
+
+/**
+ * @brief Доступ к двум страницам flash
+ */
+struct ParamFlash {
+    uint32_t    Page[2];                                    ///< Адреса страниц
+    uint32_t    PageSize;                                   ///< Размер страницы, байт
+    uint32_t    (*Read)(uint32_t address);                  ///< Чтение слова
+    void        (*Program)(uint32_t address, uint32_t data);    ///< Запись стёртого слова
+    void        (*Erase)(uint32_t address);                 ///< Стирание страницы
+};
+
+/**
+ * @brief Результат записи параметра
+ */
+enum ParamLogResult {
+    PARAM_LOG_OK,                   ///< Записано или значение не изменилось
+    PARAM_LOG_FULL,                 ///< Нет места до ParamLogCollect()
+    PARAM_LOG_ERROR                 ///< Неверный ключ или слово не записалось
+};
+
+/**
+ * @brief Счётчики работы
+ */
+struct ParamLogStats {
+    uint32_t Commits;               ///< Записано параметров
+    uint32_t Unchanged;             ///< Записей без изменения значения, flash не трогалась
+    uint32_t Collections;           ///< Переносов в другую страницу
+    uint32_t Erases;                ///< Стираний страниц
+    uint32_t Torn;                  ///< Незавершённых записей, найденных при монтировании
+    uint32_t Errors;                ///< Слов, не совпавших после записи
+};
+
+/**
+ * @brief Состояние журнала
+ */
+struct ParamLog {
+    const ParamFlash   *Flash;
+    uint8_t             Active;                         ///< Номер активной страницы
+    bool                SpareErased;                    ///< Вторая страница стёрта и готова к переносу
+    uint32_t            Generation;                     ///< Поколение активной страницы
+    uint32_t            Tail;                           ///< Смещение первой свободной записи в активной странице
+    uint32_t            Present;                        ///< Бит ключа - значение есть
+    uint16_t            Value[PARAM_LOG_KEYS];          ///< Последние значения
+    ParamLogStats       Stats;
+};
+
+
+bool ParamLogMount(ParamLog &log, const ParamFlash &flash);
+bool ParamLogGet(const ParamLog &log, uint8_t key, uint16_t &value);
+ParamLogResult ParamLogSet(ParamLog &log, uint8_t key, uint16_t value);
+bool ParamLogNeedsCollect(const ParamLog &log);
+bool ParamLogCollect(ParamLog &log);
+uint32_t ParamLogFreeSlots(const ParamLog &log);
+
+#endif //MILANDRBASE_PARAM_LOG_H
@@ -0,0 +1,148 @@
+/**
+ * @file paramstore.cpp
+ * @brief Хранение DAC_DEFAULT_CH* и DAC_MAX_CH* в двух последних страницах основной flash
+ */
+
+#include <MDR32F9Qx_config.h>
+#include <MDR32F9Qx_rst_clk.h>
+#include <MDR32F9Qx_eeprom.h>
+#include <FreeRTOS.h>
+#include <task.h>
+#include <semphr.h>
+#include "paramstore.h"
+
+#if (CONFIG_PARAMSTORE_ENABLE == 1)
+
+#include "log_levels.h"
+#define LOG_LOCAL_LEVEL LOG_TAG_PARAMS_LOCAL_LEVEL
+#include <mdr_log.h>
+static const char *TAG = "PARAMS";
+
+static ParamLog s_xLog;
+static SemaphoreHandle_t s_xMutex = nullptr;
+static TaskHandle_t s_xTask = nullptr;
+
+
+/*
+ * Во время работы контроллера flash её нельзя читать, поэтому прерывания запрещены целиком, а не только
+ * до configMAX_SYSCALL_INTERRUPT_PRIORITY
+ */
+static uint32_t FlashRead(uint32_t address) {
+    uint32_t primask = __get_PRIMASK();
+    __disable_irq();
+    uint32_t data = EEPROM_ReadWord(address, EEPROM_Main_Bank_Select);
+    __set_PRIMASK(primask);
+    return data;
+}
+
+static void FlashProgram(uint32_t address, uint32_t data) {
+    uint32_t primask = __get_PRIMASK();
+    __disable_irq();
+    EEPROM_ProgramWord(address, EEPROM_Main_Bank_Select, data);
+    __set_PRIMASK(primask);
+}
+
+static void FlashErase(uint32_t address) {
+    uint32_t primask = __get_PRIMASK();
+    __disable_irq();
+    EEPROM_ErasePage(address, EEPROM_Main_Bank_Select);
+    __set_PRIMASK(primask);
+}
+
+static const ParamFlash s_xFlash = {
+    {CONFIG_PARAMSTORE_PAGE0, CONFIG_PARAMSTORE_PAGE1},
+    CONFIG_PARAMSTORE_PAGE_SIZE,
+    FlashRead,
+    FlashProgram,
+    FlashErase,
+};
+
+
+static void Execute(void *pvParameters) {
+    (void)pvParameters;
+
+    for (;;) {
+        ulTaskNotifyTake(pdTRUE, pdMS_TO_TICKS(CONFIG_PARAMSTORE_COLLECT_MS));
+
+        xSemaphoreTake(s_xMutex, portMAX_DELAY);
+        while (ParamLogNeedsCollect(s_xLog)) {
+            if (!ParamLogCollect(s_xLog)) {
+                MDR_LOGW(TAG, "Collect failed, errors %lu", s_xLog.Stats.Errors);
+                break;
+            }
+            // Между стиранием и переносом даём поработать задачам, ждущим параметры
+            xSemaphoreGive(s_xMutex);
+            taskYIELD();
+            xSemaphoreTake(s_xMutex, portMAX_DELAY);
+        }
+        xSemaphoreGive(s_xMutex);
+    }
+}
+
+
+/**
+ * @brief Монтирование журнала и запуск фоновой сборки
+ *
+ * Вызывается до первого ParamStoreGet(), можно до запуска планировщика.
+ *
+ * @return false, если журнал не удалось разметить
+ */
+bool ParamStoreStart() {
+    RST_CLK_PCLKcmd(RST_CLK_PCLK_EEPROM, ENABLE);
+    s_xMutex = xSemaphoreCreateMutex();
+
+    bool ok = ParamLogMount(s_xLog, s_xFlash);
+    MDR_LOGI(TAG, "Page %u, generation %lu, free %lu, keys %08lX", s_xLog.Active, s_xLog.Generation,
+             ParamLogFreeSlots(s_xLog), s_xLog.Present);
+    if (s_xLog.Stats.Torn)
+        MDR_LOGW(TAG, "Torn records %lu", s_xLog.Stats.Torn);
+
+    xTaskCreate(Execute, "Params", configMINIMAL_STACK_SIZE, nullptr, tskIDLE_PRIORITY + 1, &s_xTask);
+    return ok;
+}
+
+
+/**
+ * @brief Сохранённое значение
+ * @return false, если параметр не сохранялся
+ */
+bool ParamStoreGet(ParamKey key, uint16_t &value) {
+    xSemaphoreTake(s_xMutex, portMAX_DELAY);
+    bool ok = ParamLogGet(s_xLog, key, value);
+    xSemaphoreGive(s_xMutex);
+    return ok;
+}
+
+
+/**
+ * @brief Сохранение значения, для SAVE_EEP
+ *
+ * Обычно - две записи слова. Если фоновая сборка не успела освободить место, перенос выполняется здесь,
+ * со стиранием страницы.
+ *
+ * @return false при ошибке записи flash, LE_EEPROM_ERROR
+ */
+bool ParamStoreSet(ParamKey key, uint16_t value) {
+    xSemaphoreTake(s_xMutex, portMAX_DELAY);
+    ParamLogResult result = ParamLogSet(s_xLog, key, value);
+    if (result == PARAM_LOG_FULL) {
+        MDR_LOGW(TAG, "Log full, collecting in foreground");
+        while (result == PARAM_LOG_FULL && ParamLogCollect(s_xLog))
+            result = ParamLogSet(s_xLog, key, value);
+    }
+    bool collect = ParamLogNeedsCollect(s_xLog);
+    xSemaphoreGive(s_xMutex);
+
+    if (collect)
+        xTaskNotifyGive(s_xTask);
+    return result == PARAM_LOG_OK;
+}
+
+
+void ParamStoreGetStats(ParamLogStats &stats) {
+    xSemaphoreTake(s_xMutex, portMAX_DELAY);
+    stats = s_xLog.Stats;
+    xSemaphoreGive(s_xMutex);
+}
+
+#endif
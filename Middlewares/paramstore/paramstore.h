@@ -0,0 +1,58 @@
+/**
+ * @file paramstore.h
+ * @brief Хранение DAC_DEFAULT_CH* и DAC_MAX_CH* в двух последних страницах основной flash
+ *
+ * Запись параметра - две записи слова в журнал param_log.h без стирания страницы. Задача Params в фоне стирает
+ * освободившуюся страницу и переносит журнал, когда активная страница почти заполнена. Стирание страницы занимает
+ * ~165 мс с запрещёнными прерываниями: код и векторы во flash, а читать её во время стирания нельзя. Поэтому
+ * стирание - только в фоне, один раз на несколько сотен записей.
+ *
+ * Страницы CONFIG_PARAMSTORE_PAGE0 и CONFIG_PARAMSTORE_PAGE1 исключены из области FLASH в 1986ve92.ld. Поэтому
+ * FLASH_SIZE в CMakeLists.txt - 120 КиБ без этих страниц: append_crc пишет CRC образа в последнее слово FLASH_SIZE,
+ * при 128 КиБ слово 0x0801FFFC попадало в журнал страницы 1.
+ *
+ * Запись и стирание flash выполняются из RAM, пока контроллер занят, flash читать нельзя. В SPL для GCC __RAMFUNC
+ * пустой, поэтому MDR32F9Qx_eeprom.c размещён в .data в 1986ve92.ld по имени объектного файла.
+ *
+ * Хранилище собирается при CONFIG_PARAMSTORE_ENABLE, иначе ParamStoreStart() пустая и задача Params не создаётся.
+ */
+
+#ifndef MILANDRBASE_PARAMSTORE_H
+#define MILANDRBASE_PARAMSTORE_H
+
+#include <stdint.h>
+#include "param_log.h"
+#include "app_config.h"
+
+
+/**
+ * @brief Ключи параметров, порядок битов как в регистре SAVE_EEP
+ */
+enum ParamKey {
+    PARAM_DAC_DEFAULT_CH1 = 0,
+    PARAM_DAC_DEFAULT_CH2,
+    PARAM_DAC_DEFAULT_CH3,
+    PARAM_DAC_DEFAULT_CH4,
+    PARAM_DAC_MAX_CH1,
+    PARAM_DAC_MAX_CH2,
+    PARAM_DAC_MAX_CH3,
+    PARAM_DAC_MAX_CH4,
+};
+
+static_assert(PARAM_DAC_MAX_CH4 < PARAM_LOG_KEYS, "CONFIG_PARAMSTORE_KEYS too small");
+
+
+#if (CONFIG_PARAMSTORE_ENABLE == 1)
+
+bool ParamStoreStart();
+bool ParamStoreGet(ParamKey key, uint16_t &value);
+bool ParamStoreSet(ParamKey key, uint16_t value);
+void ParamStoreGetStats(ParamLogStats &stats);
+
+#else
+
+static inline bool ParamStoreStart() { return true; }
+
+#endif
+
+#endif //MILANDRBASE_PARAMSTORE_H
@@ -0,0 +1,102 @@
+/**
+ * @file ssp_setup.h
+ * @brief Регистры ведущего SSP по параметрам устройства, наполнение FIFO передачи
+ *
+ * Частота SCK ведущего SSP_CLK / (CPSDVSR * (SCR + 1)), CPSDVSR чётный 2..254, SCR 0..255. Наибольшая частота
+ * SSP_CLK / 2. Выбирается наименьший делитель, при котором частота не больше заданной.
+ *
+ * Каждое переданное слово принимается, поэтому слов в обмене (передано, но не прочитано из FIFO приёма) не больше
+ * глубины FIFO: FIFO приёма не переполняется при любой задержке прерывания.
+ *
+ * Модуль не зависит от периферии и собирается в хостовых тестах.
+ */
+
+#ifndef MILANDRBASE_SSP_SETUP_H
+#define MILANDRBASE_SSP_SETUP_H
+
+#include <stdint.h>
+
+
+#define SSP_SETUP_CPSDVSR_MIN       (2)
+#define SSP_SETUP_CPSDVSR_MAX       (254)
+#define SSP_SETUP_SCR_MAX           (255)
+#define SSP_SETUP_WORD_BITS_MIN     (4)
+#define SSP_SETUP_WORD_BITS_MAX     (16)
+#define SSP_SETUP_FIFO_DEPTH        (8)
+
+#define SSP_SETUP_CR0_SPO           (1U << 6)       ///< SSP_CR0_SPO: SCK в паузе 1
+#define SSP_SETUP_CR0_SPH           (1U << 7)       ///< SSP_CR0_SPH: захват по второму фронту
+#define SSP_SETUP_CR0_SCR_Pos       (8)
+
+#define SSP_SETUP_MODE_SPH          (1U << 0)       ///< Режим SPI 1 и 3
+#define SSP_SETUP_MODE_SPO          (1U << 1)       ///< Режим SPI 2 и 3
+
+
+/**
+ * @brief Настройка SSP для устройства
+ */
+struct SspSetup {
+    uint16_t Cr0;                   ///< DSS, FRF Motorola, SPO, SPH, SCR
+    uint8_t  Cpsr;                  ///< CPSDVSR
+    uint32_t Hz;                    ///< Получившаяся частота SCK
+};
+
+
+/**
+ * @brief Регистры CR0 и CPSR
+ * @param clock SSP_CLK, Гц
+ * @param maxHz Наибольшая частота SCK устройства
+ * @param bits Бит в слове, 4..16
+ * @param mode Режим SPI 0..3: SSP_SETUP_MODE_SPO | SSP_SETUP_MODE_SPH
+ * @return false - частота ниже SSP_CLK / (254 * 256) или неверные бит в слове, режим
+ */
+static inline bool SspSetupEncode(uint32_t clock, uint32_t maxHz, uint8_t bits, uint8_t mode, SspSetup &setup) {
+    if (maxHz == 0 || bits < SSP_SETUP_WORD_BITS_MIN || bits > SSP_SETUP_WORD_BITS_MAX || mode > 3)
+        return false;
+    uint32_t total = (clock + maxHz - 1) / maxHz;
+    uint32_t bestCpsr = 0, bestScr = 0, bestDivider = UINT32_MAX;
+    for (uint32_t cpsr = SSP_SETUP_CPSDVSR_MIN; cpsr <= SSP_SETUP_CPSDVSR_MAX && cpsr < bestDivider; cpsr += 2) {
+        uint32_t scr = (total + cpsr - 1) / cpsr;
+        if (scr == 0)
+            scr = 1;
+        if (scr > SSP_SETUP_SCR_MAX + 1)
+            continue;
+        if (cpsr * scr < bestDivider) {
+            bestDivider = cpsr * scr;
+            bestCpsr = cpsr;
+            bestScr = scr - 1;
+        }
+    }
+    if (bestDivider == UINT32_MAX)
+        return false;
+
+    setup.Cr0 = static_cast<uint16_t>((bits - 1) | (bestScr << SSP_SETUP_CR0_SCR_Pos) |
+                                      ((mode & SSP_SETUP_MODE_SPO) ? SSP_SETUP_CR0_SPO : 0) |
+                                      ((mode & SSP_SETUP_MODE_SPH) ? SSP_SETUP_CR0_SPH : 0));
+    setup.Cpsr = static_cast<uint8_t>(bestCpsr);
+    setup.Hz = clock / bestDivider;
+    return true;
+}
+
+
+/**
+ * @brief Устройства с одинаковой настройкой обмениваются без перенастройки SSP
+ */
+static inline bool SspSetupEqual(const SspSetup &a, const SspSetup &b) {
+    return a.Cr0 == b.Cr0 && a.Cpsr == b.Cpsr;
+}
+
+
+/**
+ * @brief Слов, которые можно записать в FIFO передачи
+ * @param sent Слов передано
+ * @param received Слов принято
+ * @param words Слов в транзакции
+ */
+static inline uint32_t SspSetupPump(uint32_t sent, uint32_t received, uint32_t words) {
+    uint32_t room = SSP_SETUP_FIFO_DEPTH - (sent - received);
+    uint32_t left = words - sent;
+    return left < room ? left : room;
+}
+
+#endif //MILANDRBASE_SSP_SETUP_H
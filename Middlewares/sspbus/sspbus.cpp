@@ -0,0 +1,246 @@
+/**
+ * @file sspbus.cpp
+ * @brief Очередь транзакций ведущего SSP2 для нескольких устройств на одной шине
+ */
+
+#include <MDR32F9Qx_config.h>
+#include <MDR32F9Qx_rst_clk.h>
+#include <MDR32F9Qx_port.h>
+#include <MDR32F9Qx_ssp.h>
+#include <FreeRTOS.h>
+#include <stackprof.h>
+#include "sspbus.h"
+
+#include "log_levels.h"
+#define LOG_LOCAL_LEVEL LOG_TAG_SSPBUS_LOCAL_LEVEL
+#include <mdr_log.h>
+static const char *TAG = "SSPBUS";
+
+#define SSPBUS_HW               MDR_SSP2
+#define SSPBUS_IRQ_PREEMPTIVE_PRIORITY  (7)     ///< Не выше configMAX_SYSCALL_INTERRUPT_PRIORITY: публикуются события
+#define SSPBUS_IRQ_SUBPRIORITY          (0)
+
+
+static bool s_bInit = false;
+static SspBusTransaction *s_pHead;              ///< Выполняется
+static SspBusTransaction *s_pTail;
+static SspSetup s_xActive;                      ///< Текущая настройка SSP, Cpsr = 0 - не настроен
+static SspBusDevice *s_pSelected;               ///< Устройство с прижатым выводом выбора
+static uint32_t s_uGpioDevices;
+static uint32_t s_uFssDevices;
+static SspBusStats s_xStats;
+
+
+static void Deselect() {
+    if (s_pSelected != nullptr) {
+        PORT_SetBits(s_pSelected->CsPort, s_pSelected->CsPin);
+        s_pSelected = nullptr;
+    }
+}
+
+
+static void Pump(SspBusTransaction &transaction) {
+    uint32_t count = SspSetupPump(transaction.Sent, transaction.Received, transaction.Words);
+    bool wide = transaction.Device->WordBits > 8;
+    for (; count != 0; count--, transaction.Sent++) {
+        uint16_t word = transaction.Fill;
+        if (transaction.Tx != nullptr) {
+            word = wide ? static_cast<const uint16_t *>(transaction.Tx)[transaction.Sent]
+                        : static_cast<const uint8_t *>(transaction.Tx)[transaction.Sent];
+        }
+        SSPBUS_HW->DR = word;
+    }
+}
+
+
+/*
+ * Запуск транзакции из головы очереди. Вызывается с запрещёнными прерываниями или из SSP2_IRQHandler.
+ * FIFO приёма пуст: предыдущая транзакция приняла все слова
+ */
+static void Start(SspBusTransaction &transaction) {
+    SspBusDevice &device = *transaction.Device;
+    if (s_pSelected != &device)
+        Deselect();
+    if (!SspSetupEqual(device.Setup, s_xActive)) {
+        SSPBUS_HW->CR1 &= ~SSP_CR1_SSE;
+        SSPBUS_HW->CR0 = device.Setup.Cr0;
+        SSPBUS_HW->CPSR = device.Setup.Cpsr;
+        SSPBUS_HW->CR1 |= SSP_CR1_SSE;
+        s_xActive = device.Setup;
+        s_xStats.Reconfigs++;
+    }
+    if (device.CsPort != nullptr && s_pSelected != &device) {
+        PORT_ResetBits(device.CsPort, device.CsPin);
+        s_pSelected = &device;
+    }
+
+    transaction.Sent = 0;
+    transaction.Received = 0;
+    Pump(transaction);
+    SSPBUS_HW->IMSC = SSP_IMSC_RXIM | SSP_IMSC_RTIM;
+}
+
+
+static void Finish(SspBusTransaction &transaction, BaseType_t *pxHigherPriorityTaskWoken) {
+    if ((transaction.Flags & SSPBUS_KEEP_CS) == 0)
+        Deselect();
+    s_xStats.Transactions++;
+    s_xStats.Words += transaction.Words;
+
+    // После Pending = false транзакция принадлежит вызывающему
+    EventChannel *done = transaction.Done;
+    s_pHead = transaction.Next;
+    if (s_pHead == nullptr)
+        s_pTail = nullptr;
+    transaction.Pending = false;
+    if (done != nullptr)
+        EventPostFromISR(*done, pxHigherPriorityTaskWoken);
+
+    if (s_pHead != nullptr)
+        Start(*s_pHead);
+    else
+        SSPBUS_HW->IMSC = 0;
+}
+
+
+extern "C" void SSP2_IRQHandler() {
+    STACKPROF_ISR_ENTER();
+    BaseType_t xHigherPriorityTaskWoken = pdFALSE;
+    SSPBUS_HW->ICR = SSP_ICR_RTIC | SSP_ICR_RORIC;
+    SspBusTransaction *transaction = s_pHead;
+    if (transaction == nullptr) {
+        SSPBUS_HW->IMSC = 0;
+        return;
+    }
+
+    bool wide = transaction->Device->WordBits > 8;
+    while ((SSPBUS_HW->SR & SSP_SR_RNE) && transaction->Received < transaction->Sent) {
+        uint16_t word = SSPBUS_HW->DR;
+        if (transaction->Rx != nullptr) {
+            if (wide)
+                static_cast<uint16_t *>(transaction->Rx)[transaction->Received] = word;
+            else
+                static_cast<uint8_t *>(transaction->Rx)[transaction->Received] = static_cast<uint8_t>(word);
+        }
+        transaction->Received++;
+    }
+    if (transaction->Received < transaction->Words)
+        Pump(*transaction);
+    else
+        Finish(*transaction, &xHigherPriorityTaskWoken);
+    portYIELD_FROM_ISR(xHigherPriorityTaskWoken);
+}
+
+
+/**
+ * @brief Выводы SSP2, ведущий режим и прерывание. Повторные вызовы ничего не делают
+ */
+void SspBusInit() {
+    uint32_t primask = __get_PRIMASK();
+    __disable_irq();
+    if (s_bInit) {
+        __set_PRIMASK(primask);
+        return;
+    }
+    s_bInit = true;
+    __set_PRIMASK(primask);
+
+    RST_CLK_PCLKcmd(RST_CLK_PCLK_PORTD | RST_CLK_PCLK_SSP2, ENABLE);
+    PORT_InitTypeDef PORT_InitStructure;
+    PORT_StructInit(&PORT_InitStructure);
+    // PD5, PD6 - CLK, TXD выходы
+    PORT_InitStructure.PORT_Pin = PORT_Pin_5 | PORT_Pin_6;
+    PORT_InitStructure.PORT_OE = PORT_OE_OUT;
+    PORT_InitStructure.PORT_FUNC = PORT_FUNC_ALTER;
+    PORT_InitStructure.PORT_MODE = PORT_MODE_DIGITAL;
+    PORT_InitStructure.PORT_SPEED = PORT_SPEED_FAST;
+    PORT_Init(MDR_PORTD, &PORT_InitStructure);
+    // PD2 - RXD вход
+    PORT_InitStructure.PORT_Pin = PORT_Pin_2;
+    PORT_InitStructure.PORT_OE = PORT_OE_IN;
+    PORT_Init(MDR_PORTD, &PORT_InitStructure);
+
+    SSP_DeInit(SSPBUS_HW);
+    SSP_BRGInit(SSPBUS_HW, SSP_HCLKdiv1);       // SSP_CLK = HCLK
+    SSPBUS_HW->CR1 = 0;                         // Ведущий, выключен до первой транзакции
+    NVIC_SetPriority(SSP2_IRQn, NVIC_EncodePriority(NVIC_GetPriorityGrouping(), SSPBUS_IRQ_PREEMPTIVE_PRIORITY,
+                                                    SSPBUS_IRQ_SUBPRIORITY));
+    NVIC_EnableIRQ(SSP2_IRQn);
+}
+
+
+/**
+ * @brief Настройка устройства и его вывода выбора
+ * @param device Устройство, живёт всё время работы шины. Заполняется device.Setup
+ * @return false - частота или формат слова недопустимы, либо FSS и выводы порта на одной шине
+ */
+bool SspBusAddDevice(SspBusDevice &device) {
+    SspBusInit();
+    if (!SspSetupEncode(SystemCoreClock, device.MaxHz, device.WordBits, device.Mode, device.Setup)) {
+        MDR_LOGE(TAG, "%s: unsupported %lu Hz, %u bits, mode %u", device.Name, device.MaxHz, device.WordBits,
+                 device.Mode);
+        return false;
+    }
+    if ((device.CsPort == nullptr && s_uGpioDevices != 0) || (device.CsPort != nullptr && s_uFssDevices != 0)) {
+        MDR_LOGE(TAG, "%s: hardware FSS cannot share the bus with GPIO chip selects", device.Name);
+        return false;
+    }
+
+    PORT_InitTypeDef PORT_InitStructure;
+    PORT_StructInit(&PORT_InitStructure);
+    PORT_InitStructure.PORT_OE = PORT_OE_OUT;
+    PORT_InitStructure.PORT_MODE = PORT_MODE_DIGITAL;
+    PORT_InitStructure.PORT_SPEED = PORT_SPEED_FAST;
+    if (device.CsPort != nullptr) {
+        // Вывод выбора отпущен до включения выхода
+        RST_CLK_PCLKcmd(PCLK_BIT(reinterpret_cast<uintptr_t>(device.CsPort)), ENABLE);
+        PORT_SetBits(device.CsPort, device.CsPin);
+        PORT_InitStructure.PORT_Pin = device.CsPin;
+        PORT_InitStructure.PORT_FUNC = PORT_FUNC_PORT;
+        PORT_Init(device.CsPort, &PORT_InitStructure);
+        s_uGpioDevices++;
+    } else {
+        // PD3 - FSS выход, ведёт SSP
+        PORT_InitStructure.PORT_Pin = PORT_Pin_3;
+        PORT_InitStructure.PORT_FUNC = PORT_FUNC_ALTER;
+        PORT_Init(MDR_PORTD, &PORT_InitStructure);
+        s_uFssDevices++;
+    }
+    MDR_LOGI(TAG, "%s: %lu Hz, %u bits, mode %u, CS %s", device.Name, device.Setup.Hz, device.WordBits, device.Mode,
+             device.CsPort != nullptr ? "GPIO" : "FSS");
+    return true;
+}
+
+
+/**
+ * @brief Постановка транзакции в очередь, из задачи или прерывания
+ * @param transaction Транзакция, не должна быть в очереди. Device добавлено SspBusAddDevice()
+ * @return false - пустая транзакция или устройство не добавлено
+ */
+bool SspBusSubmit(SspBusTransaction &transaction) {
+    assert_param(!transaction.Pending);
+    if (transaction.Words == 0 || transaction.Device == nullptr || transaction.Device->Setup.Cpsr == 0)
+        return false;
+    transaction.Next = nullptr;
+    transaction.Pending = true;
+
+    uint32_t primask = __get_PRIMASK();
+    __disable_irq();
+    if (s_pTail != nullptr) {
+        s_pTail->Next = &transaction;
+        s_pTail = &transaction;
+    } else {
+        s_pHead = s_pTail = &transaction;
+        Start(transaction);
+    }
+    __set_PRIMASK(primask);
+    return true;
+}
+
+
+void SspBusGetStats(SspBusStats &stats) {
+    uint32_t primask = __get_PRIMASK();
+    __disable_irq();
+    stats = s_xStats;
+    __set_PRIMASK(primask);
+}
@@ -0,0 +1,89 @@
+/**
+ * @file sspbus.h
+ * @brief Очередь транзакций ведущего SSP2 для нескольких устройств на одной шине
+ *
+ * SSP2: PD2 - RXD, PD5 - CLK, PD6 - TXD, функция ALTER. Устройство задаёт частоту, бит в слове, режим SPI и вывод
+ * выбора. Транзакция - обмен словами с одним устройством: передача из буфера или слово заполнения, приём в буфер
+ * или без сохранения. Транзакции ставятся в общую очередь SspBusSubmit() из задач и прерываний и выполняются
+ * по порядку в SSP2_IRQHandler, следующая запускается сразу из прерывания конца предыдущей.
+ *
+ * SSP перенастраивается только при смене CR0 или CPSR: устройства с одинаковой настройкой идут подряд без
+ * выключения SSP. Прерывание по заполнению FIFO приёма наполовину дочитывает принятые слова и дописывает
+ * передачу, последние слова транзакции забирает прерывание таймаута приёма (32 такта SCK).
+ *
+ * Выбор устройства:
+ *   - вывод порта. Прижимается к 0 перед первым словом и отпускается после последнего принятого слова. С флагом
+ *     SSPBUS_KEEP_CS остаётся прижатым до транзакции другого устройства: команда и данные одним кадром;
+ *   - аппаратный FSS на PD3, ALTER. FSS ведёт SSP: в режимах SPH = 0 FSS поднимается между словами, в режимах
+ *     SPH = 1 держится, пока FIFO передачи не пуст. Такой FSS опускается при обмене с любым устройством, поэтому
+ *     устройство с FSS не может делить шину с устройствами на выводах порта. Вывод FSS PC0 (OVERRID) не используется.
+ *
+ * Транзакция и буферы должны жить до завершения: SspBusBusy() или событие.
+ */
+
+#ifndef MILANDRBASE_SSPBUS_H
+#define MILANDRBASE_SSPBUS_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include <MDR32Fx.h>
+#include <events.h>
+#include "app_config.h"
+#include "ssp_setup.h"
+
+
+#define SSPBUS_KEEP_CS              (1U << 0)       ///< Не отпускать вывод выбора после транзакции
+
+
+/**
+ * @brief Устройство на шине
+ */
+struct SspBusDevice {
+    const char        *Name;
+    uint32_t           MaxHz;           ///< Наибольшая частота SCK
+    uint8_t            WordBits;        ///< Бит в слове, 4..16
+    uint8_t            Mode;            ///< Режим SPI 0..3: SSP_SETUP_MODE_SPO | SSP_SETUP_MODE_SPH
+    MDR_PORT_TypeDef  *CsPort;          ///< Порт вывода выбора, nullptr - аппаратный FSS PD3
+    uint32_t           CsPin;           ///< PORT_Pin_0..PORT_Pin_15
+    SspSetup           Setup;           ///< Заполняет SspBusAddDevice()
+};
+
+/**
+ * @brief Транзакция: Words слов передаются и принимаются одновременно
+ *
+ * Слово буфера - uint8_t при WordBits <= 8, иначе uint16_t.
+ */
+struct SspBusTransaction {
+    SspBusDevice        *Device;
+    const void          *Tx;            ///< Слова передачи, nullptr - передаётся Fill
+    void                *Rx;            ///< Буфер приёма, nullptr - принятые слова отбрасываются
+    uint16_t             Words;
+    uint16_t             Fill;
+    uint8_t              Flags;         ///< SSPBUS_KEEP_CS
+    volatile bool        Pending;       ///< В очереди или выполняется
+    EventChannel        *Done;          ///< Событие завершения, nullptr - без события
+    SspBusTransaction   *Next;
+    uint16_t             Sent;
+    uint16_t             Received;
+};
+
+/**
+ * @brief Счётчики шины
+ */
+struct SspBusStats {
+    uint32_t Transactions;
+    uint32_t Words;
+    uint32_t Reconfigs;                 ///< Перенастроек SSP при смене устройства
+};
+
+
+void SspBusInit();
+bool SspBusAddDevice(SspBusDevice &device);
+bool SspBusSubmit(SspBusTransaction &transaction);
+void SspBusGetStats(SspBusStats &stats);
+
+static inline bool SspBusBusy(const SspBusTransaction &transaction) {
+    return transaction.Pending;
+}
+
+#endif //MILANDRBASE_SSPBUS_H
@@ -0,0 +1,191 @@
+/**
+ * @file stackprof.cpp
+ * @brief Профилировщик стеков задач и MSP
+ */
+
+#include <cstring>
+#include <MDR32F9Qx_config.h>
+#include <FreeRTOS.h>
+#include <task.h>
+#include <timers.h>
+#include <SEGGER_RTT.h>
+#include "stackprof.h"
+
+#if (CONFIG_STACKPROF_ENABLE == 1)
+
+#include "log_levels.h"
+#define LOG_LOCAL_LEVEL LOG_TAG_STACKPROF_LOCAL_LEVEL
+#include <mdr_log.h>
+static const char *TAG = "STK";
+
+
+#define STACK_FILL_WORD         (0xA5A5A5A5UL)      ///< tskSTACK_FILL_BYTE ядра, повторённый 4 раза
+#define MSP_PAINT_GUARD_WORDS   (16)                ///< Запас ниже текущего SP при заполнении MSP
+
+
+// Символы из 1986ve92.ld
+extern "C" uint32_t _Main_Stack_Limit;
+extern "C" uint32_t __stack;
+
+
+volatile uint32_t g_uStackProfMaxNesting = 0;
+
+
+struct TaskStackInfo {
+    void       *Handle;             ///< Указатель на TCB, совпадает с TaskHandle_t
+    uint16_t    Size;               ///< Размер стека, слов
+};
+
+static TaskStackInfo s_xTaskStacks[CONFIG_STACKPROF_MAX_TASKS];
+static TaskStatus_t s_xStatus[CONFIG_STACKPROF_MAX_TASKS];
+static uint8_t s_xRecords[CONFIG_STACKPROF_MAX_TASKS + 1][STACKPROF_RECORD_SIZE];
+static uint8_t s_uRecordCount = 0;
+
+
+/*
+ * Хуки traceTASK_CREATE и traceTASK_DELETE, вызываются ядром в критической секции
+ */
+extern "C" void vStackProfTaskCreated(void *xTask, void *pxStack, void *pxEndOfStack) {
+    for (auto &info : s_xTaskStacks) {
+        if (info.Handle == nullptr) {
+            info.Handle = xTask;
+            info.Size = static_cast<StackType_t *>(pxEndOfStack) - static_cast<StackType_t *>(pxStack) + 1;
+            return;
+        }
+    }
+}
+
+extern "C" void vStackProfTaskDeleted(void *xTask) {
+    for (auto &info : s_xTaskStacks) {
+        if (info.Handle == xTask) {
+            info.Handle = nullptr;
+            return;
+        }
+    }
+}
+
+extern "C" void vApplicationStackOverflowHook(TaskHandle_t xTask, char *pcTaskName) {
+    (void)xTask;
+    SEGGER_RTT_printf(0, "@OVF,%s\n", pcTaskName);
+    taskDISABLE_INTERRUPTS();
+    for (;;);
+}
+
+
+static uint16_t TaskStackSize(TaskHandle_t handle) {
+    for (const auto &info : s_xTaskStacks) {
+        if (info.Handle == handle)
+            return info.Size;
+    }
+    return 0;
+}
+
+static uint32_t MspSizeWords() {
+    return &__stack - &_Main_Stack_Limit;
+}
+
+static uint32_t MspUsedWords() {
+    const uint32_t *p = &_Main_Stack_Limit;
+    while (p < &__stack && *p == STACK_FILL_WORD)
+        p++;
+    return &__stack - p;
+}
+
+
+/**
+ * @brief Заполнение свободной части MSP
+ *
+ * Вызывается первой в main(), до CPU_Init(). Кадры main() выше текущего SP остаются незаполненными и входят
+ * в использование MSP. После запуска планировщика MSP используют только прерывания.
+ */
+void StackProfPaintMsp() {
+    uint32_t *p = &_Main_Stack_Limit;
+    uint32_t *sp = reinterpret_cast<uint32_t *>(__get_MSP()) - MSP_PAINT_GUARD_WORDS;
+    while (p < sp)
+        *p++ = STACK_FILL_WORD;
+}
+
+
+/**
+ * @brief Пересчёт максимального использования стеков
+ *
+ * Обновляет записи StackProfReadRecord(). Вызывается из задачи: uxTaskGetSystemState() приостанавливает планировщик
+ * на время обхода стеков, записи копируются в критической секции, так как читаются из прерывания Timer1 ведомого I2C.
+ */
+void StackProfUpdate() {
+    UBaseType_t count = uxTaskGetSystemState(s_xStatus, CONFIG_STACKPROF_MAX_TASKS, nullptr);
+    if (count == 0) {
+        MDR_LOGW(TAG, "More than %d tasks, increase CONFIG_STACKPROF_MAX_TASKS", CONFIG_STACKPROF_MAX_TASKS);
+        return;
+    }
+
+    // Порядок задач в uxTaskGetSystemState зависит от состояния, упорядочиваем по номеру создания
+    for (UBaseType_t i = 1; i < count; i++) {
+        TaskStatus_t status = s_xStatus[i];
+        UBaseType_t j = i;
+        for (; j > 0 && s_xStatus[j - 1].xTaskNumber > status.xTaskNumber; j--)
+            s_xStatus[j] = s_xStatus[j - 1];
+        s_xStatus[j] = status;
+    }
+
+    StackProfHeader header;
+    header.Magic = STACKPROF_RECORD_MAGIC;
+    header.TaskCount = count;
+    header.MaxNesting = g_uStackProfMaxNesting;
+    header.MspSize = MspSizeWords();
+    header.MspUsed = MspUsedWords();
+
+    taskENTER_CRITICAL();
+    memcpy(s_xRecords[0], &header, sizeof(header));
+    for (UBaseType_t i = 0; i < count; i++) {
+        StackProfTask task;
+        strncpy(task.Name, s_xStatus[i].pcTaskName, sizeof(task.Name));
+        task.Size = TaskStackSize(s_xStatus[i].xHandle);
+        task.Used = task.Size - s_xStatus[i].usStackHighWaterMark;
+        memcpy(s_xRecords[i + 1], &task, sizeof(task));
+    }
+    s_uRecordCount = count + 1;
+    taskEXIT_CRITICAL();
+
+    for (UBaseType_t i = 0; i < count; i++) {
+        uint32_t size = TaskStackSize(s_xStatus[i].xHandle);
+        MDR_LOGI(TAG, "@STK,%s,%u,%u", s_xStatus[i].pcTaskName, size * sizeof(StackType_t),
+                 (size - s_xStatus[i].usStackHighWaterMark) * sizeof(StackType_t));
+    }
+    MDR_LOGI(TAG, "@MSP,%u,%u,%u", header.MspSize * sizeof(uint32_t), header.MspUsed * sizeof(uint32_t),
+             header.MaxNesting);
+}
+
+
+/**
+ * @brief Чтение записи профилировщика. Можно вызывать из прерываний
+ * @param index 0 - заголовок StackProfHeader, 1..TaskCount - StackProfTask
+ * @param record Буфер на STACKPROF_RECORD_SIZE байт
+ * @return false, если записи с таким номером нет. Буфер заполняется нулями
+ */
+bool StackProfReadRecord(uint8_t index, uint8_t *record) {
+    if (index >= s_uRecordCount) {
+        memset(record, 0, STACKPROF_RECORD_SIZE);
+        return false;
+    }
+    memcpy(record, s_xRecords[index], STACKPROF_RECORD_SIZE);
+    return true;
+}
+
+
+static void TimerCallback(TimerHandle_t xTimer) {
+    (void)xTimer;
+    StackProfUpdate();
+}
+
+/**
+ * @brief Запуск периодического пересчёта в задаче программных таймеров, период CONFIG_STACKPROF_PERIOD_MS
+ */
+void StackProfStart() {
+    TimerHandle_t timer = xTimerCreate("StackProf", pdMS_TO_TICKS(CONFIG_STACKPROF_PERIOD_MS), pdTRUE, nullptr,
+                                       TimerCallback);
+    assert_param(timer != nullptr);
+    xTimerStart(timer, 0);
+}
+
+#endif
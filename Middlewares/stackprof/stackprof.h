@@ -0,0 +1,87 @@
+/**
+ * @file stackprof.h
+ * @brief Профилировщик стеков задач и MSP
+ *
+ * Стеки задач заполняются ядром значением 0xA5 при создании (configUSE_TRACE_FACILITY), область MSP
+ * (_Main_Stack_Limit.._stack из 1986ve92.ld) заполняется StackProfPaintMsp() в начале main(). Размер стека каждой
+ * задачи запоминается хуком traceTASK_CREATE. Программный таймер периодически считает максимальное использование и
+ * выводит его в лог строками:
+ *   @STK,<имя задачи>,<размер, байт>,<максимум использования, байт>
+ *   @MSP,<размер, байт>,<максимум использования, байт>,<максимальная вложенность прерываний>
+ *
+ * Те же данные доступны записями по 8 байт через StackProfReadRecord(), см. IICSlaveTask.
+ */
+
+#ifndef MILANDRBASE_STACKPROF_H
+#define MILANDRBASE_STACKPROF_H
+
+#include <stdint.h>
+#include <MDR32Fx.h>
+#include "app_config.h"
+
+
+#define STACKPROF_RECORD_SIZE       (8)             ///< Размер записи StackProfReadRecord()
+#define STACKPROF_RECORD_MAGIC      (0x5053)        ///< "SP" в заголовке, запись 0
+
+/**
+ * @brief Запись 0 - заголовок
+ */
+struct StackProfHeader {
+    uint16_t Magic;                 ///< STACKPROF_RECORD_MAGIC
+    uint8_t  TaskCount;             ///< Количество записей задач, начиная с 1
+    uint8_t  MaxNesting;            ///< Максимальная наблюдавшаяся вложенность прерываний
+    uint16_t MspSize;               ///< Размер области MSP, слов
+    uint16_t MspUsed;               ///< Максимум использования MSP, слов
+} __attribute__((packed));
+
+/**
+ * @brief Записи 1..TaskCount - задачи в порядке создания
+ */
+struct StackProfTask {
+    char     Name[4];               ///< Первые 4 символа имени задачи, без завершающего нуля
+    uint16_t Size;                  ///< Размер стека, слов
+    uint16_t Used;                  ///< Максимум использования, слов
+} __attribute__((packed));
+
+static_assert(sizeof(StackProfHeader) == STACKPROF_RECORD_SIZE, "StackProfHeader size");
+static_assert(sizeof(StackProfTask) == STACKPROF_RECORD_SIZE, "StackProfTask size");
+
+
+#if (CONFIG_STACKPROF_ENABLE == 1)
+
+extern volatile uint32_t g_uStackProfMaxNesting;
+
+/**
+ * @brief Учёт вложенности прерываний, вызывается первым в обработчике
+ *
+ * Вложенность - количество активных исключений: внешние прерывания по NVIC->IABR и системные (SVCall, PendSV,
+ * SysTick, отказы) по SCB->SHCSR.
+ */
+static inline void StackProfIsrEnter() {
+    uint32_t nesting = __builtin_popcount(NVIC->IABR[0]) +
+                       __builtin_popcount(SCB->SHCSR & (SCB_SHCSR_MEMFAULTACT_Msk | SCB_SHCSR_BUSFAULTACT_Msk |
+                                                        SCB_SHCSR_USGFAULTACT_Msk | SCB_SHCSR_SVCALLACT_Msk |
+                                                        SCB_SHCSR_MONITORACT_Msk | SCB_SHCSR_PENDSVACT_Msk |
+                                                        SCB_SHCSR_SYSTICKACT_Msk));
+    if (nesting > g_uStackProfMaxNesting)
+        g_uStackProfMaxNesting = nesting;
+}
+
+#define STACKPROF_ISR_ENTER()       StackProfIsrEnter()
+
+void StackProfPaintMsp();
+void StackProfStart();
+void StackProfUpdate();
+bool StackProfReadRecord(uint8_t index, uint8_t *record);
+
+#else
+
+#define STACKPROF_ISR_ENTER()
+static inline void StackProfPaintMsp() {}
+static inline void StackProfStart() {}
+static inline void StackProfUpdate() {}
+static inline bool StackProfReadRecord(uint8_t, uint8_t *) { return false; }
+
+#endif
+
+#endif //MILANDRBASE_STACKPROF_H
@@ -0,0 +1,164 @@
+/**
+ * @file uart_ring.h
+ * @brief Делитель частоты UART, позиция записи кольца приёма DMA, разбиение приёма на кадры по паузе
+ *
+ * UART PL011: частота обмена UART_CLK / (16 * (IBRD + FBRD / 64)), наибольшая - UART_CLK / 16.
+ *
+ * Кольцо приёма - две половины канала пинг-понг. Обратный вызов DMA перезапускает остановленную половину и считает
+ * завершённые половины, позиция записи - счётчик байт с начала приёма. Счётчики чтения и записи не сворачиваются
+ * по размеру кольца, поэтому переполнение видно как разность больше кольца.
+ *
+ * Кадр заканчивается паузой: позиция записи не менялась idle опросов UartRxPoll() подряд. Поток без пауз
+ * отдаётся кадрами по maxFrame байт.
+ *
+ * Модуль не зависит от периферии и собирается в хостовых тестах.
+ */
+
+#ifndef MILANDRBASE_UART_RING_H
+#define MILANDRBASE_UART_RING_H
+
+#include <stdint.h>
+#include "dma_table.h"
+
+
+#define UART_BAUD_OVERSAMPLING      (16)
+#define UART_BAUD_FRACTION_BITS     (6)
+#define UART_BAUD_IBRD_MAX          (0xFFFF)
+#define UART_BAUD_ERROR_MAX_PPM     (15625)         ///< 2/128, как в UART_Init()
+
+
+/**
+ * @brief Делитель частоты UART
+ */
+struct UartDivider {
+    uint16_t Integer;               ///< IBRD
+    uint8_t  Fraction;              ///< FBRD, 1/64
+    int32_t  ErrorPpm;              ///< Отклонение получившейся частоты, миллионные доли
+};
+
+/**
+ * @brief Разбиение приёма на кадры
+ */
+struct UartRxFramer {
+    uint32_t Read;                  ///< Байт прочитано с начала приёма
+    uint32_t Seen;                  ///< Позиция записи на прошлом опросе
+    uint32_t Idle;                  ///< Опросов без новых байт
+    uint32_t Overruns;              ///< Переполнений кольца, непрочитанные байты отброшены
+};
+
+
+/**
+ * @brief Наибольшая частота обмена
+ */
+static inline uint32_t UartBaudMax(uint32_t clock) {
+    return clock / UART_BAUD_OVERSAMPLING;
+}
+
+
+/**
+ * @brief Делитель с округлением до 1/64, в отличие от UART_Init(), которая отбрасывает дробную часть
+ * @param clock UART_CLK, Гц
+ * @param baud Частота обмена, бод
+ * @return false - частота вне диапазона делителя или отклонение больше UART_BAUD_ERROR_MAX_PPM
+ */
+static inline bool UartBaudDivider(uint32_t clock, uint32_t baud, UartDivider &divider) {
+    if (baud == 0 || baud > UartBaudMax(clock))
+        return false;
+    // Делитель в 1/64: clock * 64 / (16 * baud) = clock * 4 / baud
+    uint64_t scaled = (static_cast<uint64_t>(clock) * 4 * 2 / baud + 1) / 2;
+    uint64_t integer = scaled >> UART_BAUD_FRACTION_BITS;
+    if (integer == 0 || integer > UART_BAUD_IBRD_MAX)
+        return false;
+    divider.Integer = static_cast<uint16_t>(integer);
+    divider.Fraction = static_cast<uint8_t>(scaled & ((1U << UART_BAUD_FRACTION_BITS) - 1));
+    int64_t real = static_cast<int64_t>(clock) * 4 / static_cast<int64_t>(scaled);
+    divider.ErrorPpm = static_cast<int32_t>((real - baud) * 1000000 / baud);
+    return divider.ErrorPpm <= UART_BAUD_ERROR_MAX_PPM && divider.ErrorPpm >= -UART_BAUD_ERROR_MAX_PPM;
+}
+
+
+static inline uint32_t UartDescriptorRemaining(const DmaDescriptor &descriptor) {
+    if ((descriptor.Control & DMA_CYCLE_Msk) == DMA_CYCLE_STOP)
+        return 0;
+    return ((descriptor.Control & DMA_N_MINUS_1_Msk) >> DMA_N_MINUS_1_Pos) + 1;
+}
+
+
+/**
+ * @brief Позиция записи кольца пинг-понг
+ *
+ * Контроллер переписывает управляющее слово после каждой пересылки. Половина, завершённая до обратного вызова,
+ * остановлена, запись уже идёт в другую половину.
+ * @param halves Половин, перезапущенных обратным вызовом; текущая половина - halves & 1, 0 - основная
+ * @param primary Основная структура канала
+ * @param alternate Альтернативная структура канала
+ * @param half Байт в половине
+ * @return Байт записано с начала приёма
+ */
+static inline uint32_t UartRxWritten(uint32_t halves, const DmaDescriptor &primary, const DmaDescriptor &alternate,
+                                     uint32_t half) {
+    const DmaDescriptor &current = (halves & 1) ? alternate : primary;
+    const DmaDescriptor &next = (halves & 1) ? primary : alternate;
+    if ((current.Control & DMA_CYCLE_Msk) != DMA_CYCLE_STOP)
+        return halves * half + half - UartDescriptorRemaining(current);
+    return (halves + 1) * half + half - ((next.Control & DMA_CYCLE_Msk) != DMA_CYCLE_STOP ?
+                                         UartDescriptorRemaining(next) : 0);
+}
+
+
+/**
+ * @brief Опрос позиции записи, один раз за период опроса
+ * @param framer Состояние
+ * @param written Позиция записи, UartRxWritten()
+ * @param ring Байт в кольце
+ * @return false - кольцо переполнено, непрочитанные байты отброшены
+ */
+static inline bool UartRxPoll(UartRxFramer &framer, uint32_t written, uint32_t ring) {
+    bool overrun = written - framer.Read > ring;
+    if (overrun) {
+        framer.Overruns++;
+        framer.Read = written;
+    }
+    if (written != framer.Seen) {
+        framer.Seen = written;
+        framer.Idle = 0;
+    } else if (framer.Idle != UINT32_MAX) {
+        framer.Idle++;
+    }
+    return !overrun;
+}
+
+
+/**
+ * @brief Готовый кадр после UartRxPoll()
+ * @param framer Состояние
+ * @param idle Опросов без новых байт, после которых кадр закончен
+ * @param maxFrame Наибольший кадр, не больше буфера кадра вызывающего
+ * @return Байт кадра с позиции framer.Read, 0 - кадра нет. После копирования framer.Read += длина
+ */
+static inline uint32_t UartRxFrame(const UartRxFramer &framer, uint32_t idle, uint32_t maxFrame) {
+    uint32_t pending = framer.Seen - framer.Read;
+    if (pending >= maxFrame)
+        return maxFrame;
+    if (pending != 0 && framer.Idle >= idle)
+        return pending;
+    return 0;
+}
+
+
+/**
+ * @brief Непрерывный участок кольца передачи от tail до head или до конца кольца
+ * @param head Байт записано в кольцо
+ * @param tail Байт передано
+ * @param ring Байт в кольце, степень 2
+ * @param max Наибольший участок
+ */
+static inline uint32_t UartTxSpan(uint32_t head, uint32_t tail, uint32_t ring, uint32_t max) {
+    uint32_t span = head - tail;
+    uint32_t toEnd = ring - (tail & (ring - 1));
+    if (span > toEnd)
+        span = toEnd;
+    return span > max ? max : span;
+}
+
+#endif //MILANDRBASE_UART_RING_H
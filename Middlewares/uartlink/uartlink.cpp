@@ -0,0 +1,357 @@
+/**
+ * @file uartlink.cpp
+ * @brief Обмен по UART2 на DMA: кольцо приёма с кадрами по паузе, очередь передачи
+ */
+
+#include <cstdio>
+#include <cstring>
+#include <MDR32F9Qx_config.h>
+#include <MDR32F9Qx_rst_clk.h>
+#include <MDR32F9Qx_port.h>
+#include <MDR32F9Qx_uart.h>
+#include <MDR32F9Qx_dma.h>
+#include <FreeRTOS.h>
+#include <task.h>
+#include <dmamgr.h>
+#include <events.h>
+#include <stackprof.h>
+#include "uartlink.h"
+
+#include "log_levels.h"
+#define LOG_LOCAL_LEVEL LOG_TAG_UART_LOCAL_LEVEL
+#include <mdr_log.h>
+static const char *TAG = "UART";
+
+#define UARTLINK_HW             MDR_UART2
+#define UARTLINK_RX_CHANNEL     DMA_Channel_UART2_RX
+#define UARTLINK_TX_CHANNEL     DMA_Channel_UART2_TX
+#define UARTLINK_RX_HALF        (CONFIG_UARTLINK_RX_SIZE / 2)
+#define UARTLINK_TX_SPAN_MAX    (1024)              ///< Элементов в цикле DMA
+#define UARTLINK_EVENT_RX       (1UL << 0)          ///< Заполнена половина кольца приёма или пришёл первый байт
+#define UARTLINK_RX_WAKE_IT     (UART_IMSC_RXIM | UART_IMSC_RTIM)
+#define UARTLINK_IRQ_PREEMPTIVE_PRIORITY (7)        ///< Не выше configMAX_SYSCALL_INTERRUPT_PRIORITY: публикуются события
+#define UARTLINK_IRQ_SUBPRIORITY         (0)
+#define UARTLINK_LCR_H          (UART_WordLength8b | UART_StopBits1 | UART_Parity_No | UART_FIFO_ON)
+
+static_assert((CONFIG_UARTLINK_RX_SIZE & (CONFIG_UARTLINK_RX_SIZE - 1)) == 0, "UART RX ring must be a power of 2");
+static_assert(UARTLINK_RX_HALF <= 1024, "UART RX half must fit one DMA cycle");
+static_assert((CONFIG_UARTLINK_TX_SIZE & (CONFIG_UARTLINK_TX_SIZE - 1)) == 0, "UART TX ring must be a power of 2");
+
+
+static uint8_t s_uRxRing[CONFIG_UARTLINK_RX_SIZE];
+static uint8_t s_uTxRing[CONFIG_UARTLINK_TX_SIZE];
+static uint8_t s_uFrame[CONFIG_UARTLINK_FRAME_MAX];
+
+static bool s_bInit = false;
+static volatile uint32_t s_uRxHalves;              ///< Половин, перезапущенных RxDone()
+static uint32_t s_uTxHead;                          ///< Байт записано в кольцо передачи
+static uint32_t s_uTxTail;                          ///< Байт передано DMA
+static uint32_t s_uTxSpan;                          ///< Байт в текущем цикле DMA, 0 - передача стоит
+static UartRxFramer s_xFramer;
+static UartLinkStats s_xStats;
+static EventChannel s_xRxEvent;
+static UartLinkHandler s_pHandler;
+static void *s_pContext;
+
+
+static void RxDescriptor(uint32_t half, DmaDescriptor &descriptor) {
+    DmaSegmentDescriptor(descriptor, {DmaMgrBusAddress(&UARTLINK_HW->DR),
+                                      DmaMgrBusAddress(&s_uRxRing[half * UARTLINK_RX_HALF]),
+                                      UARTLINK_RX_HALF, 0, DMA_SEGMENT_SOURCE_FIXED},
+                         DMA_CYCLE_PINGPONG, 0);
+}
+
+
+/*
+ * Перезапуск заполненных половин по порядку. Если DMA заполнил обе половины до прерывания, контроллер выключил
+ * канал: после перезапуска обеих он включается с половины, которая заполнится следующей
+ */
+static void RxDone(uint8_t channel, void *context, BaseType_t *pxHigherPriorityTaskWoken) {
+    (void)context;
+    uint32_t mask = 1UL << channel;
+    for (uint32_t i = 0; i < 2; i++) {
+        uint32_t half = s_uRxHalves & 1;
+        DMA_CtrlDataTypeDef *descriptor = half ? DmaMgrAlternate(channel) : DmaMgrPrimary(channel);
+        if ((descriptor->DMA_Control & DMA_CYCLE_Msk) != DMA_CYCLE_STOP)
+            break;
+        DmaDescriptor fresh;
+        RxDescriptor(half, fresh);
+        descriptor->DMA_Control = fresh.Control;
+        s_uRxHalves = s_uRxHalves + 1;
+    }
+    if ((MDR_DMA->CHNL_ENABLE_SET & mask) == 0) {
+        if (s_uRxHalves & 1)
+            MDR_DMA->CHNL_PRI_ALT_SET = mask;
+        else
+            MDR_DMA->CHNL_PRI_ALT_CLR = mask;
+        MDR_DMA->CHNL_ENABLE_SET = mask;
+    }
+    EventPostFromISR(s_xRxEvent, pxHigherPriorityTaskWoken);
+}
+
+
+static uint32_t RxWritten() {
+    uint32_t primask = __get_PRIMASK();
+    __disable_irq();
+    uint32_t written = UartRxWritten(s_uRxHalves,
+                                     *reinterpret_cast<const DmaDescriptor *>(DmaMgrPrimary(UARTLINK_RX_CHANNEL)),
+                                     *reinterpret_cast<const DmaDescriptor *>(DmaMgrAlternate(UARTLINK_RX_CHANNEL)),
+                                     UARTLINK_RX_HALF);
+    __set_PRIMASK(primask);
+    return written;
+}
+
+
+/*
+ * Следующий непрерывный участок кольца передачи. Вызывается с запрещёнными прерываниями или из обратного вызова
+ */
+static void TxStart() {
+    s_uTxSpan = UartTxSpan(s_uTxHead, s_uTxTail, CONFIG_UARTLINK_TX_SIZE, UARTLINK_TX_SPAN_MAX);
+    if (s_uTxSpan == 0)
+        return;
+    DmaDescriptor primary;
+    DmaSegmentDescriptor(primary, {DmaMgrBusAddress(&s_uTxRing[s_uTxTail & (CONFIG_UARTLINK_TX_SIZE - 1)]),
+                                   DmaMgrBusAddress(&UARTLINK_HW->DR),
+                                   static_cast<uint16_t>(s_uTxSpan), 0, DMA_SEGMENT_DEST_FIXED},
+                         DMA_CYCLE_BASIC, 0);
+    DmaMgrStartDescriptor(UARTLINK_TX_CHANNEL, primary);
+}
+
+
+static void TxDone(uint8_t channel, void *context, BaseType_t *pxHigherPriorityTaskWoken) {
+    (void)channel;
+    (void)context;
+    (void)pxHigherPriorityTaskWoken;
+    s_uTxTail += s_uTxSpan;
+    s_xStats.TxBytes += s_uTxSpan;
+    TxStart();
+}
+
+
+/*
+ * Делитель частоты. PL011 принимает IBRD и FBRD записью LCR_H
+ */
+static bool ApplyBaud(uint32_t baud) {
+    UartDivider divider;
+    if (!UartBaudDivider(SystemCoreClock, baud, divider))
+        return false;
+    UARTLINK_HW->IBRD = divider.Integer;
+    UARTLINK_HW->FBRD = divider.Fraction;
+    UARTLINK_HW->LCR_H = UARTLINK_LCR_H;
+    s_xStats.Baud = baud;
+    MDR_LOGD(TAG, "%lu baud, IBRD %u, FBRD %u, error %ld ppm", baud, divider.Integer, divider.Fraction,
+             divider.ErrorPpm);
+    return true;
+}
+
+
+static void InitHW() {
+    RST_CLK_PCLKcmd(RST_CLK_PCLK_PORTF | RST_CLK_PCLK_UART2, ENABLE);
+    UART_DeInit(UARTLINK_HW);
+    UART_BRGInit(UARTLINK_HW, UART_HCLKdiv1);
+
+PORT_InitTypeDef PORT_InitStructure;
+    PORT_StructInit(&PORT_InitStructure);
+    // PF0 - RXD вход, PF1 - TXD выход, переопределённая функция
+    PORT_InitStructure.PORT_Pin = PORT_Pin_0;
+    PORT_InitStructure.PORT_OE = PORT_OE_IN;
+    PORT_InitStructure.PORT_FUNC = PORT_FUNC_OVERRID;
+    PORT_InitStructure.PORT_MODE = PORT_MODE_DIGITAL;
+    PORT_InitStructure.PORT_SPEED = PORT_SPEED_MAXFAST;
+    PORT_Init(MDR_PORTF, &PORT_InitStructure);
+
+    PORT_InitStructure.PORT_Pin = PORT_Pin_1;
+    PORT_InitStructure.PORT_OE = PORT_OE_OUT;
+    PORT_Init(MDR_PORTF, &PORT_InitStructure);
+}
+
+
+/**
+ * @brief Настройка UART2 и каналов DMA, запуск приёма в кольцо. Можно вызывать до запуска планировщика
+ * @param baud Частота обмена, до UartBaudMax(SystemCoreClock)
+ * @return false - частота недостижима или каналы DMA заняты
+ */
+bool UartLinkInit(uint32_t baud) {
+    if (s_bInit)
+        return true;
+    if (!DmaMgrClaim(UARTLINK_RX_CHANNEL, "UartLink"))
+        return false;
+    if (!DmaMgrClaim(UARTLINK_TX_CHANNEL, "UartLink")) {
+        DmaMgrRelease(UARTLINK_RX_CHANNEL);
+        return false;
+    }
+
+    InitHW();
+    if (!ApplyBaud(baud)) {
+        MDR_LOGE(TAG, "Baud %lu is not reachable, maximum %lu", baud, UartBaudMax(SystemCoreClock));
+        DmaMgrRelease(UARTLINK_RX_CHANNEL);
+        DmaMgrRelease(UARTLINK_TX_CHANNEL);
+        return false;
+    }
+
+    DmaMgrSetCallback(UARTLINK_RX_CHANNEL, RxDone, nullptr, true);
+    DmaMgrSetCallback(UARTLINK_TX_CHANNEL, TxDone, nullptr, false);
+    DmaDescriptor primary, alternate;
+    RxDescriptor(0, primary);
+    RxDescriptor(1, alternate);
+    DmaMgrStartDescriptor(UARTLINK_RX_CHANNEL, primary, &alternate);
+
+    // Прерывание приёма по 2 байтам в FIFO, таймаут приёма - по одному. Разрешаются только на время простоя
+    UARTLINK_HW->IFLS &= ~UART_IFLS_RXIFLSEL_Msk;
+    UARTLINK_HW->IMSC = 0;
+    NVIC_SetPriority(UART2_IRQn, NVIC_EncodePriority(NVIC_GetPriorityGrouping(), UARTLINK_IRQ_PREEMPTIVE_PRIORITY,
+                                                     UARTLINK_IRQ_SUBPRIORITY));
+    NVIC_EnableIRQ(UART2_IRQn);
+
+    UARTLINK_HW->DMACR = UART_DMA_RXE | UART_DMA_TXE;
+    UARTLINK_HW->CR = UART_HardwareFlowControl_RXE | UART_HardwareFlowControl_TXE | UART_CR_UARTEN;
+    s_bInit = true;
+    return true;
+}
+
+
+/*
+ * Простой без опроса: запросы DMA приёма выключаются, первые байты остаются в FIFO и поднимают прерывание приёма
+ * или таймаута приёма. UART2_IRQHandler() включает DMA обратно, DMA забирает байты из FIFO по порядку.
+ * Возвращает false, если DMA успел принять байт до выключения: разбор продолжается опросом
+ */
+static bool RxSleep() {
+    // Без вытеснения: при выключенных DMA и прерывании FIFO на 16 байт переполнится за 32 мкс на 5 Мбод
+    uint32_t primask = __get_PRIMASK();
+    __disable_irq();
+    UARTLINK_HW->DMACR &= ~UART_DMA_RXE;
+    bool idle = RxWritten() == s_xFramer.Seen;
+    if (idle) {
+        UARTLINK_HW->ICR = UARTLINK_RX_WAKE_IT;
+        UARTLINK_HW->IMSC = UARTLINK_RX_WAKE_IT;
+    } else {
+        UARTLINK_HW->DMACR |= UART_DMA_RXE;
+    }
+    __set_PRIMASK(primask);
+    return idle;
+}
+
+
+extern "C" void UART2_IRQHandler() {
+    STACKPROF_ISR_ENTER();
+    BaseType_t xHigherPriorityTaskWoken = pdFALSE;
+    UARTLINK_HW->IMSC = 0;
+    UARTLINK_HW->DMACR |= UART_DMA_RXE;
+    EventPostFromISR(s_xRxEvent, &xHigherPriorityTaskWoken);
+    portYIELD_FROM_ISR(xHigherPriorityTaskWoken);
+}
+
+
+/*
+ * Разбор приёма. Пока в кольце есть неразобранные байты, конец кадра ищется опросом позиции записи каждый тик.
+ * Без них задача спит до первого байта или заполнения половины кольца
+ */
+static void Execute(void *pvParameters) {
+    (void)pvParameters;
+    EventInit(s_xRxEvent, xTaskGetCurrentTaskHandle(), UARTLINK_EVENT_RX, "uart_rx");
+    for (;;) {
+        if (s_xFramer.Seen == s_xFramer.Read && RxSleep())
+            EventWait(s_xRxEvent, portMAX_DELAY);
+        else
+            EventWait(s_xRxEvent, 1);
+        if (UARTLINK_HW->RSR_ECR & UART_RSR_ECR_OE) {
+            UARTLINK_HW->RSR_ECR = 0;
+            s_xStats.FifoOverruns++;
+        }
+        if (!UartRxPoll(s_xFramer, RxWritten(), CONFIG_UARTLINK_RX_SIZE)) {
+            s_xStats.RxOverruns = s_xFramer.Overruns;
+            MDR_LOGW(TAG, "RX ring overrun");
+        }
+
+        uint32_t length;
+        while ((length = UartRxFrame(s_xFramer, CONFIG_UARTLINK_IDLE_TICKS, CONFIG_UARTLINK_FRAME_MAX)) != 0) {
+            uint32_t offset = s_xFramer.Read & (CONFIG_UARTLINK_RX_SIZE - 1);
+            uint32_t first = CONFIG_UARTLINK_RX_SIZE - offset;
+            if (first > length)
+                first = length;
+            memcpy(s_uFrame, &s_uRxRing[offset], first);
+            memcpy(&s_uFrame[first], s_uRxRing, length - first);
+            s_xFramer.Read += length;
+            s_xStats.RxBytes += length;
+            s_xStats.RxFrames++;
+            if (s_pHandler != nullptr)
+                s_pHandler(s_uFrame, length, s_pContext);
+        }
+    }
+}
+
+
+/**
+ * @brief Запуск задачи приёма кадров
+ * @param handler Обработчик кадров, вызывается в задаче приёма
+ * @param context Параметр обработчика
+ */
+void UartLinkStart(UartLinkHandler handler, void *context) {
+    if (!s_bInit)
+        return;
+    s_pHandler = handler;
+    s_pContext = context;
+    xTaskCreate(Execute, "UartLink", configMINIMAL_STACK_SIZE * 2, nullptr, tskIDLE_PRIORITY + 2, nullptr);
+}
+
+
+/**
+ * @brief Смена частоты обмена после передачи очереди. Вызывается из задачи, принимаемые байты теряются
+ * @return false - частота недостижима, прежняя частота не изменена
+ */
+bool UartLinkSetBaud(uint32_t baud) {
+    UartDivider divider;
+    if (!s_bInit || !UartBaudDivider(SystemCoreClock, baud, divider))
+        return false;
+    while (s_uTxSpan != 0 || (UARTLINK_HW->FR & UART_FR_BUSY))
+        vTaskDelay(1);
+    uint32_t cr = UARTLINK_HW->CR;
+    UARTLINK_HW->CR = cr & ~UART_CR_UARTEN;
+    ApplyBaud(baud);
+    UARTLINK_HW->CR = cr;
+    return true;
+}
+
+
+/**
+ * @brief Постановка байт в очередь передачи, без ожидания. Можно вызывать из прерываний
+ * @return Байт принято, остальные отброшены при полном кольце
+ */
+size_t UartLinkWrite(const void *data, size_t size) {
+    if (!s_bInit)
+        return 0;
+    auto bytes = static_cast<const uint8_t *>(data);
+    uint32_t primask = __get_PRIMASK();
+    __disable_irq();
+    size_t free = CONFIG_UARTLINK_TX_SIZE - (s_uTxHead - s_uTxTail);
+    size_t accepted = size < free ? size : free;
+    s_xStats.TxDropped += size - accepted;
+    for (size_t i = 0; i < accepted; i++)
+        s_uTxRing[(s_uTxHead + i) & (CONFIG_UARTLINK_TX_SIZE - 1)] = bytes[i];
+    s_uTxHead += accepted;
+    if (s_uTxSpan == 0)
+        TxStart();
+    __set_PRIMASK(primask);
+    return accepted;
+}
+
+
+/**
+ * @brief Вывод лога в UART, для mdr_log_set_vprintf(). Строка длиннее CONFIG_UARTLINK_LOG_LINE обрезается
+ */
+int UartLinkVprintf(const char *format, va_list args) {
+    char line[CONFIG_UARTLINK_LOG_LINE];
+    int length = vsnprintf(line, sizeof(line), format, args);
+    if (length <= 0)
+        return length;
+    size_t size = static_cast<size_t>(length) < sizeof(line) ? length : sizeof(line) - 1;
+    return static_cast<int>(UartLinkWrite(line, size));
+}
+
+
+void UartLinkGetStats(UartLinkStats &stats) {
+    uint32_t primask = __get_PRIMASK();
+    __disable_irq();
+    stats = s_xStats;
+    __set_PRIMASK(primask);
+}
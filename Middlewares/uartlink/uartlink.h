@@ -0,0 +1,60 @@
+/**
+ * @file uartlink.h
+ * @brief Обмен по UART2 на DMA: кольцо приёма с кадрами по паузе, очередь передачи
+ *
+ * UART2: PF0 - RXD, PF1 - TXD, переопределённая функция. UART_CLK = HCLK, частота обмена до HCLK / 16,
+ * 5 Мбод на 80 МГц. 8 бит, без чётности, 1 стоп-бит, без аппаратного управления потоком.
+ *
+ * Приём: канал DMA_Channel_UART2_RX пинг-понг по одиночным запросам пишет в кольцо CONFIG_UARTLINK_RX_SIZE.
+ * Прерывание таймаута приёма PL011 требует непрочитанных байт в FIFO, а DMA по одиночным запросам FIFO опустошает,
+ * поэтому конец кадра находит задача приёма: позиция записи DMA не менялась CONFIG_UARTLINK_IDLE_TICKS опросов.
+ * Опрос идёт только при неразобранных байтах. В простое запросы DMA приёма выключены, задача ждёт без таймаута,
+ * а первый байт в FIFO будит её прерыванием UART2 (приём или таймаут приёма), которое включает DMA обратно.
+ * Кадр копируется в буфер и передаётся обработчику UartLinkStart() в задаче приёма. Поток без пауз отдаётся
+ * кадрами по CONFIG_UARTLINK_FRAME_MAX байт.
+ *
+ * Передача: UartLinkWrite() копирует байты в кольцо CONFIG_UARTLINK_TX_SIZE и возвращает управление, канал
+ * DMA_Channel_UART2_TX передаёт кольцо непрерывными участками. При полном кольце лишние байты отбрасываются
+ * и считаются, ожидания нет: функция вызывается из прерываний и как вывод лога UartLinkVprintf().
+ */
+
+#ifndef MILANDRBASE_UARTLINK_H
+#define MILANDRBASE_UARTLINK_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include <stdarg.h>
+#include "app_config.h"
+#include "uart_ring.h"
+
+
+/**
+ * @brief Обработчик кадра, вызывается в задаче приёма
+ * @param data Кадр, действителен до возврата
+ * @param size Байт, 1..CONFIG_UARTLINK_FRAME_MAX
+ * @param context Параметр UartLinkStart()
+ */
+typedef void (*UartLinkHandler)(const uint8_t *data, size_t size, void *context);
+
+/**
+ * @brief Счётчики обмена
+ */
+struct UartLinkStats {
+    uint32_t Baud;                  ///< Установленная частота обмена
+    uint32_t RxBytes;               ///< Байт передано обработчику
+    uint32_t RxFrames;              ///< Кадров передано обработчику
+    uint32_t RxOverruns;            ///< Переполнений кольца приёма
+    uint32_t FifoOverruns;          ///< Переполнений FIFO приёма UART: DMA не успел
+    uint32_t TxBytes;               ///< Байт передано DMA
+    uint32_t TxDropped;             ///< Байт отброшено при полном кольце передачи
+};
+
+
+bool UartLinkInit(uint32_t baud);
+void UartLinkStart(UartLinkHandler handler, void *context);
+bool UartLinkSetBaud(uint32_t baud);
+size_t UartLinkWrite(const void *data, size_t size);
+int UartLinkVprintf(const char *format, va_list args);
+void UartLinkGetStats(UartLinkStats &stats);
+
+#endif //MILANDRBASE_UARTLINK_H
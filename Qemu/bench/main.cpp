@@ -0,0 +1,321 @@
+/**
+ * @file main.cpp
+ * @brief Микробенчмарки горячего кода прошивки на Cortex-M3 в QEMU mps2-an385
+ *
+ * Запуск: qemu-system-arm -M mps2-an385 -nographic -semihosting -icount shift=0 -kernel milandr_qemu_bench.elf
+ *
+ * Каждый бенчмарк выполняется BENCH_REPEAT раз, из счёта вычитается такой же цикл с пустой функцией. В отчёте
+ * число операций и инструкций Thumb-2 на операцию с десятыми: операция - вызов TimerIIC_IRQHandler(),
+ * байт crc8(), запись или чтение RingBuffer, строка лога. Код возврата 0 - проверки результатов пройдены.
+ */
+
+#include <cstdio>
+#include <cstring>
+#include <MDR32F9Qx_config.h>
+#include <mdr_log.h>
+#include <iicslave.h>
+#include <ring_buffer.h>
+#include <crc8.h>
+#include "qemu.h"
+
+
+#define BENCH_REPEAT            (100)
+#define BENCH_IIC_ADDRESS       (0x37)                  ///< Адрес IICSlaveTask
+#define BENCH_IIC_TRACE_SIZE    (512)
+#define BENCH_CRC_BLOCK         (64)
+#define BENCH_RING_SIZE         (64)
+#define BENCH_LOG_LINE_SIZE     (128)
+
+static const char *TAG = "BENCH";
+
+
+namespace {
+
+struct Benchmark {
+    const char *Name;
+    void (*Setup)();                ///< Подготовка до замера, может быть nullptr
+    uint32_t (*Run)();              ///< Одна итерация. @return число операций
+    bool (*Check)();                ///< Проверка результата после замера, может быть nullptr
+};
+
+/**
+ * @brief Событие захвата таймера: флаг STATUS и уровни линий в момент прерывания
+ */
+struct IicEvent {
+    uint32_t Status;
+    uint8_t  Sda;
+    uint8_t  Scl;
+};
+
+}
+
+
+static volatile uint32_t s_uSink;      ///< Результаты, которые компилятор не должен выбросить
+
+
+/*
+ * I2C ведомый: регистры таймера и порта в RAM, уровни линий подставляет трасса. Флаги каналов
+ * как в IICSlaveTask: SDA - TIMER_CHANNEL1, SCL - TIMER_CHANNEL2
+ */
+static MDR_TIMER_TypeDef s_xTimer;
+static MDR_PORT_TypeDef s_xPort;
+static uint32_t s_uSdaLevel;
+static uint32_t s_uSclLevel;
+static IICSlave s_xSlave;
+
+static IicEvent s_xTrace[BENCH_IIC_TRACE_SIZE];
+static uint32_t s_uTraceLength;
+static bool s_bTraceSda;
+static bool s_bTraceScl;
+
+static const uint8_t s_uIicRegister[8] = {0xA0, 0xA1, 0xBC, 0xCC, 0xDE, 0x12, 0x68, 0x57};
+static uint32_t s_uIicTxIndex;
+static uint32_t s_uIicMatches;
+static uint32_t s_uIicStops;
+static uint8_t s_uIicReceived;
+
+
+static bool IicAddressMatch(bool read, bool restart) {
+    (void)read;
+    (void)restart;
+    s_uIicMatches++;
+    s_uIicTxIndex = 0;
+    return true;
+}
+
+static bool IicDataReceived(uint8_t data) {
+    s_uIicReceived = data;
+    return true;
+}
+
+static bool IicTransmitByte(uint8_t &data) {
+    data = s_uIicRegister[s_uIicTxIndex++ % sizeof(s_uIicRegister)];
+    return true;
+}
+
+static bool IicStop() {
+    s_uIicStops++;
+    return true;
+}
+
+
+static void TraceEdge(uint32_t status) {
+    if (s_uTraceLength < BENCH_IIC_TRACE_SIZE)
+        s_xTrace[s_uTraceLength++] = {status, s_bTraceSda, s_bTraceScl};
+}
+
+static void TraceSda(bool level) {
+    if (level != s_bTraceSda) {
+        s_bTraceSda = level;
+        TraceEdge(level ? s_xSlave.hw.SDARiseFlag : s_xSlave.hw.SDAFallFlag);
+    }
+}
+
+static void TraceScl(bool level) {
+    if (level != s_bTraceScl) {
+        s_bTraceScl = level;
+        TraceEdge(level ? s_xSlave.hw.SCLRiseFlag : s_xSlave.hw.SCLFallFlag);
+    }
+}
+
+static void TraceStart() {
+    if (!s_bTraceSda || !s_bTraceScl) {     // Повторный START
+        TraceScl(false);
+        TraceSda(true);
+        TraceScl(true);
+    }
+    TraceSda(false);
+}
+
+/// Байт и бит ACK: уровни SDA на шине, кто бы их ни выставлял
+static void TraceByte(uint8_t value, bool ack) {
+    for (int bit = 7; bit >= -1; bit--) {
+        TraceScl(false);
+        TraceSda(bit >= 0 ? (value >> bit) & 1 : !ack);
+        TraceScl(true);
+    }
+}
+
+static void TraceStop() {
+    TraceScl(false);
+    TraceSda(false);
+    TraceScl(true);
+    TraceSda(true);
+}
+
+
+/*
+ * Чтение 8 байт регистра 0, как у стенда симулятора: запись адреса регистра, повторный START, чтение
+ */
+static void SetupIicSlave() {
+    s_xSlave.hw.SDA = {&s_uSdaLevel, &s_xPort, PORT_FUNC_ALTER << 2, ~(0b11U << 2)};
+    s_xSlave.hw.SCL = {&s_uSclLevel, &s_xPort, PORT_FUNC_ALTER << 6, ~(0b11U << 6)};
+    s_xSlave.hw.timer = &s_xTimer;
+    s_xSlave.hw.SDARiseFlag = TIMER_STATUS_CCR_CAP_CH1;
+    s_xSlave.hw.SDAFallFlag = TIMER_STATUS_CCR_CAP1_CH1;
+    s_xSlave.hw.SCLRiseFlag = TIMER_STATUS_CCR_CAP_CH2;
+    s_xSlave.hw.SCLFallFlag = TIMER_STATUS_CCR_CAP1_CH2;
+    IICSlaveSetAddress(s_xSlave, BENCH_IIC_ADDRESS);
+    IICSlaveCallback(s_xSlave, IicAddressMatch, IicDataReceived, IicTransmitByte, IicStop);
+
+    s_uTraceLength = 0;
+    s_bTraceSda = true;
+    s_bTraceScl = true;
+    TraceStart();
+    TraceByte(BENCH_IIC_ADDRESS << 1, true);
+    TraceByte(0x00, true);
+    TraceStart();
+    TraceByte((BENCH_IIC_ADDRESS << 1) | 0x01, true);
+    for (uint32_t i = 0; i < sizeof(s_uIicRegister); i++)
+        TraceByte(s_uIicRegister[i], i + 1 < sizeof(s_uIicRegister));
+    TraceStop();
+}
+
+static uint32_t RunIicSlave() {
+    for (uint32_t i = 0; i < s_uTraceLength; i++) {
+        const IicEvent &event = s_xTrace[i];
+        s_xTimer.STATUS = event.Status;
+        s_uSdaLevel = event.Sda;
+        s_uSclLevel = event.Scl;
+        TimerIIC_IRQHandler(s_xSlave);
+    }
+    return s_uTraceLength;
+}
+
+static bool CheckIicSlave() {
+    // Две передачи с совпадением адреса и один STOP на прогон
+    return s_uTraceLength < BENCH_IIC_TRACE_SIZE && s_uIicReceived == 0x00 &&
+           s_uIicMatches == 2 * BENCH_REPEAT && s_uIicStops == BENCH_REPEAT;
+}
+
+
+/*
+ * crc8() хоста, копия RegisterCrc() протокола регистров: кадр записи регистра (3 байта) и блок по байтам
+ */
+static uint8_t s_uCrcBlock[BENCH_CRC_BLOCK];
+
+static void SetupCrc8() {
+    for (uint32_t i = 0; i < sizeof(s_uCrcBlock); i++)
+        s_uCrcBlock[i] = static_cast<uint8_t>(i * 7 + 3);
+}
+
+static uint32_t RunCrc8Frame() {
+    s_uSink = crc8(s_uCrcBlock, 3);
+    return 1;
+}
+
+static uint32_t RunCrc8Block() {
+    s_uSink = crc8(s_uCrcBlock, sizeof(s_uCrcBlock));
+    return sizeof(s_uCrcBlock);
+}
+
+static bool CheckCrc8() {
+    static const uint8_t check[] = {'1', '2', '3', '4', '5', '6', '7', '8', '9'};
+    return crc8(check, sizeof(check)) == 0xA1;
+}
+
+
+static RingBuffer<BENCH_RING_SIZE> s_xRing;
+static uint32_t s_uRingSum;
+
+static uint32_t RunRingBuffer() {
+    for (uint32_t i = 0; i < BENCH_RING_SIZE / 2; i++)
+        s_xRing.Write(static_cast<uint8_t>(i));
+    uint8_t value;
+    uint32_t sum = 0;
+    while (s_xRing.Read(value))
+        sum += value;
+    s_uRingSum = sum;
+    return BENCH_RING_SIZE;
+}
+
+static bool CheckRingBuffer() {
+    return s_xRing.IsEmpty() && s_uRingSum == (BENCH_RING_SIZE / 2) * (BENCH_RING_SIZE / 2 - 1) / 2;
+}
+
+
+/*
+ * Логгер: форматирование строки в буфер, как перед выводом в RTT, и отброшенная по уровню строка
+ */
+static char s_cLogLine[BENCH_LOG_LINE_SIZE];
+static uint32_t s_uLogLines;
+
+static int LogSink(const char *format, va_list args) {
+    s_uLogLines++;
+    return vsnprintf(s_cLogLine, sizeof(s_cLogLine), format, args);
+}
+
+static void SetupLog() {
+    s_uLogLines = 0;
+}
+
+static uint32_t RunLogInfo() {
+    MDR_LOGI(TAG, "ch %d value %u", 3, 4095U);
+    return 1;
+}
+
+static uint32_t RunLogFiltered() {
+    MDR_LOGD(TAG, "ch %d value %u", 3, 4095U);
+    return 1;
+}
+
+static bool CheckLogInfo() {
+    return s_uLogLines == BENCH_REPEAT && strstr(s_cLogLine, "ch 3 value 4095") != nullptr;
+}
+
+static bool CheckLogFiltered() {
+    return s_uLogLines == 0;
+}
+
+
+static const Benchmark s_xBenchmarks[] = {
+        {"iicslave_irq",  SetupIicSlave, RunIicSlave,    CheckIicSlave},
+        {"crc8_frame",    SetupCrc8,     RunCrc8Frame,   CheckCrc8},
+        {"crc8_byte",     SetupCrc8,     RunCrc8Block,   CheckCrc8},
+        {"ringbuffer",    nullptr,       RunRingBuffer,  CheckRingBuffer},
+        {"log_info",      SetupLog,      RunLogInfo,     CheckLogInfo},
+        {"log_filtered",  SetupLog,      RunLogFiltered, CheckLogFiltered},
+};
+
+
+__attribute__((noinline)) static uint32_t RunEmpty() {
+    return 1;
+}
+
+/**
+ * @brief Прогон BENCH_REPEAT итераций
+ * @param ops Число операций за прогон
+ * @return Инструкции за прогон
+ */
+static uint64_t Measure(uint32_t (*run)(), uint32_t &ops) {
+    ops = 0;
+    uint64_t start = QemuInstructions();
+    for (uint32_t i = 0; i < BENCH_REPEAT; i++)
+        ops += run();
+    return QemuInstructions() - start;
+}
+
+
+int main() {
+    mdr_log_set_vprintf(LogSink);
+    mdr_log_level_set("*", MDR_LOG_INFO);
+
+    uint32_t ops;
+    uint64_t overhead = Measure(RunEmpty, ops);
+
+    QemuPrintf("%-16s %8s %12s\n", "benchmark", "ops", "insn/op");
+    bool passed = true;
+    for (const auto &benchmark : s_xBenchmarks) {
+        if (benchmark.Setup != nullptr)
+            benchmark.Setup();
+        uint64_t instructions = Measure(benchmark.Run, ops);
+        bool ok = benchmark.Check == nullptr || benchmark.Check();
+        passed &= ok;
+
+        uint64_t net = instructions > overhead ? instructions - overhead : 0;
+        auto tenths = static_cast<uint32_t>(net * 10 / ops);
+        QemuPrintf("%-16s %8lu %10lu.%lu%s\n", benchmark.Name, ops, tenths / 10, tenths % 10, ok ? "" : "  FAIL");
+    }
+    QemuPrintf("%s, %lu instructions per SysTick tick\n", passed ? "PASS" : "FAIL", QEMU_INSTRUCTIONS_PER_TICK);
+    return passed ? 0 : 1;
+}
@@ -0,0 +1,34 @@
+/**
+ * @file qemu.h
+ * @brief Минимальное окружение Cortex-M3 платы QEMU mps2-an385 для микробенчмарков
+ *
+ * Модули прошивки собираются тем же arm-none-eabi-gcc и с теми же флагами, что и прошивка, и выполняются
+ * в QEMU без 1986ВЕ92. Вывод и завершение через semihosting. Счёт инструкций - SysTick от частоты ядра
+ * платы при запуске QEMU с -icount shift=QEMU_ICOUNT_SHIFT: виртуальное время идёт 2^shift нс на инструкцию,
+ * один такт SysTick - QEMU_INSTRUCTIONS_PER_TICK выполненных инструкций Thumb-2. Конвейер, ожидание flash
+ * и загрузки данных QEMU не моделирует: счёт сравнивает число инструкций, а не такты 1986ВЕ92.
+ */
+
+#ifndef MILANDRBASE_QEMU_H
+#define MILANDRBASE_QEMU_H
+
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define QEMU_SYSCLK_HZ              (25000000UL)    ///< Частота ядра mps2-an385, тактирует SysTick
+#define QEMU_ICOUNT_SHIFT           (0)             ///< Параметр -icount shift при запуске QEMU
+#define QEMU_INSTRUCTIONS_PER_TICK  (1000000000UL / QEMU_SYSCLK_HZ >> QEMU_ICOUNT_SHIFT)
+
+
+uint64_t QemuInstructions(void);
+int QemuPrintf(const char *format, ...) __attribute__((format(printf, 1, 2)));
+void QemuExit(int code) __attribute__((noreturn));
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif //MILANDRBASE_QEMU_H
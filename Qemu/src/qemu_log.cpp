@@ -0,0 +1,44 @@
+/**
+ * @file qemu_log.cpp
+ * @brief Порт логгера без FreeRTOS для бенчмарков: один поток, блокировка не нужна
+ *
+ * Заменяет log_freertos.cpp. Отметка времени - миллисекунды виртуального времени QEMU, форматирование
+ * в log.cpp выполняется так же, как в прошивке.
+ */
+
+#include <stdint.h>
+#include <stdio.h>
+#include "mdr_log.h"
+#include "mdr_log_private.h"
+#include "qemu.h"
+
+
+void mdr_log_impl_lock() {
+}
+
+
+bool mdr_log_impl_lock_timeout() {
+    return true;
+}
+
+
+void mdr_log_impl_unlock() {
+}
+
+
+char *mdr_log_system_timestamp() {
+    static char buffer[18] = {0};
+    uint32_t timestamp = mdr_log_timestamp();
+    snprintf(buffer, sizeof(buffer), "%lu", timestamp);
+    return buffer;
+}
+
+
+uint32_t mdr_log_timestamp(void) {
+    return mdr_log_early_timestamp();
+}
+
+
+uint32_t mdr_log_early_timestamp(void) {
+    return (QemuInstructions() << QEMU_ICOUNT_SHIFT) / 1000000;
+}
@@ -0,0 +1,48 @@
+/**
+ * @file qemu_semihost.c
+ * @brief Вывод и завершение через semihosting ARM (QEMU -semihosting)
+ */
+
+#include <stdarg.h>
+#include <stdio.h>
+#include "qemu.h"
+
+
+#define SEMIHOST_SYS_WRITE0             (0x04)
+#define SEMIHOST_SYS_EXIT               (0x18)
+#define SEMIHOST_ADP_APPLICATION_EXIT   (0x20026)   ///< QEMU завершается с кодом 0
+#define SEMIHOST_ADP_RUNTIME_ERROR      (0x20023)   ///< QEMU завершается с кодом 1
+
+#define QEMU_PRINTF_BUFFER_SIZE         (256)
+
+
+static uint32_t Semihost(uint32_t operation, const void *argument) {
+    register uint32_t r0 __asm__("r0") = operation;
+    register const void *r1 __asm__("r1") = argument;
+    __asm__ volatile ("bkpt 0xAB" : "+r"(r0) : "r"(r1) : "memory");
+    return r0;
+}
+
+
+/**
+ * @brief printf в консоль QEMU. Строка длиннее QEMU_PRINTF_BUFFER_SIZE обрезается
+ */
+int QemuPrintf(const char *format, ...) {
+    char buffer[QEMU_PRINTF_BUFFER_SIZE];
+    va_list args;
+    va_start(args, format);
+    int length = vsnprintf(buffer, sizeof(buffer), format, args);
+    va_end(args);
+    Semihost(SEMIHOST_SYS_WRITE0, buffer);
+    return length;
+}
+
+
+/**
+ * @brief Завершение QEMU. Код процесса QEMU: 0 при code == 0, иначе 1
+ */
+void QemuExit(int code) {
+    Semihost(SEMIHOST_SYS_EXIT, (const void *) (code == 0 ? SEMIHOST_ADP_APPLICATION_EXIT
+                                                          : SEMIHOST_ADP_RUNTIME_ERROR));
+    for (;;) {}
+}
@@ -0,0 +1,100 @@
+/**
+ * @file qemu_startup.c
+ * @brief Таблица векторов, запуск и счётчик инструкций на SysTick для mps2-an385
+ *
+ * Прерывания платы, кроме SysTick, не используются. Отказы завершают QEMU с кодом ошибки, чтобы сбой
+ * бенчмарка не выглядел как зависание.
+ */
+
+#include <stdint.h>
+#include <MDR32Fx.h>
+#include "qemu.h"
+
+
+#define QEMU_SYSTICK_RELOAD     (SysTick_LOAD_RELOAD_Msk)
+
+
+extern uint32_t __stack;
+extern uint32_t _sidata;
+extern uint32_t __data_start__;
+extern uint32_t __data_end__;
+extern uint32_t __bss_start__;
+extern uint32_t __bss_end__;
+extern void (*__init_array_start[])(void);
+extern void (*__init_array_end[])(void);
+
+extern int main(void);
+
+void Reset_Handler(void);
+void Fault_Handler(void);
+void SysTick_Handler(void);
+
+static volatile uint32_t s_uSysTickWraps;
+
+
+__attribute__((section(".isr_vector"), used))
+void (*const g_pfnVectors[16])(void) = {
+        (void (*)(void)) &__stack,
+        Reset_Handler,
+        Fault_Handler,          // NMI
+        Fault_Handler,          // HardFault
+        Fault_Handler,          // MemManage
+        Fault_Handler,          // BusFault
+        Fault_Handler,          // UsageFault
+        0, 0, 0, 0,
+        Fault_Handler,          // SVCall
+        Fault_Handler,          // DebugMon
+        0,
+        Fault_Handler,          // PendSV
+        SysTick_Handler,
+};
+
+
+void Reset_Handler(void) {
+    uint32_t *from = &_sidata;
+    for (uint32_t *p = &__data_start__; p < &__data_end__; )
+        *p++ = *from++;
+    for (uint32_t *p = &__bss_start__; p < &__bss_end__; )
+        *p++ = 0;
+    for (uint32_t i = 0; i < (uint32_t)(__init_array_end - __init_array_start); i++)
+        __init_array_start[i]();
+
+    SysTick->LOAD = QEMU_SYSTICK_RELOAD;
+    SysTick->VAL = 0;
+    SysTick->CTRL = SysTick_CTRL_CLKSOURCE_Msk | SysTick_CTRL_TICKINT_Msk | SysTick_CTRL_ENABLE_Msk;
+
+    QemuExit(main());
+}
+
+
+void Fault_Handler(void) {
+    QemuPrintf("FAULT: IPSR %lu, CFSR 0x%08lX, BFAR 0x%08lX\n", __get_IPSR(), SCB->CFSR, SCB->BFAR);
+    QemuExit(2);
+}
+
+
+void SysTick_Handler(void) {
+    s_uSysTickWraps++;
+}
+
+
+/**
+ * @brief Выполненные инструкции с запуска, шаг QEMU_INSTRUCTIONS_PER_TICK
+ *
+ * 24-битный SysTick продлевается счётчиком перезагрузок. Перезагрузка, прерывание которой ещё не
+ * обработано, учитывается по PENDSTSET.
+ */
+uint64_t QemuInstructions(void) {
+    uint32_t primask = __get_PRIMASK();
+    __disable_irq();
+    uint32_t value = SysTick->VAL;
+    uint64_t wraps = s_uSysTickWraps;
+    if (SCB->ICSR & SCB_ICSR_PENDSTSET_Msk) {
+        value = SysTick->VAL;
+        wraps++;
+    }
+    __set_PRIMASK(primask);
+
+    uint64_t ticks = wraps * (QEMU_SYSTICK_RELOAD + 1ULL) + (QEMU_SYSTICK_RELOAD - value);
+    return ticks * QEMU_INSTRUCTIONS_PER_TICK;
+}
@@ -0,0 +1,688 @@
+/**
+ * @file main.cpp
+ * @brief Стенд симулятора: задачи прошивки под Linux и внешние устройства сценариев
+ *
+ * Запуск: milandr_sim <сценарий> [-v]. Сценарий запускает задачи прошивки, задача стенда играет роль внешнего
+ * устройства, проверяет ответы и печатает время и счётчики симулятора. Код возврата 0 - сценарий пройден.
+ * -v включает лог прошивки уровня VERBOSE, по умолчанию выводятся только предупреждения и ошибки.
+ */
+
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <ctime>
+#include <unistd.h>
+#include <MDR32F9Qx_config.h>
+#include <FreeRTOS.h>
+#include <task.h>
+#include <mdr_log.h>
+#include <stackprof.h>
+#include <adcacq.h>
+#include <dmacopy.h>
+#include <uartlink.h>
+#include <sspbus.h>
+#include "IICSlaveTask.hpp"
+#include "IICMasterTask.hpp"
+#include "SSPSlaveTask.hpp"
+#include "UARTCommand.hpp"
+#include "RegisterProtocol.hpp"
+#include "sim.h"
+
+
+#define BENCH_IIC_SDA_PIN       (1)             ///< PA1, TIMER1 CH1 в IICSlaveTask
+#define BENCH_IIC_SCL_PIN       (3)             ///< PA3, TIMER1 CH2 в IICSlaveTask
+#define BENCH_IIC_SLAVE_ADDRESS (0x37 << 1)
+#define BENCH_IIC_REG_STACKPROF (0x80)
+#define BENCH_IIC_ROUNDS        (50)
+#define BENCH_IDLE_MS           (1000)          ///< Простой задач без работы: переключения контекста в отчёте
+#define BENCH_SSP_ROUNDS        (200)
+#define BENCH_START_DELAY_MS    (50)            ///< Инициализация периферии задачами прошивки
+#define BENCH_TIMEOUT_MS        (5000)
+#define BENCH_SSP_REPLY_TICKS   (2)             ///< Не меньше полного тика SSPSlaveTask: задачи одного приоритета
+#define BENCH_DMACOPY_SIZE      (8192)          ///< Буферы копирования: задания в несколько циклов авто
+#define BENCH_DMACOPY_THRESHOLD (64)
+#define BENCH_UART_ROUNDS       (100)
+#define BENCH_UART_BURSTS       (12)            ///< Пачек по 100 команд: кольцо приёма проходится несколько раз
+#define BENCH_UART_STREAM       (16384)         ///< Байт потока передачи, больше кольца передачи
+#define BENCH_UART_IDLE_MS      (200)           ///< Простой линии: задача приёма не должна просыпаться каждый тик
+#define BENCH_UART_IDLE_SWITCHES (10)
+#define BENCH_SSPBUS_CS_A       (9)             ///< PB9, выбор устройства A: 8 бит, режим 0
+#define BENCH_SSPBUS_CS_B       (10)            ///< PB10, выбор устройства B: 16 бит, режим 3
+#define BENCH_SSPBUS_ROUNDS     (200)
+
+
+namespace {
+
+struct Scenario {
+    const char *Name;
+    void (*Start)();                ///< Запуск задач прошивки, до планировщика
+    bool (*Run)(uint32_t &ops);     ///< Сценарий в задаче стенда. ops - число операций для отчёта
+};
+
+}
+
+
+#define BENCH_CHECK(condition) \
+    do { if (!(condition)) { SimPrintf("FAIL %s:%d: %s\n", __FILE__, __LINE__, #condition); return false; } } while (0)
+
+
+static uint64_t NowUs() {
+    timespec now {};
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return static_cast<uint64_t>(now.tv_sec) * 1000000ULL + now.tv_nsec / 1000;
+}
+
+
+/*
+ * Ведущий I2C на выводах IICSlaveTask. Линии с открытым стоком: стенд только прижимает их к 0
+ */
+static void IicSda(bool high) {
+    SimPinDrive(MDR_PORTA, BENCH_IIC_SDA_PIN, !high);
+}
+
+static void IicScl(bool high) {
+    SimPinDrive(MDR_PORTA, BENCH_IIC_SCL_PIN, !high);
+}
+
+static bool IicSdaLevel() {
+    return SimPinLevel(MDR_PORTA, BENCH_IIC_SDA_PIN);
+}
+
+static void IicStart() {
+    IicSda(true);
+    IicScl(true);
+    IicSda(false);
+    IicScl(false);
+}
+
+/// @return true - ACK от ведомого
+static bool IicWrite(uint8_t value) {
+    for (int bit = 7; bit >= 0; bit--) {
+        IicSda((value >> bit) & 1);
+        IicScl(true);
+        IicScl(false);
+    }
+    IicSda(true);
+    IicScl(true);
+    bool ack = !IicSdaLevel();
+    IicScl(false);
+    return ack;
+}
+
+static uint8_t IicRead(bool ack) {
+    uint8_t value = 0;
+    IicSda(true);
+    for (int bit = 0; bit < 8; bit++) {
+        IicScl(true);
+        value = (value << 1) | (IicSdaLevel() ? 1 : 0);
+        IicScl(false);
+    }
+    IicSda(!ack);
+    IicScl(true);
+    IicScl(false);
+    IicSda(true);
+    return value;
+}
+
+/*
+ * Ведомый выдаёт следующий бит по спаду SCL и после NACK: тактами освобождаем SDA перед STOP,
+ * как при восстановлении шины
+ */
+static void IicStop() {
+    for (int i = 0; i < 9 && !IicSdaLevel(); i++) {
+        IicScl(true);
+        IicScl(false);
+    }
+    IicSda(false);
+    IicScl(true);
+    IicSda(true);
+}
+
+static bool IicReadRegister(uint8_t reg, uint8_t *data, size_t len) {
+    IicStart();
+    bool ok = IicWrite(BENCH_IIC_SLAVE_ADDRESS) && IicWrite(reg);
+    IicStop();
+    if (!ok)
+        return false;
+
+    IicStart();
+    ok = IicWrite(BENCH_IIC_SLAVE_ADDRESS | 0x01);
+    for (size_t i = 0; ok && i < len; i++)
+        data[i] = IicRead(i + 1 < len);
+    IicStop();
+    return ok;
+}
+
+
+static void StartIicSlave() {
+    IICSlaveTaskStart();
+}
+
+static bool RunIicSlave(uint32_t &ops) {
+    static const uint8_t expected[8] = {0xA0, 0xA1, 0xBC, 0xCC, 0xDE, 0x12, 0x68, 0x57};
+    uint8_t data[8] {};
+    for (uint32_t round = 0; round < BENCH_IIC_ROUNDS; round++) {
+        BENCH_CHECK(IicReadRegister(0x00, data, sizeof(data)));
+        BENCH_CHECK(memcmp(data, expected, sizeof(expected)) == 0);
+        ops++;
+    }
+
+    StackProfUpdate();
+    BENCH_CHECK(IicReadRegister(BENCH_IIC_REG_STACKPROF, data, sizeof(data)));
+    BENCH_CHECK((data[0] | (data[1] << 8)) == STACKPROF_RECORD_MAGIC);
+    BENCH_CHECK(data[2] > 0);
+    ops++;
+    return true;
+}
+
+
+/*
+ * Простой: IICSlaveTask без обращений по I2C. Задача, ждущая событий, не должна просыпаться
+ */
+static bool RunIdle(uint32_t &ops) {
+    vTaskDelay(pdMS_TO_TICKS(BENCH_IDLE_MS));
+    ops = BENCH_IDLE_MS;
+    return true;
+}
+
+
+static void StartIicMaster() {
+    IICMasterTaskStart();
+}
+
+static bool RunIicMaster(uint32_t &ops) {
+    static const uint8_t expected[16] = {0xDE, 0xAD, 0xBE, 0xEF, 0xA0, 0xA5, 0x01, 0x02,
+                                         0x03, 0x04, 0x05, 0x54, 0x49, 0x23, 0x69, 0x11};
+    // Первый цикл IICMasterTask пишет 16 байт по адресу 0, следующие - по адресам 32, 64...
+    for (uint32_t waited = 0; waited < BENCH_TIMEOUT_MS; waited += 10) {
+        bool written = true;
+        for (uint32_t i = 0; i < sizeof(expected); i++)
+            written &= SimEepromRead(i) == expected[i];
+        if (written && SimEepromRead(64) != 0xFF) {
+            ops = 3;
+            return true;
+        }
+        vTaskDelay(pdMS_TO_TICKS(10));
+    }
+    SimPrintf("FAIL: EEPROM was not written in %d ms\n", BENCH_TIMEOUT_MS);
+    return false;
+}
+
+
+static void StartAdc() {
+    AdcAcqStart();
+}
+
+static bool RunAdc(uint32_t &ops) {
+    static const uint8_t inputs[ADC_PIPELINE_CHANNELS] = {CONFIG_ADC_CH1_INPUT, CONFIG_ADC_CH2_INPUT,
+                                                          CONFIG_ADC_CH3_INPUT, CONFIG_ADC_CH4_INPUT};
+    static const uint16_t values[ADC_PIPELINE_CHANNELS] = {100, 1000, 2000, 4000};
+    for (uint32_t ch = 0; ch < ADC_PIPELINE_CHANNELS; ch++)
+        SimAdcSetInput(inputs[ch], values[ch]);
+
+    // Первая половина буфера может содержать отсчёты до SimAdcSetInput()
+    vTaskDelay(pdMS_TO_TICKS(200));
+    AdcSnapshot snapshot {};
+    BENCH_CHECK(AdcAcqRead(snapshot) != 0);
+    for (uint32_t ch = 0; ch < ADC_PIPELINE_CHANNELS; ch++)
+        BENCH_CHECK(snapshot.Value[ch] == values[ch]);
+
+    AdcAcqStats stats {};
+    AdcAcqGetStats(stats);
+    BENCH_CHECK(stats.Blocks > 0);
+    BENCH_CHECK(stats.Overruns == 0);
+    BENCH_CHECK(stats.Unmapped == 0);
+    ops = stats.Blocks;
+    return true;
+}
+
+
+static void StartSsp() {
+    SSPSlaveTaskStart();
+}
+
+/// CRC-8 ответа SSPSlaveTask: полином 0x07, начальное значение 0, результат XOR 0x55
+static uint8_t SspCrc(const uint8_t *data, size_t len) {
+    uint8_t crc = 0;
+    while (len--) {
+        crc ^= *data++;
+        for (int bit = 0; bit < 8; bit++)
+            crc = (crc & 0x80) ? static_cast<uint8_t>((crc << 1) ^ 0x07) : static_cast<uint8_t>(crc << 1);
+    }
+    return crc ^ 0x55;
+}
+
+static bool SspReadWhoIAm() {
+    const uint8_t command = 0x01;               // SSP_READ(SSP_REG_WHOIAM)
+    const uint8_t dummy[3] = {0x00, 0x00, 0x00};
+    uint8_t rx[3] {};
+    BENCH_CHECK(SimSspExchange(MDR_SSP2, &command, nullptr, 1) == 1);
+    vTaskDelay(BENCH_SSP_REPLY_TICKS);
+    BENCH_CHECK(SimSspExchange(MDR_SSP2, dummy, rx, sizeof(rx)) == sizeof(rx));
+    BENCH_CHECK(rx[0] == 0xCC && rx[1] == 0xDA);
+    BENCH_CHECK(rx[2] == SspCrc(rx, 2));
+    return true;
+}
+
+static bool RunSsp(uint32_t &ops) {
+    for (uint32_t round = 0; round < BENCH_SSP_ROUNDS; round++) {
+        if (!SspReadWhoIAm())
+            return false;
+        ops++;
+    }
+
+    // Запись SVC с неверной CRC игнорируется, обмен продолжается
+    const uint8_t svc[4] = {0x30, 0x80, 0x00, 0x00};
+    BENCH_CHECK(SimSspExchange(MDR_SSP2, svc, nullptr, sizeof(svc)) == sizeof(svc));
+    vTaskDelay(BENCH_SSP_REPLY_TICKS);
+    return SspReadWhoIAm();
+}
+
+
+static void StartDmaCopy() {
+    DmaCopyStart();
+}
+
+static uint8_t s_uCopySource[BENCH_DMACOPY_SIZE];
+static uint8_t s_uCopyDest[BENCH_DMACOPY_SIZE];
+
+/*
+ * Копирование и проверка: байты вне [offset, offset + size) приёмника не изменены
+ */
+static bool DmaCopyCheck(EventChannel &done, uint32_t destOffset, uint32_t sourceOffset, uint32_t size, bool dma) {
+    memset(s_uCopyDest, 0xEE, sizeof(s_uCopyDest));
+    DmaCopyJob job {};
+    BENCH_CHECK(DmaMemcpyAsync(job, s_uCopyDest + destOffset, s_uCopySource + sourceOffset, size, &done) == dma);
+    BENCH_CHECK(EventWait(done, pdMS_TO_TICKS(BENCH_TIMEOUT_MS)));
+    BENCH_CHECK(!DmaCopyBusy(job));
+    BENCH_CHECK(memcmp(s_uCopyDest + destOffset, s_uCopySource + sourceOffset, size) == 0);
+    for (uint32_t i = 0; i < BENCH_DMACOPY_SIZE; i++) {
+        if (i < destOffset || i >= destOffset + size)
+            BENCH_CHECK(s_uCopyDest[i] == 0xEE);
+    }
+    return true;
+}
+
+static bool RunDmaCopy(uint32_t &ops) {
+    EventChannel done {};
+    EventInit(done, xTaskGetCurrentTaskHandle(), 1UL << 0, "dmacopy");
+    for (uint32_t i = 0; i < BENCH_DMACOPY_SIZE; i++)
+        s_uCopySource[i] = static_cast<uint8_t>(i * 7 + (i >> 8));
+    DmaCopySetThreshold(BENCH_DMACOPY_THRESHOLD);
+
+    // Короче порога - процессором, событие то же
+    BENCH_CHECK(DmaCopyCheck(done, 0, 0, BENCH_DMACOPY_THRESHOLD - 1, false));
+    // Слова, 2 цикла; полуслова; байты, 3 цикла
+    BENCH_CHECK(DmaCopyCheck(done, 0, 0, 6000, true));
+    BENCH_CHECK(DmaCopyCheck(done, 2, 6, 1026, true));
+    BENCH_CHECK(DmaCopyCheck(done, 3, 1, 3001, true));
+
+    // Заполнение полусловами через границу цикла
+    memset(s_uCopyDest, 0xEE, sizeof(s_uCopyDest));
+    DmaCopyJob fill {};
+    BENCH_CHECK(DmaMemsetAsync(fill, s_uCopyDest + 2, 0x5A, 2050, &done));
+    BENCH_CHECK(EventWait(done, pdMS_TO_TICKS(BENCH_TIMEOUT_MS)));
+    BENCH_CHECK(s_uCopyDest[1] == 0xEE && s_uCopyDest[2 + 2050] == 0xEE);
+    for (uint32_t i = 2; i < 2 + 2050; i++)
+        BENCH_CHECK(s_uCopyDest[i] == 0x5A);
+
+    // Очередь: задания выполняются по порядку, событие только у последнего
+    DmaCopyJob jobs[3] {};
+    BENCH_CHECK(DmaMemcpyAsync(jobs[0], s_uCopyDest, s_uCopySource, 4096, nullptr));
+    BENCH_CHECK(DmaMemsetAsync(jobs[1], s_uCopyDest + 4096, 0xA5, 100, nullptr));
+    BENCH_CHECK(DmaMemcpyAsync(jobs[2], s_uCopyDest + 4096 + 50, s_uCopySource, 2000, &done));
+    BENCH_CHECK(EventWait(done, pdMS_TO_TICKS(BENCH_TIMEOUT_MS)));
+    for (const auto &job : jobs)
+        BENCH_CHECK(!DmaCopyBusy(job));
+    BENCH_CHECK(memcmp(s_uCopyDest, s_uCopySource, 4096) == 0);
+    for (uint32_t i = 4096; i < 4096 + 50; i++)
+        BENCH_CHECK(s_uCopyDest[i] == 0xA5);
+    BENCH_CHECK(memcmp(s_uCopyDest + 4096 + 50, s_uCopySource, 2000) == 0);
+
+    DmaCopyStats stats {};
+    DmaCopyGetStats(stats);
+    BENCH_CHECK(stats.DmaJobs == 7);
+    BENCH_CHECK(stats.CpuJobs == 1);
+    ops = stats.DmaJobs + stats.CpuJobs;
+    return true;
+}
+
+
+static void StartUart() {
+    UartLinkInit(CONFIG_UARTLINK_BAUD);
+    UARTCommandStart();
+}
+
+/*
+ * Ответ UARTCommand: ждёт len байт, кадр заканчивается паузой CONFIG_UARTLINK_IDLE_TICKS
+ */
+static bool UartReply(uint8_t *reply, size_t len) {
+    size_t received = 0;
+    for (uint32_t ms = 0; ms < BENCH_TIMEOUT_MS && received < len; ms++) {
+        received += SimUartReceive(MDR_UART2, reply + received, len - received);
+        if (received < len)
+            vTaskDelay(1);
+    }
+    BENCH_CHECK(received == len);
+    return true;
+}
+
+static bool RunUart(uint32_t &ops) {
+    // Чтения WHOIAM по одному в кадре
+    for (uint32_t round = 0; round < BENCH_UART_ROUNDS; round++) {
+        const uint8_t command = REG_READ(REG_WHOIAM);
+        uint8_t reply[3] {};
+        BENCH_CHECK(SimUartSend(MDR_UART2, &command, 1) == 1);
+        BENCH_CHECK(UartReply(reply, sizeof(reply)));
+        BENCH_CHECK(reply[0] == 0xCC && reply[1] == 0xDA);
+        BENCH_CHECK(reply[2] == RegisterCrc(reply, 2));
+        ops++;
+    }
+
+    // Несколько команд в кадре, запись с неверной CRC пропускается
+    const uint8_t frame[] = {REG_READ(REG_WHOIAM), REG_WRITE(REG_SVC), 0x00, 0x00, 0x00, REG_READ(REG_WHOIAM)};
+    uint8_t replies[6] {};
+    BENCH_CHECK(SimUartSend(MDR_UART2, frame, sizeof(frame)) == sizeof(frame));
+    BENCH_CHECK(UartReply(replies, sizeof(replies)));
+    BENCH_CHECK(memcmp(replies, replies + 3, 3) == 0 && replies[0] == 0xCC);
+
+    // Вход в обновление по UART отклоняется, ответы продолжаются
+    uint8_t update[] = {REG_WRITE(REG_SVC), REG_SVC_UPDATE, 0x00, 0x00, REG_READ(REG_WHOIAM)};
+    update[3] = RegisterCrc(update, 3);
+    BENCH_CHECK(SimUartSend(MDR_UART2, update, sizeof(update)) == sizeof(update));
+    BENCH_CHECK(UartReply(replies, 3));
+    BENCH_CHECK(memcmp(replies, replies + 3, 3) == 0);
+
+    // Пачки команд через обе половины кольца приёма
+    uint8_t burst[100];
+    memset(burst, REG_READ(REG_WHOIAM), sizeof(burst));
+    for (uint32_t round = 0; round < BENCH_UART_BURSTS; round++) {
+        static uint8_t burstReplies[3 * sizeof(burst)];
+        BENCH_CHECK(SimUartSend(MDR_UART2, burst, sizeof(burst)) == sizeof(burst));
+        BENCH_CHECK(UartReply(burstReplies, sizeof(burstReplies)));
+        for (uint32_t i = 0; i < sizeof(burstReplies); i += 3)
+            BENCH_CHECK(memcmp(&burstReplies[i], replies, 3) == 0);
+        ops += sizeof(burst);
+    }
+
+    // Простой без кадров
+    SimStats idleStart {};
+    SimStats idleEnd {};
+    SimGetStats(idleStart);
+    vTaskDelay(pdMS_TO_TICKS(BENCH_UART_IDLE_MS));
+    SimGetStats(idleEnd);
+    SimPrintf("  idle      %10llu switches\n", static_cast<unsigned long long>(idleEnd.Switches - idleStart.Switches));
+    BENCH_CHECK(idleEnd.Switches - idleStart.Switches < BENCH_UART_IDLE_SWITCHES);
+
+    // Поток передачи через кольцо: принятое стендом совпадает с записанным, без потерь
+    uint8_t chunk[64];
+    uint8_t line[sizeof(chunk)];
+    uint32_t sent = 0;
+    uint32_t checked = 0;
+    while (checked < BENCH_UART_STREAM) {
+        if (sent < BENCH_UART_STREAM) {
+            for (uint32_t i = 0; i < sizeof(chunk); i++)
+                chunk[i] = static_cast<uint8_t>(sent + i);
+            sent += UartLinkWrite(chunk, sizeof(chunk));
+        }
+        size_t received = SimUartReceive(MDR_UART2, line, sizeof(line));
+        for (size_t i = 0; i < received; i++)
+            BENCH_CHECK(line[i] == static_cast<uint8_t>(checked + i));
+        checked += received;
+        if (received == 0 && sent >= BENCH_UART_STREAM)
+            vTaskDelay(1);
+    }
+
+    UartLinkStats stats {};
+    UartLinkGetStats(stats);
+    BENCH_CHECK(stats.Baud == CONFIG_UARTLINK_BAUD);
+    BENCH_CHECK(stats.RxFrames == BENCH_UART_ROUNDS + 2 + BENCH_UART_BURSTS);
+    BENCH_CHECK(stats.RxBytes == BENCH_UART_ROUNDS + sizeof(frame) + sizeof(update) +
+                BENCH_UART_BURSTS * sizeof(burst));
+    BENCH_CHECK(stats.RxOverruns == 0 && stats.FifoOverruns == 0);
+    BENCH_CHECK(stats.TxDropped == 0);
+    BENCH_CHECK(stats.TxBytes == 3 * (BENCH_UART_ROUNDS + BENCH_UART_BURSTS * sizeof(burst) + 1) + sizeof(replies) +
+                BENCH_UART_STREAM);
+
+    // Наибольшая частота на 80 МГц и недостижимая
+    BENCH_CHECK(UartLinkSetBaud(UartBaudMax(SystemCoreClock)));
+    BENCH_CHECK(!UartLinkSetBaud(UartBaudMax(SystemCoreClock) + 1));
+    UartLinkGetStats(stats);
+    BENCH_CHECK(stats.Baud == 5000000);
+    return true;
+}
+
+
+/*
+ * Устройства стенда на SSP2. A отвечает предыдущим принятым байтом с инверсией, B - словом + 0x1111.
+ * Слово при выборе не одного устройства или при чужой настройке CR0 считается ошибкой
+ */
+struct BenchSspDevice {
+    uint32_t    Pin;
+    uint32_t    Cr0;
+    uint16_t    Last;
+    uint32_t    Words;
+    uint32_t    Errors;
+};
+
+static BenchSspDevice s_xBenchA = {BENCH_SSPBUS_CS_A, 0, 0, 0, 0};
+static BenchSspDevice s_xBenchB = {BENCH_SSPBUS_CS_B, 0, 0, 0, 0};
+
+static SspBusDevice s_xBusA = {"A", 20000000, 8, 0, MDR_PORTB, 1UL << BENCH_SSPBUS_CS_A, {}};
+static SspBusDevice s_xBusB = {"B", 1000000, 16, SSP_SETUP_MODE_SPO | SSP_SETUP_MODE_SPH, MDR_PORTB,
+                               1UL << BENCH_SSPBUS_CS_B, {}};
+
+static uint16_t SspBusDeviceWord(uint16_t word, uint32_t cr0, void *context) {
+    (void)context;
+    bool a = !SimPinLevel(MDR_PORTB, BENCH_SSPBUS_CS_A);
+    bool b = !SimPinLevel(MDR_PORTB, BENCH_SSPBUS_CS_B);
+    if (a == b) {
+        s_xBenchA.Errors++;
+        return 0xFFFF;
+    }
+    BenchSspDevice &device = a ? s_xBenchA : s_xBenchB;
+    device.Words++;
+    if (cr0 != device.Cr0)
+        device.Errors++;
+    if (a) {
+        uint16_t reply = device.Last ^ 0xFF;
+        device.Last = word;
+        return reply;
+    }
+    return static_cast<uint16_t>(word + 0x1111);
+}
+
+static void StartSspBus() {
+    SimSspAttach(MDR_SSP2, SspBusDeviceWord, nullptr);
+}
+
+/*
+ * Транзакция устройства A с проверкой ответа и вывода выбора после неё
+ */
+static bool SspBusRunA(EventChannel &done, const uint8_t *tx, uint16_t words, uint8_t flags) {
+    uint8_t rx[64];
+    uint16_t last = s_xBenchA.Last;
+    SspBusTransaction transaction {};
+    transaction.Device = &s_xBusA;
+    transaction.Tx = tx;
+    transaction.Rx = rx;
+    transaction.Words = words;
+    transaction.Flags = flags;
+    transaction.Done = &done;
+    BENCH_CHECK(SspBusSubmit(transaction));
+    BENCH_CHECK(EventWait(done, pdMS_TO_TICKS(BENCH_TIMEOUT_MS)));
+    BENCH_CHECK(!SspBusBusy(transaction));
+    BENCH_CHECK(rx[0] == (last ^ 0xFF));
+    for (uint16_t i = 1; i < words; i++)
+        BENCH_CHECK(rx[i] == (tx[i - 1] ^ 0xFF));
+    BENCH_CHECK(SimPinLevel(MDR_PORTB, BENCH_SSPBUS_CS_A) == ((flags & SSPBUS_KEEP_CS) == 0));
+    return true;
+}
+
+static bool SspBusRunB(EventChannel &done, const uint16_t *tx, uint16_t words) {
+    uint16_t rx[16];
+    SspBusTransaction transaction {};
+    transaction.Device = &s_xBusB;
+    transaction.Tx = tx;
+    transaction.Rx = rx;
+    transaction.Words = words;
+    transaction.Done = &done;
+    BENCH_CHECK(SspBusSubmit(transaction));
+    BENCH_CHECK(EventWait(done, pdMS_TO_TICKS(BENCH_TIMEOUT_MS)));
+    for (uint16_t i = 0; i < words; i++)
+        BENCH_CHECK(rx[i] == static_cast<uint16_t>(tx[i] + 0x1111));
+    BENCH_CHECK(SimPinLevel(MDR_PORTB, BENCH_SSPBUS_CS_B));
+    return true;
+}
+
+static bool RunSspBus(uint32_t &ops) {
+    EventChannel done {};
+    EventInit(done, xTaskGetCurrentTaskHandle(), 1UL << 0, "sspbus");
+
+    BENCH_CHECK(SspBusAddDevice(s_xBusA));
+    BENCH_CHECK(SspBusAddDevice(s_xBusB));
+    BENCH_CHECK(s_xBusA.Setup.Hz == 20000000 && s_xBusB.Setup.Hz == 1000000);
+    s_xBenchA.Cr0 = s_xBusA.Setup.Cr0;
+    s_xBenchB.Cr0 = s_xBusB.Setup.Cr0;
+    BENCH_CHECK(SimPinLevel(MDR_PORTB, BENCH_SSPBUS_CS_A) && SimPinLevel(MDR_PORTB, BENCH_SSPBUS_CS_B));
+    // Аппаратный FSS не делит шину с выводами порта, частота ниже наименьшей
+    SspBusDevice fss = {"FSS", 1000000, 8, 0, nullptr, 0, {}};
+    BENCH_CHECK(!SspBusAddDevice(fss));
+    SspBusDevice slow = {"Slow", 1000, 8, 0, MDR_PORTB, 1UL << BENCH_SSPBUS_CS_A, {}};
+    BENCH_CHECK(!SspBusAddDevice(slow));
+
+    uint8_t bytes[40];
+    uint16_t words[12];
+    for (uint32_t i = 0; i < sizeof(bytes); i++)
+        bytes[i] = static_cast<uint8_t>(i * 13 + 1);
+    for (uint32_t i = 0; i < 12; i++)
+        words[i] = static_cast<uint16_t>(i * 0x1357);
+
+    // Больше FIFO: дочитывание по уровню и таймауту приёма
+    BENCH_CHECK(SspBusRunA(done, bytes, 21, 0));
+    BENCH_CHECK(SspBusRunB(done, words, 12));
+    // Команда и данные одним кадром: вывод выбора держится между транзакциями, без перенастройки
+    SspBusStats before {};
+    SspBusGetStats(before);
+    BENCH_CHECK(SspBusRunA(done, bytes, 1, SSPBUS_KEEP_CS));
+    BENCH_CHECK(SspBusRunA(done, bytes + 1, 4, 0));
+    SspBusStats stats {};
+    SspBusGetStats(stats);
+    BENCH_CHECK(stats.Reconfigs == before.Reconfigs + 1);
+
+    // Очередь из прерываний запрещены: транзакции идут подряд из SSP2_IRQHandler, событие у последней
+    SspBusTransaction queue[4] {};
+    uint8_t rxA[40];
+    uint16_t rxB[12];
+    SspBusDevice *devices[4] = {&s_xBusA, &s_xBusB, &s_xBusA, &s_xBusB};
+    for (uint32_t i = 0; i < 4; i++) {
+        queue[i].Device = devices[i];
+        queue[i].Words = i < 2 ? 10 : 3;
+    }
+    queue[0].Tx = bytes;
+    queue[0].Rx = rxA;
+    queue[1].Tx = words;
+    queue[2].Fill = 0x5A;
+    queue[3].Rx = rxB;
+    queue[3].Fill = 0x0100;
+    queue[3].Done = &done;
+    SspBusGetStats(before);
+    __disable_irq();
+    for (auto &transaction : queue)
+        BENCH_CHECK(SspBusSubmit(transaction));
+    __enable_irq();
+    BENCH_CHECK(EventWait(done, pdMS_TO_TICKS(BENCH_TIMEOUT_MS)));
+    for (const auto &transaction : queue)
+        BENCH_CHECK(!SspBusBusy(transaction));
+    for (uint32_t i = 1; i < 10; i++)
+        BENCH_CHECK(rxA[i] == (bytes[i - 1] ^ 0xFF));
+    for (uint32_t i = 0; i < 3; i++)
+        BENCH_CHECK(rxB[i] == 0x1211);
+    BENCH_CHECK(s_xBenchA.Last == 0x5A);
+    SspBusGetStats(stats);
+    BENCH_CHECK(stats.Transactions == before.Transactions + 4);
+    BENCH_CHECK(stats.Reconfigs == before.Reconfigs + 3);       // SSP уже настроен для A
+
+    for (uint32_t round = 0; round < BENCH_SSPBUS_ROUNDS; round++) {
+        BENCH_CHECK(SspBusRunA(done, bytes, 16, 0));
+        BENCH_CHECK(SspBusRunB(done, words, 8));
+    }
+
+    SspBusGetStats(stats);
+    BENCH_CHECK(stats.Words == s_xBenchA.Words + s_xBenchB.Words);
+    BENCH_CHECK(s_xBenchA.Errors == 0 && s_xBenchB.Errors == 0);
+    BENCH_CHECK((MDR_SSP2->RIS & SSP_RIS_RORRIS) == 0);
+    ops = stats.Transactions;
+    return true;
+}
+
+
+static const Scenario s_xScenarios[] = {
+        {"iic_slave", StartIicSlave, RunIicSlave},
+        {"idle", StartIicSlave, RunIdle},
+        {"iic_master", StartIicMaster, RunIicMaster},
+        {"adc", StartAdc, RunAdc},
+        {"ssp", StartSsp, RunSsp},
+        {"dmacopy", StartDmaCopy, RunDmaCopy},
+        {"uart", StartUart, RunUart},
+        {"sspbus", StartSspBus, RunSspBus},
+};
+
+
+static void BenchTask(void *pvParameters) {
+    auto scenario = static_cast<const Scenario *>(pvParameters);
+    vTaskDelay(pdMS_TO_TICKS(BENCH_START_DELAY_MS));
+
+    SimStats before {};
+    SimStats after {};
+    uint32_t ops = 0;
+    SimGetStats(before);
+    uint64_t start = NowUs();
+    bool passed = scenario->Run(ops);
+    uint64_t elapsed = NowUs() - start;
+    SimGetStats(after);
+
+    SimPrintf("%s: %s\n", scenario->Name, passed ? "PASS" : "FAIL");
+    SimPrintf("  time      %10.3f ms, %lu ops, %.1f us/op\n", elapsed / 1000.0, static_cast<unsigned long>(ops),
+              ops ? static_cast<double>(elapsed) / ops : 0.0);
+    SimPrintf("  traps     %10llu, %.0f/s\n", static_cast<unsigned long long>(after.Traps - before.Traps),
+              elapsed ? (after.Traps - before.Traps) * 1e6 / elapsed : 0.0);
+    SimPrintf("  irqs      %10llu\n", static_cast<unsigned long long>(after.Irqs - before.Irqs));
+    SimPrintf("  dma       %10llu\n", static_cast<unsigned long long>(after.DmaTransfers - before.DmaTransfers));
+    SimPrintf("  ticks     %10llu\n", static_cast<unsigned long long>(after.Ticks - before.Ticks));
+    SimPrintf("  switches  %10llu, %.1f/op\n", static_cast<unsigned long long>(after.Switches - before.Switches),
+              ops ? static_cast<double>(after.Switches - before.Switches) / ops : 0.0);
+    _exit(passed ? EXIT_SUCCESS : EXIT_FAILURE);
+}
+
+
+int main(int argc, char *argv[]) {
+    const Scenario *scenario = nullptr;
+    for (const auto &item : s_xScenarios) {
+        if (argc > 1 && strcmp(argv[1], item.Name) == 0)
+            scenario = &item;
+    }
+    if (scenario == nullptr) {
+        fprintf(stderr, "Usage: %s <scenario> [-v]\nScenarios:", argv[0]);
+        for (const auto &item : s_xScenarios)
+            fprintf(stderr, " %s", item.Name);
+        fprintf(stderr, "\n");
+        return EXIT_FAILURE;
+    }
+    bool verbose = argc > 2 && strcmp(argv[2], "-v") == 0;
+
+    SimInit();
+    SystemCoreClock = SIM_CORE_CLOCK_HZ;
+    StackProfPaintMsp();
+    DWT->CYCCNT = 0;
+    DWT->CTRL |= 1;
+    mdr_log_set_vprintf(SimVprintf);
+    mdr_log_level_set("*", verbose ? MDR_LOG_VERBOSE : MDR_LOG_WARN);
+    NVIC_SetPriorityGrouping(0);
+
+    scenario->Start();
+    xTaskCreate(BenchTask, "Bench", configMINIMAL_STACK_SIZE * 4, const_cast<Scenario *>(scenario),
+                configMAX_PRIORITIES - 1, nullptr);
+    vTaskStartScheduler();
+    return EXIT_FAILURE;
+}
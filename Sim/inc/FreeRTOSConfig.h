@@ -0,0 +1,118 @@
+/*
+ * FreeRTOS Kernel V10.4.1
+ * Copyright (C) 2020 Amazon.com, Inc. or its affiliates.  All Rights Reserved.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of
+ * this software and associated documentation files (the "Software"), to deal in
+ * the Software without restriction, including without limitation the rights to
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+ * the Software, and to permit persons to whom the Software is furnished to do so,
+ * subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+ * FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+ * COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+ * IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ *
+ * http://www.FreeRTOS.org
+ * http://aws.amazon.com/freertos
+ *
+ * 1 tab == 4 spaces!
+ */
+
+#ifndef FREERTOS_CONFIG_H
+#define FREERTOS_CONFIG_H
+#include "MDR32Fx.h"
+
+/*-----------------------------------------------------------
+ * Сборка под Linux, порт FreeRTOS POSIX. Параметры задач и планировщика как в Core/inc/FreeRTOSConfig.h,
+ * отличаются стеки (задача - поток pthread на стеке из кучи FreeRTOS) и хуки симулятора.
+ *----------------------------------------------------------*/
+
+#define configUSE_PREEMPTION		1
+#define configUSE_IDLE_HOOK			1	/* Отложенные прерывания и сон до следующего тика */
+#define configUSE_TICK_HOOK			1	/* Модели с собственным временем: АЦП, цикл записи EEPROM */
+#define configCPU_CLOCK_HZ			( ( unsigned long ) 80000000 )
+#define configTICK_RATE_HZ			( ( TickType_t ) 1000 )
+#define configMAX_PRIORITIES		( 5 )
+#define configMINIMAL_STACK_SIZE	( ( unsigned short ) 4096 )	/* Слова по 8 байт, не меньше PTHREAD_STACK_MIN */
+#define configTOTAL_HEAP_SIZE		( ( size_t ) ( 2 * 1024 * 1024 ) )
+#define configMAX_TASK_NAME_LEN		( 16 )
+#define configUSE_TRACE_FACILITY	1
+#define configUSE_16_BIT_TICKS		0
+#define configIDLE_SHOULD_YIELD		1
+
+/* Co-routine definitions. */
+#define configUSE_CO_ROUTINES 		0
+#define configMAX_CO_ROUTINE_PRIORITIES ( 2 )
+
+#define configUSE_MUTEXES				1
+#define configUSE_COUNTING_SEMAPHORES 	1
+#define configUSE_ALTERNATIVE_API 		0
+#define configCHECK_FOR_STACK_OVERFLOW	0	/* Переопределяется ниже при CONFIG_STACKPROF_ENABLE */
+#define configUSE_RECURSIVE_MUTEXES		1
+#define configQUEUE_REGISTRY_SIZE		0
+#define configGENERATE_RUN_TIME_STATS	0
+
+/* Software timer definitions. */
+#define configUSE_TIMERS				1
+#define configTIMER_TASK_PRIORITY		( 2 )
+#define configTIMER_QUEUE_LENGTH		10
+#define configTIMER_TASK_STACK_DEPTH	( configMINIMAL_STACK_SIZE * 5 )
+
+/* Set the following definitions to 1 to include the API function, or zero
+to exclude the API function. */
+
+#define INCLUDE_vTaskPrioritySet		1
+#define INCLUDE_uxTaskPriorityGet		1
+#define INCLUDE_vTaskDelete				1
+#define INCLUDE_vTaskCleanUpResources	0
+#define INCLUDE_vTaskSuspend			1
+#define INCLUDE_vTaskDelayUntil			1
+#define INCLUDE_vTaskDelay				1
+#define INCLUDE_xTaskGetSchedulerState	1
+#define INCLUDE_xTaskGetCurrentTaskHandle	1	/* Нужна порту POSIX */
+
+void SimAssertFailed( const char *pcFile, unsigned long ulLine );
+#define configASSERT( x ) if( ( x ) == 0 ) { SimAssertFailed( __FILE__, __LINE__ ); }
+
+/* Обработчики прерываний симулятора вызываются в потоке прерванной задачи, признак ведёт sim_core.cpp */
+int SimIsInsideInterrupt( void );
+#define xPortIsInsideInterrupt()		SimIsInsideInterrupt()
+
+/* Счётчик переключений контекста для отчёта стенда */
+void SimTaskSwitchedIn( void );
+#define traceTASK_SWITCHED_IN()			SimTaskSwitchedIn()
+
+
+/*-----------------------------------------------------------
+ * Трасса выделений heap_4 для mempool_benchmark, app_config.h CONFIG_MEMPOOL_TRACE
+ *-----------------------------------------------------------*/
+#include "app_config.h"
+#if (CONFIG_MEMPOOL_TRACE == 1)
+void vMemTraceMalloc( void *pvAddress, size_t uiSize );
+void vMemTraceFree( void *pvAddress, size_t uiSize );
+#define traceMALLOC( pvAddress, uiSize )    vMemTraceMalloc( pvAddress, uiSize )
+#define traceFREE( pvAddress, uiSize )      vMemTraceFree( pvAddress, uiSize )
+#endif
+
+
+/*-----------------------------------------------------------
+ * Профилировщик стеков, app_config.h CONFIG_STACKPROF_ENABLE
+ *-----------------------------------------------------------*/
+#if (CONFIG_STACKPROF_ENABLE == 1)
+#undef configCHECK_FOR_STACK_OVERFLOW
+#define configCHECK_FOR_STACK_OVERFLOW      2
+#define configRECORD_STACK_HIGH_ADDRESS     1
+void vStackProfTaskCreated( void *xTask, void *pxStack, void *pxEndOfStack );
+void vStackProfTaskDeleted( void *xTask );
+#define traceTASK_CREATE( pxNewTCB )        vStackProfTaskCreated( pxNewTCB, pxNewTCB->pxStack, pxNewTCB->pxEndOfStack )
+#define traceTASK_DELETE( pxTCB )           vStackProfTaskDeleted( pxTCB )
+#endif
+
+#endif /* FREERTOS_CONFIG_H */
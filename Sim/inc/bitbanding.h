@@ -0,0 +1,27 @@
+/**
+ * @file bitbanding.h
+ * @brief Адреса bit-band для сборки под Linux
+ *
+ * Стоит в пути поиска раньше CMSIS. Макросы CMSIS приводят адрес регистра к uint32_t, для 64-битного указателя это
+ * ошибка C++. Здесь приведение через uintptr_t: окна периферии симулятора лежат в младших 4 ГБ.
+ */
+
+#ifndef MILANDRBASE_SIM_BITBANDING_H
+#define MILANDRBASE_SIM_BITBANDING_H
+
+#include <stdint.h>
+#include_next <bitbanding.h>
+
+#undef BIT_BAND_PER
+#undef BIT_BAND_SRAM
+#undef TO_BIT_BAND_PER
+#undef TO_BIT_BAND_SRAM
+
+#define TO_BIT_BAND_PER(REG,BIT)    (*(__IO uint32_t *)(uintptr_t)(PERIPH_BB_BASE + \
+        ((uint32_t)(uintptr_t)(&(REG)) - PERIPH_BASE) * 32 + 4 * ((uint32_t)(BYTE_TO_BITBAND(BIT)))))
+#define TO_BIT_BAND_SRAM(RAM,BIT)   (*(__IO uint32_t *)(uintptr_t)(SRAM_BB_BASE + \
+        ((uint32_t)(uintptr_t)(RAM) - SRAM_BASE) * 32 + 4 * ((uint32_t)(BIT))))
+#define BIT_BAND_PER(REG,BIT,VAL)   (TO_BIT_BAND_PER(REG,BIT) = VAL)
+#define BIT_BAND_SRAM(RAM,BIT,VAL)  (TO_BIT_BAND_SRAM(RAM,BIT) = VAL)
+
+#endif //MILANDRBASE_SIM_BITBANDING_H
@@ -0,0 +1,81 @@
+/**
+ * @file core_cm3.h
+ * @brief Встроенные функции Cortex-M3 для сборки под Linux
+ *
+ * Стоит в пути поиска раньше CMSIS и подменяет cmsis_gcc.h: ассемблер ARM заменён вызовами симулятора,
+ * описания регистров NVIC, SCB, SysTick и DWT берутся из настоящего core_cm3.h.
+ */
+
+#ifndef MILANDRBASE_SIM_CORE_CM3_H
+#define MILANDRBASE_SIM_CORE_CM3_H
+
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+void SimDisableIrq(void);
+void SimEnableIrq(void);
+uint32_t SimGetPrimask(void);
+void SimSetPrimask(uint32_t priMask);
+uint32_t SimGetIpsr(void);
+uint32_t SimGetMsp(void);
+void SimWaitForInterrupt(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#define __CMSIS_GCC_H       /* Функции ниже вместо cmsis_gcc.h */
+
+static inline void __enable_irq(void)                   { SimEnableIrq(); }
+static inline void __disable_irq(void)                  { SimDisableIrq(); }
+static inline uint32_t __get_PRIMASK(void)              { return SimGetPrimask(); }
+static inline void __set_PRIMASK(uint32_t priMask)      { SimSetPrimask(priMask); }
+static inline void __enable_fault_irq(void)             { }
+static inline void __disable_fault_irq(void)            { }
+static inline uint32_t __get_FAULTMASK(void)            { return 0; }
+static inline void __set_FAULTMASK(uint32_t faultMask)  { (void)faultMask; }
+static inline uint32_t __get_BASEPRI(void)              { return 0; }
+static inline void __set_BASEPRI(uint32_t value)        { (void)value; }
+static inline void __set_BASEPRI_MAX(uint32_t value)    { (void)value; }
+static inline uint32_t __get_CONTROL(void)              { return 0; }
+static inline void __set_CONTROL(uint32_t control)      { (void)control; }
+static inline uint32_t __get_IPSR(void)                 { return SimGetIpsr(); }
+static inline uint32_t __get_APSR(void)                 { return 0; }
+static inline uint32_t __get_xPSR(void)                 { return SimGetIpsr(); }
+static inline uint32_t __get_MSP(void)                  { return SimGetMsp(); }
+static inline void __set_MSP(uint32_t topOfMainStack)   { (void)topOfMainStack; }
+static inline uint32_t __get_PSP(void)                  { return 0; }
+static inline void __set_PSP(uint32_t topOfProcStack)   { (void)topOfProcStack; }
+
+static inline void __NOP(void)                          { }
+static inline void __WFI(void)                          { SimWaitForInterrupt(); }
+static inline void __WFE(void)                          { SimWaitForInterrupt(); }
+static inline void __SEV(void)                          { }
+static inline void __ISB(void)                          { __sync_synchronize(); }
+static inline void __DSB(void)                          { __sync_synchronize(); }
+static inline void __DMB(void)                          { __sync_synchronize(); }
+static inline void __BKPT(uint32_t value)               { (void)value; __builtin_trap(); }
+static inline uint32_t __REV(uint32_t value)            { return __builtin_bswap32(value); }
+static inline uint32_t __REV16(uint32_t value) {
+    return ((value & 0xFF00FF00UL) >> 8) | ((value & 0x00FF00FFUL) << 8);
+}
+static inline int32_t __REVSH(int32_t value)            { return (int16_t)__builtin_bswap16((uint16_t)value); }
+static inline uint32_t __ROR(uint32_t op1, uint32_t op2) {
+    op2 &= 31U;
+    return op2 == 0U ? op1 : (op1 >> op2) | (op1 << (32U - op2));
+}
+static inline uint32_t __RBIT(uint32_t value) {
+    uint32_t result = 0;
+    for (int i = 0; i < 32; i++, value >>= 1)
+        result = (result << 1) | (value & 1U);
+    return result;
+}
+static inline uint8_t __CLZ(uint32_t value)             { return value == 0 ? 32 : (uint8_t)__builtin_clz(value); }
+static inline void __CLREX(void)                        { }
+
+#include_next <core_cm3.h>
+
+#endif //MILANDRBASE_SIM_CORE_CM3_H
@@ -0,0 +1,64 @@
+/**
+ * @file sim.h
+ * @brief Симулятор периферии 1986ВЕ92 для сборки прошивки под Linux
+ *
+ * Прошивка и SPL собираются без изменений и обращаются к регистрам по настоящим адресам. Области периферии
+ * 0x40000000, bit-band 0x42000000 и системная 0xE0000000 отображаются без доступа: каждое обращение ловится
+ * SIGSEGV, выполняется одной инструкцией под флагом TF и передаётся модели регистра (sim_bus.cpp). Модели
+ * вызывают прерывания, обработчики из vectors.c вызываются в контексте прерванной задачи.
+ *
+ * Функции стенда вызываются из задач FreeRTOS: внешнее устройство меняет выводы, передаёт байты по SPI
+ * и UART или задаёт входы АЦП. Прерывания, вызванные изменением, обрабатываются до возврата из функции.
+ */
+
+#ifndef MILANDRBASE_SIM_H
+#define MILANDRBASE_SIM_H
+
+#include <stdarg.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <MDR32Fx.h>
+
+
+#define SIM_CORE_CLOCK_HZ       (80000000UL)    ///< Частота ядра, как после CPU_Init(): HSE 8 МГц и PLL x10
+#define SIM_EEPROM_SIZE         (256 * 1024)    ///< Модель 24CM02 на I2C: 2 байта адреса, блок в адресе ведомого
+#define SIM_EEPROM_PAGE_SIZE    (256)
+#define SIM_EEPROM_WRITE_MS     (10)            ///< Цикл записи страницы, ведомый не отвечает на адрес
+
+
+/**
+ * @brief Счётчики симулятора для отчёта сценария
+ */
+struct SimStats {
+    uint64_t Traps;                 ///< Обращения к регистрам
+    uint64_t Irqs;                  ///< Вызванные обработчики прерываний
+    uint64_t DmaTransfers;          ///< Пересылки DMA
+    uint64_t Ticks;                 ///< Тики FreeRTOS
+    uint64_t Switches;              ///< Переключения контекста, traceTASK_SWITCHED_IN
+};
+
+
+void SimInit();
+void SimGetStats(SimStats &stats);
+int SimVprintf(const char *format, va_list args);
+int SimPrintf(const char *format, ...) __attribute__((format(printf, 1, 2)));
+
+void SimPinDrive(MDR_PORT_TypeDef *port, uint32_t pin, bool low);
+bool SimPinLevel(MDR_PORT_TypeDef *port, uint32_t pin);
+
+/**
+ * @brief Устройство на шине ведущего SSP: слово ведущего и CR0 при обмене, возвращает ответ
+ */
+typedef uint16_t (*SimSspDevice)(uint16_t word, uint32_t cr0, void *context);
+
+size_t SimSspExchange(MDR_SSP_TypeDef *ssp, const uint8_t *tx, uint8_t *rx, size_t len);
+void SimSspAttach(MDR_SSP_TypeDef *ssp, SimSspDevice device, void *context);
+
+size_t SimUartSend(MDR_UART_TypeDef *uart, const uint8_t *data, size_t len);
+size_t SimUartReceive(MDR_UART_TypeDef *uart, uint8_t *data, size_t len);
+
+void SimAdcSetInput(uint8_t input, uint16_t value);
+
+uint8_t SimEepromRead(uint32_t address);
+
+#endif //MILANDRBASE_SIM_H
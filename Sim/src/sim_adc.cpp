@@ -0,0 +1,155 @@
+/**
+ * @file sim_adc.cpp
+ * @brief Модель ADC1 и ADC2 (MDR_ADC)
+ *
+ * Преобразования идут по тику FreeRTOS: за тик выполняется столько преобразований, сколько укладывается
+ * в 1 мс при частоте SIM_CORE_CLOCK_HZ / 2^DIVCLK и 28 тактах на преобразование. Значение входа задаёт стенд
+ * функцией SimAdcSetInput(). При переключении каналов (CHCH) входы из ADCx_CHSEL перебираются по порядку.
+ * Чтение ADCx_RESULT сбрасывает EOCIF, новый результат при выставленном EOCIF выставляет OVERWRITE.
+ * Запрос DMA активен, пока выставлен EOCIF.
+ */
+
+#include <MDR32F9Qx_config.h>
+#include <FreeRTOS.h>
+#include "sim.h"
+#include "sim_bus.h"
+
+
+#define SIM_ADC_COUNT           (2)
+#define SIM_ADC_SIZE            (0x8000)
+#define SIM_ADC_INPUTS          (32)
+#define SIM_ADC_CONVERSION_CLKS (28)            ///< Тактов ADC_CLK на одно преобразование
+#define SIM_ADC_DMA_CHANNEL(index)  ((index) == 0 ? 8 : 9)  ///< DMA_Channel_ADC1, DMA_Channel_ADC2
+
+#define SIM_ADC_CFG(index)      (offsetof(MDR_ADC_TypeDef, ADC1_CFG) + (index) * 4)
+#define SIM_ADC_RESULT(index)   (offsetof(MDR_ADC_TypeDef, ADC1_RESULT) + (index) * 4)
+#define SIM_ADC_STATUS(index)   (offsetof(MDR_ADC_TypeDef, ADC1_STATUS) + (index) * 4)
+#define SIM_ADC_CHSEL(index)    (offsetof(MDR_ADC_TypeDef, ADC1_CHSEL) + (index) * 4)
+
+
+namespace {
+
+uint16_t s_uInputs[SIM_ADC_INPUTS];
+uint32_t s_uCursor[SIM_ADC_COUNT];              ///< Последний преобразованный вход при переключении каналов
+uint64_t s_uClocks[SIM_ADC_COUNT];              ///< Такты ядра, не вошедшие в целое преобразование
+
+}
+
+
+static uint32_t &Reg(uint32_t offset) {
+    return SimShadow(MDR_ADC_BASE + offset);
+}
+
+
+static void UpdateIrq() {
+    bool level = false;
+    for (uint32_t i = 0; i < SIM_ADC_COUNT; i++) {
+        uint32_t status = Reg(SIM_ADC_STATUS(i));
+        level |= (status & (1UL << ADC_STATUS_FLG_REG_EOCIF_Pos)) && (status & (1UL << ADC_STATUS_ECOIF_IE_Pos));
+    }
+    SimIrqSet(ADC_IRQn, level);
+}
+
+
+static uint32_t NextInput(uint32_t index) {
+    uint32_t cfg = Reg(SIM_ADC_CFG(index));
+    if ((cfg & (1UL << ADC1_CFG_REG_CHCH_Pos)) == 0)
+        return (cfg >> ADC1_CFG_REG_CHS_Pos) & 0x1F;
+
+    uint32_t channels = Reg(SIM_ADC_CHSEL(index));
+    if (channels == 0)
+        return (cfg >> ADC1_CFG_REG_CHS_Pos) & 0x1F;
+    for (uint32_t i = 1; i <= SIM_ADC_INPUTS; i++) {
+        uint32_t input = (s_uCursor[index] + i) % SIM_ADC_INPUTS;
+        if (channels & (1UL << input)) {
+            s_uCursor[index] = input;
+            return input;
+        }
+    }
+    return 0;
+}
+
+
+static void Convert(uint32_t index) {
+    uint32_t input = NextInput(index);
+    uint32_t &status = Reg(SIM_ADC_STATUS(index));
+    if (status & (1UL << ADC_STATUS_FLG_REG_EOCIF_Pos))
+        status |= 1UL << ADC_STATUS_FLG_REG_OVERWRITE_Pos;
+    status |= 1UL << ADC_STATUS_FLG_REG_EOCIF_Pos;
+    Reg(SIM_ADC_RESULT(index)) = (input << ADC_RESULT_CHANNEL_Pos) | s_uInputs[input];
+    UpdateIrq();
+    SimDmaService();
+}
+
+
+static uint32_t AdcRead(uint32_t offset, bool peek) {
+    for (uint32_t i = 0; i < SIM_ADC_COUNT; i++) {
+        if (offset == SIM_ADC_RESULT(i) && !peek) {
+            Reg(SIM_ADC_STATUS(i)) &= ~(1UL << ADC_STATUS_FLG_REG_EOCIF_Pos);
+            UpdateIrq();
+        }
+    }
+    return Reg(offset);
+}
+
+
+static void AdcWrite(uint32_t offset, uint32_t value) {
+    Reg(offset) = value;
+    UpdateIrq();
+    SimDmaService();
+}
+
+
+template <uint32_t Index>
+static bool DmaRequest() {
+    return (Reg(SIM_ADC_STATUS(Index)) & (1UL << ADC_STATUS_FLG_REG_EOCIF_Pos)) != 0;
+}
+
+
+/**
+ * @brief Подключение модели АЦП и запросов DMA
+ */
+void SimAdcInit() {
+    SimRegister({MDR_ADC_BASE, SIM_ADC_SIZE, AdcRead, AdcWrite});
+    SimDmaAddSource({SIM_ADC_DMA_CHANNEL(0), DmaRequest<0>});
+    SimDmaAddSource({SIM_ADC_DMA_CHANNEL(1), DmaRequest<1>});
+}
+
+
+/**
+ * @brief Преобразования за один тик FreeRTOS. Вызывается из vApplicationTickHook()
+ */
+void SimAdcTick() {
+    for (uint32_t i = 0; i < SIM_ADC_COUNT; i++) {
+        uint32_t &cfg = Reg(SIM_ADC_CFG(i));
+        bool cyclic = (cfg & (1UL << ADC1_CFG_REG_SAMPLE_Pos)) != 0;
+        if ((cfg & (1UL << ADC1_CFG_REG_ADON_Pos)) == 0 || !(cyclic || (cfg & (1UL << ADC1_CFG_REG_GO_Pos)))) {
+            s_uClocks[i] = 0;
+            continue;
+        }
+
+        uint64_t period = (1ULL << ((cfg >> ADC1_CFG_REG_DIVCLK_Pos) & 0xF)) * SIM_ADC_CONVERSION_CLKS;
+        s_uClocks[i] += SIM_CORE_CLOCK_HZ / configTICK_RATE_HZ;
+        if (!cyclic) {
+            if (s_uClocks[i] >= period) {
+                cfg &= ~(1UL << ADC1_CFG_REG_GO_Pos);
+                s_uClocks[i] = 0;
+                Convert(i);
+            }
+            continue;
+        }
+        for (; s_uClocks[i] >= period; s_uClocks[i] -= period)
+            Convert(i);
+    }
+}
+
+
+/**
+ * @brief Напряжение на входе АЦП
+ * @param input Вход 0..31: ADC0..ADC7 на PD0..PD7, внутренние каналы
+ * @param value Код 0..4095
+ */
+void SimAdcSetInput(uint8_t input, uint16_t value) {
+    SimGuard guard;
+    s_uInputs[input % SIM_ADC_INPUTS] = value & 0xFFF;
+}
@@ -0,0 +1,298 @@
+/**
+ * @file sim_bus.cpp
+ * @brief Перехват обращений к регистрам периферии
+ *
+ * Окна периферии, bit-band и системной области отображаются по своим адресам без доступа. Обращение вызывает
+ * SIGSEGV: страница открывается, в ячейку кладётся значение регистра от модели, снимается копия страницы и
+ * выставляется флаг TF. Инструкция выполняется и вызывает SIGTRAP: изменённые слова страницы передаются модели,
+ * страница закрывается, и если прерванный код мог быть прерван, вызываются обработчики прерываний.
+ *
+ * Запись распознаётся по коду ошибки страницы и по сравнению с копией: инструкции чтения-модификации-записи
+ * x86 сообщают об ошибке как о чтении. Запись того же значения командой чтения-модификации-записи модели
+ * не передаётся, у регистров с побочными действиями при записи SPL пишет значение целиком.
+ */
+
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <initializer_list>
+#include <pthread.h>
+#include <sys/mman.h>
+#include <ucontext.h>
+#include "sim_bus.h"
+
+
+#define SIM_PAGE_SIZE           (4096UL)
+#define SIM_TRAP_FLAG           (0x100)         ///< EFLAGS.TF, пошаговое выполнение
+#define SIM_PF_WRITE            (0x2)           ///< Код ошибки страницы: запись
+
+
+namespace {
+
+struct Window {
+    uintptr_t Base;
+    uintptr_t Size;
+};
+
+const Window s_xWindows[] = {
+        {SIM_PERIPH_BASE, SIM_PERIPH_SIZE},
+        {SIM_BITBAND_BASE, SIM_BITBAND_SIZE},
+        {SIM_SYSTEM_BASE, SIM_SYSTEM_SIZE},
+};
+
+/*
+ * Незавершённое обращение. Между SIGSEGV и SIGTRAP сигналы планировщика заблокированы и задачи не переключаются,
+ * поэтому обращение одно на процесс. Обращения из обработчиков прерываний начинаются после завершения предыдущего.
+ */
+struct Access {
+    bool        Active;
+    bool        Write;
+    uintptr_t   Address;                            ///< Адрес ошибки
+    uint32_t   *Page;
+    sigset_t    Mask;                               ///< Маска сигналов прерванного кода
+    uint32_t    Snapshot[SIM_PAGE_SIZE / 4];
+};
+
+uint32_t s_uPeriph[SIM_PERIPH_SIZE / 4];
+uint32_t s_uSystem[SIM_SYSTEM_SIZE / 4];
+SimDevice s_xDevices[SIM_MAX_DEVICES];
+uint32_t s_uDeviceCount;
+sigset_t s_xAsyncSignals;
+Access s_xAccess;
+uint64_t s_uTraps;
+
+}
+
+
+static inline bool InWindow(uintptr_t address, uintptr_t base, uintptr_t size) {
+    return address >= base && address - base < size;
+}
+
+static inline bool IsBitBand(uintptr_t address) {
+    return InWindow(address, SIM_BITBAND_BASE, SIM_BITBAND_SIZE);
+}
+
+/// Слово периферии, которому соответствует адрес в области bit-band
+static inline uint32_t BitBandWord(uintptr_t alias) {
+    return SIM_PERIPH_BASE + (((alias - SIM_BITBAND_BASE) >> 5) & ~3UL);
+}
+
+static inline uint32_t BitBandBit(uintptr_t alias) {
+    return ((alias - SIM_BITBAND_BASE) >> 2) & 31;
+}
+
+
+static const SimDevice *FindDevice(uint32_t address) {
+    for (uint32_t i = 0; i < s_uDeviceCount; i++) {
+        if (InWindow(address, s_xDevices[i].Base, s_xDevices[i].Size))
+            return &s_xDevices[i];
+    }
+    return nullptr;
+}
+
+
+static uint32_t DeviceRead(uint32_t address, bool peek) {
+    address &= ~3UL;
+    const SimDevice *device = FindDevice(address);
+    if (device != nullptr && device->Read != nullptr)
+        return device->Read(address - device->Base, peek);
+    return SimShadow(address);
+}
+
+
+static void DeviceWrite(uint32_t address, uint32_t value) {
+    address &= ~3UL;
+    const SimDevice *device = FindDevice(address);
+    if (device != nullptr && device->Write != nullptr)
+        device->Write(address - device->Base, value);
+    else
+        SimShadow(address) = value;
+}
+
+
+/**
+ * @brief Теневая копия регистра
+ * @param address Адрес в окне периферии или системной области
+ */
+uint32_t &SimShadow(uint32_t address) {
+    if (InWindow(address, SIM_PERIPH_BASE, SIM_PERIPH_SIZE))
+        return s_uPeriph[(address - SIM_PERIPH_BASE) / 4];
+    if (InWindow(address, SIM_SYSTEM_BASE, SIM_SYSTEM_SIZE))
+        return s_uSystem[(address - SIM_SYSTEM_BASE) / 4];
+    fprintf(stderr, "SIM: no shadow register at 0x%08X\n", address);
+    abort();
+}
+
+
+/**
+ * @brief Подключение модели к окну адресов
+ */
+void SimRegister(const SimDevice &device) {
+    if (s_uDeviceCount == SIM_MAX_DEVICES) {
+        fprintf(stderr, "SIM: more than %d devices, increase SIM_MAX_DEVICES\n", SIM_MAX_DEVICES);
+        abort();
+    }
+    s_xDevices[s_uDeviceCount++] = device;
+}
+
+
+/**
+ * @brief Чтение от имени DMA: регистр периферии с побочными действиями или память процесса
+ * @param size 1, 2 или 4 байта
+ */
+uint32_t SimBusRead(uint32_t address, uint32_t size) {
+    uint32_t mask = size == 4 ? 0xFFFFFFFFUL : (1UL << (size * 8)) - 1;
+    if (IsBitBand(address))
+        return (DeviceRead(BitBandWord(address), false) >> BitBandBit(address)) & 1;
+    if (InWindow(address, SIM_PERIPH_BASE, SIM_PERIPH_SIZE) || InWindow(address, SIM_SYSTEM_BASE, SIM_SYSTEM_SIZE))
+        return (DeviceRead(address, false) >> ((address & 3) * 8)) & mask;
+
+    uint32_t value = 0;
+    memcpy(&value, reinterpret_cast<const void *>(static_cast<uintptr_t>(address)), size);
+    return value;
+}
+
+
+/**
+ * @brief Запись от имени DMA. Запись части слова регистра дополняется его текущим значением
+ * @param size 1, 2 или 4 байта
+ */
+void SimBusWrite(uint32_t address, uint32_t value, uint32_t size) {
+    if (IsBitBand(address)) {
+        uint32_t word = BitBandWord(address);
+        uint32_t bit = 1UL << BitBandBit(address);
+        DeviceWrite(word, (value & 1) ? (DeviceRead(word, true) | bit) : (DeviceRead(word, true) & ~bit));
+        return;
+    }
+    if (InWindow(address, SIM_PERIPH_BASE, SIM_PERIPH_SIZE) || InWindow(address, SIM_SYSTEM_BASE, SIM_SYSTEM_SIZE)) {
+        if (size < 4) {
+            uint32_t shift = (address & 3) * 8;
+            uint32_t mask = ((1UL << (size * 8)) - 1) << shift;
+            value = (DeviceRead(address, true) & ~mask) | ((value << shift) & mask);
+        }
+        DeviceWrite(address, value);
+        return;
+    }
+    memcpy(reinterpret_cast<void *>(static_cast<uintptr_t>(address)), &value, size);
+}
+
+
+static void OnFault(int sig, siginfo_t *info, void *context) {
+    (void)sig;
+    auto *uc = static_cast<ucontext_t *>(context);
+    auto address = reinterpret_cast<uintptr_t>(info->si_addr);
+
+    bool trapped = false;
+    for (const auto &window : s_xWindows)
+        trapped |= InWindow(address, window.Base, window.Size);
+    if (!trapped || s_xAccess.Active) {
+        // Настоящая ошибка памяти: повтор инструкции завершит процесс обработчиком по умолчанию
+        fprintf(stderr, "SIM: memory fault at 0x%08lX, pc 0x%08lX\n", static_cast<unsigned long>(address),
+                static_cast<unsigned long>(uc->uc_mcontext.gregs[REG_RIP]));
+        signal(SIGSEGV, SIG_DFL);
+        return;
+    }
+
+    auto *page = reinterpret_cast<uint32_t *>(address & ~(SIM_PAGE_SIZE - 1));
+    mprotect(page, SIM_PAGE_SIZE, PROT_READ | PROT_WRITE);
+
+    // Ячейку записи заполняем без побочных действий: запись части слова сохраняет остальные байты
+    bool write = (uc->uc_mcontext.gregs[REG_ERR] & SIM_PF_WRITE) != 0;
+    auto *cell = reinterpret_cast<uint32_t *>(address & ~3UL);
+    if (IsBitBand(address))
+        *cell = (DeviceRead(BitBandWord(address), write) >> BitBandBit(address)) & 1;
+    else
+        *cell = DeviceRead(static_cast<uint32_t>(address), write);
+    memcpy(s_xAccess.Snapshot, page, SIM_PAGE_SIZE);
+
+    s_xAccess.Active = true;
+    s_xAccess.Write = write;
+    s_xAccess.Address = address & ~3UL;
+    s_xAccess.Page = page;
+    s_xAccess.Mask = uc->uc_sigmask;
+    sigorset(&uc->uc_sigmask, &uc->uc_sigmask, &s_xAsyncSignals);
+    uc->uc_mcontext.gregs[REG_EFL] |= SIM_TRAP_FLAG;
+    s_uTraps++;
+}
+
+
+static void OnStep(int sig, siginfo_t *info, void *context) {
+    (void)sig;
+    (void)info;
+    auto *uc = static_cast<ucontext_t *>(context);
+    if (!s_xAccess.Active) {
+        signal(SIGTRAP, SIG_DFL);
+        raise(SIGTRAP);
+        return;
+    }
+    uc->uc_mcontext.gregs[REG_EFL] &= ~SIM_TRAP_FLAG;
+    s_xAccess.Active = false;
+
+    uint32_t *page = s_xAccess.Page;
+    for (uint32_t i = 0; i < SIM_PAGE_SIZE / 4; i++) {
+        auto address = reinterpret_cast<uintptr_t>(&page[i]);
+        if (page[i] == s_xAccess.Snapshot[i] && !(s_xAccess.Write && address == s_xAccess.Address))
+            continue;
+        if (IsBitBand(address)) {
+            uint32_t word = BitBandWord(address);
+            uint32_t bit = 1UL << BitBandBit(address);
+            uint32_t value = DeviceRead(word, true);
+            DeviceWrite(word, (page[i] & 1) ? (value | bit) : (value & ~bit));
+        } else {
+            DeviceWrite(static_cast<uint32_t>(address), page[i]);
+        }
+    }
+    mprotect(page, SIM_PAGE_SIZE, PROT_NONE);
+
+    uc->uc_sigmask = s_xAccess.Mask;
+    SimIrqDispatch(s_xAccess.Mask);
+}
+
+
+/**
+ * @brief Отображение окон и установка обработчиков ловушек. Вызывается первой в main()
+ */
+void SimBusInit() {
+    sigfillset(&s_xAsyncSignals);
+    for (int sig : {SIGSEGV, SIGTRAP, SIGBUS, SIGILL, SIGFPE, SIGINT})
+        sigdelset(&s_xAsyncSignals, sig);
+
+    for (const auto &window : s_xWindows) {
+        void *base = mmap(reinterpret_cast<void *>(window.Base), window.Size, PROT_NONE,
+                          MAP_PRIVATE | MAP_ANONYMOUS | MAP_NORESERVE | MAP_FIXED_NOREPLACE, -1, 0);
+        if (base != reinterpret_cast<void *>(window.Base)) {
+            fprintf(stderr, "SIM: can not map 0x%08lX, the address is taken\n", static_cast<unsigned long>(window.Base));
+            exit(EXIT_FAILURE);
+        }
+    }
+
+    struct sigaction action {};
+    action.sa_flags = SA_SIGINFO | SA_NODEFER;
+    action.sa_mask = s_xAsyncSignals;
+    action.sa_sigaction = OnFault;
+    sigaction(SIGSEGV, &action, nullptr);
+    action.sa_sigaction = OnStep;
+    sigaction(SIGTRAP, &action, nullptr);
+}
+
+
+uint64_t SimBusTraps() {
+    return s_uTraps;
+}
+
+
+SimGuard::SimGuard() {
+    pthread_sigmask(SIG_BLOCK, &s_xAsyncSignals, &m_xSaved);
+}
+
+SimGuard::~SimGuard() {
+    pthread_sigmask(SIG_SETMASK, &m_xSaved, nullptr);
+}
+
+
+/**
+ * @brief Сигналы, которые блокирует вход в прерывание: тик FreeRTOS и остальные асинхронные
+ */
+const sigset_t &SimAsyncSignals() {
+    return s_xAsyncSignals;
+}
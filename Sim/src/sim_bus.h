@@ -0,0 +1,102 @@
+/**
+ * @file sim_bus.h
+ * @brief Шина симулятора: регистрация моделей периферии, прерывания и DMA
+ *
+ * Модель занимает окно адресов и хранит регистры в теневой копии. Обработчик Read или Write вызывается
+ * только для регистров с побочным действием, остальные читаются и пишутся в теневую копию напрямую.
+ * Все функции вызываются при заблокированных сигналах таймера FreeRTOS: из обработчиков ловушек или под SimGuard.
+ */
+
+#ifndef MILANDRBASE_SIM_BUS_H
+#define MILANDRBASE_SIM_BUS_H
+
+#include <signal.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <MDR32Fx.h>
+
+
+#define SIM_PERIPH_BASE         (0x40000000UL)
+#define SIM_PERIPH_SIZE         (0x00100000UL)
+#define SIM_BITBAND_BASE        (0x42000000UL)
+#define SIM_BITBAND_SIZE        (0x02000000UL)
+#define SIM_SYSTEM_BASE         (0xE0000000UL)
+#define SIM_SYSTEM_SIZE         (0x00100000UL)
+
+#define SIM_MAX_DEVICES         (24)
+#define SIM_MAX_DMA_SOURCES     (12)
+
+
+/**
+ * @brief Модель периферийного блока
+ */
+struct SimDevice {
+    uint32_t Base;                                      ///< Адрес первого регистра
+    uint32_t Size;                                      ///< Размер окна, байт
+    uint32_t (*Read)(uint32_t offset, bool peek);       ///< nullptr - значение из теневой копии. peek - без побочных действий
+    void (*Write)(uint32_t offset, uint32_t value);     ///< nullptr - запись в теневую копию
+};
+
+
+/**
+ * @brief Линия запроса DMA: пока Active() возвращает true, канал Channel пересылает по одному элементу
+ */
+struct SimDmaSource {
+    uint8_t Channel;
+    bool (*Active)();
+};
+
+
+/**
+ * @brief Блокировка сигналов планировщика на время работы с моделями из задачи
+ */
+class SimGuard {
+public:
+    SimGuard();
+    ~SimGuard();
+    SimGuard(const SimGuard &) = delete;
+    SimGuard &operator=(const SimGuard &) = delete;
+private:
+    sigset_t m_xSaved;
+};
+
+
+uint32_t &SimShadow(uint32_t address);
+
+/// Регистры модели в теневой копии, например SimRegs<MDR_SSP_TypeDef>(MDR_SSP2_BASE)
+template <typename T>
+static inline T &SimRegs(uint32_t base) {
+    return *reinterpret_cast<T *>(&SimShadow(base));
+}
+
+void SimRegister(const SimDevice &device);
+uint32_t SimBusRead(uint32_t address, uint32_t size);
+void SimBusWrite(uint32_t address, uint32_t value, uint32_t size);
+void SimBusInit();
+uint64_t SimBusTraps();
+const sigset_t &SimAsyncSignals();
+
+void SimIrqSet(IRQn_Type irq, bool level);
+void SimIrqPend(IRQn_Type irq);
+void SimIrqDispatch(const sigset_t &interrupted);
+void SimIrqPoll();
+void SimCoreInit();
+uint64_t SimCoreIrqs();
+uint64_t SimCycles();
+uint64_t SimTicks();
+
+void SimDmaAddSource(const SimDmaSource &source);
+void SimDmaService();
+void SimDmaInit();
+uint64_t SimDmaTransfers();
+
+void SimPortInit();
+void SimTimerInit();
+void SimTimerInput(MDR_TIMER_TypeDef *timer, uint32_t channel, bool level);
+void SimSspInit();
+void SimUartInit();
+void SimAdcInit();
+void SimAdcTick();
+void SimI2cInit();
+
+#endif //MILANDRBASE_SIM_BUS_H
@@ -0,0 +1,459 @@
+/**
+ * @file sim_core.cpp
+ * @brief Ядро Cortex-M3 в симуляторе: NVIC, SCB, SysTick, DWT, PRIMASK и вызов обработчиков прерываний
+ *
+ * Обработчик прерывания вызывается в потоке прерванной задачи при приостановленном планировщике:
+ * portYIELD_FROM_ISR() только откладывает переключение, задача сменится в xTaskResumeAll() после выхода
+ * из последнего обработчика. Вложенность прерываний не моделируется, обработчики идут по одному в порядке
+ * приоритета NVIC->IP.
+ *
+ * Прерывания вызываются при выходе из ловушки регистра, из функций стенда, в задаче IDLE и в __enable_irq(),
+ * если прерванный код не в критической секции и PRIMASK сброшен. Тик FreeRTOS только продвигает время моделей.
+ */
+
+#include <cstdarg>
+#include <cstdio>
+#include <cstdlib>
+#include <ctime>
+#include <pthread.h>
+#include <unistd.h>
+#include <MDR32F9Qx_config.h>
+#include <FreeRTOS.h>
+#include <task.h>
+#include "sim.h"
+#include "sim_bus.h"
+
+
+#define SIM_IRQ_COUNT           (32)
+#define SIM_IRQ_STORM           (100000)        ///< Обработчиков подряд без возврата в задачу: линия не сбрасывается
+#define SIM_MSP_WORDS           (512)
+#define SIM_SCS_SIZE            (0x1000)
+#define SIM_DWT_SIZE            (0x1000)
+#define SIM_AIRCR_VECTKEY       (0x05FAUL)
+
+
+extern "C" {
+void CAN1_IRQHandler() __attribute__((weak));
+void CAN2_IRQHandler() __attribute__((weak));
+void USB_IRQHandler() __attribute__((weak));
+void DMA_IRQHandler() __attribute__((weak));
+void UART1_IRQHandler() __attribute__((weak));
+void UART2_IRQHandler() __attribute__((weak));
+void SSP1_IRQHandler() __attribute__((weak));
+void I2C_IRQHandler() __attribute__((weak));
+void POWER_IRQHandler() __attribute__((weak));
+void WWDG_IRQHandler() __attribute__((weak));
+void Timer1_IRQHandler() __attribute__((weak));
+void Timer2_IRQHandler() __attribute__((weak));
+void Timer3_IRQHandler() __attribute__((weak));
+void ADC_IRQHandler() __attribute__((weak));
+void COMPARATOR_IRQHandler() __attribute__((weak));
+void SSP2_IRQHandler() __attribute__((weak));
+void BACKUP_IRQHandler() __attribute__((weak));
+void EXT_INT1_IRQHandler() __attribute__((weak));
+void EXT_INT2_IRQHandler() __attribute__((weak));
+void EXT_INT3_IRQHandler() __attribute__((weak));
+void EXT_INT4_IRQHandler() __attribute__((weak));
+
+/// Область MSP для профилировщика стеков, символы как в 1986ve92.ld
+__attribute__((aligned(8))) uint32_t g_uSimMainStack[SIM_MSP_WORDS];
+}
+
+#define SIM_STR_(x)  #x
+#define SIM_STR(x)   SIM_STR_(x)
+__asm__(".globl _Main_Stack_Limit\n"
+        ".set _Main_Stack_Limit, g_uSimMainStack\n"
+        ".globl __stack\n"
+        ".set __stack, g_uSimMainStack + " SIM_STR(SIM_MSP_WORDS) " * 4\n");
+
+
+/// Таблица векторов 1986ВЕ92 с IRQ0, как в vectors.c
+static void (*const s_pHandlers[SIM_IRQ_COUNT])() = {
+        CAN1_IRQHandler, CAN2_IRQHandler, USB_IRQHandler, nullptr,
+        nullptr, DMA_IRQHandler, UART1_IRQHandler, UART2_IRQHandler,
+        SSP1_IRQHandler, nullptr, I2C_IRQHandler, POWER_IRQHandler,
+        WWDG_IRQHandler, nullptr, Timer1_IRQHandler, Timer2_IRQHandler,
+        Timer3_IRQHandler, ADC_IRQHandler, nullptr, COMPARATOR_IRQHandler,
+        SSP2_IRQHandler, nullptr, nullptr, nullptr,
+        nullptr, nullptr, nullptr, BACKUP_IRQHandler,
+        EXT_INT1_IRQHandler, EXT_INT2_IRQHandler, EXT_INT3_IRQHandler, EXT_INT4_IRQHandler,
+};
+
+static uint32_t s_uLevel;                           ///< Линии прерываний от моделей
+static uint32_t s_uPending;                         ///< NVIC ISPR
+static uint32_t s_uEnabled;                         ///< NVIC ISER
+static int32_t s_iActive = -1;                      ///< Выполняемое прерывание или -1
+static bool s_bPrimask;
+static uint64_t s_uIrqs;
+static uint64_t s_uTicks;
+static uint64_t s_uSwitches;
+static uint64_t s_uSysTickStart;
+static uint32_t s_uCycCnt;                          ///< DWT->CYCCNT на момент s_uCycStart
+static uint64_t s_uCycStart;
+
+
+/**
+ * @brief Такты ядра SIM_CORE_CLOCK_HZ по монотонным часам
+ */
+uint64_t SimCycles() {
+    timespec now {};
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    uint64_t ns = static_cast<uint64_t>(now.tv_sec) * 1000000000ULL + now.tv_nsec;
+    return ns / 1000 * (SIM_CORE_CLOCK_HZ / 1000000);
+}
+
+
+uint64_t SimTicks() {
+    return s_uTicks;
+}
+
+
+uint64_t SimCoreIrqs() {
+    return s_uIrqs;
+}
+
+
+/**
+ * @brief Линия прерывания модели. Пока линия поднята, прерывание остаётся в ожидании
+ */
+void SimIrqSet(IRQn_Type irq, bool level) {
+    if (level)
+        s_uLevel |= 1UL << irq;
+    else
+        s_uLevel &= ~(1UL << irq);
+}
+
+
+/**
+ * @brief Однократный запрос прерывания
+ */
+void SimIrqPend(IRQn_Type irq) {
+    s_uPending |= 1UL << irq;
+}
+
+
+static uint32_t Ready() {
+    return (s_uPending | s_uLevel) & s_uEnabled;
+}
+
+
+static uint8_t Priority(uint32_t irq) {
+    return (SimShadow(NVIC_BASE + offsetof(NVIC_Type, IP) + (irq & ~3UL)) >> ((irq & 3) * 8)) & 0xFF;
+}
+
+
+/// Прерывание с наименьшим значением приоритета, при равенстве - с меньшим номером
+static uint32_t Highest(uint32_t ready) {
+    uint32_t best = SIM_IRQ_COUNT;
+    for (uint32_t irq = 0; irq < SIM_IRQ_COUNT; irq++) {
+        if ((ready & (1UL << irq)) && (best == SIM_IRQ_COUNT || Priority(irq) < Priority(best)))
+            best = irq;
+    }
+    return best;
+}
+
+
+/**
+ * @brief Вызов ожидающих прерываний
+ *
+ * Вызывается при заблокированных сигналах планировщика.
+ *
+ * @param interrupted Маска сигналов прерванного кода: с заблокированным SIGALRM он в критической секции
+ */
+void SimIrqDispatch(const sigset_t &interrupted) {
+    if (sigismember(&interrupted, SIGALRM) || s_bPrimask || s_iActive >= 0 || Ready() == 0)
+        return;
+
+    // Как порт CM3: первый вызов API до запуска планировщика поднимает BASEPRI до vTaskStartScheduler()
+    BaseType_t state = xTaskGetSchedulerState();
+    if (state == taskSCHEDULER_NOT_STARTED)
+        return;
+    bool scheduler = state == taskSCHEDULER_RUNNING;
+    if (scheduler)
+        vTaskSuspendAll();
+
+    uint32_t ready;
+    for (uint32_t count = 0; (ready = Ready()) != 0; count++) {
+        uint32_t irq = Highest(ready);
+        if (count == SIM_IRQ_STORM) {
+            fprintf(stderr, "SIM: IRQ %lu storm, the handler does not clear the request\n", irq);
+            abort();
+        }
+        if (s_pHandlers[irq] == nullptr) {
+            fprintf(stderr, "SIM: IRQ %lu enabled without a handler\n", irq);
+            abort();
+        }
+        s_uPending &= ~(1UL << irq);
+        s_iActive = static_cast<int32_t>(irq);
+        s_uIrqs++;
+        s_pHandlers[irq]();
+        s_iActive = -1;
+        // portYIELD_FROM_ISR() в обработчике снимает блокировку сигналов
+        pthread_sigmask(SIG_BLOCK, &SimAsyncSignals(), nullptr);
+    }
+
+    if (scheduler)
+        xTaskResumeAll();
+}
+
+
+/**
+ * @brief Вызов ожидающих прерываний из задачи
+ */
+void SimIrqPoll() {
+    sigset_t saved;
+    pthread_sigmask(SIG_BLOCK, &SimAsyncSignals(), &saved);
+    SimIrqDispatch(saved);
+    pthread_sigmask(SIG_SETMASK, &saved, nullptr);
+}
+
+
+static uint32_t SysTickValue() {
+    uint32_t reload = SimShadow(SysTick_BASE + offsetof(SysTick_Type, LOAD)) & SysTick_LOAD_RELOAD_Msk;
+    if ((SimShadow(SysTick_BASE + offsetof(SysTick_Type, CTRL)) & SysTick_CTRL_ENABLE_Msk) == 0)
+        return SimShadow(SysTick_BASE + offsetof(SysTick_Type, VAL));
+    return reload - static_cast<uint32_t>((SimCycles() - s_uSysTickStart) % (reload + 1ULL));
+}
+
+
+static uint32_t CycleCount() {
+    if ((SimShadow(DWT_BASE + offsetof(DWT_Type, CTRL)) & DWT_CTRL_CYCCNTENA_Msk) == 0)
+        return s_uCycCnt;
+    return s_uCycCnt + static_cast<uint32_t>(SimCycles() - s_uCycStart);
+}
+
+
+static uint32_t ScsRead(uint32_t offset, bool peek) {
+    (void)peek;
+    uint32_t address = SCS_BASE + offset;
+    uint32_t index = (offset & 0x7F) / 4;
+    if (address == SysTick_BASE + offsetof(SysTick_Type, VAL))
+        return SysTickValue();
+    if (address >= NVIC_BASE + offsetof(NVIC_Type, ISER) && address < NVIC_BASE + offsetof(NVIC_Type, RESERVED0))
+        return index == 0 ? s_uEnabled : 0;
+    if (address >= NVIC_BASE + offsetof(NVIC_Type, ICER) && address < NVIC_BASE + offsetof(NVIC_Type, RSERVED1))
+        return index == 0 ? s_uEnabled : 0;
+    if (address >= NVIC_BASE + offsetof(NVIC_Type, ISPR) && address < NVIC_BASE + offsetof(NVIC_Type, RESERVED2))
+        return index == 0 ? (s_uPending | s_uLevel) : 0;
+    if (address >= NVIC_BASE + offsetof(NVIC_Type, ICPR) && address < NVIC_BASE + offsetof(NVIC_Type, RESERVED3))
+        return index == 0 ? (s_uPending | s_uLevel) : 0;
+    if (address >= NVIC_BASE + offsetof(NVIC_Type, IABR) && address < NVIC_BASE + offsetof(NVIC_Type, RESERVED4))
+        return (index == 0 && s_iActive >= 0) ? (1UL << s_iActive) : 0;
+    if (address == SCB_BASE + offsetof(SCB_Type, CPUID))
+        return 0x412FC231UL;                        // Cortex-M3 r2p1
+    if (address == SCB_BASE + offsetof(SCB_Type, ICSR))
+        return s_iActive >= 0 ? static_cast<uint32_t>(s_iActive + 16) : 0;
+    if (address == SCB_BASE + offsetof(SCB_Type, AIRCR))
+        return (0xFA05UL << SCB_AIRCR_VECTKEY_Pos) | (SimShadow(address) & SCB_AIRCR_PRIGROUP_Msk);
+    return SimShadow(address);
+}
+
+
+static void ScsWrite(uint32_t offset, uint32_t value) {
+    uint32_t address = SCS_BASE + offset;
+    uint32_t index = (offset & 0x7F) / 4;
+    if (address >= NVIC_BASE + offsetof(NVIC_Type, ISER) && address < NVIC_BASE + offsetof(NVIC_Type, RESERVED0)) {
+        if (index == 0)
+            s_uEnabled |= value;
+    } else if (address >= NVIC_BASE + offsetof(NVIC_Type, ICER) && address < NVIC_BASE + offsetof(NVIC_Type, RSERVED1)) {
+        if (index == 0)
+            s_uEnabled &= ~value;
+    } else if (address >= NVIC_BASE + offsetof(NVIC_Type, ISPR) && address < NVIC_BASE + offsetof(NVIC_Type, RESERVED2)) {
+        if (index == 0)
+            s_uPending |= value;
+    } else if (address >= NVIC_BASE + offsetof(NVIC_Type, ICPR) && address < NVIC_BASE + offsetof(NVIC_Type, RESERVED3)) {
+        if (index == 0)
+            s_uPending &= ~value;
+    } else if (address == SCB_BASE + offsetof(SCB_Type, AIRCR)) {
+        if ((value >> SCB_AIRCR_VECTKEY_Pos) != SIM_AIRCR_VECTKEY)
+            return;
+        if (value & SCB_AIRCR_SYSRESETREQ_Msk) {
+            fprintf(stderr, "SIM: SYSRESETREQ, stopping\n");
+            fflush(stdout);
+            _exit(EXIT_SUCCESS);
+        }
+        SimShadow(address) = value & SCB_AIRCR_PRIGROUP_Msk;
+    } else if (address == SysTick_BASE + offsetof(SysTick_Type, VAL)) {
+        s_uSysTickStart = SimCycles();
+        SimShadow(address) = 0;
+    } else if (address == SysTick_BASE + offsetof(SysTick_Type, CTRL)) {
+        if (value & SysTick_CTRL_TICKINT_Msk) {
+            fprintf(stderr, "SIM: SysTick interrupt belongs to the FreeRTOS port\n");
+            abort();
+        }
+        s_uSysTickStart = SimCycles();
+        SimShadow(address) = value;
+    } else {
+        SimShadow(address) = value;
+    }
+}
+
+
+static uint32_t DwtRead(uint32_t offset, bool peek) {
+    (void)peek;
+    if (offset == offsetof(DWT_Type, CYCCNT))
+        return CycleCount();
+    return SimShadow(DWT_BASE + offset);
+}
+
+
+static void DwtWrite(uint32_t offset, uint32_t value) {
+    if (offset == offsetof(DWT_Type, CYCCNT)) {
+        s_uCycCnt = value;
+        s_uCycStart = SimCycles();
+    } else if (offset == offsetof(DWT_Type, CTRL)) {
+        s_uCycCnt = CycleCount();
+        s_uCycStart = SimCycles();
+        SimShadow(DWT_BASE + offset) = value;
+    } else {
+        SimShadow(DWT_BASE + offset) = value;
+    }
+}
+
+
+/**
+ * @brief Подключение моделей NVIC, SCB, SysTick и DWT
+ */
+void SimCoreInit() {
+    SimRegister({SCS_BASE, SIM_SCS_SIZE, ScsRead, ScsWrite});
+    SimRegister({DWT_BASE, SIM_DWT_SIZE, DwtRead, DwtWrite});
+}
+
+
+extern "C" {
+
+void SimDisableIrq() {
+    pthread_sigmask(SIG_BLOCK, &SimAsyncSignals(), nullptr);
+    s_bPrimask = true;
+}
+
+
+void SimEnableIrq() {
+    s_bPrimask = false;
+    pthread_sigmask(SIG_UNBLOCK, &SimAsyncSignals(), nullptr);
+    SimIrqPoll();
+}
+
+
+uint32_t SimGetPrimask() {
+    return s_bPrimask ? 1 : 0;
+}
+
+
+void SimSetPrimask(uint32_t priMask) {
+    if (priMask & 1)
+        SimDisableIrq();
+    else
+        SimEnableIrq();
+}
+
+
+uint32_t SimGetIpsr() {
+    return s_iActive >= 0 ? static_cast<uint32_t>(s_iActive + 16) : 0;
+}
+
+
+/**
+ * @brief MSP: прерывания симулятора работают на стеке задачи, занята только область кадров main()
+ */
+uint32_t SimGetMsp() {
+    return static_cast<uint32_t>(reinterpret_cast<uintptr_t>(&g_uSimMainStack[SIM_MSP_WORDS - 32]));
+}
+
+
+void SimWaitForInterrupt() {
+    SimIrqPoll();
+    usleep(100);
+}
+
+
+int SimIsInsideInterrupt() {
+    return s_iActive >= 0;
+}
+
+
+void SimAssertFailed(const char *pcFile, unsigned long ulLine) {
+    fprintf(stderr, "configASSERT() failed: file \"%s\", line %lu\n", pcFile, ulLine);
+    abort();
+}
+
+
+void SimTaskSwitchedIn() {
+    s_uSwitches++;
+}
+
+
+void vApplicationTickHook() {
+    s_uTicks++;
+    SimAdcTick();
+}
+
+
+/*
+ * Прерывания, запрошенные в тике, вызываются здесь или при следующем обращении к регистру. Сон до следующего
+ * тика не даёт задаче IDLE занимать ядро хоста
+ */
+void vApplicationIdleHook() {
+    SimIrqPoll();
+    usleep(1000000 / configTICK_RATE_HZ / 2);
+}
+
+}
+
+
+#if (USE_ASSERT_INFO == 2)
+void assert_failed(uint8_t *file, uint32_t line, const uint8_t *expr) {
+    fprintf(stderr, "assert_param() failed: file \"%s\", line %lu, expr \"%s\"\n", file, line, expr);
+    abort();
+}
+#endif
+
+
+/**
+ * @brief Счётчики симулятора
+ */
+void SimGetStats(SimStats &stats) {
+    SimGuard guard;
+    stats.Traps = SimBusTraps();
+    stats.Irqs = s_uIrqs;
+    stats.DmaTransfers = SimDmaTransfers();
+    stats.Ticks = s_uTicks;
+    stats.Switches = s_uSwitches;
+}
+
+
+/**
+ * @brief Вывод в stdout без вытеснения задачи: задача, вытесненная с захваченным stdout, останавливает
+ * вывод всех остальных. Подходит для mdr_log_set_vprintf()
+ */
+int SimVprintf(const char *format, va_list args) {
+    SimGuard guard;
+    int length = vprintf(format, args);
+    fflush(stdout);
+    return length;
+}
+
+
+int SimPrintf(const char *format, ...) {
+    va_list args;
+    va_start(args, format);
+    int length = SimVprintf(format, args);
+    va_end(args);
+    return length;
+}
+
+
+/**
+ * @brief Подключение всех моделей. Вызывается первой в main(), до обращений к регистрам
+ */
+void SimInit() {
+    SimBusInit();
+    SimCoreInit();
+    SimPortInit();
+    SimTimerInit();
+    SimSspInit();
+    SimUartInit();
+    SimDmaInit();
+    SimAdcInit();
+    SimI2cInit();
+}
@@ -0,0 +1,240 @@
+/**
+ * @file sim_dma.cpp
+ * @brief Модель контроллера DMA PL230 (MDR_DMA)
+ *
+ * Управляющие структуры каналов читаются из памяти прошивки по CTRL_BASE_PTR, как это делает контроллер.
+ * Запрос периферии пересылает один элемент, программный запрос CHNL_SW_REQUEST - весь цикл в режиме
+ * авто и 2^R элементов в основном режиме. Поддержаны режимы основной, авто и пинг-понг, режимы
+ * с изменением конфигурации (scatter-gather) не моделируются. Завершение цикла запрашивает DMA_IRQn.
+ * Арбитраж каналов по приоритету и burst не моделируются: источники обслуживаются в порядке регистрации.
+ */
+
+#include <cstdio>
+#include <cstdlib>
+#include <MDR32F9Qx_config.h>
+#include "sim_bus.h"
+
+
+#define SIM_DMA_SIZE            (0x8000)
+#define SIM_DMA_CHANNELS        (32)
+#define SIM_DMA_ALT_OFFSET      (SIM_DMA_CHANNELS * 16)     ///< Альтернативные структуры после основных
+#define SIM_DMA_SERVICE_LIMIT   (65536)                     ///< Пересылок за один вызов SimDmaService()
+
+#define SIM_DMA_CYCLE_STOP      (0)
+#define SIM_DMA_CYCLE_BASIC     (1)
+#define SIM_DMA_CYCLE_AUTO      (2)
+#define SIM_DMA_CYCLE_PINGPONG  (3)
+#define SIM_DMA_INC_NONE        (3)
+
+
+namespace {
+
+/**
+ * @brief Управляющая структура канала в памяти, как DMA_CtrlDataTypeDef
+ */
+struct Descriptor {
+    uint32_t SourceEnd;
+    uint32_t DestEnd;
+    uint32_t Control;
+    uint32_t Spare;
+};
+
+SimDmaSource s_xSources[SIM_MAX_DMA_SOURCES];
+uint32_t s_uSourceCount;
+uint64_t s_uTransfers;
+bool s_bServicing;
+
+}
+
+
+static auto &Regs() {
+    return SimRegs<MDR_DMA_TypeDef>(MDR_DMA_BASE);
+}
+
+
+static Descriptor *Structure(uint32_t channel, bool alternate) {
+    uint32_t base = Regs().CTRL_BASE_PTR + (alternate ? SIM_DMA_ALT_OFFSET : 0);
+    return reinterpret_cast<Descriptor *>(static_cast<uintptr_t>(base + channel * sizeof(Descriptor)));
+}
+
+
+static bool Runnable(uint32_t channel) {
+    auto &regs = Regs();
+    uint32_t bit = 1UL << channel;
+    return (regs.CFG & DMA_CFG_MASTER_ENABLE) && regs.CTRL_BASE_PTR != 0 &&
+           (regs.CHNL_ENABLE_SET & bit) && !(regs.CHNL_REQ_MASK_SET & bit);
+}
+
+
+/**
+ * @brief Пересылка одного элемента канала
+ * @return false - канал остановлен
+ */
+static bool TransferItem(uint32_t channel) {
+    auto &regs = Regs();
+    uint32_t bit = 1UL << channel;
+    bool alternate = (regs.CHNL_PRI_ALT_SET & bit) != 0;
+    Descriptor *descriptor = Structure(channel, alternate);
+    uint32_t control = descriptor->Control;
+    uint32_t cycle = control & 0b111;
+
+    if (cycle == SIM_DMA_CYCLE_STOP) {
+        regs.CHNL_ENABLE_SET &= ~bit;
+        return false;
+    }
+    if (cycle > SIM_DMA_CYCLE_PINGPONG) {
+        fprintf(stderr, "SIM: DMA channel %lu cycle mode %lu is not modelled\n", channel, cycle);
+        abort();
+    }
+
+    uint32_t remaining = (control >> 4) & 0x3FF;        // n - 1
+    uint32_t srcSize = (control >> 24) & 0b11;
+    uint32_t srcInc = (control >> 26) & 0b11;
+    uint32_t dstSize = (control >> 28) & 0b11;
+    uint32_t dstInc = (control >> 30) & 0b11;
+    uint32_t src = descriptor->SourceEnd - (srcInc == SIM_DMA_INC_NONE ? 0 : remaining << srcInc);
+    uint32_t dst = descriptor->DestEnd - (dstInc == SIM_DMA_INC_NONE ? 0 : remaining << dstInc);
+
+    SimBusWrite(dst, SimBusRead(src, 1UL << srcSize), 1UL << dstSize);
+    s_uTransfers++;
+
+    if (remaining > 0) {
+        descriptor->Control = (control & ~(0x3FFUL << 4)) | ((remaining - 1) << 4);
+        return true;
+    }
+
+    // Конец цикла: структура останавливается, контроллер сообщает dma_done
+    descriptor->Control = control & ~0b111UL;
+    SimIrqPend(DMA_IRQn);
+    if (cycle == SIM_DMA_CYCLE_PINGPONG) {
+        regs.CHNL_PRI_ALT_SET ^= bit;
+        if ((Structure(channel, !alternate)->Control & 0b111) == SIM_DMA_CYCLE_STOP)
+            regs.CHNL_ENABLE_SET &= ~bit;
+    } else {
+        regs.CHNL_ENABLE_SET &= ~bit;
+    }
+    return false;
+}
+
+
+/**
+ * @brief Программный запрос: цикл авто целиком, в остальных режимах 2^R элементов
+ */
+static void SoftwareRequest(uint32_t channel) {
+    if (!Runnable(channel))
+        return;
+    uint32_t control = Structure(channel, (Regs().CHNL_PRI_ALT_SET >> channel) & 1)->Control;
+    uint32_t count = (control & 0b111) == SIM_DMA_CYCLE_AUTO ? 1024 : 1UL << ((control >> 14) & 0xF);
+    for (uint32_t i = 0; i < count; i++) {
+        if (!TransferItem(channel))
+            break;
+    }
+}
+
+
+static uint32_t DmaRead(uint32_t offset, bool peek) {
+    (void)peek;
+    auto &regs = Regs();
+    switch (offset) {
+        case offsetof(MDR_DMA_TypeDef, STATUS):
+            return regs.CFG & DMA_CFG_MASTER_ENABLE;
+        case offsetof(MDR_DMA_TypeDef, ALT_CTRL_BASE_PTR):
+            return regs.CTRL_BASE_PTR + SIM_DMA_ALT_OFFSET;
+        case offsetof(MDR_DMA_TypeDef, CHNL_USEBURST_CLR):
+        case offsetof(MDR_DMA_TypeDef, CHNL_REQ_MASK_CLR):
+        case offsetof(MDR_DMA_TypeDef, CHNL_ENABLE_CLR):
+        case offsetof(MDR_DMA_TypeDef, CHNL_PRI_ALT_CLR):
+        case offsetof(MDR_DMA_TypeDef, CHNL_PRIORITY_CLR):
+            // Состояние хранится в регистре SET, регистр CLR стоит сразу за ним
+            return (&regs.STATUS)[offset / 4 - 1];
+        default:
+            return (&regs.STATUS)[offset / 4];
+    }
+}
+
+
+static void DmaWrite(uint32_t offset, uint32_t value) {
+    auto &regs = Regs();
+    switch (offset) {
+        case offsetof(MDR_DMA_TypeDef, STATUS):
+        case offsetof(MDR_DMA_TypeDef, ALT_CTRL_BASE_PTR):
+        case offsetof(MDR_DMA_TypeDef, ERR_CLR):
+            break;
+        case offsetof(MDR_DMA_TypeDef, CHNL_SW_REQUEST):
+            for (uint32_t channel = 0; channel < SIM_DMA_CHANNELS; channel++) {
+                if (value & (1UL << channel))
+                    SoftwareRequest(channel);
+            }
+            break;
+        case offsetof(MDR_DMA_TypeDef, CHNL_USEBURST_SET):
+        case offsetof(MDR_DMA_TypeDef, CHNL_REQ_MASK_SET):
+        case offsetof(MDR_DMA_TypeDef, CHNL_ENABLE_SET):
+        case offsetof(MDR_DMA_TypeDef, CHNL_PRI_ALT_SET):
+        case offsetof(MDR_DMA_TypeDef, CHNL_PRIORITY_SET):
+            (&regs.STATUS)[offset / 4] |= value;
+            break;
+        case offsetof(MDR_DMA_TypeDef, CHNL_USEBURST_CLR):
+        case offsetof(MDR_DMA_TypeDef, CHNL_REQ_MASK_CLR):
+        case offsetof(MDR_DMA_TypeDef, CHNL_ENABLE_CLR):
+        case offsetof(MDR_DMA_TypeDef, CHNL_PRI_ALT_CLR):
+        case offsetof(MDR_DMA_TypeDef, CHNL_PRIORITY_CLR):
+            (&regs.STATUS)[offset / 4 - 1] &= ~value;
+            break;
+        default:
+            (&regs.STATUS)[offset / 4] = value;
+            break;
+    }
+    SimDmaService();
+}
+
+
+/**
+ * @brief Подключение модели DMA
+ */
+void SimDmaInit() {
+    SimRegister({MDR_DMA_BASE, SIM_DMA_SIZE, DmaRead, DmaWrite});
+}
+
+
+/**
+ * @brief Регистрация линии запроса DMA периферии
+ */
+void SimDmaAddSource(const SimDmaSource &source) {
+    if (s_uSourceCount == SIM_MAX_DMA_SOURCES) {
+        fprintf(stderr, "SIM: more than %d DMA sources, increase SIM_MAX_DMA_SOURCES\n", SIM_MAX_DMA_SOURCES);
+        abort();
+    }
+    s_xSources[s_uSourceCount++] = source;
+}
+
+
+/**
+ * @brief Обслуживание активных запросов периферии
+ *
+ * Вызывается моделями после изменения состояния и после записи в регистры DMA. Пересылка сама меняет
+ * состояние периферии, повторный вызов из неё игнорируется, запросы обслуживаются циклом.
+ */
+void SimDmaService() {
+    if (s_bServicing)
+        return;
+    s_bServicing = true;
+    uint32_t transfers = 0;
+    bool progress = true;
+    while (progress && transfers < SIM_DMA_SERVICE_LIMIT) {
+        progress = false;
+        for (uint32_t i = 0; i < s_uSourceCount; i++) {
+            const SimDmaSource &source = s_xSources[i];
+            if (Runnable(source.Channel) && source.Active()) {
+                TransferItem(source.Channel);
+                transfers++;
+                progress = true;
+            }
+        }
+    }
+    s_bServicing = false;
+}
+
+
+uint64_t SimDmaTransfers() {
+    return s_uTransfers;
+}
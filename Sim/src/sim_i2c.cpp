@@ -0,0 +1,205 @@
+/**
+ * @file sim_i2c.cpp
+ * @brief Модель контроллера MDR_I2C с EEPROM 24CM02 на шине
+ *
+ * Команды CMD выполняются сразу при записи: после START, WR и RD в STA выставляется INT, TR_PROG сброшен,
+ * RX_ACK отражает ответ ведомого. Длительность передачи байта по шине не моделируется.
+ *
+ * EEPROM отвечает на адреса 0xA0..0xA7: биты 1-2 адреса ведомого - старшие биты адреса ячейки, затем два
+ * байта адреса. Запись идёт в буфер страницы с заворотом внутри страницы и переносится в память по STOP,
+ * после чего EEPROM SIM_EEPROM_WRITE_MS тиков не отвечает на свой адрес. Последовательное чтение
+ * заворачивается на конце памяти.
+ */
+
+#include <cstring>
+#include <MDR32F9Qx_config.h>
+#include "sim.h"
+#include "sim_bus.h"
+
+
+#define SIM_I2C_SIZE            (0x8000)
+#define SIM_EEPROM_ADDRESS      (0xA0)
+#define SIM_EEPROM_ADDRESS_Msk  (0xF8)
+#define SIM_I2C_RD_Msk          (0x01)
+
+
+namespace {
+
+enum EepromState {
+    EE_IDLE,                ///< Не выбрана
+    EE_ADDRESS_HIGH,        ///< Ждёт старший байт адреса ячейки
+    EE_ADDRESS_LOW,         ///< Ждёт младший байт адреса ячейки
+    EE_WRITE,               ///< Принимает данные в буфер страницы
+    EE_READ,                ///< Передаёт данные
+};
+
+struct Eeprom {
+    uint8_t     Memory[SIM_EEPROM_SIZE];
+    uint8_t     Page[SIM_EEPROM_PAGE_SIZE];
+    bool        PageDirty[SIM_EEPROM_PAGE_SIZE];
+    uint32_t    Address;
+    uint32_t    PageBase;
+    EepromState State;
+    bool        Written;
+    uint64_t    BusyUntil;  ///< Тик окончания цикла записи
+};
+
+Eeprom s_xEeprom;
+
+}
+
+
+static auto &Regs() {
+    return SimRegs<MDR_I2C_TypeDef>(MDR_I2C_BASE);
+}
+
+
+/**
+ * @brief Байт адреса ведомого после START
+ * @return true - ACK
+ */
+static bool EepromStart(uint8_t address) {
+    if ((address & SIM_EEPROM_ADDRESS_Msk) != SIM_EEPROM_ADDRESS || SimTicks() < s_xEeprom.BusyUntil) {
+        s_xEeprom.State = EE_IDLE;
+        return false;
+    }
+    uint32_t block = (address >> 1) & 0b11;
+    if (address & SIM_I2C_RD_Msk) {
+        s_xEeprom.State = EE_READ;
+    } else {
+        s_xEeprom.Address = (block << 16) | (s_xEeprom.Address & 0xFFFF);
+        s_xEeprom.State = EE_ADDRESS_HIGH;
+    }
+    return true;
+}
+
+
+static bool EepromWrite(uint8_t value) {
+    Eeprom &ee = s_xEeprom;
+    switch (ee.State) {
+        case EE_ADDRESS_HIGH:
+            ee.Address = (ee.Address & 0x30000) | (value << 8);
+            ee.State = EE_ADDRESS_LOW;
+            return true;
+        case EE_ADDRESS_LOW:
+            ee.Address = (ee.Address & 0x3FF00) | value;
+            ee.PageBase = ee.Address & ~(SIM_EEPROM_PAGE_SIZE - 1UL);
+            memcpy(ee.Page, &ee.Memory[ee.PageBase], SIM_EEPROM_PAGE_SIZE);
+            memset(ee.PageDirty, 0, sizeof(ee.PageDirty));
+            ee.State = EE_WRITE;
+            return true;
+        case EE_WRITE: {
+            uint32_t offset = ee.Address & (SIM_EEPROM_PAGE_SIZE - 1);
+            ee.Page[offset] = value;
+            ee.PageDirty[offset] = true;
+            ee.Written = true;
+            ee.Address = ee.PageBase | ((offset + 1) & (SIM_EEPROM_PAGE_SIZE - 1));
+            return true;
+        }
+        default:
+            return false;
+    }
+}
+
+
+static uint8_t EepromRead() {
+    Eeprom &ee = s_xEeprom;
+    if (ee.State != EE_READ)
+        return 0xFF;
+    uint8_t value = ee.Memory[ee.Address];
+    ee.Address = (ee.Address + 1) % SIM_EEPROM_SIZE;
+    return value;
+}
+
+
+static void EepromStop() {
+    Eeprom &ee = s_xEeprom;
+    if (ee.State == EE_WRITE && ee.Written) {
+        for (uint32_t i = 0; i < SIM_EEPROM_PAGE_SIZE; i++) {
+            if (ee.PageDirty[i])
+                ee.Memory[ee.PageBase + i] = ee.Page[i];
+        }
+        ee.BusyUntil = SimTicks() + SIM_EEPROM_WRITE_MS;
+    }
+    ee.Written = false;
+    ee.State = EE_IDLE;
+}
+
+
+static void UpdateIrq() {
+    auto &regs = Regs();
+    SimIrqSet(I2C_IRQn, (regs.CTR & I2C_CTR_EN_INT) && (regs.STA & I2C_STA_INT));
+}
+
+
+static void Command(uint32_t command) {
+    auto &regs = Regs();
+    if (command & I2C_CMD_CLRINT)
+        regs.STA &= ~I2C_STA_INT;
+    if ((regs.CTR & I2C_CTR_EN_I2C) == 0)
+        return;
+
+    bool transfer = false;
+    bool ack = false;
+    if (command & I2C_CMD_START) {
+        regs.STA |= I2C_STA_BUSY;
+        if (command & I2C_CMD_WR)
+            ack = EepromStart(regs.TXD & 0xFF);
+        transfer = true;
+    } else if (command & I2C_CMD_WR) {
+        ack = EepromWrite(regs.TXD & 0xFF);
+        transfer = true;
+    } else if (command & I2C_CMD_RD) {
+        regs.RXD = EepromRead();
+        ack = true;
+        transfer = true;
+    }
+    if (transfer) {
+        regs.STA = (regs.STA & ~(I2C_STA_TR_PROG | I2C_STA_RX_ACK)) | I2C_STA_INT | (ack ? 0 : I2C_STA_RX_ACK);
+        regs.CMD = command & I2C_CMD_ACK;
+    }
+    if (command & I2C_CMD_STOP) {
+        EepromStop();
+        regs.STA &= ~I2C_STA_BUSY;
+    }
+}
+
+
+static uint32_t I2cRead(uint32_t offset, bool peek) {
+    (void)peek;
+    auto &regs = Regs();
+    if (offset == offsetof(MDR_I2C_TypeDef, CMD))
+        return regs.CMD & I2C_CMD_ACK;          // Команды выполнены
+    return (&regs.PRL)[offset / 4];
+}
+
+
+static void I2cWrite(uint32_t offset, uint32_t value) {
+    auto &regs = Regs();
+    if (offset == offsetof(MDR_I2C_TypeDef, CMD))
+        Command(value);
+    else if (offset != offsetof(MDR_I2C_TypeDef, STA) && offset != offsetof(MDR_I2C_TypeDef, RXD))
+        (&regs.PRL)[offset / 4] = value;
+    else if (offset == offsetof(MDR_I2C_TypeDef, STA) && value == 0)
+        regs.STA = 0;                           // I2C_DeInit()
+    UpdateIrq();
+}
+
+
+/**
+ * @brief Подключение модели I2C. EEPROM стёрта (0xFF)
+ */
+void SimI2cInit() {
+    memset(s_xEeprom.Memory, 0xFF, sizeof(s_xEeprom.Memory));
+    SimRegister({MDR_I2C_BASE, SIM_I2C_SIZE, I2cRead, I2cWrite});
+}
+
+
+/**
+ * @brief Содержимое EEPROM без обращения по шине
+ * @param address Адрес ячейки 0..SIM_EEPROM_SIZE-1
+ */
+uint8_t SimEepromRead(uint32_t address) {
+    SimGuard guard;
+    return s_xEeprom.Memory[address % SIM_EEPROM_SIZE];
+}
@@ -0,0 +1,171 @@
+/**
+ * @file sim_port.cpp
+ * @brief Модель MDR_PORTA..MDR_PORTF: уровни выводов с подтяжками и ведомыми стенда
+ *
+ * Вывод ведёт микроконтроллер, если он в режиме порта (FUNC = 0), цифровой и на выход (OE = 1). Двухтактный
+ * выход выдаёт значение RXTX, открытый сток - только 0. Стенд подтягивает вывод к 0 функцией SimPinDrive(),
+ * как ведомый на шине с открытым стоком. Отпущенный вывод читается как 1, если не включена только подтяжка к 0.
+ *
+ * Чтение RXTX возвращает уровни цифровых выводов, запись меняет защёлку. Изменение уровня передаётся
+ * на входы таймеров из таблицы s_xRoutes.
+ */
+
+#include <MDR32F9Qx_config.h>
+#include "sim.h"
+#include "sim_bus.h"
+
+
+#define SIM_PORT_COUNT          (6)
+#define SIM_PORT_SIZE           (0x8000)
+
+
+namespace {
+
+/**
+ * @brief Вход канала таймера, подключённый к выводу в альтернативной функции
+ */
+struct Route {
+    uint32_t            Port;
+    uint32_t            Pin;
+    MDR_TIMER_TypeDef  *Timer;
+    uint32_t            Channel;            ///< 0..3: CH1..CH4
+};
+
+const uint32_t s_uBases[SIM_PORT_COUNT] = {
+        MDR_PORTA_BASE, MDR_PORTB_BASE, MDR_PORTC_BASE, MDR_PORTD_BASE, MDR_PORTE_BASE, MDR_PORTF_BASE,
+};
+
+/// Подключение выводов IICSlaveTask: PA1 - TIMER1 CH1 (SDA), PA3 - TIMER1 CH2 (SCL)
+const Route s_xRoutes[] = {
+        {MDR_PORTA_BASE, 1, MDR_TIMER1, 0},
+        {MDR_PORTA_BASE, 3, MDR_TIMER1, 1},
+};
+
+uint16_t s_uBenchLow[SIM_PORT_COUNT];       ///< Выводы, прижатые к 0 стендом
+uint16_t s_uLevels[SIM_PORT_COUNT];         ///< Последние уровни, переданные таймерам
+
+}
+
+
+static uint32_t PortIndex(uint32_t base) {
+    for (uint32_t i = 0; i < SIM_PORT_COUNT; i++) {
+        if (s_uBases[i] == base)
+            return i;
+    }
+    return SIM_PORT_COUNT;
+}
+
+
+/**
+ * @brief Уровни всех выводов порта
+ */
+static uint16_t Levels(uint32_t index) {
+    auto &port = SimRegs<MDR_PORT_TypeDef>(s_uBases[index]);
+    uint16_t levels = 0;
+    for (uint32_t pin = 0; pin < 16; pin++) {
+        uint32_t bit = 1UL << pin;
+        bool driven = ((port.FUNC >> (pin * 2)) & 0b11) == 0 && (port.OE & bit) && (port.ANALOG & bit);
+        bool low;
+        if (driven && (port.RXTX & bit) == 0)
+            low = true;
+        else if (s_uBenchLow[index] & bit)
+            low = true;
+        else if (driven && (port.PD & bit) == 0)
+            low = false;
+        else
+            low = (port.PULL & bit) && !(port.PULL & (bit << 16));
+        if (!low)
+            levels |= bit;
+    }
+    return levels;
+}
+
+
+/**
+ * @brief Передача изменившихся уровней на входы таймеров
+ */
+static void Propagate(uint32_t index) {
+    uint16_t levels = Levels(index);
+    uint16_t changed = levels ^ s_uLevels[index];
+    s_uLevels[index] = levels;
+    if (changed == 0)
+        return;
+    for (const auto &route : s_xRoutes) {
+        if (route.Port == s_uBases[index] && (changed & (1UL << route.Pin)))
+            SimTimerInput(route.Timer, route.Channel, (levels >> route.Pin) & 1);
+    }
+}
+
+
+static uint32_t PortRead(uint32_t index, uint32_t offset, bool peek) {
+    auto &port = SimRegs<MDR_PORT_TypeDef>(s_uBases[index]);
+    if (offset == offsetof(MDR_PORT_TypeDef, RXTX) && !peek)
+        return (port.RXTX & ~port.ANALOG & 0xFFFF) | (Levels(index) & port.ANALOG);
+    return (&port.RXTX)[offset / 4];
+}
+
+
+static void PortWrite(uint32_t index, uint32_t offset, uint32_t value) {
+    auto &port = SimRegs<MDR_PORT_TypeDef>(s_uBases[index]);
+    (&port.RXTX)[offset / 4] = value;
+    Propagate(index);
+}
+
+
+template <uint32_t Index>
+static uint32_t PortReadN(uint32_t offset, bool peek) {
+    return PortRead(Index, offset, peek);
+}
+
+template <uint32_t Index>
+static void PortWriteN(uint32_t offset, uint32_t value) {
+    PortWrite(Index, offset, value);
+}
+
+
+/**
+ * @brief Подключение моделей портов. После сброса все выводы аналоговые, уровни 1
+ */
+void SimPortInit() {
+    static const SimDevice devices[SIM_PORT_COUNT] = {
+            {MDR_PORTA_BASE, SIM_PORT_SIZE, PortReadN<0>, PortWriteN<0>},
+            {MDR_PORTB_BASE, SIM_PORT_SIZE, PortReadN<1>, PortWriteN<1>},
+            {MDR_PORTC_BASE, SIM_PORT_SIZE, PortReadN<2>, PortWriteN<2>},
+            {MDR_PORTD_BASE, SIM_PORT_SIZE, PortReadN<3>, PortWriteN<3>},
+            {MDR_PORTE_BASE, SIM_PORT_SIZE, PortReadN<4>, PortWriteN<4>},
+            {MDR_PORTF_BASE, SIM_PORT_SIZE, PortReadN<5>, PortWriteN<5>},
+    };
+    for (uint32_t i = 0; i < SIM_PORT_COUNT; i++) {
+        SimRegister(devices[i]);
+        s_uLevels[i] = Levels(i);
+    }
+}
+
+
+/**
+ * @brief Стенд прижимает вывод к 0 или отпускает его
+ * @param port MDR_PORTA..MDR_PORTF
+ * @param pin Номер вывода 0..15
+ * @param low true - прижать к 0
+ */
+void SimPinDrive(MDR_PORT_TypeDef *port, uint32_t pin, bool low) {
+    uint32_t index = PortIndex(static_cast<uint32_t>(reinterpret_cast<uintptr_t>(port)));
+    {
+        SimGuard guard;
+        if (low)
+            s_uBenchLow[index] |= 1U << pin;
+        else
+            s_uBenchLow[index] &= ~(1U << pin);
+        Propagate(index);
+    }
+    SimIrqPoll();
+}
+
+
+/**
+ * @brief Уровень вывода с учётом выхода микроконтроллера, стенда и подтяжек
+ */
+bool SimPinLevel(MDR_PORT_TypeDef *port, uint32_t pin) {
+    SimGuard guard;
+    return (Levels(PortIndex(static_cast<uint32_t>(reinterpret_cast<uintptr_t>(port)))) >> pin) & 1;
+}
@@ -0,0 +1,37 @@
+/**
+ * @file sim_sigmask.c
+ * @brief Маски сигналов без SIGSEGV и SIGTRAP
+ *
+ * Порт POSIX входит в критическую секцию блокировкой всех сигналов, кроме SIGINT. Обращение к регистру
+ * внутри секции вызывает SIGSEGV, и заблокированный синхронный сигнал завершает процесс. Обёртки убирают
+ * сигналы ловушек из блокируемых масок и передают вызов glibc.
+ */
+
+#define _GNU_SOURCE
+#include <dlfcn.h>
+#include <signal.h>
+
+
+static void StripTraps(sigset_t *set) {
+    sigdelset(set, SIGSEGV);
+    sigdelset(set, SIGTRAP);
+    sigdelset(set, SIGBUS);
+}
+
+
+int pthread_sigmask(int how, const sigset_t *set, sigset_t *oldset) {
+    static int (*next)(int, const sigset_t *, sigset_t *);
+    if (next == NULL)
+        next = (int (*)(int, const sigset_t *, sigset_t *)) dlsym(RTLD_NEXT, "pthread_sigmask");
+
+    if (set == NULL || how == SIG_UNBLOCK)
+        return next(how, set, oldset);
+    sigset_t stripped = *set;
+    StripTraps(&stripped);
+    return next(how, &stripped, oldset);
+}
+
+
+int sigprocmask(int how, const sigset_t *set, sigset_t *oldset) {
+    return pthread_sigmask(how, set, oldset);
+}
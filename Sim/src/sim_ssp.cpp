@@ -0,0 +1,243 @@
+/**
+ * @file sim_ssp.cpp
+ * @brief Модель MDR_SSP1 и MDR_SSP2: FIFO приёма и передачи на 8 слов
+ *
+ * Ведомый SSP (CR1.MS = 1): обмен ведёт стенд функцией SimSspExchange(): на каждый байт ведущего SSP выдаёт слово
+ * из FIFO передачи (0xFF при пустом FIFO) и кладёт принятый байт в FIFO приёма.
+ *
+ * Ведущий SSP (CR1.MS = 0): слово, записанное в DR при SSE, сразу передаётся устройству стенда SimSspAttach(),
+ * ответ устройства кладётся в FIFO приёма, FIFO передачи всегда пуст. После обмена выставляется таймаут приёма.
+ *
+ * Скорость обмена не моделируется, BSY всегда 0. Запросы DMA: RX при непустом FIFO приёма и RXDMAE, TX при неполном
+ * FIFO передачи и TXDMAE.
+ */
+
+#include <MDR32F9Qx_config.h>
+#include "sim.h"
+#include "sim_bus.h"
+
+
+#define SIM_SSP_COUNT           (2)
+#define SIM_SSP_SIZE            (0x8000)
+#define SIM_SSP_FIFO_DEPTH      (8)
+#define SIM_SSP_FIFO_LEVEL      (SIM_SSP_FIFO_DEPTH / 2)    ///< Порог TXRIS и RXRIS
+
+#define SIM_SSP_TX_DMA_CHANNEL(index)   ((index) == 0 ? 4 : 6)     ///< DMA_Channel_SSP1_TX, DMA_Channel_SSP2_TX
+#define SIM_SSP_RX_DMA_CHANNEL(index)   ((index) == 0 ? 5 : 7)
+
+
+namespace {
+
+struct Fifo {
+    uint16_t Data[SIM_SSP_FIFO_DEPTH];
+    uint32_t Head;
+    uint32_t Count;
+
+    bool Empty() const { return Count == 0; }
+    bool Full() const { return Count == SIM_SSP_FIFO_DEPTH; }
+
+    void Push(uint16_t value) {
+        Data[(Head + Count) % SIM_SSP_FIFO_DEPTH] = value;
+        Count++;
+    }
+
+    uint16_t Pop() {
+        uint16_t value = Data[Head];
+        Head = (Head + 1) % SIM_SSP_FIFO_DEPTH;
+        Count--;
+        return value;
+    }
+};
+
+struct Ssp {
+    uint32_t    Base;
+    IRQn_Type   Irq;
+    Fifo        Tx;
+    Fifo        Rx;
+    bool        Timeout;        ///< RTRIS: в FIFO приёма остались слова после обмена
+    bool        Overrun;        ///< RORRIS: слово принято при полном FIFO
+    SimSspDevice Device;        ///< Устройство стенда на шине ведущего SSP
+    void       *Context;
+};
+
+Ssp s_xSsp[SIM_SSP_COUNT] = {
+        {MDR_SSP1_BASE, SSP1_IRQn, {}, {}, false, false, nullptr, nullptr},
+        {MDR_SSP2_BASE, SSP2_IRQn, {}, {}, false, false, nullptr, nullptr},
+};
+
+}
+
+
+static uint32_t RawStatus(const Ssp &ssp) {
+    uint32_t ris = 0;
+    if (ssp.Overrun)
+        ris |= 1UL << SSP_RIS_RORRIS_Pos;
+    if (ssp.Timeout && !ssp.Rx.Empty())
+        ris |= 1UL << SSP_RIS_RTRIS_Pos;
+    if (ssp.Rx.Count >= SIM_SSP_FIFO_LEVEL)
+        ris |= 1UL << SSP_RIS_RXRIS_Pos;
+    if (ssp.Tx.Count <= SIM_SSP_FIFO_LEVEL)
+        ris |= 1UL << SSP_RIS_TXRIS_Pos;
+    return ris;
+}
+
+
+static void UpdateIrq(const Ssp &ssp) {
+    SimIrqSet(ssp.Irq, (RawStatus(ssp) & SimRegs<MDR_SSP_TypeDef>(ssp.Base).IMSC) != 0);
+}
+
+
+static bool Master(const Ssp &ssp) {
+    return (SimRegs<MDR_SSP_TypeDef>(ssp.Base).CR1 & (SSP_CR1_SSE | SSP_CR1_MS)) == SSP_CR1_SSE;
+}
+
+
+/*
+ * Обмен словом ведущего SSP с устройством стенда
+ */
+static void MasterExchange(Ssp &ssp, uint16_t word) {
+    uint32_t cr0 = SimRegs<MDR_SSP_TypeDef>(ssp.Base).CR0;
+    uint16_t mask = static_cast<uint16_t>((2UL << (cr0 & SSP_CR0_DSS_Msk)) - 1);
+    uint16_t reply = ssp.Device != nullptr ? ssp.Device(word & mask, cr0, ssp.Context) : mask;
+    if (ssp.Rx.Full())
+        ssp.Overrun = true;
+    else
+        ssp.Rx.Push(reply & mask);
+    ssp.Timeout = true;
+}
+
+
+template <uint32_t Index>
+static uint32_t SspRead(uint32_t offset, bool peek) {
+    Ssp &ssp = s_xSsp[Index];
+    auto &regs = SimRegs<MDR_SSP_TypeDef>(ssp.Base);
+    switch (offset) {
+        case offsetof(MDR_SSP_TypeDef, DR): {
+            if (peek || ssp.Rx.Empty())
+                return 0;
+            uint16_t value = ssp.Rx.Pop();
+            UpdateIrq(ssp);
+            return value;
+        }
+        case offsetof(MDR_SSP_TypeDef, SR):
+            return (ssp.Tx.Empty() ? 1UL << SSP_SR_TFE_Pos : 0) |
+                   (!ssp.Tx.Full() ? 1UL << SSP_SR_TNF_Pos : 0) |
+                   (!ssp.Rx.Empty() ? 1UL << SSP_SR_RNE_Pos : 0) |
+                   (ssp.Rx.Full() ? 1UL << SSP_SR_RFF_Pos : 0);
+        case offsetof(MDR_SSP_TypeDef, RIS):
+            return RawStatus(ssp);
+        case offsetof(MDR_SSP_TypeDef, MIS):
+            return RawStatus(ssp) & regs.IMSC;
+        default:
+            return (&regs.CR0)[offset / 4];
+    }
+}
+
+
+template <uint32_t Index>
+static void SspWrite(uint32_t offset, uint32_t value) {
+    Ssp &ssp = s_xSsp[Index];
+    auto &regs = SimRegs<MDR_SSP_TypeDef>(ssp.Base);
+    switch (offset) {
+        case offsetof(MDR_SSP_TypeDef, DR):
+            if (Master(ssp))
+                MasterExchange(ssp, value & 0xFFFF);
+            else if (!ssp.Tx.Full())
+                ssp.Tx.Push(value & 0xFFFF);
+            break;
+        case offsetof(MDR_SSP_TypeDef, ICR):
+            if (value & (1UL << SSP_ICR_RORIC_Pos))
+                ssp.Overrun = false;
+            if (value & (1UL << SSP_ICR_RTIC_Pos))
+                ssp.Timeout = false;
+            break;
+        case offsetof(MDR_SSP_TypeDef, SR):
+        case offsetof(MDR_SSP_TypeDef, RIS):
+        case offsetof(MDR_SSP_TypeDef, MIS):
+            break;
+        default:
+            (&regs.CR0)[offset / 4] = value;
+            break;
+    }
+    UpdateIrq(ssp);
+    SimDmaService();
+}
+
+
+template <uint32_t Index>
+static bool RxRequest() {
+    const Ssp &ssp = s_xSsp[Index];
+    return (SimRegs<MDR_SSP_TypeDef>(ssp.Base).DMACR & (1UL << SSP_DMACR_RXDMAE_Pos)) && !ssp.Rx.Empty();
+}
+
+
+template <uint32_t Index>
+static bool TxRequest() {
+    const Ssp &ssp = s_xSsp[Index];
+    return (SimRegs<MDR_SSP_TypeDef>(ssp.Base).DMACR & (1UL << SSP_DMACR_TXDMAE_Pos)) && !ssp.Tx.Full();
+}
+
+
+/**
+ * @brief Подключение моделей SSP и их запросов DMA
+ */
+void SimSspInit() {
+    SimRegister({MDR_SSP1_BASE, SIM_SSP_SIZE, SspRead<0>, SspWrite<0>});
+    SimRegister({MDR_SSP2_BASE, SIM_SSP_SIZE, SspRead<1>, SspWrite<1>});
+    SimDmaAddSource({SIM_SSP_RX_DMA_CHANNEL(0), RxRequest<0>});
+    SimDmaAddSource({SIM_SSP_TX_DMA_CHANNEL(0), TxRequest<0>});
+    SimDmaAddSource({SIM_SSP_RX_DMA_CHANNEL(1), RxRequest<1>});
+    SimDmaAddSource({SIM_SSP_TX_DMA_CHANNEL(1), TxRequest<1>});
+}
+
+
+/**
+ * @brief Обмен стенда, ведущего шину, с SSP
+ * @param ssp MDR_SSP1 или MDR_SSP2
+ * @param tx Байты ведущего
+ * @param rx Байты SSP, может быть nullptr
+ * @param len Длина обмена
+ * @return Число байт, принятых SSP без переполнения FIFO
+ */
+size_t SimSspExchange(MDR_SSP_TypeDef *ssp, const uint8_t *tx, uint8_t *rx, size_t len) {
+    Ssp &model = s_xSsp[ssp == MDR_SSP1 ? 0 : 1];
+    size_t accepted = 0;
+    {
+        SimGuard guard;
+        bool enabled = (SimRegs<MDR_SSP_TypeDef>(model.Base).CR1 & (1UL << SSP_CR1_SSE_Pos)) != 0;
+        for (size_t i = 0; i < len; i++) {
+            uint8_t out = 0xFF;
+            if (enabled) {
+                if (!model.Tx.Empty())
+                    out = model.Tx.Pop() & 0xFF;
+                if (model.Rx.Full()) {
+                    model.Overrun = true;
+                } else {
+                    model.Rx.Push(tx[i]);
+                    accepted++;
+                }
+                model.Timeout = true;
+            }
+            if (rx != nullptr)
+                rx[i] = out;
+            UpdateIrq(model);
+            SimDmaService();
+        }
+    }
+    SimIrqPoll();
+    return accepted;
+}
+
+
+/**
+ * @brief Устройство стенда на шине ведущего SSP
+ * @param ssp MDR_SSP1 или MDR_SSP2
+ * @param device Обработчик слова, вызывается при записи DR из контекста прошивки. nullptr - отключить
+ * @param context Параметр обработчика
+ */
+void SimSspAttach(MDR_SSP_TypeDef *ssp, SimSspDevice device, void *context) {
+    Ssp &model = s_xSsp[ssp == MDR_SSP1 ? 0 : 1];
+    SimGuard guard;
+    model.Device = device;
+    model.Context = context;
+}
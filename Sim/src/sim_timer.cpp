@@ -0,0 +1,86 @@
+/**
+ * @file sim_timer.cpp
+ * @brief Модель MDR_TIMER1..MDR_TIMER3: захват фронтов входов каналов
+ *
+ * Счёт не моделируется: CNT меняет только прошивка, захват копирует его в CCRx и CCR1x. Канал с CAP_NPWM
+ * захватывает в CCRx фронт, выбранный CHSEL, канал с CCR1_EN - в CCR1x фронт, выбранный CHSEL1. Поддержаны
+ * выборы 00 (передний фронт) и 01 (задний фронт) собственного входа канала. Запись в STATUS сбрасывает флаги,
+ * записанные нулём, прерывание таймера поднято, пока STATUS & IE не равно 0.
+ */
+
+#include <MDR32F9Qx_config.h>
+#include "sim_bus.h"
+
+
+#define SIM_TIMER_COUNT         (3)
+#define SIM_TIMER_SIZE          (0x8000)
+#define SIM_TIMER_EDGE_RISE     (0b00)
+#define SIM_TIMER_EDGE_FALL     (0b01)
+
+
+namespace {
+
+const uint32_t s_uBases[SIM_TIMER_COUNT] = {MDR_TIMER1_BASE, MDR_TIMER2_BASE, MDR_TIMER3_BASE};
+const IRQn_Type s_xIrqs[SIM_TIMER_COUNT] = {Timer1_IRQn, Timer2_IRQn, Timer3_IRQn};
+
+}
+
+
+static void UpdateIrq(uint32_t index) {
+    auto &timer = SimRegs<MDR_TIMER_TypeDef>(s_uBases[index]);
+    SimIrqSet(s_xIrqs[index], (timer.STATUS & timer.IE) != 0);
+}
+
+
+template <uint32_t Index>
+static void TimerWrite(uint32_t offset, uint32_t value) {
+    auto &timer = SimRegs<MDR_TIMER_TypeDef>(s_uBases[Index]);
+    if (offset == offsetof(MDR_TIMER_TypeDef, STATUS))
+        timer.STATUS &= value;
+    else
+        (&timer.CNT)[offset / 4] = value;
+    UpdateIrq(Index);
+}
+
+
+/**
+ * @brief Подключение моделей таймеров
+ */
+void SimTimerInit() {
+    SimRegister({MDR_TIMER1_BASE, SIM_TIMER_SIZE, nullptr, TimerWrite<0>});
+    SimRegister({MDR_TIMER2_BASE, SIM_TIMER_SIZE, nullptr, TimerWrite<1>});
+    SimRegister({MDR_TIMER3_BASE, SIM_TIMER_SIZE, nullptr, TimerWrite<2>});
+}
+
+
+/**
+ * @brief Изменение уровня на входе канала таймера
+ * @param timer MDR_TIMER1..MDR_TIMER3
+ * @param channel 0..3: CH1..CH4
+ * @param level Новый уровень входа
+ */
+void SimTimerInput(MDR_TIMER_TypeDef *timer, uint32_t channel, bool level) {
+    uint32_t base = static_cast<uint32_t>(reinterpret_cast<uintptr_t>(timer));
+    uint32_t index = 0;
+    while (index < SIM_TIMER_COUNT && s_uBases[index] != base)
+        index++;
+    if (index == SIM_TIMER_COUNT)
+        return;
+
+    auto &regs = SimRegs<MDR_TIMER_TypeDef>(base);
+    if ((regs.CNTRL & TIMER_CNTRL_CNT_EN) == 0)
+        return;
+
+    uint32_t edge = level ? SIM_TIMER_EDGE_RISE : SIM_TIMER_EDGE_FALL;
+    uint32_t control = (&regs.CH1_CNTRL)[channel];
+    if ((control & (1UL << TIMER_CH_CNTRL_CAP_NPWM_Pos)) && ((control >> TIMER_CH_CNTRL_CHSEL_Pos) & 0b11) == edge) {
+        (&regs.CCR1)[channel] = regs.CNT;
+        regs.STATUS |= 1UL << (TIMER_STATUS_CCR_CAP_EVENT_Pos + channel);
+    }
+    uint32_t control2 = (&regs.CH1_CNTRL2)[channel];
+    if ((control2 & (1UL << TIMER_CH_CNTRL2_CCR1_EN_Pos)) && ((control2 >> TIMER_CH_CNTRL2_CHSEL1_Pos) & 0b11) == edge) {
+        (&regs.CCR11)[channel] = regs.CNT;
+        regs.STATUS |= 1UL << (TIMER_STATUS_CCR1_CAP_EVENT_Pos + channel);
+    }
+    UpdateIrq(index);
+}
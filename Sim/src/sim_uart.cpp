@@ -0,0 +1,220 @@
+/**
+ * @file sim_uart.cpp
+ * @brief Модель MDR_UART1 и MDR_UART2: FIFO приёма на 16 байт, передача без задержки
+ *
+ * Стенд передаёт байты в UART функцией SimUartSend() и забирает переданные прошивкой функцией SimUartReceive().
+ * Передача и приём идут при UARTEN и TXE/RXE, частота обмена не моделируется: записанный в DR байт сразу уходит
+ * в линию стенда, FIFO передачи всегда пуст. Запросы DMA: RX при непустом FIFO приёма и RXDMAE, TX при TXDMAE.
+ * Прерывания: RXRIS по порогу IFLS.RXIFLSEL, RTRIS при непустом FIFO приёма (время таймаута не моделируется)
+ * и OERIS. Стенд передаёт байты по одному и после каждого обслуживает прерывания, как при реальной скорости линии.
+ */
+
+#include <MDR32F9Qx_config.h>
+#include "sim.h"
+#include "sim_bus.h"
+
+
+#define SIM_UART_COUNT          (2)
+#define SIM_UART_SIZE           (0x8000)
+#define SIM_UART_FIFO_DEPTH     (16)
+#define SIM_UART_LINE_SIZE      (65536)         ///< Байт, переданных прошивкой и не прочитанных стендом
+#define SIM_UART_RX_LEVELS      (5)             ///< Порогов RXIFLSEL: 1/8, 1/4, 1/2, 3/4, 7/8 FIFO
+
+#define SIM_UART_TX_DMA_CHANNEL(index)  ((index) == 0 ? 0 : 2)     ///< DMA_Channel_UART1_TX, DMA_Channel_UART2_TX
+#define SIM_UART_RX_DMA_CHANNEL(index)  ((index) == 0 ? 1 : 3)
+
+
+namespace {
+
+struct Uart {
+    uint32_t    Base;
+    IRQn_Type   Irq;
+    uint8_t     Rx[SIM_UART_FIFO_DEPTH];
+    uint32_t    RxHead;
+    uint32_t    RxCount;
+    bool        Overrun;                        ///< OERIS и RSR_ECR.OE: байт принят при полном FIFO
+    uint8_t     Line[SIM_UART_LINE_SIZE];       ///< Переданные байты для стенда
+    uint32_t    LineHead;
+    uint32_t    LineCount;
+};
+
+Uart s_xUart[SIM_UART_COUNT] = {
+        {MDR_UART1_BASE, UART1_IRQn, {}, 0, 0, false, {}, 0, 0},
+        {MDR_UART2_BASE, UART2_IRQn, {}, 0, 0, false, {}, 0, 0},
+};
+
+}
+
+
+static bool Enabled(const Uart &uart, uint32_t direction) {
+    uint32_t cr = SimRegs<MDR_UART_TypeDef>(uart.Base).CR;
+    return (cr & UART_CR_UARTEN) && (cr & direction);
+}
+
+
+static uint32_t RxLevel(const Uart &uart) {
+    static const uint32_t levels[SIM_UART_RX_LEVELS] = {2, 4, 8, 12, 14};
+    uint32_t select = (SimRegs<MDR_UART_TypeDef>(uart.Base).IFLS & UART_IFLS_RXIFLSEL_Msk) >> UART_IFLS_RXIFLSEL_Pos;
+    return select < SIM_UART_RX_LEVELS ? levels[select] : SIM_UART_FIFO_DEPTH / 2;
+}
+
+
+static uint32_t RawStatus(const Uart &uart) {
+    uint32_t ris = 0;
+    if (uart.Overrun)
+        ris |= UART_RIS_OERIS;
+    if (uart.RxCount >= RxLevel(uart))
+        ris |= UART_RIS_RXRIS;
+    if (uart.RxCount != 0)
+        ris |= UART_RIS_RTRIS;
+    return ris;
+}
+
+
+static void UpdateIrq(const Uart &uart) {
+    SimIrqSet(uart.Irq, (RawStatus(uart) & SimRegs<MDR_UART_TypeDef>(uart.Base).IMSC) != 0);
+}
+
+
+template <uint32_t Index>
+static uint32_t UartRead(uint32_t offset, bool peek) {
+    Uart &uart = s_xUart[Index];
+    auto &regs = SimRegs<MDR_UART_TypeDef>(uart.Base);
+    switch (offset) {
+        case offsetof(MDR_UART_TypeDef, DR): {
+            if (peek || uart.RxCount == 0)
+                return 0;
+            uint8_t value = uart.Rx[uart.RxHead];
+            uart.RxHead = (uart.RxHead + 1) % SIM_UART_FIFO_DEPTH;
+            uart.RxCount--;
+            UpdateIrq(uart);
+            return value;
+        }
+        case offsetof(MDR_UART_TypeDef, RSR_ECR):
+            return uart.Overrun ? UART_RSR_ECR_OE : 0;
+        case offsetof(MDR_UART_TypeDef, FR):
+            return UART_FR_TXFE |
+                   (uart.RxCount == 0 ? UART_FR_RXFE : 0) |
+                   (uart.RxCount == SIM_UART_FIFO_DEPTH ? UART_FR_RXFF : 0);
+        case offsetof(MDR_UART_TypeDef, RIS):
+            return RawStatus(uart);
+        case offsetof(MDR_UART_TypeDef, MIS):
+            return RawStatus(uart) & regs.IMSC;
+        default:
+            return (&regs.DR)[offset / 4];
+    }
+}
+
+
+template <uint32_t Index>
+static void UartWrite(uint32_t offset, uint32_t value) {
+    Uart &uart = s_xUart[Index];
+    auto &regs = SimRegs<MDR_UART_TypeDef>(uart.Base);
+    switch (offset) {
+        case offsetof(MDR_UART_TypeDef, DR):
+            if (Enabled(uart, UART_CR_TXE) && uart.LineCount < SIM_UART_LINE_SIZE) {
+                uart.Line[(uart.LineHead + uart.LineCount) % SIM_UART_LINE_SIZE] = value & 0xFF;
+                uart.LineCount++;
+            }
+            break;
+        case offsetof(MDR_UART_TypeDef, RSR_ECR):
+            uart.Overrun = false;
+            break;
+        case offsetof(MDR_UART_TypeDef, ICR):
+            if (value & UART_ICR_OEIC)
+                uart.Overrun = false;
+            break;
+        case offsetof(MDR_UART_TypeDef, FR):
+        case offsetof(MDR_UART_TypeDef, RIS):
+        case offsetof(MDR_UART_TypeDef, MIS):
+            break;
+        default:
+            (&regs.DR)[offset / 4] = value;
+            break;
+    }
+    UpdateIrq(uart);
+    SimDmaService();
+}
+
+
+template <uint32_t Index>
+static bool RxRequest() {
+    const Uart &uart = s_xUart[Index];
+    return (SimRegs<MDR_UART_TypeDef>(uart.Base).DMACR & (1UL << UART_DMACR_RXDMAE_Pos)) && uart.RxCount != 0;
+}
+
+
+template <uint32_t Index>
+static bool TxRequest() {
+    const Uart &uart = s_xUart[Index];
+    return (SimRegs<MDR_UART_TypeDef>(uart.Base).DMACR & (1UL << UART_DMACR_TXDMAE_Pos)) &&
+           Enabled(uart, UART_CR_TXE) && uart.LineCount < SIM_UART_LINE_SIZE;
+}
+
+
+/**
+ * @brief Подключение моделей UART и их запросов DMA
+ */
+void SimUartInit() {
+    SimRegister({MDR_UART1_BASE, SIM_UART_SIZE, UartRead<0>, UartWrite<0>});
+    SimRegister({MDR_UART2_BASE, SIM_UART_SIZE, UartRead<1>, UartWrite<1>});
+    SimDmaAddSource({SIM_UART_RX_DMA_CHANNEL(0), RxRequest<0>});
+    SimDmaAddSource({SIM_UART_TX_DMA_CHANNEL(0), TxRequest<0>});
+    SimDmaAddSource({SIM_UART_RX_DMA_CHANNEL(1), RxRequest<1>});
+    SimDmaAddSource({SIM_UART_TX_DMA_CHANNEL(1), TxRequest<1>});
+}
+
+
+/**
+ * @brief Передача стенда в UART
+ * @param uart MDR_UART1 или MDR_UART2
+ * @param data Байты
+ * @param len Байт
+ * @return Байт, принятых UART без переполнения FIFO
+ */
+size_t SimUartSend(MDR_UART_TypeDef *uart, const uint8_t *data, size_t len) {
+    Uart &model = s_xUart[uart == MDR_UART1 ? 0 : 1];
+    size_t accepted = 0;
+    for (size_t i = 0; i < len; i++) {
+        {
+            SimGuard guard;
+            if (!Enabled(model, UART_CR_RXE))
+                break;
+            if (model.RxCount == SIM_UART_FIFO_DEPTH) {
+                model.Overrun = true;
+            } else {
+                model.Rx[(model.RxHead + model.RxCount) % SIM_UART_FIFO_DEPTH] = data[i];
+                model.RxCount++;
+                accepted++;
+            }
+            UpdateIrq(model);
+            SimDmaService();
+        }
+        SimIrqPoll();
+    }
+    return accepted;
+}
+
+
+/**
+ * @brief Приём стендом байт, переданных UART
+ * @param uart MDR_UART1 или MDR_UART2
+ * @param data Буфер
+ * @param len Размер буфера
+ * @return Байт прочитано
+ */
+size_t SimUartReceive(MDR_UART_TypeDef *uart, uint8_t *data, size_t len) {
+    Uart &model = s_xUart[uart == MDR_UART1 ? 0 : 1];
+    size_t count = 0;
+    {
+        SimGuard guard;
+        for (; count < len && model.LineCount != 0; count++) {
+            data[count] = model.Line[model.LineHead];
+            model.LineHead = (model.LineHead + 1) % SIM_UART_LINE_SIZE;
+            model.LineCount--;
+        }
+        SimDmaService();
+    }
+    SimIrqPoll();
+    return count;
+}